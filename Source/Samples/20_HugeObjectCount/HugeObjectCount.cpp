@@ -76,7 +76,11 @@ void HugeObjectCount::CreateScene()
     auto* cache = GetSubsystem<ResourceCache>();
 
     if (!scene_)
+    {
         scene_ = new Scene(context_);
+        // Update transforms of huge number of moving nodes in one batch
+        scene_->SetTransformHierarchyEnabled(true);
+    }
     else
     {
         scene_->Clear();
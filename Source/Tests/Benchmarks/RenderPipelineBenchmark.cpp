@@ -0,0 +1,394 @@
+//
+// Copyright (c) 2017-2021 the rbfx project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include <Urho3D/Container/FrameAllocator.h>
+#include <Urho3D/Core/Context.h>
+#include <Urho3D/Core/StringUtils.h>
+#include <Urho3D/Core/Timer.h>
+#include <Urho3D/Engine/Engine.h>
+#include <Urho3D/Engine/EngineDefs.h>
+#include <Urho3D/Graphics/Camera.h>
+#include <Urho3D/Graphics/DrawCommandQueue.h>
+#include <Urho3D/Graphics/Graphics.h>
+#include <Urho3D/Graphics/Light.h>
+#include <Urho3D/Graphics/Material.h>
+#include <Urho3D/Graphics/Model.h>
+#include <Urho3D/Graphics/Octree.h>
+#include <Urho3D/Graphics/OctreeQuery.h>
+#include <Urho3D/Graphics/StaticModel.h>
+#include <Urho3D/Graphics/Technique.h>
+#include <Urho3D/Graphics/Viewport.h>
+#include <Urho3D/IO/Log.h>
+#include <Urho3D/Math/RandomEngine.h>
+#include <Urho3D/RenderPipeline/BatchCompositor.h>
+#include <Urho3D/RenderPipeline/BatchRenderer.h>
+#include <Urho3D/RenderPipeline/DrawableProcessor.h>
+#include <Urho3D/RenderPipeline/InstancingBuffer.h>
+#include <Urho3D/RenderPipeline/LightProcessor.h>
+#include <Urho3D/RenderPipeline/SceneProcessor.h>
+#include <Urho3D/RenderPipeline/ScenePass.h>
+#include <Urho3D/RenderPipeline/ShadowMapAllocator.h>
+#include <Urho3D/Resource/ResourceCache.h>
+#include <Urho3D/Scene/Scene.h>
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+using namespace Urho3D;
+
+namespace
+{
+
+/// Number of global allocations. Only allocations visible to this executable are counted.
+std::atomic<unsigned long long> numAllocations{};
+
+/// Synthetic scene parameters.
+struct BenchmarkSceneParams
+{
+    unsigned numStaticModels_{};
+    unsigned numMovingModels_{};
+    unsigned numAlphaModels_{};
+    unsigned numLights_{};
+    unsigned numShadowCasters_{};
+};
+
+/// CPU frame phases measured by benchmark.
+enum BenchmarkPhase
+{
+    PHASE_MOVE_NODES,
+    PHASE_OCTREE_UPDATE,
+    PHASE_SCENE_PROCESSOR,
+    PHASE_DRAWABLE_PROCESSOR,
+    PHASE_BATCH_COMPOSITOR,
+    PHASE_BATCH_SORTING,
+    PHASE_BATCH_RENDERER,
+    NUM_PHASES
+};
+
+const char* phaseNames[NUM_PHASES] = { "Move nodes", "Octree update", "SceneProcessor", "DrawableProcessor",
+    "BatchCompositor", "Batch sorting", "BatchRenderer" };
+
+/// Phase timer that also counts allocations.
+struct PhaseTimer
+{
+    HiresTimer timer_;
+    unsigned long long allocationsCheckpoint_{};
+    long long phaseTimes_[NUM_PHASES]{};
+    unsigned long long phaseAllocations_[NUM_PHASES]{};
+    bool measure_{};
+
+    void Begin()
+    {
+        timer_.Reset();
+        allocationsCheckpoint_ = numAllocations.load(std::memory_order_relaxed);
+    }
+
+    void End(BenchmarkPhase phase)
+    {
+        const long long elapsed = timer_.GetUSec(true);
+        const unsigned long long allocations = numAllocations.load(std::memory_order_relaxed);
+        if (measure_)
+        {
+            phaseTimes_[phase] += elapsed;
+            phaseAllocations_[phase] += allocations - allocationsCheckpoint_;
+        }
+        allocationsCheckpoint_ = numAllocations.load(std::memory_order_relaxed);
+    }
+};
+
+/// Minimal render pipeline that owns SceneProcessor and updates it on CPU.
+class BenchmarkRenderPipeline : public Object, public RenderPipelineInterface
+{
+    URHO3D_OBJECT(BenchmarkRenderPipeline, Object);
+
+public:
+    explicit BenchmarkRenderPipeline(Context* context) : Object(context) {}
+
+    Context* GetContext() const override { return context_; }
+    RenderPipelineDebugger* GetDebugger() override { return nullptr; }
+};
+
+/// Scene pass that measures time spent on batch sorting.
+template <class T>
+class TimedScenePass : public T
+{
+public:
+    using T::T;
+
+    long long sortTime_{};
+
+protected:
+    void OnBatchesReady() override
+    {
+        HiresTimer timer;
+        T::OnBatchesReady();
+        sortTime_ += timer.GetUSec(false);
+    }
+};
+
+}
+
+void* operator new(std::size_t size)
+{
+    numAllocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* ptr = std::malloc(size ? size : 1))
+        return ptr;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept
+{
+    std::free(ptr);
+}
+
+int main()
+{
+    static const unsigned numWarmupFrames = 10;
+    static const unsigned numFrames = 100;
+
+    const BenchmarkSceneParams params{ 50000, 5000, 2000, 32, 10000 };
+
+    // Create engine with null graphics device
+    SharedPtr<Context> context = MakeShared<Context>();
+    auto engine = MakeShared<Engine>(context);
+    VariantMap engineParameters;
+    engineParameters[EP_HEADLESS] = true;
+    engineParameters[EP_NULL_GRAPHICS] = true;
+    engineParameters[EP_LOG_QUIET] = true;
+    engineParameters[EP_WINDOW_WIDTH] = 1920;
+    engineParameters[EP_WINDOW_HEIGHT] = 1080;
+    if (!engine->Initialize(engineParameters))
+    {
+        std::fprintf(stderr, "Failed to initialize engine\n");
+        return EXIT_FAILURE;
+    }
+    context->GetSubsystem<Log>()->SetLevel(LOG_ERROR);
+
+    auto cache = context->GetSubsystem<ResourceCache>();
+    auto model = cache->GetResource<Model>("Models/Box.mdl");
+    auto opaqueMaterial = cache->GetResource<Material>("Materials/DefaultGrey.xml");
+    auto alphaMaterial = opaqueMaterial->Clone();
+    alphaMaterial->SetTechnique(0, cache->GetResource<Technique>("Techniques/NoTextureAlpha.xml"));
+    if (!model || !opaqueMaterial)
+    {
+        std::fprintf(stderr, "Failed to load CoreData resources\n");
+        return EXIT_FAILURE;
+    }
+
+    // Create synthetic scene
+    auto scene = MakeShared<Scene>(context);
+    auto octree = scene->CreateComponent<Octree>();
+
+    RandomEngine randomEngine(0);
+    const BoundingBox sceneBox{ Vector3(-500.0f, 0.0f, -500.0f), Vector3(500.0f, 50.0f, 500.0f) };
+    ea::vector<Node*> movingNodes;
+    for (unsigned i = 0; i < params.numStaticModels_; ++i)
+    {
+        Node* node = scene->CreateChild();
+        node->SetPosition(randomEngine.GetVector3(sceneBox));
+        node->SetScale(randomEngine.GetFloat(0.5f, 3.0f));
+
+        auto staticModel = node->CreateComponent<StaticModel>();
+        staticModel->SetModel(model);
+        staticModel->SetMaterial(i < params.numAlphaModels_ ? alphaMaterial : opaqueMaterial);
+        staticModel->SetCastShadows(i < params.numShadowCasters_);
+
+        if (i < params.numMovingModels_)
+            movingNodes.push_back(node);
+    }
+
+    for (unsigned i = 0; i < params.numLights_; ++i)
+    {
+        Node* node = scene->CreateChild();
+        node->SetPosition(randomEngine.GetVector3(sceneBox));
+
+        auto light = node->CreateComponent<Light>();
+        light->SetLightType(LIGHT_POINT);
+        light->SetRange(randomEngine.GetFloat(10.0f, 50.0f));
+    }
+
+    Node* directionalLightNode = scene->CreateChild();
+    directionalLightNode->SetDirection({ 0.5f, -1.0f, 0.5f });
+    auto directionalLight = directionalLightNode->CreateComponent<Light>();
+    directionalLight->SetLightType(LIGHT_DIRECTIONAL);
+    directionalLight->SetCastShadows(true);
+
+    Node* cameraNode = scene->CreateChild();
+    cameraNode->SetPosition({ 0.0f, 20.0f, -500.0f });
+    auto camera = cameraNode->CreateComponent<Camera>();
+    camera->SetFarClip(500.0f);
+
+    auto viewport = MakeShared<Viewport>(context, scene, camera);
+
+    // Create render pipeline objects as DefaultRenderPipelineView does
+    RenderPipelineSettings settings;
+    settings.sceneProcessor_.maxOccluderTriangles_ = 0;
+    settings.Validate();
+    settings.AdjustToSupported(context);
+    settings.PropagateImpliedSettings();
+
+    auto renderPipeline = MakeShared<BenchmarkRenderPipeline>(context);
+    auto shadowMapAllocator = MakeShared<ShadowMapAllocator>(context);
+    auto instancingBuffer = MakeShared<InstancingBuffer>(context);
+    auto sceneProcessor = MakeShared<SceneProcessor>(renderPipeline, "shadow", shadowMapAllocator, instancingBuffer);
+
+    auto opaquePass = sceneProcessor->CreatePass<TimedScenePass<UnorderedScenePass>>(
+        DrawableProcessorPassFlag::HasAmbientLighting, "", "base", "litbase", "light");
+    auto alphaPass = sceneProcessor->CreatePass<TimedScenePass<BackToFrontScenePass>>(
+        DrawableProcessorPassFlag::HasAmbientLighting | DrawableProcessorPassFlag::NeedReadableDepth,
+        "", "alpha", "alpha", "litalpha");
+    sceneProcessor->SetPasses({ opaquePass, alphaPass });
+    sceneProcessor->SetSettings(settings);
+    instancingBuffer->SetSettings(settings.instancingBuffer_);
+    shadowMapAllocator->SetSettings(settings.shadowMapAllocator_);
+
+    CommonFrameInfo frameInfo;
+    frameInfo.viewport_ = viewport;
+    frameInfo.viewportRect_ = viewport->GetEffectiveRect(nullptr);
+    frameInfo.viewportSize_ = frameInfo.viewportRect_.Size();
+    if (!sceneProcessor->Define(frameInfo))
+    {
+        std::fprintf(stderr, "Failed to define scene processor\n");
+        return EXIT_FAILURE;
+    }
+    sceneProcessor->SetRenderCamera(camera);
+
+    DrawableProcessor* drawableProcessor = sceneProcessor->GetDrawableProcessor();
+    BatchCompositor* batchCompositor = sceneProcessor->GetBatchCompositor();
+    BatchRenderer* batchRenderer = sceneProcessor->GetBatchRenderer();
+    auto graphics = context->GetSubsystem<Graphics>();
+    auto drawQueue = MakeShared<DrawCommandQueue>(graphics);
+
+    // Simulate frames. Steps of SceneProcessor::Update are reproduced one by one to measure them separately.
+    ea::vector<Drawable*> visibleDrawables;
+    PhaseTimer timer;
+    unsigned long long numVisibleDrawables = 0;
+    unsigned long long numBatches = 0;
+    unsigned long long numShadowBatches = 0;
+    unsigned long long numDrawCalls = 0;
+    unsigned long long numPrimitives = 0;
+
+    for (unsigned frameIndex = 0; frameIndex < numWarmupFrames + numFrames; ++frameIndex)
+    {
+        timer.measure_ = frameIndex >= numWarmupFrames;
+        opaquePass->sortTime_ = 0;
+        alphaPass->sortTime_ = 0;
+
+        frameInfo.frameNumber_ = frameIndex + 1;
+        frameInfo.timeStep_ = 1.0f / 60.0f;
+
+        FrameInfo octreeFrameInfo;
+        octreeFrameInfo.frameNumber_ = frameInfo.frameNumber_;
+        octreeFrameInfo.timeStep_ = frameInfo.timeStep_;
+        octreeFrameInfo.camera_ = camera;
+
+        // Null device only resets draw statistics
+        graphics->BeginFrame();
+        timer.Begin();
+
+        for (Node* node : movingNodes)
+            node->Translate(randomEngine.GetVector3(-Vector3::ONE, Vector3::ONE));
+        timer.End(PHASE_MOVE_NODES);
+
+        octree->Update(octreeFrameInfo);
+        timer.End(PHASE_OCTREE_UPDATE);
+
+        shadowMapAllocator->ResetAllShadowMaps();
+        renderPipeline->OnUpdateBegin(renderPipeline, frameInfo);
+        FrustumOctreeQuery drawableQuery(visibleDrawables, camera->GetFrustum(),
+            DRAWABLE_GEOMETRY | DRAWABLE_LIGHT, camera->GetViewMask());
+        octree->GetDrawables(drawableQuery);
+        timer.End(PHASE_SCENE_PROCESSOR);
+
+        drawableProcessor->ProcessVisibleDrawables(visibleDrawables, nullptr);
+        drawableProcessor->ProcessLights(sceneProcessor);
+        drawableProcessor->UpdateGeometries();
+        timer.End(PHASE_DRAWABLE_PROCESSOR);
+
+        batchCompositor->ComposeSceneBatches();
+        batchCompositor->ComposeShadowBatches();
+        renderPipeline->OnUpdateEnd(renderPipeline, frameInfo);
+        timer.End(PHASE_BATCH_COMPOSITOR);
+
+        // Sorting is invoked from BatchCompositor, move its time into separate phase
+        if (timer.measure_)
+        {
+            const long long sortTime = opaquePass->sortTime_ + alphaPass->sortTime_;
+            timer.phaseTimes_[PHASE_BATCH_COMPOSITOR] -= sortTime;
+            timer.phaseTimes_[PHASE_BATCH_SORTING] += sortTime;
+        }
+
+        // Record draw commands, null device only counts them on execution
+        renderPipeline->OnRenderBegin(renderPipeline, frameInfo);
+        timer.Begin();
+        for (LightProcessor* sceneLight : drawableProcessor->GetLightProcessorsByShadowMap())
+        {
+            for (const ShadowSplitProcessor& split : sceneLight->GetSplits())
+            {
+                drawQueue->Reset(false);
+                batchRenderer->RenderBatches({ *drawQueue, split }, split.GetShadowBatches());
+                drawQueue->Execute();
+                if (timer.measure_)
+                    numShadowBatches += split.GetShadowBatches().batches_.size();
+            }
+        }
+        drawQueue->Reset(false);
+        batchRenderer->RenderBatches({ *drawQueue, *camera }, opaquePass->GetBaseBatches());
+        batchRenderer->RenderBatches({ *drawQueue, *camera }, opaquePass->GetLightBatches());
+        batchRenderer->RenderBatches({ *drawQueue, *camera }, alphaPass->GetBatches());
+        drawQueue->Execute();
+        timer.End(PHASE_BATCH_RENDERER);
+        renderPipeline->OnRenderEnd(renderPipeline, frameInfo);
+
+        if (timer.measure_)
+        {
+            numVisibleDrawables += visibleDrawables.size();
+            numBatches += opaquePass->GetBaseBatches().batches_.size() + opaquePass->GetLightBatches().batches_.size()
+                + alphaPass->GetBatches().batches_.size();
+            numDrawCalls += graphics->GetNumBatches();
+            numPrimitives += graphics->GetNumPrimitives();
+        }
+
+        // Frame memory is not used after this point
+        FrameAllocator::Reset();
+    }
+
+    ea::string report = Format("{} static models ({} moving, {} alpha), {} lights, {} shadow casters\n",
+        params.numStaticModels_, params.numMovingModels_, params.numAlphaModels_, params.numLights_,
+        params.numShadowCasters_);
+    report += Format("{} visible drawables, {} scene batches, {} shadow batches per frame on average\n",
+        numVisibleDrawables / numFrames, numBatches / numFrames, numShadowBatches / numFrames);
+    report += Format("{} draw calls, {} primitives per frame on average\n", numDrawCalls / numFrames, numPrimitives / numFrames);
+    for (unsigned phase = 0; phase < NUM_PHASES; ++phase)
+    {
+        report += Format("{:<20} {:>8} us/frame {:>8} allocations/frame\n", phaseNames[phase],
+            timer.phaseTimes_[phase] / numFrames, timer.phaseAllocations_[phase] / numFrames);
+    }
+    std::printf("%s", report.c_str());
+
+    sceneProcessor = nullptr;
+    scene = nullptr;
+    engine = nullptr;
+    return numVisibleDrawables > 0 && numPrimitives > 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -24,6 +24,7 @@
 
 #include "CommonUtils.h"
 
+#include <Urho3D/Core/WorkQueue.h>
 #include <Urho3D/Engine/Engine.h>
 #include <Urho3D/Engine/EngineDefs.h>
 
@@ -42,4 +43,12 @@ SharedPtr<Context> CreateCompleteTestContext()
     return context;
 }
 
+void RecreateWorkQueue(Context* context, unsigned numWorkerThreads)
+{
+    auto workQueue = MakeShared<WorkQueue>(context);
+    workQueue->CreateThreads(numWorkerThreads);
+    context->RemoveSubsystem<WorkQueue>();
+    context->RegisterSubsystem(workQueue);
+}
+
 }
@@ -36,6 +36,8 @@ namespace Tests
 
 /// Create test context with all subsystems ready.
 SharedPtr<Context> CreateCompleteTestContext();
+/// Replace WorkQueue of the context with one that has specified number of worker threads.
+void RecreateWorkQueue(Context* context, unsigned numWorkerThreads);
 
 }
 
@@ -0,0 +1,133 @@
+//
+// Copyright (c) 2017-2021 the rbfx project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "../CommonUtils.h"
+
+#include <Urho3D/Container/FrameAllocator.h>
+
+#include <EASTL/vector.h>
+
+#include <cstdint>
+#include <thread>
+
+namespace
+{
+
+bool IsAligned(const void* ptr, unsigned alignment)
+{
+    return reinterpret_cast<uintptr_t>(ptr) % alignment == 0;
+}
+
+}
+
+TEST_CASE("Frame allocator reuses memory after reset")
+{
+    FrameAllocator::Reset();
+
+    void* first = FrameAllocator::Allocate(100, 16);
+    void* second = FrameAllocator::Allocate(200, 64);
+    void* third = FrameAllocator::Allocate(1, 1);
+    REQUIRE(IsAligned(first, 16));
+    REQUIRE(IsAligned(second, 64));
+    REQUIRE(second >= static_cast<unsigned char*>(first) + 100);
+    REQUIRE(third >= static_cast<unsigned char*>(second) + 200);
+
+    FrameAllocator::Reset();
+    const FrameAllocatorStats stats = FrameAllocator::GetLastFrameStats();
+    REQUIRE(stats.numAllocations_ == 3);
+    REQUIRE(stats.numBytes_ == 301);
+
+    // Memory of the previous frame is reused
+    REQUIRE(FrameAllocator::Allocate(100, 16) == first);
+    FrameAllocator::Reset();
+    REQUIRE(FrameAllocator::GetLastFrameStats().numAllocations_ == 1);
+    REQUIRE(FrameAllocator::GetLastFrameStats().numHeapAllocations_ == 0);
+}
+
+TEST_CASE("Frame allocator merges memory blocks on reset")
+{
+    static const unsigned numAllocations = 32;
+    static const unsigned allocationSize = 48 * 1024;
+
+    FrameAllocator::Reset();
+
+    // Allocate more memory than fits into single block
+    const auto allocateAll = []
+    {
+        for (unsigned i = 0; i < numAllocations; ++i)
+        {
+            auto ptr = static_cast<unsigned char*>(FrameAllocator::Allocate(allocationSize, 16));
+            REQUIRE(IsAligned(ptr, 16));
+            ptr[0] = 1;
+            ptr[allocationSize - 1] = 1;
+        }
+    };
+
+    allocateAll();
+    FrameAllocator::Reset();
+    REQUIRE(FrameAllocator::GetLastFrameStats().numAllocations_ == numAllocations);
+    REQUIRE(FrameAllocator::GetLastFrameStats().numBytes_ == numAllocations * allocationSize);
+    REQUIRE(FrameAllocator::GetLastFrameStats().numHeapAllocations_ > 0);
+
+    // Merged block fits the whole frame
+    allocateAll();
+    FrameAllocator::Reset();
+    REQUIRE(FrameAllocator::GetLastFrameStats().numAllocations_ == numAllocations);
+    REQUIRE(FrameAllocator::GetLastFrameStats().numHeapAllocations_ == 0);
+
+    // Large allocation grows the arena
+    FrameAllocator::Allocate(numAllocations * allocationSize * 2, 16);
+    FrameAllocator::Reset();
+    REQUIRE(FrameAllocator::GetLastFrameStats().numHeapAllocations_ == 1);
+}
+
+TEST_CASE("Frame allocator statistics include all threads")
+{
+    FrameAllocator::Reset();
+
+    ea::vector<int, EASTLFrameAllocator> values;
+    for (int i = 0; i < 1000; ++i)
+        values.push_back(i);
+
+    std::thread thread([] { FrameAllocator::Allocate(10, 4); });
+    thread.join();
+
+    FrameAllocator::Reset();
+    const FrameAllocatorStats stats = FrameAllocator::GetLastFrameStats();
+    REQUIRE(stats.numAllocations_ > 1);
+    REQUIRE(stats.numBytes_ >= 1000 * sizeof(int) + 10);
+}
+
+TEST_CASE("Frame allocator releases arenas of exited threads on reset")
+{
+    FrameAllocator::Allocate(1, 1);
+    FrameAllocator::Reset();
+    const unsigned numArenas = FrameAllocator::GetNumArenas();
+
+    std::thread thread([] { FrameAllocator::Allocate(10, 4); });
+    thread.join();
+    REQUIRE(FrameAllocator::GetNumArenas() == numArenas + 1);
+
+    FrameAllocator::Reset();
+    REQUIRE(FrameAllocator::GetLastFrameStats().numAllocations_ == 1);
+    REQUIRE(FrameAllocator::GetNumArenas() == numArenas);
+}
@@ -0,0 +1,166 @@
+//
+// Copyright (c) 2017-2021 the rbfx project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "../CommonUtils.h"
+
+#include <Urho3D/Container/PoolAllocator.h>
+#include <Urho3D/Core/StringUtils.h>
+#include <Urho3D/Core/Timer.h>
+
+#include <EASTL/sort.h>
+
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+
+namespace
+{
+
+/// Allocate objects in several threads and free them in other threads, checking that memory is not corrupted.
+void StressCrossThreadFree(unsigned numThreads, unsigned numObjects)
+{
+    const unsigned sizes[] = { 8, 16, 24, 100, 256, 700, 1024, 4000 };
+
+    // Each thread allocates objects and passes them to the next thread to free
+    ea::vector<ea::vector<ea::pair<unsigned char*, unsigned>>> handoff(numThreads);
+    std::atomic<bool> corrupted{};
+
+    ea::vector<std::thread> threads;
+    for (unsigned threadIndex = 0; threadIndex < numThreads; ++threadIndex)
+    {
+        threads.emplace_back([&, threadIndex]()
+        {
+            auto& objects = handoff[threadIndex];
+            for (unsigned i = 0; i < numObjects; ++i)
+            {
+                const unsigned size = sizes[(i + threadIndex) % ea::size(sizes)];
+                auto ptr = static_cast<unsigned char*>(PoolAllocator::Allocate(size));
+                memset(ptr, static_cast<int>(threadIndex + 1), size);
+                objects.emplace_back(ptr, size);
+
+                // Free some objects immediately in the owner thread
+                if (i % 3 == 0)
+                {
+                    PoolAllocator::Free(objects.back().first, objects.back().second);
+                    objects.pop_back();
+                }
+            }
+        });
+    }
+    for (std::thread& thread : threads)
+        thread.join();
+    threads.clear();
+
+    for (unsigned threadIndex = 0; threadIndex < numThreads; ++threadIndex)
+    {
+        threads.emplace_back([&, threadIndex]()
+        {
+            const unsigned ownerIndex = (threadIndex + 1) % numThreads;
+            for (const auto& [ptr, size] : handoff[ownerIndex])
+            {
+                for (unsigned j = 0; j < size; ++j)
+                {
+                    if (ptr[j] != ownerIndex + 1)
+                        corrupted = true;
+                }
+                PoolAllocator::Free(ptr, size);
+            }
+        });
+    }
+    for (std::thread& thread : threads)
+        thread.join();
+
+    REQUIRE_FALSE(corrupted);
+}
+
+}
+
+TEST_CASE("PoolAllocator returns distinct aligned memory")
+{
+    ea::vector<void*> objects;
+    for (unsigned size = 1; size <= PoolAllocator::MaxPooledSize + 64; size += 7)
+    {
+        void* ptr = PoolAllocator::Allocate(size);
+        REQUIRE(reinterpret_cast<uintptr_t>(ptr) % 16 == 0);
+        memset(ptr, 0xcd, size);
+        objects.push_back(ptr);
+    }
+
+    ea::vector<void*> sortedObjects = objects;
+    ea::sort(sortedObjects.begin(), sortedObjects.end());
+    REQUIRE(ea::unique(sortedObjects.begin(), sortedObjects.end()) == sortedObjects.end());
+
+    unsigned index = 0;
+    for (unsigned size = 1; size <= PoolAllocator::MaxPooledSize + 64; size += 7)
+        PoolAllocator::Free(objects[index++], size);
+
+    // Freed memory is reused
+    void* ptr = PoolAllocator::Allocate(64);
+    PoolAllocator::Free(ptr, 64);
+    REQUIRE(PoolAllocator::Allocate(64) == ptr);
+    PoolAllocator::Free(ptr, 64);
+}
+
+TEST_CASE("PoolAllocator supports frees from other threads")
+{
+    for (unsigned iteration = 0; iteration < 10; ++iteration)
+        StressCrossThreadFree(4, 10000);
+
+    // Caches of finished threads are reused
+    REQUIRE(PoolAllocator::GetStats().numThreadCaches_ <= 16);
+}
+
+TEST_CASE("PoolAllocator benchmark", "[.benchmark]")
+{
+    const unsigned numIterations = 100;
+    const unsigned numObjects = 10000;
+    const unsigned sizes[] = { 16, 48, 64, 128, 256 };
+    ea::vector<void*> objects(numObjects);
+
+    const auto runBenchmark = [&](auto allocate, auto deallocate)
+    {
+        HiresTimer timer;
+        for (unsigned iteration = 0; iteration < numIterations; ++iteration)
+        {
+            for (unsigned i = 0; i < numObjects; ++i)
+                objects[i] = allocate(sizes[i % ea::size(sizes)]);
+            // Free in interleaved order to simulate fragmentation
+            for (unsigned i = 0; i < numObjects; i += 2)
+                deallocate(objects[i], sizes[i % ea::size(sizes)]);
+            for (unsigned i = 1; i < numObjects; i += 2)
+                deallocate(objects[i], sizes[i % ea::size(sizes)]);
+        }
+        return timer.GetUSec(false);
+    };
+
+    const long long poolTime = runBenchmark(
+        [](unsigned size) { return PoolAllocator::Allocate(size); },
+        [](void* ptr, unsigned size) { PoolAllocator::Free(ptr, size); });
+    const long long mallocTime = runBenchmark(
+        [](unsigned size) { return malloc(size); },
+        [](void* ptr, unsigned /*size*/) { free(ptr); });
+
+    const unsigned numOperations = numIterations * numObjects;
+    WARN(Format("Pool: {} us, malloc: {} us for {} allocations and deallocations",
+        poolTime, mallocTime, numOperations).c_str());
+}
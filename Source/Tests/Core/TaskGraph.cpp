@@ -0,0 +1,73 @@
+//
+// Copyright (c) 2017-2021 the rbfx project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR rhs
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR rhsWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR rhs DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "../CommonUtils.h"
+
+#include <Urho3D/Core/TaskGraph.h>
+
+TEST_CASE("TaskGraph executes tasks in order of dependencies")
+{
+    auto context = MakeShared<Context>();
+    auto workQueue = MakeShared<WorkQueue>(context);
+    workQueue->CreateThreads(3);
+
+    TaskGraph graph(workQueue);
+    for (unsigned iteration = 0; iteration < 10; ++iteration)
+    {
+        ea::vector<unsigned> values(1000);
+        std::atomic<bool> mainThreadTaskInWorker{};
+        unsigned sum = 0;
+
+        graph.Clear();
+        const auto fill = graph.AddParallelTask("Fill", values.size(), 16,
+            [&](unsigned beginIndex, unsigned endIndex)
+        {
+            for (unsigned i = beginIndex; i < endIndex; ++i)
+                values[i] = i;
+        });
+        const auto square = graph.AddParallelTask("Square", [&]() { return values.size(); }, 16,
+            [&](unsigned beginIndex, unsigned endIndex)
+        {
+            for (unsigned i = beginIndex; i < endIndex; ++i)
+                values[i] *= values[i];
+        });
+        graph.AddDependency(square, fill);
+        const auto accumulate = graph.AddTask("Accumulate", [&](unsigned threadIndex)
+        {
+            if (threadIndex != 0)
+                mainThreadTaskInWorker = true;
+            for (unsigned value : values)
+                sum += value;
+        }, TaskAffinity::MainThread);
+        graph.AddDependency(accumulate, square);
+
+        graph.Execute();
+
+        unsigned expectedSum = 0;
+        for (unsigned i = 0; i < values.size(); ++i)
+            expectedSum += i * i;
+
+        REQUIRE(sum == expectedSum);
+        REQUIRE_FALSE(mainThreadTaskInWorker);
+        REQUIRE(graph.GetCriticalPath().size() == 3);
+    }
+}
@@ -0,0 +1,157 @@
+//
+// Copyright (c) 2017-2021 the rbfx project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR rhs
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR rhsWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR rhs DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "../CommonUtils.h"
+
+#include <Urho3D/Core/WorkQueue.h>
+
+#include <thread>
+
+TEST_CASE("WorkQueue executes all items in ForEachParallel")
+{
+    auto context = MakeShared<Context>();
+    auto workQueue = MakeShared<WorkQueue>(context);
+    workQueue->CreateThreads(3);
+
+    ea::vector<unsigned> values(10000);
+    for (unsigned iteration = 0; iteration < 10; ++iteration)
+    {
+        ForEachParallel(workQueue, 7u, values, [](unsigned index, unsigned& value) { value += index; });
+    }
+
+    for (unsigned i = 0; i < values.size(); ++i)
+        REQUIRE(values[i] == i * 10);
+}
+
+TEST_CASE("WorkQueue respects work item dependencies")
+{
+    auto context = MakeShared<Context>();
+    auto workQueue = MakeShared<WorkQueue>(context);
+    workQueue->CreateThreads(3);
+
+    for (unsigned iteration = 0; iteration < 100; ++iteration)
+    {
+        std::atomic<unsigned> counter{};
+        std::atomic<bool> orderViolated{};
+
+        ea::vector<SharedPtr<WorkItem>> firstStage;
+        for (unsigned i = 0; i < 8; ++i)
+            firstStage.push_back(workQueue->AddWorkItem([&](unsigned) { ++counter; }, M_MAX_UNSIGNED));
+
+        ea::vector<SharedPtr<WorkItem>> secondStage;
+        for (unsigned i = 0; i < 8; ++i)
+        {
+            secondStage.push_back(workQueue->AddWorkItem([&](unsigned)
+            {
+                if (counter.load() < 8)
+                    orderViolated = true;
+                ++counter;
+            }, firstStage, M_MAX_UNSIGNED));
+        }
+
+        workQueue->AddWorkItem([&](unsigned)
+        {
+            if (counter.load() < 16)
+                orderViolated = true;
+        }, secondStage, M_MAX_UNSIGNED);
+
+        workQueue->Complete(M_MAX_UNSIGNED);
+        REQUIRE(counter == 16);
+        REQUIRE_FALSE(orderViolated);
+    }
+}
+
+TEST_CASE("WorkQueue cancels items that are not started")
+{
+    auto context = MakeShared<Context>();
+    auto workQueue = MakeShared<WorkQueue>(context);
+
+    bool executed = false;
+    bool dependentExecuted = false;
+    SharedPtr<WorkItem> item = workQueue->AddWorkItem([&](unsigned) { executed = true; }, M_MAX_UNSIGNED);
+    workQueue->AddWorkItem([&](unsigned) { dependentExecuted = true; }, {&item, 1}, M_MAX_UNSIGNED);
+
+    REQUIRE(workQueue->RemoveWorkItem(item));
+    workQueue->Complete(M_MAX_UNSIGNED);
+
+    REQUIRE_FALSE(executed);
+    REQUIRE(dependentExecuted);
+}
+
+TEST_CASE("WorkQueue completes only specified items")
+{
+    auto context = MakeShared<Context>();
+    auto workQueue = MakeShared<WorkQueue>(context);
+    workQueue->CreateThreads(1);
+
+    // Keep the only worker thread busy with unrelated work
+    std::atomic<bool> started{};
+    std::atomic<bool> released{};
+    const auto blockingItem = workQueue->AddWorkItem([&](unsigned)
+    {
+        started = true;
+        while (!released)
+            std::this_thread::yield();
+    }, M_MAX_UNSIGNED);
+    while (!started)
+        std::this_thread::yield();
+
+    std::atomic<unsigned> counter{};
+    ea::vector<SharedPtr<WorkItem>> items;
+    for (unsigned i = 0; i < 4; ++i)
+        items.push_back(workQueue->AddWorkItem([&](unsigned) { ++counter; }, M_MAX_UNSIGNED));
+
+    workQueue->CompleteItems(items);
+    REQUIRE(counter.load() == 4);
+    REQUIRE_FALSE(blockingItem->completed_.load());
+
+    released = true;
+    workQueue->Complete(M_MAX_UNSIGNED);
+    REQUIRE(blockingItem->completed_.load());
+    REQUIRE(workQueue->GetNumIncomplete(0) == 0);
+}
+
+TEST_CASE("WorkQueue completes items waiting for dependencies without worker threads")
+{
+    auto context = MakeShared<Context>();
+    auto workQueue = MakeShared<WorkQueue>(context);
+
+    ea::vector<unsigned> order;
+    const auto first = workQueue->AddWorkItem([&](unsigned) { order.push_back(0); }, M_MAX_UNSIGNED);
+    const auto second = workQueue->AddWorkItem([&](unsigned) { order.push_back(1); }, M_MAX_UNSIGNED);
+    const SharedPtr<WorkItem> firstDependency[] = { first };
+    const auto third = workQueue->AddWorkItem([&](unsigned) { order.push_back(2); }, firstDependency, M_MAX_UNSIGNED);
+    const SharedPtr<WorkItem> thirdDependency[] = { third };
+    const auto fourth = workQueue->AddWorkItem([&](unsigned) { order.push_back(3); }, thirdDependency, M_MAX_UNSIGNED);
+
+    // Dependencies are executed by the main thread, unrelated item may be executed meanwhile too
+    const SharedPtr<WorkItem> items[] = { fourth };
+    workQueue->CompleteItems(items);
+    REQUIRE(fourth->completed_.load());
+    REQUIRE(first->completed_.load());
+    REQUIRE(third->completed_.load());
+    REQUIRE(order.back() == 3);
+
+    workQueue->Complete(M_MAX_UNSIGNED);
+    REQUIRE(order.size() == 4);
+    REQUIRE(workQueue->GetNumIncomplete(0) == 0);
+}
@@ -0,0 +1,419 @@
+//
+// Copyright (c) 2017-2021 the rbfx project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "../CommonUtils.h"
+
+#include <Urho3D/Core/StringUtils.h>
+#include <Urho3D/Core/Timer.h>
+#include <Urho3D/Graphics/AnimatedModel.h>
+#include <Urho3D/Graphics/Animation.h>
+#include <Urho3D/Graphics/AnimationPoseCache.h>
+#include <Urho3D/Graphics/AnimationState.h>
+#include <Urho3D/Graphics/Model.h>
+#include <Urho3D/Graphics/Octree.h>
+#include <Urho3D/Scene/Scene.h>
+
+namespace
+{
+
+/// Create model with skeleton only. Bone N is attached to bone (N - 1) / 2, all bones are offset along Y axis.
+SharedPtr<Model> CreateSkeletonModel(Context* context, unsigned numBones)
+{
+    Skeleton skeleton;
+    ea::vector<Bone>& bones = skeleton.GetModifiableBones();
+    bones.resize(numBones);
+    for (unsigned i = 0; i < numBones; ++i)
+    {
+        Bone& bone = bones[i];
+        bone.name_ = Format("Bone{}", i);
+        bone.nameHash_ = bone.name_;
+        bone.parentIndex_ = i > 0 ? (i - 1) / 2 : 0;
+        bone.initialPosition_ = i > 0 ? Vector3::UP : Vector3::ZERO;
+        bone.collisionMask_ = BONECOLLISION_SPHERE;
+        bone.radius_ = 0.1f;
+    }
+    skeleton.SetRootBoneIndex(0);
+
+    auto model = MakeShared<Model>(context);
+    model->SetName(Format("Models/Skeleton{}.mdl", numBones));
+    model->SetBoundingBox(BoundingBox(-Vector3::ONE, Vector3::ONE));
+    model->SetSkeleton(skeleton);
+    return model;
+}
+
+/// Create animation that rotates every bone around Z axis.
+SharedPtr<Animation> CreateBendAnimation(Context* context, unsigned numBones, float angle)
+{
+    auto animation = MakeShared<Animation>(context);
+    animation->SetName(Format("Animations/Bend{}_{}.ani", numBones, angle));
+    animation->SetAnimationName("Bend");
+    animation->SetLength(1.0f);
+    for (unsigned i = 0; i < numBones; ++i)
+    {
+        AnimationTrack* track = animation->CreateTrack(Format("Bone{}", i));
+        track->channelMask_ = CHANNEL_POSITION | CHANNEL_ROTATION;
+
+        AnimationKeyFrame keyFrame;
+        keyFrame.position_ = i > 0 ? Vector3::UP : Vector3::ZERO;
+        keyFrame.time_ = 0.0f;
+        track->AddKeyFrame(keyFrame);
+        keyFrame.time_ = 1.0f;
+        keyFrame.rotation_ = Quaternion(angle, Vector3::FORWARD);
+        track->AddKeyFrame(keyFrame);
+    }
+    return animation;
+}
+
+/// Compare transforms with tolerance.
+bool AreTransformsEqual(const Matrix3x4& lhs, const Matrix3x4& rhs)
+{
+    for (unsigned i = 0; i < 12; ++i)
+    {
+        if (Abs(lhs.Data()[i] - rhs.Data()[i]) > 0.0001f)
+            return false;
+    }
+    return true;
+}
+
+}
+
+TEST_CASE("Animated model evaluates pose without bone nodes")
+{
+    auto context = Tests::CreateCompleteTestContext();
+    auto scene = MakeShared<Scene>(context);
+    scene->CreateComponent<Octree>();
+
+    const unsigned numBones = 3;
+    const auto model = CreateSkeletonModel(context, numBones);
+    const auto animation = CreateBendAnimation(context, numBones, 90.0f);
+
+    Node* node = scene->CreateChild("Character");
+    node->SetPosition({ 10.0f, 0.0f, 0.0f });
+    auto animatedModel = node->CreateComponent<AnimatedModel>();
+    animatedModel->SetModel(model);
+    animatedModel->SetLazyBoneUpdate(true);
+
+    AnimationState* state = animatedModel->AddAnimationState(animation);
+    state->SetWeight(1.0f);
+    state->SetTime(1.0f);
+    animatedModel->ApplyAnimation();
+
+    // Bone nodes are not touched, pose is still available
+    Node* boneNode = node->GetChild("Bone1", true);
+    REQUIRE(boneNode);
+    REQUIRE(animatedModel->AreBoneNodesDirty());
+    REQUIRE(boneNode->GetRotation().Equals(Quaternion::IDENTITY));
+
+    const Vector3 expectedPosition{ 10.0f - 1.0f, 0.0f, 0.0f };
+    REQUIRE((animatedModel->GetBoneWorldTransform(1).Translation() - expectedPosition).Length() < 0.0001f);
+
+    // Bone nodes are written on demand
+    animatedModel->UpdateBoneNodes();
+    REQUIRE_FALSE(animatedModel->AreBoneNodesDirty());
+    for (unsigned i = 0; i < numBones; ++i)
+    {
+        Node* currentBoneNode = animatedModel->GetSkeleton().GetBone(i)->node_;
+        REQUIRE(AreTransformsEqual(currentBoneNode->GetWorldTransform(), animatedModel->GetBoneWorldTransform(i)));
+    }
+
+    // Bone nodes with attachments are always written
+    boneNode->CreateChild("Attachment");
+    state->SetTime(0.5f);
+    animatedModel->ApplyAnimation();
+    REQUIRE_FALSE(animatedModel->AreBoneNodesDirty());
+    REQUIRE(Abs(boneNode->GetRotation().DotProduct(Quaternion(45.0f, Vector3::FORWARD))) > 0.9999f);
+    REQUIRE(AreTransformsEqual(boneNode->GetWorldTransform(), animatedModel->GetBoneWorldTransform(1)));
+}
+
+TEST_CASE("Animated models share pose via pose cache")
+{
+    auto context = Tests::CreateCompleteTestContext();
+    auto scene = MakeShared<Scene>(context);
+    scene->CreateComponent<Octree>();
+    auto poseCache = scene->CreateComponent<AnimationPoseCache>();
+    poseCache->SetTimeStep(0.25f);
+
+    const unsigned numBones = 7;
+    const auto model = CreateSkeletonModel(context, numBones);
+    const auto animation = CreateBendAnimation(context, numBones, 90.0f);
+
+    const auto createAnimatedModel = [&](bool usePoseCache, float time)
+    {
+        auto animatedModel = scene->CreateChild()->CreateComponent<AnimatedModel>();
+        animatedModel->SetModel(model);
+        animatedModel->SetLazyBoneUpdate(true);
+        animatedModel->SetUsePoseCache(usePoseCache);
+
+        AnimationState* state = animatedModel->AddAnimationState(animation);
+        state->SetWeight(1.0f);
+        state->SetTime(time);
+        animatedModel->ApplyAnimation();
+        return animatedModel;
+    };
+
+    // Models within the same time step share the pose
+    auto firstModel = createAnimatedModel(true, 0.5f);
+    auto secondModel = createAnimatedModel(true, 0.6f);
+    auto thirdModel = createAnimatedModel(true, 0.8f);
+    REQUIRE(firstModel->GetSharedPose());
+    REQUIRE(firstModel->GetSharedPose() == secondModel->GetSharedPose());
+    REQUIRE(firstModel->GetSharedPose() != thirdModel->GetSharedPose());
+    REQUIRE(poseCache->GetNumPoses() == 2);
+    REQUIRE(poseCache->GetNumHits() == 1);
+    REQUIRE(poseCache->GetNumMisses() == 2);
+
+    // Shared pose is sampled at quantized time
+    auto referenceModel = createAnimatedModel(false, 0.5f);
+    REQUIRE_FALSE(referenceModel->GetSharedPose());
+    for (unsigned i = 0; i < numBones; ++i)
+    {
+        REQUIRE(AreTransformsEqual(secondModel->GetBoneModelTransforms()[i], referenceModel->GetBoneModelTransforms()[i]));
+        REQUIRE(AreTransformsEqual(secondModel->GetSharedPose()->skinMatrices_[i],
+            referenceModel->GetBoneModelTransforms()[i] * model->GetSkeleton().GetBone(i)->offsetMatrix_));
+    }
+}
+
+TEST_CASE("Animated model skinning from pose matches skinning from bone nodes")
+{
+    auto context = Tests::CreateCompleteTestContext();
+    auto scene = MakeShared<Scene>(context);
+    scene->CreateComponent<Octree>();
+
+    const unsigned numBones = 7;
+    const unsigned changedBone = 5;
+    const auto model = CreateSkeletonModel(context, numBones);
+    const auto baseAnimation = CreateBendAnimation(context, numBones, 90.0f);
+    const auto partialAnimation = CreateBendAnimation(context, numBones, -40.0f);
+    const auto additiveAnimation = CreateBendAnimation(context, numBones, 20.0f);
+
+    const auto createAnimatedModel = [&]()
+    {
+        Node* node = scene->CreateChild("Character");
+        node->SetPosition({ 10.0f, 0.0f, 0.0f });
+        node->SetRotation(Quaternion(30.0f, Vector3::UP));
+        auto animatedModel = node->CreateComponent<AnimatedModel>();
+        animatedModel->SetModel(model);
+        animatedModel->SetLazyBoneUpdate(true);
+
+        AnimationState* baseState = animatedModel->AddAnimationState(baseAnimation);
+        baseState->SetWeight(1.0f);
+        baseState->SetTime(0.6f);
+
+        AnimationState* partialState = animatedModel->AddAnimationState(partialAnimation);
+        partialState->SetWeight(0.7f);
+        partialState->SetTime(0.8f);
+        partialState->SetLayer(1);
+        partialState->SetBoneWeight(1u, 0.0f);
+        partialState->SetBoneWeight(2u, 0.5f, true);
+
+        AnimationState* additiveState = animatedModel->AddAnimationState(additiveAnimation);
+        additiveState->SetWeight(0.4f);
+        additiveState->SetTime(0.5f);
+        additiveState->SetLayer(2);
+        additiveState->SetBlendMode(ABM_ADDITIVE);
+        additiveState->SetBoneWeight(3u, 0.25f);
+
+        animatedModel->ApplyAnimation();
+        return animatedModel;
+    };
+
+    FrameInfo frameInfo;
+    frameInfo.frameNumber_ = 1;
+    frameInfo.timeStep_ = 1.0f / 60.0f;
+
+    // Skin matrices are evaluated from the pose, bone nodes are out of date
+    auto poseModel = createAnimatedModel();
+    poseModel->UpdateGeometry(frameInfo);
+    REQUIRE(poseModel->AreBoneNodesDirty());
+
+    // Change bone node directly to the same transform as in the pose, skinning falls back to bone nodes
+    auto nodeModel = createAnimatedModel();
+    const ea::vector<Matrix3x4>& boneModelTransforms = poseModel->GetBoneModelTransforms();
+    const Matrix3x4 changedBoneTransform = boneModelTransforms[(changedBone - 1) / 2].Inverse() * boneModelTransforms[changedBone];
+    Node* changedBoneNode = nodeModel->GetSkeleton().GetBone(changedBone)->node_;
+    // Bone node is notified of changes only when its world transform is up to date
+    changedBoneNode->GetWorldTransform();
+    changedBoneNode->SetTransform(changedBoneTransform);
+    REQUIRE_FALSE(nodeModel->AreBoneNodesDirty());
+    nodeModel->UpdateGeometry(frameInfo);
+
+    for (unsigned i = 0; i < numBones; ++i)
+    {
+        Node* boneNode = nodeModel->GetSkeleton().GetBone(i)->node_;
+        REQUIRE(AreTransformsEqual(boneNode->GetWorldTransform(), poseModel->GetBoneWorldTransform(i)));
+        REQUIRE(AreTransformsEqual(nodeModel->GetSkinMatrices()[i], poseModel->GetSkinMatrices()[i]));
+    }
+}
+
+TEST_CASE("Animated model update benchmark", "[.benchmark]")
+{
+    static const unsigned numModels = 500;
+    static const unsigned numBones = 63;
+    static const unsigned numFrames = 100;
+
+    auto context = Tests::CreateCompleteTestContext();
+    const auto model = CreateSkeletonModel(context, numBones);
+    const auto animation = CreateBendAnimation(context, numBones, 30.0f);
+
+    ea::string report = Format("{} models, {} bones each\n", numModels, numBones);
+    for (const bool lazyBoneUpdate : { false, true })
+    {
+        auto scene = MakeShared<Scene>(context);
+        auto octree = scene->CreateComponent<Octree>();
+
+        ea::vector<AnimatedModel*> animatedModels;
+        for (unsigned i = 0; i < numModels; ++i)
+        {
+            Node* node = scene->CreateChild();
+            node->SetPosition({ i * 2.0f, 0.0f, 0.0f });
+            auto animatedModel = node->CreateComponent<AnimatedModel>();
+            animatedModel->SetModel(model);
+            animatedModel->SetLazyBoneUpdate(lazyBoneUpdate);
+            animatedModel->AddAnimationState(animation)->SetWeight(1.0f);
+            animatedModels.push_back(animatedModel);
+        }
+
+        HiresTimer timer;
+        for (unsigned frameIndex = 0; frameIndex < numFrames; ++frameIndex)
+        {
+            FrameInfo frameInfo;
+            frameInfo.frameNumber_ = frameIndex + 1;
+            frameInfo.timeStep_ = 1.0f / 60.0f;
+
+            for (AnimatedModel* animatedModel : animatedModels)
+                animatedModel->GetAnimationState(0u)->AddTime(frameInfo.timeStep_);
+            octree->Update(frameInfo);
+            for (AnimatedModel* animatedModel : animatedModels)
+                animatedModel->UpdateGeometry(frameInfo);
+        }
+
+        report += Format("{:<24} {:>8} us/frame\n", lazyBoneUpdate ? "Lazy bone update:" : "Bone nodes updated:",
+            timer.GetUSec(false) / numFrames);
+    }
+    WARN(report.c_str());
+}
+
+TEST_CASE("Pose cache is not used for models with disabled bone animation")
+{
+    auto context = Tests::CreateCompleteTestContext();
+    auto scene = MakeShared<Scene>(context);
+    scene->CreateComponent<Octree>();
+    auto poseCache = scene->CreateComponent<AnimationPoseCache>();
+    poseCache->SetTimeStep(0.0f);
+
+    const unsigned numBones = 7;
+    const auto model = CreateSkeletonModel(context, numBones);
+    const auto animation = CreateBendAnimation(context, numBones, 90.0f);
+
+    const auto createAnimatedModel = [&](bool usePoseCache, bool disableBoneAnimation)
+    {
+        auto animatedModel = scene->CreateChild()->CreateComponent<AnimatedModel>();
+        animatedModel->SetModel(model);
+        animatedModel->SetLazyBoneUpdate(true);
+        animatedModel->SetUsePoseCache(usePoseCache);
+
+        if (disableBoneAnimation)
+        {
+            Bone* bone = animatedModel->GetSkeleton().GetBone(1);
+            bone->animated_ = false;
+            bone->node_->SetRotation(Quaternion(30.0f, Vector3::FORWARD));
+        }
+
+        AnimationState* state = animatedModel->AddAnimationState(animation);
+        state->SetWeight(1.0f);
+        state->SetTime(0.5f);
+        animatedModel->ApplyAnimation();
+        return animatedModel;
+    };
+
+    auto sharedModel = createAnimatedModel(true, false);
+    auto overriddenModel = createAnimatedModel(true, true);
+    auto referenceModel = createAnimatedModel(false, true);
+    REQUIRE(sharedModel->GetSharedPose());
+    REQUIRE_FALSE(overriddenModel->GetSharedPose());
+
+    // Bone 1 and its children 3 and 4 follow the bone node
+    for (unsigned i = 0; i < numBones; ++i)
+        REQUIRE(AreTransformsEqual(overriddenModel->GetBoneModelTransforms()[i], referenceModel->GetBoneModelTransforms()[i]));
+    for (unsigned i : { 1, 3, 4 })
+        REQUIRE_FALSE(AreTransformsEqual(overriddenModel->GetBoneModelTransforms()[i], sharedModel->GetBoneModelTransforms()[i]));
+
+    const Quaternion boneRotation = overriddenModel->GetBoneModelTransforms()[1].Rotation();
+    REQUIRE(Abs(boneRotation.DotProduct(Quaternion(30.0f, Vector3::FORWARD) * Quaternion(45.0f, Vector3::FORWARD))) > 0.9999f);
+}
+
+TEST_CASE("Animated crowd pose cache benchmark", "[.benchmark]")
+{
+    static const unsigned numModels = 1000;
+    static const unsigned numBones = 63;
+    static const unsigned numPhases = 16;
+    static const unsigned numFrames = 100;
+
+    auto context = Tests::CreateCompleteTestContext();
+    const auto model = CreateSkeletonModel(context, numBones);
+    const auto animation = CreateBendAnimation(context, numBones, 30.0f);
+    animation->SetLength(2.0f);
+
+    ea::string report = Format("{} models, {} bones each, {} animation phases\n", numModels, numBones, numPhases);
+    for (const bool usePoseCache : { false, true })
+    {
+        auto scene = MakeShared<Scene>(context);
+        auto octree = scene->CreateComponent<Octree>();
+        auto poseCache = scene->CreateComponent<AnimationPoseCache>();
+
+        ea::vector<AnimatedModel*> animatedModels;
+        for (unsigned i = 0; i < numModels; ++i)
+        {
+            Node* node = scene->CreateChild();
+            node->SetPosition({ (i % 32) * 2.0f, 0.0f, (i / 32) * 2.0f });
+            auto animatedModel = node->CreateComponent<AnimatedModel>();
+            animatedModel->SetModel(model);
+            animatedModel->SetLazyBoneUpdate(true);
+            animatedModel->SetUsePoseCache(usePoseCache);
+
+            AnimationState* state = animatedModel->AddAnimationState(animation);
+            state->SetWeight(1.0f);
+            state->SetLooped(true);
+            state->SetTime((i % numPhases) * animation->GetLength() / numPhases);
+            animatedModels.push_back(animatedModel);
+        }
+
+        HiresTimer timer;
+        for (unsigned frameIndex = 0; frameIndex < numFrames; ++frameIndex)
+        {
+            FrameInfo frameInfo;
+            frameInfo.frameNumber_ = frameIndex + 1;
+            frameInfo.timeStep_ = 1.0f / 60.0f;
+
+            for (AnimatedModel* animatedModel : animatedModels)
+                animatedModel->GetAnimationState(0u)->AddTime(frameInfo.timeStep_);
+            octree->Update(frameInfo);
+            for (AnimatedModel* animatedModel : animatedModels)
+                animatedModel->UpdateGeometry(frameInfo);
+        }
+
+        report += Format("{:<20} {:>8} us/frame, {} cache hits, {} cache misses\n",
+            usePoseCache ? "Pose cache:" : "No pose cache:", timer.GetUSec(false) / numFrames,
+            poseCache->GetNumHits(), poseCache->GetNumMisses());
+    }
+    WARN(report.c_str());
+}
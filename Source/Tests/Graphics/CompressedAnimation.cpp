@@ -0,0 +1,266 @@
+//
+// Copyright (c) 2017-2021 the rbfx project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "../CommonUtils.h"
+
+#include <Urho3D/Core/StringUtils.h>
+#include <Urho3D/Core/Timer.h>
+#include <Urho3D/Graphics/Animation.h>
+#include <Urho3D/Graphics/AnimationState.h>
+#include <Urho3D/Graphics/CompressedAnimation.h>
+#include <Urho3D/IO/VectorBuffer.h>
+#include <Urho3D/Math/RandomEngine.h>
+#include <Urho3D/Scene/Scene.h>
+
+namespace
+{
+
+/// Create animation with constant, linear and arbitrary tracks.
+SharedPtr<Animation> CreateTestAnimation(Context* context, unsigned numTracks, float length, float keyFrameRate)
+{
+    auto animation = MakeShared<Animation>(context);
+    animation->SetLength(length);
+
+    RandomEngine engine(0);
+    const unsigned numKeyFrames = static_cast<unsigned>(length * keyFrameRate) + 1;
+    for (unsigned trackIndex = 0; trackIndex < numTracks; ++trackIndex)
+    {
+        AnimationTrack* track = animation->CreateTrack(Format("Bone{}", trackIndex));
+        track->channelMask_ = CHANNEL_POSITION | CHANNEL_ROTATION;
+        if (trackIndex % 4 == 0)
+            track->channelMask_ |= CHANNEL_SCALE;
+
+        const Vector3 basePosition = engine.GetVector3(-Vector3::ONE, Vector3::ONE);
+        const Vector3 velocity = engine.GetVector3(-Vector3::ONE, Vector3::ONE);
+        const Vector3 axis = engine.GetDirectionVector3();
+        const float frequency = engine.GetFloat(0.5f, 2.0f);
+        const float amplitude = engine.GetFloat(10.0f, 60.0f);
+
+        for (unsigned i = 0; i < numKeyFrames; ++i)
+        {
+            AnimationKeyFrame keyFrame;
+            keyFrame.time_ = ea::min(i / keyFrameRate, length);
+            const float wave = Sin(keyFrame.time_ * frequency * 360.0f);
+
+            switch (trackIndex % 3)
+            {
+            case 0: // Constant
+                keyFrame.position_ = basePosition;
+                keyFrame.rotation_ = Quaternion(amplitude, axis);
+                break;
+            case 1: // Linear
+                keyFrame.position_ = basePosition + velocity * keyFrame.time_;
+                keyFrame.rotation_ = Quaternion(amplitude * 0.25f * keyFrame.time_ / length, axis);
+                break;
+            default: // Arbitrary
+                keyFrame.position_ = basePosition + velocity * wave;
+                keyFrame.rotation_ = Quaternion(amplitude * wave, axis);
+                break;
+            }
+            keyFrame.scale_ = Vector3::ONE * (1.0f + 0.5f * wave);
+            track->AddKeyFrame(keyFrame);
+        }
+    }
+    return animation;
+}
+
+/// Sample all tracks from keyframes like AnimationState does.
+void SampleKeyFrames(const ea::vector<const AnimationTrack*>& tracks, ea::vector<unsigned>& frameHints, float time, AnimationPose& pose)
+{
+    for (unsigned i = 0; i < tracks.size(); ++i)
+    {
+        const AnimationTrack& track = *tracks[i];
+        unsigned& frame = frameHints[i];
+        track.GetKeyFrameIndex(time, frame);
+
+        const unsigned nextFrame = ea::min(frame + 1, track.keyFrames_.size() - 1);
+        const AnimationKeyFrame& keyFrame = track.keyFrames_[frame];
+        const AnimationKeyFrame& nextKeyFrame = track.keyFrames_[nextFrame];
+        const float timeInterval = nextKeyFrame.time_ - keyFrame.time_;
+        const float t = timeInterval > 0.0f ? (time - keyFrame.time_) / timeInterval : 1.0f;
+
+        pose.positions_[i] = keyFrame.position_.Lerp(nextKeyFrame.position_, t);
+        pose.rotations_[i] = keyFrame.rotation_.Slerp(nextKeyFrame.rotation_, t);
+        pose.scales_[i] = keyFrame.scale_.Lerp(nextKeyFrame.scale_, t);
+    }
+}
+
+}
+
+TEST_CASE("Compressed animation is sampled within tolerance")
+{
+    auto context = Tests::CreateCompleteTestContext();
+    auto animation = CreateTestAnimation(context, 30, 2.0f, 30.0f);
+
+    AnimationCompressionSettings settings;
+    animation->Compress(settings);
+    const CompressedAnimation* compressed = animation->GetCompressed();
+    REQUIRE(compressed);
+    REQUIRE(compressed->GetNumTracks() == 30);
+
+    // Constant and linear tracks are reduced
+    REQUIRE(compressed->GetPositions().constantTracks_.size() == 10);
+    REQUIRE(compressed->GetPositions().linearTracks_.size() == 10);
+    REQUIRE(compressed->GetPositions().sampledTracks_.size() == 10);
+    REQUIRE(compressed->GetRotations().constantTracks_.size() == 10);
+    REQUIRE(compressed->GetRotations().linearTracks_.size() == 10);
+    REQUIRE(compressed->GetRotations().sampledTracks_.size() == 10);
+
+    const AnimationCompressionError error = compressed->MeasureError(*animation);
+    REQUIRE(error.maxPositionError_ < 0.005f);
+    REQUIRE(error.maxRotationError_ < 0.5f);
+    REQUIRE(error.maxScaleError_ < 0.005f);
+
+    // Compressed tracks survive serialization
+    VectorBuffer buffer;
+    REQUIRE(animation->Save(buffer));
+    buffer.Seek(0);
+
+    auto loadedAnimation = MakeShared<Animation>(context);
+    REQUIRE(loadedAnimation->Load(buffer));
+    const CompressedAnimation* loadedCompressed = loadedAnimation->GetCompressed();
+    REQUIRE(loadedCompressed);
+
+    AnimationPose expectedPose;
+    AnimationPose loadedPose;
+    for (const float time : { 0.0f, 0.37f, 1.0f, 1.99f, 2.0f })
+    {
+        compressed->Sample(time, expectedPose);
+        loadedCompressed->Sample(time, loadedPose);
+        REQUIRE(expectedPose.positions_ == loadedPose.positions_);
+        REQUIRE(expectedPose.rotations_ == loadedPose.rotations_);
+        REQUIRE(expectedPose.scales_ == loadedPose.scales_);
+    }
+
+    // Animation without compressed tracks is still readable
+    animation->RemoveCompressedData();
+    buffer.Clear();
+    REQUIRE(animation->Save(buffer));
+    buffer.Seek(0);
+    REQUIRE(loadedAnimation->Load(buffer));
+    REQUIRE(loadedAnimation->GetCompressed() == nullptr);
+
+    // Unknown data after keyframes is ignored
+    buffer.Seek(buffer.GetSize());
+    buffer.WriteFileID("UXXX");
+    buffer.WriteUInt(0xdeadbeef);
+    buffer.Seek(0);
+    REQUIRE(loadedAnimation->Load(buffer));
+    REQUIRE(loadedAnimation->GetCompressed() == nullptr);
+    REQUIRE(loadedAnimation->GetNumTracks() == 30);
+}
+
+TEST_CASE("Compressed looped animation is interpolated between last and first keyframes")
+{
+    auto context = Tests::CreateCompleteTestContext();
+    auto scene = MakeShared<Scene>(context);
+
+    // Leave a gap between the last keyframe and the end of the clip
+    static const unsigned numTracks = 6;
+    auto animation = CreateTestAnimation(context, numTracks, 2.0f, 30.0f);
+    animation->SetLength(2.5f);
+    auto compressedAnimation = CreateTestAnimation(context, numTracks, 2.0f, 30.0f);
+    compressedAnimation->SetLength(2.5f);
+    compressedAnimation->Compress(AnimationCompressionSettings{});
+    REQUIRE(compressedAnimation->GetCompressed());
+
+    const auto createNodes = [&]()
+    {
+        Node* rootNode = scene->CreateChild("Root");
+        for (unsigned i = 0; i < numTracks; ++i)
+            rootNode->CreateChild(Format("Bone{}", i));
+        return rootNode;
+    };
+
+    Node* rootNode = createNodes();
+    Node* compressedRootNode = createNodes();
+    auto state = MakeShared<AnimationState>(rootNode, animation);
+    auto compressedState = MakeShared<AnimationState>(compressedRootNode, compressedAnimation);
+
+    for (const bool looped : { false, true })
+    {
+        state->SetLooped(looped);
+        compressedState->SetLooped(looped);
+        for (const float time : { 1.5f, 2.1f, 2.25f, 2.45f })
+        {
+            state->SetTime(time);
+            compressedState->SetTime(time);
+            state->Apply();
+            compressedState->Apply();
+
+            for (unsigned i = 0; i < numTracks; ++i)
+            {
+                Node* node = rootNode->GetChild(i);
+                Node* compressedNode = compressedRootNode->GetChild(i);
+                REQUIRE(node->GetPosition().Equals(compressedNode->GetPosition(), 0.005f));
+                REQUIRE(Abs(node->GetRotation().DotProduct(compressedNode->GetRotation())) > 0.9999f);
+                REQUIRE(node->GetScale().Equals(compressedNode->GetScale(), 0.005f));
+            }
+        }
+    }
+}
+
+TEST_CASE("Compressed animation sampling benchmark", "[.benchmark]")
+{
+    static const unsigned numTracks = 60;
+    static const unsigned numSamples = 100000;
+
+    auto context = Tests::CreateCompleteTestContext();
+    auto animation = CreateTestAnimation(context, numTracks, 10.0f, 30.0f);
+
+    ea::vector<const AnimationTrack*> tracks;
+    for (const auto& item : animation->GetTracks())
+        tracks.push_back(&item.second);
+    ea::vector<unsigned> frameHints(numTracks);
+
+    animation->Compress(AnimationCompressionSettings{});
+    const CompressedAnimation* compressed = animation->GetCompressed();
+
+    AnimationPose pose;
+    pose.Reset(numTracks);
+
+    RandomEngine engine(0);
+    ea::vector<float> times(numSamples);
+    for (float& time : times)
+        time = engine.GetFloat(0.0f, animation->GetLength());
+
+    HiresTimer timer;
+    for (const float time : times)
+        SampleKeyFrames(tracks, frameHints, time, pose);
+    const long long keyFrameTime = timer.GetUSec(true);
+
+    for (const float time : times)
+        compressed->Sample(time, pose);
+    const long long compressedTime = timer.GetUSec(true);
+
+    unsigned keyFrameMemory = 0;
+    for (const AnimationTrack* track : tracks)
+        keyFrameMemory += track->keyFrames_.size() * sizeof(AnimationKeyFrame);
+
+    const AnimationCompressionError error = compressed->MeasureError(*animation);
+    WARN(Format("{} tracks, {} poses sampled\n"
+        "Keyframes:  {:>8} us, {:>8} bytes\n"
+        "Compressed: {:>8} us, {:>8} bytes\n"
+        "Max error: position {:.5f}, rotation {:.3f} deg, scale {:.5f}",
+        numTracks, numSamples, keyFrameTime, keyFrameMemory, compressedTime, compressed->GetMemoryUse(),
+        error.maxPositionError_, error.maxRotationError_, error.maxScaleError_).c_str());
+}
@@ -0,0 +1,77 @@
+//
+// Copyright (c) 2017-2021 the rbfx project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include "../CommonUtils.h"
+
+#include <Urho3D/Engine/Engine.h>
+#include <Urho3D/Engine/EngineDefs.h>
+#include <Urho3D/Graphics/DrawCommandQueue.h>
+#include <Urho3D/Graphics/Graphics.h>
+#include <Urho3D/Graphics/PipelineState.h>
+
+TEST_CASE("Null graphics device counts draw calls and primitives")
+{
+    auto context = MakeShared<Context>();
+    auto engine = new Engine(context);
+    VariantMap parameters;
+    parameters[EP_HEADLESS] = true;
+    parameters[EP_NULL_GRAPHICS] = true;
+    parameters[EP_LOG_QUIET] = true;
+    REQUIRE(engine->Initialize(parameters));
+
+    auto graphics = context->GetSubsystem<Graphics>();
+    REQUIRE(graphics->IsNullDevice());
+
+    // Nothing is rendered, but frame statistics are reset
+    REQUIRE_FALSE(graphics->BeginFrame());
+    REQUIRE(graphics->GetNumBatches() == 0);
+    REQUIRE(graphics->GetNumPrimitives() == 0);
+
+    graphics->Draw(TRIANGLE_LIST, 0, 30);
+    graphics->Draw(TRIANGLE_STRIP, 0, 6, 0, 4);
+    graphics->Draw(LINE_LIST, 0, 8, 2, 0, 4);
+    graphics->DrawInstanced(TRIANGLE_LIST, 0, 36, 0, 24, 10);
+    graphics->Draw(TRIANGLE_LIST, 0, 0);
+    REQUIRE(graphics->GetNumBatches() == 4);
+    REQUIRE(graphics->GetNumPrimitives() == 10 + 4 + 4 + 120);
+
+    // Draw command queue doesn't touch GPU state on null device
+    PipelineStateDesc desc;
+    desc.primitiveType_ = TRIANGLE_LIST;
+    desc.RecalculateHash();
+    auto pipelineState = MakeShared<PipelineState>(nullptr);
+    pipelineState->Setup(desc);
+
+    auto drawQueue = MakeShared<DrawCommandQueue>(graphics);
+    drawQueue->Reset(false);
+    drawQueue->SetPipelineState(pipelineState);
+    drawQueue->Draw(0, 6);
+    drawQueue->Draw(6, 3);
+    drawQueue->Execute();
+
+    REQUIRE_FALSE(graphics->BeginFrame());
+    REQUIRE(graphics->GetNumBatches() == 0);
+    drawQueue->Execute();
+    REQUIRE(graphics->GetNumBatches() == 2);
+    REQUIRE(graphics->GetNumPrimitives() == 3);
+}
@@ -0,0 +1,205 @@
+//
+// Copyright (c) 2017-2021 the rbfx project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include "../CommonUtils.h"
+
+#include <Urho3D/Container/PoolAllocator.h>
+#include <Urho3D/Graphics/Model.h>
+#include <Urho3D/Graphics/Octree.h>
+#include <Urho3D/Graphics/OctreeQuery.h>
+#include <Urho3D/Graphics/StaticModel.h>
+#include <Urho3D/Math/RandomEngine.h>
+#include <Urho3D/Scene/Scene.h>
+
+#include <EASTL/hash_set.h>
+#include <EASTL/sort.h>
+
+namespace
+{
+
+void UpdateOctree(Octree* octree, unsigned frameNumber)
+{
+    FrameInfo frameInfo;
+    frameInfo.frameNumber_ = frameNumber;
+    frameInfo.timeStep_ = 1.0f / 60.0f;
+    octree->Update(frameInfo);
+}
+
+Vector3 GetRandomPosition(RandomEngine& engine, float range)
+{
+    return { engine.GetFloat(-range, range), engine.GetFloat(-range, range), engine.GetFloat(-range, range) };
+}
+
+/// Return drawables intersecting the box, sorted.
+ea::vector<Drawable*> QueryDrawables(Octree* octree, const BoundingBox& box)
+{
+    ea::vector<Drawable*> result;
+    BoxOctreeQuery query(result, box);
+    octree->GetDrawables(query);
+    ea::sort(result.begin(), result.end());
+    return result;
+}
+
+/// Return drawables intersecting the box by testing every drawable, sorted.
+ea::vector<Drawable*> QueryDrawablesBruteForce(const ea::vector<StaticModel*>& drawables, const BoundingBox& box)
+{
+    ea::vector<Drawable*> result;
+    for (StaticModel* drawable : drawables)
+    {
+        if (box.IsInsideFast(drawable->GetWorldBoundingBox()) != OUTSIDE)
+            result.push_back(drawable);
+    }
+    ea::sort(result.begin(), result.end());
+    return result;
+}
+
+/// Return number of octants that contain drawables directly or in children.
+unsigned CountOctants(const ea::vector<StaticModel*>& drawables)
+{
+    ea::hash_set<Octant*> octants;
+    for (StaticModel* drawable : drawables)
+    {
+        for (Octant* octant = drawable->GetOctant(); octant; octant = octant->GetParent())
+        {
+            if (!octants.insert(octant).second)
+                break;
+        }
+    }
+    return octants.size();
+}
+
+}
+
+TEST_CASE("Octree queries match brute force after drawables move across octants")
+{
+    static const float range = 100.0f;
+
+    auto context = Tests::CreateCompleteTestContext();
+    auto model = MakeShared<Model>(context);
+    model->SetBoundingBox(BoundingBox(-Vector3::ONE, Vector3::ONE));
+
+    auto scene = MakeShared<Scene>(context);
+    auto octree = scene->CreateComponent<Octree>();
+    octree->SetSize(BoundingBox(-range, range), 6);
+
+    RandomEngine engine(0);
+    ea::vector<StaticModel*> drawables;
+    const auto createDrawable = [&]()
+    {
+        Node* node = scene->CreateChild();
+        node->SetPosition(GetRandomPosition(engine, range * 1.1f));
+        node->SetScale(engine.GetFloat(0.1f, 10.0f));
+        auto staticModel = node->CreateComponent<StaticModel>();
+        staticModel->SetModel(model);
+        drawables.push_back(staticModel);
+    };
+
+    for (unsigned i = 0; i < 1000; ++i)
+        createDrawable();
+
+    for (unsigned frameNumber = 1; frameNumber <= 20; ++frameNumber)
+    {
+        // Some drawables move, some are removed and created again
+        for (unsigned i = 0; i < 300; ++i)
+        {
+            const unsigned index = engine.GetUInt(0, drawables.size());
+            Node* node = drawables[index]->GetNode();
+            if (i % 4 == 0)
+            {
+                node->Remove();
+                drawables.erase_unsorted(drawables.begin() + index);
+                createDrawable();
+            }
+            else if (i % 2 == 0)
+                node->Translate(GetRandomPosition(engine, range * 0.05f));
+            else
+                node->SetPosition(GetRandomPosition(engine, range * 1.1f));
+        }
+
+        UpdateOctree(octree, frameNumber);
+
+        for (unsigned i = 0; i < 10; ++i)
+        {
+            const Vector3 center = GetRandomPosition(engine, range);
+            const BoundingBox box(center - Vector3::ONE * engine.GetFloat(1.0f, 50.0f), center + Vector3::ONE * engine.GetFloat(1.0f, 50.0f));
+            REQUIRE(QueryDrawables(octree, box) == QueryDrawablesBruteForce(drawables, box));
+        }
+        REQUIRE(QueryDrawables(octree, BoundingBox(-range * 2.0f, range * 2.0f)).size() == drawables.size());
+    }
+}
+
+TEST_CASE("Octree reuses memory of freed octants")
+{
+    static const float range = 100.0f;
+
+    auto context = Tests::CreateCompleteTestContext();
+    auto model = MakeShared<Model>(context);
+    model->SetBoundingBox(BoundingBox(-Vector3::ONE, Vector3::ONE));
+
+    auto scene = MakeShared<Scene>(context);
+    auto octree = scene->CreateComponent<Octree>();
+    octree->SetSize(BoundingBox(-range, range), 8);
+
+    RandomEngine engine(0);
+    ea::vector<StaticModel*> drawables;
+    ea::vector<Vector3> scatteredPositions;
+    for (unsigned i = 0; i < 500; ++i)
+    {
+        auto staticModel = scene->CreateChild()->CreateComponent<StaticModel>();
+        staticModel->SetModel(model);
+        drawables.push_back(staticModel);
+        scatteredPositions.push_back(GetRandomPosition(engine, range * 0.9f));
+    }
+
+    // Scattered small drawables occupy many deep octants, gathered ones occupy few
+    unsigned frameNumber = 0;
+    const auto scatter = [&]()
+    {
+        for (unsigned i = 0; i < drawables.size(); ++i)
+            drawables[i]->GetNode()->SetPosition(scatteredPositions[i]);
+        UpdateOctree(octree, ++frameNumber);
+    };
+    const auto gather = [&]()
+    {
+        for (StaticModel* drawable : drawables)
+            drawable->GetNode()->SetPosition(Vector3::ONE * 0.5f);
+        UpdateOctree(octree, ++frameNumber);
+    };
+
+    scatter();
+    const unsigned numScatteredOctants = CountOctants(drawables);
+    gather();
+    const unsigned numGatheredOctants = CountOctants(drawables);
+    REQUIRE(numGatheredOctants * 10 < numScatteredOctants);
+
+    // Octants are freed and created again without allocating new memory
+    const unsigned numSpans = PoolAllocator::GetStats().numSpans_;
+    for (unsigned i = 0; i < 10; ++i)
+    {
+        scatter();
+        REQUIRE(CountOctants(drawables) == numScatteredOctants);
+        gather();
+        REQUIRE(CountOctants(drawables) == numGatheredOctants);
+    }
+    REQUIRE(PoolAllocator::GetStats().numSpans_ == numSpans);
+}
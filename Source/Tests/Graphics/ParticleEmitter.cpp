@@ -0,0 +1,163 @@
+//
+// Copyright (c) 2017-2021 the rbfx project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "../CommonUtils.h"
+
+#include <Urho3D/Core/StringUtils.h>
+#include <Urho3D/Core/Timer.h>
+#include <Urho3D/Graphics/Octree.h>
+#include <Urho3D/Graphics/ParticleEffect.h>
+#include <Urho3D/Graphics/ParticleEmitter.h>
+#include <Urho3D/Scene/Scene.h>
+
+namespace
+{
+
+/// Create effect that emits particles at the origin and pulls them down with constant force.
+SharedPtr<ParticleEffect> CreateFallingEffect(Context* context, unsigned numParticles, float emissionRate)
+{
+    auto effect = MakeShared<ParticleEffect>(context);
+    effect->SetNumParticles(numParticles);
+    effect->SetUpdateInvisible(true);
+    effect->SetEmitterType(EMITTER_BOX);
+    effect->SetEmitterSize(Vector3::ZERO);
+    effect->SetMinEmissionRate(emissionRate);
+    effect->SetMaxEmissionRate(emissionRate);
+    effect->SetMinTimeToLive(1.0f);
+    effect->SetMaxTimeToLive(1.0f);
+    effect->SetMinVelocity(0.0f);
+    effect->SetMaxVelocity(0.0f);
+    effect->SetMinParticleSize(Vector2::ONE);
+    effect->SetMaxParticleSize(Vector2::ONE);
+    effect->SetConstantForce(Vector3(0.0f, -10.0f, 0.0f));
+    effect->SetDampingForce(0.0f);
+    effect->SetSizeAdd(0.5f);
+    effect->SetColorFrames({ ColorFrame(Color::WHITE, 0.0f), ColorFrame(Color::BLACK, 1.0f) });
+    return effect;
+}
+
+void UpdateScene(Scene* scene, Octree* octree, float timeStep, unsigned frameNumber)
+{
+    scene->Update(timeStep);
+
+    FrameInfo frameInfo;
+    frameInfo.frameNumber_ = frameNumber;
+    frameInfo.timeStep_ = timeStep;
+    octree->Update(frameInfo);
+}
+
+}
+
+TEST_CASE("Particle emitter simulates particles and bounds them")
+{
+    static const float timeStep = 1.0f / 32.0f;
+
+    auto context = Tests::CreateCompleteTestContext();
+    auto scene = MakeShared<Scene>(context);
+    auto octree = scene->CreateComponent<Octree>();
+
+    Node* node = scene->CreateChild();
+    node->SetPosition({ 1.0f, 2.0f, 3.0f });
+    auto emitter = node->CreateComponent<ParticleEmitter>();
+    emitter->SetEffect(CreateFallingEffect(context, 33, 16.0f));
+
+    for (unsigned frameIndex = 0; frameIndex < 24; ++frameIndex)
+        UpdateScene(scene, octree, timeStep, frameIndex + 1);
+
+    const ParticleBuffer& particles = emitter->GetParticleBuffer();
+    REQUIRE(emitter->GetNumParticles() == 33);
+    REQUIRE(particles.numActive_ > 4);
+    REQUIRE(particles.numActive_ <= 12);
+
+    const BoundingBox& worldBox = emitter->GetWorldBoundingBox();
+    for (unsigned i = 0; i < particles.numActive_; ++i)
+    {
+        const float timer = particles.timers_[i];
+        REQUIRE(timer < particles.timeToLive_[i]);
+        REQUIRE(particles.GetVelocity(i).Equals(Vector3(0.0f, -10.0f * timer, 0.0f), 1e-4f));
+        REQUIRE(particles.GetDirection(i).Equals(Vector3::DOWN));
+        REQUIRE(particles.scales_[i] == Catch::Approx(1.0f + 0.5f * timer).margin(1e-4f));
+        REQUIRE(particles.colors_[i].Equals(Color::WHITE.Lerp(Color::BLACK, timer)));
+        REQUIRE(worldBox.IsInside(node->GetWorldTransform() * particles.GetPosition(i)) == INSIDE);
+    }
+
+    // Particles survive serialization in the same order
+    auto loadedEmitter = scene->CreateChild()->CreateComponent<ParticleEmitter>();
+    loadedEmitter->SetEffect(emitter->GetEffect());
+    loadedEmitter->SetParticlesAttr(emitter->GetParticlesAttr());
+    loadedEmitter->SetParticleBillboardsAttr(emitter->GetParticleBillboardsAttr());
+
+    const ParticleBuffer& loadedParticles = loadedEmitter->GetParticleBuffer();
+    REQUIRE(loadedParticles.numActive_ == particles.numActive_);
+    for (unsigned i = 0; i < particles.numActive_; ++i)
+    {
+        REQUIRE(loadedParticles.GetPosition(i).Equals(particles.GetPosition(i)));
+        REQUIRE(loadedParticles.timers_[i] == particles.timers_[i]);
+    }
+
+    // All particles expire once emission stops
+    emitter->SetEmitting(false);
+    loadedEmitter->SetEmitting(false);
+    for (unsigned frameIndex = 0; frameIndex < 40; ++frameIndex)
+        UpdateScene(scene, octree, timeStep, frameIndex + 25);
+
+    REQUIRE(particles.numActive_ == 0);
+    REQUIRE(loadedParticles.numActive_ == 0);
+}
+
+TEST_CASE("Particle emitter benchmark", "[.benchmark]")
+{
+    static const unsigned numEmitters = 100;
+    static const unsigned numParticles = 5000;
+    static const unsigned numWarmupFrames = 60;
+    static const unsigned numFrames = 100;
+    static const float timeStep = 1.0f / 60.0f;
+
+    auto context = Tests::CreateCompleteTestContext();
+    auto scene = MakeShared<Scene>(context);
+    auto octree = scene->CreateComponent<Octree>();
+
+    // Emit until the particle limit is reached and keep it saturated
+    const auto effect = CreateFallingEffect(context, numParticles, numParticles * 60.0f);
+    effect->SetMinVelocity(1.0f);
+    effect->SetMaxVelocity(2.0f);
+    effect->SetMinTimeToLive(10.0f);
+    effect->SetMaxTimeToLive(10.0f);
+    for (unsigned i = 0; i < numEmitters; ++i)
+    {
+        Node* node = scene->CreateChild();
+        node->SetPosition({ 10.0f * (i % 10), 0.0f, 10.0f * (i / 10) });
+        node->CreateComponent<ParticleEmitter>()->SetEffect(effect);
+    }
+
+    long long elapsed = 0;
+    HiresTimer timer;
+    for (unsigned frameIndex = 0; frameIndex < numWarmupFrames + numFrames; ++frameIndex)
+    {
+        timer.Reset();
+        UpdateScene(scene, octree, timeStep, frameIndex + 1);
+        if (frameIndex >= numWarmupFrames)
+            elapsed += timer.GetUSec(false);
+    }
+
+    WARN(Format("{} emitters x {} particles: {} us/frame", numEmitters, numParticles, elapsed / numFrames).c_str());
+}
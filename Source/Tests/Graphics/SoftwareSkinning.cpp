@@ -0,0 +1,274 @@
+//
+// Copyright (c) 2017-2021 the rbfx project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "../CommonUtils.h"
+
+#include <Urho3D/Core/StringUtils.h>
+#include <Urho3D/Core/Timer.h>
+#include <Urho3D/Graphics/Model.h>
+#include <Urho3D/Graphics/SoftwareModelAnimator.h>
+#include <Urho3D/Graphics/VertexBuffer.h>
+#include <Urho3D/IO/MemoryBuffer.h>
+#include <Urho3D/IO/VectorBuffer.h>
+#include <Urho3D/Math/RandomEngine.h>
+
+namespace
+{
+
+/// Skinned vertex as stored in test vertex buffer.
+struct SkinnedVertex
+{
+    Vector3 position_;
+    Vector3 normal_;
+    Vector4 tangent_;
+    Vector4 blendWeights_;
+    unsigned char blendIndices_[4];
+};
+
+/// Create model with random skinned vertices and morphs affecting overlapping vertex ranges.
+/// Vertices are affected by 1 to 4 bones.
+SharedPtr<Model> CreateSkinnedModel(Context* context, RandomEngine& engine,
+    unsigned numVertices, unsigned numBones, unsigned numMorphs)
+{
+    ea::vector<SkinnedVertex> vertices(numVertices);
+    for (unsigned vertexIndex = 0; vertexIndex < numVertices; ++vertexIndex)
+    {
+        SkinnedVertex& vertex = vertices[vertexIndex];
+        vertex.position_ = engine.GetVector3(-Vector3::ONE, Vector3::ONE);
+        vertex.normal_ = engine.GetDirectionVector3();
+        vertex.tangent_ = Vector4(engine.GetDirectionVector3(), vertexIndex % 2 ? 1.0f : -1.0f);
+
+        const unsigned numInfluences = 1 + vertexIndex % 4;
+        float weights[4];
+        float totalWeight = 0.0f;
+        for (unsigned i = 0; i < 4; ++i)
+        {
+            weights[i] = i < numInfluences ? engine.GetFloat(0.1f, 1.0f) : 0.0f;
+            vertex.blendIndices_[i] = static_cast<unsigned char>(engine.GetUInt(0, numBones - 1));
+            totalWeight += weights[i];
+        }
+        vertex.blendWeights_ = Vector4(weights) / totalWeight;
+    }
+
+    const ea::vector<VertexElement> elements = {
+        VertexElement{ TYPE_VECTOR3, SEM_POSITION },
+        VertexElement{ TYPE_VECTOR3, SEM_NORMAL },
+        VertexElement{ TYPE_VECTOR4, SEM_TANGENT },
+        VertexElement{ TYPE_VECTOR4, SEM_BLENDWEIGHTS },
+        VertexElement{ TYPE_UBYTE4, SEM_BLENDINDICES },
+    };
+
+    auto vertexBuffer = MakeShared<VertexBuffer>(context);
+    vertexBuffer->SetShadowed(true);
+    vertexBuffer->SetSize(numVertices, elements);
+    REQUIRE(vertexBuffer->GetVertexSize() == sizeof(SkinnedVertex));
+    vertexBuffer->SetData(vertices.data());
+
+    auto model = MakeShared<Model>(context);
+    model->SetVertexBuffers({ vertexBuffer }, { 0 }, { numVertices });
+
+    ea::vector<ModelMorph> morphs(numMorphs);
+    for (unsigned morphIndex = 0; morphIndex < numMorphs; ++morphIndex)
+    {
+        const unsigned firstVertex = morphIndex * numVertices / (numMorphs + 1);
+        const unsigned numMorphVertices = 2 * numVertices / (numMorphs + 1);
+
+        VectorBuffer morphData;
+        for (unsigned i = 0; i < numMorphVertices; ++i)
+        {
+            morphData.WriteUInt(firstVertex + i);
+            morphData.WriteVector3(engine.GetVector3(-Vector3::ONE, Vector3::ONE));
+            morphData.WriteVector3(engine.GetVector3(-Vector3::ONE, Vector3::ONE) * 0.1f);
+        }
+
+        VertexBufferMorph bufferMorph;
+        bufferMorph.elementMask_ = MASK_POSITION | MASK_NORMAL;
+        bufferMorph.vertexCount_ = numMorphVertices;
+        bufferMorph.dataSize_ = morphData.GetSize();
+        bufferMorph.morphData_ = ea::shared_array<unsigned char>(new unsigned char[morphData.GetSize()]);
+        memcpy(bufferMorph.morphData_.get(), morphData.GetData(), morphData.GetSize());
+
+        morphs[morphIndex].name_ = Format("Morph{}", morphIndex);
+        morphs[morphIndex].nameHash_ = morphs[morphIndex].name_;
+        morphs[morphIndex].buffers_[0] = bufferMorph;
+    }
+    model->SetMorphs(morphs);
+    return model;
+}
+
+/// Morph and skin vertex in the most straightforward way.
+SkinnedVertex AnimateVertexReference(const Model* model, unsigned vertexIndex, const ea::vector<Matrix3x4>& transforms)
+{
+    const VertexBuffer* vertexBuffer = model->GetVertexBuffers()[0];
+    SkinnedVertex vertex = reinterpret_cast<const SkinnedVertex*>(vertexBuffer->GetShadowData())[vertexIndex];
+
+    for (const ModelMorph& morph : model->GetMorphs())
+    {
+        const VertexBufferMorph& bufferMorph = morph.buffers_.find(0)->second;
+        MemoryBuffer morphData(bufferMorph.morphData_.get(), bufferMorph.dataSize_);
+        for (unsigned i = 0; i < bufferMorph.vertexCount_; ++i)
+        {
+            const unsigned index = morphData.ReadUInt();
+            const Vector3 positionDelta = morphData.ReadVector3();
+            const Vector3 normalDelta = morphData.ReadVector3();
+            if (index == vertexIndex)
+            {
+                vertex.position_ += positionDelta * morph.weight_;
+                vertex.normal_ += normalDelta * morph.weight_;
+            }
+        }
+    }
+
+    Matrix3x4 matrix = Matrix3x4::ZERO;
+    for (unsigned i = 0; i < 4; ++i)
+        matrix = matrix + transforms[vertex.blendIndices_[i]] * vertex.blendWeights_.Data()[i];
+
+    vertex.position_ = matrix * vertex.position_;
+    vertex.normal_ = matrix.ToMatrix3() * vertex.normal_;
+    vertex.tangent_ = Vector4(matrix.ToMatrix3() * Vector3(vertex.tangent_), vertex.tangent_.w_);
+    return vertex;
+}
+
+ea::vector<Matrix3x4> CreateRandomTransforms(RandomEngine& engine, unsigned numBones)
+{
+    ea::vector<Matrix3x4> transforms(numBones);
+    for (Matrix3x4& transform : transforms)
+    {
+        transform = Matrix3x4(engine.GetVector3(-Vector3::ONE, Vector3::ONE),
+            engine.GetQuaternion(), engine.GetFloat(0.5f, 1.5f));
+    }
+    return transforms;
+}
+
+/// Compare animated vertices with reference implementation.
+void CheckAnimatedVertices(const Model* model, const SoftwareModelAnimator* animator, const ea::vector<Matrix3x4>& transforms)
+{
+    const VertexBuffer* animatedBuffer = animator->GetVertexBuffers()[0];
+    REQUIRE(animatedBuffer);
+
+    const unsigned numVertices = model->GetVertexBuffers()[0]->GetVertexCount();
+    REQUIRE(animatedBuffer->GetVertexCount() == numVertices);
+
+    const unsigned vertexSize = animatedBuffer->GetVertexSize();
+    const unsigned normalOffset = animatedBuffer->GetElementOffset(SEM_NORMAL);
+    const unsigned tangentOffset = animatedBuffer->GetElementOffset(SEM_TANGENT);
+    const unsigned char* animatedData = animatedBuffer->GetShadowData();
+    for (unsigned vertexIndex = 0; vertexIndex < numVertices; ++vertexIndex)
+    {
+        const SkinnedVertex expected = AnimateVertexReference(model, vertexIndex, transforms);
+        const unsigned char* vertexData = animatedData + vertexIndex * vertexSize;
+        const auto& position = *reinterpret_cast<const Vector3*>(vertexData);
+        const auto& normal = *reinterpret_cast<const Vector3*>(vertexData + normalOffset);
+        const auto& tangent = *reinterpret_cast<const Vector4*>(vertexData + tangentOffset);
+        REQUIRE(position.Equals(expected.position_, 1e-4f));
+        REQUIRE(normal.Equals(expected.normal_, 1e-4f));
+        REQUIRE(tangent.Equals(expected.tangent_, 1e-4f));
+    }
+}
+
+}
+
+TEST_CASE("Software skinning and morphing match reference implementation")
+{
+    static const unsigned numVertices = 1001;
+    static const unsigned numBones = 16;
+    static const unsigned numMorphs = 3;
+
+    auto context = Tests::CreateCompleteTestContext();
+    RandomEngine engine(0);
+    auto model = CreateSkinnedModel(context, engine, numVertices, numBones, numMorphs);
+
+    ea::vector<ModelMorph> morphs = model->GetMorphs();
+    morphs[0].weight_ = 0.5f;
+    morphs[1].weight_ = 0.0f;
+    morphs[2].weight_ = 1.0f;
+    model->SetMorphs(morphs);
+
+    const ea::vector<Matrix3x4> transforms = CreateRandomTransforms(engine, numBones);
+
+    auto animator = MakeShared<SoftwareModelAnimator>(context);
+    animator->Initialize(model, true, SoftwareModelAnimator::MaxBones);
+    animator->ResetAnimation();
+    animator->ApplyMorphs(morphs);
+    animator->ApplySkinning(transforms);
+
+    CheckAnimatedVertices(model, animator, transforms);
+}
+
+TEST_CASE("Software skinning of large model in worker threads matches reference implementation")
+{
+    // More vertex blocks than processed by one thread
+    static const unsigned numVertices = SoftwareModelAnimator::VertexBlockSize * SoftwareModelAnimator::ThreadedSkinningBlocks * 2 + 3;
+    static const unsigned numBones = 32;
+
+    auto context = Tests::CreateCompleteTestContext();
+    Tests::RecreateWorkQueue(context, 3);
+    RandomEngine engine(1);
+    auto model = CreateSkinnedModel(context, engine, numVertices, numBones, 0);
+
+    const ea::vector<Matrix3x4> transforms = CreateRandomTransforms(engine, numBones);
+
+    auto animator = MakeShared<SoftwareModelAnimator>(context);
+    animator->Initialize(model, true, SoftwareModelAnimator::MaxBones);
+    animator->ResetAnimation();
+    animator->ApplySkinning(transforms);
+
+    CheckAnimatedVertices(model, animator, transforms);
+}
+
+TEST_CASE("Software skinning benchmark", "[.benchmark]")
+{
+    static const unsigned numVertices = 100000;
+    static const unsigned numBones = 64;
+    static const unsigned numMorphs = 8;
+    static const unsigned numFrames = 100;
+
+    auto context = Tests::CreateCompleteTestContext();
+    RandomEngine engine(0);
+    auto model = CreateSkinnedModel(context, engine, numVertices, numBones, numMorphs);
+
+    ea::vector<ModelMorph> morphs = model->GetMorphs();
+    for (ModelMorph& morph : morphs)
+        morph.weight_ = 0.5f;
+
+    const ea::vector<Matrix3x4> transforms = CreateRandomTransforms(engine, numBones);
+
+    auto animator = MakeShared<SoftwareModelAnimator>(context);
+    animator->Initialize(model, true, SoftwareModelAnimator::MaxBones);
+
+    long long morphTime = 0;
+    long long skinningTime = 0;
+    HiresTimer timer;
+    for (unsigned frameIndex = 0; frameIndex < numFrames; ++frameIndex)
+    {
+        animator->ResetAnimation();
+
+        timer.Reset();
+        animator->ApplyMorphs(morphs);
+        morphTime += timer.GetUSec(true);
+        animator->ApplySkinning(transforms);
+        skinningTime += timer.GetUSec(true);
+    }
+
+    WARN(Format("{} vertices, {} morphs: morphing {} us/frame, skinning {} us/frame",
+        numVertices, numMorphs, morphTime / numFrames, skinningTime / numFrames).c_str());
+}
@@ -0,0 +1,185 @@
+//
+// Copyright (c) 2017-2021 the rbfx project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "../CommonUtils.h"
+
+#include <Urho3D/Core/StringUtils.h>
+#include <Urho3D/Core/Timer.h>
+#include <Urho3D/IO/File.h>
+#include <Urho3D/IO/FileSystem.h>
+#include <Urho3D/IO/MemoryBuffer.h>
+#include <Urho3D/IO/PackageFile.h>
+#include <Urho3D/IO/VectorBuffer.h>
+#include <Urho3D/Resource/XMLFile.h>
+#include <Urho3D/Scene/Scene.h>
+
+#include <cstdio>
+
+namespace
+{
+
+/// Write uncompressed package file with specified entries.
+void WritePackage(Context* context, const ea::string& fileName, const ea::vector<ea::pair<ea::string, ByteVector>>& entries)
+{
+    unsigned offset = 3 * sizeof(unsigned);
+    for (const auto& [name, data] : entries)
+        offset += name.length() + 1 + 3 * sizeof(unsigned);
+
+    File file(context, fileName, FILE_WRITE);
+    file.WriteFileID("UPAK");
+    file.WriteUInt(entries.size());
+    file.WriteUInt(0);
+    for (const auto& [name, data] : entries)
+    {
+        file.WriteString(name);
+        file.WriteUInt(offset);
+        file.WriteUInt(data.size());
+        file.WriteUInt(0);
+        offset += data.size();
+    }
+
+    for (const auto& [name, data] : entries)
+        file.Write(data.data(), data.size());
+}
+
+ByteVector ToByteVector(const ea::string& text)
+{
+    return ByteVector(text.begin(), text.end());
+}
+
+/// Return resident set size of the process in kilobytes, or 0 if unknown.
+unsigned GetResidentSize()
+{
+#ifdef __linux__
+    unsigned size = 0;
+    unsigned resident = 0;
+    if (FILE* statm = fopen("/proc/self/statm", "r"))
+    {
+        if (fscanf(statm, "%u %u", &size, &resident) != 2)
+            resident = 0;
+        fclose(statm);
+    }
+    return resident * 4;
+#else
+    return 0;
+#endif
+}
+
+}
+
+TEST_CASE("Memory-mapped package file is read without copying")
+{
+    auto context = Tests::CreateCompleteTestContext();
+    auto fileSystem = context->GetSubsystem<FileSystem>();
+    const ea::string fileName = fileSystem->GetTemporaryDir() + "MappedPackageTest.pak";
+
+    const ea::string text = "Hello, world!";
+    const ea::string xml = "<root attribute=\"value\" />";
+    WritePackage(context, fileName, { { "Data/Text.txt", ToByteVector(text) }, { "Data/File.xml", ToByteVector(xml) } });
+
+    {
+        auto package = MakeShared<PackageFile>(context, fileName);
+        REQUIRE(package->GetNumFiles() == 2);
+#if !defined(UWP) && !defined(__EMSCRIPTEN__)
+        REQUIRE(package->MapToMemory());
+        REQUIRE(package->IsMemoryMapped());
+#endif
+
+        auto textFile = MakeShared<File>(context, package, "Data/Text.txt");
+        REQUIRE(textFile->IsOpen());
+        REQUIRE(textFile->IsPackaged());
+        REQUIRE(textFile->ReadText() == text);
+
+        textFile->Seek(7);
+        char buffer[5]{};
+        REQUIRE(textFile->Read(buffer, sizeof(buffer)) == 5);
+        REQUIRE(ea::string(buffer, 5) == "world");
+
+        if (package->IsMemoryMapped())
+        {
+            MemoryBuffer memoryBuffer(textFile->GetMappedData(), textFile->GetSize());
+            REQUIRE(memoryBuffer.GetData() == textFile->GetMappedData());
+            REQUIRE(memoryBuffer.ReadFileID() == "Hell");
+        }
+
+        auto xmlFile = MakeShared<XMLFile>(context);
+        File xmlSource(context, package, "Data/File.xml");
+        REQUIRE(xmlFile->Load(xmlSource));
+        REQUIRE(xmlFile->GetRoot().GetAttribute("attribute") == "value");
+    }
+
+    fileSystem->Delete(fileName);
+}
+
+TEST_CASE("Package file scene loading benchmark", "[.benchmark]")
+{
+    auto context = Tests::CreateCompleteTestContext();
+    auto fileSystem = context->GetSubsystem<FileSystem>();
+    const ea::string fileName = fileSystem->GetTemporaryDir() + "SceneLoadingBenchmark.pak";
+
+    const unsigned numScenes = 20;
+    const unsigned numNodes = 2000;
+
+    // Create synthetic scenes
+    auto scene = MakeShared<Scene>(context);
+    for (unsigned i = 0; i < numNodes; ++i)
+    {
+        Node* node = scene->CreateChild(Format("Node {}", i));
+        node->SetPosition(Vector3(static_cast<float>(i), 0.0f, 0.0f));
+        node->SetVar("Index", i);
+    }
+
+    VectorBuffer sceneData;
+    scene->SaveXML(sceneData);
+
+    ea::vector<ea::pair<ea::string, ByteVector>> entries;
+    for (unsigned i = 0; i < numScenes; ++i)
+        entries.emplace_back(Format("Scenes/Scene{}.xml", i), sceneData.GetBuffer());
+    WritePackage(context, fileName, entries);
+
+    const auto loadScenes = [&](bool mapToMemory)
+    {
+        auto package = MakeShared<PackageFile>(context, fileName);
+        if (mapToMemory)
+            REQUIRE(package->MapToMemory());
+
+        const unsigned oldResidentSize = GetResidentSize();
+        HiresTimer timer;
+        for (unsigned i = 0; i < numScenes; ++i)
+        {
+            File file(context, package, Format("Scenes/Scene{}.xml", i));
+            auto loadedScene = MakeShared<Scene>(context);
+            REQUIRE(loadedScene->LoadXML(file));
+            REQUIRE(loadedScene->GetNumChildren() == numNodes);
+        }
+        const long long elapsed = timer.GetUSec(false);
+        const unsigned newResidentSize = GetResidentSize();
+
+        WARN(Format("{}: {} scenes loaded in {} us, resident size delta {} KB", mapToMemory ? "Mapped" : "Buffered",
+            numScenes, elapsed, static_cast<int>(newResidentSize - oldResidentSize)).c_str());
+    };
+
+    loadScenes(false);
+    loadScenes(true);
+
+    fileSystem->Delete(fileName);
+}
@@ -0,0 +1,109 @@
+//
+// Copyright (c) 2017-2021 the rbfx project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR rhs
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR rhsWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR rhs DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "../CommonUtils.h"
+
+#include <Urho3D/Math/Frustum.h>
+#include <Urho3D/Math/RandomEngine.h>
+
+namespace
+{
+
+Frustum CreateTestFrustum()
+{
+    Frustum frustum;
+    frustum.Define(60.0f, 1.5f, 1.0f, 0.1f, 500.0f, Matrix3x4(Vector3(10.0f, 5.0f, -20.0f), Quaternion(30.0f, Vector3::UP), 1.0f));
+    return frustum;
+}
+
+ea::vector<BoundingBox> CreateTestBoxes(unsigned count)
+{
+    RandomEngine engine(0);
+    ea::vector<BoundingBox> boxes;
+    for (unsigned i = 0; i < count; ++i)
+    {
+        const Vector3 center = engine.GetVector3({ -1000.0f, -100.0f, -1000.0f }, { 1000.0f, 100.0f, 1000.0f });
+        const Vector3 halfSize = engine.GetVector3(Vector3::ONE * 0.1f, Vector3::ONE * 10.0f);
+        boxes.emplace_back(center - halfSize, center + halfSize);
+    }
+    return boxes;
+}
+
+}
+
+TEST_CASE("Batch frustum culling matches per-box culling")
+{
+    const Frustum frustum = CreateTestFrustum();
+    const auto boxes = CreateTestBoxes(1003);
+
+    BoundingBoxSoA boxesSoA;
+    for (const BoundingBox& box : boxes)
+        boxesSoA.Push(box);
+
+    ea::vector<bool> result;
+    frustum.IsInsideFast(boxesSoA, result);
+
+    REQUIRE(result.size() == boxes.size());
+    unsigned numInside = 0;
+    for (unsigned i = 0; i < boxes.size(); ++i)
+    {
+        const bool expected = frustum.IsInsideFast(boxes[i]) != OUTSIDE;
+        REQUIRE(result[i] == expected);
+        numInside += expected;
+    }
+    REQUIRE(numInside > 0);
+    REQUIRE(numInside < boxes.size());
+}
+
+TEST_CASE("Batch frustum culling performance", "[.benchmark]")
+{
+    const Frustum frustum = CreateTestFrustum();
+    const auto boxes = CreateTestBoxes(100000);
+    ea::vector<bool> result;
+    BoundingBoxSoA boxesSoA;
+
+    BENCHMARK("Per-box culling")
+    {
+        result.resize(boxes.size());
+        for (unsigned i = 0; i < boxes.size(); ++i)
+            result[i] = frustum.IsInsideFast(boxes[i]) != OUTSIDE;
+        return result.size();
+    };
+
+    BENCHMARK("Batch culling including gather")
+    {
+        boxesSoA.Clear();
+        for (const BoundingBox& box : boxes)
+            boxesSoA.Push(box);
+        frustum.IsInsideFast(boxesSoA, result);
+        return result.size();
+    };
+
+    boxesSoA.Clear();
+    for (const BoundingBox& box : boxes)
+        boxesSoA.Push(box);
+    BENCHMARK("Batch culling")
+    {
+        frustum.IsInsideFast(boxesSoA, result);
+        return result.size();
+    };
+}
@@ -0,0 +1,267 @@
+//
+// Copyright (c) 2017-2021 the rbfx project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "../CommonUtils.h"
+
+#if URHO3D_NAVIGATION && URHO3D_PHYSICS
+
+#include <Urho3D/Core/StringUtils.h>
+#include <Urho3D/Core/Timer.h>
+#include <Urho3D/Core/WorkQueue.h>
+#include <Urho3D/Math/RandomEngine.h>
+#include <Urho3D/Navigation/DynamicNavigationMesh.h>
+#include <Urho3D/Navigation/Navigable.h>
+#include <Urho3D/Navigation/NavigationEvents.h>
+#include <Urho3D/Navigation/NavigationMesh.h>
+#include <Urho3D/Physics/CollisionShape.h>
+#include <Urho3D/Physics/PhysicsWorld.h>
+#include <Urho3D/Scene/Scene.h>
+
+namespace
+{
+
+/// Create scene with synthetic terrain made of boxes of random height.
+SharedPtr<Scene> CreateTerrainScene(Context* context, unsigned gridSize, float cellSize, bool dynamic = false)
+{
+    auto scene = MakeShared<Scene>(context);
+    scene->CreateComponent<PhysicsWorld>();
+
+    NavigationMesh* navMesh = dynamic ? scene->CreateComponent<DynamicNavigationMesh>() : scene->CreateComponent<NavigationMesh>();
+    navMesh->SetTileSize(32);
+    navMesh->SetPadding(Vector3::ZERO);
+
+    Node* terrainNode = scene->CreateChild("Terrain");
+    terrainNode->CreateComponent<Navigable>();
+
+    RandomEngine engine(0);
+    for (unsigned x = 0; x < gridSize; ++x)
+    {
+        for (unsigned z = 0; z < gridSize; ++z)
+        {
+            const float height = engine.GetFloat(0.5f, 2.0f);
+            Node* cellNode = terrainNode->CreateChild("Cell");
+            cellNode->SetPosition({ x * cellSize, height * 0.5f, z * cellSize });
+            cellNode->SetScale({ cellSize, height, cellSize });
+            cellNode->CreateComponent<CollisionShape>()->SetBox(Vector3::ONE);
+        }
+    }
+    return scene;
+}
+
+}
+
+TEST_CASE("Navigation mesh tiles built in parallel match serial build")
+{
+    auto context = Tests::CreateCompleteTestContext();
+
+    Tests::RecreateWorkQueue(context, 0);
+    auto serialScene = CreateTerrainScene(context, 12, 4.0f);
+    auto serialNavMesh = serialScene->GetComponent<NavigationMesh>();
+    REQUIRE(serialNavMesh->Build());
+
+    Tests::RecreateWorkQueue(context, 3);
+    auto parallelScene = CreateTerrainScene(context, 12, 4.0f);
+    auto parallelNavMesh = parallelScene->GetComponent<NavigationMesh>();
+    REQUIRE(parallelNavMesh->Build());
+
+    const IntVector2 numTiles = serialNavMesh->GetNumTiles();
+    REQUIRE(numTiles.x_ * numTiles.y_ > 1);
+    REQUIRE(parallelNavMesh->GetNumTiles() == numTiles);
+    for (int z = 0; z < numTiles.y_; ++z)
+    {
+        for (int x = 0; x < numTiles.x_; ++x)
+        {
+            const IntVector2 tile{ x, z };
+            REQUIRE(serialNavMesh->HasTile(tile));
+            REQUIRE(parallelNavMesh->GetTileData(tile) == serialNavMesh->GetTileData(tile));
+        }
+    }
+
+    // Build is aborted after first batch
+    StopToken stopToken;
+    unsigned numProgressEvents = 0;
+    parallelScene->SubscribeToEvent(parallelNavMesh, E_NAVIGATION_BUILD_PROGRESS,
+        [&](StringHash, VariantMap& eventData)
+    {
+        using namespace NavigationBuildProgress;
+        REQUIRE(eventData[P_NUMPROCESSED].GetInt() < eventData[P_NUMTOTAL].GetInt());
+        ++numProgressEvents;
+        stopToken.Stop();
+    });
+
+    unsigned numRebuiltEvents = 0;
+    parallelScene->SubscribeToEvent(parallelNavMesh, E_NAVIGATION_MESH_REBUILT, [&](StringHash, VariantMap&) { ++numRebuiltEvents; });
+
+    REQUIRE_FALSE(parallelNavMesh->Build(stopToken));
+    REQUIRE(numProgressEvents == 1);
+    REQUIRE(numRebuiltEvents == 0);
+
+    // Partially built mesh is released
+    REQUIRE(parallelNavMesh->GetNumTiles() == IntVector2::ZERO);
+    REQUIRE_FALSE(parallelNavMesh->HasTile(IntVector2::ZERO));
+    ea::vector<Vector3> path;
+    parallelNavMesh->FindPath(path, Vector3::ZERO, Vector3::ONE);
+    REQUIRE(path.empty());
+
+    // Mesh can be built again afterwards
+    parallelScene->UnsubscribeFromEvent(parallelNavMesh, E_NAVIGATION_BUILD_PROGRESS);
+    REQUIRE(parallelNavMesh->Build());
+    REQUIRE(numRebuiltEvents == 1);
+    REQUIRE(parallelNavMesh->GetNumTiles() == numTiles);
+    REQUIRE(parallelNavMesh->GetTileData(numTiles - IntVector2::ONE) == serialNavMesh->GetTileData(numTiles - IntVector2::ONE));
+}
+
+TEST_CASE("Dynamic navigation mesh tiles built in parallel match serial build")
+{
+    auto context = Tests::CreateCompleteTestContext();
+
+    Tests::RecreateWorkQueue(context, 0);
+    auto serialScene = CreateTerrainScene(context, 12, 4.0f, true);
+    auto serialNavMesh = serialScene->GetComponent<DynamicNavigationMesh>();
+    REQUIRE(serialNavMesh->Build());
+
+    Tests::RecreateWorkQueue(context, 3);
+    auto parallelScene = CreateTerrainScene(context, 12, 4.0f, true);
+    auto parallelNavMesh = parallelScene->GetComponent<DynamicNavigationMesh>();
+    REQUIRE(parallelNavMesh->Build());
+
+    const auto compareTiles = [&]()
+    {
+        const IntVector2 numTiles = serialNavMesh->GetNumTiles();
+        REQUIRE(numTiles.x_ * numTiles.y_ > 1);
+        REQUIRE(parallelNavMesh->GetNumTiles() == numTiles);
+        for (int z = 0; z < numTiles.y_; ++z)
+        {
+            for (int x = 0; x < numTiles.x_; ++x)
+            {
+                const IntVector2 tile{ x, z };
+                const ea::vector<unsigned char> tileData = serialNavMesh->GetTileData(tile);
+                REQUIRE_FALSE(tileData.empty());
+                REQUIRE(parallelNavMesh->GetTileData(tile) == tileData);
+            }
+        }
+    };
+    compareTiles();
+
+    // Partial rebuild goes through the same batches
+    REQUIRE(serialNavMesh->Build(IntVector2::ZERO, IntVector2::ONE));
+    REQUIRE(parallelNavMesh->Build(IntVector2::ZERO, IntVector2::ONE));
+    compareTiles();
+
+    // Aborted build releases the mesh together with the tile cache
+    StopToken stopToken;
+    parallelScene->SubscribeToEvent(parallelNavMesh, E_NAVIGATION_BUILD_PROGRESS, [&](StringHash, VariantMap&) { stopToken.Stop(); });
+    REQUIRE_FALSE(parallelNavMesh->Build(stopToken));
+    REQUIRE(parallelNavMesh->GetNumTiles() == IntVector2::ZERO);
+    REQUIRE(parallelNavMesh->GetTileData(IntVector2::ZERO).empty());
+
+    parallelScene->UnsubscribeFromEvent(parallelNavMesh, E_NAVIGATION_BUILD_PROGRESS);
+    REQUIRE(parallelNavMesh->Build());
+    compareTiles();
+}
+
+TEST_CASE("Asynchronous path requests return the same paths as synchronous ones")
+{
+    auto context = Tests::CreateCompleteTestContext();
+    Tests::RecreateWorkQueue(context, 3);
+
+    auto scene = CreateTerrainScene(context, 12, 4.0f);
+    auto navMesh = scene->GetComponent<NavigationMesh>();
+    REQUIRE(navMesh->Build());
+
+    RandomEngine engine(0);
+    const BoundingBox terrainBox{ Vector3::ZERO, Vector3(44.0f, 2.0f, 44.0f) };
+    ea::vector<ea::pair<Vector3, Vector3>> endpoints(200);
+    for (auto& [start, end] : endpoints)
+    {
+        start = engine.GetVector3(terrainBox);
+        end = engine.GetVector3(terrainBox);
+    }
+
+    ea::vector<unsigned> handles;
+    for (const auto& [start, end] : endpoints)
+        handles.push_back(navMesh->FindPathAsync(start, end, Vector3(1.0f, 4.0f, 1.0f)));
+    navMesh->CancelPathRequest(handles[1]);
+
+    ea::vector<NavigationPathResult> results;
+    scene->SubscribeToEvent(navMesh, E_NAVIGATION_PATHS_FOUND, [&](StringHash, VariantMap&)
+    {
+        const auto& batch = navMesh->GetPathResults();
+        results.insert(results.end(), batch.begin(), batch.end());
+    });
+
+    // Only one batch fits into zero time budget
+    navMesh->SetMaxPathRequestTime(0);
+    scene->Update(1.0f / 60.0f);
+    REQUIRE_FALSE(results.empty());
+    REQUIRE(navMesh->GetNumPendingPathRequests() > 0);
+
+    navMesh->SetMaxPathRequestTime(M_MAX_UNSIGNED);
+    scene->Update(1.0f / 60.0f);
+    REQUIRE(navMesh->GetNumPendingPathRequests() == 0);
+    REQUIRE(results.size() == endpoints.size() - 1);
+
+    unsigned numPaths = 0;
+    ea::vector<NavigationPathPoint> expectedPath;
+    for (unsigned i = 0, resultIndex = 0; i < endpoints.size(); ++i)
+    {
+        if (i == 1)
+            continue;
+
+        const NavigationPathResult& result = results[resultIndex++];
+        REQUIRE(result.handle_ == handles[i]);
+
+        navMesh->FindPath(expectedPath, endpoints[i].first, endpoints[i].second, Vector3(1.0f, 4.0f, 1.0f));
+        REQUIRE(result.path_.size() == expectedPath.size());
+        for (unsigned j = 0; j < expectedPath.size(); ++j)
+        {
+            REQUIRE(result.path_[j].position_ == expectedPath[j].position_);
+            REQUIRE(result.path_[j].flag_ == expectedPath[j].flag_);
+        }
+        if (!expectedPath.empty())
+            ++numPaths;
+    }
+    REQUIRE(numPaths > 0);
+}
+
+TEST_CASE("Navigation mesh build benchmark", "[.benchmark]")
+{
+    auto context = Tests::CreateCompleteTestContext();
+
+    ea::string report;
+    for (const unsigned numThreads : { 1u, 4u, 16u })
+    {
+        Tests::RecreateWorkQueue(context, numThreads - 1);
+        auto scene = CreateTerrainScene(context, 64, 4.0f);
+        auto navMesh = scene->GetComponent<NavigationMesh>();
+
+        HiresTimer timer;
+        REQUIRE(navMesh->Build());
+        const long long elapsed = timer.GetUSec(false);
+
+        const IntVector2 numTiles = navMesh->GetNumTiles();
+        report += Format("{:>2} threads: {}x{} tiles in {:>8} us\n", numThreads, numTiles.x_, numTiles.y_, elapsed);
+    }
+    WARN(report.c_str());
+}
+
+#endif
@@ -0,0 +1,379 @@
+//
+// Copyright (c) 2017-2021 the rbfx project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "../CommonUtils.h"
+#include "../NetworkUtils.h"
+
+#if URHO3D_NETWORK
+
+#include <Urho3D/Core/WorkQueue.h>
+#include <Urho3D/Network/Connection.h>
+#include <Urho3D/Network/InterestManager.h>
+#include <Urho3D/Network/NetworkPriority.h>
+#include <Urho3D/Scene/Scene.h>
+#include <Urho3D/Scene/SmoothedTransform.h>
+
+#include <EASTL/sort.h>
+
+namespace
+{
+
+ea::vector<Node*> QueryNodes(const InterestManager* interestManager, const Connection* connection)
+{
+    ea::vector<const InterestEntry*> entries;
+    interestManager->QueryRelevantNodes(connection, entries);
+
+    ea::vector<Node*> nodes;
+    for (const InterestEntry* entry : entries)
+        nodes.push_back(entry->node_);
+    ea::sort(nodes.begin(), nodes.end());
+    return nodes;
+}
+
+/// Return latest position received by the client.
+Vector3 GetClientPosition(Scene* clientScene, Node* serverNode)
+{
+    Node* clientNode = clientScene->GetNode(serverNode->GetID());
+    REQUIRE(clientNode);
+    return clientNode->GetComponent<SmoothedTransform>()->GetTargetPosition();
+}
+
+/// Update server and clients for specified number of ticks.
+void RunTicks(Tests::LoopbackSession& session, unsigned numTicks)
+{
+    auto workQueue = session.serverScene_->GetSubsystem<WorkQueue>();
+    for (unsigned tick = 0; tick < numTicks; ++tick)
+    {
+        session.UpdateServer(workQueue);
+        session.UpdateClientsAndLinks(1.0f / 30.0f);
+    }
+}
+
+/// Move nodes to encode current tick, update session and return number of nodes updated on the client.
+unsigned RunTickAndCountUpdates(Tests::LoopbackSession& session, const ea::vector<Node*>& nodes, unsigned tick,
+    ea::vector<unsigned>& numUpdates)
+{
+    for (Node* node : nodes)
+    {
+        Vector3 position = node->GetPosition();
+        position.y_ = static_cast<float>(tick);
+        node->SetPosition(position);
+    }
+
+    RunTicks(session, 1);
+
+    unsigned numUpdatedNodes = 0;
+    numUpdates.resize(nodes.size());
+    for (unsigned i = 0; i < nodes.size(); ++i)
+    {
+        if (GetClientPosition(session.clientScenes_[0], nodes[i]).y_ == static_cast<float>(tick))
+        {
+            ++numUpdates[i];
+            ++numUpdatedNodes;
+        }
+    }
+    return numUpdatedNodes;
+}
+
+}
+
+TEST_CASE("Interest manager returns nodes relevant to connection")
+{
+    auto context = Tests::CreateCompleteTestContext();
+    auto scene = MakeShared<Scene>(context);
+    auto interestManager = scene->CreateComponent<InterestManager>(LOCAL);
+    interestManager->SetCellSize(16.0f);
+    interestManager->SetRelevanceRadius(50.0f);
+
+    auto connection = MakeShared<Connection>(context);
+    connection->SetPosition({ 5.0f, 0.0f, -5.0f });
+
+    // Grid of nodes, some of them are children of the nodes to the left
+    ea::vector<Node*> expectedNodes;
+    for (int x = -20; x <= 20; ++x)
+    {
+        Node* parent = nullptr;
+        for (int z = -20; z <= 20; ++z)
+        {
+            Node* node = (parent ? parent : scene.Get())->CreateChild();
+            node->SetWorldPosition({ x * 10.0f, 0.0f, z * 10.0f });
+            parent = z % 3 == 0 ? node : nullptr;
+
+            if ((node->GetWorldPosition() - connection->GetPosition()).Length() <= 50.0f)
+                expectedNodes.push_back(node);
+        }
+    }
+
+    // Local nodes are ignored
+    scene->CreateChild("Local", LOCAL);
+
+    // Far node owned by connection is relevant
+    Node* ownedNode = scene->CreateChild();
+    ownedNode->SetPosition({ 1000.0f, 0.0f, 1000.0f });
+    ownedNode->SetOwner(connection);
+    expectedNodes.push_back(ownedNode);
+
+    // Node with non-matching mask is not relevant
+    connection->SetInterestMask(0x1);
+    Node* maskedNode = scene->CreateChild();
+    maskedNode->CreateComponent<NetworkPriority>()->SetRelevanceMask(0x2);
+
+    // Far node may be relevant to everyone
+    Node* globalNode = scene->CreateChild();
+    globalNode->SetPosition({ -1000.0f, 0.0f, 1000.0f });
+    globalNode->CreateComponent<NetworkPriority>()->SetAlwaysRelevant(true);
+    expectedNodes.push_back(globalNode);
+
+    ea::sort(expectedNodes.begin(), expectedNodes.end());
+
+    interestManager->Update();
+    REQUIRE(QueryNodes(interestManager, connection) == expectedNodes);
+
+    // Nodes behind the observer are relevant only within near radius
+    interestManager->SetViewAngle(90.0f);
+    interestManager->SetNearRadius(0.0f);
+    connection->SetRotation(Quaternion::IDENTITY);
+    for (Node* node : QueryNodes(interestManager, connection))
+    {
+        if (node != ownedNode && node != globalNode)
+            REQUIRE(node->GetWorldPosition().z_ >= connection->GetPosition().z_);
+    }
+}
+
+TEST_CASE("Nodes are created and removed on client as they enter and leave relevance")
+{
+    auto context = Tests::CreateCompleteTestContext();
+    Tests::LoopbackSession session(context, 1, LoopbackLinkParams{});
+    Scene* serverScene = session.serverScene_;
+    Scene* clientScene = session.clientScenes_[0];
+
+    auto interestManager = serverScene->CreateComponent<InterestManager>(LOCAL);
+    interestManager->SetCellSize(10.0f);
+    interestManager->SetRelevanceRadius(20.0f);
+    session.links_[0]->GetServerConnection()->SetPosition(Vector3::ZERO);
+
+    Node* nearNode = serverScene->CreateChild("Near");
+    nearNode->SetPosition({ 5.0f, 0.0f, 0.0f });
+    Node* farNode = serverScene->CreateChild("Far");
+    farNode->SetPosition({ 100.0f, 0.0f, 0.0f });
+
+    RunTicks(session, 10);
+    REQUIRE(session.AreClientsReady());
+    REQUIRE(clientScene->GetNode(nearNode->GetID()));
+    REQUIRE_FALSE(clientScene->GetNode(farNode->GetID()));
+
+    // Node enters relevance
+    farNode->SetPosition({ 0.0f, 0.0f, 10.0f });
+    RunTicks(session, 2);
+    REQUIRE(clientScene->GetNode(farNode->GetID()));
+    REQUIRE(GetClientPosition(clientScene, farNode) == farNode->GetPosition());
+
+    // Node leaves relevance
+    nearNode->SetPosition({ 200.0f, 0.0f, 0.0f });
+    RunTicks(session, 2);
+    REQUIRE_FALSE(clientScene->GetNode(nearNode->GetID()));
+
+    // Changes made while node was irrelevant are received when it enters relevance again
+    nearNode->SetName("NearAgain");
+    RunTicks(session, 2);
+    nearNode->SetPosition({ 0.0f, 0.0f, -5.0f });
+    RunTicks(session, 2);
+    Node* clientNearNode = clientScene->GetNode(nearNode->GetID());
+    REQUIRE(clientNearNode);
+    REQUIRE(clientNearNode->GetName() == "NearAgain");
+    REQUIRE(GetClientPosition(clientScene, nearNode) == nearNode->GetPosition());
+
+    // Irrelevant parent is replicated together with relevant child
+    Node* parentNode = serverScene->CreateChild("Parent");
+    parentNode->SetPosition({ 300.0f, 0.0f, 0.0f });
+    Node* childNode = parentNode->CreateChild("Child");
+    childNode->SetWorldPosition({ 5.0f, 0.0f, 5.0f });
+    RunTicks(session, 2);
+    REQUIRE(clientScene->GetNode(parentNode->GetID()));
+    REQUIRE(clientScene->GetNode(childNode->GetID()));
+    REQUIRE(clientScene->GetNode(childNode->GetID())->GetParent() == clientScene->GetNode(parentNode->GetID()));
+
+    childNode->SetWorldPosition({ 300.0f, 0.0f, 0.0f });
+    RunTicks(session, 2);
+    REQUIRE_FALSE(clientScene->GetNode(parentNode->GetID()));
+    REQUIRE_FALSE(clientScene->GetNode(childNode->GetID()));
+
+    // Removed node is removed from client
+    const unsigned farNodeID = farNode->GetID();
+    farNode->Remove();
+    RunTicks(session, 2);
+    REQUIRE_FALSE(clientScene->GetNode(farNodeID));
+    REQUIRE(clientScene->GetNode(nearNode->GetID()));
+}
+
+TEST_CASE("Replication states are released when nodes leave relevance of multiple connections")
+{
+    auto context = Tests::CreateCompleteTestContext();
+    Tests::RecreateWorkQueue(context, 3);
+
+    const unsigned numClients = 4;
+    Tests::LoopbackSession session(context, numClients, LoopbackLinkParams{});
+    Scene* serverScene = session.serverScene_;
+
+    auto interestManager = serverScene->CreateComponent<InterestManager>(LOCAL);
+    interestManager->SetCellSize(10.0f);
+    interestManager->SetRelevanceRadius(20.0f);
+    for (unsigned i = 0; i < numClients; ++i)
+        session.links_[i]->GetServerConnection()->SetPosition({ 100.0f * i, 0.0f, 0.0f });
+
+    ea::vector<Node*> nodes;
+    for (unsigned i = 0; i < 64; ++i)
+    {
+        Node* node = serverScene->CreateChild("Node");
+        node->CreateComponent<NetworkPriority>();
+        nodes.push_back(node);
+    }
+
+    RunTicks(session, 10);
+    REQUIRE(session.AreClientsReady());
+
+    // Nodes hop between connections, so every tick some of them leave relevance of several connections at once
+    for (unsigned step = 0; step < 8; ++step)
+    {
+        for (unsigned i = 0; i < nodes.size(); ++i)
+        {
+            const unsigned area = (i + step) % (numClients + 1);
+            nodes[i]->SetPosition({ 100.0f * area + (i % 5), 0.0f, 0.0f });
+        }
+        RunTicks(session, 2);
+
+        for (Node* node : nodes)
+        {
+            unsigned numRelevant = 0;
+            for (unsigned i = 0; i < numClients; ++i)
+            {
+                const bool isRelevant = node->GetPosition().DistanceToPoint(session.links_[i]->GetServerConnection()->GetPosition()) < 20.0f;
+                REQUIRE(!!session.clientScenes_[i]->GetNode(node->GetID()) == isRelevant);
+                if (isRelevant)
+                    ++numRelevant;
+            }
+
+            REQUIRE(node->GetNetworkState()->replicationStates_.size() == numRelevant);
+            auto priority = node->GetComponent<NetworkPriority>();
+            REQUIRE(priority->GetNetworkState()->replicationStates_.size() == numRelevant);
+        }
+    }
+
+    // Removed nodes are removed from all clients, remaining nodes are gathered around the first connection
+    ea::vector<unsigned> nodeIDs;
+    for (unsigned i = 0; i < nodes.size(); ++i)
+    {
+        nodeIDs.push_back(nodes[i]->GetID());
+        if (i % 2 == 0)
+            nodes[i]->Remove();
+        else
+            nodes[i]->SetPosition(Vector3::ZERO);
+    }
+    RunTicks(session, 2);
+
+    for (unsigned i = 0; i < numClients; ++i)
+    {
+        for (unsigned j = 0; j < nodeIDs.size(); ++j)
+            REQUIRE(!!session.clientScenes_[i]->GetNode(nodeIDs[j]) == (i == 0 && j % 2 == 1));
+    }
+    for (unsigned j = 1; j < nodes.size(); j += 2)
+        REQUIRE(nodes[j]->GetNetworkState()->replicationStates_.size() == 1);
+}
+
+TEST_CASE("Network priority limits update rate of relevant nodes regardless of update budget")
+{
+    for (unsigned updateBudget : { 0u, 1000000u })
+    {
+        auto context = Tests::CreateCompleteTestContext();
+        Tests::LoopbackSession session(context, 1, LoopbackLinkParams{});
+        Scene* serverScene = session.serverScene_;
+
+        auto interestManager = serverScene->CreateComponent<InterestManager>(LOCAL);
+        interestManager->SetRelevanceRadius(1000.0f);
+        interestManager->SetUpdateBudget(updateBudget);
+
+        Node* fastNode = serverScene->CreateChild("Fast");
+        Node* slowNode = serverScene->CreateChild("Slow");
+        auto priority = slowNode->CreateComponent<NetworkPriority>();
+        priority->SetBasePriority(25.0f);
+        priority->SetDistanceFactor(0.0f);
+
+        RunTicks(session, 10);
+        REQUIRE(session.AreClientsReady());
+
+        const ea::vector<Node*> nodes{ fastNode, slowNode };
+        ea::vector<unsigned> numUpdates;
+        for (unsigned tick = 100; tick < 140; ++tick)
+            RunTickAndCountUpdates(session, nodes, tick, numUpdates);
+
+        CHECK(numUpdates[0] == 40);
+        CHECK(numUpdates[1] == 10);
+    }
+}
+
+TEST_CASE("Update budget schedules relevant nodes by accumulated priority")
+{
+    static const unsigned numNodes = 20;
+    static const unsigned numTicks = 60;
+
+    auto context = Tests::CreateCompleteTestContext();
+    Tests::LoopbackSession session(context, 1, LoopbackLinkParams{});
+    Scene* serverScene = session.serverScene_;
+
+    auto interestManager = serverScene->CreateComponent<InterestManager>(LOCAL);
+    interestManager->SetRelevanceRadius(1000.0f);
+    interestManager->SetUpdateBudget(120);
+
+    // Priority decreases with distance, far nodes are due for update every few ticks
+    ea::vector<Node*> nodes;
+    for (unsigned i = 0; i < numNodes; ++i)
+    {
+        Node* node = serverScene->CreateChild();
+        node->SetPosition({ i * 10.0f, 0.0f, 0.0f });
+        auto priority = node->CreateComponent<NetworkPriority>();
+        priority->SetBasePriority(200.0f);
+        priority->SetDistanceFactor(1.0f);
+        priority->SetMinPriority(20.0f);
+        nodes.push_back(node);
+    }
+
+    // New nodes are created first, possibly over several ticks
+    RunTicks(session, 60);
+    REQUIRE(session.AreClientsReady());
+    for (Node* node : nodes)
+        REQUIRE(session.clientScenes_[0]->GetNode(node->GetID()));
+
+    ea::vector<unsigned> numUpdates;
+    unsigned maxUpdatedNodes = 0;
+    for (unsigned tick = 100; tick < 100 + numTicks; ++tick)
+        maxUpdatedNodes = ea::max(maxUpdatedNodes, RunTickAndCountUpdates(session, nodes, tick, numUpdates));
+
+    // Budget limits number of updates per tick
+    CHECK(maxUpdatedNodes < numNodes / 2);
+
+    // Every node is eventually updated, and near nodes are updated more often
+    for (unsigned i = 0; i < numNodes; ++i)
+        CHECK(numUpdates[i] > 0);
+    CHECK(numUpdates.front() > numUpdates.back());
+}
+
+#endif
@@ -0,0 +1,264 @@
+//
+// Copyright (c) 2017-2021 the rbfx project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "../CommonUtils.h"
+#include "../NetworkUtils.h"
+
+#if URHO3D_NETWORK
+
+#include <Urho3D/Core/StringUtils.h>
+#include <Urho3D/Core/Timer.h>
+#include <Urho3D/Core/WorkQueue.h>
+#include <Urho3D/Network/Connection.h>
+#include <Urho3D/Scene/ReplicationState.h>
+#include <Urho3D/Scene/Scene.h>
+#include <Urho3D/Scene/SmoothedTransform.h>
+
+TEST_CASE("Nodes are replicated via lossy loopback link")
+{
+    const float timeStep = 1.0f / 30.0f;
+    auto context = Tests::CreateCompleteTestContext();
+    auto workQueue = context->GetSubsystem<WorkQueue>();
+
+    LoopbackLinkParams params;
+    params.latency_ = 0.05f;
+    params.jitter_ = 0.02f;
+    params.packetLoss_ = 0.2f;
+    Tests::LoopbackSession session(context, 2, params);
+
+    Node* serverNode = session.serverScene_->CreateChild("Moving");
+    for (unsigned tick = 0; tick < 120; ++tick)
+    {
+        serverNode->SetPosition({ static_cast<float>(tick), 0.0f, 0.0f });
+        session.UpdateServer(workQueue);
+        session.UpdateClientsAndLinks(timeStep);
+    }
+
+    // Let latest data settle
+    for (unsigned tick = 0; tick < 30; ++tick)
+    {
+        session.UpdateServer(workQueue);
+        session.UpdateClientsAndLinks(timeStep);
+    }
+
+    REQUIRE(session.AreClientsReady());
+    for (Scene* clientScene : session.clientScenes_)
+    {
+        Node* clientNode = clientScene->GetNode(serverNode->GetID());
+        REQUIRE(clientNode);
+        REQUIRE(clientNode->GetName() == "Moving");
+        REQUIRE(clientNode->GetComponent<SmoothedTransform>()->GetTargetPosition() == serverNode->GetPosition());
+    }
+
+    const LoopbackLinkStats& stats = session.links_[0]->GetStats(LoopbackLink::TO_CLIENT);
+    REQUIRE(stats.numPacketsLost_ + stats.numPacketsResent_ > 0);
+}
+
+TEST_CASE("Serialized node updates are shared between connections")
+{
+    static const unsigned numClients = 4;
+    static const unsigned numNodes = 8;
+    static const unsigned numTicks = 60;
+    const float timeStep = 1.0f / 30.0f;
+    auto context = Tests::CreateCompleteTestContext();
+    Tests::RecreateWorkQueue(context, 3);
+    auto workQueue = context->GetSubsystem<WorkQueue>();
+
+    // Ideal link, so every connection receives the same data
+    const auto createSession = [&]()
+    {
+        auto session = ea::make_unique<Tests::LoopbackSession>(context, numClients, LoopbackLinkParams{});
+        for (unsigned i = 0; i < numNodes; ++i)
+            session->serverScene_->CreateChild(Format("Node{}", i));
+        for (LoopbackLink* link : session->links_)
+            link->SetRecordPackets(LoopbackLink::TO_CLIENT, true);
+        return session;
+    };
+    auto parallelSession = createSession();
+    auto serialSession = createSession();
+
+    unsigned numSharedDeltas = 0;
+    for (unsigned tick = 0; tick < numTicks; ++tick)
+    {
+        // Every node has position changed, every other node has name changed
+        for (Tests::LoopbackSession* session : { parallelSession.get(), serialSession.get() })
+        {
+            const auto& nodes = session->serverScene_->GetChildren();
+            for (unsigned i = 0; i < numNodes; ++i)
+            {
+                nodes[i]->SetPosition({ static_cast<float>(tick * (i + 1)), 0.0f, 0.0f });
+                if (i % 2 == 0)
+                    nodes[i]->SetName(Format("Node{}_{}", i, tick));
+            }
+        }
+
+        parallelSession->UpdateServer(workQueue);
+
+        // Each node is serialized once for all connections
+        for (Node* node : parallelSession->serverScene_->GetChildren())
+        {
+            const NetworkState* networkState = node->GetNetworkState();
+            REQUIRE(networkState);
+            REQUIRE(networkState->serializedDeltas_.size() <= 1);
+            if (!networkState->serializedDeltas_.empty())
+                ++numSharedDeltas;
+        }
+
+        // Reference update is built connection by connection without sharing serialized data
+        Scene* serialScene = serialSession->serverScene_;
+        serialScene->PrepareNetworkUpdate();
+        for (LoopbackLink* link : serialSession->links_)
+        {
+            for (Node* node : serialScene->GetChildren())
+                node->GetNetworkState()->ClearSerializedData();
+
+            Connection* connection = link->GetClientConnection();
+            connection->SendServerUpdate();
+            connection->SendAllBuffers();
+        }
+
+        parallelSession->UpdateClientsAndLinks(timeStep);
+        serialSession->UpdateClientsAndLinks(timeStep);
+    }
+
+    REQUIRE(parallelSession->AreClientsReady());
+    REQUIRE(numSharedDeltas > 0);
+    const ByteVector& expectedData = serialSession->links_[0]->GetRecordedData(LoopbackLink::TO_CLIENT);
+    REQUIRE_FALSE(expectedData.empty());
+    for (unsigned i = 0; i < numClients; ++i)
+    {
+        REQUIRE(serialSession->links_[i]->GetRecordedData(LoopbackLink::TO_CLIENT) == expectedData);
+        REQUIRE(parallelSession->links_[i]->GetRecordedData(LoopbackLink::TO_CLIENT) == expectedData);
+    }
+
+    for (Scene* clientScene : parallelSession->clientScenes_)
+    {
+        for (Node* serverNode : parallelSession->serverScene_->GetChildren())
+        {
+            Node* clientNode = clientScene->GetNode(serverNode->GetID());
+            REQUIRE(clientNode);
+            REQUIRE(clientNode->GetName() == serverNode->GetName());
+        }
+    }
+}
+
+TEST_CASE("Loopback replication soak benchmark", "[.benchmark]")
+{
+    static const unsigned numClients = 16;
+    static const unsigned numNodes = 1000;
+    static const unsigned numWarmupTicks = 60;
+    static const unsigned numTicks = 600;
+    static const float timeStep = 1.0f / 30.0f;
+
+    const bool snapshotReplication = GENERATE(false, true);
+    const bool compactEncoding = GENERATE(false, true);
+
+    auto context = Tests::CreateCompleteTestContext();
+    auto workQueue = context->GetSubsystem<WorkQueue>();
+
+    // Encoding is shared by server and clients because they use the same context
+    const AttributeNetworkEncoding positionEncoding = compactEncoding
+        ? AttributeNetworkEncoding::Quantized(-1024.0f, 1024.0f, 16) : AttributeNetworkEncoding{};
+    const AttributeNetworkEncoding rotationEncoding = compactEncoding
+        ? AttributeNetworkEncoding::SmallestThree(15) : AttributeNetworkEncoding{};
+    context->UpdateAttributeNetworkEncoding(Node::GetTypeStatic(), "Network Position", positionEncoding);
+    context->UpdateAttributeNetworkEncoding(Node::GetTypeStatic(), "Network Rotation", rotationEncoding);
+
+    LoopbackLinkParams params;
+    params.latency_ = 0.05f;
+    params.jitter_ = 0.01f;
+    params.packetLoss_ = 0.01f;
+    params.bandwidth_ = 1024 * 1024;
+    Tests::LoopbackSession session(context, numClients, params);
+    for (LoopbackLink* link : session.links_)
+        link->GetClientConnection()->SetSnapshotReplication(snapshotReplication);
+
+    // Node Y coordinate is the tick when the node was moved, so the client can measure end-to-end latency
+    ea::vector<Node*> serverNodes;
+    for (unsigned i = 0; i < numNodes; ++i)
+    {
+        Node* node = session.serverScene_->CreateChild();
+        node->SetPosition({ static_cast<float>(i % 100), 0.0f, static_cast<float>(i / 100) });
+        serverNodes.push_back(node);
+    }
+
+    long long serverTime = 0;
+    double latencySum = 0.0;
+    unsigned long long numLatencySamples = 0;
+    HiresTimer timer;
+
+    for (unsigned tick = 0; tick < numWarmupTicks + numTicks; ++tick)
+    {
+        const bool measure = tick >= numWarmupTicks;
+
+        for (Node* node : serverNodes)
+        {
+            Vector3 position = node->GetPosition();
+            position.y_ = static_cast<float>(tick);
+            node->SetPosition(position);
+        }
+
+        timer.Reset();
+        session.UpdateServer(workQueue);
+        if (measure)
+            serverTime += timer.GetUSec(false);
+
+        session.UpdateClientsAndLinks(timeStep);
+
+        if (measure)
+        {
+            for (Scene* clientScene : session.clientScenes_)
+            {
+                for (Node* serverNode : serverNodes)
+                {
+                    Node* clientNode = clientScene->GetNode(serverNode->GetID());
+                    if (!clientNode)
+                        continue;
+
+                    const float sentTick = clientNode->GetComponent<SmoothedTransform>()->GetTargetPosition().y_;
+                    latencySum += (tick - sentTick) * timeStep;
+                    ++numLatencySamples;
+                }
+            }
+        }
+    }
+
+    REQUIRE(session.AreClientsReady());
+    REQUIRE(numLatencySamples > 0);
+
+    unsigned long long numBytesToClients = 0;
+    for (LoopbackLink* link : session.links_)
+        numBytesToClients += link->GetStats(LoopbackLink::TO_CLIENT).numBytesSent_;
+    const double duration = (numWarmupTicks + numTicks) * timeStep;
+
+    WARN(Format("{} clients, {} moving nodes, {} ticks, {} replication, {} encoding\n"
+        "Server update: {} us/tick\n"
+        "Traffic: {:.1f} KB/s per client\n"
+        "Latency: {:.1f} ms on average",
+        numClients, numNodes, numTicks, snapshotReplication ? "snapshot" : "latest data",
+        compactEncoding ? "compact" : "plain",
+        serverTime / numTicks,
+        numBytesToClients / duration / numClients / 1024.0,
+        latencySum / numLatencySamples * 1000.0).c_str());
+}
+
+#endif
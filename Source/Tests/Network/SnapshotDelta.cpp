@@ -0,0 +1,124 @@
+//
+// Copyright (c) 2017-2021 the rbfx project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "../CommonUtils.h"
+
+#if URHO3D_NETWORK
+
+#include <Urho3D/IO/MemoryBuffer.h>
+#include <Urho3D/IO/VectorBuffer.h>
+#include <Urho3D/Math/Quaternion.h>
+#include <Urho3D/Network/SnapshotDelta.h>
+#include <Urho3D/Scene/ReplicationState.h>
+
+namespace
+{
+
+ByteVector EncodeDecode(const ByteVector& data, const ByteVector& base, unsigned* encodedSize = nullptr)
+{
+    VectorBuffer encoded;
+    WriteSnapshotDelta(encoded, data, base);
+    if (encodedSize)
+        *encodedSize = encoded.GetSize();
+
+    ByteVector decoded;
+    MemoryBuffer source(encoded.GetBuffer());
+    REQUIRE(ReadSnapshotDelta(source, base, decoded));
+    REQUIRE(source.IsEof());
+    return decoded;
+}
+
+}
+
+TEST_CASE("Snapshot delta is decoded against the same base")
+{
+    VectorBuffer base;
+    base.WriteVector3({ 10.0f, 2.0f, -5.0f });
+    base.WriteQuaternion(Quaternion(30.0f, Vector3::UP));
+
+    VectorBuffer data;
+    data.WriteVector3({ 10.5f, 2.0f, -5.0f });
+    data.WriteQuaternion(Quaternion(30.0f, Vector3::UP));
+
+    // Unchanged data is reduced to size and group masks
+    unsigned encodedSize{};
+    REQUIRE(EncodeDecode(base.GetBuffer(), base.GetBuffer(), &encodedSize) == base.GetBuffer());
+    REQUIRE(encodedSize == 2);
+
+    // Small change is much smaller than the data
+    REQUIRE(EncodeDecode(data.GetBuffer(), base.GetBuffer(), &encodedSize) == data.GetBuffer());
+    REQUIRE(encodedSize < data.GetSize() / 2);
+
+    // Data is decoded without base or with base of different size
+    REQUIRE(EncodeDecode(data.GetBuffer(), {}) == data.GetBuffer());
+    const ByteVector shortBase(base.GetBuffer().begin(), base.GetBuffer().begin() + 5);
+    REQUIRE(EncodeDecode(data.GetBuffer(), shortBase) == data.GetBuffer());
+    REQUIRE(EncodeDecode(shortBase, data.GetBuffer()) == shortBase);
+}
+
+TEST_CASE("Truncated snapshot delta is rejected")
+{
+    const ByteVector data(100, 0xcc);
+
+    VectorBuffer encoded;
+    WriteSnapshotDelta(encoded, data, {});
+
+    ByteVector decoded;
+    MemoryBuffer source(encoded.GetData(), encoded.GetSize() - 1);
+    REQUIRE_FALSE(ReadSnapshotDelta(source, {}, decoded));
+}
+
+TEST_CASE("Snapshot history is sorted by snapshot ID")
+{
+    const auto getIDs = [](const SnapshotHistory& history)
+    {
+        ea::vector<unsigned> ids;
+        for (const SnapshotEntry& entry : history.entries_)
+            ids.push_back(entry.snapshotID_);
+        return ids;
+    };
+
+    // Snapshots received out of order are inserted in place
+    const unsigned char data = 0;
+    SnapshotHistory history;
+    for (unsigned snapshotID : { 10, 12, 11, 14, 13 })
+        history.Add(snapshotID, &data, 1);
+    REQUIRE(getIDs(history) == ea::vector<unsigned>{ 10, 11, 12, 13, 14 });
+
+    // The oldest entry is discarded when history is full
+    const unsigned maxEntries = SnapshotHistory::MAX_ENTRIES;
+    for (unsigned snapshotID = 100; snapshotID < 100 + maxEntries - 5; ++snapshotID)
+        history.Add(snapshotID, &data, 1);
+    REQUIRE(history.entries_.size() == maxEntries);
+
+    history.Add(20, &data, 1);
+    REQUIRE(history.entries_.size() == maxEntries);
+    REQUIRE(history.entries_.front().snapshotID_ == 11);
+    REQUIRE(history.Find(20) == &history.entries_[4]);
+
+    // Snapshot older than all entries is ignored when history is full
+    history.Add(5, &data, 1);
+    REQUIRE(history.entries_.front().snapshotID_ == 11);
+    REQUIRE_FALSE(history.Find(5));
+}
+
+#endif
@@ -0,0 +1,223 @@
+//
+// Copyright (c) 2017-2021 the rbfx project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "../CommonUtils.h"
+#include "../NetworkUtils.h"
+
+#if URHO3D_NETWORK
+
+#include <Urho3D/Core/WorkQueue.h>
+#include <Urho3D/IO/MemoryBuffer.h>
+#include <Urho3D/IO/VectorBuffer.h>
+#include <Urho3D/Network/Connection.h>
+#include <Urho3D/Network/Protocol.h>
+#include <Urho3D/Scene/SmoothedTransform.h>
+
+namespace
+{
+
+/// Create session with snapshot replication enabled for all clients.
+ea::unique_ptr<Tests::LoopbackSession> CreateSnapshotSession(Context* context, unsigned numClients)
+{
+    auto session = ea::make_unique<Tests::LoopbackSession>(context, numClients, LoopbackLinkParams{});
+    for (LoopbackLink* link : session->links_)
+        link->GetClientConnection()->SetSnapshotReplication(true);
+    return session;
+}
+
+/// Create moving nodes.
+ea::vector<Node*> CreateNodes(Scene* scene, unsigned numNodes)
+{
+    ea::vector<Node*> nodes;
+    for (unsigned i = 0; i < numNodes; ++i)
+    {
+        Node* node = scene->CreateChild();
+        node->SetPosition({ static_cast<float>(i), 0.0f, 0.0f });
+        nodes.push_back(node);
+    }
+    return nodes;
+}
+
+/// Move nodes, update session and return number of bytes sent to the first client.
+unsigned long long RunTick(Tests::LoopbackSession& session, const ea::vector<Node*>& nodes, unsigned tick)
+{
+    for (Node* node : nodes)
+    {
+        Vector3 position = node->GetPosition();
+        position.y_ = static_cast<float>(tick);
+        node->SetPosition(position);
+    }
+
+    const LoopbackLinkStats& stats = session.links_[0]->GetStats(LoopbackLink::TO_CLIENT);
+    const unsigned long long numBytesSent = stats.numBytesSent_;
+    session.UpdateServer(session.serverScene_->GetSubsystem<WorkQueue>());
+    session.UpdateClientsAndLinks(1.0f / 30.0f);
+    return stats.numBytesSent_ - numBytesSent;
+}
+
+/// Return whether the client has received latest positions of all nodes.
+bool IsClientUpToDate(Scene* clientScene, const ea::vector<Node*>& nodes)
+{
+    for (Node* node : nodes)
+    {
+        Node* clientNode = clientScene->GetNode(node->GetID());
+        if (!clientNode || clientNode->GetComponent<SmoothedTransform>()->GetTargetPosition() != node->GetPosition())
+            return false;
+    }
+    return true;
+}
+
+/// Pass snapshot acknowledgement to the server side of the connection directly.
+void AckSnapshot(Connection* connection, unsigned snapshotID)
+{
+    VectorBuffer packet;
+    packet.WriteUInt(MSG_SNAPSHOTACK);
+    packet.WriteUInt(sizeof(unsigned));
+    packet.WriteUInt(snapshotID);
+    MemoryBuffer buffer(packet.GetData(), packet.GetSize());
+    connection->ProcessMessage(MSG_PACKED_MESSAGE, buffer);
+}
+
+}
+
+TEST_CASE("Server tracks snapshots acknowledged by client")
+{
+    auto context = Tests::CreateCompleteTestContext();
+    auto session = CreateSnapshotSession(context, 1);
+    LoopbackLink* link = session->links_[0];
+    Connection* connection = link->GetClientConnection();
+    const ea::vector<Node*> nodes = CreateNodes(session->serverScene_, 10);
+
+    unsigned tick = 0;
+    for (; tick < 10; ++tick)
+        RunTick(*session, nodes, tick);
+    REQUIRE(session->AreClientsReady());
+
+    // Snapshot is acknowledged after round trip
+    RunTick(*session, nodes, tick++);
+    const unsigned snapshotID = connection->GetSnapshotID();
+    REQUIRE_FALSE(connection->IsSnapshotAcked(snapshotID));
+    RunTick(*session, nodes, tick++);
+    RunTick(*session, nodes, tick++);
+    REQUIRE(connection->IsSnapshotAcked(snapshotID));
+    REQUIRE(IsClientUpToDate(session->clientScenes_[0], nodes));
+
+    // Snapshots are not acknowledged if acknowledgements are lost
+    link->SetDropUnreliablePackets(LoopbackLink::TO_SERVER, true);
+    const unsigned firstLostSnapshotID = connection->GetSnapshotID() + 1;
+    for (unsigned i = 0; i < 5; ++i)
+        RunTick(*session, nodes, tick++);
+    for (unsigned snapshotID = firstLostSnapshotID; snapshotID <= connection->GetSnapshotID(); ++snapshotID)
+        REQUIRE_FALSE(connection->IsSnapshotAcked(snapshotID));
+    REQUIRE(IsClientUpToDate(session->clientScenes_[0], nodes));
+}
+
+TEST_CASE("Snapshot acknowledgements are tracked in ring buffer")
+{
+    auto context = Tests::CreateCompleteTestContext();
+    auto session = CreateSnapshotSession(context, 1);
+    LoopbackLink* link = session->links_[0];
+    Connection* connection = link->GetClientConnection();
+    const ea::vector<Node*> nodes = CreateNodes(session->serverScene_, 1);
+
+    link->SetDropUnreliablePackets(LoopbackLink::TO_SERVER, true);
+    unsigned tick = 0;
+    while (connection->GetSnapshotID() < 2 * MAX_ACKED_SNAPSHOTS)
+        RunTick(*session, nodes, tick++);
+
+    // Acknowledgements of snapshots too old or not sent yet are ignored
+    const unsigned latestSnapshotID = connection->GetSnapshotID();
+    const unsigned oldestSnapshotID = latestSnapshotID - MAX_ACKED_SNAPSHOTS + 1;
+    AckSnapshot(connection, oldestSnapshotID - 1);
+    AckSnapshot(connection, latestSnapshotID + 1);
+    REQUIRE_FALSE(connection->IsSnapshotAcked(oldestSnapshotID - 1));
+    REQUIRE_FALSE(connection->IsSnapshotAcked(latestSnapshotID + 1));
+
+    AckSnapshot(connection, oldestSnapshotID);
+    AckSnapshot(connection, latestSnapshotID);
+    REQUIRE(connection->IsSnapshotAcked(oldestSnapshotID));
+    REQUIRE(connection->IsSnapshotAcked(latestSnapshotID));
+
+    // Newer acknowledgement replaces the one that is MAX_ACKED_SNAPSHOTS older
+    RunTick(*session, nodes, tick++);
+    REQUIRE(connection->GetSnapshotID() == oldestSnapshotID + MAX_ACKED_SNAPSHOTS);
+    AckSnapshot(connection, oldestSnapshotID + MAX_ACKED_SNAPSHOTS);
+    REQUIRE(connection->IsSnapshotAcked(oldestSnapshotID + MAX_ACKED_SNAPSHOTS));
+    REQUIRE_FALSE(connection->IsSnapshotAcked(oldestSnapshotID));
+    REQUIRE(connection->IsSnapshotAcked(latestSnapshotID));
+}
+
+TEST_CASE("Snapshot replication falls back to full data when acknowledgements are lost")
+{
+    static const unsigned numNodes = 100;
+    static const unsigned numMeasuredTicks = 10;
+
+    auto context = Tests::CreateCompleteTestContext();
+    auto session = CreateSnapshotSession(context, 1);
+    LoopbackLink* link = session->links_[0];
+    Scene* clientScene = session->clientScenes_[0];
+    const ea::vector<Node*> nodes = CreateNodes(session->serverScene_, numNodes);
+
+    unsigned tick = 0;
+    for (; tick < 10; ++tick)
+        RunTick(*session, nodes, tick);
+    REQUIRE(session->AreClientsReady());
+
+    // Deltas against acknowledged snapshots
+    unsigned long long deltaBytes = 0;
+    for (unsigned i = 0; i < numMeasuredTicks; ++i)
+    {
+        deltaBytes += RunTick(*session, nodes, tick++);
+        REQUIRE(IsClientUpToDate(clientScene, nodes));
+    }
+
+    // Acknowledged snapshot is eventually dropped from history, so full data is sent
+    link->SetDropUnreliablePackets(LoopbackLink::TO_SERVER, true);
+    for (unsigned i = 0; i < SnapshotHistory::MAX_ENTRIES; ++i)
+    {
+        RunTick(*session, nodes, tick++);
+        REQUIRE(IsClientUpToDate(clientScene, nodes));
+    }
+
+    unsigned long long fullBytes = 0;
+    for (unsigned i = 0; i < numMeasuredTicks; ++i)
+    {
+        fullBytes += RunTick(*session, nodes, tick++);
+        REQUIRE(IsClientUpToDate(clientScene, nodes));
+    }
+    REQUIRE(fullBytes > deltaBytes);
+
+    // Deltas are used again when acknowledgements arrive
+    link->SetDropUnreliablePackets(LoopbackLink::TO_SERVER, false);
+    for (unsigned i = 0; i < 5; ++i)
+        RunTick(*session, nodes, tick++);
+
+    unsigned long long restoredDeltaBytes = 0;
+    for (unsigned i = 0; i < numMeasuredTicks; ++i)
+    {
+        restoredDeltaBytes += RunTick(*session, nodes, tick++);
+        REQUIRE(IsClientUpToDate(clientScene, nodes));
+    }
+    REQUIRE(restoredDeltaBytes < fullBytes);
+}
+
+#endif
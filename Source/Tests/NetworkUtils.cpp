@@ -0,0 +1,90 @@
+//
+// Copyright (c) 2017-2021 the rbfx project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "NetworkUtils.h"
+
+#if URHO3D_NETWORK
+
+#include <Urho3D/Core/WorkQueue.h>
+#include <Urho3D/Network/Connection.h>
+#include <Urho3D/Network/InterestManager.h>
+
+namespace Tests
+{
+
+LoopbackSession::LoopbackSession(Context* context, unsigned numClients, const LoopbackLinkParams& params)
+{
+    serverScene_ = MakeShared<Scene>(context);
+    for (unsigned i = 0; i < numClients; ++i)
+    {
+        auto link = MakeShared<LoopbackLink>(context, params, i);
+        auto clientScene = MakeShared<Scene>(context);
+        link->GetServerConnection()->SetScene(clientScene);
+        link->GetClientConnection()->SetScene(serverScene_);
+        links_.push_back(link);
+        clientScenes_.push_back(clientScene);
+    }
+}
+
+void LoopbackSession::UpdateServer(WorkQueue* workQueue)
+{
+    serverScene_->PrepareNetworkUpdate();
+    if (auto interestManager = serverScene_->GetComponent<InterestManager>())
+        interestManager->Update();
+
+    connections_.clear();
+    for (LoopbackLink* link : links_)
+        connections_.push_back(link->GetClientConnection());
+
+    ForEachParallel(workQueue, 1, connections_,
+        [](unsigned /*index*/, Connection* connection) { connection->BuildServerUpdate(); });
+
+    for (Connection* connection : connections_)
+    {
+        connection->FinishServerUpdate();
+        connection->SendAllBuffers();
+    }
+}
+
+void LoopbackSession::UpdateClientsAndLinks(float timeStep)
+{
+    for (LoopbackLink* link : links_)
+    {
+        link->GetServerConnection()->SendClientUpdate();
+        link->GetServerConnection()->SendAllBuffers();
+        link->Update(timeStep);
+    }
+}
+
+bool LoopbackSession::AreClientsReady() const
+{
+    for (LoopbackLink* link : links_)
+    {
+        if (!link->GetClientConnection()->IsSceneLoaded())
+            return false;
+    }
+    return true;
+}
+
+}
+
+#endif
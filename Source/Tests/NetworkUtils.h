@@ -0,0 +1,63 @@
+//
+// Copyright (c) 2017-2021 the rbfx project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "CommonUtils.h"
+
+#if URHO3D_NETWORK
+
+#include <Urho3D/Network/LoopbackTransport.h>
+#include <Urho3D/Scene/Scene.h>
+
+namespace Urho3D
+{
+
+class WorkQueue;
+
+}
+
+namespace Tests
+{
+
+/// Server scene and loopback clients updated with fixed time step.
+struct LoopbackSession
+{
+    /// Construct server scene and clients connected via loopback links.
+    LoopbackSession(Context* context, unsigned numClients, const LoopbackLinkParams& params);
+
+    /// Build and send server update for all clients.
+    void UpdateServer(WorkQueue* workQueue);
+    /// Send client updates and advance links.
+    void UpdateClientsAndLinks(float timeStep);
+    /// Return whether all clients have loaded the scene.
+    bool AreClientsReady() const;
+
+    SharedPtr<Scene> serverScene_;
+    ea::vector<SharedPtr<LoopbackLink>> links_;
+    ea::vector<SharedPtr<Scene>> clientScenes_;
+    ea::vector<Connection*> connections_;
+};
+
+}
+
+#endif
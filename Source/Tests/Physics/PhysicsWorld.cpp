@@ -0,0 +1,277 @@
+//
+// Copyright (c) 2017-2021 the rbfx project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "../CommonUtils.h"
+
+#if URHO3D_PHYSICS
+
+#include <Urho3D/Core/StringUtils.h>
+#include <Urho3D/Core/Timer.h>
+#include <Urho3D/Core/WorkQueue.h>
+#include <Urho3D/Math/RandomEngine.h>
+#include <Urho3D/Physics/CollisionShape.h>
+#include <Urho3D/Physics/PhysicsEvents.h>
+#include <Urho3D/Physics/PhysicsWorld.h>
+#include <Urho3D/Physics/RigidBody.h>
+#include <Urho3D/Scene/Scene.h>
+
+namespace
+{
+
+/// Create scene with a grid of box stacks on static floor.
+SharedPtr<Scene> CreateStackScene(Context* context, bool multiThreaded, unsigned maxThreads,
+    unsigned gridSize, unsigned stackHeight, ea::vector<Node*>& boxes)
+{
+    PhysicsWorld::config.multiThreaded_ = multiThreaded;
+    PhysicsWorld::config.maxThreads_ = maxThreads;
+    auto scene = MakeShared<Scene>(context);
+    scene->CreateComponent<PhysicsWorld>();
+    PhysicsWorld::config = PhysicsWorldConfig{};
+
+    Node* floorNode = scene->CreateChild("Floor");
+    floorNode->SetPosition({ 0.0f, -0.5f, 0.0f });
+    floorNode->SetScale({ 1000.0f, 1.0f, 1000.0f });
+    floorNode->CreateComponent<RigidBody>();
+    floorNode->CreateComponent<CollisionShape>()->SetBox(Vector3::ONE);
+
+    boxes.clear();
+    for (unsigned x = 0; x < gridSize; ++x)
+    {
+        for (unsigned z = 0; z < gridSize; ++z)
+        {
+            for (unsigned y = 0; y < stackHeight; ++y)
+            {
+                Node* boxNode = scene->CreateChild("Box");
+                boxNode->SetPosition({ x * 3.0f, y * 1.05f + 0.5f, z * 3.0f });
+                boxNode->SetRotation({ y * 7.0f, Vector3::UP });
+
+                auto body = boxNode->CreateComponent<RigidBody>();
+                body->SetMass(1.0f);
+                body->SetFriction(1.0f);
+                boxNode->CreateComponent<CollisionShape>()->SetBox(Vector3::ONE);
+                boxes.push_back(boxNode);
+            }
+        }
+    }
+    return scene;
+}
+
+/// Create random queries directed down towards the box stacks.
+ea::vector<PhysicsRaycastQuery> CreateRandomQueries(unsigned numQueries, float gridExtent, float radius)
+{
+    RandomEngine engine(0);
+    ea::vector<PhysicsRaycastQuery> queries(numQueries);
+    for (PhysicsRaycastQuery& query : queries)
+    {
+        const Vector3 origin{ engine.GetFloat(-1.0f, gridExtent), 20.0f, engine.GetFloat(-1.0f, gridExtent) };
+        const Vector3 target{ engine.GetFloat(-1.0f, gridExtent), 0.0f, engine.GetFloat(-1.0f, gridExtent) };
+        query.ray_ = Ray(origin, target - origin);
+        query.maxDistance_ = 30.0f;
+        query.radius_ = radius;
+    }
+    return queries;
+}
+
+}
+
+TEST_CASE("Multithreaded physics world doesn't depend on number of threads")
+{
+    auto context = Tests::CreateCompleteTestContext();
+    Tests::RecreateWorkQueue(context, 3);
+
+    ea::vector<Node*> singleThreadBoxes;
+    ea::vector<Node*> multiThreadBoxes;
+    auto singleThreadScene = CreateStackScene(context, true, 1, 4, 5, singleThreadBoxes);
+    auto multiThreadScene = CreateStackScene(context, true, 4, 4, 5, multiThreadBoxes);
+
+    auto singleThreadWorld = singleThreadScene->GetComponent<PhysicsWorld>();
+    auto multiThreadWorld = multiThreadScene->GetComponent<PhysicsWorld>();
+#if BT_THREADSAFE
+    REQUIRE(multiThreadWorld->IsMultiThreaded());
+#endif
+
+    unsigned numCollisions = 0;
+    multiThreadScene->SubscribeToEvent(multiThreadWorld, E_PHYSICSCOLLISION,
+        [&](StringHash, VariantMap&) { ++numCollisions; });
+
+    for (unsigned i = 0; i < 60; ++i)
+    {
+        singleThreadWorld->Update(1.0f / 60.0f);
+        multiThreadWorld->Update(1.0f / 60.0f);
+    }
+
+    REQUIRE(numCollisions > 0);
+    for (unsigned i = 0; i < singleThreadBoxes.size(); ++i)
+    {
+        const Vector3 expectedPosition = singleThreadBoxes[i]->GetWorldPosition();
+        const Vector3 actualPosition = multiThreadBoxes[i]->GetWorldPosition();
+        REQUIRE(expectedPosition == actualPosition);
+    }
+}
+
+TEST_CASE("Physics world fills contact stream")
+{
+    auto context = Tests::CreateCompleteTestContext();
+    ea::vector<Node*> boxes;
+    auto scene = CreateStackScene(context, false, 0, 1, 1, boxes);
+    auto physicsWorld = scene->GetComponent<PhysicsWorld>();
+    auto boxBody = boxes[0]->GetComponent<RigidBody>();
+
+    unsigned numStartEvents = 0;
+    scene->SubscribeToEvent(physicsWorld, E_PHYSICSCOLLISIONSTART, [&](StringHash, VariantMap&) { ++numStartEvents; });
+
+    // Box is resting on the floor
+    physicsWorld->Update(1.0f / 60.0f);
+    REQUIRE(physicsWorld->GetCollisions().size() == 1);
+    REQUIRE(physicsWorld->GetCollisionIndices(boxBody).size() == 1);
+
+    const RigidBodyCollision& collision = physicsWorld->GetCollisions()[0];
+    const float normalSign = collision.bodyA_ == boxBody ? 1.0f : -1.0f;
+    REQUIRE(collision.started_);
+    REQUIRE_FALSE(physicsWorld->GetContacts(collision).empty());
+    for (const PhysicsContact& contact : physicsWorld->GetContacts(collision))
+        REQUIRE(contact.normal_.y_ * normalSign > 0.9f);
+    REQUIRE(numStartEvents == 1);
+
+    physicsWorld->Update(1.0f / 60.0f);
+    REQUIRE(physicsWorld->GetCollisions().size() == 1);
+    REQUIRE_FALSE(physicsWorld->GetCollisions()[0].started_);
+    REQUIRE(numStartEvents == 1);
+
+    // Lift the box to end the collision
+    boxes[0]->SetPosition({ 0.0f, 10.0f, 0.0f });
+    physicsWorld->Update(1.0f / 60.0f);
+    REQUIRE(physicsWorld->GetCollisions().empty());
+    REQUIRE(physicsWorld->GetEndedCollisions().size() == 1);
+    REQUIRE(physicsWorld->GetCollisionIndices(boxBody).empty());
+
+    // Removed body is reset in the stream
+    boxes[0]->SetPosition({ 0.0f, 0.5f, 0.0f });
+    physicsWorld->SetCollisionEventsEnabled(false);
+    physicsWorld->Update(1.0f / 60.0f);
+    REQUIRE(physicsWorld->GetCollisions().size() == 1);
+    REQUIRE(numStartEvents == 1);
+
+    boxes[0]->Remove();
+    REQUIRE(physicsWorld->GetCollisions()[0].bodyA_ == nullptr);
+    REQUIRE(physicsWorld->GetCollisions()[0].bodyB_ == nullptr);
+}
+
+TEST_CASE("Physics raycast batch returns the same hits as single raycasts")
+{
+    auto context = Tests::CreateCompleteTestContext();
+    Tests::RecreateWorkQueue(context, 3);
+
+    ea::vector<Node*> boxes;
+    auto scene = CreateStackScene(context, false, 0, 4, 3, boxes);
+    auto physicsWorld = scene->GetComponent<PhysicsWorld>();
+    physicsWorld->UpdateCollisions();
+
+    for (const float radius : { 0.0f, 0.25f })
+    {
+        const auto queries = CreateRandomQueries(200, 12.0f, radius);
+        ea::vector<PhysicsRaycastResult> results(queries.size());
+        physicsWorld->RaycastSingleBatch(queries, results);
+
+        for (unsigned i = 0; i < queries.size(); ++i)
+        {
+            const PhysicsRaycastQuery& query = queries[i];
+            PhysicsRaycastResult expected;
+            if (radius > 0.0f)
+                physicsWorld->SphereCast(expected, query.ray_, query.radius_, query.maxDistance_, query.collisionMask_);
+            else
+                physicsWorld->RaycastSingle(expected, query.ray_, query.maxDistance_, query.collisionMask_);
+
+            REQUIRE(results[i].body_ != nullptr);
+            REQUIRE(results[i].body_ == expected.body_);
+            REQUIRE(results[i].distance_ == expected.distance_);
+        }
+    }
+}
+
+TEST_CASE("Physics raycast batch benchmark", "[.benchmark]")
+{
+    static const unsigned numQueries = 10000;
+    static const unsigned numIterations = 20;
+    static const unsigned gridSize = 32;
+
+    auto context = Tests::CreateCompleteTestContext();
+    Tests::RecreateWorkQueue(context, 15);
+
+    ea::vector<Node*> boxes;
+    auto scene = CreateStackScene(context, false, 0, gridSize, 4, boxes);
+    auto physicsWorld = scene->GetComponent<PhysicsWorld>();
+    physicsWorld->UpdateCollisions();
+
+    const auto queries = CreateRandomQueries(numQueries, gridSize * 3.0f, 0.0f);
+    ea::vector<PhysicsRaycastResult> results(queries.size());
+
+    HiresTimer timer;
+    for (unsigned iteration = 0; iteration < numIterations; ++iteration)
+    {
+        for (unsigned i = 0; i < queries.size(); ++i)
+            physicsWorld->RaycastSingle(results[i], queries[i].ray_, queries[i].maxDistance_, queries[i].collisionMask_);
+    }
+    const long long loopTime = timer.GetUSec(true);
+
+    for (unsigned iteration = 0; iteration < numIterations; ++iteration)
+        physicsWorld->RaycastSingleBatch(queries, results);
+    const long long batchTime = timer.GetUSec(true);
+
+    WARN(Format("{} raycasts against {} boxes\nRaycastSingle loop: {:>8} us\nRaycastSingleBatch: {:>8} us",
+        numQueries, boxes.size(), loopTime / numIterations, batchTime / numIterations).c_str());
+}
+
+TEST_CASE("Physics stress benchmark", "[.benchmark]")
+{
+    static const unsigned numWarmupSteps = 30;
+    static const unsigned numSteps = 300;
+    static const unsigned gridSize = 16;
+    static const unsigned stackHeight = 10;
+    static const unsigned threadCounts[] = { 1, 4, 16 };
+
+    auto context = Tests::CreateCompleteTestContext();
+    Tests::RecreateWorkQueue(context, 15);
+
+    ea::string report = Format("{} boxes in {} stacks\n", gridSize * gridSize * stackHeight, gridSize * gridSize);
+    ea::vector<Node*> boxes;
+    for (unsigned numThreads : threadCounts)
+    {
+        auto scene = CreateStackScene(context, numThreads > 1, numThreads, gridSize, stackHeight, boxes);
+        auto physicsWorld = scene->GetComponent<PhysicsWorld>();
+
+        HiresTimer timer;
+        long long elapsed = 0;
+        for (unsigned i = 0; i < numWarmupSteps + numSteps; ++i)
+        {
+            timer.Reset();
+            physicsWorld->Update(1.0f / 60.0f);
+            if (i >= numWarmupSteps)
+                elapsed += timer.GetUSec(false);
+        }
+
+        report += Format("{:>2} threads: {:>8} us/step\n", numThreads, elapsed / numSteps);
+    }
+    WARN(report.c_str());
+}
+
+#endif
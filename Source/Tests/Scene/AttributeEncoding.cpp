@@ -0,0 +1,174 @@
+//
+// Copyright (c) 2017-2021 the rbfx project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "../CommonUtils.h"
+
+#include <Urho3D/Core/StringUtils.h>
+#include <Urho3D/Core/Timer.h>
+#include <Urho3D/IO/BitStream.h>
+#include <Urho3D/IO/MemoryBuffer.h>
+#include <Urho3D/IO/VectorBuffer.h>
+#include <Urho3D/Math/RandomEngine.h>
+#include <Urho3D/Scene/AttributeEncoding.h>
+
+namespace
+{
+
+AttributeInfo CreateAttribute(VariantType type, const AttributeNetworkEncoding& encoding)
+{
+    AttributeInfo attr(type, "Test", nullptr, nullptr, Variant::EMPTY, AM_NET);
+    attr.networkEncoding_ = encoding;
+    return attr;
+}
+
+Variant EncodeDecode(const AttributeInfo& attr, const Variant& value, unsigned* encodedSize = nullptr)
+{
+    VectorBuffer encoded;
+    WriteNetworkAttribute(encoded, attr, value);
+    if (encodedSize)
+        *encodedSize = encoded.GetSize();
+
+    MemoryBuffer source(encoded.GetBuffer());
+    const Variant decoded = ReadNetworkAttribute(source, attr);
+    REQUIRE(source.IsEof());
+    return decoded;
+}
+
+}
+
+TEST_CASE("Bit stream is read in the same order as written")
+{
+    VectorBuffer buffer;
+    {
+        BitWriter writer(buffer);
+        writer.WriteBits(5, 3);
+        writer.WriteBit(true);
+        writer.WriteBits(0xabcdef12, 32);
+        writer.WriteBits(0x1ff, 9);
+        REQUIRE(writer.GetNumBits() == 45);
+    }
+    REQUIRE(buffer.GetSize() == 6);
+
+    MemoryBuffer source(buffer.GetBuffer());
+    BitReader reader(source);
+    REQUIRE(reader.ReadBits(3) == 5);
+    REQUIRE(reader.ReadBit());
+    REQUIRE(reader.ReadBits(32) == 0xabcdef12);
+    REQUIRE(reader.ReadBits(9) == 0x1ff);
+    REQUIRE_FALSE(reader.IsOverrun());
+    REQUIRE(reader.ReadBits(8) == 0);
+    REQUIRE(reader.IsOverrun());
+}
+
+TEST_CASE("Compact attribute encodings preserve values within precision")
+{
+    unsigned encodedSize{};
+
+    const auto position = CreateAttribute(VAR_VECTOR3, AttributeNetworkEncoding::Quantized(-512.0f, 512.0f, 16));
+    const Vector3 positionValue{ 100.25f, -3.5f, 511.0f };
+    const Vector3 decodedPosition = EncodeDecode(position, positionValue, &encodedSize).GetVector3();
+    REQUIRE(encodedSize == 6);
+    REQUIRE(decodedPosition.Equals(positionValue, 1024.0f / 65535.0f));
+    REQUIRE(EncodeDecode(position, Vector3(1000.0f, 0.0f, 0.0f)).GetVector3().x_ == 512.0f);
+
+    const auto rotation = CreateAttribute(VAR_QUATERNION, AttributeNetworkEncoding::SmallestThree(15));
+    RandomEngine engine(0);
+    for (unsigned i = 0; i < 100; ++i)
+    {
+        const Quaternion rotationValue = engine.GetQuaternion();
+        const Quaternion decodedRotation = EncodeDecode(rotation, rotationValue, &encodedSize).GetQuaternion();
+        REQUIRE(encodedSize == 6);
+        REQUIRE(Abs(decodedRotation.DotProduct(rotationValue)) > 0.9999f);
+    }
+
+    const auto index = CreateAttribute(VAR_INT, AttributeNetworkEncoding::Bits(-10, 100));
+    REQUIRE(index.networkEncoding_.bits_ == 7);
+    REQUIRE(EncodeDecode(index, -10, &encodedSize).GetInt() == -10);
+    REQUIRE(encodedSize == 1);
+    REQUIRE(EncodeDecode(index, 100).GetInt() == 100);
+    REQUIRE(EncodeDecode(index, 1000).GetInt() == 100);
+
+    // Range doesn't fit into int
+    const int wideLimit = 1 << 30;
+    const auto wideIndex = CreateAttribute(VAR_INT, AttributeNetworkEncoding::Bits(-wideLimit, wideLimit));
+    REQUIRE(wideIndex.networkEncoding_.bits_ == 32);
+    REQUIRE(EncodeDecode(wideIndex, -wideLimit, &encodedSize).GetInt() == -wideLimit);
+    REQUIRE(encodedSize == 4);
+    REQUIRE(EncodeDecode(wideIndex, 12345).GetInt() == 12345);
+    REQUIRE(EncodeDecode(wideIndex, wideLimit).GetInt() == wideLimit);
+
+    const auto fallback = CreateAttribute(VAR_STRING, AttributeNetworkEncoding::Quantized(0.0f, 1.0f, 8));
+    REQUIRE(EncodeDecode(fallback, "Text").GetString() == "Text");
+}
+
+TEST_CASE("Compact attribute encoding benchmark", "[.benchmark]")
+{
+    static const unsigned numValues = 100000;
+
+    const auto defaultPosition = CreateAttribute(VAR_VECTOR3, {});
+    const auto defaultRotation = CreateAttribute(VAR_QUATERNION, {});
+    const auto compactPosition = CreateAttribute(VAR_VECTOR3, AttributeNetworkEncoding::Quantized(-1024.0f, 1024.0f, 18));
+    const auto compactRotation = CreateAttribute(VAR_QUATERNION, AttributeNetworkEncoding::SmallestThree(15));
+
+    RandomEngine engine(0);
+    const BoundingBox box{ -Vector3::ONE * 1000.0f, Vector3::ONE * 1000.0f };
+    ea::vector<Variant> positions;
+    ea::vector<Variant> rotations;
+    for (unsigned i = 0; i < numValues; ++i)
+    {
+        positions.push_back(engine.GetVector3(box));
+        rotations.push_back(engine.GetQuaternion());
+    }
+
+    const auto measure = [&](const AttributeInfo& positionAttr, const AttributeInfo& rotationAttr)
+    {
+        HiresTimer timer;
+        VectorBuffer buffer;
+        for (unsigned i = 0; i < numValues; ++i)
+        {
+            WriteNetworkAttribute(buffer, positionAttr, positions[i]);
+            WriteNetworkAttribute(buffer, rotationAttr, rotations[i]);
+        }
+        const long long writeTime = timer.GetUSec(true);
+
+        float maxPositionError = 0.0f;
+        float minRotationDot = 1.0f;
+        MemoryBuffer source(buffer.GetBuffer());
+        for (unsigned i = 0; i < numValues; ++i)
+        {
+            const Vector3 position = ReadNetworkAttribute(source, positionAttr).GetVector3();
+            const Quaternion rotation = ReadNetworkAttribute(source, rotationAttr).GetQuaternion();
+            maxPositionError = ea::max(maxPositionError, (position - positions[i].GetVector3()).Length());
+            minRotationDot = ea::min(minRotationDot, Abs(rotation.DotProduct(rotations[i].GetQuaternion())));
+        }
+        const long long readTime = timer.GetUSec(true);
+
+        REQUIRE(source.IsEof());
+        return Format("{:>6.2f} bytes/transform, write {:>6} us, read {:>6} us, max position error {:.4f}, min rotation dot {:.6f}\n",
+            static_cast<float>(buffer.GetSize()) / numValues, writeTime, readTime, maxPositionError, minRotationDot);
+    };
+
+    ea::string report = Format("{} transforms\n", numValues);
+    report += "Default: " + measure(defaultPosition, defaultRotation);
+    report += "Compact: " + measure(compactPosition, compactRotation);
+    WARN(report.c_str());
+}
@@ -0,0 +1,185 @@
+//
+// Copyright (c) 2017-2021 the rbfx project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "../CommonUtils.h"
+
+#include <Urho3D/Core/StringUtils.h>
+#include <Urho3D/Core/Timer.h>
+#include <Urho3D/Core/WorkQueue.h>
+#include <Urho3D/Graphics/Light.h>
+#include <Urho3D/IO/File.h>
+#include <Urho3D/IO/FileSystem.h>
+#include <Urho3D/Scene/Scene.h>
+
+namespace
+{
+
+enum class SceneFormat
+{
+    Binary,
+    XML,
+    JSON
+};
+
+/// Save scene to file in specified format.
+void SaveScene(Scene* scene, const ea::string& fileName, SceneFormat format)
+{
+    File file(scene->GetContext(), fileName, FILE_WRITE);
+    if (format == SceneFormat::Binary)
+        REQUIRE(scene->Save(file));
+    else if (format == SceneFormat::XML)
+        REQUIRE(scene->SaveXML(file));
+    else
+        REQUIRE(scene->SaveJSON(file));
+}
+
+/// Start async loading of the scene from file in specified format.
+bool StartAsyncLoading(Scene* scene, File* file, SceneFormat format)
+{
+    if (format == SceneFormat::Binary)
+        return scene->LoadAsync(file);
+    else if (format == SceneFormat::XML)
+        return scene->LoadAsyncXML(file);
+    else
+        return scene->LoadAsyncJSON(file);
+}
+
+/// Update scene until async loading is finished. Return max time of single update in microseconds.
+long long WaitForAsyncLoading(Scene* scene)
+{
+    auto workQueue = scene->GetSubsystem<WorkQueue>();
+    long long maxUpdateTime = 0;
+    while (scene->IsAsyncLoading())
+    {
+        // Without worker threads the file is parsed on the main thread, don't count it as update time
+        if (workQueue->GetNumThreads() == 0)
+            workQueue->Complete(0);
+
+        HiresTimer timer;
+        scene->Update(0.0f);
+        maxUpdateTime = ea::max(maxUpdateTime, timer.GetUSec(false));
+    }
+    return maxUpdateTime;
+}
+
+}
+
+TEST_CASE("Scene is loaded asynchronously from binary, XML and JSON files")
+{
+    auto context = Tests::CreateCompleteTestContext();
+    auto fileSystem = context->GetSubsystem<FileSystem>();
+    const ea::string fileName = fileSystem->GetTemporaryDir() + "AsyncSceneLoadingTest.scene";
+
+    auto scene = MakeShared<Scene>(context);
+    scene->SetTimeScale(0.5f);
+    for (unsigned i = 0; i < 10; ++i)
+    {
+        Node* node = scene->CreateChild(Format("Node {}", i));
+        node->SetPosition(Vector3(static_cast<float>(i), 0.0f, 0.0f));
+
+        Node* childNode = node->CreateChild("Child");
+        childNode->CreateChild("Grandchild")->SetVar("Index", i);
+
+        auto light = childNode->CreateComponent<Light>();
+        light->SetLightType(LIGHT_SPOT);
+        light->SetRange(static_cast<float>(i + 1));
+    }
+
+    for (SceneFormat format : { SceneFormat::Binary, SceneFormat::XML, SceneFormat::JSON })
+    {
+        SaveScene(scene, fileName, format);
+
+        auto loadedScene = MakeShared<Scene>(context);
+        auto file = MakeShared<File>(context, fileName);
+        REQUIRE(StartAsyncLoading(loadedScene, file, format));
+        WaitForAsyncLoading(loadedScene);
+
+        REQUIRE(loadedScene->GetTimeScale() == 0.5f);
+        REQUIRE(loadedScene->GetNumChildren() == 10);
+        for (unsigned i = 0; i < 10; ++i)
+        {
+            Node* node = loadedScene->GetChild(Format("Node {}", i));
+            REQUIRE(node);
+            REQUIRE(node->GetPosition() == Vector3(static_cast<float>(i), 0.0f, 0.0f));
+
+            Node* childNode = node->GetChild("Child");
+            REQUIRE(childNode);
+            REQUIRE(childNode->GetChild("Grandchild"));
+            REQUIRE(childNode->GetChild("Grandchild")->GetVar("Index") == Variant(i));
+
+            auto light = childNode->GetComponent<Light>();
+            REQUIRE(light);
+            REQUIRE(light->GetLightType() == LIGHT_SPOT);
+            REQUIRE(light->GetRange() == static_cast<float>(i + 1));
+        }
+    }
+
+    fileSystem->Delete(fileName);
+}
+
+TEST_CASE("Async scene loading benchmark", "[.benchmark]")
+{
+    auto context = Tests::CreateCompleteTestContext();
+    auto fileSystem = context->GetSubsystem<FileSystem>();
+    const ea::string fileName = fileSystem->GetTemporaryDir() + "AsyncSceneLoadingBenchmark.xml";
+
+    const unsigned numNodes = 50000;
+
+    // Create synthetic scene
+    auto scene = MakeShared<Scene>(context);
+    for (unsigned i = 0; i < numNodes; ++i)
+    {
+        Node* node = scene->CreateChild(Format("Node {}", i));
+        node->SetPosition(Vector3(static_cast<float>(i), 0.0f, 0.0f));
+        node->SetVar("Index", i);
+        node->CreateComponent<Light>()->SetRange(static_cast<float>(i % 100 + 1));
+    }
+    SaveScene(scene, fileName, SceneFormat::XML);
+
+    {
+        auto loadedScene = MakeShared<Scene>(context);
+        File file(context, fileName);
+
+        HiresTimer timer;
+        REQUIRE(loadedScene->LoadXML(file));
+        const long long elapsed = timer.GetUSec(false);
+
+        REQUIRE(loadedScene->GetNumChildren() == numNodes);
+        WARN(Format("Synchronous: {} nodes loaded in {} us on the main thread", numNodes, elapsed).c_str());
+    }
+
+    {
+        auto loadedScene = MakeShared<Scene>(context);
+        auto file = MakeShared<File>(context, fileName);
+
+        HiresTimer timer;
+        REQUIRE(loadedScene->LoadAsyncXML(file));
+        const long long maxUpdateTime = WaitForAsyncLoading(loadedScene);
+        const long long elapsed = timer.GetUSec(false);
+
+        REQUIRE(loadedScene->GetNumChildren() == numNodes);
+        WARN(Format("Asynchronous: {} nodes loaded in {} us, longest main thread update {} us (budget {} ms)",
+            numNodes, elapsed, maxUpdateTime, loadedScene->GetAsyncLoadingMs()).c_str());
+    }
+
+    fileSystem->Delete(fileName);
+}
@@ -0,0 +1,80 @@
+//
+// Copyright (c) 2017-2021 the rbfx project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR rhs
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR rhsWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR rhs DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "../CommonUtils.h"
+
+#include <Urho3D/Scene/Scene.h>
+#include <Urho3D/Scene/TransformHierarchy.h>
+
+TEST_CASE("Transform hierarchy matches lazily evaluated world transforms")
+{
+    auto context = Tests::CreateCompleteTestContext();
+
+    auto sceneBatched = MakeShared<Scene>(context);
+    auto sceneLazy = MakeShared<Scene>(context);
+    sceneBatched->SetTransformHierarchyEnabled(true);
+
+    // Build identical hierarchies
+    ea::vector<Node*> nodesBatched;
+    ea::vector<Node*> nodesLazy;
+    for (unsigned i = 0; i < 50; ++i)
+    {
+        Node* parentBatched = i % 5 == 0 ? sceneBatched.Get() : nodesBatched[i / 2];
+        Node* parentLazy = i % 5 == 0 ? sceneLazy.Get() : nodesLazy[i / 2];
+        nodesBatched.push_back(parentBatched->CreateChild());
+        nodesLazy.push_back(parentLazy->CreateChild());
+    }
+
+    const auto moveNodes = [](ea::vector<Node*>& nodes, unsigned iteration)
+    {
+        for (unsigned i = iteration % 3; i < nodes.size(); i += 3)
+        {
+            const float value = static_cast<float>(i + iteration);
+            nodes[i]->SetTransform(Vector3(value, -value, 0.5f * value),
+                Quaternion(10.0f * value, Vector3::UP), Vector3::ONE * (1.0f + 0.01f * value));
+        }
+    };
+
+    for (unsigned iteration = 0; iteration < 5; ++iteration)
+    {
+        moveNodes(nodesBatched, iteration);
+        moveNodes(nodesLazy, iteration);
+
+        // Reparent one node to check structure updates
+        if (iteration == 2)
+        {
+            nodesBatched[7]->SetParent(nodesBatched[40]);
+            nodesLazy[7]->SetParent(nodesLazy[40]);
+        }
+
+        sceneBatched->UpdateTransformHierarchy();
+
+        for (unsigned i = 0; i < nodesBatched.size(); ++i)
+        {
+            REQUIRE_FALSE(nodesBatched[i]->IsDirty());
+            REQUIRE(nodesBatched[i]->GetWorldTransform().Equals(nodesLazy[i]->GetWorldTransform()));
+            REQUIRE(nodesBatched[i]->GetWorldRotation().Equals(nodesLazy[i]->GetWorldRotation()));
+        }
+    }
+
+    REQUIRE(sceneBatched->GetTransformHierarchy()->GetNumNodes() == nodesBatched.size());
+}
@@ -27,6 +27,7 @@
 #include <Urho3D/Graphics/AnimatedModel.h>
 #include <Urho3D/Graphics/Animation.h>
 #include <Urho3D/Graphics/DebugRenderer.h>
+#include <Urho3D/Graphics/CompressedAnimation.h>
 #include <Urho3D/Graphics/Geometry.h>
 #include <Urho3D/Graphics/Graphics.h>
 #include <Urho3D/Graphics/IndexBuffer.h>
@@ -176,6 +177,7 @@ float defaultTicksPerSecond_ = 4800.0f;
 float importStartTime_ = 0.0f;
 float importEndTime_ = 0.0f;
 bool suppressFbxPivotNodes_ = true;
+bool compressAnimations_ = false;
 
 int main(int argc, char** argv);
 void Run(const ea::vector<ea::string>& arguments);
@@ -308,6 +310,7 @@ void Run(const ea::vector<ea::string>& arguments)
             "-split <start> <end> (animation model only)\n"
             "            Split animation, will only import from start frame to end frame\n"
             "-np         Do not suppress $fbx pivot nodes (FBX files only)\n"
+            "-ca         Store compressed animation tracks for faster playback\n"
         );
     }
 
@@ -463,6 +466,8 @@ void Run(const ea::vector<ea::string>& arguments)
                 checkUniqueModel_ = false;
             else if (argument == "bp")
                 moveToBindPose_ = true;
+            else if (argument == "ca")
+                compressAnimations_ = true;
             else if (argument == "split")
             {
                 ea::string value2 = i + 2 < arguments.size() ? arguments[i + 2] : EMPTY_STRING;
@@ -1499,6 +1504,17 @@ void BuildAndSaveAnimations(OutModel* model)
         File outFile(context_);
         if (!outFile.Open(animOutName, FILE_WRITE))
             ErrorExit("Could not open output file " + animOutName);
+
+        if (compressAnimations_)
+        {
+            outAnim->Compress(AnimationCompressionSettings{});
+
+            const CompressedAnimation* compressed = outAnim->GetCompressed();
+            const AnimationCompressionError error = compressed->MeasureError(*outAnim);
+            PrintLine(Format("Compressed animation to {} bytes, max error: position {:.5f}, rotation {:.3f} deg, scale {:.5f}",
+                compressed->GetMemoryUse(), error.maxPositionError_, error.maxRotationError_, error.maxScaleError_));
+        }
+
         outAnim->Save(outFile);
     }
 }
@@ -117,6 +117,7 @@ using namespace Urho3D;
 #endif
 
 #define URHO3D_TYPE_TRAIT(...)
+#define URHO3D_POOL_ALLOCATED()
 
 %apply void* VOID_INT_PTR {
 	SDL_Cursor*,
@@ -477,11 +478,16 @@ public:
 %ignore Urho3D::NodeReplicationState::dirtyVars_;		// Needs HashSet wrapped
 %ignore Urho3D::Animatable::animatedNetworkAttributes_; // Needs HashSet wrapped
 %ignore Urho3D::AsyncProgress::resources_;
+%ignore Urho3D::AsyncProgress::loader_;
+%ignore Urho3D::Serializable::LoadAttributeValues;
 %ignore Urho3D::ValueAnimation::GetKeyFrames;
 %ignore Urho3D::Serializable::networkState_;
 %ignore Urho3D::Serializable::instanceDefaultValues_;
 %ignore Urho3D::Serializable::temporary_;
 %ignore Urho3D::ReplicationState::connection_;
+%ignore Urho3D::NetworkState::serializedDeltas_;
+%ignore Urho3D::NetworkState::serializedDataMutex_;
+%ignore Urho3D::SnapshotHistory::entries_;
 %ignore Urho3D::Component::CleanupConnection;
 %ignore Urho3D::Scene::CleanupConnection;
 %ignore Urho3D::Node::CleanupConnection;
@@ -727,11 +733,15 @@ public:
 %ignore Urho3D::Network::GetConnection;
 %ignore Urho3D::Network::OnServerConnect;
 %ignore Urho3D::Network::HandleIncomingPacket;
+%ignore Urho3D::InterestManager::QueryRelevantNodes;
+%ignore Urho3D::InterestManager::FindEntry;
+%ignore Urho3D::Connection::GetTransport;
 
 %include "generated/Urho3D/_pre_network.i"
 %include "Urho3D/Network/Connection.h"
 %include "Urho3D/Network/Network.h"
 %include "Urho3D/Network/NetworkPriority.h"
+%include "Urho3D/Network/InterestManager.h"
 %include "Urho3D/Network/Protocol.h"
 
 %template(ConnectionVector) eastl::vector<Urho3D::SharedPtr<Urho3D::Connection>>;
@@ -91,7 +91,6 @@ using AttributeModeFlags = Urho3D::AttributeMode;
 %csattribute(Urho3D::WorkQueue, %arg(SharedPtr<Urho3D::WorkItem>), FreeItem, GetFreeItem);
 %csattribute(Urho3D::WorkQueue, %arg(unsigned int), NumThreads, GetNumThreads);
 %csattribute(Urho3D::WorkQueue, %arg(bool), IsCompleting, IsCompleting);
-%csattribute(Urho3D::WorkQueue, %arg(int), Tolerance, GetTolerance, SetTolerance);
 %csattribute(Urho3D::WorkQueue, %arg(int), NonThreadedWorkMs, GetNonThreadedWorkMs, SetNonThreadedWorkMs);
 %pragma(csharp) moduleimports=%{
 public static partial class E
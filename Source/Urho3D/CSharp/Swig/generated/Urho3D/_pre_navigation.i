@@ -36,6 +36,8 @@
 %csattribute(Urho3D::CrowdAgent, %arg(Urho3D::NavigationPushiness), NavigationPushiness, GetNavigationPushiness, SetNavigationPushiness);
 %csattribute(Urho3D::CrowdAgent, %arg(bool), IsInCrowd, IsInCrowd);
 %csattribute(Urho3D::NavigationMesh, %arg(ea::string), MeshName, GetMeshName, SetMeshName);
+%csattribute(Urho3D::NavigationMesh, %arg(unsigned int), NumPendingPathRequests, GetNumPendingPathRequests);
+%csattribute(Urho3D::NavigationMesh, %arg(unsigned int), MaxPathRequestTime, GetMaxPathRequestTime, SetMaxPathRequestTime);
 %csattribute(Urho3D::NavigationMesh, %arg(int), TileSize, GetTileSize, SetTileSize);
 %csattribute(Urho3D::NavigationMesh, %arg(float), CellSize, GetCellSize, SetCellSize);
 %csattribute(Urho3D::NavigationMesh, %arg(float), CellHeight, GetCellHeight, SetCellHeight);
@@ -120,6 +122,24 @@ public static partial class E
         public static implicit operator StringHash(NavigationAllTilesRemovedEvent e) { return e._event; }
     }
     public static NavigationAllTilesRemovedEvent NavigationAllTilesRemoved = new NavigationAllTilesRemovedEvent();
+    public class NavigationBuildProgressEvent {
+        private StringHash _event = new StringHash("NavigationBuildProgress");
+        public StringHash Node = new StringHash("Node");
+        public StringHash Mesh = new StringHash("Mesh");
+        public StringHash NumProcessed = new StringHash("NumProcessed");
+        public StringHash NumTotal = new StringHash("NumTotal");
+        public NavigationBuildProgressEvent() { }
+        public static implicit operator StringHash(NavigationBuildProgressEvent e) { return e._event; }
+    }
+    public static NavigationBuildProgressEvent NavigationBuildProgress = new NavigationBuildProgressEvent();
+    public class NavigationPathsFoundEvent {
+        private StringHash _event = new StringHash("NavigationPathsFound");
+        public StringHash Node = new StringHash("Node");
+        public StringHash Mesh = new StringHash("Mesh");
+        public NavigationPathsFoundEvent() { }
+        public static implicit operator StringHash(NavigationPathsFoundEvent e) { return e._event; }
+    }
+    public static NavigationPathsFoundEvent NavigationPathsFound = new NavigationPathsFoundEvent();
     public class CrowdAgentFormationEvent {
         private StringHash _event = new StringHash("CrowdAgentFormation");
         public StringHash Node = new StringHash("Node");
@@ -41,6 +41,8 @@
 %csattribute(Urho3D::PhysicsWorld, %arg(bool), SplitImpulse, GetSplitImpulse, SetSplitImpulse);
 %csattribute(Urho3D::PhysicsWorld, %arg(int), Fps, GetFps, SetFps);
 %csattribute(Urho3D::PhysicsWorld, %arg(float), MaxNetworkAngularVelocity, GetMaxNetworkAngularVelocity, SetMaxNetworkAngularVelocity);
+%csattribute(Urho3D::PhysicsWorld, %arg(bool), IsMultiThreaded, IsMultiThreaded);
+%csattribute(Urho3D::PhysicsWorld, %arg(bool), CollisionEventsEnabled, GetCollisionEventsEnabled, SetCollisionEventsEnabled);
 %csattribute(Urho3D::PhysicsWorld, %arg(btDiscreteDynamicsWorld *), World, GetWorld);
 %csattribute(Urho3D::PhysicsWorld, %arg(Urho3D::CollisionGeometryDataCache), TriMeshCache, GetTriMeshCache);
 %csattribute(Urho3D::PhysicsWorld, %arg(Urho3D::CollisionGeometryDataCache), ConvexCache, GetConvexCache);
@@ -140,6 +142,13 @@ public static partial class E
         public static implicit operator StringHash(PhysicsCollisionEndEvent e) { return e._event; }
     }
     public static PhysicsCollisionEndEvent PhysicsCollisionEnd = new PhysicsCollisionEndEvent();
+    public class PhysicsContactsEvent {
+        private StringHash _event = new StringHash("PhysicsContacts");
+        public StringHash World = new StringHash("World");
+        public PhysicsContactsEvent() { }
+        public static implicit operator StringHash(PhysicsContactsEvent e) { return e._event; }
+    }
+    public static PhysicsContactsEvent PhysicsContacts = new PhysicsContactsEvent();
     public class NodeCollisionStartEvent {
         private StringHash _event = new StringHash("NodeCollisionStart");
         public StringHash Body = new StringHash("Body");
@@ -83,7 +83,7 @@ using SmoothingTypeFlags = Urho3D::SmoothingType;
 %csattribute(Urho3D::Node, %arg(ea::vector<WeakPtr<Component>>), Listeners, GetListeners);
 %csattribute(Urho3D::Node, %arg(Urho3D::VariantMap), Vars, GetVars);
 %csattribute(Urho3D::Node, %arg(Urho3D::Vector3), NetPositionAttr, GetNetPositionAttr, SetNetPositionAttr);
-%csattribute(Urho3D::Node, %arg(ea::vector<unsigned char>), NetRotationAttr, GetNetRotationAttr, SetNetRotationAttr);
+%csattribute(Urho3D::Node, %arg(Urho3D::Quaternion), NetRotationAttr, GetNetRotationAttr, SetNetRotationAttr);
 %csattribute(Urho3D::Node, %arg(ea::vector<unsigned char>), NetParentAttr, GetNetParentAttr, SetNetParentAttr);
 %csattribute(Urho3D::Node, %arg(ea::vector<Node *>), DependencyNodes, GetDependencyNodes);
 %csattribute(Urho3D::Node, %arg(unsigned int), NumPersistentChildren, GetNumPersistentChildren);
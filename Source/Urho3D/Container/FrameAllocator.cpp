@@ -0,0 +1,199 @@
+//
+// Copyright (c) 2017-2021 the rbfx project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "../Precompiled.h"
+
+#include "../Container/FrameAllocator.h"
+#include "../Core/Mutex.h"
+
+#include <EASTL/algorithm.h>
+#include <EASTL/unique_ptr.h>
+#include <EASTL/vector.h>
+
+#include <cstdint>
+
+#include "../DebugNew.h"
+
+namespace Urho3D
+{
+
+namespace
+{
+
+/// Minimum size of arena memory block.
+static const unsigned MIN_BLOCK_SIZE = 64 * 1024;
+
+/// Arena of single thread.
+class FrameArena
+{
+public:
+    /// Allocate memory.
+    void* Allocate(unsigned size, unsigned alignment)
+    {
+        ++numAllocations_;
+        numBytes_ += size;
+
+        unsigned char* ptr = AlignPointer(current_, alignment);
+        if (!ptr || ptr + size > end_)
+        {
+            // Grow geometrically so the arena converges to single block
+            AllocateBlock(ea::max(ea::max(MIN_BLOCK_SIZE, size + alignment), capacity_));
+            ptr = AlignPointer(current_, alignment);
+        }
+
+        current_ = ptr + size;
+        return ptr;
+    }
+
+    /// Reset arena. Memory blocks used during the frame are merged into one.
+    void Reset()
+    {
+        if (blocks_.size() > 1)
+        {
+            blocks_.clear();
+            const unsigned capacity = capacity_;
+            capacity_ = 0;
+            AllocateBlock(capacity);
+        }
+        else if (!blocks_.empty())
+        {
+            current_ = blocks_.back().get();
+        }
+
+        numAllocations_ = 0;
+        numBytes_ = 0;
+        numHeapAllocations_ = 0;
+    }
+
+    /// Number of allocations since last reset.
+    unsigned numAllocations_{};
+    /// Number of allocated bytes since last reset.
+    unsigned long long numBytes_{};
+    /// Number of heap allocations since last reset.
+    unsigned numHeapAllocations_{};
+    /// Whether the owner thread has exited. Arena is released on next reset.
+    bool orphaned_{};
+
+private:
+    /// Align pointer.
+    static unsigned char* AlignPointer(unsigned char* ptr, unsigned alignment)
+    {
+        const auto address = reinterpret_cast<uintptr_t>(ptr);
+        return reinterpret_cast<unsigned char*>((address + alignment - 1) & ~static_cast<uintptr_t>(alignment - 1));
+    }
+
+    /// Allocate new memory block and make it current.
+    void AllocateBlock(unsigned size)
+    {
+        blocks_.push_back(ea::make_unique<unsigned char[]>(size));
+        current_ = blocks_.back().get();
+        end_ = current_ + size;
+        capacity_ += size;
+        ++numHeapAllocations_;
+    }
+
+    /// Memory blocks.
+    ea::vector<ea::unique_ptr<unsigned char[]>> blocks_;
+    /// Total size of memory blocks.
+    unsigned capacity_{};
+    /// Current position in the last block.
+    unsigned char* current_{};
+    /// End of the last block.
+    unsigned char* end_{};
+};
+
+/// Mutex for arena registration.
+Mutex arenasMutex;
+/// Arenas of all threads.
+ea::vector<ea::unique_ptr<FrameArena>> arenas;
+/// Statistics of last frame.
+FrameAllocatorStats lastFrameStats;
+
+/// Reference to the arena of current thread. Arena is orphaned when the thread exits.
+struct ThreadArenaRef
+{
+    /// Destruct.
+    ~ThreadArenaRef()
+    {
+        if (arena_)
+        {
+            MutexLock lock(arenasMutex);
+            arena_->orphaned_ = true;
+        }
+    }
+
+    /// Arena.
+    FrameArena* arena_{};
+};
+
+/// Arena of current thread.
+thread_local ThreadArenaRef threadArena;
+
+FrameArena& GetThreadArena()
+{
+    if (!threadArena.arena_)
+    {
+        MutexLock lock(arenasMutex);
+        arenas.push_back(ea::make_unique<FrameArena>());
+        threadArena.arena_ = arenas.back().get();
+    }
+    return *threadArena.arena_;
+}
+
+}
+
+void* FrameAllocator::Allocate(unsigned size, unsigned alignment)
+{
+    return GetThreadArena().Allocate(size, alignment);
+}
+
+void FrameAllocator::Reset()
+{
+    MutexLock lock(arenasMutex);
+
+    lastFrameStats = {};
+    for (const auto& arena : arenas)
+    {
+        lastFrameStats.numAllocations_ += arena->numAllocations_;
+        lastFrameStats.numBytes_ += arena->numBytes_;
+        lastFrameStats.numHeapAllocations_ += arena->numHeapAllocations_;
+        arena->Reset();
+    }
+
+    // Memory of exited threads may have been used during the frame, so it's released only now
+    arenas.erase(ea::remove_if(arenas.begin(), arenas.end(),
+        [](const ea::unique_ptr<FrameArena>& arena) { return arena->orphaned_; }), arenas.end());
+}
+
+unsigned FrameAllocator::GetNumArenas()
+{
+    MutexLock lock(arenasMutex);
+    return arenas.size();
+}
+
+FrameAllocatorStats FrameAllocator::GetLastFrameStats()
+{
+    MutexLock lock(arenasMutex);
+    return lastFrameStats;
+}
+
+}
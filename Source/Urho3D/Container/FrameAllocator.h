@@ -0,0 +1,99 @@
+//
+// Copyright (c) 2017-2021 the rbfx project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+/// \file
+
+#pragma once
+
+#include <Urho3D/Urho3D.h>
+
+#include <EASTL/internal/config.h>
+
+namespace Urho3D
+{
+
+/// Statistics of frame allocator.
+struct FrameAllocatorStats
+{
+    /// Number of allocations.
+    unsigned numAllocations_{};
+    /// Number of allocated bytes.
+    unsigned long long numBytes_{};
+    /// Number of memory blocks allocated from the heap by the arenas. Zero in steady state unless frame memory usage grows.
+    /// Containers that don't use the frame allocator still allocate from the heap as usual.
+    unsigned numHeapAllocations_{};
+};
+
+/// Linear allocator of memory that is valid until the end of the frame.
+/// Each thread allocates from its own arena, deallocation is no-op.
+/// Arenas are reset by Time::EndFrame() after E_ENDFRAME, frame memory should not be accessed after that.
+/// Arenas of exited threads are released on reset.
+class URHO3D_API FrameAllocator
+{
+public:
+    /// Allocate memory from the arena of current thread.
+    static void* Allocate(unsigned size, unsigned alignment);
+    /// Reset arenas of all threads and update statistics.
+    /// Should be called from the main thread when frame memory is not used by any thread.
+    static void Reset();
+    /// Return statistics of the last frame.
+    static FrameAllocatorStats GetLastFrameStats();
+    /// Return number of thread arenas, including arenas of exited threads that are not released yet.
+    static unsigned GetNumArenas();
+};
+
+/// EASTL allocator that uses FrameAllocator. Containers should not outlive the frame.
+class EASTLFrameAllocator
+{
+public:
+    /// Construct.
+    explicit EASTLFrameAllocator(const char* /*name*/ = nullptr) {}
+    /// Construct.
+    EASTLFrameAllocator(const EASTLFrameAllocator& /*other*/, const char* /*name*/) {}
+
+    /// Allocate memory.
+    void* allocate(size_t n, int /*flags*/ = 0)
+    {
+        return FrameAllocator::Allocate(static_cast<unsigned>(n), EASTL_ALLOCATOR_MIN_ALIGNMENT);
+    }
+
+    /// Allocate aligned memory.
+    void* allocate(size_t n, size_t alignment, size_t /*offset*/, int /*flags*/ = 0)
+    {
+        return FrameAllocator::Allocate(static_cast<unsigned>(n), static_cast<unsigned>(alignment));
+    }
+
+    /// Deallocate memory. Memory is released at the end of the frame.
+    void deallocate(void* /*p*/, size_t /*n*/) {}
+
+    /// Return name.
+    const char* get_name() const { return "FrameAllocator"; }
+    /// Set name.
+    void set_name(const char* /*name*/) {}
+};
+
+/// Compare frame allocators. All frame allocators are interchangeable.
+inline bool operator==(const EASTLFrameAllocator& /*lhs*/, const EASTLFrameAllocator& /*rhs*/) { return true; }
+/// Compare frame allocators. All frame allocators are interchangeable.
+inline bool operator!=(const EASTLFrameAllocator& /*lhs*/, const EASTLFrameAllocator& /*rhs*/) { return false; }
+
+}
@@ -22,6 +22,8 @@
 
 #pragma once
 
+#include "../Container/FrameAllocator.h"
+
 #include <EASTL/iterator.h>
 #include <EASTL/vector.h>
 #include <EASTL/utility.h>
@@ -30,12 +32,18 @@ namespace Urho3D
 {
 
 /// Vector of vectors.
-template <class T>
+/// If EASTLFrameAllocator is used, inner vectors lose their memory on Clear without touching it.
+template <class T, class Allocator = EASTLAllocatorType>
 class MultiVector
 {
 public:
+    /// Whether the inner vectors use frame memory.
+    static constexpr bool IsFrameAllocated = ea::is_same_v<Allocator, EASTLFrameAllocator>;
+    static_assert(!IsFrameAllocated || ea::is_trivially_destructible_v<T>,
+        "Frame memory is released without calling destructors");
+
     /// Inner collection type.
-    using InnerCollection = ea::vector<T>;
+    using InnerCollection = ea::vector<T, Allocator>;
     /// Outer collection type.
     using OuterCollection = ea::vector<InnerCollection>;
     /// Index in multi-vector (pair of outer and inner indices).
@@ -159,7 +167,13 @@ public:
     {
         outer_.resize(outerSize);
         for (auto& inner : outer_)
-            inner.clear();
+        {
+            // Frame memory may be already reused, don't access it
+            if constexpr (IsFrameAllocated)
+                inner.reset_lose_memory();
+            else
+                inner.clear();
+        }
     }
 
     /// Emplace element at the back of specified outer vector.
@@ -226,14 +240,14 @@ private:
 };
 
 /// Return begin iterator of const MultiVector.
-template <class T> auto begin(const MultiVector<T>& c) { return c.Begin(); }
+template <class T, class A> auto begin(const MultiVector<T, A>& c) { return c.Begin(); }
 /// Return end iterator of const MultiVector.
-template <class T> auto end(const MultiVector<T>& c) { return c.End(); }
+template <class T, class A> auto end(const MultiVector<T, A>& c) { return c.End(); }
 /// Return begin iterator of mutable MultiVector.
-template <class T> auto begin(MultiVector<T>& c) { return c.Begin(); }
+template <class T, class A> auto begin(MultiVector<T, A>& c) { return c.Begin(); }
 /// Return end iterator of mutable MultiVector.
-template <class T> auto end(MultiVector<T>& c) { return c.End(); }
+template <class T, class A> auto end(MultiVector<T, A>& c) { return c.End(); }
 /// Return size of MultiVector.
-template <class T> unsigned size(const MultiVector<T>& c) { return c.Size(); }
+template <class T, class A> unsigned size(const MultiVector<T, A>& c) { return c.Size(); }
 
 }
@@ -0,0 +1,281 @@
+//
+// Copyright (c) 2017-2021 the rbfx project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "../Precompiled.h"
+
+#include "../Container/PoolAllocator.h"
+#include "../Core/Mutex.h"
+
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+
+#include "../DebugNew.h"
+
+namespace Urho3D
+{
+
+namespace
+{
+
+/// Size of span. Spans are aligned to their size, so span header can be found from object pointer.
+const uintptr_t SPAN_SIZE = 64 * 1024;
+/// Size of span header. Objects are placed after the header.
+const unsigned SPAN_HEADER_SIZE = 64;
+/// Number of spans allocated from the heap at once.
+const unsigned SPANS_PER_CHUNK = 16;
+/// Granularity of size class lookup.
+const unsigned SIZE_GRANULARITY = 16;
+
+/// Sizes of objects in size classes.
+constexpr unsigned sizeClasses[] = {
+    16, 32, 48, 64, 80, 96, 112, 128,
+    160, 192, 224, 256, 320, 384, 448, 512,
+    640, 768, 896, 1024
+};
+constexpr unsigned NUM_SIZE_CLASSES = sizeof(sizeClasses) / sizeof(sizeClasses[0]);
+static_assert(sizeClasses[NUM_SIZE_CLASSES - 1] == PoolAllocator::MaxPooledSize, "Invalid size classes");
+
+/// Lookup table from size in granules to size class index.
+struct SizeClassTable
+{
+    constexpr SizeClassTable()
+    {
+        unsigned sizeClass = 0;
+        for (unsigned granules = 0; granules <= NUM_GRANULES; ++granules)
+        {
+            while (sizeClasses[sizeClass] < granules * SIZE_GRANULARITY)
+                ++sizeClass;
+            indices_[granules] = static_cast<unsigned char>(sizeClass);
+        }
+    }
+
+    static const unsigned NUM_GRANULES = PoolAllocator::MaxPooledSize / SIZE_GRANULARITY;
+    unsigned char indices_[NUM_GRANULES + 1]{};
+};
+
+constexpr SizeClassTable sizeClassTable;
+
+unsigned GetSizeClass(size_t size)
+{
+    return sizeClassTable.indices_[(size + SIZE_GRANULARITY - 1) / SIZE_GRANULARITY];
+}
+
+/// Free object.
+struct FreeNode
+{
+    /// Next free object.
+    FreeNode* next_;
+};
+
+struct ThreadCache;
+
+/// Header of span. Each span contains objects of single size class owned by single thread cache.
+struct SpanHeader
+{
+    /// Owner cache.
+    ThreadCache* owner_;
+    /// Size class index.
+    unsigned sizeClass_;
+};
+static_assert(sizeof(SpanHeader) <= SPAN_HEADER_SIZE, "Span header is too big");
+
+/// Cache of free objects owned by thread.
+struct ThreadCache
+{
+    /// Free objects owned by the cache. Accessed only by the owner thread.
+    FreeNode* freeLists_[NUM_SIZE_CLASSES]{};
+    /// Unused memory of the last span of each size class. Accessed only by the owner thread.
+    unsigned char* spanCursors_[NUM_SIZE_CLASSES]{};
+    /// End of the last span of each size class.
+    unsigned char* spanEnds_[NUM_SIZE_CLASSES]{};
+    /// Objects freed by other threads.
+    alignas(64) std::atomic<FreeNode*> remoteFreeLists_[NUM_SIZE_CLASSES]{};
+    /// Next cache of finished thread. Protected by global mutex.
+    ThreadCache* nextAbandoned_{};
+};
+
+/// Global state. Trivially constructible so it can be used during static initialization and destruction.
+SpinLockMutex globalMutex;
+ThreadCache* abandonedCaches{};
+unsigned char* chunkCursor{};
+unsigned char* chunkEnd{};
+std::atomic<unsigned> numSpans{};
+std::atomic<unsigned> numThreadCaches{};
+
+/// Cache of current thread. Trivially destructible so it's safe to access during thread termination.
+thread_local ThreadCache* threadCache{};
+
+/// Return cache to the global pool on thread termination.
+struct ThreadCacheGuard
+{
+    ~ThreadCacheGuard()
+    {
+        if (!threadCache)
+            return;
+
+        // Objects may be freed later by other threads or by this thread during termination, it's fine
+        MutexLock<SpinLockMutex> lock(globalMutex);
+        threadCache->nextAbandoned_ = abandonedCaches;
+        abandonedCaches = threadCache;
+        threadCache = nullptr;
+    }
+};
+thread_local ThreadCacheGuard threadCacheGuard;
+
+ThreadCache* AcquireThreadCache()
+{
+    // Touch the guard so it's destroyed on thread termination
+    (void)&threadCacheGuard;
+
+    {
+        MutexLock<SpinLockMutex> lock(globalMutex);
+        if (abandonedCaches)
+        {
+            ThreadCache* cache = abandonedCaches;
+            abandonedCaches = cache->nextAbandoned_;
+            cache->nextAbandoned_ = nullptr;
+            return cache;
+        }
+    }
+
+    numThreadCaches.fetch_add(1, std::memory_order_relaxed);
+    return new ThreadCache();
+}
+
+unsigned char* AllocateSpan()
+{
+    MutexLock<SpinLockMutex> lock(globalMutex);
+    if (chunkCursor == chunkEnd)
+    {
+        // Allocate one extra span to align spans. Chunks are never freed
+        const auto chunk = reinterpret_cast<uintptr_t>(malloc((SPANS_PER_CHUNK + 1) * SPAN_SIZE));
+        if (!chunk)
+            throw std::bad_alloc();
+
+        const uintptr_t alignedChunk = (chunk + SPAN_SIZE - 1) & ~(SPAN_SIZE - 1);
+        chunkCursor = reinterpret_cast<unsigned char*>(alignedChunk);
+        chunkEnd = chunkCursor + SPANS_PER_CHUNK * SPAN_SIZE;
+    }
+
+    unsigned char* span = chunkCursor;
+    chunkCursor += SPAN_SIZE;
+    numSpans.fetch_add(1, std::memory_order_relaxed);
+    return span;
+}
+
+SpanHeader* GetSpanHeader(void* ptr)
+{
+    return reinterpret_cast<SpanHeader*>(reinterpret_cast<uintptr_t>(ptr) & ~(SPAN_SIZE - 1));
+}
+
+}
+
+void* PoolAllocator::Allocate(size_t size)
+{
+    if (size > MaxPooledSize)
+    {
+        void* ptr = malloc(size);
+        if (!ptr)
+            throw std::bad_alloc();
+        return ptr;
+    }
+
+    if (!threadCache)
+        threadCache = AcquireThreadCache();
+
+    ThreadCache& cache = *threadCache;
+    const unsigned sizeClass = GetSizeClass(size);
+
+    // Take all objects freed by other threads at once, so there's no ABA problem
+    FreeNode*& freeList = cache.freeLists_[sizeClass];
+    if (!freeList)
+        freeList = cache.remoteFreeLists_[sizeClass].exchange(nullptr, std::memory_order_acquire);
+
+    if (FreeNode* node = freeList)
+    {
+        freeList = node->next_;
+        return node;
+    }
+
+    // Allocate from the last span, objects are not linked in advance
+    const unsigned objectSize = sizeClasses[sizeClass];
+    unsigned char*& cursor = cache.spanCursors_[sizeClass];
+    if (cursor == cache.spanEnds_[sizeClass])
+    {
+        unsigned char* span = AllocateSpan();
+        auto header = reinterpret_cast<SpanHeader*>(span);
+        header->owner_ = &cache;
+        header->sizeClass_ = sizeClass;
+
+        const unsigned numObjects = (SPAN_SIZE - SPAN_HEADER_SIZE) / objectSize;
+        cursor = span + SPAN_HEADER_SIZE;
+        cache.spanEnds_[sizeClass] = cursor + numObjects * objectSize;
+    }
+
+    void* ptr = cursor;
+    cursor += objectSize;
+    return ptr;
+}
+
+void PoolAllocator::Free(void* ptr, size_t size)
+{
+    if (!ptr)
+        return;
+
+    if (size > MaxPooledSize)
+    {
+        free(ptr);
+        return;
+    }
+
+    SpanHeader* header = GetSpanHeader(ptr);
+    ThreadCache* owner = header->owner_;
+    const unsigned sizeClass = header->sizeClass_;
+    assert(sizeClass == GetSizeClass(size));
+
+    auto node = static_cast<FreeNode*>(ptr);
+    if (owner == threadCache)
+    {
+        node->next_ = owner->freeLists_[sizeClass];
+        owner->freeLists_[sizeClass] = node;
+    }
+    else
+    {
+        std::atomic<FreeNode*>& remoteFreeList = owner->remoteFreeLists_[sizeClass];
+        node->next_ = remoteFreeList.load(std::memory_order_relaxed);
+        while (!remoteFreeList.compare_exchange_weak(node->next_, node, std::memory_order_release, std::memory_order_relaxed))
+            ;
+    }
+}
+
+PoolAllocatorStats PoolAllocator::GetStats()
+{
+    PoolAllocatorStats stats;
+    stats.numSpans_ = numSpans.load(std::memory_order_relaxed);
+    stats.numThreadCaches_ = numThreadCaches.load(std::memory_order_relaxed);
+    return stats;
+}
+
+}
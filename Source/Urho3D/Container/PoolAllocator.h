@@ -0,0 +1,79 @@
+//
+// Copyright (c) 2017-2021 the rbfx project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+/// \file
+
+#pragma once
+
+#include <Urho3D/Urho3D.h>
+
+#include <cstddef>
+
+namespace Urho3D
+{
+
+/// Statistics of pool allocator.
+struct PoolAllocatorStats
+{
+    /// Number of memory spans allocated for small objects. Spans are never returned to the system.
+    unsigned numSpans_{};
+    /// Number of thread caches, including caches of finished threads that are waiting for reuse.
+    unsigned numThreadCaches_{};
+};
+
+/// Thread-safe allocator of small objects.
+/// Objects are grouped into size classes, each thread allocates from its own cache without locking.
+/// Objects may be freed by any thread, objects freed by other threads are returned to the owner cache via lock-free list.
+/// Caches of finished threads are reused by new threads. Large objects are allocated from the heap.
+class URHO3D_API PoolAllocator
+{
+public:
+    /// Max size of object allocated from the pool.
+    static const unsigned MaxPooledSize = 1024;
+
+    /// Allocate memory. Memory is aligned at least to 16 bytes.
+    static void* Allocate(size_t size);
+    /// Free memory. Size should be the same as on allocation.
+    static void Free(void* ptr, size_t size);
+    /// Return statistics.
+    static PoolAllocatorStats GetStats();
+};
+
+}
+
+#if defined(_MSC_VER) && defined(_DEBUG)
+    #define URHO3D_POOL_ALLOCATED_DEBUG_NEW() \
+        static void* operator new(size_t size, int, const char*, int) { return Urho3D::PoolAllocator::Allocate(size); } \
+        static void operator delete(void* /*ptr*/, int, const char*, int) {}
+#else
+    #define URHO3D_POOL_ALLOCATED_DEBUG_NEW()
+#endif
+
+/// Allocate instances of the class and derived classes from PoolAllocator.
+/// Class should have virtual destructor if derived classes are deleted via pointer to base class.
+#define URHO3D_POOL_ALLOCATED() \
+    public: \
+        static void* operator new(size_t size) { return Urho3D::PoolAllocator::Allocate(size); } \
+        static void* operator new(size_t /*size*/, void* ptr) { return ptr; } \
+        static void operator delete(void* ptr, size_t size) { Urho3D::PoolAllocator::Free(ptr, size); } \
+        static void operator delete(void* /*ptr*/, void* /*place*/) {} \
+        URHO3D_POOL_ALLOCATED_DEBUG_NEW()
@@ -26,6 +26,7 @@
 
 #include <EASTL/internal/thread_support.h>
 
+#include "../Container/PoolAllocator.h"
 #include "../Container/RefCounted.h"
 #include "../Core/Macros.h"
 #if URHO3D_CSHARP
@@ -37,15 +38,14 @@ namespace Urho3D
 
 RefCount* RefCount::Allocate()
 {
-    void* const memory = EASTLAlloc(*ea::get_default_allocator((Allocator*)nullptr), sizeof(RefCount));
-    assert(memory != nullptr);
+    void* const memory = PoolAllocator::Allocate(sizeof(RefCount));
     return ::new(memory) RefCount();
 }
 
 void RefCount::Free(RefCount* instance)
 {
     instance->~RefCount();
-    EASTLFree(*ea::get_default_allocator((Allocator*)nullptr), instance, sizeof(RefCount));
+    PoolAllocator::Free(instance, sizeof(RefCount));
 }
 
 RefCounted::RefCounted()
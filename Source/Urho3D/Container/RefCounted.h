@@ -47,9 +47,9 @@ public:
         weakRefs_ = -1;
     }
 
-    /// Allocate RefCount using it's default allocator.
+    /// Allocate RefCount from PoolAllocator.
     static RefCount* Allocate();
-    /// Free RefCount using it's default allocator.
+    /// Free RefCount to PoolAllocator.
     static void Free(RefCount* instance);
 
     /// Reference count. If below zero, the object has been destroyed.
@@ -0,0 +1,120 @@
+//
+// Copyright (c) 2017-2021 the rbfx project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include <EASTL/unique_ptr.h>
+
+#include <atomic>
+
+namespace Urho3D
+{
+
+/// Bounded lock-free work-stealing deque of pointers (Chase-Lev).
+/// Push and Pop may be called only by the owner thread, Steal may be called by any thread.
+template <class T>
+class WorkStealingDeque
+{
+public:
+    /// Construct with capacity. Capacity is rounded up to power of two.
+    explicit WorkStealingDeque(unsigned capacity = 4096)
+    {
+        unsigned size = 1;
+        while (size < capacity)
+            size <<= 1;
+        mask_ = size - 1;
+        buffer_ = ea::make_unique<std::atomic<T*>[]>(size);
+    }
+
+    /// Push element to the bottom. Owner thread only. Return false if deque is full.
+    bool Push(T* value)
+    {
+        const long long bottom = bottom_.load(std::memory_order_relaxed);
+        const long long top = top_.load(std::memory_order_acquire);
+        if (bottom - top > static_cast<long long>(mask_))
+            return false;
+
+        buffer_[bottom & mask_].store(value, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        bottom_.store(bottom + 1, std::memory_order_relaxed);
+        return true;
+    }
+
+    /// Pop element from the bottom. Owner thread only. Return null if deque is empty.
+    T* Pop()
+    {
+        const long long bottom = bottom_.load(std::memory_order_relaxed) - 1;
+        bottom_.store(bottom, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        long long top = top_.load(std::memory_order_relaxed);
+
+        if (top > bottom)
+        {
+            bottom_.store(bottom + 1, std::memory_order_relaxed);
+            return nullptr;
+        }
+
+        T* value = buffer_[bottom & mask_].load(std::memory_order_relaxed);
+        if (top == bottom)
+        {
+            // Last element, race against thieves
+            if (!top_.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+                value = nullptr;
+            bottom_.store(bottom + 1, std::memory_order_relaxed);
+        }
+        return value;
+    }
+
+    /// Steal element from the top. Any thread. Return null if deque is empty or if lost the race.
+    T* Steal()
+    {
+        long long top = top_.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        const long long bottom = bottom_.load(std::memory_order_acquire);
+
+        if (top >= bottom)
+            return nullptr;
+
+        T* value = buffer_[top & mask_].load(std::memory_order_relaxed);
+        if (!top_.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+            return nullptr;
+        return value;
+    }
+
+    /// Return whether the deque looks empty. The result is approximate if other threads are active.
+    bool IsEmpty() const
+    {
+        return top_.load(std::memory_order_relaxed) >= bottom_.load(std::memory_order_relaxed);
+    }
+
+private:
+    /// Index of the element to be stolen next.
+    alignas(64) std::atomic<long long> top_{};
+    /// Index of the element to be pushed next.
+    alignas(64) std::atomic<long long> bottom_{};
+    /// Ring buffer.
+    ea::unique_ptr<std::atomic<T*>[]> buffer_;
+    /// Index mask.
+    unsigned mask_{};
+};
+
+}
@@ -28,6 +28,8 @@
 #include "../Container/Ptr.h"
 #include "../Core/Variant.h"
 
+#include <cassert>
+
 namespace Urho3D
 {
 
@@ -56,6 +58,56 @@ enum AttributeMode
 };
 URHO3D_FLAGSET(AttributeMode, AttributeModeFlags);
 
+/// Compact encoding of attribute value in network replication.
+enum AttributeNetworkEncodingType
+{
+    /// Attribute value is serialized as is.
+    ANE_DEFAULT = 0,
+    /// Float or vector components are clamped to range and quantized to specified number of bits.
+    ANE_QUANTIZED,
+    /// Quaternion is normalized and stored as three smallest components of specified number of bits each.
+    ANE_SMALLEST_THREE,
+    /// Integer is stored as offset from minimum value with specified number of bits.
+    ANE_BITS,
+};
+
+/// Network encoding of attribute value. Encoded values are padded to whole bytes.
+struct AttributeNetworkEncoding
+{
+    /// Return quantized float or vector encoding.
+    static AttributeNetworkEncoding Quantized(float minValue, float maxValue, unsigned bits)
+    {
+        return { ANE_QUANTIZED, bits, minValue, maxValue };
+    }
+
+    /// Return smallest three quaternion encoding.
+    static AttributeNetworkEncoding SmallestThree(unsigned bits)
+    {
+        return { ANE_SMALLEST_THREE, bits, 0.0f, 0.0f };
+    }
+
+    /// Return bit-width integer encoding. Range should be representable as float without precision loss.
+    static AttributeNetworkEncoding Bits(int minValue, int maxValue)
+    {
+        assert(minValue <= maxValue);
+        unsigned bits = 1;
+        // Range may not fit into int, compute it in unsigned arithmetic
+        const unsigned range = static_cast<unsigned>(maxValue) - static_cast<unsigned>(minValue);
+        while (bits < 32 && (range >> bits) != 0)
+            ++bits;
+        return { ANE_BITS, bits, static_cast<float>(minValue), static_cast<float>(maxValue) };
+    }
+
+    /// Encoding type.
+    AttributeNetworkEncodingType type_{ ANE_DEFAULT };
+    /// Number of bits per component.
+    unsigned bits_{};
+    /// Minimum value.
+    float min_{};
+    /// Maximum value.
+    float max_{};
+};
+
 class Serializable;
 
 /// Abstract base class for invoking attribute accessors.
@@ -113,6 +165,7 @@ struct AttributeInfo
         defaultValue_ = other.defaultValue_;
         mode_ = other.mode_;
         metadata_ = other.metadata_;
+        networkEncoding_ = other.networkEncoding_;
         ptr_ = other.ptr_;
         enumNamesStorage_ = other.enumNamesStorage_;
 
@@ -167,6 +220,8 @@ struct AttributeInfo
     AttributeModeFlags mode_ = AM_DEFAULT;
     /// Attribute metadata.
     VariantMap metadata_;
+    /// Compact encoding used in network replication.
+    AttributeNetworkEncoding networkEncoding_;
     /// Attribute data pointer if elsewhere than in the Serializable.
     void* ptr_ = nullptr;
     /// List of enum names. Used when names can not be stored externally.
@@ -214,6 +269,15 @@ public:
             networkAttributeInfo_->metadata_[key] = value;
         return *this;
     }
+    /// Set network encoding.
+    AttributeHandle& SetNetworkEncoding(const AttributeNetworkEncoding& encoding)
+    {
+        if (attributeInfo_)
+            attributeInfo_->networkEncoding_ = encoding;
+        if (networkAttributeInfo_)
+            networkAttributeInfo_->networkEncoding_ = encoding;
+        return *this;
+    }
 };
 
 }
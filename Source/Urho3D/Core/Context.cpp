@@ -317,6 +317,23 @@ void Context::UpdateAttributeDefaultValue(StringHash objectType, const char* nam
         info->defaultValue_ = defaultValue;
 }
 
+void Context::UpdateAttributeNetworkEncoding(StringHash objectType, const char* name, const AttributeNetworkEncoding& encoding)
+{
+    AttributeInfo* info = GetAttribute(objectType, name);
+    if (info)
+        info->networkEncoding_ = encoding;
+
+    auto i = networkAttributes_.find(objectType);
+    if (i == networkAttributes_.end())
+        return;
+
+    for (AttributeInfo& networkInfo : i->second)
+    {
+        if (!networkInfo.name_.comparei(name))
+            networkInfo.networkEncoding_ = encoding;
+    }
+}
+
 VariantMap& Context::GetEventDataMap()
 {
     unsigned nestingLevel = eventSenders_.size();
@@ -0,0 +1,264 @@
+//
+// Copyright (c) 2017-2021 the rbfx project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "../Precompiled.h"
+
+#include "../Core/Profiler.h"
+#include "../Core/StringUtils.h"
+#include "../Core/TaskGraph.h"
+
+#include <EASTL/algorithm.h>
+
+#include "../DebugNew.h"
+
+namespace Urho3D
+{
+
+TaskGraph::TaskGraph(WorkQueue* workQueue)
+    : workQueue_(workQueue)
+{
+}
+
+TaskGraph::~TaskGraph()
+{
+}
+
+void TaskGraph::Clear()
+{
+    for (unsigned i = 0; i < numTasks_; ++i)
+    {
+        Task& task = *tasks_[i];
+        task.callback_ = nullptr;
+        task.rangeCallback_ = nullptr;
+        task.sizeCallback_ = nullptr;
+        task.dependencies_.clear();
+        task.sizeItem_ = nullptr;
+        task.items_.clear();
+    }
+    numTasks_ = 0;
+}
+
+TaskGraph::Task& TaskGraph::AllocateTask(const ea::string& name, TaskAffinity affinity)
+{
+    if (numTasks_ >= tasks_.size())
+        tasks_.push_back(ea::make_unique<Task>());
+
+    Task& task = *tasks_[numTasks_++];
+    task.graph_ = this;
+    task.name_ = name;
+    task.affinity_ = affinity;
+    task.size_ = 0;
+    task.bucket_ = 0;
+    return task;
+}
+
+TaskGraph::TaskId TaskGraph::AddTask(const ea::string& name, TaskCallback callback, TaskAffinity affinity)
+{
+    Task& task = AllocateTask(name, affinity);
+    task.callback_ = ea::move(callback);
+    return numTasks_ - 1;
+}
+
+TaskGraph::TaskId TaskGraph::AddParallelTask(const ea::string& name,
+    unsigned size, unsigned bucket, RangeTaskCallback callback)
+{
+    Task& task = AllocateTask(name, TaskAffinity::Any);
+    task.rangeCallback_ = ea::move(callback);
+    task.size_ = size;
+    task.bucket_ = ea::max(1u, bucket);
+    return numTasks_ - 1;
+}
+
+TaskGraph::TaskId TaskGraph::AddParallelTask(const ea::string& name,
+    SizeCallback sizeCallback, unsigned bucket, RangeTaskCallback callback)
+{
+    Task& task = AllocateTask(name, TaskAffinity::Any);
+    task.rangeCallback_ = ea::move(callback);
+    task.sizeCallback_ = ea::move(sizeCallback);
+    task.bucket_ = ea::max(1u, bucket);
+    return numTasks_ - 1;
+}
+
+void TaskGraph::AddDependency(TaskId task, TaskId dependency)
+{
+    assert(task < numTasks_ && dependency < task);
+    tasks_[task]->dependencies_.push_back(dependency);
+}
+
+void TaskGraph::Execute()
+{
+    URHO3D_PROFILE("ExecuteTaskGraph");
+
+    executionTimer_.Reset();
+    const unsigned maxThreads = workQueue_->GetNumThreads() + 1;
+
+    for (unsigned taskIndex = 0; taskIndex < numTasks_; ++taskIndex)
+    {
+        Task& task = *tasks_[taskIndex];
+        task.offset_ = 0;
+        task.startTime_ = M_MAX_INT;
+        task.endTime_ = 0;
+
+        dependencyItems_.clear();
+        for (TaskId dependency : task.dependencies_)
+            dependencyItems_.append(tasks_[dependency]->items_);
+
+        // If size is unknown, evaluate it before processing and spawn as many items as there may be threads
+        if (task.sizeCallback_)
+        {
+            task.size_ = 0;
+            task.sizeItem_ = CreateItem(task, EvaluateTaskSize);
+            workQueue_->AddWorkItem(task.sizeItem_, dependencyItems_);
+
+            dependencyItems_.clear();
+            dependencyItems_.push_back(task.sizeItem_);
+        }
+
+        // Parallel task is executed by several work items, but at least one item is needed to track dependencies
+        unsigned numItems = 1;
+        if (task.sizeCallback_)
+            numItems = maxThreads;
+        else if (task.rangeCallback_)
+        {
+            const unsigned numBuckets = (task.size_ + task.bucket_ - 1) / task.bucket_;
+            numItems = ea::max(1u, ea::min(maxThreads, numBuckets));
+        }
+
+        task.items_.clear();
+        for (unsigned i = 0; i < numItems; ++i)
+        {
+            task.items_.push_back(CreateItem(task, ExecuteTaskItem));
+            workQueue_->AddWorkItem(task.items_.back(), dependencyItems_);
+        }
+    }
+
+    workQueue_->Complete(M_MAX_UNSIGNED);
+
+    for (unsigned taskIndex = 0; taskIndex < numTasks_; ++taskIndex)
+    {
+        tasks_[taskIndex]->sizeItem_ = nullptr;
+        tasks_[taskIndex]->items_.clear();
+    }
+
+    UpdateCriticalPath();
+}
+
+long long TaskGraph::GetTaskDuration(TaskId task) const
+{
+    const Task& taskData = *tasks_[task];
+    const long long startTime = taskData.startTime_.load(std::memory_order_relaxed);
+    const long long endTime = taskData.endTime_.load(std::memory_order_relaxed);
+    return ea::max(0ll, endTime - startTime);
+}
+
+SharedPtr<WorkItem> TaskGraph::CreateItem(Task& task, void (*workFunction)(const WorkItem*, unsigned))
+{
+    SharedPtr<WorkItem> item = workQueue_->GetFreeItem();
+    item->workFunction_ = workFunction;
+    item->aux_ = &task;
+    item->priority_ = M_MAX_UNSIGNED;
+    item->mainThreadOnly_ = task.affinity_ == TaskAffinity::MainThread;
+    return item;
+}
+
+void TaskGraph::EvaluateTaskSize(const WorkItem* item, unsigned /*threadIndex*/)
+{
+    Task& task = *static_cast<Task*>(item->aux_);
+    task.size_ = task.sizeCallback_();
+}
+
+void TaskGraph::ExecuteTaskItem(const WorkItem* item, unsigned threadIndex)
+{
+    Task& task = *static_cast<Task*>(item->aux_);
+    HiresTimer& timer = task.graph_->executionTimer_;
+
+    URHO3D_PROFILE("ExecuteTask");
+    URHO3D_PROFILE_ZONENAME(task.name_.c_str(), task.name_.size());
+
+    const long long startTime = timer.GetUSec(false);
+    long long oldStartTime = task.startTime_.load(std::memory_order_relaxed);
+    while (startTime < oldStartTime && !task.startTime_.compare_exchange_weak(oldStartTime, startTime))
+        ;
+
+    if (task.rangeCallback_)
+    {
+        while (true)
+        {
+            const unsigned beginIndex = task.offset_.fetch_add(task.bucket_, std::memory_order_relaxed);
+            if (beginIndex >= task.size_)
+                break;
+
+            const unsigned endIndex = ea::min(beginIndex + task.bucket_, task.size_);
+            task.rangeCallback_(beginIndex, endIndex);
+        }
+    }
+    else if (task.callback_)
+        task.callback_(threadIndex);
+
+    const long long endTime = timer.GetUSec(false);
+    long long oldEndTime = task.endTime_.load(std::memory_order_relaxed);
+    while (endTime > oldEndTime && !task.endTime_.compare_exchange_weak(oldEndTime, endTime))
+        ;
+}
+
+void TaskGraph::UpdateCriticalPath()
+{
+    criticalPath_.clear();
+    criticalPathDuration_ = 0;
+    if (numTasks_ == 0)
+        return;
+
+    // Dependencies always precede dependent tasks, so tasks are already sorted topologically
+    pathDurations_.resize(numTasks_);
+    TaskId lastTask = 0;
+    for (unsigned taskIndex = 0; taskIndex < numTasks_; ++taskIndex)
+    {
+        long long longestDependencyPath = 0;
+        TaskId longestDependency = M_MAX_UNSIGNED;
+        for (TaskId dependency : tasks_[taskIndex]->dependencies_)
+        {
+            if (longestDependency == M_MAX_UNSIGNED || pathDurations_[dependency].first > longestDependencyPath)
+            {
+                longestDependencyPath = pathDurations_[dependency].first;
+                longestDependency = dependency;
+            }
+        }
+
+        pathDurations_[taskIndex] = { longestDependencyPath + GetTaskDuration(taskIndex), longestDependency };
+        if (pathDurations_[taskIndex].first >= pathDurations_[lastTask].first)
+            lastTask = taskIndex;
+    }
+
+    criticalPathDuration_ = pathDurations_[lastTask].first;
+    for (TaskId task = lastTask; task != M_MAX_UNSIGNED; task = pathDurations_[task].second)
+        criticalPath_.push_back(task);
+    ea::reverse(criticalPath_.begin(), criticalPath_.end());
+
+#if URHO3D_PROFILING
+    ea::string message = Format("Critical path {} us:", criticalPathDuration_);
+    for (TaskId task : criticalPath_)
+        message += Format(" {} ({} us)", tasks_[task]->name_, GetTaskDuration(task));
+    URHO3D_PROFILE_MESSAGE(message.c_str(), message.size());
+#endif
+}
+
+}
@@ -0,0 +1,157 @@
+//
+// Copyright (c) 2017-2021 the rbfx project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "../Core/NonCopyable.h"
+#include "../Core/Timer.h"
+#include "../Core/WorkQueue.h"
+
+#include <EASTL/string.h>
+#include <EASTL/unique_ptr.h>
+#include <EASTL/vector.h>
+
+#include <atomic>
+#include <functional>
+
+namespace Urho3D
+{
+
+/// Thread affinity of task graph node.
+enum class TaskAffinity
+{
+    /// Task may be executed by any WorkQueue thread.
+    Any,
+    /// Task is executed only by the main thread.
+    MainThread
+};
+
+/// Graph of tasks with explicit dependencies executed by WorkQueue.
+/// Independent tasks are executed concurrently, there are no global barriers between them.
+/// Graph may be rebuilt every frame, task storage is reused.
+class URHO3D_API TaskGraph : public NonCopyable
+{
+public:
+    /// Index of task in the graph.
+    using TaskId = unsigned;
+    /// Task callback. Called with thread index.
+    using TaskCallback = std::function<void(unsigned threadIndex)>;
+    /// Parallel task callback. Called with range of indices to process.
+    using RangeTaskCallback = std::function<void(unsigned beginIndex, unsigned endIndex)>;
+    /// Size callback of parallel task. Called after all dependencies are completed.
+    using SizeCallback = std::function<unsigned()>;
+
+    /// Construct.
+    explicit TaskGraph(WorkQueue* workQueue);
+    /// Destruct.
+    ~TaskGraph();
+
+    /// Remove all tasks.
+    void Clear();
+    /// Add task.
+    TaskId AddTask(const ea::string& name, TaskCallback callback, TaskAffinity affinity = TaskAffinity::Any);
+    /// Add task that processes range of indices in multiple threads.
+    TaskId AddParallelTask(const ea::string& name, unsigned size, unsigned bucket, RangeTaskCallback callback);
+    /// Add task that processes range of indices in multiple threads. Range size is unknown until task is started.
+    TaskId AddParallelTask(const ea::string& name, SizeCallback sizeCallback, unsigned bucket, RangeTaskCallback callback);
+    /// Add dependency between tasks. Dependency should be added to the graph before dependent task.
+    void AddDependency(TaskId task, TaskId dependency);
+    /// Execute all tasks and wait for completion. Main thread executes tasks too. Should be called from main thread.
+    void Execute();
+
+    /// Return number of tasks.
+    unsigned GetNumTasks() const { return numTasks_; }
+    /// Return task name.
+    const ea::string& GetTaskName(TaskId task) const { return tasks_[task]->name_; }
+    /// Return time in microseconds spent on the task during last execution.
+    long long GetTaskDuration(TaskId task) const;
+    /// Return the longest chain of dependent tasks measured during last execution.
+    const ea::vector<TaskId>& GetCriticalPath() const { return criticalPath_; }
+    /// Return duration of critical path in microseconds measured during last execution.
+    long long GetCriticalPathDuration() const { return criticalPathDuration_; }
+
+private:
+    /// Task description and execution state.
+    struct Task
+    {
+        /// Owner graph.
+        TaskGraph* graph_{};
+        /// Name used for profiling.
+        ea::string name_;
+        /// Affinity.
+        TaskAffinity affinity_{};
+        /// Single-threaded callback.
+        TaskCallback callback_;
+        /// Parallel callback.
+        RangeTaskCallback rangeCallback_;
+        /// Callback that returns number of elements to be processed by parallel callback.
+        SizeCallback sizeCallback_;
+        /// Number of elements to be processed by parallel callback.
+        unsigned size_{};
+        /// Number of elements processed by parallel callback at once.
+        unsigned bucket_{};
+        /// Tasks that should be completed before this task.
+        ea::vector<TaskId> dependencies_;
+
+        /// Work item that evaluates size of parallel task.
+        SharedPtr<WorkItem> sizeItem_;
+        /// Work items executing the task.
+        ea::vector<SharedPtr<WorkItem>> items_;
+        /// Next element to be processed by parallel callback.
+        std::atomic<unsigned> offset_{};
+        /// Earliest start time in microseconds since execution start.
+        std::atomic<long long> startTime_{};
+        /// Latest end time in microseconds since execution start.
+        std::atomic<long long> endTime_{};
+    };
+
+    /// Allocate new or reuse old task.
+    Task& AllocateTask(const ea::string& name, TaskAffinity affinity);
+    /// Create work item for task.
+    SharedPtr<WorkItem> CreateItem(Task& task, void (*workFunction)(const WorkItem*, unsigned));
+    /// Evaluate size of parallel task.
+    static void EvaluateTaskSize(const WorkItem* item, unsigned threadIndex);
+    /// Execute work item of task.
+    static void ExecuteTaskItem(const WorkItem* item, unsigned threadIndex);
+    /// Evaluate critical path after execution.
+    void UpdateCriticalPath();
+
+    /// Work queue.
+    WorkQueue* workQueue_{};
+    /// Tasks. Only first numTasks_ are used.
+    ea::vector<ea::unique_ptr<Task>> tasks_;
+    /// Number of used tasks.
+    unsigned numTasks_{};
+    /// Timer used to measure tasks.
+    HiresTimer executionTimer_;
+
+    /// Temporary dependencies of work item.
+    ea::vector<SharedPtr<WorkItem>> dependencyItems_;
+    /// Temporary accumulated durations of critical paths.
+    ea::vector<ea::pair<long long, TaskId>> pathDurations_;
+    /// Critical path of last execution.
+    ea::vector<TaskId> criticalPath_;
+    /// Duration of critical path of last execution.
+    long long criticalPathDuration_{};
+};
+
+}
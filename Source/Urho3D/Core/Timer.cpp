@@ -22,6 +22,7 @@
 
 #include "../Precompiled.h"
 
+#include "../Container/FrameAllocator.h"
 #include "../Core/CoreEvents.h"
 #include "../Core/Profiler.h"
 #include "../Core/Timer.h"
@@ -142,7 +143,17 @@ void Time::EndFrame()
 
         // Internal frame end event used only by the engine/tools
         SendEvent(E_ENDFRAMEPRIVATE);
+
+        // Frame memory is not used after the end of the frame
+        FrameAllocator::Reset();
     }
+
+#if URHO3D_PROFILING
+    const FrameAllocatorStats frameAllocatorStats = FrameAllocator::GetLastFrameStats();
+    URHO3D_PROFILE_VALUE("FrameAllocations", static_cast<int64_t>(frameAllocatorStats.numAllocations_));
+    URHO3D_PROFILE_VALUE("FrameAllocatedBytes", static_cast<int64_t>(frameAllocatorStats.numBytes_));
+    URHO3D_PROFILE_VALUE("FrameHeapAllocations", static_cast<int64_t>(frameAllocatorStats.numHeapAllocations_));
+#endif
 }
 
 void Time::SetTimerPeriod(unsigned mSec)
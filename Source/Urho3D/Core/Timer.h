@@ -89,7 +89,7 @@ public:
 
     /// Begin new frame, with (last) frame duration in seconds and send frame start event.
     void BeginFrame(float timeStep);
-    /// End frame. Increment total time and send frame end event.
+    /// End frame. Increment total time, send frame end event and reset frame allocator.
     void EndFrame();
     /// Set the low-resolution timer period in milliseconds. 0 resets to the default period.
     void SetTimerPeriod(unsigned mSec);
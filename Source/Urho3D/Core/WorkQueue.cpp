@@ -30,6 +30,9 @@
 #include "../Core/WorkQueue.h"
 #include "../IO/Log.h"
 
+#include <EASTL/algorithm.h>
+#include <EASTL/sort.h>
+
 namespace Urho3D
 {
 
@@ -70,15 +73,17 @@ private:
 
 WorkQueue::WorkQueue(Context* context) :
     Object(context),
+    numQueued_(0),
+    numMainThreadQueued_(0),
+    numImmediateIncomplete_(0),
+    numSleeping_(0),
     shutDown_(false),
-    pausing_(false),
     paused_(false),
     completing_(false),
-    tolerance_(10),
-    lastSize_(0),
     maxNonThreadedWorkMs_(5)
 {
     currentThreadIndex = 0;
+    deques_.push_back(ea::make_unique<WorkStealingDeque<WorkItem>>());
     SubscribeToEvent(E_BEGINFRAME, URHO3D_HANDLER(WorkQueue, HandleBeginFrame));
 }
 
@@ -87,9 +92,21 @@ WorkQueue::~WorkQueue()
     // Stop the worker threads. First make sure they are not waiting for work items
     shutDown_ = true;
     Resume();
+    WakeThreads();
 
     for (unsigned i = 0; i < threads_.size(); ++i)
         threads_[i]->Stop();
+
+    // Release references held by queues
+    for (auto& deque : deques_)
+    {
+        while (WorkItem* item = deque->Steal())
+            item->ReleaseRef();
+    }
+    for (WorkItem* item : queue_)
+        item->ReleaseRef();
+    for (WorkItem* item : mainThreadQueue_)
+        item->ReleaseRef();
 }
 
 void WorkQueue::CreateThreads(unsigned numThreads)
@@ -103,7 +120,11 @@ void WorkQueue::CreateThreads(unsigned numThreads)
     // Start threads in paused mode
     Pause();
 
+    // Queues should be ready before any thread starts
     maxThreadIndex = numThreads + 1;
+    for (unsigned i = 0; i < numThreads; ++i)
+        deques_.push_back(ea::make_unique<WorkStealingDeque<WorkItem>>());
+
     for (unsigned i = 0; i < numThreads; ++i)
     {
         SharedPtr<WorkerThread> thread(new WorkerThread(this, i + 1));
@@ -118,22 +139,16 @@ void WorkQueue::CreateThreads(unsigned numThreads)
 
 SharedPtr<WorkItem> WorkQueue::GetFreeItem()
 {
-    if (!poolItems_.empty())
-    {
-        SharedPtr<WorkItem> item = poolItems_.front();
-        poolItems_.pop_front();
-        return item;
-    }
-    else
-    {
-        // No usable items found, create a new one set it as pooled and return it.
-        SharedPtr<WorkItem> item(new WorkItem());
-        item->pooled_ = true;
-        return item;
-    }
+    // Work items are allocated from the pool, so there's no need to recycle them explicitly
+    return MakeShared<WorkItem>();
 }
 
 void WorkQueue::AddWorkItem(const SharedPtr<WorkItem>& item)
+{
+    AddWorkItem(item, {});
+}
+
+void WorkQueue::AddWorkItem(const SharedPtr<WorkItem>& item, ea::span<const SharedPtr<WorkItem>> dependencies)
 {
     if (!item)
     {
@@ -148,92 +163,229 @@ void WorkQueue::AddWorkItem(const SharedPtr<WorkItem>& item)
     // Clear completed flag in case item is reused
     workItems_.push_back(item);
     item->completed_ = false;
+    item->dependentsClosed_ = false;
+    item->dependents_.clear();
+    if (item->IsImmediate())
+        numImmediateIncomplete_.fetch_add(1, std::memory_order_relaxed);
+
+    // Hold one extra dependency while registering in dependencies, so the item cannot be scheduled too early
+    item->state_.store(WorkItem::State::Waiting, std::memory_order_relaxed);
+    item->numDependencies_.store(1, std::memory_order_relaxed);
+    for (const SharedPtr<WorkItem>& dependency : dependencies)
+    {
+        if (!dependency || dependency == item)
+            continue;
+
+        MutexLock<SpinLockMutex> lock(dependency->dependentsLock_);
+        if (!dependency->dependentsClosed_)
+        {
+            item->numDependencies_.fetch_add(1, std::memory_order_relaxed);
+            dependency->dependents_.push_back(item);
+        }
+    }
+
+    if (item->numDependencies_.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        ScheduleItem(item.Get(), 0);
 
-    // Make sure worker threads' list is safe to modify
-    if (threads_.size() && !paused_)
-        queueMutex_.Acquire();
+    paused_ = false;
+    WakeThreads();
+}
+
+SharedPtr<WorkItem> WorkQueue::AddWorkItem(std::function<void(unsigned threadIndex)> workFunction, unsigned priority)
+{
+    return AddWorkItem(std::move(workFunction), {}, priority);
+}
 
-    // Find position for new item
-    if (queue_.empty())
-        queue_.push_back(item.Get());
-    else
+SharedPtr<WorkItem> WorkQueue::AddWorkItem(std::function<void(unsigned threadIndex)> workFunction,
+    ea::span<const SharedPtr<WorkItem>> dependencies, unsigned priority)
+{
+    SharedPtr<WorkItem> item = GetFreeItem();
+    item->workLambda_ = std::move(workFunction);
+    item->workFunction_ = [](const WorkItem* item, unsigned threadIndex) { item->workLambda_(threadIndex); };
+    item->priority_ = priority;
+    AddWorkItem(item, dependencies);
+    return item;
+}
+
+void WorkQueue::ScheduleItem(WorkItem* item, unsigned threadIndex)
+{
+    WorkItem::State expected = WorkItem::State::Waiting;
+    if (!item->state_.compare_exchange_strong(expected, WorkItem::State::Queued, std::memory_order_acq_rel))
+        return;
+
+    // Queue holds its own reference, so cancelled items are safe to pop
+    item->AddRef();
+
+    if (item->mainThreadOnly_)
     {
-        bool inserted = false;
+        MutexLock<Mutex> lock(queueMutex_);
+        mainThreadQueue_.push_back(item);
+        numMainThreadQueued_.fetch_add(1, std::memory_order_release);
+        return;
+    }
+
+    if (item->IsImmediate() && deques_[threadIndex]->Push(item))
+        return;
 
-        for (auto i = queue_.begin(); i != queue_.end(); ++i)
+    MutexLock<Mutex> lock(queueMutex_);
+    auto i = queue_.begin();
+    while (i != queue_.end() && (*i)->priority_ > item->priority_)
+        ++i;
+    queue_.insert(i, item);
+    numQueued_.fetch_add(1, std::memory_order_release);
+}
+
+WorkItem* WorkQueue::TakeItem(unsigned threadIndex, unsigned priority)
+{
+    // Main thread serves its own items first
+    if (threadIndex == 0 && numMainThreadQueued_.load(std::memory_order_acquire) != 0)
+    {
+        MutexLock<Mutex> lock(queueMutex_);
+        for (auto i = mainThreadQueue_.begin(); i != mainThreadQueue_.end(); ++i)
         {
-            if ((*i)->priority_ <= item->priority_)
+            WorkItem* item = *i;
+            if (item->priority_ >= priority)
             {
-                queue_.insert(i, item.Get());
-                inserted = true;
-                break;
+                mainThreadQueue_.erase(i);
+                numMainThreadQueued_.fetch_sub(1, std::memory_order_relaxed);
+                return item;
             }
         }
+    }
 
-        if (!inserted)
-            queue_.push_back(item.Get());
+    // Own queue first, most recently pushed items are most likely to be hot in cache
+    if (WorkItem* item = deques_[threadIndex]->Pop())
+        return item;
+
+    // Steal from other threads, starting from the neighbour to spread the contention
+    const unsigned numDeques = deques_.size();
+    for (unsigned i = 1; i < numDeques; ++i)
+    {
+        if (WorkItem* item = deques_[(threadIndex + i) % numDeques]->Steal())
+            return item;
     }
 
-    if (threads_.size())
+    // Prioritized queue last
+    if (numQueued_.load(std::memory_order_acquire) != 0)
     {
-        queueMutex_.Release();
-        paused_ = false;
+        MutexLock<Mutex> lock(queueMutex_);
+        if (!queue_.empty() && queue_.front()->priority_ >= priority)
+        {
+            WorkItem* item = queue_.front();
+            queue_.pop_front();
+            numQueued_.fetch_sub(1, std::memory_order_relaxed);
+            return item;
+        }
     }
+
+    return nullptr;
 }
 
-SharedPtr<WorkItem> WorkQueue::AddWorkItem(std::function<void(unsigned threadIndex)> workFunction, unsigned priority)
+void WorkQueue::ExecuteItem(WorkItem* item, unsigned threadIndex)
 {
-    SharedPtr<WorkItem> item = GetFreeItem();
-    item->workLambda_ = std::move(workFunction);
-    item->workFunction_ = [](const WorkItem* item, unsigned threadIndex) { item->workLambda_(threadIndex); };
-    item->priority_ = priority;
-    AddWorkItem(item);
-    return item;
+    TryRunItem(item, threadIndex);
+    item->ReleaseRef();
 }
 
-bool WorkQueue::RemoveWorkItem(SharedPtr<WorkItem> item)
+bool WorkQueue::TryRunItem(WorkItem* item, unsigned threadIndex)
 {
-    if (!item)
+    WorkItem::State expected = WorkItem::State::Queued;
+    if (!item->state_.compare_exchange_strong(expected, WorkItem::State::Running, std::memory_order_acq_rel))
         return false;
 
-    MutexLock lock(queueMutex_);
+    item->workFunction_(item, threadIndex);
+    ReleaseDependents(item, threadIndex);
 
-    // Can only remove successfully if the item was not yet taken by threads for execution
-    auto i = ea::find(queue_.begin(), queue_.end(), item.Get());
-    if (i != queue_.end())
+    // Item may be recycled by the main thread as soon as it is marked completed
+    const bool isImmediate = item->IsImmediate();
+    item->state_.store(WorkItem::State::Finished, std::memory_order_relaxed);
+    item->completed_.store(true, std::memory_order_release);
+    if (isImmediate)
+        numImmediateIncomplete_.fetch_sub(1, std::memory_order_release);
+    return true;
+}
+
+void WorkQueue::ReleaseDependents(WorkItem* item, unsigned threadIndex)
+{
+    ea::vector<SharedPtr<WorkItem>> dependents;
     {
-        auto j = ea::find(workItems_.begin(), workItems_.end(), item);
-        if (j != workItems_.end())
+        MutexLock<SpinLockMutex> lock(item->dependentsLock_);
+        item->dependentsClosed_ = true;
+        dependents.swap(item->dependents_);
+    }
+
+    for (const SharedPtr<WorkItem>& dependent : dependents)
+    {
+        if (dependent->numDependencies_.fetch_sub(1, std::memory_order_acq_rel) == 1)
+            ScheduleItem(dependent.Get(), threadIndex);
+    }
+
+    if (!dependents.empty())
+    {
+        paused_ = false;
+        WakeThreads();
+    }
+}
+
+bool WorkQueue::CancelItem(WorkItem* item)
+{
+    // Try to cancel the item either waiting for dependencies or waiting in the queue
+    WorkItem::State expected = WorkItem::State::Waiting;
+    if (!item->state_.compare_exchange_strong(expected, WorkItem::State::Cancelled, std::memory_order_acq_rel))
+    {
+        expected = WorkItem::State::Queued;
+        if (!item->state_.compare_exchange_strong(expected, WorkItem::State::Cancelled, std::memory_order_acq_rel))
+            return false;
+
+        // Remove from prioritized queues if possible, otherwise the item will be skipped when popped from deque
+        MutexLock<Mutex> lock(queueMutex_);
+        auto i = ea::find(queue_.begin(), queue_.end(), item);
+        auto j = ea::find(mainThreadQueue_.begin(), mainThreadQueue_.end(), item);
+        if (i != queue_.end())
         {
             queue_.erase(i);
-            ReturnToPool(item);
-            workItems_.erase(j);
-            return true;
+            numQueued_.fetch_sub(1, std::memory_order_relaxed);
+            item->ReleaseRef();
+        }
+        else if (j != mainThreadQueue_.end())
+        {
+            mainThreadQueue_.erase(j);
+            numMainThreadQueued_.fetch_sub(1, std::memory_order_relaxed);
+            item->ReleaseRef();
         }
     }
 
+    // Don't leave dependent items waiting forever
+    ReleaseDependents(item, 0);
+    if (item->IsImmediate())
+        numImmediateIncomplete_.fetch_sub(1, std::memory_order_release);
+    return true;
+}
+
+bool WorkQueue::RemoveWorkItem(SharedPtr<WorkItem> item)
+{
+    if (!item)
+        return false;
+
+    // Can only remove successfully if the item was not yet taken by threads for execution
+    auto i = ea::find(workItems_.begin(), workItems_.end(), item);
+    if (i != workItems_.end() && CancelItem(item))
+    {
+        workItems_.erase(i);
+        return true;
+    }
+
     return false;
 }
 
 unsigned WorkQueue::RemoveWorkItems(const ea::vector<SharedPtr<WorkItem> >& items)
 {
-    MutexLock lock(queueMutex_);
     unsigned removed = 0;
 
     for (auto i = items.begin(); i != items.end(); ++i)
     {
-        auto j = ea::find(queue_.begin(), queue_.end(), i->Get());
-        if (j != queue_.end())
-        {
-            auto k = ea::find(workItems_.begin(), workItems_.end(), *i);
-            if (k != workItems_.end())
-            {
-                queue_.erase(j);
-                ReturnToPool(*k);
-                workItems_.erase(k);
-                ++removed;
-            }
-        }
+        if (RemoveWorkItem(*i))
+            ++removed;
     }
 
     return removed;
@@ -241,77 +393,102 @@ unsigned WorkQueue::RemoveWorkItems(const ea::vector<SharedPtr<WorkItem> >& item
 
 void WorkQueue::Pause()
 {
-    if (!paused_)
+    paused_ = true;
+}
+
+void WorkQueue::Resume()
+{
+    if (paused_)
     {
-        pausing_ = true;
+        paused_ = false;
+        WakeThreads();
+    }
+}
 
-        queueMutex_.Acquire();
-        paused_ = true;
+bool WorkQueue::HasQueuedWork() const
+{
+    if (numQueued_.load(std::memory_order_acquire) != 0)
+        return true;
 
-        pausing_ = false;
+    for (const auto& deque : deques_)
+    {
+        if (!deque->IsEmpty())
+            return true;
     }
+
+    return false;
 }
 
-void WorkQueue::Resume()
+void WorkQueue::WakeThreads()
 {
-    if (paused_)
+    // Pairs with the increment of sleeping threads counter before the last check for work
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (numSleeping_.load(std::memory_order_relaxed) != 0)
     {
-        queueMutex_.Release();
-        paused_ = false;
+        std::lock_guard<std::mutex> lock(sleepMutex_);
+        sleepCondition_.notify_all();
     }
 }
 
+void WorkQueue::WaitForWork()
+{
+    std::unique_lock<std::mutex> lock(sleepMutex_);
+    numSleeping_.fetch_add(1, std::memory_order_seq_cst);
+    sleepCondition_.wait(lock, [this] { return shutDown_ || (!paused_ && HasQueuedWork()); });
+    numSleeping_.fetch_sub(1, std::memory_order_relaxed);
+}
 
 void WorkQueue::Complete(unsigned priority)
 {
     completing_ = true;
+    Resume();
 
-    if (threads_.size())
+    // Take work items also in the main thread until all the work of interest is completed
+    while (!IsCompleted(priority))
     {
-        Resume();
+        if (WorkItem* item = TakeItem(0, priority))
+            ExecuteItem(item, 0);
+        else
+            std::this_thread::yield();
+    }
 
-        // Take work items also in the main thread until queue empty or no high-priority items anymore
-        while (!queue_.empty())
-        {
-            queueMutex_.Acquire();
-            if (!queue_.empty() && queue_.front()->priority_ >= priority)
-            {
-                WorkItem* item = queue_.front();
-                queue_.pop_front();
-                queueMutex_.Release();
-                item->workFunction_(item, 0);
-                item->completed_ = true;
-            }
-            else
-            {
-                queueMutex_.Release();
-                break;
-            }
-        }
+    // If no work at all remaining, pause worker threads
+    if (!threads_.empty() && !HasQueuedWork())
+        Pause();
 
-        // Wait for threaded work to complete
-        while (!IsCompleted(priority))
-        {
-        }
+    PurgeCompleted(priority);
+    completing_ = false;
+}
 
-        // If no work at all remaining, pause worker threads by leaving the mutex locked
-        if (queue_.empty())
-            Pause();
-    }
-    else
+void WorkQueue::CompleteItems(ea::span<const SharedPtr<WorkItem>> items)
+{
+    for (const SharedPtr<WorkItem>& item : items)
     {
-        // No worker threads: ensure all high-priority items are completed in the main thread
-        while (!queue_.empty() && queue_.front()->priority_ >= priority)
+        assert(item->state_.load(std::memory_order_relaxed) != WorkItem::State::Idle);
+
+        // Queued item stays in the queue and is skipped when taken by worker thread.
+        // Item waiting for dependencies is not runnable yet, so take other work meanwhile:
+        // dependencies may not be processed otherwise if there are no worker threads or they are paused
+        while (!TryRunItem(item, 0))
         {
-            WorkItem* item = queue_.front();
-            queue_.pop_front();
-            item->workFunction_(item, 0);
-            item->completed_ = true;
+            if (item->completed_.load(std::memory_order_acquire)
+                || item->state_.load(std::memory_order_relaxed) == WorkItem::State::Cancelled)
+                break;
+
+            if (WorkItem* otherItem = TakeItem(0, 0))
+                ExecuteItem(otherItem, 0);
+            else
+                std::this_thread::yield();
         }
     }
 
-    PurgeCompleted(priority);
-    completing_ = false;
+    // Remove all completed items in one pass
+    tempItems_.clear();
+    for (const SharedPtr<WorkItem>& item : items)
+        tempItems_.push_back(item.Get());
+    ea::sort(tempItems_.begin(), tempItems_.end());
+    workItems_.remove_if([&](const SharedPtr<WorkItem>& item)
+        { return ea::binary_search(tempItems_.begin(), tempItems_.end(), item.Get()); });
 }
 
 unsigned WorkQueue::GetNumIncomplete(unsigned priority) const
@@ -328,6 +505,10 @@ unsigned WorkQueue::GetNumIncomplete(unsigned priority) const
 
 bool WorkQueue::IsCompleted(unsigned priority) const
 {
+    // Fast path for immediate work
+    if (priority == M_MAX_UNSIGNED)
+        return numImmediateIncomplete_.load(std::memory_order_acquire) == 0;
+
     for (const auto & workItem : workItems_)
     {
         if (workItem->priority_ >= priority && !workItem->completed_)
@@ -339,36 +520,33 @@ bool WorkQueue::IsCompleted(unsigned priority) const
 
 void WorkQueue::ProcessItems(unsigned threadIndex)
 {
-    bool wasActive = false;
+    // Spin for a while before going to sleep, frame work usually comes in bursts
+    static const unsigned maxIdleSpins = 1024;
+    unsigned idleSpins = 0;
 
     for (;;)
     {
         if (shutDown_)
             return;
 
-        if (pausing_ && !wasActive)
-            Time::Sleep(0);
-        else
+        if (!paused_)
         {
-            queueMutex_.Acquire();
-            if (!queue_.empty())
+            if (WorkItem* item = TakeItem(threadIndex, 0))
             {
-                wasActive = true;
-
-                WorkItem* item = queue_.front();
-                queue_.pop_front();
-                queueMutex_.Release();
-                item->workFunction_(item, threadIndex);
-                item->completed_ = true;
+                ExecuteItem(item, threadIndex);
+                idleSpins = 0;
+                continue;
             }
-            else
-            {
-                wasActive = false;
 
-                queueMutex_.Release();
-                Time::Sleep(0);
+            if (++idleSpins < maxIdleSpins)
+            {
+                std::this_thread::yield();
+                continue;
             }
         }
+
+        idleSpins = 0;
+        WaitForWork();
     }
 }
 
@@ -390,7 +568,6 @@ void WorkQueue::PurgeCompleted(unsigned priority)
                 SendEvent(E_WORKITEMCOMPLETED, eventData);
             }
 
-            ReturnToPool(*i);
             i = workItems_.erase(i);
         }
         else
@@ -398,60 +575,26 @@ void WorkQueue::PurgeCompleted(unsigned priority)
     }
 }
 
-void WorkQueue::PurgePool()
-{
-    unsigned currentSize = poolItems_.size();
-    int difference = lastSize_ - currentSize;
-
-    // Difference tolerance, should be fairly significant to reduce the pool size.
-    for (unsigned i = 0; !poolItems_.empty() && difference > tolerance_ && i < (unsigned)difference; i++)
-        poolItems_.pop_front();
-
-    lastSize_ = currentSize;
-}
-
-void WorkQueue::ReturnToPool(SharedPtr<WorkItem>& item)
-{
-    // Check if this was a pooled item and set it to usable
-    if (item->pooled_)
-    {
-        // Reset the values to their defaults. This should
-        // be safe to do here as the completed event has
-        // already been handled and this is part of the
-        // internal pool.
-        item->start_ = nullptr;
-        item->end_ = nullptr;
-        item->aux_ = nullptr;
-        item->workFunction_ = nullptr;
-        item->priority_ = M_MAX_UNSIGNED;
-        item->sendEvent_ = false;
-        item->completed_ = false;
-
-        poolItems_.push_back(item);
-    }
-}
-
 void WorkQueue::HandleBeginFrame(StringHash eventType, VariantMap& eventData)
 {
     // If no worker threads, complete low-priority work here
-    if (threads_.empty() && !queue_.empty())
+    if (threads_.empty() && (HasQueuedWork() || numMainThreadQueued_.load(std::memory_order_relaxed) != 0))
     {
         URHO3D_PROFILE("CompleteWorkNonthreaded");
 
         HiresTimer timer;
 
-        while (!queue_.empty() && timer.GetUSec(false) < maxNonThreadedWorkMs_ * 1000LL)
+        while (timer.GetUSec(false) < maxNonThreadedWorkMs_ * 1000LL)
         {
-            WorkItem* item = queue_.front();
-            queue_.pop_front();
-            item->workFunction_(item, 0);
-            item->completed_ = true;
+            WorkItem* item = TakeItem(0, 0);
+            if (!item)
+                break;
+            ExecuteItem(item, 0);
         }
     }
 
     // Complete and signal items down to the lowest priority
     PurgeCompleted(0);
-    PurgePool();
 }
 
 unsigned WorkQueue::GetThreadIndex()
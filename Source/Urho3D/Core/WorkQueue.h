@@ -25,10 +25,15 @@
 #include "../Core/Mutex.h"
 #include "../Core/Object.h"
 #include "../Container/MultiVector.h"
+#include "../Container/PoolAllocator.h"
+#include "../Container/WorkStealingDeque.h"
 
 #include <EASTL/list.h>
 #include <EASTL/span.h>
+#include <EASTL/unique_ptr.h>
 #include <atomic>
+#include <condition_variable>
+#include <mutex>
 
 namespace Urho3D
 {
@@ -47,6 +52,8 @@ struct WorkItem : public RefCounted
 {
     friend class WorkQueue;
 
+    URHO3D_POOL_ALLOCATED();
+
 public:
     /// Work function. Called with the work item and thread index (0 = main thread) as parameters.
     void (* workFunction_)(const WorkItem*, unsigned){};
@@ -60,13 +67,38 @@ public:
     unsigned priority_{};
     /// Whether to send event on completion.
     bool sendEvent_{};
+    /// Whether the item may be executed only in the main thread.
+    bool mainThreadOnly_{};
     /// Completed flag.
     std::atomic<bool> completed_{};
 
+    /// Return whether the item is executed on work-stealing queues.
+    bool IsImmediate() const { return priority_ == M_MAX_UNSIGNED; }
+
 private:
-    bool pooled_{};
+    /// Execution state of the item.
+    enum class State
+    {
+        Idle,
+        Waiting,
+        Queued,
+        Running,
+        Finished,
+        Cancelled
+    };
+
     /// Work function. Called without any parameters.
     std::function<void(unsigned threadIndex)> workLambda_;
+    /// Current state.
+    std::atomic<State> state_{};
+    /// Number of dependencies that are not finished yet, plus one while the item is being submitted.
+    std::atomic<unsigned> numDependencies_{};
+    /// Lock for dependents list.
+    SpinLockMutex dependentsLock_;
+    /// Items waiting for this item. Protected by dependentsLock_.
+    ea::vector<SharedPtr<WorkItem>> dependents_;
+    /// Whether the item doesn't accept new dependents anymore. Protected by dependentsLock_.
+    bool dependentsClosed_{};
 };
 
 /// Work queue subsystem for multithreading.
@@ -84,12 +116,17 @@ public:
 
     /// Create worker threads. Can only be called once.
     void CreateThreads(unsigned numThreads);
-    /// Get pointer to an usable WorkItem from the item pool. Allocate one if no more free items.
+    /// Allocate new WorkItem. May be called from any thread.
     SharedPtr<WorkItem> GetFreeItem();
     /// Add a work item and resume worker threads.
     void AddWorkItem(const SharedPtr<WorkItem>& item);
+    /// Add a work item that is executed only after all dependencies are completed, and resume worker threads.
+    void AddWorkItem(const SharedPtr<WorkItem>& item, ea::span<const SharedPtr<WorkItem>> dependencies);
     /// Add a work item and resume worker threads.
     SharedPtr<WorkItem> AddWorkItem(std::function<void(unsigned threadIndex)> workFunction, unsigned priority = 0);
+    /// Add a work item that is executed only after all dependencies are completed, and resume worker threads.
+    SharedPtr<WorkItem> AddWorkItem(std::function<void(unsigned threadIndex)> workFunction,
+        ea::span<const SharedPtr<WorkItem>> dependencies, unsigned priority = 0);
     /// Remove a work item before it has started executing. Return true if successfully removed.
     bool RemoveWorkItem(SharedPtr<WorkItem> item);
     /// Remove a number of work items before they have started executing. Return the number of items successfully removed.
@@ -98,11 +135,11 @@ public:
     void Pause();
     /// Resume worker threads.
     void Resume();
-    /// Finish all queued work which has at least the specified priority. Main thread will also execute priority work. Pause worker threads if no more work remains.
+    /// Finish all queued work which has at least the specified priority. Main thread executes work while waiting. Pause worker threads if no more work remains.
     void Complete(unsigned priority);
-
-    /// Set the pool telerance before it starts deleting pool items.
-    void SetTolerance(int tolerance) { tolerance_ = tolerance; }
+    /// Finish specified work items only. Items not yet taken by worker threads are executed in the main thread.
+    /// Main thread also executes other work while items wait for their dependencies. Completed items are removed from the queue without completion events.
+    void CompleteItems(ea::span<const SharedPtr<WorkItem>> items);
 
     /// Set how many milliseconds maximum per frame to spend on low-priority work, when there are no worker threads.
     void SetNonThreadedWorkMs(int ms) { maxNonThreadedWorkMs_ = Max(ms, 1); }
@@ -117,9 +154,6 @@ public:
     /// Return whether the queue is currently completing work in the main thread.
     bool IsCompleting() const { return completing_; }
 
-    /// Return the pool tolerance.
-    int GetTolerance() const { return tolerance_; }
-
     /// Return how many milliseconds maximum to spend on non-threaded low-priority work.
     int GetNonThreadedWorkMs() const { return maxNonThreadedWorkMs_; }
 
@@ -131,50 +165,76 @@ public:
 private:
     /// Process work items until shut down. Called by the worker threads.
     void ProcessItems(unsigned threadIndex);
+    /// Put item with resolved dependencies into the queue. May be called from any WorkQueue thread.
+    void ScheduleItem(WorkItem* item, unsigned threadIndex);
+    /// Take item with at least the specified priority for execution. Return null if nothing found.
+    WorkItem* TakeItem(unsigned threadIndex, unsigned priority);
+    /// Execute taken item and release dependent items.
+    void ExecuteItem(WorkItem* item, unsigned threadIndex);
+    /// Run queued item if it wasn't started yet. Return whether the item was run.
+    bool TryRunItem(WorkItem* item, unsigned threadIndex);
+    /// Release dependent items of finished or cancelled item.
+    void ReleaseDependents(WorkItem* item, unsigned threadIndex);
+    /// Cancel item that was not started yet. Main thread only.
+    bool CancelItem(WorkItem* item);
+    /// Return whether there is any work available for worker threads.
+    bool HasQueuedWork() const;
+    /// Wake up sleeping worker threads.
+    void WakeThreads();
+    /// Block worker thread until there's some work.
+    void WaitForWork();
     /// Purge completed work items which have at least the specified priority, and send completion events as necessary.
     void PurgeCompleted(unsigned priority);
-    /// Purge the pool to reduce allocation where its unneeded.
-    void PurgePool();
-    /// Return a work item to the pool.
-    void ReturnToPool(SharedPtr<WorkItem>& item);
     /// Handle frame start event. Purge completed work from the main thread queue, and perform work if no threads at all.
     void HandleBeginFrame(StringHash eventType, VariantMap& eventData);
 
     /// Worker threads.
     ea::vector<SharedPtr<WorkerThread> > threads_;
-    /// Work item pool for reuse to cut down on allocation. The bool is a flag for item pooling and whether it is available or not.
-    ea::list<SharedPtr<WorkItem> > poolItems_;
     /// Work item collection. Accessed only by the main thread.
     ea::list<SharedPtr<WorkItem> > workItems_;
-    /// Work item prioritized queue for worker threads. Pointers are guaranteed to be valid (point to workItems).
+    /// Temporary buffer of work items. Accessed only by the main thread.
+    ea::vector<WorkItem*> tempItems_;
+    /// Per-thread work-stealing queues for immediate work items. Each queued item holds a reference.
+    ea::vector<ea::unique_ptr<WorkStealingDeque<WorkItem>>> deques_;
+    /// Work item prioritized queue for non-immediate items and for immediate items that didn't fit into deques.
+    /// Each queued item holds a reference.
     ea::list<WorkItem*> queue_;
-    /// Worker queue mutex.
+    /// Number of items in prioritized queue.
+    std::atomic<unsigned> numQueued_;
+    /// Items that should be executed only in the main thread. Each queued item holds a reference.
+    ea::vector<WorkItem*> mainThreadQueue_;
+    /// Number of items in main thread queue.
+    std::atomic<unsigned> numMainThreadQueued_;
+    /// Prioritized queue mutex.
     Mutex queueMutex_;
+    /// Number of immediate items that are submitted and neither finished nor cancelled.
+    std::atomic<unsigned> numImmediateIncomplete_;
+    /// Mutex for sleeping worker threads.
+    std::mutex sleepMutex_;
+    /// Condition for sleeping worker threads.
+    std::condition_variable sleepCondition_;
+    /// Number of sleeping worker threads.
+    std::atomic<unsigned> numSleeping_;
     /// Shutting down flag.
     std::atomic<bool> shutDown_;
-    /// Pausing flag. Indicates the worker threads should not contend for the queue mutex.
-    std::atomic<bool> pausing_;
-    /// Paused flag. Indicates the queue mutex being locked to prevent worker threads using up CPU time.
-    bool paused_;
+    /// Paused flag. Indicates the worker threads should sleep instead of taking new work.
+    std::atomic<bool> paused_;
     /// Completing work in the main thread flag.
     bool completing_;
-    /// Tolerance for the shared pool before it begins to deallocate.
-    int tolerance_;
-    /// Last size of the shared pool.
-    unsigned lastSize_;
     /// Maximum milliseconds per frame to spend on low-priority work, when there are no worker threads.
     int maxNonThreadedWorkMs_;
 };
 
 /// Vector-like collection that can be safely filled from different WorkQueue threads simultaneously.
-template <class T>
-class WorkQueueVector : public MultiVector<T>
+/// Use EASTLFrameAllocator for collections that are rebuilt every frame.
+template <class T, class Allocator = EASTLAllocatorType>
+class WorkQueueVector : public MultiVector<T, Allocator>
 {
 public:
     /// Clear collection, considering number of threads in WorkQueue.
     void Clear()
     {
-        MultiVector<T>::Clear(WorkQueue::GetMaxThreadIndex());
+        MultiVector<T, Allocator>::Clear(WorkQueue::GetMaxThreadIndex());
     }
 
     /// Insert new element. Thread-safe as long as called from WorkQueue threads (or main thread).
@@ -208,22 +268,40 @@ void ForEachParallel(WorkQueue* workQueue, unsigned bucket, unsigned size, Callb
         return;
     }
 
-    std::atomic<unsigned> offset = 0;
-    const unsigned maxThreads = workQueue->GetNumThreads() + 1;
-    for (unsigned i = 0; i < maxThreads; ++i)
+    struct ParallelContext
     {
-        workQueue->AddWorkItem([=, &offset](unsigned /*threadIndex*/) mutable
+        const Callback* callback_;
+        std::atomic<unsigned> offset_;
+        unsigned bucket_;
+        unsigned size_;
+    };
+
+    ParallelContext parallelContext{ &callback, 0, bucket, size };
+    const auto workFunction = [](const WorkItem* item, unsigned /*threadIndex*/)
+    {
+        auto& ctx = *static_cast<ParallelContext*>(item->aux_);
+        Callback threadCallback = *ctx.callback_;
+        while (true)
         {
-            while (true)
-            {
-                const unsigned beginIndex = offset.fetch_add(bucket, std::memory_order_relaxed);
-                if (beginIndex >= size)
-                    break;
-
-                const unsigned endIndex = ea::min(beginIndex + bucket, size);
-                callback(beginIndex, endIndex);
-            }
-        }, M_MAX_UNSIGNED);
+            const unsigned beginIndex = ctx.offset_.fetch_add(ctx.bucket_, std::memory_order_relaxed);
+            if (beginIndex >= ctx.size_)
+                break;
+
+            const unsigned endIndex = ea::min(beginIndex + ctx.bucket_, ctx.size_);
+            threadCallback(beginIndex, endIndex);
+        }
+    };
+
+    // Don't spawn more items than there are buckets, main thread is going to help anyway
+    const unsigned numBuckets = (size + bucket - 1) / bucket;
+    const unsigned maxThreads = ea::min(workQueue->GetNumThreads() + 1, numBuckets);
+    for (unsigned i = 0; i < maxThreads; ++i)
+    {
+        SharedPtr<WorkItem> item = workQueue->GetFreeItem();
+        item->workFunction_ = workFunction;
+        item->aux_ = &parallelContext;
+        item->priority_ = M_MAX_UNSIGNED;
+        workQueue->AddWorkItem(item);
     }
     workQueue->Complete(M_MAX_UNSIGNED);
 }
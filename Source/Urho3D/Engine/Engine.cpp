@@ -203,6 +203,7 @@ bool Engine::Initialize(const VariantMap& parameters)
 
     // Set headless mode
     headless_ = GetParameter(parameters, EP_HEADLESS, false).GetBool();
+    const bool nullGraphics = headless_ && GetParameter(parameters, EP_NULL_GRAPHICS, false).GetBool();
 
     // Register the rest of the subsystems
     context_->RegisterSubsystem(new Input(context_));
@@ -212,6 +213,11 @@ bool Engine::Initialize(const VariantMap& parameters)
         context_->RegisterSubsystem(new Graphics(context_));
         context_->RegisterSubsystem(new Renderer(context_));
     }
+    else if (nullGraphics)
+    {
+        // Renderer is created after resource paths are set
+        context_->RegisterSubsystem(new Graphics(context_));
+    }
     else
     {
         // Register graphics library objects explicitly in headless mode to allow them to work without using actual GPU resources
@@ -249,6 +255,15 @@ bool Engine::Initialize(const VariantMap& parameters)
     auto* cache = GetSubsystem<ResourceCache>();
     auto* fileSystem = GetSubsystem<FileSystem>();
 
+    // Initialize null device to update render pipeline on CPU without drawing anything
+    if (nullGraphics)
+    {
+        GetSubsystem<Graphics>()->SetNullDevice(
+            GetParameter(parameters, EP_WINDOW_WIDTH, 1920).GetInt(),
+            GetParameter(parameters, EP_WINDOW_HEIGHT, 1080).GetInt());
+        context_->RegisterSubsystem(new Renderer(context_));
+    }
+
     // Initialize graphics & audio output
     if (!headless_)
     {
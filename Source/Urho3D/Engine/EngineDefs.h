@@ -40,6 +40,7 @@ static const ea::string EP_FRAME_LIMITER = "FrameLimiter";
 static const ea::string EP_FULL_SCREEN = "FullScreen";
 static const ea::string EP_GPU_DEBUG = "GPUDebug";
 static const ea::string EP_HEADLESS = "Headless";
+static const ea::string EP_NULL_GRAPHICS = "NullGraphics";
 static const ea::string EP_VALIDATE_SHADERS = "ValidateShaders";
 static const ea::string EP_HIGH_DPI = "HighDPI";
 static const ea::string EP_LOG_LEVEL = "LogLevel";
@@ -119,6 +119,8 @@ void AnimatedModel::RegisterObject(Context* context)
     URHO3D_ACCESSOR_ATTRIBUTE("Can Be Occluded", IsOccludee, SetOccludee, bool, true, AM_DEFAULT);
     URHO3D_ATTRIBUTE("Cast Shadows", bool, castShadows_, false, AM_DEFAULT);
     URHO3D_ACCESSOR_ATTRIBUTE("Update When Invisible", GetUpdateInvisible, SetUpdateInvisible, bool, false, AM_DEFAULT);
+    URHO3D_ACCESSOR_ATTRIBUTE("Lazy Bone Update", GetLazyBoneUpdate, SetLazyBoneUpdate, bool, false, AM_DEFAULT);
+    URHO3D_ACCESSOR_ATTRIBUTE("Use Pose Cache", GetUsePoseCache, SetUsePoseCache, bool, false, AM_DEFAULT);
     URHO3D_ACCESSOR_ATTRIBUTE("Draw Distance", GetDrawDistance, SetDrawDistance, float, 0.0f, AM_DEFAULT);
     URHO3D_ACCESSOR_ATTRIBUTE("Shadow Distance", GetShadowDistance, SetShadowDistance, float, 0.0f, AM_DEFAULT);
     URHO3D_ACCESSOR_ATTRIBUTE("LOD Bias", GetLodBias, SetLodBias, float, 1.0f, AM_DEFAULT);
@@ -177,6 +179,15 @@ bool AnimatedModel::LoadJSON(const JSONValue& source)
     return success;
 }
 
+bool AnimatedModel::LoadAttributeValues(const ea::vector<ea::pair<unsigned, Variant>>& values)
+{
+    loading_ = true;
+    bool success = Component::LoadAttributeValues(values);
+    loading_ = false;
+
+    return success;
+}
+
 void AnimatedModel::ApplyAttributes()
 {
     if (assignBonesPending_)
@@ -213,7 +224,7 @@ void AnimatedModel::ProcessRayQuery(const RayOctreeQuery& query, ea::vector<RayQ
         {
             // Do an initial crude test using the bone's AABB
             const BoundingBox& box = bone.boundingBox_;
-            const Matrix3x4& transform = bone.node_->GetWorldTransform();
+            const Matrix3x4 transform = GetBoneWorldTransform(i);
             distance = query.ray_.HitDistance(box.Transformed(transform));
             if (distance >= query.maxDistance_)
                 continue;
@@ -229,7 +240,7 @@ void AnimatedModel::ProcessRayQuery(const RayOctreeQuery& query, ea::vector<RayQ
         }
         else if (bone.collisionMask_ & BONECOLLISION_SPHERE)
         {
-            boneSphere.center_ = bone.node_->GetWorldPosition();
+            boneSphere.center_ = GetBoneWorldTransform(i).Translation();
             boneSphere.radius_ = bone.radius_;
             distance = query.ray_.HitDistance(boneSphere);
             if (distance >= query.maxDistance_)
@@ -350,6 +361,7 @@ void AnimatedModel::DrawDebugGeometry(DebugRenderer* debug, bool depthTest)
     if (debug && IsEnabledEffective())
     {
         debug->AddBoundingBox(GetWorldBoundingBox(), Color::GREEN, depthTest);
+        UpdateBoneNodes();
         debug->AddSkeleton(skeleton_, Color(0.75f, 0.75f, 0.75f), depthTest);
     }
 }
@@ -572,6 +584,57 @@ void AnimatedModel::SetAnimationLodBias(float bias)
     MarkNetworkUpdate();
 }
 
+void AnimatedModel::SetLazyBoneUpdate(bool enable)
+{
+    lazyBoneUpdate_ = enable;
+    if (!lazyBoneUpdate_)
+        UpdateBoneNodes();
+}
+
+void AnimatedModel::SetUsePoseCache(bool enable)
+{
+    if (usePoseCache_ != enable)
+    {
+        usePoseCache_ = enable;
+        MarkAnimationDirty();
+    }
+}
+
+void AnimatedModel::UpdateBoneNodes()
+{
+    if (!boneNodesDirty_ || !node_)
+        return;
+
+    boneNodesDirty_ = false;
+
+    const ea::vector<Bone>& bones = skeleton_.GetBones();
+    if (localPose_.positions_.size() != bones.size())
+        return;
+
+    for (unsigned i = 0; i < bones.size(); ++i)
+    {
+        const Bone& bone = bones[i];
+        if (bone.animated_ && bone.node_)
+            bone.node_->SetTransformSilent(localPose_.positions_[i], localPose_.rotations_[i], localPose_.scales_[i]);
+    }
+
+    // Transforms are applied silently to avoid repeated marking dirty. Mark dirty now
+    node_->MarkDirty();
+}
+
+Matrix3x4 AnimatedModel::GetBoneWorldTransform(unsigned index) const
+{
+    if (!node_)
+        return Matrix3x4::IDENTITY;
+
+    if (poseSkinning_ && index < boneModelTransforms_.size())
+        return node_->GetWorldTransform() * boneModelTransforms_[index];
+
+    const ea::vector<Bone>& bones = skeleton_.GetBones();
+    Node* boneNode = index < bones.size() ? bones[index].node_.Get() : nullptr;
+    return boneNode ? boneNode->GetWorldTransform() : node_->GetWorldTransform();
+}
+
 void AnimatedModel::SetUpdateInvisible(bool enable)
 {
     updateInvisible_ = enable;
@@ -729,6 +792,8 @@ AnimationState* AnimatedModel::GetAnimationState(unsigned index) const
 
 void AnimatedModel::SetSkeleton(const Skeleton& skeleton, bool createBones)
 {
+    boneOrderDirty_ = true;
+
     if (!node_ && createBones)
     {
         URHO3D_LOGERROR("AnimatedModel not attached to a scene node, can not create bone nodes");
@@ -948,6 +1013,22 @@ void AnimatedModel::UpdateBoneBoundingBox()
         Matrix3x4 inverseNodeTransform = node_->GetWorldTransform().Inverse();
 
         const ea::vector<Bone>& bones = skeleton_.GetBones();
+        if (poseSkinning_ && boneModelTransforms_.size() == bones.size())
+        {
+            for (unsigned i = 0; i < bones.size(); ++i)
+            {
+                const Bone& bone = bones[i];
+                if (bone.collisionMask_ & BONECOLLISION_BOX)
+                    boneBoundingBox_.Merge(bone.boundingBox_.Transformed(boneModelTransforms_[i]));
+                else if (bone.collisionMask_ & BONECOLLISION_SPHERE)
+                    boneBoundingBox_.Merge(Sphere(boneModelTransforms_[i].Translation(), bone.radius_ * 0.5f));
+            }
+
+            boneBoundingBoxDirty_ = false;
+            worldBoundingBoxDirty_ = true;
+            return;
+        }
+
         for (auto i = bones.begin(); i != bones.end(); ++i)
         {
             Node* boneNode = i->node_;
@@ -988,7 +1069,23 @@ void AnimatedModel::OnMarkedDirty(Node* node)
         skinningDirty_ = true;
         // Bone bounding box doesn't need to be marked dirty when only the base scene node moves
         if (node != node_)
+        {
             boneBoundingBoxDirty_ = true;
+            // Bone node is changed directly rather than moved together with the model, follow bone nodes until next animation update
+            if (!node_->IsDirty())
+            {
+                // Lazily updated bone nodes are out of date, write the pose first. Keep the transform of the changed node
+                if (poseSkinning_ && boneNodesDirty_)
+                {
+                    const Vector3 position = node->GetPosition();
+                    const Quaternion rotation = node->GetRotation();
+                    const Vector3 scale = node->GetScale();
+                    UpdateBoneNodes();
+                    node->SetTransformSilent(position, rotation, scale);
+                }
+                poseSkinning_ = false;
+            }
+        }
     }
 }
 
@@ -1015,6 +1112,7 @@ void AnimatedModel::OnWorldBoundingBoxUpdate()
 void AnimatedModel::AssignBoneNodes()
 {
     assignBonesPending_ = false;
+    boneOrderDirty_ = true;
 
     if (!node_)
         return;
@@ -1189,6 +1287,8 @@ void AnimatedModel::SetGeometryBoneMappings()
 
 void AnimatedModel::UpdateAnimation(const FrameInfo& frame)
 {
+    animationFrameNumber_ = frame.frameNumber_;
+
     // If using animation LOD, accumulate time and see if it is time to update
     if (animationLodBias_ > 0.0f && animationLodDistance_ > 0.0f)
     {
@@ -1219,8 +1319,15 @@ void AnimatedModel::ApplyAnimation()
 
     // Reset skeleton, apply all animations, calculate bones' bounding box. Make sure this is only done for the master model
     // (first AnimatedModel in a node)
-    if (isMaster_)
+    if (isMaster_ && UpdateBoneHierarchy())
+        ApplyAnimationToPose();
+    else if (isMaster_)
     {
+        poseSkinning_ = false;
+        boneNodesDirty_ = false;
+        boneModelTransforms_.clear();
+        sharedPose_ = nullptr;
+
         skeleton_.ResetSilent();
         for (auto i = animationStates_.begin(); i !=
             animationStates_.end(); ++i)
@@ -1236,6 +1343,191 @@ void AnimatedModel::ApplyAnimation()
     animationDirty_ = false;
 }
 
+bool AnimatedModel::UpdateBoneHierarchy()
+{
+    const ea::vector<Bone>& bones = skeleton_.GetBones();
+    const unsigned numBones = bones.size();
+    const auto isRootBone = [&](unsigned index) { return bones[index].parentIndex_ == index || bones[index].parentIndex_ >= numBones; };
+
+    if (boneOrderDirty_)
+    {
+        boneOrderDirty_ = false;
+        boneOrder_.clear();
+        numChildBones_.clear();
+        numChildBones_.resize(numBones);
+
+        for (unsigned i = 0; i < numBones; ++i)
+        {
+            if (isRootBone(i))
+                boneOrder_.push_back(i);
+            else
+                ++numChildBones_[bones[i].parentIndex_];
+        }
+
+        // Breadth-first traversal, bones not reachable from roots are not added
+        for (unsigned i = 0; i < boneOrder_.size(); ++i)
+        {
+            const unsigned parentIndex = boneOrder_[i];
+            for (unsigned j = 0; j < numBones; ++j)
+            {
+                if (j != parentIndex && bones[j].parentIndex_ == parentIndex)
+                    boneOrder_.push_back(j);
+            }
+        }
+    }
+
+    if (!node_ || !numBones || boneOrder_.size() != numBones)
+        return false;
+
+    // Bone nodes may be reparented or removed at any time, so check them on each update
+    for (unsigned i = 0; i < numBones; ++i)
+    {
+        Node* boneNode = bones[i].node_;
+        const Node* expectedParent = isRootBone(i) ? node_ : bones[bones[i].parentIndex_].node_.Get();
+        if (!boneNode || boneNode->GetParent() != expectedParent)
+            return false;
+    }
+    return true;
+}
+
+void AnimatedModel::ApplyAnimationToPose()
+{
+    AnimationPoseCache* poseCache = GetPoseCache();
+    if (!poseCache)
+    {
+        sharedPose_ = nullptr;
+        EvaluatePose(localPose_, boneModelTransforms_, nullptr);
+    }
+    else
+    {
+        // Identical model and animation states produce identical pose
+        poseCacheKey_.clear();
+        poseCacheKey_.push_back(model_->GetNameHash().Value());
+        for (const SharedPtr<AnimationState>& state : animationStates_)
+            state->AppendPoseKey(poseCacheKey_, state->GetQuantizedTime(poseCache->GetTimeStep()));
+
+        sharedPose_ = poseCache->FindPose(poseCacheKey_, animationFrameNumber_);
+        if (!sharedPose_)
+        {
+            auto pose = ea::make_shared<SharedAnimationPose>();
+            EvaluatePose(pose->localPose_, pose->boneModelTransforms_, poseCache);
+
+            const ea::vector<Bone>& bones = skeleton_.GetBones();
+            pose->skinMatrices_.resize(bones.size());
+            for (unsigned i = 0; i < bones.size(); ++i)
+                pose->skinMatrices_[i] = pose->boneModelTransforms_[i] * bones[i].offsetMatrix_;
+
+            sharedPose_ = poseCache->StorePose(poseCacheKey_, animationFrameNumber_, pose);
+        }
+
+        localPose_ = sharedPose_->localPose_;
+        boneModelTransforms_ = sharedPose_->boneModelTransforms_;
+    }
+
+    poseSkinning_ = true;
+    boneNodesDirty_ = true;
+    skinningDirty_ = true;
+    if (!lazyBoneUpdate_ || AreBoneNodesObserved())
+        UpdateBoneNodes();
+
+    UpdateBoneBoundingBox();
+    MarkForUpdate();
+}
+
+void AnimatedModel::EvaluatePose(AnimationPose& localPose, ea::vector<Matrix3x4>& boneModelTransforms,
+    const AnimationPoseCache* poseCache) const
+{
+    const ea::vector<Bone>& bones = skeleton_.GetBones();
+    const unsigned numBones = bones.size();
+
+    // Reset animated bones to initial pose, take the rest from bone nodes
+    if (localPose.positions_.size() != numBones)
+        localPose.Reset(numBones);
+    for (unsigned i = 0; i < numBones; ++i)
+    {
+        const Bone& bone = bones[i];
+        if (bone.animated_)
+        {
+            localPose.positions_[i] = bone.initialPosition_;
+            localPose.rotations_[i] = bone.initialRotation_;
+            localPose.scales_[i] = bone.initialScale_;
+        }
+        else
+        {
+            localPose.positions_[i] = bone.node_->GetPosition();
+            localPose.rotations_[i] = bone.node_->GetRotation();
+            localPose.scales_[i] = bone.node_->GetScale();
+        }
+    }
+
+    for (const SharedPtr<AnimationState>& state : animationStates_)
+    {
+        if (poseCache)
+            state->ApplyToPose(localPose, state->GetQuantizedTime(poseCache->GetTimeStep()));
+        else
+            state->ApplyToPose(localPose);
+    }
+
+    // Calculate bone transforms relative to the model node in the flat hierarchy
+    boneModelTransforms.resize(numBones);
+    for (const unsigned index : boneOrder_)
+    {
+        const Matrix3x4 localTransform{ localPose.positions_[index], localPose.rotations_[index], localPose.scales_[index] };
+        const unsigned parentIndex = bones[index].parentIndex_;
+        if (parentIndex == index || parentIndex >= numBones)
+            boneModelTransforms[index] = localTransform;
+        else
+            boneModelTransforms[index] = boneModelTransforms[parentIndex] * localTransform;
+    }
+}
+
+AnimationPoseCache* AnimatedModel::GetPoseCache() const
+{
+    Scene* scene = GetScene();
+    if (!usePoseCache_ || !model_ || !scene)
+        return nullptr;
+
+    // Shared pose is identified by resource names, so unnamed resources cannot be shared
+    if (model_->GetName().empty())
+        return nullptr;
+    for (const SharedPtr<AnimationState>& state : animationStates_)
+    {
+        Animation* animation = state->GetAnimation();
+        if (animation && animation->GetName().empty())
+            return nullptr;
+    }
+
+    // Bones with disabled animation are controlled by each model individually
+    for (const Bone& bone : skeleton_.GetBones())
+    {
+        if (!bone.animated_)
+            return nullptr;
+    }
+
+    return scene->GetComponent<AnimationPoseCache>();
+}
+
+bool AnimatedModel::AreBoneNodesObserved() const
+{
+    // Other animated models in the node use the same bone nodes for skinning
+    unsigned numAnimatedModels = 0;
+    for (const SharedPtr<Component>& component : node_->GetComponents())
+    {
+        if (component->GetType() == GetTypeStatic() && ++numAnimatedModels > 1)
+            return true;
+    }
+
+    // Attachments and components on bone nodes depend on bone transforms
+    const ea::vector<Bone>& bones = skeleton_.GetBones();
+    for (unsigned i = 0; i < bones.size(); ++i)
+    {
+        const Node* boneNode = bones[i].node_;
+        if (boneNode->GetNumComponents() != 0 || boneNode->GetNumChildren() != numChildBones_[i])
+            return true;
+    }
+    return false;
+}
+
 void AnimatedModel::UpdateSkinning()
 {
     // Note: the model's world transform will be baked in the skin matrices
@@ -1243,8 +1535,29 @@ void AnimatedModel::UpdateSkinning()
     // Use model's world transform in case a bone is missing
     const Matrix3x4& worldTransform = node_->GetWorldTransform();
 
+    // Skinning with bone transforms from the pose, bone nodes may be out of date
+    if (poseSkinning_ && boneModelTransforms_.size() == bones.size())
+    {
+        // Shared pose already contains skin matrices relative to the model node
+        if (sharedPose_ && sharedPose_->skinMatrices_.size() == bones.size())
+        {
+            for (unsigned i = 0; i < bones.size(); ++i)
+                skinMatrices_[i] = worldTransform * sharedPose_->skinMatrices_[i];
+        }
+        else
+        {
+            for (unsigned i = 0; i < bones.size(); ++i)
+                skinMatrices_[i] = worldTransform * boneModelTransforms_[i] * bones[i].offsetMatrix_;
+        }
+
+        for (unsigned i = 0; i < geometrySkinMatrixPtrs_.size(); ++i)
+        {
+            for (unsigned j = 0; j < geometrySkinMatrixPtrs_[i].size(); ++j)
+                *geometrySkinMatrixPtrs_[i][j] = skinMatrices_[i];
+        }
+    }
     // Skinning with global matrices only
-    if (!geometrySkinMatrices_.size())
+    else if (!geometrySkinMatrices_.size())
     {
         for (unsigned i = 0; i < bones.size(); ++i)
         {
@@ -22,6 +22,7 @@
 
 #pragma once
 
+#include "../Graphics/AnimationPoseCache.h"
 #include "../Graphics/Model.h"
 #include "../Graphics/Skeleton.h"
 #include "../Graphics/StaticModel.h"
@@ -60,6 +61,8 @@ public:
     bool LoadXML(const XMLElement& source) override;
     /// Load from JSON data. Return true if successful.
     bool LoadJSON(const JSONValue& source) override;
+    /// Load attribute values parsed in advance. Return true if successful.
+    bool LoadAttributeValues(const ea::vector<ea::pair<unsigned, Variant>>& values) override;
     /// Apply attribute changes that can not be applied immediately. Called after scene load or a network update.
     void ApplyAttributes() override;
     /// Process octree raycast. May be called from a worker thread.
@@ -108,6 +111,17 @@ public:
     void ResetMorphWeights();
     /// Apply all animation states to nodes.
     void ApplyAnimation();
+    /// Set whether to write animated transforms to bone nodes only when bone nodes are observed.
+    /// Bone nodes are observed if they have components or child nodes other than bones, or if there are other animated models in the node.
+    /// Otherwise bone nodes are updated on demand by UpdateBoneNodes().
+    /// @property
+    void SetLazyBoneUpdate(bool enable);
+    /// Write animated transforms to bone nodes if they are out of date.
+    void UpdateBoneNodes();
+    /// Set whether to share evaluated pose with other models via AnimationPoseCache of the scene.
+    /// Pose is not shared if the model has bones with disabled animation, or if model or animations are not named resources.
+    /// @property
+    void SetUsePoseCache(bool enable);
 
     /// Return skeleton.
     /// @property
@@ -138,6 +152,25 @@ public:
     /// @property
     bool GetUpdateInvisible() const { return updateInvisible_; }
 
+    /// Return whether to write animated transforms to bone nodes only when bone nodes are observed.
+    /// @property
+    bool GetLazyBoneUpdate() const { return lazyBoneUpdate_; }
+
+    /// Return whether to share evaluated pose with other models via AnimationPoseCache of the scene.
+    /// @property
+    bool GetUsePoseCache() const { return usePoseCache_; }
+
+    /// Return whether bone nodes are out of date.
+    bool AreBoneNodesDirty() const { return boneNodesDirty_; }
+    /// Return pose shared with other models as of last animation update, if any.
+    const SharedAnimationPose* GetSharedPose() const { return sharedPose_.get(); }
+
+    /// Return bone transforms relative to the model node as of last animation update. Empty if animation is applied to bone nodes.
+    const ea::vector<Matrix3x4>& GetBoneModelTransforms() const { return boneModelTransforms_; }
+
+    /// Return world transform of the bone by index. Valid even if bone nodes are out of date.
+    Matrix3x4 GetBoneWorldTransform(unsigned index) const;
+
     /// Return all vertex morphs.
     const ea::vector<ModelMorph>& GetMorphs() const { return morphs_; }
 
@@ -181,6 +214,8 @@ public:
 
     /// Return per-geometry skin matrices. If empty, uses global skinning.
     const ea::vector<ea::vector<Matrix3x4> >& GetGeometrySkinMatrices() const { return geometrySkinMatrices_; }
+    /// Return global skin matrices of all bones.
+    const ea::vector<Matrix3x4>& GetSkinMatrices() const { return skinMatrices_; }
 
     /// Recalculate the bone bounding box. Normally called internally, but can also be manually called if up-to-date information before rendering is necessary.
     void UpdateBoneBoundingBox();
@@ -214,6 +249,17 @@ private:
     void CloneGeometries();
     /// Recalculate animations. Called from Update().
     void UpdateAnimation(const FrameInfo& frame);
+    /// Rebuild bone evaluation order if needed. Return whether bone nodes match skeleton hierarchy.
+    bool UpdateBoneHierarchy();
+    /// Apply all animation states to local pose and calculate bone transforms relative to the model node.
+    void ApplyAnimationToPose();
+    /// Evaluate local pose and bone transforms relative to the model node.
+    /// If pose cache is specified, animations are sampled at quantized time.
+    void EvaluatePose(AnimationPose& localPose, ea::vector<Matrix3x4>& boneModelTransforms, const AnimationPoseCache* poseCache) const;
+    /// Return pose cache to use, if any. Pose cache is used only if the pose is identified by resource names and animation states.
+    AnimationPoseCache* GetPoseCache() const;
+    /// Return whether bone nodes are observed by anything except this model.
+    bool AreBoneNodesObserved() const;
     /// Recalculate skinning.
     void UpdateSkinning();
     /// Reapply all vertex morphs.
@@ -231,6 +277,18 @@ private:
     ea::vector<SharedPtr<AnimationState> > animationStates_;
     /// Skinning matrices.
     ea::vector<Matrix3x4> skinMatrices_;
+    /// Local pose of bones, indexed by bone index.
+    AnimationPose localPose_;
+    /// Bone transforms relative to the model node, indexed by bone index.
+    ea::vector<Matrix3x4> boneModelTransforms_;
+    /// Pose shared with other models.
+    ea::shared_ptr<const SharedAnimationPose> sharedPose_;
+    /// Key of the shared pose.
+    ea::vector<unsigned> poseCacheKey_;
+    /// Bone indices in evaluation order, parents are stored before children.
+    ea::vector<unsigned> boneOrder_;
+    /// Number of child bones of each bone.
+    ea::vector<unsigned> numChildBones_;
     /// Mapping of subgeometry bone indices, used if more bones than skinning shader can manage.
     ea::vector<ea::vector<unsigned> > geometryBoneMappings_;
     /// Subgeometry skinning matrices, used if more bones than skinning shader can manage.
@@ -241,6 +299,8 @@ private:
     BoundingBox boneBoundingBox_;
     /// Attribute buffer.
     mutable VectorBuffer attrBuffer_;
+    /// The frame number animation was last updated on.
+    unsigned animationFrameNumber_{};
     /// The frame number animation LOD distance was last calculated on.
     unsigned animationLodFrameNumber_;
     /// Animation LOD bias.
@@ -273,6 +333,16 @@ private:
     bool assignBonesPending_;
     /// Force animation update after becoming visible flag.
     bool forceAnimationUpdate_;
+    /// Lazy bone node update flag.
+    bool lazyBoneUpdate_{};
+    /// Pose cache usage flag.
+    bool usePoseCache_{};
+    /// Bone evaluation order dirty flag.
+    bool boneOrderDirty_{ true };
+    /// Whether skinning uses bone transforms from the local pose instead of bone nodes.
+    bool poseSkinning_{};
+    /// Bone nodes are out of date flag.
+    bool boneNodesDirty_{};
 };
 
 }
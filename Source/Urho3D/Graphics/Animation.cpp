@@ -27,6 +27,7 @@
 #include "../Core/Context.h"
 #include "../Core/Profiler.h"
 #include "../Graphics/Animation.h"
+#include "../Graphics/CompressedAnimation.h"
 #include "../IO/Deserializer.h"
 #include "../IO/FileSystem.h"
 #include "../IO/Log.h"
@@ -141,6 +142,7 @@ bool Animation::BeginLoad(Deserializer& source)
     animationNameHash_ = animationName_;
     length_ = source.ReadFloat();
     tracks_.clear();
+    compressed_.reset();
 
     unsigned tracks = source.ReadUInt();
     memoryUse += tracks * sizeof(AnimationTrack);
@@ -169,6 +171,24 @@ bool Animation::BeginLoad(Deserializer& source)
         }
     }
 
+    // Optionally read compressed tracks. Keyframe tracks are enough to play the animation, so ignore anything unexpected
+    if (!source.IsEof())
+    {
+        if (source.ReadFileID() == "UCMP")
+        {
+            compressed_ = ea::make_unique<CompressedAnimation>();
+            if (compressed_->Load(source))
+                memoryUse += compressed_->GetMemoryUse();
+            else
+            {
+                URHO3D_LOGWARNING(source.GetName() + " has invalid compressed animation data, keyframes are used");
+                compressed_.reset();
+            }
+        }
+        else
+            URHO3D_LOGWARNING(source.GetName() + " has unknown data after animation tracks, ignored");
+    }
+
     // Optionally read triggers from an XML file
     auto* cache = GetSubsystem<ResourceCache>();
     ea::string xmlName = ReplaceExtension(GetName(), ".xml");
@@ -257,6 +277,14 @@ bool Animation::Save(Serializer& dest) const
         }
     }
 
+    // Write compressed tracks
+    if (compressed_)
+    {
+        dest.WriteFileID("UCMP");
+        if (!compressed_->Save(dest))
+            return false;
+    }
+
     // If triggers have been defined, write an XML file for them
     if (!triggers_.empty() || HasMetadata())
     {
@@ -329,6 +357,39 @@ void Animation::RemoveAllTracks()
     tracks_.clear();
 }
 
+void Animation::Compress(const AnimationCompressionSettings& settings, bool stripKeyFrames)
+{
+    URHO3D_PROFILE("CompressAnimation");
+
+    if (compressed_)
+        SetMemoryUse(GetMemoryUse() - compressed_->GetMemoryUse());
+
+    compressed_ = ea::make_unique<CompressedAnimation>();
+    compressed_->Compress(*this, settings);
+
+    unsigned memoryUse = GetMemoryUse() + compressed_->GetMemoryUse();
+    if (stripKeyFrames)
+    {
+        for (auto& item : tracks_)
+        {
+            AnimationTrack& track = item.second;
+            memoryUse -= ea::min<unsigned>(memoryUse, track.keyFrames_.size() * sizeof(AnimationKeyFrame));
+            track.keyFrames_.clear();
+            track.keyFrames_.shrink_to_fit();
+        }
+    }
+    SetMemoryUse(memoryUse);
+}
+
+void Animation::RemoveCompressedData()
+{
+    if (compressed_)
+    {
+        SetMemoryUse(GetMemoryUse() - compressed_->GetMemoryUse());
+        compressed_.reset();
+    }
+}
+
 void Animation::SetTrigger(unsigned index, const AnimationTriggerPoint& trigger)
 {
     if (index == triggers_.size())
@@ -381,6 +442,8 @@ SharedPtr<Animation> Animation::Clone(const ea::string& cloneName) const
     ret->length_ = length_;
     ret->tracks_ = tracks_;
     ret->triggers_ = triggers_;
+    if (compressed_)
+        ret->compressed_ = ea::make_unique<CompressedAnimation>(*compressed_);
     ret->CopyMetadata(*this);
     ret->SetMemoryUse(GetMemoryUse());
 
@@ -30,6 +30,8 @@
 #include "../Math/Vector3.h"
 #include "../Resource/Resource.h"
 
+#include <EASTL/unique_ptr.h>
+
 namespace Urho3D
 {
 
@@ -152,6 +154,9 @@ struct AnimationTriggerPoint
     }
 };
 
+class CompressedAnimation;
+struct AnimationCompressionSettings;
+
 /// Skeletal animation resource.
 class URHO3D_API Animation : public ResourceWithMetadata
 {
@@ -197,6 +202,12 @@ public:
     /// Resize trigger point vector.
     /// @property
     void SetNumTriggers(unsigned num);
+    /// Compress tracks for faster sampling of all tracks at once. Compressed data is used by AnimationState when present.
+    /// Compressed data is not updated when tracks are changed afterwards.
+    /// If keyframes are stripped, tracks keep only names and channel masks.
+    void Compress(const AnimationCompressionSettings& settings, bool stripKeyFrames = false);
+    /// Remove compressed data.
+    void RemoveCompressedData();
     /// Clone the animation.
     SharedPtr<Animation> Clone(const ea::string& cloneName = EMPTY_STRING) const;
 
@@ -227,6 +238,9 @@ public:
     /// Return animation track by name hash.
     AnimationTrack* GetTrack(StringHash nameHash);
 
+    /// Return compressed data, or null if the animation is not compressed.
+    const CompressedAnimation* GetCompressed() const { return compressed_.get(); }
+
     /// Return animation trigger points.
     const ea::vector<AnimationTriggerPoint>& GetTriggers() const { return triggers_; }
 
@@ -250,6 +264,8 @@ private:
     ea::unordered_map<StringHash, AnimationTrack> tracks_;
     /// Animation trigger points.
     ea::vector<AnimationTriggerPoint> triggers_;
+    /// Compressed tracks.
+    ea::unique_ptr<CompressedAnimation> compressed_;
 };
 
 }
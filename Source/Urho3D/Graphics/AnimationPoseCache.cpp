@@ -0,0 +1,118 @@
+//
+// Copyright (c) 2017-2021 the rbfx project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "../Precompiled.h"
+
+#include "../Core/Context.h"
+#include "../Graphics/AnimationPoseCache.h"
+
+#include "../DebugNew.h"
+
+namespace Urho3D
+{
+
+extern const char* SUBSYSTEM_CATEGORY;
+
+AnimationPoseCache::AnimationPoseCache(Context* context)
+    : Component(context)
+{
+}
+
+AnimationPoseCache::~AnimationPoseCache() = default;
+
+void AnimationPoseCache::RegisterObject(Context* context)
+{
+    context->RegisterFactory<AnimationPoseCache>(SUBSYSTEM_CATEGORY);
+
+    URHO3D_ACCESSOR_ATTRIBUTE("Time Step", GetTimeStep, SetTimeStep, float, 1.0f / 60.0f, AM_DEFAULT);
+    URHO3D_ATTRIBUTE("Max Unused Frames", unsigned, maxUnusedFrames_, 2, AM_DEFAULT);
+}
+
+void AnimationPoseCache::SetTimeStep(float step)
+{
+    MutexLock lock(mutex_);
+    timeStep_ = Max(step, 0.0f);
+    poses_.clear();
+}
+
+ea::shared_ptr<const SharedAnimationPose> AnimationPoseCache::FindPose(const ea::vector<unsigned>& key, unsigned frameNumber)
+{
+    MutexLock lock(mutex_);
+    if (frameNumber != currentFrame_)
+        RemoveUnusedPoses(frameNumber);
+
+    const auto iter = poses_.find(key);
+    if (iter == poses_.end())
+    {
+        ++numMisses_;
+        return nullptr;
+    }
+
+    ++numHits_;
+    iter->second.lastUsedFrame_ = frameNumber;
+    return iter->second.pose_;
+}
+
+ea::shared_ptr<const SharedAnimationPose> AnimationPoseCache::StorePose(const ea::vector<unsigned>& key, unsigned frameNumber,
+    const ea::shared_ptr<const SharedAnimationPose>& pose)
+{
+    MutexLock lock(mutex_);
+    Entry& entry = poses_[key];
+    if (!entry.pose_)
+        entry.pose_ = pose;
+    entry.lastUsedFrame_ = frameNumber;
+    return entry.pose_;
+}
+
+void AnimationPoseCache::Clear()
+{
+    MutexLock lock(mutex_);
+    poses_.clear();
+}
+
+unsigned AnimationPoseCache::GetNumPoses() const
+{
+    MutexLock lock(mutex_);
+    return poses_.size();
+}
+
+void AnimationPoseCache::ResetStatistics()
+{
+    MutexLock lock(mutex_);
+    numHits_ = 0;
+    numMisses_ = 0;
+}
+
+void AnimationPoseCache::RemoveUnusedPoses(unsigned frameNumber)
+{
+    currentFrame_ = frameNumber;
+    for (auto iter = poses_.begin(); iter != poses_.end();)
+    {
+        // Frame number may wrap around
+        if (frameNumber - iter->second.lastUsedFrame_ > maxUnusedFrames_)
+            iter = poses_.erase(iter);
+        else
+            ++iter;
+    }
+}
+
+}
@@ -0,0 +1,122 @@
+//
+// Copyright (c) 2017-2021 the rbfx project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+/// \file
+
+#pragma once
+
+#include "../Core/Mutex.h"
+#include "../Graphics/CompressedAnimation.h"
+#include "../Math/Matrix3x4.h"
+#include "../Scene/Component.h"
+
+#include <EASTL/shared_ptr.h>
+#include <EASTL/unordered_map.h>
+#include <EASTL/vector.h>
+
+namespace Urho3D
+{
+
+/// Skeleton pose evaluated once and shared between animated models.
+struct SharedAnimationPose
+{
+    /// Local bone transforms, indexed by bone index.
+    AnimationPose localPose_;
+    /// Bone transforms relative to the model node.
+    ea::vector<Matrix3x4> boneModelTransforms_;
+    /// Skin matrices relative to the model node.
+    ea::vector<Matrix3x4> skinMatrices_;
+};
+
+/// Scene-wide cache of skeleton poses.
+/// Animated models with the same model and the same animation states share the pose evaluated by the first of them.
+/// Animation time is quantized, so models with close animation time positions share the pose too.
+/// Poses not used for several frames are removed.
+class URHO3D_API AnimationPoseCache : public Component
+{
+    URHO3D_OBJECT(AnimationPoseCache, Component);
+
+public:
+    /// Construct.
+    explicit AnimationPoseCache(Context* context);
+    /// Destruct.
+    ~AnimationPoseCache() override;
+    /// Register object factory.
+    static void RegisterObject(Context* context);
+
+    /// Set time quantization step in seconds. Zero disables quantization.
+    void SetTimeStep(float step);
+    /// Return time quantization step in seconds.
+    float GetTimeStep() const { return timeStep_; }
+    /// Set number of frames an unused pose is kept for.
+    void SetMaxUnusedFrames(unsigned numFrames) { maxUnusedFrames_ = numFrames; }
+    /// Return number of frames an unused pose is kept for.
+    unsigned GetMaxUnusedFrames() const { return maxUnusedFrames_; }
+
+    /// Find pose by key. Safe to call from worker threads.
+    ea::shared_ptr<const SharedAnimationPose> FindPose(const ea::vector<unsigned>& key, unsigned frameNumber);
+    /// Store pose by key. If another thread stored the pose first, return existing pose. Safe to call from worker threads.
+    ea::shared_ptr<const SharedAnimationPose> StorePose(const ea::vector<unsigned>& key, unsigned frameNumber,
+        const ea::shared_ptr<const SharedAnimationPose>& pose);
+    /// Remove all poses.
+    void Clear();
+
+    /// Return number of cached poses.
+    unsigned GetNumPoses() const;
+    /// Return number of successful lookups since statistics reset.
+    unsigned GetNumHits() const { return numHits_; }
+    /// Return number of failed lookups since statistics reset.
+    unsigned GetNumMisses() const { return numMisses_; }
+    /// Reset statistics.
+    void ResetStatistics();
+
+private:
+    /// Cached pose.
+    struct Entry
+    {
+        /// Pose.
+        ea::shared_ptr<const SharedAnimationPose> pose_;
+        /// Last frame when the pose was used.
+        unsigned lastUsedFrame_{};
+    };
+
+    /// Remove poses unused for too long.
+    void RemoveUnusedPoses(unsigned frameNumber);
+
+    /// Time quantization step.
+    float timeStep_{ 1.0f / 60.0f };
+    /// Number of frames an unused pose is kept for.
+    unsigned maxUnusedFrames_{ 2 };
+
+    /// Mutex for cache access.
+    mutable Mutex mutex_;
+    /// Cached poses.
+    ea::unordered_map<ea::vector<unsigned>, Entry> poses_;
+    /// Last frame when unused poses were removed.
+    unsigned currentFrame_{};
+    /// Number of successful lookups.
+    unsigned numHits_{};
+    /// Number of failed lookups.
+    unsigned numMisses_{};
+};
+
+}
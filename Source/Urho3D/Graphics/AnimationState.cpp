@@ -37,7 +37,9 @@ AnimationStateTrack::AnimationStateTrack() :
     track_(nullptr),
     bone_(nullptr),
     weight_(1.0f),
-    keyFrame_(0)
+    keyFrame_(0),
+    compressedIndex_(M_MAX_UNSIGNED),
+    boneIndex_(M_MAX_UNSIGNED)
 {
 }
 
@@ -125,6 +127,7 @@ void AnimationState::SetStartBone(Bone* startBone)
 
     const ea::unordered_map<StringHash, AnimationTrack>& tracks = animation_->GetTracks();
     stateTracks_.clear();
+    compressed_ = nullptr;
 
     if (!startBone->node_)
         return;
@@ -150,6 +153,7 @@ void AnimationState::SetStartBone(Bone* startBone)
         if (trackBone && trackBone->node_)
         {
             stateTrack.bone_ = trackBone;
+            stateTrack.boneIndex_ = skeleton.GetBoneIndex(trackBone);
             stateTrack.node_ = trackBone->node_;
             stateTracks_.push_back(stateTrack);
         }
@@ -447,44 +451,115 @@ void AnimationState::Apply()
     if (!animation_ || !IsEnabled())
         return;
 
+    SampleCompressed(time_);
+
     if (model_)
         ApplyToModel();
     else
         ApplyToNodes();
 }
 
-void AnimationState::ApplyToModel()
+void AnimationState::ApplyToPose(AnimationPose& pose)
 {
-    for (auto i = stateTracks_.begin(); i != stateTracks_.end(); ++i)
+    ApplyToPose(pose, time_);
+}
+
+void AnimationState::ApplyToPose(AnimationPose& pose, float time)
+{
+    if (!animation_ || !IsEnabled() || !model_)
+        return;
+
+    SampleCompressed(time);
+
+    const unsigned numBones = pose.positions_.size();
+    for (AnimationStateTrack& stateTrack : stateTracks_)
     {
-        AnimationStateTrack& stateTrack = *i;
-        float finalWeight = weight_ * stateTrack.weight_;
+        const float finalWeight = weight_ * stateTrack.weight_;
+        const unsigned boneIndex = stateTrack.boneIndex_;
 
         // Do not apply if zero effective weight or the bone has animation disabled
-        if (Equals(finalWeight, 0.0f) || !stateTrack.bone_->animated_)
+        if (Equals(finalWeight, 0.0f) || !stateTrack.bone_->animated_ || boneIndex >= numBones)
             continue;
 
-        ApplyTrack(stateTrack, finalWeight, true);
+        AnimationKeyFrame value;
+        AnimationChannelFlags channelMask;
+        if (!SampleTrack(stateTrack, time, value, channelMask))
+            continue;
+
+        AnimationKeyFrame current;
+        current.position_ = pose.positions_[boneIndex];
+        current.rotation_ = pose.rotations_[boneIndex];
+        current.scale_ = pose.scales_[boneIndex];
+        BlendTrack(stateTrack, channelMask, finalWeight, current, value);
+
+        if (channelMask & CHANNEL_POSITION)
+            pose.positions_[boneIndex] = value.position_;
+        if (channelMask & CHANNEL_ROTATION)
+            pose.rotations_[boneIndex] = value.rotation_;
+        if (channelMask & CHANNEL_SCALE)
+            pose.scales_[boneIndex] = value.scale_;
     }
 }
 
-void AnimationState::ApplyToNodes()
+float AnimationState::GetQuantizedTime(float step) const
 {
-    // When applying to a node hierarchy, can only use full weight (nothing to blend to)
-    for (auto i = stateTracks_.begin(); i != stateTracks_.end(); ++i)
-        ApplyTrack(*i, 1.0f, false);
+    if (step <= 0.0f)
+        return time_;
+    return Min(FloorToInt(time_ / step) * step, GetLength());
 }
 
-void AnimationState::ApplyTrack(AnimationStateTrack& stateTrack, float weight, bool silent)
+void AnimationState::AppendPoseKey(ea::vector<unsigned>& key, float time) const
+{
+    // Disabled states don't contribute to the pose
+    if (!animation_ || !IsEnabled() || !model_)
+        return;
+
+    key.push_back(animation_->GetNameHash().Value());
+    key.push_back(startBone_ ? startBone_->nameHash_.Value() : 0);
+    key.push_back(layer_ | (blendingMode_ << 8u) | (looped_ << 16u));
+    key.push_back(FloatToRawIntBits(time));
+    key.push_back(FloatToRawIntBits(weight_));
+    for (const AnimationStateTrack& stateTrack : stateTracks_)
+        key.push_back(FloatToRawIntBits(stateTrack.weight_));
+}
+
+void AnimationState::SampleCompressed(float time)
+{
+    const CompressedAnimation* compressed = animation_->GetCompressed();
+    if (compressed != compressed_)
+    {
+        compressed_ = compressed;
+        for (AnimationStateTrack& stateTrack : stateTracks_)
+            stateTrack.compressedIndex_ = compressed_ ? compressed_->GetTrackIndex(stateTrack.track_->nameHash_) : M_MAX_UNSIGNED;
+    }
+
+    if (compressed_)
+        compressed_->Sample(time, pose_);
+}
+
+bool AnimationState::SampleTrack(AnimationStateTrack& stateTrack, float time, AnimationKeyFrame& value,
+    AnimationChannelFlags& channelMask) const
 {
     const AnimationTrack* track = stateTrack.track_;
-    Node* node = stateTrack.node_;
 
-    if (track->keyFrames_.empty() || !node)
-        return;
+    // Compressed tracks don't wrap around, sample the segment between the last and the first keyframe of looped animation from keyframes
+    const bool isWrapSegment = looped_ && !track->keyFrames_.empty() && time > track->keyFrames_.back().time_;
+
+    const unsigned compressedIndex = stateTrack.compressedIndex_;
+    if (compressed_ && compressedIndex != M_MAX_UNSIGNED && !isWrapSegment)
+    {
+        channelMask = compressed_->GetTrackChannels(compressedIndex);
+        value.position_ = pose_.positions_[compressedIndex];
+        value.rotation_ = pose_.rotations_[compressedIndex];
+        value.scale_ = pose_.scales_[compressedIndex];
+        return !!channelMask;
+    }
+
+    if (track->keyFrames_.empty())
+        return false;
 
     unsigned& frame = stateTrack.keyFrame_;
-    track->GetKeyFrameIndex(time_, frame);
+    track->GetKeyFrameIndex(time, frame);
 
     // Check if next frame to interpolate to is valid, or if wrapping is needed (looping animation only)
     unsigned nextFrame = frame + 1;
@@ -501,11 +576,7 @@ void AnimationState::ApplyTrack(AnimationStateTrack& stateTrack, float weight, b
     }
 
     const AnimationKeyFrame* keyFrame = &track->keyFrames_[frame];
-    const AnimationChannelFlags channelMask = track->channelMask_;
-
-    Vector3 newPosition;
-    Quaternion newRotation;
-    Vector3 newScale;
+    channelMask = track->channelMask_;
 
     if (interpolate)
     {
@@ -513,43 +584,71 @@ void AnimationState::ApplyTrack(AnimationStateTrack& stateTrack, float weight, b
         float timeInterval = nextKeyFrame->time_ - keyFrame->time_;
         if (timeInterval < 0.0f)
             timeInterval += animation_->GetLength();
-        float t = timeInterval > 0.0f ? (time_ - keyFrame->time_) / timeInterval : 1.0f;
+        float t = timeInterval > 0.0f ? (time - keyFrame->time_) / timeInterval : 1.0f;
 
         if (channelMask & CHANNEL_POSITION)
-            newPosition = keyFrame->position_.Lerp(nextKeyFrame->position_, t);
+            value.position_ = keyFrame->position_.Lerp(nextKeyFrame->position_, t);
         if (channelMask & CHANNEL_ROTATION)
-            newRotation = keyFrame->rotation_.Slerp(nextKeyFrame->rotation_, t);
+            value.rotation_ = keyFrame->rotation_.Slerp(nextKeyFrame->rotation_, t);
         if (channelMask & CHANNEL_SCALE)
-            newScale = keyFrame->scale_.Lerp(nextKeyFrame->scale_, t);
+            value.scale_ = keyFrame->scale_.Lerp(nextKeyFrame->scale_, t);
     }
     else
     {
         if (channelMask & CHANNEL_POSITION)
-            newPosition = keyFrame->position_;
+            value.position_ = keyFrame->position_;
         if (channelMask & CHANNEL_ROTATION)
-            newRotation = keyFrame->rotation_;
+            value.rotation_ = keyFrame->rotation_;
         if (channelMask & CHANNEL_SCALE)
-            newScale = keyFrame->scale_;
+            value.scale_ = keyFrame->scale_;
+    }
+
+    return true;
+}
+
+void AnimationState::ApplyToModel()
+{
+    for (auto i = stateTracks_.begin(); i != stateTracks_.end(); ++i)
+    {
+        AnimationStateTrack& stateTrack = *i;
+        float finalWeight = weight_ * stateTrack.weight_;
+
+        // Do not apply if zero effective weight or the bone has animation disabled
+        if (Equals(finalWeight, 0.0f) || !stateTrack.bone_->animated_)
+            continue;
+
+        ApplyTrack(stateTrack, finalWeight, true);
     }
+}
+
+void AnimationState::ApplyToNodes()
+{
+    // When applying to a node hierarchy, can only use full weight (nothing to blend to)
+    for (auto i = stateTracks_.begin(); i != stateTracks_.end(); ++i)
+        ApplyTrack(*i, 1.0f, false);
+}
 
+void AnimationState::BlendTrack(const AnimationStateTrack& stateTrack, AnimationChannelFlags channelMask, float weight,
+    const AnimationKeyFrame& current, AnimationKeyFrame& value) const
+{
     if (blendingMode_ == ABM_ADDITIVE) // not ABM_LERP
     {
         if (channelMask & CHANNEL_POSITION)
         {
-            Vector3 delta = newPosition - stateTrack.bone_->initialPosition_;
-            newPosition = node->GetPosition() + delta * weight;
+            Vector3 delta = value.position_ - stateTrack.bone_->initialPosition_;
+            value.position_ = current.position_ + delta * weight;
         }
         if (channelMask & CHANNEL_ROTATION)
         {
-            Quaternion delta = newRotation * stateTrack.bone_->initialRotation_.Inverse();
-            newRotation = (delta * node->GetRotation()).Normalized();
+            Quaternion delta = value.rotation_ * stateTrack.bone_->initialRotation_.Inverse();
+            value.rotation_ = (delta * current.rotation_).Normalized();
             if (!Equals(weight, 1.0f))
-                newRotation = node->GetRotation().Slerp(newRotation, weight);
+                value.rotation_ = current.rotation_.Slerp(value.rotation_, weight);
         }
         if (channelMask & CHANNEL_SCALE)
         {
-            Vector3 delta = newScale - stateTrack.bone_->initialScale_;
-            newScale = node->GetScale() + delta * weight;
+            Vector3 delta = value.scale_ - stateTrack.bone_->initialScale_;
+            value.scale_ = current.scale_ + delta * weight;
         }
     }
     else
@@ -557,31 +656,49 @@ void AnimationState::ApplyTrack(AnimationStateTrack& stateTrack, float weight, b
         if (!Equals(weight, 1.0f)) // not full weight
         {
             if (channelMask & CHANNEL_POSITION)
-                newPosition = node->GetPosition().Lerp(newPosition, weight);
+                value.position_ = current.position_.Lerp(value.position_, weight);
             if (channelMask & CHANNEL_ROTATION)
-                newRotation = node->GetRotation().Slerp(newRotation, weight);
+                value.rotation_ = current.rotation_.Slerp(value.rotation_, weight);
             if (channelMask & CHANNEL_SCALE)
-                newScale = node->GetScale().Lerp(newScale, weight);
+                value.scale_ = current.scale_.Lerp(value.scale_, weight);
         }
     }
+}
+
+void AnimationState::ApplyTrack(AnimationStateTrack& stateTrack, float weight, bool silent)
+{
+    Node* node = stateTrack.node_;
+    if (!node)
+        return;
+
+    AnimationKeyFrame value;
+    AnimationChannelFlags channelMask;
+    if (!SampleTrack(stateTrack, time_, value, channelMask))
+        return;
+
+    AnimationKeyFrame current;
+    current.position_ = node->GetPosition();
+    current.rotation_ = node->GetRotation();
+    current.scale_ = node->GetScale();
+    BlendTrack(stateTrack, channelMask, weight, current, value);
 
     if (silent)
     {
         if (channelMask & CHANNEL_POSITION)
-            node->SetPositionSilent(newPosition);
+            node->SetPositionSilent(value.position_);
         if (channelMask & CHANNEL_ROTATION)
-            node->SetRotationSilent(newRotation);
+            node->SetRotationSilent(value.rotation_);
         if (channelMask & CHANNEL_SCALE)
-            node->SetScaleSilent(newScale);
+            node->SetScaleSilent(value.scale_);
     }
     else
     {
         if (channelMask & CHANNEL_POSITION)
-            node->SetPosition(newPosition);
+            node->SetPosition(value.position_);
         if (channelMask & CHANNEL_ROTATION)
-            node->SetRotation(newRotation);
+            node->SetRotation(value.rotation_);
         if (channelMask & CHANNEL_SCALE)
-            node->SetScale(newScale);
+            node->SetScale(value.scale_);
     }
 }
 
@@ -27,6 +27,7 @@
 #include <EASTL/unordered_map.h>
 
 #include "../Container/Ptr.h"
+#include "../Graphics/CompressedAnimation.h"
 #include "../Math/StringHash.h"
 
 namespace Urho3D
@@ -80,6 +81,10 @@ struct URHO3D_API AnimationStateTrack
     float weight_;
     /// Last key frame.
     unsigned keyFrame_;
+    /// Index of the track in compressed animation, M_MAX_UNSIGNED if not compressed.
+    unsigned compressedIndex_;
+    /// Index of the bone in model skeleton, M_MAX_UNSIGNED in node animation mode.
+    unsigned boneIndex_;
 };
 
 /// %Animation instance.
@@ -179,12 +184,28 @@ public:
 
     /// Apply the animation at the current time position.
     void Apply();
+    /// Apply the animation at the current time position to the local pose of model bones instead of bone nodes. Pose is indexed by bone index.
+    void ApplyToPose(AnimationPose& pose);
+    /// Apply the animation at the given time position to the local pose of model bones.
+    void ApplyToPose(AnimationPose& pose, float time);
+    /// Return time position rounded down to the multiple of step. Zero step disables rounding.
+    float GetQuantizedTime(float step) const;
+    /// Append data identifying the result of ApplyToPose at the given time position. Nothing is appended if the state is disabled.
+    void AppendPoseKey(ea::vector<unsigned>& key, float time) const;
 
 private:
     /// Apply animation to a skeleton. Transform changes are applied silently, so the model needs to dirty its root model afterward.
     void ApplyToModel();
     /// Apply animation to a scene node hierarchy.
     void ApplyToNodes();
+    /// Sample compressed animation for all tracks at the given time position if present.
+    void SampleCompressed(float time);
+    /// Sample track at the given time position. Return false if the track has no data.
+    bool SampleTrack(AnimationStateTrack& stateTrack, float time, AnimationKeyFrame& value,
+        AnimationChannelFlags& channelMask) const;
+    /// Blend sampled track value with current value according to blending mode and weight.
+    void BlendTrack(const AnimationStateTrack& stateTrack, AnimationChannelFlags channelMask, float weight,
+        const AnimationKeyFrame& current, AnimationKeyFrame& value) const;
     /// Apply track.
     void ApplyTrack(AnimationStateTrack& stateTrack, float weight, bool silent);
 
@@ -208,6 +229,10 @@ private:
     unsigned char layer_;
     /// Blending mode.
     AnimationBlendMode blendingMode_;
+    /// Compressed animation used to map tracks.
+    const CompressedAnimation* compressed_{};
+    /// Pose sampled from compressed animation.
+    AnimationPose pose_;
 };
 
 }
@@ -592,6 +592,32 @@ void BillboardSet::UpdateVertexBuffer(const FrameInfo& frame)
         }
     }
 
+    // Use vertices prepared in advance if possible
+    if (!sorted_ && !fixedScreenSize_)
+    {
+        const float* preparedData = nullptr;
+        unsigned numPreparedBillboards = 0;
+        if (GetPreparedVertexData(preparedData, numPreparedBillboards))
+        {
+            numPreparedBillboards = ea::min(numPreparedBillboards, billboards_.size());
+            batches_[0].geometry_->SetDrawRange(TRIANGLE_LIST, 0, numPreparedBillboards * 6, false);
+
+            bufferDirty_ = false;
+            forceUpdate_ = false;
+            if (!numPreparedBillboards)
+                return;
+
+            void* dest = vertexBuffer_->Lock(0, numPreparedBillboards * 4, true);
+            if (!dest)
+                return;
+
+            memcpy(dest, preparedData, numPreparedBillboards * 4 * vertexBuffer_->GetVertexSize());
+            vertexBuffer_->Unlock();
+            vertexBuffer_->ClearDataLost();
+            return;
+        }
+    }
+
     unsigned numBillboards = billboards_.size();
     unsigned enabledBillboards = 0;
     const Matrix3x4& worldTransform = node_->GetWorldTransform();
@@ -639,126 +665,21 @@ void BillboardSet::UpdateVertexBuffer(const FrameInfo& frame)
     if (!dest)
         return;
 
-    if (faceCameraMode_ != FC_DIRECTION)
+    for (unsigned i = 0; i < enabledBillboards; ++i)
     {
-        for (unsigned i = 0; i < enabledBillboards; ++i)
-        {
-            Billboard& billboard = *sortedBillboards_[i];
-
-            Vector2 size(billboard.size_.x_ * billboardScale.x_, billboard.size_.y_ * billboardScale.y_);
-            unsigned color = billboard.color_.ToUInt();
-            if (fixedScreenSize_)
-                size *= billboard.screenScaleFactor_;
-
-            float rotationMatrix[2][2];
-            SinCos(billboard.rotation_, rotationMatrix[0][1], rotationMatrix[0][0]);
-            rotationMatrix[1][0] = -rotationMatrix[0][1];
-            rotationMatrix[1][1] = rotationMatrix[0][0];
-
-            dest[0] = billboard.position_.x_;
-            dest[1] = billboard.position_.y_;
-            dest[2] = billboard.position_.z_;
-            ((unsigned&)dest[3]) = color;
-            dest[4] = billboard.uv_.min_.x_;
-            dest[5] = billboard.uv_.min_.y_;
-            dest[6] = -size.x_ * rotationMatrix[0][0] + size.y_ * rotationMatrix[0][1];
-            dest[7] = -size.x_ * rotationMatrix[1][0] + size.y_ * rotationMatrix[1][1];
-
-            dest[8] = billboard.position_.x_;
-            dest[9] = billboard.position_.y_;
-            dest[10] = billboard.position_.z_;
-            ((unsigned&)dest[11]) = color;
-            dest[12] = billboard.uv_.max_.x_;
-            dest[13] = billboard.uv_.min_.y_;
-            dest[14] = size.x_ * rotationMatrix[0][0] + size.y_ * rotationMatrix[0][1];
-            dest[15] = size.x_ * rotationMatrix[1][0] + size.y_ * rotationMatrix[1][1];
-
-            dest[16] = billboard.position_.x_;
-            dest[17] = billboard.position_.y_;
-            dest[18] = billboard.position_.z_;
-            ((unsigned&)dest[19]) = color;
-            dest[20] = billboard.uv_.max_.x_;
-            dest[21] = billboard.uv_.max_.y_;
-            dest[22] = size.x_ * rotationMatrix[0][0] - size.y_ * rotationMatrix[0][1];
-            dest[23] = size.x_ * rotationMatrix[1][0] - size.y_ * rotationMatrix[1][1];
-
-            dest[24] = billboard.position_.x_;
-            dest[25] = billboard.position_.y_;
-            dest[26] = billboard.position_.z_;
-            ((unsigned&)dest[27]) = color;
-            dest[28] = billboard.uv_.min_.x_;
-            dest[29] = billboard.uv_.max_.y_;
-            dest[30] = -size.x_ * rotationMatrix[0][0] - size.y_ * rotationMatrix[0][1];
-            dest[31] = -size.x_ * rotationMatrix[1][0] - size.y_ * rotationMatrix[1][1];
-
-            dest += 32;
-        }
-    }
-    else
-    {
-        for (unsigned i = 0; i < enabledBillboards; ++i)
+        Billboard& billboard = *sortedBillboards_[i];
+
+        Vector2 size(billboard.size_.x_ * billboardScale.x_, billboard.size_.y_ * billboardScale.y_);
+        unsigned color = billboard.color_.ToUInt();
+        if (fixedScreenSize_)
+            size *= billboard.screenScaleFactor_;
+
+        if (faceCameraMode_ != FC_DIRECTION)
+            dest = WriteBillboardVertices(dest, billboard.position_, size, billboard.rotation_, color, billboard.uv_);
+        else
         {
-            Billboard& billboard = *sortedBillboards_[i];
-
-            Vector2 size(billboard.size_.x_ * billboardScale.x_, billboard.size_.y_ * billboardScale.y_);
-            unsigned color = billboard.color_.ToUInt();
-            if (fixedScreenSize_)
-                size *= billboard.screenScaleFactor_;
-
-            float rot2D[2][2];
-            SinCos(billboard.rotation_, rot2D[0][1], rot2D[0][0]);
-            rot2D[1][0] = -rot2D[0][1];
-            rot2D[1][1] = rot2D[0][0];
-
-            dest[0] = billboard.position_.x_;
-            dest[1] = billboard.position_.y_;
-            dest[2] = billboard.position_.z_;
-            dest[3] = billboard.direction_.x_;
-            dest[4] = billboard.direction_.y_;
-            dest[5] = billboard.direction_.z_;
-            ((unsigned&)dest[6]) = color;
-            dest[7] = billboard.uv_.min_.x_;
-            dest[8] = billboard.uv_.min_.y_;
-            dest[9] = -size.x_ * rot2D[0][0] + size.y_ * rot2D[0][1];
-            dest[10] = -size.x_ * rot2D[1][0] + size.y_ * rot2D[1][1];
-
-            dest[11] = billboard.position_.x_;
-            dest[12] = billboard.position_.y_;
-            dest[13] = billboard.position_.z_;
-            dest[14] = billboard.direction_.x_;
-            dest[15] = billboard.direction_.y_;
-            dest[16] = billboard.direction_.z_;
-            ((unsigned&)dest[17]) = color;
-            dest[18] = billboard.uv_.max_.x_;
-            dest[19] = billboard.uv_.min_.y_;
-            dest[20] = size.x_ * rot2D[0][0] + size.y_ * rot2D[0][1];
-            dest[21] = size.x_ * rot2D[1][0] + size.y_ * rot2D[1][1];
-
-            dest[22] = billboard.position_.x_;
-            dest[23] = billboard.position_.y_;
-            dest[24] = billboard.position_.z_;
-            dest[25] = billboard.direction_.x_;
-            dest[26] = billboard.direction_.y_;
-            dest[27] = billboard.direction_.z_;
-            ((unsigned&)dest[28]) = color;
-            dest[29] = billboard.uv_.max_.x_;
-            dest[30] = billboard.uv_.max_.y_;
-            dest[31] = size.x_ * rot2D[0][0] - size.y_ * rot2D[0][1];
-            dest[32] = size.x_ * rot2D[1][0] - size.y_ * rot2D[1][1];
-
-            dest[33] = billboard.position_.x_;
-            dest[34] = billboard.position_.y_;
-            dest[35] = billboard.position_.z_;
-            dest[36] = billboard.direction_.x_;
-            dest[37] = billboard.direction_.y_;
-            dest[38] = billboard.direction_.z_;
-            ((unsigned&)dest[39]) = color;
-            dest[40] = billboard.uv_.min_.x_;
-            dest[41] = billboard.uv_.max_.y_;
-            dest[42] = -size.x_ * rot2D[0][0] - size.y_ * rot2D[0][1];
-            dest[43] = -size.x_ * rot2D[1][0] - size.y_ * rot2D[1][1];
-
-            dest += 44;
+            dest = WriteDirectionalBillboardVertices(dest, billboard.position_, billboard.direction_, size,
+                billboard.rotation_, color, billboard.uv_);
         }
     }
 
@@ -766,6 +687,112 @@ void BillboardSet::UpdateVertexBuffer(const FrameInfo& frame)
     vertexBuffer_->ClearDataLost();
 }
 
+float* BillboardSet::WriteBillboardVertices(float* dest, const Vector3& position, const Vector2& size, float rotation,
+    unsigned color, const Rect& uv)
+{
+    float rotationMatrix[2][2];
+    SinCos(rotation, rotationMatrix[0][1], rotationMatrix[0][0]);
+    rotationMatrix[1][0] = -rotationMatrix[0][1];
+    rotationMatrix[1][1] = rotationMatrix[0][0];
+
+    dest[0] = position.x_;
+    dest[1] = position.y_;
+    dest[2] = position.z_;
+    ((unsigned&)dest[3]) = color;
+    dest[4] = uv.min_.x_;
+    dest[5] = uv.min_.y_;
+    dest[6] = -size.x_ * rotationMatrix[0][0] + size.y_ * rotationMatrix[0][1];
+    dest[7] = -size.x_ * rotationMatrix[1][0] + size.y_ * rotationMatrix[1][1];
+
+    dest[8] = position.x_;
+    dest[9] = position.y_;
+    dest[10] = position.z_;
+    ((unsigned&)dest[11]) = color;
+    dest[12] = uv.max_.x_;
+    dest[13] = uv.min_.y_;
+    dest[14] = size.x_ * rotationMatrix[0][0] + size.y_ * rotationMatrix[0][1];
+    dest[15] = size.x_ * rotationMatrix[1][0] + size.y_ * rotationMatrix[1][1];
+
+    dest[16] = position.x_;
+    dest[17] = position.y_;
+    dest[18] = position.z_;
+    ((unsigned&)dest[19]) = color;
+    dest[20] = uv.max_.x_;
+    dest[21] = uv.max_.y_;
+    dest[22] = size.x_ * rotationMatrix[0][0] - size.y_ * rotationMatrix[0][1];
+    dest[23] = size.x_ * rotationMatrix[1][0] - size.y_ * rotationMatrix[1][1];
+
+    dest[24] = position.x_;
+    dest[25] = position.y_;
+    dest[26] = position.z_;
+    ((unsigned&)dest[27]) = color;
+    dest[28] = uv.min_.x_;
+    dest[29] = uv.max_.y_;
+    dest[30] = -size.x_ * rotationMatrix[0][0] - size.y_ * rotationMatrix[0][1];
+    dest[31] = -size.x_ * rotationMatrix[1][0] - size.y_ * rotationMatrix[1][1];
+
+    return dest + BillboardVertexSize * 4;
+}
+
+float* BillboardSet::WriteDirectionalBillboardVertices(float* dest, const Vector3& position, const Vector3& direction,
+    const Vector2& size, float rotation, unsigned color, const Rect& uv)
+{
+    float rot2D[2][2];
+    SinCos(rotation, rot2D[0][1], rot2D[0][0]);
+    rot2D[1][0] = -rot2D[0][1];
+    rot2D[1][1] = rot2D[0][0];
+
+    dest[0] = position.x_;
+    dest[1] = position.y_;
+    dest[2] = position.z_;
+    dest[3] = direction.x_;
+    dest[4] = direction.y_;
+    dest[5] = direction.z_;
+    ((unsigned&)dest[6]) = color;
+    dest[7] = uv.min_.x_;
+    dest[8] = uv.min_.y_;
+    dest[9] = -size.x_ * rot2D[0][0] + size.y_ * rot2D[0][1];
+    dest[10] = -size.x_ * rot2D[1][0] + size.y_ * rot2D[1][1];
+
+    dest[11] = position.x_;
+    dest[12] = position.y_;
+    dest[13] = position.z_;
+    dest[14] = direction.x_;
+    dest[15] = direction.y_;
+    dest[16] = direction.z_;
+    ((unsigned&)dest[17]) = color;
+    dest[18] = uv.max_.x_;
+    dest[19] = uv.min_.y_;
+    dest[20] = size.x_ * rot2D[0][0] + size.y_ * rot2D[0][1];
+    dest[21] = size.x_ * rot2D[1][0] + size.y_ * rot2D[1][1];
+
+    dest[22] = position.x_;
+    dest[23] = position.y_;
+    dest[24] = position.z_;
+    dest[25] = direction.x_;
+    dest[26] = direction.y_;
+    dest[27] = direction.z_;
+    ((unsigned&)dest[28]) = color;
+    dest[29] = uv.max_.x_;
+    dest[30] = uv.max_.y_;
+    dest[31] = size.x_ * rot2D[0][0] - size.y_ * rot2D[0][1];
+    dest[32] = size.x_ * rot2D[1][0] - size.y_ * rot2D[1][1];
+
+    dest[33] = position.x_;
+    dest[34] = position.y_;
+    dest[35] = position.z_;
+    dest[36] = direction.x_;
+    dest[37] = direction.y_;
+    dest[38] = direction.z_;
+    ((unsigned&)dest[39]) = color;
+    dest[40] = uv.min_.x_;
+    dest[41] = uv.max_.y_;
+    dest[42] = -size.x_ * rot2D[0][0] - size.y_ * rot2D[0][1];
+    dest[43] = -size.x_ * rot2D[1][0] - size.y_ * rot2D[1][1];
+
+    return dest + DirectionalBillboardVertexSize * 4;
+}
+
 void BillboardSet::MarkPositionsDirty()
 {
     Drawable::OnMarkedDirty(node_);
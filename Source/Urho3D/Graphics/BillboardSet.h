@@ -76,6 +76,11 @@ class URHO3D_API BillboardSet : public Drawable
     URHO3D_OBJECT(BillboardSet, Drawable);
 
 public:
+    /// Number of floats in billboard vertex.
+    static const unsigned BillboardVertexSize = 8;
+    /// Number of floats in billboard vertex if billboards are oriented along direction.
+    static const unsigned DirectionalBillboardVertexSize = 11;
+
     /// Construct.
     explicit BillboardSet(Context* context);
     /// Destruct.
@@ -184,6 +189,16 @@ protected:
     void OnWorldBoundingBoxUpdate() override;
     /// Mark billboard vertex buffer to need an update.
     void MarkPositionsDirty();
+    /// Return vertex data of enabled billboards prepared in advance. Return false if vertices should be generated from billboards.
+    /// Not used if billboards are sorted or have fixed screen size.
+    virtual bool GetPreparedVertexData(const float*& data, unsigned& numBillboards) { return false; }
+
+    /// Write 4 vertices of billboard facing camera. Return pointer to the end of written data.
+    static float* WriteBillboardVertices(float* dest, const Vector3& position, const Vector2& size, float rotation,
+        unsigned color, const Rect& uv);
+    /// Write 4 vertices of billboard oriented along direction. Return pointer to the end of written data.
+    static float* WriteDirectionalBillboardVertices(float* dest, const Vector3& position, const Vector3& direction,
+        const Vector2& size, float rotation, unsigned color, const Rect& uv);
 
     /// Billboards.
     ea::vector<Billboard> billboards_;
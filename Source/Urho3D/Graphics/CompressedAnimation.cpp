@@ -0,0 +1,756 @@
+//
+// Copyright (c) 2017-2021 the rbfx project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "../Precompiled.h"
+
+#include "../Graphics/CompressedAnimation.h"
+#include "../IO/Deserializer.h"
+#include "../IO/Serializer.h"
+
+#include <EASTL/sort.h>
+
+#ifdef URHO3D_SSE
+#include <emmintrin.h>
+#endif
+
+#include "../DebugNew.h"
+
+namespace Urho3D
+{
+
+namespace
+{
+
+/// Max value of 15-bit quantized rotation component.
+const float MAX_ROTATION_COMPONENT_15 = 32767.0f;
+/// Max value of 16-bit quantized rotation component or Vector3 coordinate.
+const float MAX_QUANTIZED_16 = 65535.0f;
+/// Max absolute value of any component of normalized quaternion except the largest one.
+const float MAX_SMALLEST_COMPONENT = M_SQRT2 * 0.5f;
+/// Number of channels decoded at once.
+const unsigned DECODE_CHUNK_SIZE = 64;
+
+/// Quantize value in range [-MAX_SMALLEST_COMPONENT, MAX_SMALLEST_COMPONENT].
+unsigned QuantizeRotationComponent(float value, float maxQuantized)
+{
+    const float normalized = Clamp(value / MAX_SMALLEST_COMPONENT * 0.5f + 0.5f, 0.0f, 1.0f);
+    return static_cast<unsigned>(RoundToInt(normalized * maxQuantized));
+}
+
+/// Restore quantized component of rotation.
+float DequantizeRotationComponent(unsigned value, float maxQuantized)
+{
+    return (value / maxQuantized * 2.0f - 1.0f) * MAX_SMALLEST_COMPONENT;
+}
+
+/// Pack normalized rotation into three 16-bit values.
+/// Two of them store 15-bit components and one bit of the index of the dropped largest component each.
+void PackRotation(const Quaternion& rotation, unsigned short& a, unsigned short& b, unsigned short& c)
+{
+    const Quaternion normalized = rotation.Normalized();
+    float components[4] = { normalized.w_, normalized.x_, normalized.y_, normalized.z_ };
+
+    unsigned largestIndex = 0;
+    for (unsigned i = 1; i < 4; ++i)
+    {
+        if (Abs(components[i]) > Abs(components[largestIndex]))
+            largestIndex = i;
+    }
+
+    // q and -q are the same rotation, make the dropped component positive
+    if (components[largestIndex] < 0.0f)
+    {
+        for (float& component : components)
+            component = -component;
+    }
+
+    float smallest[3];
+    for (unsigned i = 0, j = 0; i < 4; ++i)
+    {
+        if (i != largestIndex)
+            smallest[j++] = components[i];
+    }
+
+    a = static_cast<unsigned short>((QuantizeRotationComponent(smallest[0], MAX_ROTATION_COMPONENT_15) << 1u) | (largestIndex >> 1u));
+    b = static_cast<unsigned short>((QuantizeRotationComponent(smallest[1], MAX_ROTATION_COMPONENT_15) << 1u) | (largestIndex & 1u));
+    c = static_cast<unsigned short>(QuantizeRotationComponent(smallest[2], MAX_QUANTIZED_16));
+}
+
+/// Unpack rotation packed by PackRotation.
+void UnpackRotation(unsigned short a, unsigned short b, unsigned short c, float components[4])
+{
+    const unsigned largestIndex = ((a & 1u) << 1u) | (b & 1u);
+    const float x = DequantizeRotationComponent(a >> 1u, MAX_ROTATION_COMPONENT_15);
+    const float y = DequantizeRotationComponent(b >> 1u, MAX_ROTATION_COMPONENT_15);
+    const float z = DequantizeRotationComponent(c, MAX_QUANTIZED_16);
+    const float largest = sqrtf(ea::max(0.0f, 1.0f - x * x - y * y - z * z));
+
+    // Smallest components are stored in ascending order of their indices
+    switch (largestIndex)
+    {
+    case 0: components[0] = largest; components[1] = x; components[2] = y; components[3] = z; break;
+    case 1: components[0] = x; components[1] = largest; components[2] = y; components[3] = z; break;
+    case 2: components[0] = x; components[1] = y; components[2] = largest; components[3] = z; break;
+    default: components[0] = x; components[1] = y; components[2] = z; components[3] = largest; break;
+    }
+}
+
+/// Quantize coordinate to 16 bits.
+unsigned short QuantizeCoordinate(float value, float min, float step)
+{
+    if (step <= 0.0f)
+        return 0;
+    return static_cast<unsigned short>(Clamp(RoundToInt((value - min) / step), 0, 65535));
+}
+
+/// Return angle between rotations in degrees.
+float GetRotationError(const Quaternion& lhs, const Quaternion& rhs)
+{
+    return 2.0f * Acos(Abs(lhs.Normalized().DotProduct(rhs.Normalized())));
+}
+
+/// Sample source track at given time without looping.
+AnimationKeyFrame SampleTrack(const AnimationTrack& track, float time)
+{
+    unsigned frame = 0;
+    track.GetKeyFrameIndex(time, frame);
+
+    const AnimationKeyFrame& keyFrame = track.keyFrames_[frame];
+    if (frame + 1 >= track.keyFrames_.size())
+        return keyFrame;
+
+    const AnimationKeyFrame& nextKeyFrame = track.keyFrames_[frame + 1];
+    const float timeInterval = nextKeyFrame.time_ - keyFrame.time_;
+    const float t = timeInterval > 0.0f ? Clamp((time - keyFrame.time_) / timeInterval, 0.0f, 1.0f) : 1.0f;
+
+    AnimationKeyFrame result;
+    result.time_ = time;
+    result.position_ = keyFrame.position_.Lerp(nextKeyFrame.position_, t);
+    result.rotation_ = keyFrame.rotation_.Slerp(nextKeyFrame.rotation_, t);
+    result.scale_ = keyFrame.scale_.Lerp(nextKeyFrame.scale_, t);
+    return result;
+}
+
+/// Classify and store Vector3 channel. Values of sampled channels are appended to temporary storage.
+void CompressVector3Channel(CompressedVector3Channels& channels, ea::vector<ea::vector<Vector3>>& sampledValues,
+    unsigned trackIndex, ea::vector<Vector3> values, const ea::vector<float>& lerpFactors, float tolerance)
+{
+    const Vector3 first = values.front();
+    const Vector3 last = values.back();
+
+    const bool isConstant = ea::all_of(values.begin(), values.end(),
+        [&](const Vector3& value) { return (value - first).Length() <= tolerance; });
+    if (isConstant)
+    {
+        channels.constantTracks_.push_back(trackIndex);
+        channels.constantValues_.push_back(first);
+        return;
+    }
+
+    bool isLinear = true;
+    for (unsigned i = 0; i < values.size() && isLinear; ++i)
+        isLinear = (values[i] - first.Lerp(last, lerpFactors[i])).Length() <= tolerance;
+    if (isLinear)
+    {
+        channels.linearTracks_.push_back(trackIndex);
+        channels.linearBegin_.push_back(first);
+        channels.linearEnd_.push_back(last);
+        return;
+    }
+
+    BoundingBox range;
+    for (const Vector3& value : values)
+        range.Merge(value);
+
+    const Vector3 step = (range.max_ - range.min_) / MAX_QUANTIZED_16;
+    channels.sampledTracks_.push_back(trackIndex);
+    channels.minX_.push_back(range.min_.x_);
+    channels.minY_.push_back(range.min_.y_);
+    channels.minZ_.push_back(range.min_.z_);
+    channels.stepX_.push_back(step.x_);
+    channels.stepY_.push_back(step.y_);
+    channels.stepZ_.push_back(step.z_);
+    sampledValues.push_back(ea::move(values));
+}
+
+/// Quantize and interleave values of sampled Vector3 channels.
+void FinalizeVector3Channels(CompressedVector3Channels& channels, const ea::vector<ea::vector<Vector3>>& sampledValues,
+    unsigned numFrames)
+{
+    const unsigned numChannels = channels.sampledTracks_.size();
+    channels.samples_.resize(numFrames * numChannels * 3);
+    for (unsigned frame = 0; frame < numFrames; ++frame)
+    {
+        unsigned short* frameSamples = channels.samples_.data() + frame * numChannels * 3;
+        for (unsigned i = 0; i < numChannels; ++i)
+        {
+            const Vector3& value = sampledValues[i][frame];
+            frameSamples[i] = QuantizeCoordinate(value.x_, channels.minX_[i], channels.stepX_[i]);
+            frameSamples[numChannels + i] = QuantizeCoordinate(value.y_, channels.minY_[i], channels.stepY_[i]);
+            frameSamples[2 * numChannels + i] = QuantizeCoordinate(value.z_, channels.minZ_[i], channels.stepZ_[i]);
+        }
+    }
+}
+
+/// Classify and store rotation channel. Values of sampled channels are appended to temporary storage.
+void CompressRotationChannel(CompressedRotationChannels& channels, ea::vector<ea::vector<Quaternion>>& sampledValues,
+    unsigned trackIndex, ea::vector<Quaternion> values, const ea::vector<float>& lerpFactors, float tolerance)
+{
+    const Quaternion first = values.front().Normalized();
+    const Quaternion last = values.back().Normalized();
+
+    const bool isConstant = ea::all_of(values.begin(), values.end(),
+        [&](const Quaternion& value) { return GetRotationError(value, first) <= tolerance; });
+    if (isConstant)
+    {
+        channels.constantTracks_.push_back(trackIndex);
+        channels.constantValues_.push_back(first);
+        return;
+    }
+
+    bool isLinear = true;
+    for (unsigned i = 0; i < values.size() && isLinear; ++i)
+        isLinear = GetRotationError(values[i], first.Nlerp(last, lerpFactors[i], true)) <= tolerance;
+    if (isLinear)
+    {
+        channels.linearTracks_.push_back(trackIndex);
+        channels.linearBegin_.push_back(first);
+        channels.linearEnd_.push_back(last);
+        return;
+    }
+
+    channels.sampledTracks_.push_back(trackIndex);
+    sampledValues.push_back(ea::move(values));
+}
+
+/// Quantize and interleave values of sampled rotation channels.
+void FinalizeRotationChannels(CompressedRotationChannels& channels, const ea::vector<ea::vector<Quaternion>>& sampledValues,
+    unsigned numFrames)
+{
+    const unsigned numChannels = channels.sampledTracks_.size();
+    channels.samples_.resize(numFrames * numChannels * 3);
+    for (unsigned frame = 0; frame < numFrames; ++frame)
+    {
+        unsigned short* frameSamples = channels.samples_.data() + frame * numChannels * 3;
+        for (unsigned i = 0; i < numChannels; ++i)
+        {
+            PackRotation(sampledValues[i][frame],
+                frameSamples[i], frameSamples[numChannels + i], frameSamples[2 * numChannels + i]);
+        }
+    }
+}
+
+#ifdef URHO3D_SSE
+/// Load 4 quantized values and convert them to floats.
+inline __m128 LoadQuantized4(const unsigned short* values)
+{
+    const __m128i packed = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(values));
+    return _mm_cvtepi32_ps(_mm_unpacklo_epi16(packed, _mm_setzero_si128()));
+}
+#endif
+
+/// Decode and interpolate one coordinate of sampled Vector3 channels.
+void DecodeCoordinates(const unsigned short* samplesA, const unsigned short* samplesB, const float* min, const float* step,
+    float t, unsigned count, float* dest)
+{
+    unsigned i = 0;
+#ifdef URHO3D_SSE
+    const __m128 factor = _mm_set1_ps(t);
+    for (; i + 4 <= count; i += 4)
+    {
+        const __m128 a = LoadQuantized4(samplesA + i);
+        const __m128 b = LoadQuantized4(samplesB + i);
+        const __m128 quantized = _mm_add_ps(a, _mm_mul_ps(_mm_sub_ps(b, a), factor));
+        _mm_storeu_ps(dest + i, _mm_add_ps(_mm_loadu_ps(min + i), _mm_mul_ps(quantized, _mm_loadu_ps(step + i))));
+    }
+#endif
+    for (; i < count; ++i)
+    {
+        const float a = samplesA[i];
+        const float b = samplesB[i];
+        dest[i] = min[i] + (a + (b - a) * t) * step[i];
+    }
+}
+
+/// Sample Vector3 channels.
+void SampleVector3Channels(const CompressedVector3Channels& channels, unsigned frameA, unsigned frameB,
+    float t, float lerpFactor, ea::vector<Vector3>& dest)
+{
+    for (unsigned i = 0; i < channels.constantTracks_.size(); ++i)
+        dest[channels.constantTracks_[i]] = channels.constantValues_[i];
+
+    for (unsigned i = 0; i < channels.linearTracks_.size(); ++i)
+        dest[channels.linearTracks_[i]] = channels.linearBegin_[i].Lerp(channels.linearEnd_[i], lerpFactor);
+
+    const unsigned numChannels = channels.sampledTracks_.size();
+    const unsigned short* samplesA = channels.samples_.data() + frameA * numChannels * 3;
+    const unsigned short* samplesB = channels.samples_.data() + frameB * numChannels * 3;
+
+    float x[DECODE_CHUNK_SIZE];
+    float y[DECODE_CHUNK_SIZE];
+    float z[DECODE_CHUNK_SIZE];
+    for (unsigned chunkBegin = 0; chunkBegin < numChannels; chunkBegin += DECODE_CHUNK_SIZE)
+    {
+        const unsigned count = ea::min(DECODE_CHUNK_SIZE, numChannels - chunkBegin);
+        const unsigned offsetY = numChannels + chunkBegin;
+        const unsigned offsetZ = 2 * numChannels + chunkBegin;
+        DecodeCoordinates(samplesA + chunkBegin, samplesB + chunkBegin,
+            &channels.minX_[chunkBegin], &channels.stepX_[chunkBegin], t, count, x);
+        DecodeCoordinates(samplesA + offsetY, samplesB + offsetY,
+            &channels.minY_[chunkBegin], &channels.stepY_[chunkBegin], t, count, y);
+        DecodeCoordinates(samplesA + offsetZ, samplesB + offsetZ,
+            &channels.minZ_[chunkBegin], &channels.stepZ_[chunkBegin], t, count, z);
+
+        for (unsigned i = 0; i < count; ++i)
+            dest[channels.sampledTracks_[chunkBegin + i]] = Vector3(x[i], y[i], z[i]);
+    }
+}
+
+/// Sample rotation channels.
+void SampleRotationChannels(const CompressedRotationChannels& channels, unsigned frameA, unsigned frameB,
+    float t, float lerpFactor, ea::vector<Quaternion>& dest)
+{
+    for (unsigned i = 0; i < channels.constantTracks_.size(); ++i)
+        dest[channels.constantTracks_[i]] = channels.constantValues_[i];
+
+    for (unsigned i = 0; i < channels.linearTracks_.size(); ++i)
+        dest[channels.linearTracks_[i]] = channels.linearBegin_[i].Nlerp(channels.linearEnd_[i], lerpFactor, true);
+
+    const unsigned numChannels = channels.sampledTracks_.size();
+    const unsigned short* samplesA = channels.samples_.data() + frameA * numChannels * 3;
+    const unsigned short* samplesB = channels.samples_.data() + frameB * numChannels * 3;
+
+    // Unpacked rotations in SoA layout: W, X, Y and Z arrays for both frames
+    float a[4][DECODE_CHUNK_SIZE];
+    float b[4][DECODE_CHUNK_SIZE];
+    for (unsigned chunkBegin = 0; chunkBegin < numChannels; chunkBegin += DECODE_CHUNK_SIZE)
+    {
+        const unsigned count = ea::min(DECODE_CHUNK_SIZE, numChannels - chunkBegin);
+        for (unsigned i = 0; i < count; ++i)
+        {
+            const unsigned index = chunkBegin + i;
+            float components[4];
+
+            UnpackRotation(samplesA[index], samplesA[numChannels + index], samplesA[2 * numChannels + index], components);
+            for (unsigned j = 0; j < 4; ++j)
+                a[j][i] = components[j];
+
+            UnpackRotation(samplesB[index], samplesB[numChannels + index], samplesB[2 * numChannels + index], components);
+            for (unsigned j = 0; j < 4; ++j)
+                b[j][i] = components[j];
+        }
+
+        // Normalized lerp along the shortest path, result is written back to the first frame
+        unsigned i = 0;
+#ifdef URHO3D_SSE
+        const __m128 factor = _mm_set1_ps(t);
+        const __m128 signMask = _mm_set1_ps(-0.0f);
+        for (; i + 4 <= count; i += 4)
+        {
+            __m128 va[4];
+            __m128 vb[4];
+            for (unsigned j = 0; j < 4; ++j)
+            {
+                va[j] = _mm_loadu_ps(&a[j][i]);
+                vb[j] = _mm_loadu_ps(&b[j][i]);
+            }
+
+            const __m128 dot = _mm_add_ps(_mm_add_ps(_mm_mul_ps(va[0], vb[0]), _mm_mul_ps(va[1], vb[1])),
+                _mm_add_ps(_mm_mul_ps(va[2], vb[2]), _mm_mul_ps(va[3], vb[3])));
+            const __m128 sign = _mm_and_ps(dot, signMask);
+
+            __m128 result[4];
+            __m128 lengthSquared = _mm_setzero_ps();
+            for (unsigned j = 0; j < 4; ++j)
+            {
+                const __m128 target = _mm_xor_ps(vb[j], sign);
+                result[j] = _mm_add_ps(va[j], _mm_mul_ps(_mm_sub_ps(target, va[j]), factor));
+                lengthSquared = _mm_add_ps(lengthSquared, _mm_mul_ps(result[j], result[j]));
+            }
+
+            const __m128 invLength = _mm_div_ps(_mm_set1_ps(1.0f), _mm_sqrt_ps(lengthSquared));
+            for (unsigned j = 0; j < 4; ++j)
+                _mm_storeu_ps(&a[j][i], _mm_mul_ps(result[j], invLength));
+        }
+#endif
+        for (; i < count; ++i)
+        {
+            const float dot = a[0][i] * b[0][i] + a[1][i] * b[1][i] + a[2][i] * b[2][i] + a[3][i] * b[3][i];
+            const float sign = dot < 0.0f ? -1.0f : 1.0f;
+
+            float lengthSquared = 0.0f;
+            for (unsigned j = 0; j < 4; ++j)
+            {
+                a[j][i] += (b[j][i] * sign - a[j][i]) * t;
+                lengthSquared += a[j][i] * a[j][i];
+            }
+
+            const float invLength = 1.0f / sqrtf(lengthSquared);
+            for (unsigned j = 0; j < 4; ++j)
+                a[j][i] *= invLength;
+        }
+
+        for (unsigned i = 0; i < count; ++i)
+            dest[channels.sampledTracks_[chunkBegin + i]] = Quaternion(a[0][i], a[1][i], a[2][i], a[3][i]);
+    }
+}
+
+/// Write array of trivially copyable values.
+template <class T>
+void WriteArray(Serializer& dest, const ea::vector<T>& values)
+{
+    dest.WriteVLE(values.size());
+    if (!values.empty())
+        dest.Write(values.data(), values.size() * sizeof(T));
+}
+
+/// Read array of trivially copyable values. Return true if successful.
+template <class T>
+bool ReadArray(Deserializer& source, ea::vector<T>& values)
+{
+    const unsigned size = source.ReadVLE();
+    if (size * sizeof(T) > source.GetSize() - source.GetPosition())
+        return false;
+
+    values.resize(size);
+    return size == 0 || source.Read(values.data(), size * sizeof(T)) == size * sizeof(T);
+}
+
+/// Write Vector3 channels.
+void WriteVector3Channels(Serializer& dest, const CompressedVector3Channels& channels)
+{
+    WriteArray(dest, channels.constantTracks_);
+    WriteArray(dest, channels.constantValues_);
+    WriteArray(dest, channels.linearTracks_);
+    WriteArray(dest, channels.linearBegin_);
+    WriteArray(dest, channels.linearEnd_);
+    WriteArray(dest, channels.sampledTracks_);
+    WriteArray(dest, channels.minX_);
+    WriteArray(dest, channels.minY_);
+    WriteArray(dest, channels.minZ_);
+    WriteArray(dest, channels.stepX_);
+    WriteArray(dest, channels.stepY_);
+    WriteArray(dest, channels.stepZ_);
+    WriteArray(dest, channels.samples_);
+}
+
+/// Read Vector3 channels. Return true if successful.
+bool ReadVector3Channels(Deserializer& source, CompressedVector3Channels& channels)
+{
+    return ReadArray(source, channels.constantTracks_)
+        && ReadArray(source, channels.constantValues_)
+        && ReadArray(source, channels.linearTracks_)
+        && ReadArray(source, channels.linearBegin_)
+        && ReadArray(source, channels.linearEnd_)
+        && ReadArray(source, channels.sampledTracks_)
+        && ReadArray(source, channels.minX_)
+        && ReadArray(source, channels.minY_)
+        && ReadArray(source, channels.minZ_)
+        && ReadArray(source, channels.stepX_)
+        && ReadArray(source, channels.stepY_)
+        && ReadArray(source, channels.stepZ_)
+        && ReadArray(source, channels.samples_);
+}
+
+/// Return whether Vector3 channels are consistent.
+bool IsValid(const CompressedVector3Channels& channels, unsigned numTracks, unsigned numFrames)
+{
+    const unsigned numSampled = channels.sampledTracks_.size();
+    const auto isValidTrack = [&](unsigned trackIndex) { return trackIndex < numTracks; };
+    return channels.constantTracks_.size() == channels.constantValues_.size()
+        && channels.linearTracks_.size() == channels.linearBegin_.size()
+        && channels.linearTracks_.size() == channels.linearEnd_.size()
+        && channels.minX_.size() == numSampled && channels.minY_.size() == numSampled && channels.minZ_.size() == numSampled
+        && channels.stepX_.size() == numSampled && channels.stepY_.size() == numSampled && channels.stepZ_.size() == numSampled
+        && channels.samples_.size() == numFrames * numSampled * 3
+        && ea::all_of(channels.constantTracks_.begin(), channels.constantTracks_.end(), isValidTrack)
+        && ea::all_of(channels.linearTracks_.begin(), channels.linearTracks_.end(), isValidTrack)
+        && ea::all_of(channels.sampledTracks_.begin(), channels.sampledTracks_.end(), isValidTrack);
+}
+
+/// Return whether rotation channels are consistent.
+bool IsValid(const CompressedRotationChannels& channels, unsigned numTracks, unsigned numFrames)
+{
+    const auto isValidTrack = [&](unsigned trackIndex) { return trackIndex < numTracks; };
+    return channels.constantTracks_.size() == channels.constantValues_.size()
+        && channels.linearTracks_.size() == channels.linearBegin_.size()
+        && channels.linearTracks_.size() == channels.linearEnd_.size()
+        && channels.samples_.size() == numFrames * channels.sampledTracks_.size() * 3
+        && ea::all_of(channels.constantTracks_.begin(), channels.constantTracks_.end(), isValidTrack)
+        && ea::all_of(channels.linearTracks_.begin(), channels.linearTracks_.end(), isValidTrack)
+        && ea::all_of(channels.sampledTracks_.begin(), channels.sampledTracks_.end(), isValidTrack);
+}
+
+/// Return memory used by Vector3 channels.
+unsigned GetMemoryUse(const CompressedVector3Channels& channels)
+{
+    return channels.constantTracks_.size() * (sizeof(unsigned) + sizeof(Vector3))
+        + channels.linearTracks_.size() * (sizeof(unsigned) + 2 * sizeof(Vector3))
+        + channels.sampledTracks_.size() * (sizeof(unsigned) + 6 * sizeof(float))
+        + channels.samples_.size() * sizeof(unsigned short);
+}
+
+/// Return memory used by rotation channels.
+unsigned GetMemoryUse(const CompressedRotationChannels& channels)
+{
+    return channels.constantTracks_.size() * (sizeof(unsigned) + sizeof(Quaternion))
+        + channels.linearTracks_.size() * (sizeof(unsigned) + 2 * sizeof(Quaternion))
+        + channels.sampledTracks_.size() * sizeof(unsigned)
+        + channels.samples_.size() * sizeof(unsigned short);
+}
+
+}
+
+void CompressedAnimation::Compress(const Animation& animation, const AnimationCompressionSettings& settings)
+{
+    length_ = ea::max(0.0f, animation.GetLength());
+    sampleRate_ = settings.sampleRate_ > 0.0f ? settings.sampleRate_ : AnimationCompressionSettings{}.sampleRate_;
+    numFrames_ = static_cast<unsigned>(CeilToInt(length_ * sampleRate_)) + 1;
+
+    trackNameHashes_.clear();
+    trackChannels_.clear();
+    positions_ = {};
+    rotations_ = {};
+    scales_ = {};
+
+    // Keep track order independent of hash map layout
+    ea::vector<const AnimationTrack*> tracks;
+    for (const auto& item : animation.GetTracks())
+        tracks.push_back(&item.second);
+    ea::sort(tracks.begin(), tracks.end(),
+        [](const AnimationTrack* lhs, const AnimationTrack* rhs) { return lhs->nameHash_.Value() < rhs->nameHash_.Value(); });
+
+    ea::vector<float> lerpFactors(numFrames_);
+    ea::vector<float> frameTimes(numFrames_);
+    for (unsigned frame = 0; frame < numFrames_; ++frame)
+    {
+        frameTimes[frame] = ea::min(frame / sampleRate_, length_);
+        lerpFactors[frame] = length_ > 0.0f ? frameTimes[frame] / length_ : 0.0f;
+    }
+
+    ea::vector<ea::vector<Vector3>> sampledPositions;
+    ea::vector<ea::vector<Quaternion>> sampledRotations;
+    ea::vector<ea::vector<Vector3>> sampledScales;
+
+    ea::vector<Vector3> positions(numFrames_);
+    ea::vector<Quaternion> rotations(numFrames_);
+    ea::vector<Vector3> scales(numFrames_);
+    for (const AnimationTrack* track : tracks)
+    {
+        const unsigned trackIndex = trackNameHashes_.size();
+        const AnimationChannelFlags channels = track->keyFrames_.empty() ? CHANNEL_NONE : track->channelMask_;
+        trackNameHashes_.push_back(track->nameHash_);
+        trackChannels_.push_back(channels.AsInteger());
+        if (!channels)
+            continue;
+
+        for (unsigned frame = 0; frame < numFrames_; ++frame)
+        {
+            const AnimationKeyFrame keyFrame = SampleTrack(*track, frameTimes[frame]);
+            positions[frame] = keyFrame.position_;
+            rotations[frame] = keyFrame.rotation_;
+            scales[frame] = keyFrame.scale_;
+        }
+
+        if (channels & CHANNEL_POSITION)
+        {
+            CompressVector3Channel(positions_, sampledPositions, trackIndex, positions, lerpFactors,
+                settings.positionTolerance_);
+        }
+        if (channels & CHANNEL_ROTATION)
+        {
+            CompressRotationChannel(rotations_, sampledRotations, trackIndex, rotations, lerpFactors,
+                settings.rotationTolerance_);
+        }
+        if (channels & CHANNEL_SCALE)
+            CompressVector3Channel(scales_, sampledScales, trackIndex, scales, lerpFactors, settings.scaleTolerance_);
+    }
+
+    FinalizeVector3Channels(positions_, sampledPositions, numFrames_);
+    FinalizeRotationChannels(rotations_, sampledRotations, numFrames_);
+    FinalizeVector3Channels(scales_, sampledScales, numFrames_);
+}
+
+void CompressedAnimation::Sample(float time, AnimationPose& pose) const
+{
+    const unsigned numTracks = GetNumTracks();
+    if (pose.positions_.size() != numTracks)
+        pose.Reset(numTracks);
+
+    if (!numFrames_)
+        return;
+
+    time = Clamp(time, 0.0f, length_);
+    const unsigned frameA = ea::min(static_cast<unsigned>(time * sampleRate_), numFrames_ - 1);
+    const unsigned frameB = ea::min(frameA + 1, numFrames_ - 1);
+
+    // Last interval may be shorter than others
+    const float timeA = frameA / sampleRate_;
+    const float timeB = ea::min(frameB / sampleRate_, length_);
+    const float t = timeB > timeA ? Clamp((time - timeA) / (timeB - timeA), 0.0f, 1.0f) : 0.0f;
+    const float lerpFactor = length_ > 0.0f ? time / length_ : 0.0f;
+
+    SampleVector3Channels(positions_, frameA, frameB, t, lerpFactor, pose.positions_);
+    SampleRotationChannels(rotations_, frameA, frameB, t, lerpFactor, pose.rotations_);
+    SampleVector3Channels(scales_, frameA, frameB, t, lerpFactor, pose.scales_);
+}
+
+AnimationCompressionError CompressedAnimation::MeasureError(const Animation& animation) const
+{
+    // Evaluate at all source keyframes and between them
+    ea::vector<float> times;
+    const auto& tracks = animation.GetTracks();
+    for (const auto& item : tracks)
+    {
+        const ea::vector<AnimationKeyFrame>& keyFrames = item.second.keyFrames_;
+        for (unsigned i = 0; i < keyFrames.size(); ++i)
+        {
+            times.push_back(keyFrames[i].time_);
+            if (i + 1 < keyFrames.size())
+                times.push_back((keyFrames[i].time_ + keyFrames[i + 1].time_) * 0.5f);
+        }
+    }
+    ea::sort(times.begin(), times.end());
+    times.erase(ea::unique(times.begin(), times.end()), times.end());
+
+    AnimationCompressionError error;
+    double totalPositionError = 0.0;
+    double totalRotationError = 0.0;
+    double totalScaleError = 0.0;
+    unsigned numPositions = 0;
+    unsigned numRotations = 0;
+    unsigned numScales = 0;
+
+    AnimationPose pose;
+    for (const float time : times)
+    {
+        const float clampedTime = Clamp(time, 0.0f, length_);
+        Sample(clampedTime, pose);
+
+        for (unsigned trackIndex = 0; trackIndex < GetNumTracks(); ++trackIndex)
+        {
+            const auto iter = tracks.find(trackNameHashes_[trackIndex]);
+            const AnimationChannelFlags channels = GetTrackChannels(trackIndex);
+            if (iter == tracks.end() || !channels)
+                continue;
+
+            const AnimationKeyFrame expected = SampleTrack(iter->second, clampedTime);
+            if (channels & CHANNEL_POSITION)
+            {
+                const float positionError = (pose.positions_[trackIndex] - expected.position_).Length();
+                error.maxPositionError_ = ea::max(error.maxPositionError_, positionError);
+                totalPositionError += positionError;
+                ++numPositions;
+            }
+            if (channels & CHANNEL_ROTATION)
+            {
+                const float rotationError = GetRotationError(pose.rotations_[trackIndex], expected.rotation_);
+                error.maxRotationError_ = ea::max(error.maxRotationError_, rotationError);
+                totalRotationError += rotationError;
+                ++numRotations;
+            }
+            if (channels & CHANNEL_SCALE)
+            {
+                const float scaleError = (pose.scales_[trackIndex] - expected.scale_).Length();
+                error.maxScaleError_ = ea::max(error.maxScaleError_, scaleError);
+                totalScaleError += scaleError;
+                ++numScales;
+            }
+        }
+    }
+
+    error.averagePositionError_ = numPositions ? static_cast<float>(totalPositionError / numPositions) : 0.0f;
+    error.averageRotationError_ = numRotations ? static_cast<float>(totalRotationError / numRotations) : 0.0f;
+    error.averageScaleError_ = numScales ? static_cast<float>(totalScaleError / numScales) : 0.0f;
+    return error;
+}
+
+bool CompressedAnimation::Load(Deserializer& source)
+{
+    length_ = source.ReadFloat();
+    sampleRate_ = source.ReadFloat();
+    numFrames_ = source.ReadVLE();
+
+    ea::vector<unsigned> trackNameHashes;
+    if (!ReadArray(source, trackNameHashes) || !ReadArray(source, trackChannels_)
+        || !ReadVector3Channels(source, positions_) || !ReadArray(source, rotations_.constantTracks_)
+        || !ReadArray(source, rotations_.constantValues_) || !ReadArray(source, rotations_.linearTracks_)
+        || !ReadArray(source, rotations_.linearBegin_) || !ReadArray(source, rotations_.linearEnd_)
+        || !ReadArray(source, rotations_.sampledTracks_) || !ReadArray(source, rotations_.samples_)
+        || !ReadVector3Channels(source, scales_))
+    {
+        return false;
+    }
+
+    trackNameHashes_.clear();
+    for (unsigned nameHash : trackNameHashes)
+        trackNameHashes_.push_back(StringHash(nameHash));
+
+    const unsigned numTracks = trackNameHashes_.size();
+    return trackChannels_.size() == numTracks && (numFrames_ > 0 || numTracks == 0) && sampleRate_ > 0.0f
+        && IsValid(positions_, numTracks, numFrames_) && IsValid(rotations_, numTracks, numFrames_)
+        && IsValid(scales_, numTracks, numFrames_);
+}
+
+bool CompressedAnimation::Save(Serializer& dest) const
+{
+    dest.WriteFloat(length_);
+    dest.WriteFloat(sampleRate_);
+    dest.WriteVLE(numFrames_);
+
+    ea::vector<unsigned> trackNameHashes;
+    for (StringHash nameHash : trackNameHashes_)
+        trackNameHashes.push_back(nameHash.Value());
+    WriteArray(dest, trackNameHashes);
+    WriteArray(dest, trackChannels_);
+
+    WriteVector3Channels(dest, positions_);
+    WriteArray(dest, rotations_.constantTracks_);
+    WriteArray(dest, rotations_.constantValues_);
+    WriteArray(dest, rotations_.linearTracks_);
+    WriteArray(dest, rotations_.linearBegin_);
+    WriteArray(dest, rotations_.linearEnd_);
+    WriteArray(dest, rotations_.sampledTracks_);
+    WriteArray(dest, rotations_.samples_);
+    WriteVector3Channels(dest, scales_);
+    return true;
+}
+
+unsigned CompressedAnimation::GetTrackIndex(StringHash nameHash) const
+{
+    const auto iter = ea::find(trackNameHashes_.begin(), trackNameHashes_.end(), nameHash);
+    return iter != trackNameHashes_.end() ? static_cast<unsigned>(iter - trackNameHashes_.begin()) : M_MAX_UNSIGNED;
+}
+
+AnimationChannelFlags CompressedAnimation::GetTrackChannels(unsigned index) const
+{
+    return AnimationChannelFlags(static_cast<AnimationChannel>(trackChannels_[index]));
+}
+
+unsigned CompressedAnimation::GetMemoryUse() const
+{
+    return sizeof(CompressedAnimation)
+        + trackNameHashes_.size() * (sizeof(StringHash) + sizeof(unsigned char))
+        + Urho3D::GetMemoryUse(positions_) + Urho3D::GetMemoryUse(rotations_) + Urho3D::GetMemoryUse(scales_);
+}
+
+}
@@ -0,0 +1,206 @@
+//
+// Copyright (c) 2017-2021 the rbfx project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+/// \file
+
+#pragma once
+
+#include "../Graphics/Animation.h"
+
+#include <EASTL/vector.h>
+
+namespace Urho3D
+{
+
+class Deserializer;
+class Serializer;
+
+/// Settings of animation clip compression.
+struct URHO3D_API AnimationCompressionSettings
+{
+    /// Number of uniform samples per second for channels that cannot be reduced.
+    float sampleRate_{ 30.0f };
+    /// Max position error allowed when channel is reduced to constant or linear.
+    float positionTolerance_{ 0.001f };
+    /// Max rotation error in degrees allowed when channel is reduced to constant or linear.
+    float rotationTolerance_{ 0.1f };
+    /// Max scale error allowed when channel is reduced to constant or linear.
+    float scaleTolerance_{ 0.001f };
+};
+
+/// Error of compressed animation clip relative to source keyframes.
+struct URHO3D_API AnimationCompressionError
+{
+    /// Max position error.
+    float maxPositionError_{};
+    /// Max rotation error in degrees.
+    float maxRotationError_{};
+    /// Max scale error.
+    float maxScaleError_{};
+    /// Average position error.
+    float averagePositionError_{};
+    /// Average rotation error in degrees.
+    float averageRotationError_{};
+    /// Average scale error.
+    float averageScaleError_{};
+};
+
+/// Local transforms of all tracks of animation clip sampled at one time.
+struct URHO3D_API AnimationPose
+{
+    /// Resize pose and reset transforms to identity.
+    void Reset(unsigned numTracks)
+    {
+        positions_.clear();
+        rotations_.clear();
+        scales_.clear();
+        positions_.resize(numTracks, Vector3::ZERO);
+        rotations_.resize(numTracks, Quaternion::IDENTITY);
+        scales_.resize(numTracks, Vector3::ONE);
+    }
+
+    /// Track positions.
+    ea::vector<Vector3> positions_;
+    /// Track rotations.
+    ea::vector<Quaternion> rotations_;
+    /// Track scales.
+    ea::vector<Vector3> scales_;
+};
+
+/// Compressed channels of Vector3 values, used for positions and scales.
+/// Channels that don't change are stored as single value, channels that change linearly are stored as two values,
+/// other channels are sampled with uniform rate and quantized to 16 bits within their range.
+struct URHO3D_API CompressedVector3Channels
+{
+    /// Track indices of constant channels.
+    ea::vector<unsigned> constantTracks_;
+    /// Values of constant channels.
+    ea::vector<Vector3> constantValues_;
+
+    /// Track indices of linear channels.
+    ea::vector<unsigned> linearTracks_;
+    /// Values of linear channels at the beginning of the clip.
+    ea::vector<Vector3> linearBegin_;
+    /// Values of linear channels at the end of the clip.
+    ea::vector<Vector3> linearEnd_;
+
+    /// Track indices of sampled channels.
+    ea::vector<unsigned> sampledTracks_;
+    /// Min X values of sampled channels.
+    ea::vector<float> minX_;
+    /// Min Y values of sampled channels.
+    ea::vector<float> minY_;
+    /// Min Z values of sampled channels.
+    ea::vector<float> minZ_;
+    /// X range of sampled channels divided by quantization range.
+    ea::vector<float> stepX_;
+    /// Y range of sampled channels divided by quantization range.
+    ea::vector<float> stepY_;
+    /// Z range of sampled channels divided by quantization range.
+    ea::vector<float> stepZ_;
+    /// Quantized samples. Frames are stored one after another, each frame stores X, Y and Z arrays of all sampled channels.
+    ea::vector<unsigned short> samples_;
+};
+
+/// Compressed rotation channels.
+/// Sampled rotations are quantized to 48 bits using smallest three components.
+struct URHO3D_API CompressedRotationChannels
+{
+    /// Track indices of constant channels.
+    ea::vector<unsigned> constantTracks_;
+    /// Values of constant channels.
+    ea::vector<Quaternion> constantValues_;
+
+    /// Track indices of linear channels.
+    ea::vector<unsigned> linearTracks_;
+    /// Values of linear channels at the beginning of the clip.
+    ea::vector<Quaternion> linearBegin_;
+    /// Values of linear channels at the end of the clip.
+    ea::vector<Quaternion> linearEnd_;
+
+    /// Track indices of sampled channels.
+    ea::vector<unsigned> sampledTracks_;
+    /// Quantized samples. Frames are stored one after another, each frame stores three arrays of packed components of all sampled channels.
+    ea::vector<unsigned short> samples_;
+};
+
+/// Compressed representation of skeletal animation clip optimized for sampling of all tracks at once.
+/// Sampled channels are interpolated linearly between uniform samples, rotations are interpolated with normalized lerp.
+class URHO3D_API CompressedAnimation
+{
+public:
+    /// Compress tracks of the animation. Source tracks are sampled without looping. AnimationState of looped animation samples the segment after the last keyframe from keyframes.
+    void Compress(const Animation& animation, const AnimationCompressionSettings& settings);
+    /// Sample all tracks at given time. Time is clamped to clip length.
+    void Sample(float time, AnimationPose& pose) const;
+    /// Measure error relative to source keyframes of the animation. Source tracks are sampled at their keyframes and between them.
+    AnimationCompressionError MeasureError(const Animation& animation) const;
+
+    /// Load from binary stream. Return true if successful.
+    bool Load(Deserializer& source);
+    /// Save to binary stream. Return true if successful.
+    bool Save(Serializer& dest) const;
+
+    /// Return number of tracks.
+    unsigned GetNumTracks() const { return trackNameHashes_.size(); }
+    /// Return track index by name hash, or M_MAX_UNSIGNED if not found.
+    unsigned GetTrackIndex(StringHash nameHash) const;
+    /// Return track name hash.
+    StringHash GetTrackNameHash(unsigned index) const { return trackNameHashes_[index]; }
+    /// Return channels stored in the track.
+    AnimationChannelFlags GetTrackChannels(unsigned index) const;
+    /// Return clip length.
+    float GetLength() const { return length_; }
+    /// Return number of uniform samples per second.
+    float GetSampleRate() const { return sampleRate_; }
+    /// Return number of uniform samples.
+    unsigned GetNumFrames() const { return numFrames_; }
+    /// Return approximate memory use in bytes.
+    unsigned GetMemoryUse() const;
+
+    /// Return compressed positions.
+    const CompressedVector3Channels& GetPositions() const { return positions_; }
+    /// Return compressed rotations.
+    const CompressedRotationChannels& GetRotations() const { return rotations_; }
+    /// Return compressed scales.
+    const CompressedVector3Channels& GetScales() const { return scales_; }
+
+private:
+    /// Clip length.
+    float length_{};
+    /// Number of uniform samples per second.
+    float sampleRate_{};
+    /// Number of uniform samples.
+    unsigned numFrames_{};
+    /// Track name hashes.
+    ea::vector<StringHash> trackNameHashes_;
+    /// Track channel masks.
+    ea::vector<unsigned char> trackChannels_;
+    /// Compressed positions.
+    CompressedVector3Channels positions_;
+    /// Compressed rotations.
+    CompressedRotationChannels rotations_;
+    /// Compressed scales.
+    CompressedVector3Channels scales_;
+};
+
+}
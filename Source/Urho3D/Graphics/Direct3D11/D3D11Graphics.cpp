@@ -471,6 +471,14 @@ bool Graphics::TakeScreenShot(Image& destImage)
 
 bool Graphics::BeginFrame()
 {
+    // Null device doesn't render anything, only frame statistics are reset
+    if (nullDevice_)
+    {
+        numPrimitives_ = 0;
+        numBatches_ = 0;
+        return false;
+    }
+
     if (!IsInitialized())
         return false;
 
@@ -693,6 +701,12 @@ bool Graphics::ResolveToTexture(TextureCube* texture)
 
 void Graphics::Draw(PrimitiveType type, unsigned vertexStart, unsigned vertexCount)
 {
+    if (nullDevice_)
+    {
+        AddNullDraw(type, vertexCount);
+        return;
+    }
+
     if (!vertexCount || !impl_->shaderProgram_)
         return;
 
@@ -718,6 +732,12 @@ void Graphics::Draw(PrimitiveType type, unsigned vertexStart, unsigned vertexCou
 
 void Graphics::Draw(PrimitiveType type, unsigned indexStart, unsigned indexCount, unsigned minVertex, unsigned vertexCount)
 {
+    if (nullDevice_)
+    {
+        AddNullDraw(type, indexCount);
+        return;
+    }
+
     if (!impl_->shaderProgram_)
         return;
 
@@ -743,6 +763,12 @@ void Graphics::Draw(PrimitiveType type, unsigned indexStart, unsigned indexCount
 
 void Graphics::Draw(PrimitiveType type, unsigned indexStart, unsigned indexCount, unsigned baseVertexIndex, unsigned minVertex, unsigned vertexCount)
 {
+    if (nullDevice_)
+    {
+        AddNullDraw(type, indexCount);
+        return;
+    }
+
     if (!impl_->shaderProgram_)
         return;
 
@@ -769,6 +795,12 @@ void Graphics::Draw(PrimitiveType type, unsigned indexStart, unsigned indexCount
 void Graphics::DrawInstanced(PrimitiveType type, unsigned indexStart, unsigned indexCount, unsigned minVertex, unsigned vertexCount,
     unsigned instanceCount)
 {
+    if (nullDevice_)
+    {
+        AddNullDraw(type, indexCount, instanceCount);
+        return;
+    }
+
     if (!indexCount || !instanceCount || !impl_->shaderProgram_)
         return;
 
@@ -795,6 +827,12 @@ void Graphics::DrawInstanced(PrimitiveType type, unsigned indexStart, unsigned i
 void Graphics::DrawInstanced(PrimitiveType type, unsigned indexStart, unsigned indexCount, unsigned baseVertexIndex, unsigned minVertex, unsigned vertexCount,
     unsigned instanceCount)
 {
+    if (nullDevice_)
+    {
+        AddNullDraw(type, indexCount, instanceCount);
+        return;
+    }
+
     if (!indexCount || !instanceCount || !impl_->shaderProgram_)
         return;
 
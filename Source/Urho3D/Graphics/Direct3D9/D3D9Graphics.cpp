@@ -611,6 +611,14 @@ bool Graphics::TakeScreenShot(Image& destImage)
 
 bool Graphics::BeginFrame()
 {
+    // Null device doesn't render anything, only frame statistics are reset
+    if (nullDevice_)
+    {
+        numPrimitives_ = 0;
+        numBatches_ = 0;
+        return false;
+    }
+
     if (!IsInitialized())
         return false;
 
@@ -848,6 +856,12 @@ bool Graphics::ResolveToTexture(TextureCube* texture)
 
 void Graphics::Draw(PrimitiveType type, unsigned vertexStart, unsigned vertexCount)
 {
+    if (nullDevice_)
+    {
+        AddNullDraw(type, vertexCount);
+        return;
+    }
+
     if (!vertexCount)
         return;
 
@@ -865,6 +879,12 @@ void Graphics::Draw(PrimitiveType type, unsigned vertexStart, unsigned vertexCou
 
 void Graphics::Draw(PrimitiveType type, unsigned indexStart, unsigned indexCount, unsigned minVertex, unsigned vertexCount)
 {
+    if (nullDevice_)
+    {
+        AddNullDraw(type, indexCount);
+        return;
+    }
+
     if (!indexCount)
         return;
 
@@ -882,6 +902,12 @@ void Graphics::Draw(PrimitiveType type, unsigned indexStart, unsigned indexCount
 
 void Graphics::Draw(PrimitiveType type, unsigned indexStart, unsigned indexCount, unsigned baseVertexIndex, unsigned minVertex, unsigned vertexCount)
 {
+    if (nullDevice_)
+    {
+        AddNullDraw(type, indexCount);
+        return;
+    }
+
     if (!indexCount)
         return;
 
@@ -900,6 +926,12 @@ void Graphics::Draw(PrimitiveType type, unsigned indexStart, unsigned indexCount
 void Graphics::DrawInstanced(PrimitiveType type, unsigned indexStart, unsigned indexCount, unsigned minVertex, unsigned vertexCount,
     unsigned instanceCount)
 {
+    if (nullDevice_)
+    {
+        AddNullDraw(type, indexCount, instanceCount);
+        return;
+    }
+
     if (!indexCount || !instanceCount)
         return;
 
@@ -930,6 +962,12 @@ void Graphics::DrawInstanced(PrimitiveType type, unsigned indexStart, unsigned i
 void Graphics::DrawInstanced(PrimitiveType type, unsigned indexStart, unsigned indexCount, unsigned baseVertexIndex, unsigned minVertex,
     unsigned vertexCount, unsigned instanceCount)
 {
+    if (nullDevice_)
+    {
+        AddNullDraw(type, indexCount, instanceCount);
+        return;
+    }
+
     if (!indexCount || !instanceCount)
         return;
 
@@ -76,6 +76,20 @@ void DrawCommandQueue::Execute()
     if (drawCommands_.empty())
         return;
 
+    // Null device has no state to set, draw calls are only counted
+    if (graphics_->IsNullDevice())
+    {
+        for (const DrawCommandDescription& cmd : drawCommands_)
+        {
+            const PrimitiveType primitiveType = cmd.pipelineState_->GetDesc().primitiveType_;
+            if (cmd.instanceCount_ != 0)
+                graphics_->DrawInstanced(primitiveType, cmd.indexStart_, cmd.indexCount_, 0, 0, cmd.instanceCount_);
+            else
+                graphics_->Draw(primitiveType, cmd.indexStart_, cmd.indexCount_, 0, 0);
+        }
+        return;
+    }
+
     // Constant buffers to store all shader parameters for queue
     ea::vector<SharedPtr<ConstantBuffer>> constantBuffers;
 
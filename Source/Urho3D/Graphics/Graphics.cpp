@@ -26,6 +26,7 @@
 #include "../Graphics/AnimatedModel.h"
 #include "../Graphics/Animation.h"
 #include "../Graphics/AnimationController.h"
+#include "../Graphics/AnimationPoseCache.h"
 #include "../Graphics/Camera.h"
 #include "../Graphics/ConstantBuffer.h"
 #include "../Graphics/Geometry.h"
@@ -179,6 +180,65 @@ bool Graphics::SetMode(int width, int height)
     return SetDefaultWindowModes(width, height, screenParams_);
 }
 
+void Graphics::SetNullDevice(int width, int height)
+{
+    nullDevice_ = true;
+    width_ = width;
+    height_ = height;
+
+    // Report typical capabilities so render pipeline, including shadows, is processed on CPU as usual
+    shadowMapFormat_ = GetReadableDepthFormat();
+    hiresShadowMapFormat_ = GetReadableDepthFormat();
+    caps.maxTextureSize_ = 4096;
+    caps.maxRenderTargetSize_ = 4096;
+    caps.maxNumRenderTargets_ = 4;
+}
+
+ShaderProgramLayout* Graphics::GetNullShaderProgramLayout(ShaderVariation* vs, ShaderVariation* ps)
+{
+    if (!vs || !ps)
+        return nullptr;
+
+    SharedPtr<ShaderProgramLayout>& layout = nullShaderProgramLayouts_[ea::make_pair(vs, ps)];
+    if (!layout)
+        layout = MakeShared<ShaderProgramLayout>();
+    return layout;
+}
+
+void Graphics::AddNullDraw(PrimitiveType type, unsigned elementCount, unsigned instanceCount)
+{
+    unsigned primitiveCount = 0;
+    switch (type)
+    {
+    case TRIANGLE_LIST:
+        primitiveCount = elementCount / 3;
+        break;
+
+    case LINE_LIST:
+        primitiveCount = elementCount / 2;
+        break;
+
+    case POINT_LIST:
+        primitiveCount = elementCount;
+        break;
+
+    case TRIANGLE_STRIP:
+    case TRIANGLE_FAN:
+        primitiveCount = elementCount > 2 ? elementCount - 2 : 0;
+        break;
+
+    case LINE_STRIP:
+        primitiveCount = elementCount > 1 ? elementCount - 1 : 0;
+        break;
+    }
+
+    if (!primitiveCount || !instanceCount)
+        return;
+
+    numPrimitives_ += instanceCount * primitiveCount;
+    ++numBatches_;
+}
+
 bool Graphics::ToggleFullscreen()
 {
     ea::swap(primaryWindowMode_, secondaryWindowMode_);
@@ -638,6 +698,7 @@ void RegisterGraphicsLibrary(Context* context)
     Skybox::RegisterObject(context);
     AnimatedModel::RegisterObject(context);
     AnimationController::RegisterObject(context);
+    AnimationPoseCache::RegisterObject(context);
     BillboardSet::RegisterObject(context);
     ParticleEffect::RegisterObject(context);
     ParticleEmitter::RegisterObject(context);
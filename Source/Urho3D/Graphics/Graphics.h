@@ -29,6 +29,7 @@
 #include "../Core/Object.h"
 #include "../Graphics/GraphicsDefs.h"
 #include "../Graphics/ShaderVariation.h"
+#include "../Graphics/ShaderProgramLayout.h"
 #include "../Graphics/PipelineState.h"
 #include "../Math/Color.h"
 #include "../Math/Plane.h"
@@ -221,6 +222,10 @@ public:
         bool highDPI, bool vsync, bool tripleBuffer, int multiSample, int monitor, int refreshRate, bool gpuDebug);
     /// Set screen resolution only. Deprecated. Return true if successful.
     bool SetMode(int width, int height);
+    /// Use null device of given size instead of window. GPU objects are never created and nothing can be drawn,
+    /// but Renderer and render pipeline can be updated on CPU as usual. Used in headless mode.
+    /// Draw calls only update primitive and batch counters, BeginFrame() resets them and returns false.
+    void SetNullDevice(int width, int height);
     /// Set whether the main window uses sRGB conversion on write.
     /// @property
     void SetSRGB(bool enable);
@@ -485,6 +490,12 @@ public:
     /// @property
     bool IsDeviceLost() const;
 
+    /// Return whether null device is used.
+    bool IsNullDevice() const { return nullDevice_; }
+
+    /// Return placeholder shader program layout for null device.
+    ShaderProgramLayout* GetNullShaderProgramLayout(ShaderVariation* vs, ShaderVariation* ps);
+
     /// Return number of primitives drawn this frame.
     /// @property
     unsigned GetNumPrimitives() const { return numPrimitives_; }
@@ -805,6 +816,8 @@ private:
     void SetTextureUnitMappings();
     /// Process dirtied state before draw.
     void PrepareDraw();
+    /// Count primitives and batch of a draw call on null device.
+    void AddNullDraw(PrimitiveType type, unsigned elementCount, unsigned instanceCount = 1);
     /// Create intermediate texture for multisampled backbuffer resolve. No-op if already exists.
     void CreateResolveTexture();
     /// Clean up all framebuffers. Called when destroying the context. Used only on OpenGL.
@@ -883,6 +896,10 @@ private:
     bool sRGBSupport_{};
     /// sRGB conversion on write support flag.
     bool sRGBWriteSupport_{};
+    /// Null device flag.
+    bool nullDevice_{};
+    /// Placeholder shader program layouts for null device.
+    ea::unordered_map<ea::pair<ShaderVariation*, ShaderVariation*>, SharedPtr<ShaderProgramLayout>> nullShaderProgramLayouts_;
     /// Number of primitives this frame.
     unsigned numPrimitives_{};
     /// Number of batches this frame.
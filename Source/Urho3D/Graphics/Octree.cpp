@@ -57,6 +57,7 @@ static ea::vector<Drawable*> unusedDrawablesVector;
 
 static const float DEFAULT_OCTREE_SIZE = 1000.0f;
 static const int DEFAULT_OCTREE_LEVELS = 8;
+static const unsigned REINSERTION_BUCKET_SIZE = 256;
 
 extern const char* SUBSYSTEM_CATEGORY;
 
@@ -135,48 +136,59 @@ Octant* Octant::GetOrCreateChild(unsigned index)
     else
         newMax.z_ = oldCenter.z_;
 
-    children_[index] = new Octant(BoundingBox(newMin, newMax), level_ + 1, this, octree_, index);
+    children_[index] = octree_->octantAllocator_.Reserve(
+        BoundingBox(newMin, newMax), level_ + 1, this, octree_, index);
     return children_[index];
 }
 
 void Octant::DeleteChild(unsigned index)
 {
     assert(index < NUM_OCTANTS);
-    delete children_[index];
-    children_[index] = nullptr;
+    if (children_[index])
+    {
+        octree_->octantAllocator_.Free(children_[index]);
+        children_[index] = nullptr;
+    }
 }
 
 void Octant::InsertDrawable(Drawable* drawable)
 {
-    const BoundingBox& box = drawable->GetWorldBoundingBox();
-
-    // If root octant, insert all non-occludees here, so that octant occlusion does not hide the drawable.
-    // Also if drawable is outside the root octant bounds, insert to root
-    bool insertHere;
-    if (this == octree_->GetRootOctant())
-        insertHere = !drawable->IsOccludee() || cullingBox_.IsInside(box) != INSIDE || CheckDrawableFit(box);
-    else
-        insertHere = CheckDrawableFit(box);
-
-    if (insertHere)
+    Octant* newOctant = GetInsertionOctant(drawable->GetWorldBoundingBox(), drawable->IsOccludee(), true);
+    Octant* oldOctant = drawable->octant_;
+    if (oldOctant != newOctant)
     {
-        Octant* oldOctant = drawable->octant_;
-        if (oldOctant != this)
-        {
-            // Add first, then remove, because drawable count going to zero deletes the octree branch in question
-            AddDrawable(drawable);
-            if (oldOctant)
-                oldOctant->RemoveDrawable(drawable, false);
-        }
+        // Add first, then remove, because drawable count going to zero deletes the octree branch in question
+        newOctant->AddDrawable(drawable);
+        if (oldOctant)
+            oldOctant->RemoveDrawable(drawable, false);
     }
-    else
+}
+
+Octant* Octant::GetInsertionOctant(const BoundingBox& box, bool isOccludee, bool createChildren)
+{
+    const Vector3 boxCenter = box.Center();
+    Octant* octant = this;
+    while (true)
     {
-        Vector3 boxCenter = box.Center();
-        unsigned x = boxCenter.x_ < center_.x_ ? 0 : 1;
-        unsigned y = boxCenter.y_ < center_.y_ ? 0 : 2;
-        unsigned z = boxCenter.z_ < center_.z_ ? 0 : 4;
+        // If root octant, insert all non-occludees here, so that octant occlusion does not hide the drawable.
+        // Also if drawable is outside the root octant bounds, insert to root
+        bool insertHere;
+        if (octant == octree_->GetRootOctant())
+            insertHere = !isOccludee || octant->cullingBox_.IsInside(box) != INSIDE || octant->CheckDrawableFit(box);
+        else
+            insertHere = octant->CheckDrawableFit(box);
+
+        if (insertHere)
+            return octant;
 
-        GetOrCreateChild(x + y + z)->InsertDrawable(drawable);
+        const unsigned x = boxCenter.x_ < octant->center_.x_ ? 0 : 1;
+        const unsigned y = boxCenter.y_ < octant->center_.y_ ? 0 : 2;
+        const unsigned z = boxCenter.z_ < octant->center_.z_ ? 0 : 4;
+
+        const unsigned childIndex = x + y + z;
+        if (!octant->children_[childIndex] && !createChildren)
+            return nullptr;
+        octant = octant->GetOrCreateChild(childIndex);
     }
 }
 
@@ -216,14 +228,14 @@ void Octant::SetRootSize(const BoundingBox& box)
 
 void Octant::ResetOctree()
 {
-    octree_ = nullptr;
-
-    // The whole octree is being destroyed, just detach the drawables
+    // The whole octree is being destroyed, just detach the drawables so they are not moved to root
     for (Drawable* drawable : drawables_)
     {
         drawable->SetOctant(nullptr);
         drawable->SetDrawableIndex(M_MAX_UNSIGNED);
     }
+    drawables_.clear();
+    numDrawables_ = 0;
 
     for (auto& child : children_)
     {
@@ -562,32 +574,66 @@ void Octree::Update(const FrameInfo& frame)
     {
         URHO3D_PROFILE("ReinsertToOctree");
 
-        for (auto i = drawableUpdates_.begin(); i != drawableUpdates_.end(); ++i)
+        // Find new octants in worker threads. Octree is not modified at this point
+        const unsigned numUpdates = drawableUpdates_.size();
+        reinsertionOctants_.resize(numUpdates);
+        ForEachParallel(GetSubsystem<WorkQueue>(), REINSERTION_BUCKET_SIZE, numUpdates,
+            [this](unsigned beginIndex, unsigned endIndex)
         {
-            Drawable* drawable = *i;
+            for (unsigned i = beginIndex; i < endIndex; ++i)
+            {
+                Drawable* drawable = drawableUpdates_[i];
+                Octant* octant = drawable->GetOctant();
+                reinsertionOctants_[i] = octant;
+
+                // Skip if no octant or does not belong to this octree anymore
+                if (!octant || octant->GetOctree() != this)
+                    continue;
+
+                // Skip if still fits the current octant
+                const BoundingBox& box = drawable->GetWorldBoundingBox();
+                const bool isOccludee = drawable->IsOccludee();
+                if (isOccludee && octant->GetCullingBox().IsInside(box) == INSIDE && octant->CheckDrawableFit(box))
+                    continue;
+
+                reinsertionOctants_[i] = rootOctant_.GetInsertionOctant(box, isOccludee, false);
+            }
+        });
+
+        // Add drawables to new octants first, so no octant is deleted while reinsertion is in progress
+        reinsertions_.clear();
+        for (unsigned i = 0; i < numUpdates; ++i)
+        {
+            Drawable* drawable = drawableUpdates_[i];
             drawable->updateQueued_ = false;
-            Octant* octant = drawable->GetOctant();
-            const BoundingBox& box = drawable->GetWorldBoundingBox();
+            Octant* oldOctant = drawable->GetOctant();
 
-            // Skip if no octant or does not belong to this octree anymore
-            if (!octant || octant->GetOctree() != this)
+            if (!oldOctant || oldOctant->GetOctree() != this)
                 continue;
-            // Skip if still fits the current octant
-            if (drawable->IsOccludee() && octant->GetCullingBox().IsInside(box) == INSIDE && octant->CheckDrawableFit(box))
+
+            Octant* newOctant = reinsertionOctants_[i];
+            if (!newOctant)
+                newOctant = rootOctant_.GetInsertionOctant(drawable->GetWorldBoundingBox(), drawable->IsOccludee(), true);
+            if (newOctant == oldOctant)
                 continue;
 
-            rootOctant_.InsertDrawable(drawable);
+            newOctant->AddDrawable(drawable);
+            reinsertions_.emplace_back(drawable, oldOctant);
 
 #ifdef _DEBUG
             // Verify that the drawable will be culled correctly
-            octant = drawable->GetOctant();
-            if (octant != GetRootOctant() && octant->GetCullingBox().IsInside(box) != INSIDE)
+            const BoundingBox& box = drawable->GetWorldBoundingBox();
+            if (newOctant != GetRootOctant() && newOctant->GetCullingBox().IsInside(box) != INSIDE)
             {
                 URHO3D_LOGERROR("Drawable is not fully inside its octant's culling bounds: drawable box " + box.ToString() +
-                         " octant box " + octant->GetCullingBox().ToString());
+                         " octant box " + newOctant->GetCullingBox().ToString());
             }
 #endif
         }
+
+        // Remove drawables from old octants. Empty octants are returned to the pool
+        for (const auto& reinsertion : reinsertions_)
+            reinsertion.second->RemoveDrawable(reinsertion.first, false);
     }
 
     drawableUpdates_.clear();
@@ -22,6 +22,7 @@
 
 #pragma once
 
+#include "../Container/Allocator.h"
 #include "../Core/Mutex.h"
 #include "../Graphics/Drawable.h"
 #include "../Graphics/OctreeQuery.h"
@@ -51,6 +52,9 @@ public:
     void DeleteChild(unsigned index);
     /// Insert a drawable object by checking for fit recursively.
     void InsertDrawable(Drawable* drawable);
+    /// Return octant where the drawable object with given bounding box should be inserted.
+    /// If child octant has to be created and createChildren is false, return null.
+    Octant* GetInsertionOctant(const BoundingBox& box, bool isOccludee, bool createChildren);
     /// Check if a drawable object fits.
     bool CheckDrawableFit(const BoundingBox& box) const;
 
@@ -99,7 +103,7 @@ public:
 
     /// Set size for the root octant. If octree is not empty, drawable objects will be temporarily moved to the root.
     void SetRootSize(const BoundingBox& box);
-    /// Reset octree pointer recursively. Called when the whole octree is being destroyed.
+    /// Detach drawables recursively. Called when the whole octree is being destroyed.
     void ResetOctree();
     /// Draw bounds to the debug graphics recursively.
     /// @nobind
@@ -211,6 +215,7 @@ private:
 class URHO3D_API Octree : public Component
 {
     URHO3D_OBJECT(Octree, Component);
+    friend class Octant;
 
 public:
     /// Construct.
@@ -280,10 +285,16 @@ private:
     /// Update octree size.
     void UpdateOctreeSize() { SetSize(worldBoundingBox_, numLevels_); }
 
+    /// Allocator of child octants. Should be destroyed after root octant.
+    Allocator<Octant> octantAllocator_;
     /// Root octant.
     Octant rootOctant_;
     /// Drawable objects that require update.
     ea::vector<Drawable*> drawableUpdates_;
+    /// New octants of drawables that require update. Null if octant should be created.
+    ea::vector<Octant*> reinsertionOctants_;
+    /// Reinserted drawables and their old octants.
+    ea::vector<ea::pair<Drawable*, Octant*>> reinsertions_;
     /// Drawable objects that were inserted during threaded update phase.
     ea::vector<Drawable*> threadedDrawableUpdates_;
     /// All Drawable objects.
@@ -22,6 +22,7 @@
 
 #include "../Precompiled.h"
 
+#include "../Core/IteratorRange.h"
 #include "../Graphics/OctreeQuery.h"
 
 #include "../DebugNew.h"
@@ -105,16 +106,34 @@ Intersection FrustumOctreeQuery::TestOctant(const BoundingBox& box, bool inside)
 
 void FrustumOctreeQuery::TestDrawables(Drawable** start, Drawable** end, bool inside)
 {
-    while (start != end)
+    for (Drawable* drawable : MakeIteratorRange(start, end))
     {
-        Drawable* drawable = *start++;
-
         if ((drawable->GetDrawableFlags() & drawableFlags_) && (drawable->GetViewMask() & viewMask_))
+            candidates_.push_back(drawable);
+    }
+    ProcessCandidates(inside);
+}
+
+void FrustumOctreeQuery::ProcessCandidates(bool inside)
+{
+    if (inside)
+        result_.append(candidates_);
+    else
+    {
+        candidateBoxes_.Clear();
+        for (Drawable* drawable : candidates_)
+            candidateBoxes_.Push(drawable->GetWorldBoundingBox());
+
+        frustum_.IsInsideFast(candidateBoxes_, candidatesInside_);
+
+        const unsigned numCandidates = candidates_.size();
+        for (unsigned i = 0; i < numCandidates; ++i)
         {
-            if (inside || frustum_.IsInsideFast(drawable->GetWorldBoundingBox()))
-                result_.push_back(drawable);
+            if (candidatesInside_[i])
+                result_.push_back(candidates_[i]);
         }
     }
+    candidates_.clear();
 }
 
 
@@ -151,6 +151,17 @@ public:
 
     /// Frustum.
     Frustum frustum_;
+
+protected:
+    /// Test candidates against frustum in batch, add ones (partially) inside to result and clear candidates.
+    void ProcessCandidates(bool inside);
+
+    /// Drawables that passed all checks except frustum test.
+    ea::vector<Drawable*> candidates_;
+    /// Bounding boxes of candidates.
+    BoundingBoxSoA candidateBoxes_;
+    /// Whether candidates are (partially) inside frustum.
+    ea::vector<bool> candidatesInside_;
 };
 
 /// General octree query result. Used for Lua bindings only.
@@ -631,6 +631,14 @@ bool Graphics::TakeScreenShot(Image& destImage)
 
 bool Graphics::BeginFrame()
 {
+    // Null device doesn't render anything, only frame statistics are reset
+    if (nullDevice_)
+    {
+        numPrimitives_ = 0;
+        numBatches_ = 0;
+        return false;
+    }
+
     if (!IsInitialized() || IsDeviceLost())
         return false;
 
@@ -888,6 +896,12 @@ bool Graphics::ResolveToTexture(TextureCube* texture)
 
 void Graphics::Draw(PrimitiveType type, unsigned vertexStart, unsigned vertexCount)
 {
+    if (nullDevice_)
+    {
+        AddNullDraw(type, vertexCount);
+        return;
+    }
+
     if (!vertexCount)
         return;
 
@@ -905,6 +919,12 @@ void Graphics::Draw(PrimitiveType type, unsigned vertexStart, unsigned vertexCou
 
 void Graphics::Draw(PrimitiveType type, unsigned indexStart, unsigned indexCount, unsigned minVertex, unsigned vertexCount)
 {
+    if (nullDevice_)
+    {
+        AddNullDraw(type, indexCount);
+        return;
+    }
+
     if (!indexCount || !indexBuffer_ || !indexBuffer_->GetGPUObjectName())
         return;
 
@@ -924,6 +944,12 @@ void Graphics::Draw(PrimitiveType type, unsigned indexStart, unsigned indexCount
 
 void Graphics::Draw(PrimitiveType type, unsigned indexStart, unsigned indexCount, unsigned baseVertexIndex, unsigned minVertex, unsigned vertexCount)
 {
+    if (nullDevice_)
+    {
+        AddNullDraw(type, indexCount);
+        return;
+    }
+
 #ifndef GL_ES_VERSION_2_0
     if (!gl3Support || !indexCount || !indexBuffer_ || !indexBuffer_->GetGPUObjectName())
         return;
@@ -946,6 +972,12 @@ void Graphics::Draw(PrimitiveType type, unsigned indexStart, unsigned indexCount
 void Graphics::DrawInstanced(PrimitiveType type, unsigned indexStart, unsigned indexCount, unsigned minVertex, unsigned vertexCount,
     unsigned instanceCount)
 {
+    if (nullDevice_)
+    {
+        AddNullDraw(type, indexCount, instanceCount);
+        return;
+    }
+
 #if !defined(GL_ES_VERSION_2_0) || defined(__EMSCRIPTEN__)
     if (!indexCount || !indexBuffer_ || !indexBuffer_->GetGPUObjectName() || !instancingSupport_)
         return;
@@ -982,6 +1014,12 @@ void Graphics::DrawInstanced(PrimitiveType type, unsigned indexStart, unsigned i
 void Graphics::DrawInstanced(PrimitiveType type, unsigned indexStart, unsigned indexCount, unsigned baseVertexIndex, unsigned minVertex,
         unsigned vertexCount, unsigned instanceCount)
 {
+    if (nullDevice_)
+    {
+        AddNullDraw(type, indexCount, instanceCount);
+        return;
+    }
+
 #ifndef GL_ES_VERSION_2_0
     if (!gl3Support || !indexCount || !indexBuffer_ || !indexBuffer_->GetGPUObjectName() || !instancingSupport_)
         return;
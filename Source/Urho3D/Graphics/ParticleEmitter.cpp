@@ -25,6 +25,7 @@
 #include "../Core/Context.h"
 #include "../Core/Profiler.h"
 #include "../Graphics/DrawableEvents.h"
+#include "../Graphics/OctreeQuery.h"
 #include "../Graphics/ParticleEffect.h"
 #include "../Graphics/ParticleEmitter.h"
 #include "../Resource/ResourceCache.h"
@@ -32,6 +33,10 @@
 #include "../Scene/Scene.h"
 #include "../Scene/SceneEvents.h"
 
+#ifdef URHO3D_SSE
+#include <emmintrin.h>
+#endif
+
 #include "../DebugNew.h"
 
 namespace Urho3D
@@ -43,6 +48,201 @@ static const unsigned MAX_PARTICLES_IN_FRAME = 100;
 
 extern const char* autoRemoveModeNames[];
 
+static const float INV_SQRT_TWO = 1.0f / sqrtf(2.0f);
+
+namespace
+{
+
+/// Parameters of particle simulation step.
+struct ParticleSimulationParams
+{
+    /// Time step.
+    float timeStep_{};
+    /// Constant force.
+    Vector3 force_;
+    /// Damping force.
+    float damping_{};
+    /// Scale of position change.
+    Vector3 moveScale_;
+    /// Size addition per second.
+    float sizeAdd_{};
+    /// Size multiplication per second.
+    float sizeMul_{ 1.0f };
+};
+
+/// Simulate one step of particle movement, rotation and scaling.
+void SimulateParticle(ParticleBuffer& particles, unsigned i, const ParticleSimulationParams& params)
+{
+    const float timeStep = params.timeStep_;
+    particles.timers_[i] += timeStep;
+
+    Vector3 velocity = particles.GetVelocity(i);
+    velocity += timeStep * params.force_;
+    velocity += (-params.damping_ * timeStep) * velocity;
+    particles.SetVelocity(i, velocity);
+    particles.SetPosition(i, particles.GetPosition(i) + timeStep * velocity * params.moveScale_);
+    particles.SetDirection(i, velocity.Normalized());
+
+    particles.rotations_[i] += timeStep * particles.rotationSpeeds_[i];
+
+    const float scale = Max(particles.scales_[i] + timeStep * params.sizeAdd_, 0.0f);
+    particles.scales_[i] = scale * (timeStep * (params.sizeMul_ - 1.0f) + 1.0f);
+}
+
+/// Simulate one step for all active particles.
+void SimulateParticles(ParticleBuffer& particles, const ParticleSimulationParams& params)
+{
+    const unsigned numParticles = particles.numActive_;
+    unsigned i = 0;
+
+#ifdef URHO3D_SSE
+    const float timeStep = params.timeStep_;
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 timeStepVec = _mm_set1_ps(timeStep);
+    const __m128 velocityDeltaX = _mm_set1_ps(timeStep * params.force_.x_);
+    const __m128 velocityDeltaY = _mm_set1_ps(timeStep * params.force_.y_);
+    const __m128 velocityDeltaZ = _mm_set1_ps(timeStep * params.force_.z_);
+    const __m128 damping = _mm_set1_ps(-params.damping_ * timeStep);
+    const __m128 moveX = _mm_set1_ps(timeStep * params.moveScale_.x_);
+    const __m128 moveY = _mm_set1_ps(timeStep * params.moveScale_.y_);
+    const __m128 moveZ = _mm_set1_ps(timeStep * params.moveScale_.z_);
+    const __m128 sizeAdd = _mm_set1_ps(timeStep * params.sizeAdd_);
+    const __m128 sizeMul = _mm_set1_ps(timeStep * (params.sizeMul_ - 1.0f) + 1.0f);
+
+    for (; i + 4 <= numParticles; i += 4)
+    {
+        __m128 vx = _mm_add_ps(_mm_loadu_ps(&particles.velocityX_[i]), velocityDeltaX);
+        __m128 vy = _mm_add_ps(_mm_loadu_ps(&particles.velocityY_[i]), velocityDeltaY);
+        __m128 vz = _mm_add_ps(_mm_loadu_ps(&particles.velocityZ_[i]), velocityDeltaZ);
+        vx = _mm_add_ps(vx, _mm_mul_ps(damping, vx));
+        vy = _mm_add_ps(vy, _mm_mul_ps(damping, vy));
+        vz = _mm_add_ps(vz, _mm_mul_ps(damping, vz));
+        _mm_storeu_ps(&particles.velocityX_[i], vx);
+        _mm_storeu_ps(&particles.velocityY_[i], vy);
+        _mm_storeu_ps(&particles.velocityZ_[i], vz);
+
+        _mm_storeu_ps(&particles.positionX_[i], _mm_add_ps(_mm_loadu_ps(&particles.positionX_[i]), _mm_mul_ps(vx, moveX)));
+        _mm_storeu_ps(&particles.positionY_[i], _mm_add_ps(_mm_loadu_ps(&particles.positionY_[i]), _mm_mul_ps(vy, moveY)));
+        _mm_storeu_ps(&particles.positionZ_[i], _mm_add_ps(_mm_loadu_ps(&particles.positionZ_[i]), _mm_mul_ps(vz, moveZ)));
+
+        // Zero velocity results in zero direction
+        const __m128 lengthSquared = _mm_add_ps(_mm_add_ps(_mm_mul_ps(vx, vx), _mm_mul_ps(vy, vy)), _mm_mul_ps(vz, vz));
+        const __m128 nonZero = _mm_cmpgt_ps(lengthSquared, zero);
+        const __m128 invLength = _mm_and_ps(nonZero, _mm_div_ps(one, _mm_sqrt_ps(lengthSquared)));
+        _mm_storeu_ps(&particles.directionX_[i], _mm_mul_ps(vx, invLength));
+        _mm_storeu_ps(&particles.directionY_[i], _mm_mul_ps(vy, invLength));
+        _mm_storeu_ps(&particles.directionZ_[i], _mm_mul_ps(vz, invLength));
+
+        const __m128 rotationSpeed = _mm_loadu_ps(&particles.rotationSpeeds_[i]);
+        _mm_storeu_ps(&particles.rotations_[i], _mm_add_ps(_mm_loadu_ps(&particles.rotations_[i]), _mm_mul_ps(timeStepVec, rotationSpeed)));
+        _mm_storeu_ps(&particles.timers_[i], _mm_add_ps(_mm_loadu_ps(&particles.timers_[i]), timeStepVec));
+
+        const __m128 scale = _mm_max_ps(_mm_add_ps(_mm_loadu_ps(&particles.scales_[i]), sizeAdd), zero);
+        _mm_storeu_ps(&particles.scales_[i], _mm_mul_ps(scale, sizeMul));
+    }
+#endif
+
+    for (; i < numParticles; ++i)
+        SimulateParticle(particles, i, params);
+}
+
+}
+
+void ParticleBuffer::SetCapacity(unsigned capacity)
+{
+    positionX_.resize(capacity);
+    positionY_.resize(capacity);
+    positionZ_.resize(capacity);
+    velocityX_.resize(capacity);
+    velocityY_.resize(capacity);
+    velocityZ_.resize(capacity);
+    directionX_.resize(capacity);
+    directionY_.resize(capacity);
+    directionZ_.resize(capacity);
+    sizeX_.resize(capacity);
+    sizeY_.resize(capacity);
+    scales_.resize(capacity);
+    timers_.resize(capacity);
+    timeToLive_.resize(capacity);
+    rotations_.resize(capacity);
+    rotationSpeeds_.resize(capacity);
+    colorIndices_.resize(capacity);
+    texIndices_.resize(capacity);
+    colors_.resize(capacity);
+    uvs_.resize(capacity);
+    numActive_ = ea::min(numActive_, capacity);
+}
+
+void ParticleBuffer::CopyParticle(unsigned destIndex, unsigned sourceIndex)
+{
+    positionX_[destIndex] = positionX_[sourceIndex];
+    positionY_[destIndex] = positionY_[sourceIndex];
+    positionZ_[destIndex] = positionZ_[sourceIndex];
+    velocityX_[destIndex] = velocityX_[sourceIndex];
+    velocityY_[destIndex] = velocityY_[sourceIndex];
+    velocityZ_[destIndex] = velocityZ_[sourceIndex];
+    directionX_[destIndex] = directionX_[sourceIndex];
+    directionY_[destIndex] = directionY_[sourceIndex];
+    directionZ_[destIndex] = directionZ_[sourceIndex];
+    sizeX_[destIndex] = sizeX_[sourceIndex];
+    sizeY_[destIndex] = sizeY_[sourceIndex];
+    scales_[destIndex] = scales_[sourceIndex];
+    timers_[destIndex] = timers_[sourceIndex];
+    timeToLive_[destIndex] = timeToLive_[sourceIndex];
+    rotations_[destIndex] = rotations_[sourceIndex];
+    rotationSpeeds_[destIndex] = rotationSpeeds_[sourceIndex];
+    colorIndices_[destIndex] = colorIndices_[sourceIndex];
+    texIndices_[destIndex] = texIndices_[sourceIndex];
+    colors_[destIndex] = colors_[sourceIndex];
+    uvs_[destIndex] = uvs_[sourceIndex];
+}
+
+void ParticleBuffer::SwapParticles(unsigned firstIndex, unsigned secondIndex)
+{
+    ea::swap(positionX_[firstIndex], positionX_[secondIndex]);
+    ea::swap(positionY_[firstIndex], positionY_[secondIndex]);
+    ea::swap(positionZ_[firstIndex], positionZ_[secondIndex]);
+    ea::swap(velocityX_[firstIndex], velocityX_[secondIndex]);
+    ea::swap(velocityY_[firstIndex], velocityY_[secondIndex]);
+    ea::swap(velocityZ_[firstIndex], velocityZ_[secondIndex]);
+    ea::swap(directionX_[firstIndex], directionX_[secondIndex]);
+    ea::swap(directionY_[firstIndex], directionY_[secondIndex]);
+    ea::swap(directionZ_[firstIndex], directionZ_[secondIndex]);
+    ea::swap(sizeX_[firstIndex], sizeX_[secondIndex]);
+    ea::swap(sizeY_[firstIndex], sizeY_[secondIndex]);
+    ea::swap(scales_[firstIndex], scales_[secondIndex]);
+    ea::swap(timers_[firstIndex], timers_[secondIndex]);
+    ea::swap(timeToLive_[firstIndex], timeToLive_[secondIndex]);
+    ea::swap(rotations_[firstIndex], rotations_[secondIndex]);
+    ea::swap(rotationSpeeds_[firstIndex], rotationSpeeds_[secondIndex]);
+    ea::swap(colorIndices_[firstIndex], colorIndices_[secondIndex]);
+    ea::swap(texIndices_[firstIndex], texIndices_[secondIndex]);
+    ea::swap(colors_[firstIndex], colors_[secondIndex]);
+    ea::swap(uvs_[firstIndex], uvs_[secondIndex]);
+}
+
+void ParticleBuffer::SetPosition(unsigned index, const Vector3& position)
+{
+    positionX_[index] = position.x_;
+    positionY_[index] = position.y_;
+    positionZ_[index] = position.z_;
+}
+
+void ParticleBuffer::SetVelocity(unsigned index, const Vector3& velocity)
+{
+    velocityX_[index] = velocity.x_;
+    velocityY_[index] = velocity.y_;
+    velocityZ_[index] = velocity.z_;
+}
+
+void ParticleBuffer::SetDirection(unsigned index, const Vector3& direction)
+{
+    directionX_[index] = direction.x_;
+    directionY_[index] = direction.y_;
+    directionZ_[index] = direction.z_;
+}
+
 ParticleEmitter::ParticleEmitter(Context* context) :
     BillboardSet(context),
     periodTimer_(0.0f),
@@ -79,7 +279,7 @@ void ParticleEmitter::RegisterObject(Context* context)
     URHO3D_COPY_BASE_ATTRIBUTES(Drawable);
     URHO3D_MIXED_ACCESSOR_ATTRIBUTE("Particles", GetParticlesAttr, SetParticlesAttr, VariantVector, Variant::emptyVariantVector,
         AM_FILE | AM_NOEDIT);
-    URHO3D_MIXED_ACCESSOR_ATTRIBUTE("Billboards", GetParticleBillboardsAttr, SetBillboardsAttr, VariantVector, Variant::emptyVariantVector,
+    URHO3D_MIXED_ACCESSOR_ATTRIBUTE("Billboards", GetParticleBillboardsAttr, SetParticleBillboardsAttr, VariantVector, Variant::emptyVariantVector,
         AM_FILE | AM_NOEDIT);
     URHO3D_ATTRIBUTE("Serialize Particles", bool, serializeParticles_, true, AM_FILE);
 }
@@ -108,8 +308,8 @@ void ParticleEmitter::Update(const FrameInfo& frame)
         return;
 
     // If there is an amount mismatch between particles and billboards, correct it
-    if (particles_.size() != billboards_.size())
-        SetNumBillboards(particles_.size());
+    if (particles_.GetCapacity() != billboards_.size())
+        SetNumBillboards(particles_.GetCapacity());
 
     bool needCommit = false;
 
@@ -166,98 +366,66 @@ void ParticleEmitter::Update(const FrameInfo& frame)
     }
 
     // Update existing particles
-    Vector3 relativeConstantForce = node_->GetWorldRotation().Inverse() * effect_->GetConstantForce();
-    // If billboards are not relative, apply scaling to the position update
-    Vector3 scaleVector = Vector3::ONE;
-    if (scaled_ && !relative_)
-        scaleVector = node_->GetWorldScale();
-
-    for (unsigned i = 0; i < particles_.size(); ++i)
+    if (particles_.numActive_)
     {
-        Particle& particle = particles_[i];
-        Billboard& billboard = billboards_[i];
+        needCommit = true;
+        UpdateParticles();
+        UpdateParticleFrames();
+    }
 
-        if (billboard.enabled_)
+    if (needCommit)
+    {
+        // Billboards are needed only if vertices cannot be written directly
+        if (sorted_ || fixedScreenSize_)
         {
-            needCommit = true;
-
-            // Time to live
-            if (particle.timer_ >= particle.timeToLive_)
-            {
-                billboard.enabled_ = false;
-                continue;
-            }
-            particle.timer_ += lastTimeStep_;
+            vertexDataDirty_ = true;
+            UpdateBillboards();
+        }
+        else
+            PrepareVertexData();
+        Commit();
+    }
 
-            // Velocity & position
-            const Vector3& constantForce = effect_->GetConstantForce();
-            if (constantForce != Vector3::ZERO)
-            {
-                if (relative_)
-                    particle.velocity_ += lastTimeStep_ * relativeConstantForce;
-                else
-                    particle.velocity_ += lastTimeStep_ * constantForce;
-            }
+    needUpdate_ = false;
+}
 
-            float dampingForce = effect_->GetDampingForce();
-            if (dampingForce != 0.0f)
-            {
-                Vector3 force = -dampingForce * particle.velocity_;
-                particle.velocity_ += lastTimeStep_ * force;
-            }
-            billboard.position_ += lastTimeStep_ * particle.velocity_ * scaleVector;
-            billboard.direction_ = particle.velocity_.Normalized();
+void ParticleEmitter::ProcessRayQuery(const RayOctreeQuery& query, ea::vector<RayQueryResult>& results)
+{
+    // Billboards are up to date in fixed screen size mode
+    if (query.level_ < RAY_TRIANGLE || fixedScreenSize_)
+    {
+        BillboardSet::ProcessRayQuery(query, results);
+        return;
+    }
 
-            // Rotation
-            billboard.rotation_ += lastTimeStep_ * particle.rotationSpeed_;
+    // Check ray hit distance to AABB before proceeding with particle-level tests
+    if (query.ray_.HitDistance(GetWorldBoundingBox()) >= query.maxDistance_)
+        return;
 
-            // Scaling
-            float sizeAdd = effect_->GetSizeAdd();
-            float sizeMul = effect_->GetSizeMul();
-            if (sizeAdd != 0.0f || sizeMul != 1.0f)
-            {
-                particle.scale_ += lastTimeStep_ * sizeAdd;
-                if (particle.scale_ < 0.0f)
-                    particle.scale_ = 0.0f;
-                if (sizeMul != 1.0f)
-                    particle.scale_ *= (lastTimeStep_ * (sizeMul - 1.0f)) + 1.0f;
-                billboard.size_ = particle.size_ * particle.scale_;
-            }
+    const Matrix3x4& worldTransform = node_->GetWorldTransform();
+    const Matrix3x4 billboardTransform = relative_ ? worldTransform : Matrix3x4::IDENTITY;
+    const Vector3 billboardScale = scaled_ ? worldTransform.Scale() : Vector3::ONE;
 
-            // Color interpolation
-            unsigned& index = particle.colorIndex_;
-            const ea::vector<ColorFrame>& colorFrames_ = effect_->GetColorFrames();
-            if (index < colorFrames_.size())
-            {
-                if (index < colorFrames_.size() - 1)
-                {
-                    if (particle.timer_ >= colorFrames_[index + 1].time_)
-                        ++index;
-                }
-                if (index < colorFrames_.size() - 1)
-                    billboard.color_ = colorFrames_[index].Interpolate(colorFrames_[index + 1], particle.timer_);
-                else
-                    billboard.color_ = colorFrames_[index].color_;
-            }
+    for (unsigned i = 0; i < particles_.numActive_; ++i)
+    {
+        // Approximate the particles as spheres for raycasting
+        const Vector2 size = particles_.GetSize(i);
+        const float radius = INV_SQRT_TWO * (size.x_ * billboardScale.x_ + size.y_ * billboardScale.y_);
+        const Sphere particleSphere(billboardTransform * particles_.GetPosition(i), radius);
 
-            // Texture animation
-            unsigned& texIndex = particle.texIndex_;
-            const ea::vector<TextureFrame>& textureFrames_ = effect_->GetTextureFrames();
-            if (textureFrames_.size() && texIndex < textureFrames_.size() - 1)
-            {
-                if (particle.timer_ >= textureFrames_[texIndex + 1].time_)
-                {
-                    billboard.uv_ = textureFrames_[texIndex + 1].uv_;
-                    ++texIndex;
-                }
-            }
+        const float distance = query.ray_.HitDistance(particleSphere);
+        if (distance < query.maxDistance_)
+        {
+            RayQueryResult result;
+            result.position_ = query.ray_.origin_ + distance * query.ray_.direction_;
+            result.normal_ = -query.ray_.direction_;
+            result.distance_ = distance;
+            result.drawable_ = this;
+            result.node_ = node_;
+            result.subObject_ = i;
+            results.push_back(result);
         }
     }
-
-    if (needCommit)
-        Commit();
-
-    needUpdate_ = false;
 }
 
 void ParticleEmitter::SetEffect(ParticleEffect* effect)
@@ -286,8 +454,9 @@ void ParticleEmitter::SetNumParticles(unsigned num)
     if (num > M_MAX_INT)
         num = 0;
 
-    particles_.resize(num);
+    particles_.SetCapacity(num);
     SetNumBillboards(num);
+    MarkParticlesDirty();
 }
 
 void ParticleEmitter::SetEmitting(bool enable)
@@ -322,10 +491,8 @@ void ParticleEmitter::ResetEmissionTimer()
 
 void ParticleEmitter::RemoveAllParticles()
 {
-    for (auto i = billboards_.begin(); i != billboards_.end(); ++i)
-        i->enabled_ = false;
-
-    Commit();
+    particles_.numActive_ = 0;
+    MarkParticlesDirty();
 }
 
 void ParticleEmitter::Reset()
@@ -350,6 +517,25 @@ void ParticleEmitter::ApplyEffect()
     SetFaceCameraMode(effect_->GetFaceCameraMode());
 }
 
+void ParticleEmitter::UpdateBillboards()
+{
+    const unsigned numBillboards = ea::min(particles_.GetCapacity(), billboards_.size());
+    for (unsigned i = 0; i < numBillboards; ++i)
+    {
+        Billboard& billboard = billboards_[i];
+        billboard.enabled_ = i < particles_.numActive_;
+        if (!billboard.enabled_)
+            continue;
+
+        billboard.position_ = particles_.GetPosition(i);
+        billboard.size_ = particles_.GetSize(i);
+        billboard.uv_ = particles_.uvs_[i];
+        billboard.color_ = particles_.colors_[i];
+        billboard.rotation_ = particles_.rotations_[i];
+        billboard.direction_ = particles_.GetDirection(i);
+    }
+}
+
 ParticleEffect* ParticleEmitter::GetEffect() const
 {
     return effect_;
@@ -371,65 +557,105 @@ void ParticleEmitter::SetParticlesAttr(const VariantVector& value)
     unsigned index = 0;
     SetNumParticles(index < value.size() ? value[index++].GetUInt() : 0);
 
-    for (auto i = particles_.begin(); i != particles_.end() && index < value.size(); ++i)
+    // Particles are activated when billboards are loaded
+    particles_.numActive_ = 0;
+    for (unsigned i = 0; i < particles_.GetCapacity() && index < value.size(); ++i)
     {
-        i->velocity_ = value[index++].GetVector3();
-        i->size_ = value[index++].GetVector2();
-        i->timer_ = value[index++].GetFloat();
-        i->timeToLive_ = value[index++].GetFloat();
-        i->scale_ = value[index++].GetFloat();
-        i->rotationSpeed_ = value[index++].GetFloat();
-        i->colorIndex_ = (unsigned)value[index++].GetInt();
-        i->texIndex_ = (unsigned)value[index++].GetInt();
+        particles_.SetVelocity(i, value[index++].GetVector3());
+        const Vector2 size = value[index++].GetVector2();
+        particles_.sizeX_[i] = size.x_;
+        particles_.sizeY_[i] = size.y_;
+        particles_.timers_[i] = value[index++].GetFloat();
+        particles_.timeToLive_[i] = value[index++].GetFloat();
+        particles_.scales_[i] = value[index++].GetFloat();
+        particles_.rotationSpeeds_[i] = value[index++].GetFloat();
+        particles_.colorIndices_[i] = (unsigned)value[index++].GetInt();
+        particles_.texIndices_[i] = (unsigned)value[index++].GetInt();
     }
 }
 
 VariantVector ParticleEmitter::GetParticlesAttr() const
 {
     VariantVector ret;
+    const unsigned numParticles = particles_.GetCapacity();
     if (!serializeParticles_)
     {
-        ret.push_back((int)particles_.size());
+        ret.push_back((int)numParticles);
         return ret;
     }
 
-    ret.reserve(particles_.size() * 8 + 1);
-    ret.push_back((int)particles_.size());
-    for (auto i = particles_.begin(); i != particles_.end(); ++i)
+    ret.reserve(numParticles * 8 + 1);
+    ret.push_back((int)numParticles);
+    for (unsigned i = 0; i < numParticles; ++i)
     {
-        ret.push_back(i->velocity_);
-        ret.push_back(i->size_);
-        ret.push_back(i->timer_);
-        ret.push_back(i->timeToLive_);
-        ret.push_back(i->scale_);
-        ret.push_back(i->rotationSpeed_);
-        ret.push_back(i->colorIndex_);
-        ret.push_back(i->texIndex_);
+        ret.push_back(particles_.GetVelocity(i));
+        ret.push_back(Vector2(particles_.sizeX_[i], particles_.sizeY_[i]));
+        ret.push_back(particles_.timers_[i]);
+        ret.push_back(particles_.timeToLive_[i]);
+        ret.push_back(particles_.scales_[i]);
+        ret.push_back(particles_.rotationSpeeds_[i]);
+        ret.push_back(particles_.colorIndices_[i]);
+        ret.push_back(particles_.texIndices_[i]);
     }
     return ret;
 }
 
+void ParticleEmitter::SetParticleBillboardsAttr(const VariantVector& value)
+{
+    // Billboards are not necessarily up to date, reset them before loading
+    for (Billboard& billboard : billboards_)
+        billboard.enabled_ = false;
+    SetBillboardsAttr(value);
+
+    const unsigned numParticles = ea::min(particles_.GetCapacity(), billboards_.size());
+    for (unsigned i = 0; i < numParticles; ++i)
+    {
+        const Billboard& billboard = billboards_[i];
+        particles_.SetPosition(i, billboard.position_);
+        particles_.uvs_[i] = billboard.uv_;
+        particles_.colors_[i] = billboard.color_;
+        particles_.rotations_[i] = billboard.rotation_;
+        particles_.SetDirection(i, billboard.direction_);
+    }
+
+    // Move enabled particles to the beginning preserving order
+    particles_.numActive_ = 0;
+    for (unsigned i = 0; i < numParticles; ++i)
+    {
+        if (billboards_[i].enabled_)
+        {
+            if (i != particles_.numActive_)
+                particles_.SwapParticles(i, particles_.numActive_);
+            ++particles_.numActive_;
+        }
+    }
+
+    MarkParticlesDirty();
+}
+
 VariantVector ParticleEmitter::GetParticleBillboardsAttr() const
 {
     VariantVector ret;
+    const unsigned numParticles = particles_.GetCapacity();
     if (!serializeParticles_)
     {
-        ret.push_back((int)billboards_.size());
+        ret.push_back((int)numParticles);
         return ret;
     }
 
-    ret.reserve(billboards_.size() * 7 + 1);
-    ret.push_back((int)billboards_.size());
+    ret.reserve(numParticles * 7 + 1);
+    ret.push_back((int)numParticles);
 
-    for (auto i = billboards_.begin(); i != billboards_.end(); ++i)
+    for (unsigned i = 0; i < numParticles; ++i)
     {
-        ret.push_back(i->position_);
-        ret.push_back(i->size_);
-        ret.push_back(Vector4(i->uv_.min_.x_, i->uv_.min_.y_, i->uv_.max_.x_, i->uv_.max_.y_));
-        ret.push_back(i->color_);
-        ret.push_back(i->rotation_);
-        ret.push_back(i->direction_);
-        ret.push_back(i->enabled_);
+        const Rect& uv = particles_.uvs_[i];
+        ret.push_back(particles_.GetPosition(i));
+        ret.push_back(particles_.GetSize(i));
+        ret.push_back(Vector4(uv.min_.x_, uv.min_.y_, uv.max_.x_, uv.max_.y_));
+        ret.push_back(particles_.colors_[i]);
+        ret.push_back(particles_.rotations_[i]);
+        ret.push_back(particles_.GetDirection(i));
+        ret.push_back(i < particles_.numActive_);
     }
 
     return ret;
@@ -445,14 +671,215 @@ void ParticleEmitter::OnSceneSet(Scene* scene)
          UnsubscribeFromEvent(E_SCENEPOSTUPDATE);
 }
 
+void ParticleEmitter::OnWorldBoundingBoxUpdate()
+{
+    // Billboards are up to date in fixed screen size mode
+    if (fixedScreenSize_)
+    {
+        BillboardSet::OnWorldBoundingBoxUpdate();
+        return;
+    }
+
+    const Matrix3x4& worldTransform = node_->GetWorldTransform();
+    const Vector3 billboardScale = scaled_ ? worldTransform.Scale() : Vector3::ONE;
+    const float edgeScaleX = INV_SQRT_TWO * billboardScale.x_;
+    const float edgeScaleY = INV_SQRT_TWO * billboardScale.y_;
+
+    // Calculate bounding box of particle centers and max particle size
+    const unsigned numParticles = particles_.numActive_;
+    Vector3 minPosition = Vector3::ONE * M_INFINITY;
+    Vector3 maxPosition = -Vector3::ONE * M_INFINITY;
+    float maxEdge = 0.0f;
+    unsigned i = 0;
+
+#ifdef URHO3D_SSE
+    if (numParticles >= 4)
+    {
+        const __m128 edgeX = _mm_set1_ps(edgeScaleX);
+        const __m128 edgeY = _mm_set1_ps(edgeScaleY);
+        __m128 minX = _mm_set1_ps(M_INFINITY);
+        __m128 minY = minX;
+        __m128 minZ = minX;
+        __m128 maxX = _mm_set1_ps(-M_INFINITY);
+        __m128 maxY = maxX;
+        __m128 maxZ = maxX;
+        __m128 edge = _mm_setzero_ps();
+        for (; i + 4 <= numParticles; i += 4)
+        {
+            const __m128 x = _mm_loadu_ps(&particles_.positionX_[i]);
+            const __m128 y = _mm_loadu_ps(&particles_.positionY_[i]);
+            const __m128 z = _mm_loadu_ps(&particles_.positionZ_[i]);
+            minX = _mm_min_ps(minX, x);
+            minY = _mm_min_ps(minY, y);
+            minZ = _mm_min_ps(minZ, z);
+            maxX = _mm_max_ps(maxX, x);
+            maxY = _mm_max_ps(maxY, y);
+            maxZ = _mm_max_ps(maxZ, z);
+
+            const __m128 size = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(&particles_.sizeX_[i]), edgeX),
+                _mm_mul_ps(_mm_loadu_ps(&particles_.sizeY_[i]), edgeY));
+            edge = _mm_max_ps(edge, _mm_mul_ps(size, _mm_loadu_ps(&particles_.scales_[i])));
+        }
+
+        alignas(16) float lanes[7][4];
+        _mm_store_ps(lanes[0], minX);
+        _mm_store_ps(lanes[1], minY);
+        _mm_store_ps(lanes[2], minZ);
+        _mm_store_ps(lanes[3], maxX);
+        _mm_store_ps(lanes[4], maxY);
+        _mm_store_ps(lanes[5], maxZ);
+        _mm_store_ps(lanes[6], edge);
+        for (unsigned lane = 0; lane < 4; ++lane)
+        {
+            minPosition = VectorMin(minPosition, Vector3(lanes[0][lane], lanes[1][lane], lanes[2][lane]));
+            maxPosition = VectorMax(maxPosition, Vector3(lanes[3][lane], lanes[4][lane], lanes[5][lane]));
+            maxEdge = Max(maxEdge, lanes[6][lane]);
+        }
+    }
+#endif
+
+    for (; i < numParticles; ++i)
+    {
+        const Vector3 position = particles_.GetPosition(i);
+        minPosition = VectorMin(minPosition, position);
+        maxPosition = VectorMax(maxPosition, position);
+        const float size = particles_.sizeX_[i] * edgeScaleX + particles_.sizeY_[i] * edgeScaleY;
+        maxEdge = Max(maxEdge, size * particles_.scales_[i]);
+    }
+
+    BoundingBox worldBox;
+    if (numParticles)
+    {
+        BoundingBox centersBox{ minPosition, maxPosition };
+        if (relative_)
+            centersBox = centersBox.Transformed(worldTransform);
+        const Vector3 edge = Vector3::ONE * maxEdge;
+        worldBox.Merge(BoundingBox(centersBox.min_ - edge, centersBox.max_ + edge));
+    }
+
+    // Always merge the node's own position to ensure particle emitter updates continue when the relative mode is switched
+    worldBox.Merge(node_->GetWorldPosition());
+
+    worldBoundingBox_ = worldBox;
+}
+
+bool ParticleEmitter::GetPreparedVertexData(const float*& data, unsigned& numBillboards)
+{
+    // Node scale or face camera mode may change without particle update
+    const Vector3 billboardScale = scaled_ ? node_->GetWorldTransform().Scale() : Vector3::ONE;
+    if (vertexDataDirty_ || billboardScale != vertexDataScale_ || faceCameraMode_ != vertexDataMode_)
+        PrepareVertexData();
+
+    data = vertexData_.data();
+    numBillboards = particles_.numActive_;
+    return true;
+}
+
+void ParticleEmitter::UpdateParticles()
+{
+    ParticleSimulationParams params;
+    params.timeStep_ = lastTimeStep_;
+    params.force_ = relative_ ? node_->GetWorldRotation().Inverse() * effect_->GetConstantForce() : effect_->GetConstantForce();
+    params.damping_ = effect_->GetDampingForce();
+    // If billboards are not relative, apply scaling to the position update
+    params.moveScale_ = scaled_ && !relative_ ? node_->GetWorldScale() : Vector3::ONE;
+    params.sizeAdd_ = effect_->GetSizeAdd();
+    params.sizeMul_ = effect_->GetSizeMul();
+    SimulateParticles(particles_, params);
+
+    // Remove expired particles, active particles stay packed
+    for (unsigned i = 0; i < particles_.numActive_;)
+    {
+        if (particles_.timers_[i] >= particles_.timeToLive_[i])
+        {
+            --particles_.numActive_;
+            particles_.CopyParticle(i, particles_.numActive_);
+        }
+        else
+            ++i;
+    }
+}
+
+void ParticleEmitter::UpdateParticleFrames()
+{
+    const ea::vector<ColorFrame>& colorFrames = effect_->GetColorFrames();
+    const ea::vector<TextureFrame>& textureFrames = effect_->GetTextureFrames();
+    const unsigned numColorFrames = colorFrames.size();
+    const unsigned numTextureFrames = textureFrames.size();
+
+    if (numColorFrames > 0)
+    {
+        for (unsigned i = 0; i < particles_.numActive_; ++i)
+        {
+            const float timer = particles_.timers_[i];
+            unsigned& index = particles_.colorIndices_[i];
+            if (index >= numColorFrames)
+                continue;
+
+            if (index < numColorFrames - 1 && timer >= colorFrames[index + 1].time_)
+                ++index;
+
+            if (index < numColorFrames - 1)
+                particles_.colors_[i] = colorFrames[index].Interpolate(colorFrames[index + 1], timer);
+            else
+                particles_.colors_[i] = colorFrames[index].color_;
+        }
+    }
+
+    if (numTextureFrames > 1)
+    {
+        for (unsigned i = 0; i < particles_.numActive_; ++i)
+        {
+            unsigned& texIndex = particles_.texIndices_[i];
+            if (texIndex < numTextureFrames - 1 && particles_.timers_[i] >= textureFrames[texIndex + 1].time_)
+            {
+                particles_.uvs_[i] = textureFrames[texIndex + 1].uv_;
+                ++texIndex;
+            }
+        }
+    }
+}
+
+void ParticleEmitter::PrepareVertexData()
+{
+    vertexDataScale_ = scaled_ && node_ ? node_->GetWorldTransform().Scale() : Vector3::ONE;
+    vertexDataMode_ = faceCameraMode_;
+    vertexDataDirty_ = false;
+
+    const unsigned numParticles = particles_.numActive_;
+    const bool directional = faceCameraMode_ == FC_DIRECTION;
+    const unsigned vertexSize = directional ? DirectionalBillboardVertexSize : BillboardVertexSize;
+    vertexData_.resize(numParticles * 4 * vertexSize);
+
+    float* dest = vertexData_.data();
+    for (unsigned i = 0; i < numParticles; ++i)
+    {
+        const Vector3 position = particles_.GetPosition(i);
+        const Vector2 size = particles_.GetSize(i) * Vector2(vertexDataScale_.x_, vertexDataScale_.y_);
+        const unsigned color = particles_.colors_[i].ToUInt();
+        const float rotation = particles_.rotations_[i];
+        const Rect& uv = particles_.uvs_[i];
+
+        if (directional)
+            dest = WriteDirectionalBillboardVertices(dest, position, particles_.GetDirection(i), size, rotation, color, uv);
+        else
+            dest = WriteBillboardVertices(dest, position, size, rotation, color, uv);
+    }
+}
+
+void ParticleEmitter::MarkParticlesDirty()
+{
+    vertexDataDirty_ = true;
+    UpdateBillboards();
+    Commit();
+}
+
 bool ParticleEmitter::EmitNewParticle()
 {
-    unsigned index = GetFreeParticle();
+    const unsigned index = GetFreeParticle();
     if (index == M_MAX_UNSIGNED)
         return false;
-    assert(index < particles_.size());
-    Particle& particle = particles_[index];
-    Billboard& billboard = billboards_[index];
+    assert(index == particles_.numActive_);
 
     Vector3 startDir;
     Vector3 startPos;
@@ -513,17 +940,19 @@ bool ParticleEmitter::EmitNewParticle()
         break;
     }
 
-    particle.size_ = effect_->GetRandomSize();
-    particle.timer_ = 0.0f;
-    particle.timeToLive_ = effect_->GetRandomTimeToLive();
-    particle.scale_ = 1.0f;
-    particle.rotationSpeed_ = effect_->GetRandomRotationSpeed();
-    particle.colorIndex_ = 0;
-    particle.texIndex_ = 0;
+    const Vector2 size = effect_->GetRandomSize();
+    particles_.sizeX_[index] = size.x_;
+    particles_.sizeY_[index] = size.y_;
+    particles_.timers_[index] = 0.0f;
+    particles_.timeToLive_[index] = effect_->GetRandomTimeToLive();
+    particles_.scales_[index] = 1.0f;
+    particles_.rotationSpeeds_[index] = effect_->GetRandomRotationSpeed();
+    particles_.colorIndices_[index] = 0;
+    particles_.texIndices_[index] = 0;
 
     if (faceCameraMode_ == FC_DIRECTION)
     {
-        startPos += startDir * particle.size_.y_;
+        startPos += startDir * size.y_;
     }
 
     if (!relative_)
@@ -532,44 +961,27 @@ bool ParticleEmitter::EmitNewParticle()
         startDir = node_->GetWorldRotation() * startDir;
     };
 
-    particle.velocity_ = effect_->GetRandomVelocity() * startDir;
-
-    billboard.position_ = startPos;
-    billboard.size_ = particles_[index].size_;
-    const ea::vector<TextureFrame>& textureFrames_ = effect_->GetTextureFrames();
-    billboard.uv_ = textureFrames_.size() ? textureFrames_[0].uv_ : Rect::POSITIVE;
-    billboard.rotation_ = effect_->GetRandomRotation();
-    const ea::vector<ColorFrame>& colorFrames_ = effect_->GetColorFrames();
-    billboard.color_ = colorFrames_.size() ? colorFrames_[0].color_ : Color();
-    billboard.enabled_ = true;
-    billboard.direction_ = startDir;
+    particles_.SetVelocity(index, effect_->GetRandomVelocity() * startDir);
+    particles_.SetPosition(index, startPos);
+    const ea::vector<TextureFrame>& textureFrames = effect_->GetTextureFrames();
+    particles_.uvs_[index] = textureFrames.size() ? textureFrames[0].uv_ : Rect::POSITIVE;
+    particles_.rotations_[index] = effect_->GetRandomRotation();
+    const ea::vector<ColorFrame>& colorFrames = effect_->GetColorFrames();
+    particles_.colors_[index] = colorFrames.size() ? colorFrames[0].color_ : Color();
+    particles_.SetDirection(index, startDir);
+    ++particles_.numActive_;
 
     return true;
 }
 
 unsigned ParticleEmitter::GetFreeParticle() const
 {
-    for (unsigned i = 0; i < billboards_.size(); ++i)
-    {
-        if (!billboards_[i].enabled_)
-            return i;
-    }
-
-    return M_MAX_UNSIGNED;
+    return particles_.numActive_ < particles_.GetCapacity() ? particles_.numActive_ : M_MAX_UNSIGNED;
 }
 
 bool ParticleEmitter::CheckActiveParticles() const
 {
-    for (unsigned i = 0; i < billboards_.size(); ++i)
-    {
-        if (billboards_[i].enabled_)
-        {
-            return true;
-            break;
-        }
-    }
-
-    return false;
+    return particles_.numActive_ > 0;
 }
 
 void ParticleEmitter::HandleScenePostUpdate(StringHash eventType, VariantMap& eventData)
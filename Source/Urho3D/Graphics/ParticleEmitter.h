@@ -29,28 +29,81 @@ namespace Urho3D
 
 class ParticleEffect;
 
-/// One particle in the particle system.
-struct Particle
+/// Particles stored as structure of arrays. Active particles are stored before inactive ones.
+struct URHO3D_API ParticleBuffer
 {
-    /// Velocity.
-    Vector3 velocity_;
-    /// Original billboard size.
-    Vector2 size_;
+    /// Set max number of particles. Active particles beyond the capacity are removed.
+    void SetCapacity(unsigned capacity);
+    /// Copy particle data to another index.
+    void CopyParticle(unsigned destIndex, unsigned sourceIndex);
+    /// Swap particle data.
+    void SwapParticles(unsigned firstIndex, unsigned secondIndex);
+
+    /// Return max number of particles.
+    unsigned GetCapacity() const { return timers_.size(); }
+    /// Return position of particle.
+    Vector3 GetPosition(unsigned index) const { return { positionX_[index], positionY_[index], positionZ_[index] }; }
+    /// Return velocity of particle.
+    Vector3 GetVelocity(unsigned index) const { return { velocityX_[index], velocityY_[index], velocityZ_[index] }; }
+    /// Return direction of particle.
+    Vector3 GetDirection(unsigned index) const { return { directionX_[index], directionY_[index], directionZ_[index] }; }
+    /// Return current size of particle.
+    Vector2 GetSize(unsigned index) const { return { sizeX_[index] * scales_[index], sizeY_[index] * scales_[index] }; }
+    /// Set position of particle.
+    void SetPosition(unsigned index, const Vector3& position);
+    /// Set velocity of particle.
+    void SetVelocity(unsigned index, const Vector3& velocity);
+    /// Set direction of particle.
+    void SetDirection(unsigned index, const Vector3& direction);
+
+    /// Number of active particles.
+    unsigned numActive_{};
+
+    /// Position X.
+    ea::vector<float> positionX_;
+    /// Position Y.
+    ea::vector<float> positionY_;
+    /// Position Z.
+    ea::vector<float> positionZ_;
+    /// Velocity X.
+    ea::vector<float> velocityX_;
+    /// Velocity Y.
+    ea::vector<float> velocityY_;
+    /// Velocity Z.
+    ea::vector<float> velocityZ_;
+    /// Direction X.
+    ea::vector<float> directionX_;
+    /// Direction Y.
+    ea::vector<float> directionY_;
+    /// Direction Z.
+    ea::vector<float> directionZ_;
+    /// Original billboard width.
+    ea::vector<float> sizeX_;
+    /// Original billboard height.
+    ea::vector<float> sizeY_;
+    /// Size scaling value.
+    ea::vector<float> scales_;
     /// Time elapsed from creation.
-    float timer_;
+    ea::vector<float> timers_;
     /// Lifetime.
-    float timeToLive_;
-    /// Size scaling value.
-    float scale_;
+    ea::vector<float> timeToLive_;
+    /// Rotation.
+    ea::vector<float> rotations_;
     /// Rotation speed.
-    float rotationSpeed_;
+    ea::vector<float> rotationSpeeds_;
     /// Current color animation index.
-    unsigned colorIndex_;
+    ea::vector<unsigned> colorIndices_;
     /// Current texture animation index.
-    unsigned texIndex_;
+    ea::vector<unsigned> texIndices_;
+    /// Current color.
+    ea::vector<Color> colors_;
+    /// Current UV coordinates.
+    ea::vector<Rect> uvs_;
 };
 
 /// %Particle emitter component.
+/// Particles are simulated in ParticleBuffer and written to the vertex buffer directly.
+/// Billboards are kept up to date only if billboards are sorted or have fixed screen size, see UpdateBillboards().
 class URHO3D_API ParticleEmitter : public BillboardSet
 {
     URHO3D_OBJECT(ParticleEmitter, BillboardSet);
@@ -68,6 +121,8 @@ public:
     void OnSetEnabled() override;
     /// Update before octree reinsertion. Is called from a worker thread.
     void Update(const FrameInfo& frame) override;
+    /// Process octree raycast. May be called from a worker thread.
+    void ProcessRayQuery(const RayOctreeQuery& query, ea::vector<RayQueryResult>& results) override;
 
     /// Set particle effect.
     /// @property
@@ -92,6 +147,8 @@ public:
     void Reset();
     /// Apply not continuously updated values such as the material, the number of particles and sorting mode from the particle effect. Call this if you change the effect programmatically.
     void ApplyEffect();
+    /// Copy particles to billboards.
+    void UpdateBillboards();
 
     /// Return particle effect.
     /// @property
@@ -99,7 +156,11 @@ public:
 
     /// Return maximum number of particles.
     /// @property
-    unsigned GetNumParticles() const { return particles_.size(); }
+    unsigned GetNumParticles() const { return particles_.GetCapacity(); }
+    /// Return number of active particles.
+    unsigned GetNumActiveParticles() const { return particles_.numActive_; }
+    /// Return particle data.
+    const ParticleBuffer& GetParticleBuffer() const { return particles_; }
 
     /// Return whether is currently emitting.
     /// @property
@@ -121,12 +182,18 @@ public:
     void SetParticlesAttr(const VariantVector& value);
     /// Return particles attribute. Returns particle amount only if particles are not to be serialized.
     VariantVector GetParticlesAttr() const;
+    /// Set billboards attribute.
+    void SetParticleBillboardsAttr(const VariantVector& value);
     /// Return billboards attribute. Returns billboard amount only if particles are not to be serialized.
     VariantVector GetParticleBillboardsAttr() const;
 
 protected:
     /// Handle scene being assigned.
     void OnSceneSet(Scene* scene) override;
+    /// Recalculate the world-space bounding box.
+    void OnWorldBoundingBoxUpdate() override;
+    /// Return vertex data of active particles.
+    bool GetPreparedVertexData(const float*& data, unsigned& numBillboards) override;
 
     /// Create a new particle. Return true if there was room.
     bool EmitNewParticle();
@@ -136,6 +203,14 @@ protected:
     bool CheckActiveParticles() const;
 
 private:
+    /// Remove expired particles and simulate the rest.
+    void UpdateParticles();
+    /// Update color and texture animation of particles.
+    void UpdateParticleFrames();
+    /// Write vertices of active particles.
+    void PrepareVertexData();
+    /// Mark particles changed outside of update.
+    void MarkParticlesDirty();
     /// Handle scene post-update event.
     void HandleScenePostUpdate(StringHash eventType, VariantMap& eventData);
     /// Handle live reload of the particle effect.
@@ -144,7 +219,15 @@ private:
     /// Particle effect.
     SharedPtr<ParticleEffect> effect_;
     /// Particles.
-    ea::vector<Particle> particles_;
+    ParticleBuffer particles_;
+    /// Vertex data of active particles.
+    ea::vector<float> vertexData_;
+    /// Billboard scale used for vertex data.
+    Vector3 vertexDataScale_;
+    /// Face camera mode used for vertex data.
+    FaceCameraMode vertexDataMode_{};
+    /// Vertex data dirty flag.
+    bool vertexDataDirty_{ true };
     /// Active/inactive period timer.
     float periodTimer_;
     /// New particle emission timer.
@@ -100,7 +100,11 @@ void PipelineState::ResetCachedState()
 void PipelineState::RestoreCachedState(Graphics* graphics)
 {
     if (!shaderProgramLayout_)
-        shaderProgramLayout_ = graphics->GetShaderProgramLayout(desc_.vertexShader_, desc_.pixelShader_);
+    {
+        shaderProgramLayout_ = graphics->IsNullDevice()
+            ? graphics->GetNullShaderProgramLayout(desc_.vertexShader_, desc_.pixelShader_)
+            : graphics->GetShaderProgramLayout(desc_.vertexShader_, desc_.pixelShader_);
+    }
 }
 
 void PipelineState::Apply(Graphics* graphics)
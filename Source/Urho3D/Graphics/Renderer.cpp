@@ -1726,7 +1726,7 @@ void Renderer::Initialize()
     auto* graphics = GetSubsystem<Graphics>();
     auto* cache = GetSubsystem<ResourceCache>();
 
-    if (!graphics || !graphics->IsInitialized() || !cache)
+    if (!graphics || !(graphics->IsInitialized() || graphics->IsNullDevice()) || !cache)
         return;
 
     URHO3D_PROFILE("InitRenderer");
@@ -23,6 +23,8 @@
 #include "../Precompiled.h"
 
 #include "../Core/Context.h"
+#include "../Core/Thread.h"
+#include "../Core/WorkQueue.h"
 #include "../IO/Log.h"
 #include "../Graphics/Geometry.h"
 #include "../Graphics/IndexBuffer.h"
@@ -31,6 +33,10 @@
 
 #include <EASTL/sort.h>
 
+#ifdef URHO3D_SSE
+#include <xmmintrin.h>
+#endif
+
 #include "../DebugNew.h"
 
 namespace Urho3D
@@ -48,6 +54,179 @@ Vector3 TransformNormal(const Matrix3x4& m, const Vector3& v)
     };
 }
 
+/// Vertex data layout for skinning.
+struct SkinningLayout
+{
+    /// Vertex data.
+    unsigned char* data_{};
+    /// Vertex size.
+    unsigned vertexSize_{};
+    /// Offset of normal.
+    unsigned normalOffset_{};
+    /// Offset of tangent.
+    unsigned tangentOffset_{};
+    /// Number of vertices.
+    unsigned numVertices_{};
+    /// Number of bones per vertex.
+    unsigned numBones_{};
+};
+
+#ifdef URHO3D_SSE
+/// Accumulate weighted bone matrix rows for one vertex of the block.
+template <int Lane>
+inline void AccumulateBoneRows(__m128 rows[3], __m128 weights, const Matrix3x4& transform)
+{
+    const __m128 weight = _mm_shuffle_ps(weights, weights, _MM_SHUFFLE(Lane, Lane, Lane, Lane));
+    const float* data = transform.Data();
+    rows[0] = _mm_add_ps(rows[0], _mm_mul_ps(_mm_loadu_ps(data), weight));
+    rows[1] = _mm_add_ps(rows[1], _mm_mul_ps(_mm_loadu_ps(data + 4), weight));
+    rows[2] = _mm_add_ps(rows[2], _mm_mul_ps(_mm_loadu_ps(data + 8), weight));
+}
+
+/// Load 3 components of vectors of the block in SoA layout.
+inline void LoadVectors(const unsigned char* data, unsigned stride, unsigned count, __m128& x, __m128& y, __m128& z)
+{
+    alignas(16) float values[3][SoftwareModelAnimator::VertexBlockSize]{};
+    for (unsigned i = 0; i < count; ++i)
+    {
+        const auto vector = reinterpret_cast<const float*>(data + i * stride);
+        values[0][i] = vector[0];
+        values[1][i] = vector[1];
+        values[2][i] = vector[2];
+    }
+    x = _mm_load_ps(values[0]);
+    y = _mm_load_ps(values[1]);
+    z = _mm_load_ps(values[2]);
+}
+
+/// Store 3 components of vectors of the block from SoA layout.
+inline void StoreVectors(unsigned char* data, unsigned stride, unsigned count, __m128 x, __m128 y, __m128 z)
+{
+    alignas(16) float values[3][SoftwareModelAnimator::VertexBlockSize];
+    _mm_store_ps(values[0], x);
+    _mm_store_ps(values[1], y);
+    _mm_store_ps(values[2], z);
+    for (unsigned i = 0; i < count; ++i)
+    {
+        const auto vector = reinterpret_cast<float*>(data + i * stride);
+        vector[0] = values[0][i];
+        vector[1] = values[1][i];
+        vector[2] = values[2][i];
+    }
+}
+
+/// Transform vectors of the block by blended matrices in SoA layout.
+inline void TransformVectors(const __m128 m[3][4], __m128& x, __m128& y, __m128& z, bool translate)
+{
+    __m128 newX = _mm_add_ps(_mm_add_ps(_mm_mul_ps(m[0][0], x), _mm_mul_ps(m[0][1], y)), _mm_mul_ps(m[0][2], z));
+    __m128 newY = _mm_add_ps(_mm_add_ps(_mm_mul_ps(m[1][0], x), _mm_mul_ps(m[1][1], y)), _mm_mul_ps(m[1][2], z));
+    __m128 newZ = _mm_add_ps(_mm_add_ps(_mm_mul_ps(m[2][0], x), _mm_mul_ps(m[2][1], y)), _mm_mul_ps(m[2][2], z));
+    if (translate)
+    {
+        newX = _mm_add_ps(newX, m[0][3]);
+        newY = _mm_add_ps(newY, m[1][3]);
+        newZ = _mm_add_ps(newZ, m[2][3]);
+    }
+    x = newX;
+    y = newY;
+    z = newZ;
+}
+#endif
+
+/// Skin range of vertex blocks.
+template <bool SkinNormals, bool SkinTangents>
+void SkinVertexBlocks(const SkinningLayout& layout, const unsigned char* blockIndices, const float* blockWeights,
+    const Matrix3x4* transforms, unsigned beginBlock, unsigned endBlock)
+{
+    static const unsigned blockSize = SoftwareModelAnimator::VertexBlockSize;
+    const unsigned numBones = layout.numBones_;
+    const unsigned stride = layout.vertexSize_;
+
+    for (unsigned blockIndex = beginBlock; blockIndex < endBlock; ++blockIndex)
+    {
+        const unsigned firstVertex = blockIndex * blockSize;
+        const unsigned count = ea::min(blockSize, layout.numVertices_ - firstVertex);
+        const unsigned char* indices = blockIndices + blockIndex * numBones * blockSize;
+        const float* weights = blockWeights + blockIndex * numBones * blockSize;
+        unsigned char* positions = layout.data_ + firstVertex * stride;
+
+#ifdef URHO3D_SSE
+        // Blend matrix rows for each vertex
+        __m128 rows[blockSize][3];
+        for (unsigned lane = 0; lane < blockSize; ++lane)
+            rows[lane][0] = rows[lane][1] = rows[lane][2] = _mm_setzero_ps();
+
+        for (unsigned boneIndex = 0; boneIndex < numBones; ++boneIndex)
+        {
+            const __m128 boneWeights = _mm_loadu_ps(weights + boneIndex * blockSize);
+            const unsigned char* boneIndices = indices + boneIndex * blockSize;
+            AccumulateBoneRows<0>(rows[0], boneWeights, transforms[boneIndices[0]]);
+            AccumulateBoneRows<1>(rows[1], boneWeights, transforms[boneIndices[1]]);
+            AccumulateBoneRows<2>(rows[2], boneWeights, transforms[boneIndices[2]]);
+            AccumulateBoneRows<3>(rows[3], boneWeights, transforms[boneIndices[3]]);
+        }
+
+        // Transpose rows, so each register contains one matrix element for all vertices
+        __m128 m[3][4];
+        for (unsigned row = 0; row < 3; ++row)
+        {
+            m[row][0] = rows[0][row];
+            m[row][1] = rows[1][row];
+            m[row][2] = rows[2][row];
+            m[row][3] = rows[3][row];
+            _MM_TRANSPOSE4_PS(m[row][0], m[row][1], m[row][2], m[row][3]);
+        }
+
+        __m128 x, y, z;
+        LoadVectors(positions, stride, count, x, y, z);
+        TransformVectors(m, x, y, z, true);
+        StoreVectors(positions, stride, count, x, y, z);
+
+        if (SkinNormals)
+        {
+            unsigned char* normals = positions + layout.normalOffset_;
+            LoadVectors(normals, stride, count, x, y, z);
+            TransformVectors(m, x, y, z, false);
+            StoreVectors(normals, stride, count, x, y, z);
+        }
+
+        if (SkinTangents)
+        {
+            unsigned char* tangents = positions + layout.tangentOffset_;
+            LoadVectors(tangents, stride, count, x, y, z);
+            TransformVectors(m, x, y, z, false);
+            StoreVectors(tangents, stride, count, x, y, z);
+        }
+#else
+        for (unsigned lane = 0; lane < count; ++lane)
+        {
+            Matrix3x4 matrix = transforms[indices[lane]] * weights[lane];
+            for (unsigned boneIndex = 1; boneIndex < numBones; ++boneIndex)
+            {
+                const unsigned offset = boneIndex * blockSize + lane;
+                matrix = matrix + transforms[indices[offset]] * weights[offset];
+            }
+
+            unsigned char* vertex = positions + lane * stride;
+            Vector3& position = *reinterpret_cast<Vector3*>(vertex);
+            position = matrix * position;
+
+            if (SkinNormals)
+            {
+                Vector3& normal = *reinterpret_cast<Vector3*>(vertex + layout.normalOffset_);
+                normal = TransformNormal(matrix, normal);
+            }
+
+            if (SkinTangents)
+            {
+                Vector3& tangent = *reinterpret_cast<Vector3*>(vertex + layout.tangentOffset_);
+                tangent = TransformNormal(matrix, tangent);
+            }
+        }
+#endif
+    }
+}
+
 }
 
 SoftwareModelAnimator::SoftwareModelAnimator(Context* context) : Object(context) {}
@@ -66,6 +245,7 @@ void SoftwareModelAnimator::Initialize(Model* model, bool skinned, unsigned numB
     numBones_ = numBones;
     CloneModelGeometries();
     InitializeAnimationData();
+    InitializeMorphData();
 }
 
 void SoftwareModelAnimator::ResetAnimation()
@@ -89,6 +269,23 @@ void SoftwareModelAnimator::ResetAnimation()
 
 void SoftwareModelAnimator::ApplyMorphs(ea::span<const ModelMorph> morphs)
 {
+    if (morphs.size() == originalModel_->GetNumMorphs())
+    {
+        const bool anyMorphActive = ea::any_of(morphs.begin(), morphs.end(),
+            [](const ModelMorph& morph) { return morph.weight_ != 0.0f; });
+        if (!anyMorphActive)
+            return;
+
+        for (unsigned bufferIndex = 0; bufferIndex < vertexBuffers_.size(); ++bufferIndex)
+        {
+            VertexBuffer* clonedBuffer = vertexBuffers_[bufferIndex];
+            if (clonedBuffer)
+                ApplyFusedMorphs(clonedBuffer, vertexBuffersData_[bufferIndex], morphs);
+        }
+        return;
+    }
+
+    // Morphs don't match the model, apply them one by one
     for (const ModelMorph& morph : morphs)
     {
         if (morph.weight_ == 0.0f)
@@ -132,53 +329,31 @@ template <bool SkinNormals, bool SkinTangents>
 void SoftwareModelAnimator::ApplyVertexBufferSkinning(VertexBuffer* clonedBuffer, const VertexBufferAnimationData& animationData,
     ea::span<const Matrix3x4> worldTransforms) const
 {
-    const unsigned clonedVertexSize = clonedBuffer->GetVertexSize();
-    const unsigned normalOffset = clonedBuffer->GetElementOffset(TYPE_VECTOR3, SEM_NORMAL);
-    const unsigned tangentOffset = clonedBuffer->GetElementOffset(TYPE_VECTOR4, SEM_TANGENT);
-
-    unsigned char* clonedBufferData = clonedBuffer->GetShadowData();
-
-    unsigned char* positionsData = clonedBufferData;
-    unsigned char* normalsData = SkinNormals ? clonedBufferData + normalOffset : nullptr;
-    unsigned char* tangentsData = SkinTangents ? clonedBufferData + tangentOffset : nullptr;
+    SkinningLayout layout;
+    layout.data_ = clonedBuffer->GetShadowData();
+    layout.vertexSize_ = clonedBuffer->GetVertexSize();
+    layout.normalOffset_ = SkinNormals ? clonedBuffer->GetElementOffset(TYPE_VECTOR3, SEM_NORMAL) : 0;
+    layout.tangentOffset_ = SkinTangents ? clonedBuffer->GetElementOffset(TYPE_VECTOR4, SEM_TANGENT) : 0;
+    layout.numVertices_ = clonedBuffer->GetVertexCount();
+    layout.numBones_ = numBones_;
 
     const unsigned char* indicesData = animationData.blendIndices_.data();
     const float* weightsData = animationData.blendWeights_.data();
+    const Matrix3x4* transforms = worldTransforms.data();
 
-    const unsigned numVertices = clonedBuffer->GetVertexCount();
-    Matrix3x4 matrix;
-    for (unsigned vertexIndex = 0; vertexIndex < numVertices; ++vertexIndex)
+    // Work queue cannot be waited for from worker threads
+    const unsigned numBlocks = (layout.numVertices_ + VertexBlockSize - 1) / VertexBlockSize;
+    auto* workQueue = numBlocks > ThreadedSkinningBlocks && Thread::IsMainThread() ? GetSubsystem<WorkQueue>() : nullptr;
+    if (!workQueue)
     {
-        matrix = worldTransforms[indicesData[0]] * weightsData[0];
-        for (unsigned boneIndex = 1; boneIndex < numBones_; ++boneIndex)
-            matrix = matrix + worldTransforms[indicesData[boneIndex]] * weightsData[boneIndex];
-
-        Vector3& position = *reinterpret_cast<Vector3*>(positionsData);
-        position = matrix * position;
-
-        if (SkinNormals)
-        {
-            Vector3& normal = *reinterpret_cast<Vector3*>(normalsData);
-            normal = TransformNormal(matrix, normal);
-        }
-
-        if (SkinTangents)
-        {
-            Vector3& tangent = *reinterpret_cast<Vector3*>(tangentsData);
-            tangent = TransformNormal(matrix, tangent);
-        }
-
-        // Advance
-        indicesData += numBones_;
-        weightsData += numBones_;
-
-        positionsData += clonedVertexSize;
-        if (SkinNormals)
-            normalsData += clonedVertexSize;
-        if (SkinTangents)
-            tangentsData += clonedVertexSize;
+        SkinVertexBlocks<SkinNormals, SkinTangents>(layout, indicesData, weightsData, transforms, 0, numBlocks);
+        return;
     }
 
+    ForEachParallel(workQueue, ThreadedSkinningBlocks, numBlocks, [&](unsigned beginBlock, unsigned endBlock)
+    {
+        SkinVertexBlocks<SkinNormals, SkinTangents>(layout, indicesData, weightsData, transforms, beginBlock, endBlock);
+    });
 }
 
 void SoftwareModelAnimator::Commit()
@@ -257,12 +432,12 @@ void SoftwareModelAnimator::CloneModelGeometries()
             URHO3D_LOGERROR("Vertex size must be aligned to 4 for software skinning and morphing");
             continue;
         }
-        if (originalVertexBuffer->GetElementOffset(SEM_NORMAL) % alignof(float) != 0)
+        if ((clonedBufferMask & MASK_NORMAL) && originalVertexBuffer->GetElementOffset(SEM_NORMAL) % alignof(float) != 0)
         {
             URHO3D_LOGERROR("Normal offset within vertex must be aligned to 4 for software skinning and morphing");
             continue;
         }
-        if (originalVertexBuffer->GetElementOffset(SEM_TANGENT) % alignof(float) != 0)
+        if ((clonedBufferMask & MASK_TANGENT) && originalVertexBuffer->GetElementOffset(SEM_TANGENT) % alignof(float) != 0)
         {
             URHO3D_LOGERROR("Tangent offset within vertex must be aligned to 4 for software skinning and morphing");
             continue;
@@ -330,6 +505,8 @@ void SoftwareModelAnimator::InitializeAnimationData()
     {
         VertexBuffer* originalBuffer = originalModel_->GetVertexBuffers()[bufferIndex];
         VertexBuffer* clonedBuffer = vertexBuffers_[bufferIndex];
+        if (!clonedBuffer)
+            continue;
 
         const unsigned originalVertexSize = originalBuffer->GetVertexSize();
         const unsigned indicesOffset = originalBuffer->GetElementOffset(TYPE_UBYTE4, SEM_BLENDINDICES);
@@ -345,8 +522,9 @@ void SoftwareModelAnimator::InitializeAnimationData()
         animationData.hasSkeletalAnimation_ = true;
         animationData.skinNormals_ = clonedBuffer->HasElement(SEM_NORMAL);
         animationData.skinTangents_ = clonedBuffer->HasElement(SEM_TANGENT);
-        animationData.blendIndices_.resize(numVertices * numBones_);
-        animationData.blendWeights_.resize(numVertices * numBones_);
+        const unsigned numBlocks = (numVertices + VertexBlockSize - 1) / VertexBlockSize;
+        animationData.blendIndices_.resize(numBlocks * numBones_ * VertexBlockSize);
+        animationData.blendWeights_.resize(numBlocks * numBones_ * VertexBlockSize);
 
         const unsigned char* originalBufferData = originalBuffer->GetShadowData();
 
@@ -356,6 +534,9 @@ void SoftwareModelAnimator::InitializeAnimationData()
         ea::array<ea::pair<float, unsigned char>, MaxBones> bones;
         for (unsigned vertexIndex = 0; vertexIndex < numVertices; ++vertexIndex)
         {
+            const unsigned blockOffset = (vertexIndex / VertexBlockSize) * numBones_ * VertexBlockSize;
+            const unsigned lane = vertexIndex % VertexBlockSize;
+
             // Copy indices
             for (unsigned boneIndex = 0; boneIndex < MaxBones; ++boneIndex)
                 bones[boneIndex].second = indicesData[boneIndex];
@@ -377,8 +558,9 @@ void SoftwareModelAnimator::InitializeAnimationData()
             {
                 for (unsigned boneIndex = 0; boneIndex < MaxBones; ++boneIndex)
                 {
-                    animationData.blendIndices_[vertexIndex * numBones_ + boneIndex] = bones[boneIndex].second;
-                    animationData.blendWeights_[vertexIndex * numBones_ + boneIndex] = bones[boneIndex].first;
+                    const unsigned offset = blockOffset + boneIndex * VertexBlockSize + lane;
+                    animationData.blendIndices_[offset] = bones[boneIndex].second;
+                    animationData.blendWeights_[offset] = bones[boneIndex].first;
                 }
             }
             else
@@ -390,8 +572,9 @@ void SoftwareModelAnimator::InitializeAnimationData()
 
                 for (unsigned boneIndex = 0; boneIndex < numBones_; ++boneIndex)
                 {
-                    animationData.blendIndices_[vertexIndex * numBones_ + boneIndex] = bones[boneIndex].second;
-                    animationData.blendWeights_[vertexIndex * numBones_ + boneIndex] = bones[boneIndex].first / totalWeight;
+                    const unsigned offset = blockOffset + boneIndex * VertexBlockSize + lane;
+                    animationData.blendIndices_[offset] = bones[boneIndex].second;
+                    animationData.blendWeights_[offset] = bones[boneIndex].first / totalWeight;
                 }
             }
 
@@ -402,6 +585,136 @@ void SoftwareModelAnimator::InitializeAnimationData()
     }
 }
 
+void SoftwareModelAnimator::InitializeMorphData()
+{
+    for (VertexBufferAnimationData& animationData : vertexBuffersData_)
+    {
+        animationData.morphedVertices_.clear();
+        animationData.morphEntryOffsets_.clear();
+        animationData.morphEntries_.clear();
+    }
+
+    // Collect morph entries of all vertices
+    const ea::vector<ModelMorph>& morphs = originalModel_->GetMorphs();
+    ea::vector<ea::vector<ea::pair<unsigned, VertexMorphEntry>>> bufferEntries(vertexBuffers_.size());
+    for (unsigned morphIndex = 0; morphIndex < morphs.size(); ++morphIndex)
+    {
+        for (const auto& bufferMorph : morphs[morphIndex].buffers_)
+        {
+            const unsigned bufferIndex = bufferMorph.first;
+            VertexBuffer* clonedBuffer = bufferIndex < vertexBuffers_.size() ? vertexBuffers_[bufferIndex] : nullptr;
+            if (!clonedBuffer)
+                continue;
+
+            const VertexBufferMorph& morph = bufferMorph.second;
+            const VertexMaskFlags elementMask = clonedBuffer->GetElementMask();
+            const unsigned char* srcData = morph.morphData_.get();
+            for (unsigned i = 0; i < morph.vertexCount_; ++i)
+            {
+                const unsigned vertexIndex = *reinterpret_cast<const unsigned*>(srcData);
+                srcData += sizeof(unsigned);
+
+                VertexMorphEntry entry;
+                entry.morphIndex_ = morphIndex;
+                if (morph.elementMask_ & MASK_POSITION)
+                {
+                    if (elementMask & MASK_POSITION)
+                        entry.position_ = reinterpret_cast<const float*>(srcData);
+                    srcData += 3 * sizeof(float);
+                }
+                if (morph.elementMask_ & MASK_NORMAL)
+                {
+                    if (elementMask & MASK_NORMAL)
+                        entry.normal_ = reinterpret_cast<const float*>(srcData);
+                    srcData += 3 * sizeof(float);
+                }
+                if (morph.elementMask_ & MASK_TANGENT)
+                {
+                    if (elementMask & MASK_TANGENT)
+                        entry.tangent_ = reinterpret_cast<const float*>(srcData);
+                    srcData += 3 * sizeof(float);
+                }
+
+                if (vertexIndex < clonedBuffer->GetVertexCount())
+                    bufferEntries[bufferIndex].emplace_back(vertexIndex, entry);
+            }
+        }
+    }
+
+    // Group entries by vertex
+    for (unsigned bufferIndex = 0; bufferIndex < bufferEntries.size(); ++bufferIndex)
+    {
+        auto& entries = bufferEntries[bufferIndex];
+        if (entries.empty())
+            continue;
+
+        ea::stable_sort(entries.begin(), entries.end(),
+            [](const auto& lhs, const auto& rhs) { return lhs.first < rhs.first; });
+
+        VertexBufferAnimationData& animationData = vertexBuffersData_[bufferIndex];
+        animationData.morphEntries_.reserve(entries.size());
+        for (const auto& item : entries)
+        {
+            if (animationData.morphedVertices_.empty() || animationData.morphedVertices_.back() != item.first)
+            {
+                animationData.morphedVertices_.push_back(item.first);
+                animationData.morphEntryOffsets_.push_back(animationData.morphEntries_.size());
+            }
+            animationData.morphEntries_.push_back(item.second);
+        }
+        animationData.morphEntryOffsets_.push_back(animationData.morphEntries_.size());
+    }
+}
+
+void SoftwareModelAnimator::ApplyFusedMorphs(VertexBuffer* buffer, const VertexBufferAnimationData& animationData,
+    ea::span<const ModelMorph> morphs) const
+{
+    const unsigned vertexSize = buffer->GetVertexSize();
+    const unsigned normalOffset = buffer->GetElementOffset(SEM_NORMAL);
+    const unsigned tangentOffset = buffer->GetElementOffset(SEM_TANGENT);
+    unsigned char* destData = buffer->GetShadowData();
+
+    const unsigned numVertices = animationData.morphedVertices_.size();
+    for (unsigned i = 0; i < numVertices; ++i)
+    {
+        // Accumulate all morphs of the vertex, then write it once
+        float delta[3][3]{};
+        bool hasDelta[3]{};
+        for (unsigned entryIndex = animationData.morphEntryOffsets_[i]; entryIndex < animationData.morphEntryOffsets_[i + 1]; ++entryIndex)
+        {
+            const VertexMorphEntry& entry = animationData.morphEntries_[entryIndex];
+            const float weight = morphs[entry.morphIndex_].weight_;
+            if (weight == 0.0f)
+                continue;
+
+            const float* const sources[3] = { entry.position_, entry.normal_, entry.tangent_ };
+            for (unsigned element = 0; element < 3; ++element)
+            {
+                if (const float* src = sources[element])
+                {
+                    delta[element][0] += src[0] * weight;
+                    delta[element][1] += src[1] * weight;
+                    delta[element][2] += src[2] * weight;
+                    hasDelta[element] = true;
+                }
+            }
+        }
+
+        unsigned char* vertex = destData + animationData.morphedVertices_[i] * vertexSize;
+        const unsigned offsets[3] = { 0, normalOffset, tangentOffset };
+        for (unsigned element = 0; element < 3; ++element)
+        {
+            if (!hasDelta[element])
+                continue;
+
+            auto dest = reinterpret_cast<float*>(vertex + offsets[element]);
+            dest[0] += delta[element][0];
+            dest[1] += delta[element][1];
+            dest[2] += delta[element][2];
+        }
+    }
+}
+
 void SoftwareModelAnimator::CopyMorphVertices(void* destVertexData, const void* srcVertexData, unsigned vertexCount,
     VertexBuffer* destBuffer, VertexBuffer* srcBuffer) const
 {
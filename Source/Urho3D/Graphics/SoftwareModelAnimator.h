@@ -30,6 +30,19 @@
 namespace Urho3D
 {
 
+/// Morph of single vertex.
+struct VertexMorphEntry
+{
+    /// Index of morph in the model.
+    unsigned morphIndex_{};
+    /// Position delta, null if not morphed.
+    const float* position_{};
+    /// Normal delta, null if not morphed.
+    const float* normal_{};
+    /// Tangent delta, null if not morphed.
+    const float* tangent_{};
+};
+
 /// Container for vertex buffer animation data.
 struct VertexBufferAnimationData
 {
@@ -39,10 +52,19 @@ struct VertexBufferAnimationData
     bool skinNormals_{};
     /// Whether the buffer has tangents affected by skeletal animation.
     bool skinTangents_{};
-    /// Blend weights. Size is number of bones used times number of vertices.
+    /// Blend weights grouped by blocks of 4 vertices.
+    /// Each block contains weights of the first bone for 4 vertices, then weights of the second bone and so on.
+    /// Last block is padded with zero weights.
     ea::vector<float> blendWeights_;
-    /// Blend indices.
+    /// Blend indices with the same layout as weights.
     ea::vector<unsigned char> blendIndices_;
+
+    /// Sorted indices of vertices affected by morphs.
+    ea::vector<unsigned> morphedVertices_;
+    /// Range of morph entries for each affected vertex. Size is number of affected vertices plus one.
+    ea::vector<unsigned> morphEntryOffsets_;
+    /// Morph entries of affected vertices.
+    ea::vector<VertexMorphEntry> morphEntries_;
 };
 
 /// Class for software model animation (morphing and skinning).
@@ -53,6 +75,10 @@ class URHO3D_API SoftwareModelAnimator : public Object
 public:
     /// Max number of bones.
     static const unsigned MaxBones = 4;
+    /// Number of vertices skinned together.
+    static const unsigned VertexBlockSize = 4;
+    /// Number of vertex blocks processed by one thread at once.
+    static const unsigned ThreadedSkinningBlocks = 1024;
 
     /// Construct.
     explicit SoftwareModelAnimator(Context* context);
@@ -67,8 +93,9 @@ public:
     /// Reset morph and/or skeletal animation. Safe to call from worker thread.
     void ResetAnimation();
     /// Apply morphs. Safe to call from worker thread.
+    /// If morphs match the model morphs, all morphs are applied in single pass over affected vertices.
     void ApplyMorphs(ea::span<const ModelMorph> morphs);
-    /// Apply skinning.
+    /// Apply skinning. Large vertex buffers are processed in multiple threads if called from main thread.
     void ApplySkinning(ea::span<const Matrix3x4> worldTransforms);
     /// Commit data to GPU.
     void Commit();
@@ -86,11 +113,16 @@ private:
     void CloneModelGeometries();
     /// Initialize skeletal animation data.
     void InitializeAnimationData();
+    /// Initialize morph data for fused morph application.
+    void InitializeMorphData();
     /// Copy morph vertices.
     void CopyMorphVertices(void* destVertexData, const void* srcVertexData, unsigned vertexCount,
         VertexBuffer* destBuffer, VertexBuffer* srcBuffer) const;
     /// Apply a vertex buffer morph.
     void ApplyMorph(VertexBuffer* buffer, const VertexBufferMorph& morph, float weight);
+    /// Apply all morphs to vertex buffer at once.
+    void ApplyFusedMorphs(VertexBuffer* buffer, const VertexBufferAnimationData& animationData,
+        ea::span<const ModelMorph> morphs) const;
     /// Apply skinning for given vertex buffer.
     template <bool SkinNormals, bool SkinTangents>
     void ApplyVertexBufferSkinning(VertexBuffer* clonedBuffer, const VertexBufferAnimationData& animationData,
@@ -96,11 +96,9 @@ public:
 
             if (drawable->GetCastShadows() && (drawable->GetDrawableFlags() & drawableFlags_) &&
                 (drawable->GetViewMask() & viewMask_))
-            {
-                if (inside || frustum_.IsInsideFast(drawable->GetWorldBoundingBox()))
-                    result_.push_back(drawable);
-            }
+                candidates_.push_back(drawable);
         }
+        ProcessCandidates(inside);
     }
 };
 
@@ -125,11 +123,9 @@ public:
 
             if ((flags == DRAWABLE_ZONE || (flags == DRAWABLE_GEOMETRY && drawable->IsOccluder())) &&
                 (drawable->GetViewMask() & viewMask_))
-            {
-                if (inside || frustum_.IsInsideFast(drawable->GetWorldBoundingBox()))
-                    result_.push_back(drawable);
-            }
+                candidates_.push_back(drawable);
         }
+        ProcessCandidates(inside);
     }
 };
 
@@ -167,11 +163,9 @@ public:
             Drawable* drawable = *start++;
 
             if ((drawable->GetDrawableFlags() & drawableFlags_) && (drawable->GetViewMask() & viewMask_))
-            {
-                if (inside || frustum_.IsInsideFast(drawable->GetWorldBoundingBox()))
-                    result_.push_back(drawable);
-            }
+                candidates_.push_back(drawable);
         }
+        ProcessCandidates(inside);
     }
 
     /// Occlusion buffer.
@@ -0,0 +1,107 @@
+//
+// Copyright (c) 2017-2021 the rbfx project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "../Precompiled.h"
+
+#include "../IO/BitStream.h"
+#include "../IO/Deserializer.h"
+#include "../IO/Serializer.h"
+
+#include "../DebugNew.h"
+
+namespace Urho3D
+{
+
+BitWriter::BitWriter(Serializer& dest)
+    : dest_(dest)
+{
+}
+
+BitWriter::~BitWriter()
+{
+    Flush();
+}
+
+void BitWriter::WriteBits(unsigned value, unsigned numBits)
+{
+    assert(numBits <= 32);
+    if (numBits < 32)
+        value &= (1u << numBits) - 1;
+
+    pending_ |= static_cast<unsigned long long>(value) << numPending_;
+    numPending_ += numBits;
+    numBits_ += numBits;
+
+    while (numPending_ >= 8)
+    {
+        dest_.WriteUByte(static_cast<unsigned char>(pending_ & 0xff));
+        pending_ >>= 8;
+        numPending_ -= 8;
+    }
+}
+
+void BitWriter::Flush()
+{
+    if (numPending_ > 0)
+    {
+        dest_.WriteUByte(static_cast<unsigned char>(pending_ & 0xff));
+        numBits_ += 8 - numPending_;
+        pending_ = 0;
+        numPending_ = 0;
+    }
+}
+
+BitReader::BitReader(Deserializer& source)
+    : source_(source)
+{
+}
+
+unsigned BitReader::ReadBits(unsigned numBits)
+{
+    assert(numBits <= 32);
+
+    while (numPending_ < numBits)
+    {
+        if (source_.IsEof())
+        {
+            overrun_ = true;
+            numPending_ = numBits;
+            break;
+        }
+        pending_ |= static_cast<unsigned long long>(source_.ReadUByte()) << numPending_;
+        numPending_ += 8;
+    }
+
+    const unsigned long long mask = (1ull << numBits) - 1;
+    const auto value = static_cast<unsigned>(pending_ & mask);
+    pending_ >>= numBits;
+    numPending_ -= numBits;
+    return value;
+}
+
+void BitReader::Align()
+{
+    pending_ = 0;
+    numPending_ = 0;
+}
+
+}
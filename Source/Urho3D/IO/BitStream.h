@@ -0,0 +1,97 @@
+//
+// Copyright (c) 2017-2021 the rbfx project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+/// \file
+
+#pragma once
+
+#include <Urho3D/Urho3D.h>
+
+#include "../Core/NonCopyable.h"
+
+namespace Urho3D
+{
+
+class Deserializer;
+class Serializer;
+
+/// Helper for writing values with arbitrary number of bits into serializer.
+/// Bits are accumulated and written byte by byte, least significant bits first.
+class URHO3D_API BitWriter : public NonCopyable
+{
+public:
+    /// Construct.
+    explicit BitWriter(Serializer& dest);
+    /// Destruct. Flush pending bits.
+    ~BitWriter();
+
+    /// Write lowest bits of value. Up to 32 bits can be written at once.
+    void WriteBits(unsigned value, unsigned numBits);
+    /// Write single bit.
+    void WriteBit(bool value) { WriteBits(value ? 1 : 0, 1); }
+    /// Write pending bits padded with zeros. Next write starts at byte boundary.
+    void Flush();
+
+    /// Return total number of written bits.
+    unsigned GetNumBits() const { return numBits_; }
+
+private:
+    /// Destination.
+    Serializer& dest_;
+    /// Pending bits.
+    unsigned long long pending_{};
+    /// Number of pending bits.
+    unsigned numPending_{};
+    /// Total number of written bits.
+    unsigned numBits_{};
+};
+
+/// Helper for reading values written by BitWriter.
+/// Missing bits are read as zeros if the source is exhausted.
+class URHO3D_API BitReader : public NonCopyable
+{
+public:
+    /// Construct.
+    explicit BitReader(Deserializer& source);
+
+    /// Read value of specified number of bits. Up to 32 bits can be read at once.
+    unsigned ReadBits(unsigned numBits);
+    /// Read single bit.
+    bool ReadBit() { return ReadBits(1) != 0; }
+    /// Discard remaining bits of current byte.
+    void Align();
+
+    /// Return whether the source was exhausted before all requested bits were read.
+    bool IsOverrun() const { return overrun_; }
+
+private:
+    /// Source.
+    Deserializer& source_;
+    /// Pending bits.
+    unsigned long long pending_{};
+    /// Number of pending bits.
+    unsigned numPending_{};
+    /// Whether the source is exhausted.
+    bool overrun_{};
+};
+
+}
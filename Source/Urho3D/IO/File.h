@@ -111,6 +111,9 @@ public:
     /// Return whether the file originates from a package.
     /// @property
     bool IsPackaged() const { return offset_ != 0; }
+    /// Return file contents if the file is opened from memory-mapped package, otherwise null.
+    /// Data is valid while the file is open and may be wrapped by MemoryBuffer without copying.
+    const unsigned char* GetMappedData() const { return mappedData_; }
 
     /// Reads a binary file to buffer.
     void ReadBinary(ea::vector<unsigned char>& buffer);
@@ -142,6 +145,10 @@ private:
     FileMode mode_;
     /// File handle.
     void* handle_;
+    /// Memory-mapped package of the file.
+    SharedPtr<PackageFile> mappedPackage_;
+    /// Memory-mapped file contents.
+    const unsigned char* mappedData_{};
 #ifdef __ANDROID__
     /// SDL RWops context for Android asset loading.
     SDL_RWops* assetHandle_;
@@ -27,6 +27,14 @@
 #include "../IO/PackageFile.h"
 #include "../IO/FileSystem.h"
 
+#if defined(_WIN32) && !defined(UWP)
+#include <windows.h>
+#elif !defined(_WIN32) && !defined(__EMSCRIPTEN__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
 namespace Urho3D
 {
 
@@ -49,10 +57,15 @@ PackageFile::PackageFile(Context* context, const ea::string& fileName, unsigned
     Open(fileName, startOffset);
 }
 
-PackageFile::~PackageFile() = default;
+PackageFile::~PackageFile()
+{
+    Unmap();
+}
 
 bool PackageFile::Open(const ea::string& fileName, unsigned startOffset)
 {
+    Unmap();
+
     SharedPtr<File> file(new File(context_, fileName));
     if (!file->IsOpen())
         return false;
@@ -122,6 +135,76 @@ bool PackageFile::Open(const ea::string& fileName, unsigned startOffset)
     return true;
 }
 
+bool PackageFile::MapToMemory()
+{
+    if (mappedData_)
+        return true;
+
+    if (fileName_.empty())
+    {
+        URHO3D_LOGERROR("Package file should be opened before mapping into memory");
+        return false;
+    }
+
+#ifdef __ANDROID__
+    if (URHO3D_IS_ASSET(fileName_))
+    {
+        URHO3D_LOGERROR("Android asset " + fileName_ + " cannot be mapped into memory");
+        return false;
+    }
+#endif
+
+#if defined(_WIN32) && !defined(UWP)
+    HANDLE fileHandle = CreateFileW(GetWideNativePath(fileName_).c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+        OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (fileHandle != INVALID_HANDLE_VALUE)
+    {
+        // View keeps the file mapped after handles are closed
+        HANDLE mappingHandle = CreateFileMappingW(fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (mappingHandle)
+        {
+            mappedData_ = static_cast<unsigned char*>(MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0));
+            CloseHandle(mappingHandle);
+        }
+        CloseHandle(fileHandle);
+    }
+#elif !defined(_WIN32) && !defined(__EMSCRIPTEN__)
+    const int fileDescriptor = open(GetNativePath(fileName_).c_str(), O_RDONLY);
+    if (fileDescriptor != -1)
+    {
+        // Mapping stays valid after file is closed
+        void* data = mmap(nullptr, totalSize_, PROT_READ, MAP_PRIVATE, fileDescriptor, 0);
+        if (data != MAP_FAILED)
+            mappedData_ = static_cast<unsigned char*>(data);
+        close(fileDescriptor);
+    }
+#endif
+
+    if (!mappedData_)
+    {
+        URHO3D_LOGERROR("Could not map package file " + fileName_ + " into memory");
+        return false;
+    }
+
+    mappedSize_ = totalSize_;
+    return true;
+}
+
+void PackageFile::Unmap()
+{
+    if (!mappedData_)
+        return;
+
+#if defined(_WIN32) && !defined(UWP)
+    UnmapViewOfFile(mappedData_);
+#elif !defined(_WIN32) && !defined(__EMSCRIPTEN__)
+    munmap(mappedData_, mappedSize_);
+#endif
+
+    mappedData_ = nullptr;
+    mappedSize_ = 0;
+}
+
 bool PackageFile::Exists(const ea::string& fileName) const
 {
     bool found = entries_.find(fileName) != entries_.end();
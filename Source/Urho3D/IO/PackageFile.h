@@ -53,6 +53,9 @@ public:
 
     /// Open the package file. Return true if successful.
     bool Open(const ea::string& fileName, unsigned startOffset = 0);
+    /// Map opened package file into memory. Files opened from uncompressed mapped package read data directly from the mapping.
+    /// Return true if successful. Not supported for Android assets, on UWP and on Web.
+    bool MapToMemory();
     /// Check if a file exists within the package file. This will be case-insensitive on Windows and case-sensitive on other platforms.
     bool Exists(const ea::string& fileName) const;
     /// Return the file entry corresponding to the name, or null if not found. This will be case-insensitive on Windows and case-sensitive on other platforms.
@@ -88,6 +91,12 @@ public:
     /// @property
     bool IsCompressed() const { return compressed_; }
 
+    /// Return whether the package file is mapped into memory.
+    bool IsMemoryMapped() const { return mappedData_ != nullptr; }
+
+    /// Return memory-mapped contents of the package file, or null if not mapped.
+    const unsigned char* GetMappedData() const { return mappedData_; }
+
     /// Return list of file names in the package.
     const ea::vector<ea::string> GetEntryNames() const { return entries_.keys(); }
 
@@ -107,6 +116,9 @@ public:
     void Scan(ea::vector<ea::string>& result, const ea::string& pathName, const ea::string& filter, bool recursive) const;
 
 private:
+    /// Unmap package file from memory.
+    void Unmap();
+
     /// File entries.
     ea::unordered_map<ea::string, PackageEntry> entries_;
     /// File name.
@@ -121,6 +133,10 @@ private:
     unsigned checksum_;
     /// Compressed flag.
     bool compressed_;
+    /// Memory-mapped contents of the package file.
+    unsigned char* mappedData_{};
+    /// Size of memory mapping.
+    unsigned mappedSize_{};
 };
 
 }
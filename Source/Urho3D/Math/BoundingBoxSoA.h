@@ -0,0 +1,80 @@
+//
+// Copyright (c) 2017-2021 the rbfx project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+/// \file
+
+#pragma once
+
+#include "../Math/BoundingBox.h"
+
+#include <EASTL/vector.h>
+
+namespace Urho3D
+{
+
+/// Array of bounding boxes stored as separate arrays of center and half size coordinates.
+/// Used to test many boxes at once.
+class URHO3D_API BoundingBoxSoA
+{
+public:
+    /// Remove all boxes.
+    void Clear()
+    {
+        centerX_.clear();
+        centerY_.clear();
+        centerZ_.clear();
+        halfSizeX_.clear();
+        halfSizeY_.clear();
+        halfSizeZ_.clear();
+    }
+
+    /// Add bounding box.
+    void Push(const BoundingBox& box)
+    {
+        const Vector3 center = box.Center();
+        const Vector3 halfSize = center - box.min_;
+        centerX_.push_back(center.x_);
+        centerY_.push_back(center.y_);
+        centerZ_.push_back(center.z_);
+        halfSizeX_.push_back(halfSize.x_);
+        halfSizeY_.push_back(halfSize.y_);
+        halfSizeZ_.push_back(halfSize.z_);
+    }
+
+    /// Return number of boxes.
+    unsigned Size() const { return centerX_.size(); }
+
+    /// Center X coordinates.
+    ea::vector<float> centerX_;
+    /// Center Y coordinates.
+    ea::vector<float> centerY_;
+    /// Center Z coordinates.
+    ea::vector<float> centerZ_;
+    /// Half size X coordinates.
+    ea::vector<float> halfSizeX_;
+    /// Half size Y coordinates.
+    ea::vector<float> halfSizeY_;
+    /// Half size Z coordinates.
+    ea::vector<float> halfSizeZ_;
+};
+
+}
@@ -24,6 +24,10 @@
 
 #include "../Math/Frustum.h"
 
+#ifdef URHO3D_SSE
+#include <xmmintrin.h>
+#endif
+
 #include "../DebugNew.h"
 
 namespace Urho3D
@@ -206,6 +210,81 @@ Frustum Frustum::Transformed(const Matrix3x4& transform) const
     return transformed;
 }
 
+void Frustum::IsInsideFast(const BoundingBoxSoA& boxes, ea::vector<bool>& result) const
+{
+    const unsigned numBoxes = boxes.Size();
+    result.resize(numBoxes);
+
+    unsigned i = 0;
+#ifdef URHO3D_SSE
+    // Test 4 boxes at once, plane parameters are broadcasted once
+    __m128 normalX[NUM_FRUSTUM_PLANES];
+    __m128 normalY[NUM_FRUSTUM_PLANES];
+    __m128 normalZ[NUM_FRUSTUM_PLANES];
+    __m128 absNormalX[NUM_FRUSTUM_PLANES];
+    __m128 absNormalY[NUM_FRUSTUM_PLANES];
+    __m128 absNormalZ[NUM_FRUSTUM_PLANES];
+    __m128 planeD[NUM_FRUSTUM_PLANES];
+    for (unsigned j = 0; j < NUM_FRUSTUM_PLANES; ++j)
+    {
+        const Plane& plane = planes_[j];
+        normalX[j] = _mm_set1_ps(plane.normal_.x_);
+        normalY[j] = _mm_set1_ps(plane.normal_.y_);
+        normalZ[j] = _mm_set1_ps(plane.normal_.z_);
+        absNormalX[j] = _mm_set1_ps(plane.absNormal_.x_);
+        absNormalY[j] = _mm_set1_ps(plane.absNormal_.y_);
+        absNormalZ[j] = _mm_set1_ps(plane.absNormal_.z_);
+        planeD[j] = _mm_set1_ps(plane.d_);
+    }
+
+    const __m128 signMask = _mm_set1_ps(-0.0f);
+    for (; i + 4 <= numBoxes; i += 4)
+    {
+        const __m128 centerX = _mm_loadu_ps(&boxes.centerX_[i]);
+        const __m128 centerY = _mm_loadu_ps(&boxes.centerY_[i]);
+        const __m128 centerZ = _mm_loadu_ps(&boxes.centerZ_[i]);
+        const __m128 halfSizeX = _mm_loadu_ps(&boxes.halfSizeX_[i]);
+        const __m128 halfSizeY = _mm_loadu_ps(&boxes.halfSizeY_[i]);
+        const __m128 halfSizeZ = _mm_loadu_ps(&boxes.halfSizeZ_[i]);
+
+        __m128 outside = _mm_setzero_ps();
+        for (unsigned j = 0; j < NUM_FRUSTUM_PLANES; ++j)
+        {
+            const __m128 dist = _mm_add_ps(_mm_add_ps(_mm_add_ps(
+                _mm_mul_ps(normalX[j], centerX), _mm_mul_ps(normalY[j], centerY)), _mm_mul_ps(normalZ[j], centerZ)), planeD[j]);
+            const __m128 absDist = _mm_add_ps(_mm_add_ps(
+                _mm_mul_ps(absNormalX[j], halfSizeX), _mm_mul_ps(absNormalY[j], halfSizeY)), _mm_mul_ps(absNormalZ[j], halfSizeZ));
+            outside = _mm_or_ps(outside, _mm_cmplt_ps(dist, _mm_xor_ps(absDist, signMask)));
+        }
+
+        const int outsideMask = _mm_movemask_ps(outside);
+        result[i] = !(outsideMask & 1);
+        result[i + 1] = !(outsideMask & 2);
+        result[i + 2] = !(outsideMask & 4);
+        result[i + 3] = !(outsideMask & 8);
+    }
+#endif
+
+    for (; i < numBoxes; ++i)
+    {
+        const Vector3 center{ boxes.centerX_[i], boxes.centerY_[i], boxes.centerZ_[i] };
+        const Vector3 edge{ boxes.halfSizeX_[i], boxes.halfSizeY_[i], boxes.halfSizeZ_[i] };
+
+        bool inside = true;
+        for (const auto& plane : planes_)
+        {
+            const float dist = plane.normal_.DotProduct(center) + plane.d_;
+            const float absDist = plane.absNormal_.DotProduct(edge);
+            if (dist < -absDist)
+            {
+                inside = false;
+                break;
+            }
+        }
+        result[i] = inside;
+    }
+}
+
 Rect Frustum::Projected(const Matrix4& projection) const
 {
     Rect rect;
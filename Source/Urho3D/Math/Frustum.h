@@ -25,6 +25,7 @@
 #pragma once
 
 #include "../Math/BoundingBox.h"
+#include "../Math/BoundingBoxSoA.h"
 #include "../Math/Matrix3x4.h"
 #include "../Math/Plane.h"
 #include "../Math/Rect.h"
@@ -158,6 +159,10 @@ public:
         return INSIDE;
     }
 
+    /// Test if bounding boxes are (partially) inside or outside. Result is true for boxes (partially) inside.
+    /// Several boxes are tested at once if SIMD is enabled.
+    void IsInsideFast(const BoundingBoxSoA& boxes, ea::vector<bool>& result) const;
+
     /// Return distance of a point to the frustum, or 0 if inside.
     float Distance(const Vector3& point) const
     {
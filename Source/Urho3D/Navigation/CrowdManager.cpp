@@ -412,6 +412,13 @@ void CrowdManager::FindPath(ea::vector<Vector3>& dest, const Vector3& start, con
         navigationMesh_->FindPath(dest, start, end, Vector3(crowd_->getQueryExtents()), crowd_->getFilter(queryFilterType));
 }
 
+unsigned CrowdManager::FindPathAsync(const Vector3& start, const Vector3& end, int queryFilterType)
+{
+    if (crowd_ && navigationMesh_)
+        return navigationMesh_->FindPathAsync(start, end, Vector3(crowd_->getQueryExtents()), crowd_->getFilter(queryFilterType));
+    return 0;
+}
+
 Vector3 CrowdManager::GetRandomPoint(int queryFilterType, dtPolyRef* randomRef)
 {
     if (randomRef)
@@ -123,6 +123,9 @@ public:
     Vector3 MoveAlongSurface(const Vector3& start, const Vector3& end, int queryFilterType, int maxVisited = 3);
     /// Find a path between world space points using the crowd initialized query extent (based on maxAgentRadius) and the specified query filter type. Return non-empty list of points if successful.
     void FindPath(ea::vector<Vector3>& dest, const Vector3& start, const Vector3& end, int queryFilterType);
+    /// Submit asynchronous path request to the navigation mesh using the crowd initialized query extent (based on maxAgentRadius) and the specified query filter type. Return handle of the request, or 0 if failed.
+    /// Results are delivered by the navigation mesh in E_NAVIGATION_PATHS_FOUND event.
+    unsigned FindPathAsync(const Vector3& start, const Vector3& end, int queryFilterType);
     /// Return a random point on the navigation mesh using the crowd initialized query extent (based on maxAgentRadius) and the specified query filter type.
     Vector3 GetRandomPoint(int queryFilterType, dtPolyRef* randomRef = nullptr);
     /// Return a random point on the navigation mesh within a circle using the crowd initialized query extent (based on maxAgentRadius) and the specified query filter type. The circle radius is only a guideline and in practice the returned point may be further away.
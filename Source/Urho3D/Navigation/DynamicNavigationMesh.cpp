@@ -429,27 +429,14 @@ bool DynamicNavigationMesh::Build()
         }
 
         // Build each tile
-        unsigned numTiles = 0;
-
-        for (int z = 0; z < numTilesZ_; ++z)
+        bool aborted = false;
+        unsigned numTiles = BuildTiles(geometryList, IntVector2::ZERO, GetNumTiles() - IntVector2::ONE, &aborted);
+        if (aborted)
         {
-            for (int x = 0; x < numTilesX_; ++x)
-            {
-                TileCacheData tiles[TILECACHE_MAXLAYERS];
-                int layerCt = BuildTile(geometryList, x, z, tiles);
-                for (int i = 0; i < layerCt; ++i)
-                {
-                    dtCompressedTileRef tileRef;
-                    int status = tileCache_->addTile(tiles[i].data, tiles[i].dataSize, DT_COMPRESSEDTILE_FREE_DATA, &tileRef);
-                    if (dtStatusFailed((dtStatus)status))
-                    {
-                        dtFree(tiles[i].data);
-                        tiles[i].data = nullptr;
-                    }
-                }
-                tileCache_->buildNavMeshTilesAt(x, z, navMesh_);
-                ++numTiles;
-            }
+            // Don't leave partially built mesh behind
+            URHO3D_LOGDEBUG("Navigation mesh build aborted after " + ea::to_string(numTiles) + " tiles");
+            ReleaseNavigationMesh();
+            return false;
         }
 
         // For a full build it's necessary to update the nav mesh
@@ -543,7 +530,8 @@ bool DynamicNavigationMesh::Build(const IntVector2& from, const IntVector2& to)
 ea::vector<unsigned char> DynamicNavigationMesh::GetTileData(const IntVector2& tile) const
 {
     VectorBuffer ret;
-    WriteTiles(ret, tile.x_, tile.y_);
+    if (tileCache_)
+        WriteTiles(ret, tile.x_, tile.y_);
     return ret.GetBuffer();
 }
 
@@ -819,46 +807,11 @@ bool DynamicNavigationMesh::ReadTiles(Deserializer& source, bool silent)
     return true;
 }
 
-int DynamicNavigationMesh::BuildTile(ea::vector<NavigationGeometryInfo>& geometryList, int x, int z, TileCacheData* tiles)
+int DynamicNavigationMesh::BuildTileLayers(DynamicNavBuildData& build, const rcConfig& cfg, const IntVector2& tile,
+    TileCacheData* tiles) const
 {
     URHO3D_PROFILE("BuildNavigationMeshTile");
 
-    tileCache_->removeTile(navMesh_->getTileRefAt(x, z, 0), nullptr, nullptr);
-
-    const BoundingBox tileBoundingBox = GetTileBoundingBox(IntVector2(x, z));
-
-    DynamicNavBuildData build(allocator_.get());
-
-    rcConfig cfg;   // NOLINT(hicpp-member-init)
-    memset(&cfg, 0, sizeof cfg);
-    cfg.cs = cellSize_;
-    cfg.ch = cellHeight_;
-    cfg.walkableSlopeAngle = agentMaxSlope_;
-    cfg.walkableHeight = (int)ceilf(agentHeight_ / cfg.ch);
-    cfg.walkableClimb = (int)floorf(agentMaxClimb_ / cfg.ch);
-    cfg.walkableRadius = (int)ceilf(agentRadius_ / cfg.cs);
-    cfg.maxEdgeLen = (int)(edgeMaxLength_ / cellSize_);
-    cfg.maxSimplificationError = edgeMaxError_;
-    cfg.minRegionArea = (int)sqrtf(regionMinSize_);
-    cfg.mergeRegionArea = (int)sqrtf(regionMergeSize_);
-    cfg.maxVertsPerPoly = 6;
-    cfg.tileSize = tileSize_;
-    cfg.borderSize = cfg.walkableRadius + 3; // Add padding
-    cfg.width = cfg.tileSize + cfg.borderSize * 2;
-    cfg.height = cfg.tileSize + cfg.borderSize * 2;
-    cfg.detailSampleDist = detailSampleDistance_ < 0.9f ? 0.0f : cellSize_ * detailSampleDistance_;
-    cfg.detailSampleMaxError = cellHeight_ * detailSampleMaxError_;
-
-    rcVcopy(cfg.bmin, &tileBoundingBox.min_.x_);
-    rcVcopy(cfg.bmax, &tileBoundingBox.max_.x_);
-    cfg.bmin[0] -= cfg.borderSize * cfg.cs;
-    cfg.bmin[2] -= cfg.borderSize * cfg.cs;
-    cfg.bmax[0] += cfg.borderSize * cfg.cs;
-    cfg.bmax[2] += cfg.borderSize * cfg.cs;
-
-    BoundingBox expandedBox(*reinterpret_cast<Vector3*>(cfg.bmin), *reinterpret_cast<Vector3*>(cfg.bmax));
-    GetTileGeometry(&build, geometryList, expandedBox);
-
     if (build.vertices_.empty() || build.indices_.empty())
         return 0; // Nothing to do
 
@@ -952,11 +905,13 @@ int DynamicNavigationMesh::BuildTile(ea::vector<NavigationGeometryInfo>& geometr
     int retCt = 0;
     for (int i = 0; i < build.heightFieldLayers_->nlayers; ++i)
     {
+        // Header is serialized as is, clear padding bytes too
         dtTileCacheLayerHeader header;      // NOLINT(hicpp-member-init)
+        memset(&header, 0, sizeof(header));
         header.magic = DT_TILECACHE_MAGIC;
         header.version = DT_TILECACHE_VERSION;
-        header.tx = x;
-        header.ty = z;
+        header.tx = tile.x_;
+        header.ty = tile.y_;
         header.tlayer = i;
 
         rcHeightfieldLayer* layer = &build.heightFieldLayers_->layers[i];
@@ -984,57 +939,89 @@ int DynamicNavigationMesh::BuildTile(ea::vector<NavigationGeometryInfo>& geometr
             ++retCt;
     }
 
-    // Send a notification of the rebuild of this tile to anyone interested
-    {
-        using namespace NavigationAreaRebuilt;
-        VariantMap& eventData = GetContext()->GetEventDataMap();
-        eventData[P_NODE] = GetNode();
-        eventData[P_MESH] = this;
-        eventData[P_BOUNDSMIN] = Variant(tileBoundingBox.min_);
-        eventData[P_BOUNDSMAX] = Variant(tileBoundingBox.max_);
-        SendEvent(E_NAVIGATION_AREA_REBUILT, eventData);
-    }
-
     return retCt;
 }
 
-unsigned DynamicNavigationMesh::BuildTiles(ea::vector<NavigationGeometryInfo>& geometryList, const IntVector2& from, const IntVector2& to)
+unsigned DynamicNavigationMesh::BuildTiles(ea::vector<NavigationGeometryInfo>& geometryList, const IntVector2& from, const IntVector2& to,
+    bool* aborted)
 {
+    struct TileBuildTask
+    {
+        explicit TileBuildTask(dtTileCacheAlloc* allocator) : build_(allocator) {}
+
+        IntVector2 tile_;
+        rcConfig cfg_;
+        DynamicNavBuildData build_;
+        TileCacheData tiles_[TILECACHE_MAXLAYERS];
+        int numLayers_{};
+    };
+
+    ea::vector<ea::unique_ptr<TileBuildTask>> tasks(GetTileBatchSize());
     unsigned numTiles = 0;
 
-    for (int z = from.y_; z <= to.y_; ++z)
+    const auto prepare = [&](unsigned index, const IntVector2& tile)
     {
-        for (int x = from.x_; x <= to.x_; ++x)
+        dtCompressedTileRef existing[TILECACHE_MAXLAYERS];
+        const int existingCt = tileCache_->getTilesAt(tile.x_, tile.y_, existing, maxLayers_);
+        for (int i = 0; i < existingCt; ++i)
         {
-            dtCompressedTileRef existing[TILECACHE_MAXLAYERS];
-            const int existingCt = tileCache_->getTilesAt(x, z, existing, maxLayers_);
-            for (int i = 0; i < existingCt; ++i)
+            unsigned char* data = nullptr;
+            if (!dtStatusFailed(tileCache_->removeTile(existing[i], &data, nullptr)) && data != nullptr)
+                dtFree(data);
+        }
+
+        tasks[index] = ea::make_unique<TileBuildTask>(allocator_.get());
+        TileBuildTask& task = *tasks[index];
+        task.tile_ = tile;
+        BoundingBox expandedBox = InitializeTileConfig(task.cfg_, tile);
+        GetTileGeometry(&task.build_, geometryList, expandedBox);
+    };
+
+    const auto build = [&](unsigned index)
+    {
+        TileBuildTask& task = *tasks[index];
+        task.numLayers_ = BuildTileLayers(task.build_, task.cfg_, task.tile_, task.tiles_);
+    };
+
+    const auto commit = [&](unsigned index)
+    {
+        TileBuildTask& task = *tasks[index];
+        for (int i = 0; i < task.numLayers_; ++i)
+        {
+            TileCacheData& tileData = task.tiles_[i];
+            dtCompressedTileRef tileRef;
+            int status = tileCache_->addTile(tileData.data, tileData.dataSize, DT_COMPRESSEDTILE_FREE_DATA, &tileRef);
+            if (dtStatusFailed((dtStatus)status))
             {
-                unsigned char* data = nullptr;
-                if (!dtStatusFailed(tileCache_->removeTile(existing[i], &data, nullptr)) && data != nullptr)
-                    dtFree(data);
+                dtFree(tileData.data);
+                tileData.data = nullptr;
             }
-
-            TileCacheData tiles[TILECACHE_MAXLAYERS];
-            int layerCt = BuildTile(geometryList, x, z, tiles);
-            for (int i = 0; i < layerCt; ++i)
+            else
             {
-                dtCompressedTileRef tileRef;
-                int status = tileCache_->addTile(tiles[i].data, tiles[i].dataSize, DT_COMPRESSEDTILE_FREE_DATA, &tileRef);
-                if (dtStatusFailed((dtStatus)status))
-                {
-                    dtFree(tiles[i].data);
-                    tiles[i].data = nullptr;
-                }
-                else
-                {
-                    tileCache_->buildNavMeshTile(tileRef, navMesh_);
-                    ++numTiles;
-                }
+                tileCache_->buildNavMeshTile(tileRef, navMesh_);
+                ++numTiles;
             }
         }
-    }
 
+        // Send a notification of the rebuild of this tile to anyone interested
+        if (task.numLayers_ > 0)
+        {
+            const BoundingBox tileBoundingBox = GetTileBoundingBox(task.tile_);
+
+            using namespace NavigationAreaRebuilt;
+            VariantMap& eventData = GetContext()->GetEventDataMap();
+            eventData[P_NODE] = GetNode();
+            eventData[P_MESH] = this;
+            eventData[P_BOUNDSMIN] = Variant(tileBoundingBox.min_);
+            eventData[P_BOUNDSMAX] = Variant(tileBoundingBox.max_);
+            SendEvent(E_NAVIGATION_AREA_REBUILT, eventData);
+        }
+        tasks[index] = nullptr;
+    };
+
+    const bool completed = ProcessTileBatches(from, to, prepare, build, commit);
+    if (aborted)
+        *aborted = !completed;
     return numTiles;
 }
 
@@ -39,6 +39,7 @@ namespace Urho3D
 
 class OffMeshConnection;
 class Obstacle;
+struct DynamicNavBuildData;
 
 class URHO3D_API DynamicNavigationMesh : public NavigationMesh
 {
@@ -65,6 +66,7 @@ public:
     bool Build(const BoundingBox& boundingBox) override;
     /// Rebuild part of the navigation mesh in the rectangular area. Return true if successful.
     bool Build(const IntVector2& from, const IntVector2& to) override;
+    using NavigationMesh::Build;
     /// Return tile data.
     ea::vector<unsigned char> GetTileData(const IntVector2& tile) const override;
     /// Return whether the Obstacle is touching the given tile.
@@ -122,10 +124,12 @@ protected:
     /// Used by Obstacle class to remove itself from the tile cache, if 'silent' an event will not be raised.
     void RemoveObstacle(Obstacle* obstacle, bool silent = false);
 
-    /// Build one tile of the navigation mesh. Return true if successful.
-    int BuildTile(ea::vector<NavigationGeometryInfo>& geometryList, int x, int z, TileCacheData* tiles);
-    /// Build tiles in the rectangular area. Return number of built tiles.
-    unsigned BuildTiles(ea::vector<NavigationGeometryInfo>& geometryList, const IntVector2& from, const IntVector2& to);
+    /// Build compressed layers of one tile from collected geometry. Doesn't modify the tile cache and is safe to call from worker threads.
+    /// Return number of built layers.
+    int BuildTileLayers(DynamicNavBuildData& build, const rcConfig& cfg, const IntVector2& tile, TileCacheData* tiles) const;
+    /// Build tiles in the rectangular area. Return number of built tiles. Optionally output whether the build was aborted by stop token.
+    unsigned BuildTiles(ea::vector<NavigationGeometryInfo>& geometryList, const IntVector2& from, const IntVector2& to,
+        bool* aborted = nullptr);
     /// Off-mesh connections to be rebuilt in the mesh processor.
     ea::vector<OffMeshConnection*> CollectOffMeshConnections(const BoundingBox& bounds);
     /// Release the navigation mesh, query, and tile cache.
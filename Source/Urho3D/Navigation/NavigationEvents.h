@@ -66,6 +66,22 @@ URHO3D_EVENT(E_NAVIGATION_ALL_TILES_REMOVED, NavigationAllTilesRemoved)
     URHO3D_PARAM(P_MESH, Mesh); // NavigationMesh pointer
 }
 
+/// Batch of mesh tiles is processed during navigation mesh build.
+URHO3D_EVENT(E_NAVIGATION_BUILD_PROGRESS, NavigationBuildProgress)
+{
+    URHO3D_PARAM(P_NODE, Node); // Node pointer
+    URHO3D_PARAM(P_MESH, Mesh); // NavigationMesh pointer
+    URHO3D_PARAM(P_NUMPROCESSED, NumProcessed); // int
+    URHO3D_PARAM(P_NUMTOTAL, NumTotal); // int
+}
+
+/// Batch of asynchronous path requests is processed. Results are available via NavigationMesh::GetPathResults().
+URHO3D_EVENT(E_NAVIGATION_PATHS_FOUND, NavigationPathsFound)
+{
+    URHO3D_PARAM(P_NODE, Node); // Node pointer
+    URHO3D_PARAM(P_MESH, Mesh); // NavigationMesh pointer
+}
+
 /// Crowd agent formation.
 URHO3D_EVENT(E_CROWD_AGENT_FORMATION, CrowdAgentFormation)
 {
@@ -24,6 +24,8 @@
 
 #include "../Core/Context.h"
 #include "../Core/Profiler.h"
+#include "../Core/Timer.h"
+#include "../Core/WorkQueue.h"
 #include "../Graphics/DebugRenderer.h"
 #include "../Graphics/Drawable.h"
 #include "../Graphics/Geometry.h"
@@ -46,6 +48,7 @@
 #include "../Physics/CollisionShape.h"
 #endif
 #include "../Scene/Scene.h"
+#include "../Scene/SceneEvents.h"
 
 #include <cfloat>
 #include <Detour/DetourNavMesh.h>
@@ -97,6 +100,65 @@ struct FindPathData
     unsigned char pathFlags_[MAX_POLYS]{};
 };
 
+/// Pending asynchronous path request.
+struct PathRequest
+{
+    /// Handle of the request.
+    unsigned handle_{};
+    /// World-space start point.
+    Vector3 start_;
+    /// World-space end point.
+    Vector3 end_;
+    /// Query extents.
+    Vector3 extents_;
+    /// Copy of the query filter, so the request doesn't depend on filter lifetime.
+    dtQueryFilter filter_;
+};
+
+/// Queue of asynchronous path requests with per-thread queries.
+struct PathRequestQueue
+{
+    /// Destruct.
+    ~PathRequestQueue() { ReleaseQueries(); }
+
+    /// Ensure that queries for all threads are initialized. Return true if successful.
+    bool InitializeQueries(dtNavMesh* navMesh, unsigned numThreads)
+    {
+        if (queries_.size() >= numThreads)
+            return true;
+
+        while (queries_.size() < numThreads)
+        {
+            dtNavMeshQuery* query = dtAllocNavMeshQuery();
+            if (!query || dtStatusFailed(query->init(navMesh, MAX_POLYS)))
+            {
+                URHO3D_LOGERROR("Could not create navigation mesh query");
+                dtFreeNavMeshQuery(query);
+                return false;
+            }
+            queries_.push_back(query);
+            pathData_.push_back(ea::make_unique<FindPathData>());
+        }
+        return true;
+    }
+
+    /// Release queries when the navigation mesh is released.
+    void ReleaseQueries()
+    {
+        for (dtNavMeshQuery* query : queries_)
+            dtFreeNavMeshQuery(query);
+        queries_.clear();
+        pathData_.clear();
+    }
+
+    /// Pending requests in submission order.
+    ea::vector<PathRequest> requests_;
+    /// Queries indexed by WorkQueue thread index.
+    ea::vector<dtNavMeshQuery*> queries_;
+    /// Temporary path data indexed by WorkQueue thread index.
+    ea::vector<ea::unique_ptr<FindPathData>> pathData_;
+};
+
 NavigationMesh::NavigationMesh(Context* context) :
     Component(context),
     navMesh_(nullptr),
@@ -122,7 +184,8 @@ NavigationMesh::NavigationMesh(Context* context) :
     partitionType_(NAVMESH_PARTITION_WATERSHED),
     keepInterResults_(false),
     drawOffMeshConnections_(false),
-    drawNavAreas_(false)
+    drawNavAreas_(false),
+    pathRequests_(new PathRequestQueue())
 {
 }
 
@@ -445,7 +508,15 @@ bool NavigationMesh::Build()
         }
 
         // Build each tile
-        unsigned numTiles = BuildTiles(geometryList, IntVector2::ZERO, GetNumTiles() - IntVector2::ONE);
+        bool aborted = false;
+        unsigned numTiles = BuildTiles(geometryList, IntVector2::ZERO, GetNumTiles() - IntVector2::ONE, &aborted);
+        if (aborted)
+        {
+            // Don't leave partially built mesh behind
+            URHO3D_LOGDEBUG("Navigation mesh build aborted after " + ea::to_string(numTiles) + " tiles");
+            ReleaseNavigationMesh();
+            return false;
+        }
 
         URHO3D_LOGDEBUG("Built navigation mesh with " + ea::to_string(numTiles) + " tiles");
 
@@ -521,10 +592,19 @@ bool NavigationMesh::Build(const IntVector2& from, const IntVector2& to)
     return true;
 }
 
+bool NavigationMesh::Build(StopToken stopToken)
+{
+    buildStopToken_ = stopToken;
+    const bool success = Build();
+    buildStopToken_ = StopToken{};
+    return success;
+}
+
 ea::vector<unsigned char> NavigationMesh::GetTileData(const IntVector2& tile) const
 {
     VectorBuffer ret;
-    WriteTile(ret, tile.x_, tile.y_);
+    if (navMesh_)
+        WriteTile(ret, tile.x_, tile.y_);
     return ret.GetBuffer();
 }
 
@@ -674,14 +754,131 @@ void NavigationMesh::FindPath(ea::vector<NavigationPathPoint>& dest, const Vecto
     const Matrix3x4& transform = node_->GetWorldTransform();
     Matrix3x4 inverse = transform.Inverse();
 
-    Vector3 localStart = inverse * start;
-    Vector3 localEnd = inverse * end;
+    FindWorldPath(dest, navMeshQuery_, *pathData_, transform, inverse * start, inverse * end, extents,
+        filter ? filter : queryFilter_.get());
+    AssignPathAreas(dest);
+}
+
+unsigned NavigationMesh::FindPathAsync(const Vector3& start, const Vector3& end, const Vector3& extents,
+    const dtQueryFilter* filter)
+{
+    Scene* scene = GetScene();
+    if (!scene)
+    {
+        URHO3D_LOGERROR("Navigation mesh must be added to the scene to process asynchronous path requests");
+        return 0;
+    }
+
+    if (!HasSubscribedToEvent(scene, E_SCENEPOSTUPDATE))
+        SubscribeToEvent(scene, E_SCENEPOSTUPDATE, URHO3D_HANDLER(NavigationMesh, HandleScenePostUpdate));
+
+    PathRequest& request = pathRequests_->requests_.emplace_back();
+    request.handle_ = nextPathRequestHandle_;
+    request.start_ = start;
+    request.end_ = end;
+    request.extents_ = extents;
+    request.filter_ = filter ? *filter : *queryFilter_;
+
+    // Skip 0 on overflow, it's reserved for invalid handle
+    nextPathRequestHandle_ = ea::max(1u, nextPathRequestHandle_ + 1);
+    return request.handle_;
+}
+
+void NavigationMesh::CancelPathRequest(unsigned handle)
+{
+    auto& requests = pathRequests_->requests_;
+    const auto iter = ea::find_if(requests.begin(), requests.end(),
+        [&](const PathRequest& request) { return request.handle_ == handle; });
+    if (iter != requests.end())
+        requests.erase(iter);
+}
+
+void NavigationMesh::ProcessPathRequests(unsigned maxTimeUSec)
+{
+    URHO3D_PROFILE("ProcessPathRequests");
+
+    pathResults_.clear();
+    auto& requests = pathRequests_->requests_;
+    if (requests.empty())
+        return;
+
+    auto workQueue = GetSubsystem<WorkQueue>();
+    const unsigned numThreads = workQueue ? WorkQueue::GetMaxThreadIndex() : 1;
+    const bool queriesReady = node_ && navMesh_ && pathRequests_->InitializeQueries(navMesh_, numThreads);
+
+    // Navigation data is in local space. Transform path points from world to local
+    const Matrix3x4 transform = node_ ? node_->GetWorldTransform() : Matrix3x4::IDENTITY;
+    const Matrix3x4 inverse = transform.Inverse();
+
+    const auto processRequest = [&](unsigned index)
+    {
+        const PathRequest& request = requests[index];
+        NavigationPathResult& result = pathResults_[index];
+        result.handle_ = request.handle_;
+        if (!queriesReady)
+            return;
+
+        const unsigned threadIndex = workQueue ? WorkQueue::GetThreadIndex() : 0;
+        FindWorldPath(result.path_, pathRequests_->queries_[threadIndex], *pathRequests_->pathData_[threadIndex],
+            transform, inverse * request.start_, inverse * request.end_, request.extents_, &request.filter_);
+    };
+
+    // Several requests per thread to smooth out uneven path lengths
+    static const unsigned requestsPerThread = 8;
+    const unsigned batchSize = numThreads * requestsPerThread;
+    const unsigned numRequests = requests.size();
+
+    HiresTimer timer;
+    unsigned numProcessed = 0;
+    do
+    {
+        const unsigned batchBegin = numProcessed;
+        numProcessed = ea::min(batchBegin + batchSize, numRequests);
+        pathResults_.resize(numProcessed);
+
+        if (workQueue)
+        {
+            ForEachParallel(workQueue, 1, numProcessed - batchBegin, [&](unsigned beginIndex, unsigned endIndex)
+            {
+                for (unsigned index = beginIndex; index < endIndex; ++index)
+                    processRequest(batchBegin + index);
+            });
+        }
+        else
+        {
+            for (unsigned index = batchBegin; index < numProcessed; ++index)
+                processRequest(index);
+        }
+    } while (numProcessed < numRequests && timer.GetUSec(false) < maxTimeUSec);
+
+    requests.erase(requests.begin(), requests.begin() + numProcessed);
+
+    // NavArea components are not thread-safe, assign areas in main thread
+    for (NavigationPathResult& result : pathResults_)
+        AssignPathAreas(result.path_);
+
+    using namespace NavigationPathsFound;
+    VariantMap& eventData = GetContext()->GetEventDataMap();
+    eventData[P_NODE] = GetNode();
+    eventData[P_MESH] = this;
+    SendEvent(E_NAVIGATION_PATHS_FOUND, eventData);
+}
+
+unsigned NavigationMesh::GetNumPendingPathRequests() const
+{
+    return pathRequests_->requests_.size();
+}
+
+void NavigationMesh::FindWorldPath(ea::vector<NavigationPathPoint>& dest, dtNavMeshQuery* query, FindPathData& pathData,
+    const Matrix3x4& transform, const Vector3& localStart, const Vector3& localEnd, const Vector3& extents,
+    const dtQueryFilter* filter)
+{
+    dest.clear();
 
-    const dtQueryFilter* queryFilter = filter ? filter : queryFilter_.get();
     dtPolyRef startRef;
     dtPolyRef endRef;
-    navMeshQuery_->findNearestPoly(&localStart.x_, &extents.x_, queryFilter, &startRef, nullptr);
-    navMeshQuery_->findNearestPoly(&localEnd.x_, &extents.x_, queryFilter, &endRef, nullptr);
+    query->findNearestPoly(&localStart.x_, &extents.x_, filter, &startRef, nullptr);
+    query->findNearestPoly(&localEnd.x_, &extents.x_, filter, &endRef, nullptr);
 
     if (!startRef || !endRef)
         return;
@@ -689,27 +886,34 @@ void NavigationMesh::FindPath(ea::vector<NavigationPathPoint>& dest, const Vecto
     int numPolys = 0;
     int numPathPoints = 0;
 
-    navMeshQuery_->findPath(startRef, endRef, &localStart.x_, &localEnd.x_, queryFilter, pathData_->polys_, &numPolys,
-        MAX_POLYS);
+    query->findPath(startRef, endRef, &localStart.x_, &localEnd.x_, filter, pathData.polys_, &numPolys, MAX_POLYS);
     if (!numPolys)
         return;
 
     Vector3 actualLocalEnd = localEnd;
 
     // If full path was not found, clamp end point to the end polygon
-    if (pathData_->polys_[numPolys - 1] != endRef)
-        navMeshQuery_->closestPointOnPoly(pathData_->polys_[numPolys - 1], &localEnd.x_, &actualLocalEnd.x_, nullptr);
+    if (pathData.polys_[numPolys - 1] != endRef)
+        query->closestPointOnPoly(pathData.polys_[numPolys - 1], &localEnd.x_, &actualLocalEnd.x_, nullptr);
 
-    navMeshQuery_->findStraightPath(&localStart.x_, &actualLocalEnd.x_, pathData_->polys_, numPolys,
-        &pathData_->pathPoints_[0].x_, pathData_->pathFlags_, pathData_->pathPolys_, &numPathPoints, MAX_POLYS);
+    query->findStraightPath(&localStart.x_, &actualLocalEnd.x_, pathData.polys_, numPolys,
+        &pathData.pathPoints_[0].x_, pathData.pathFlags_, pathData.pathPolys_, &numPathPoints, MAX_POLYS);
 
     // Transform path result back to world space
     for (int i = 0; i < numPathPoints; ++i)
     {
         NavigationPathPoint pt;
-        pt.position_ = transform * pathData_->pathPoints_[i];
-        pt.flag_ = (NavigationPathPointFlag)pathData_->pathFlags_[i];
+        pt.position_ = transform * pathData.pathPoints_[i];
+        pt.flag_ = (NavigationPathPointFlag)pathData.pathFlags_[i];
+        pt.areaID_ = 0;
+        dest.push_back(pt);
+    }
+}
 
+void NavigationMesh::AssignPathAreas(ea::vector<NavigationPathPoint>& path)
+{
+    for (NavigationPathPoint& pt : path)
+    {
         // Walk through all NavAreas and find nearest
         unsigned nearestNavAreaID = 0;       // 0 is the default nav area ID
         float nearestDistance = M_LARGE_VALUE;
@@ -732,11 +936,14 @@ void NavigationMesh::FindPath(ea::vector<NavigationPathPoint>& dest, const Vecto
             }
         }
         pt.areaID_ = (unsigned char)nearestNavAreaID;
-
-        dest.push_back(pt);
     }
 }
 
+void NavigationMesh::HandleScenePostUpdate(StringHash eventType, VariantMap& eventData)
+{
+    ProcessPathRequests(maxPathRequestTime_);
+}
+
 Vector3 NavigationMesh::GetRandomPoint(const dtQueryFilter* filter, dtPolyRef* randomRef)
 {
     if (!InitializeQuery())
@@ -1299,18 +1506,10 @@ bool NavigationMesh::ReadTile(Deserializer& source, bool silent)
     return true;
 }
 
-bool NavigationMesh::BuildTile(ea::vector<NavigationGeometryInfo>& geometryList, int x, int z)
+BoundingBox NavigationMesh::InitializeTileConfig(rcConfig& cfg, const IntVector2& tile) const
 {
-    URHO3D_PROFILE("BuildNavigationMeshTile");
-
-    // Remove previous tile (if any)
-    navMesh_->removeTile(navMesh_->getTileRefAt(x, z, 0), nullptr, nullptr);
-
-    const BoundingBox tileBoundingBox = GetTileBoundingBox(IntVector2(x, z));
-
-    SimpleNavBuildData build;
+    const BoundingBox tileBoundingBox = GetTileBoundingBox(tile);
 
-    rcConfig cfg;       // NOLINT(hicpp-member-init)
     memset(&cfg, 0, sizeof cfg);
     cfg.cs = cellSize_;
     cfg.ch = cellHeight_;
@@ -1337,8 +1536,16 @@ bool NavigationMesh::BuildTile(ea::vector<NavigationGeometryInfo>& geometryList,
     cfg.bmax[0] += cfg.borderSize * cfg.cs;
     cfg.bmax[2] += cfg.borderSize * cfg.cs;
 
-    BoundingBox expandedBox(*reinterpret_cast<Vector3*>(cfg.bmin), *reinterpret_cast<Vector3*>(cfg.bmax));
-    GetTileGeometry(&build, geometryList, expandedBox);
+    return BoundingBox(*reinterpret_cast<Vector3*>(cfg.bmin), *reinterpret_cast<Vector3*>(cfg.bmax));
+}
+
+bool NavigationMesh::BuildTileData(SimpleNavBuildData& build, const rcConfig& cfg, const IntVector2& tile,
+    unsigned char*& navData, int& navDataSize) const
+{
+    URHO3D_PROFILE("BuildNavigationMeshTile");
+
+    navData = nullptr;
+    navDataSize = 0;
 
     if (build.vertices_.empty() || build.indices_.empty())
         return true; // Nothing to do
@@ -1462,9 +1669,6 @@ bool NavigationMesh::BuildTile(ea::vector<NavigationGeometryInfo>& geometryList,
             build.polyMesh_->flags[i] = 0x1;
     }
 
-    unsigned char* navData = nullptr;
-    int navDataSize = 0;
-
     dtNavMeshCreateParams params;       // NOLINT(hicpp-member-init)
     memset(&params, 0, sizeof params);
     params.verts = build.polyMesh_->verts;
@@ -1482,8 +1686,8 @@ bool NavigationMesh::BuildTile(ea::vector<NavigationGeometryInfo>& geometryList,
     params.walkableHeight = agentHeight_;
     params.walkableRadius = agentRadius_;
     params.walkableClimb = agentMaxClimb_;
-    params.tileX = x;
-    params.tileY = z;
+    params.tileX = tile.x_;
+    params.tileY = tile.y_;
     rcVcopy(params.bmin, build.polyMesh_->bmin);
     rcVcopy(params.bmax, build.polyMesh_->bmax);
     params.cs = cfg.cs;
@@ -1507,6 +1711,11 @@ bool NavigationMesh::BuildTile(ea::vector<NavigationGeometryInfo>& geometryList,
         return false;
     }
 
+    return true;
+}
+
+bool NavigationMesh::AddTileData(unsigned char* navData, int navDataSize, const IntVector2& tile)
+{
     if (dtStatusFailed(navMesh_->addTile(navData, navDataSize, DT_TILE_FREE_DATA, 0, nullptr)))
     {
         URHO3D_LOGERROR("Failed to add navigation mesh tile");
@@ -1516,6 +1725,8 @@ bool NavigationMesh::BuildTile(ea::vector<NavigationGeometryInfo>& geometryList,
 
     // Send a notification of the rebuild of this tile to anyone interested
     {
+        const BoundingBox tileBoundingBox = GetTileBoundingBox(tile);
+
         using namespace NavigationAreaRebuilt;
         VariantMap& eventData = GetContext()->GetEventDataMap();
         eventData[P_NODE] = GetNode();
@@ -1527,19 +1738,117 @@ bool NavigationMesh::BuildTile(ea::vector<NavigationGeometryInfo>& geometryList,
     return true;
 }
 
-unsigned NavigationMesh::BuildTiles(ea::vector<NavigationGeometryInfo>& geometryList, const IntVector2& from, const IntVector2& to)
+unsigned NavigationMesh::BuildTiles(ea::vector<NavigationGeometryInfo>& geometryList, const IntVector2& from, const IntVector2& to,
+    bool* aborted)
 {
+    struct TileBuildTask
+    {
+        IntVector2 tile_;
+        rcConfig cfg_;
+        SimpleNavBuildData build_;
+        unsigned char* navData_{};
+        int navDataSize_{};
+        bool success_{};
+    };
+
+    ea::vector<ea::unique_ptr<TileBuildTask>> tasks(GetTileBatchSize());
     unsigned numTiles = 0;
 
-    for (int z = from.y_; z <= to.y_; ++z)
+    const auto prepare = [&](unsigned index, const IntVector2& tile)
     {
-        for (int x = from.x_; x <= to.x_; ++x)
+        // Remove previous tile (if any)
+        navMesh_->removeTile(navMesh_->getTileRefAt(tile.x_, tile.y_, 0), nullptr, nullptr);
+
+        tasks[index] = ea::make_unique<TileBuildTask>();
+        TileBuildTask& task = *tasks[index];
+        task.tile_ = tile;
+        BoundingBox expandedBox = InitializeTileConfig(task.cfg_, tile);
+        GetTileGeometry(&task.build_, geometryList, expandedBox);
+    };
+
+    const auto build = [&](unsigned index)
+    {
+        TileBuildTask& task = *tasks[index];
+        task.success_ = BuildTileData(task.build_, task.cfg_, task.tile_, task.navData_, task.navDataSize_);
+    };
+
+    const auto commit = [&](unsigned index)
+    {
+        TileBuildTask& task = *tasks[index];
+        if (task.success_ && (!task.navData_ || AddTileData(task.navData_, task.navDataSize_, task.tile_)))
+            ++numTiles;
+        tasks[index] = nullptr;
+    };
+
+    const bool completed = ProcessTileBatches(from, to, prepare, build, commit);
+    if (aborted)
+        *aborted = !completed;
+    return numTiles;
+}
+
+bool NavigationMesh::ProcessTileBatches(const IntVector2& from, const IntVector2& to,
+    const ea::function<void(unsigned index, const IntVector2& tile)>& prepare,
+    const ea::function<void(unsigned index)>& build, const ea::function<void(unsigned index)>& commit)
+{
+    if (from.x_ > to.x_ || from.y_ > to.y_)
+        return true;
+
+    auto workQueue = GetSubsystem<WorkQueue>();
+    const unsigned width = static_cast<unsigned>(to.x_ - from.x_ + 1);
+    const unsigned numTotal = width * static_cast<unsigned>(to.y_ - from.y_ + 1);
+    const unsigned batchSize = GetTileBatchSize();
+
+    for (unsigned batchBegin = 0; batchBegin < numTotal; batchBegin += batchSize)
+    {
+        if (buildStopToken_.IsStopped())
+            return false;
+
+        const unsigned batchEnd = ea::min(batchBegin + batchSize, numTotal);
+        const unsigned batchLength = batchEnd - batchBegin;
+
+        // Scene is not thread-safe, collect geometry in main thread
+        for (unsigned index = 0; index < batchLength; ++index)
         {
-            if (BuildTile(geometryList, x, z))
-                ++numTiles;
+            const unsigned tileIndex = batchBegin + index;
+            prepare(index, from + IntVector2(static_cast<int>(tileIndex % width), static_cast<int>(tileIndex / width)));
         }
+
+        if (workQueue)
+        {
+            ForEachParallel(workQueue, 1, batchLength, [&](unsigned beginIndex, unsigned endIndex)
+            {
+                for (unsigned index = beginIndex; index < endIndex; ++index)
+                    build(index);
+            });
+        }
+        else
+        {
+            for (unsigned index = 0; index < batchLength; ++index)
+                build(index);
+        }
+
+        // Keep tile insertion order independent of thread scheduling
+        for (unsigned index = 0; index < batchLength; ++index)
+            commit(index);
+
+        using namespace NavigationBuildProgress;
+        VariantMap& eventData = GetContext()->GetEventDataMap();
+        eventData[P_NODE] = GetNode();
+        eventData[P_MESH] = this;
+        eventData[P_NUMPROCESSED] = batchEnd;
+        eventData[P_NUMTOTAL] = numTotal;
+        SendEvent(E_NAVIGATION_BUILD_PROGRESS, eventData);
     }
-    return numTiles;
+    return true;
+}
+
+unsigned NavigationMesh::GetTileBatchSize() const
+{
+    // Several tiles per thread to smooth out uneven tile complexity
+    static const unsigned tilesPerThread = 4;
+    auto workQueue = GetSubsystem<WorkQueue>();
+    const unsigned numThreads = workQueue ? workQueue->GetNumThreads() + 1 : 1;
+    return numThreads * tilesPerThread;
 }
 
 bool NavigationMesh::InitializeQuery()
@@ -1574,6 +1883,8 @@ void NavigationMesh::ReleaseNavigationMesh()
     dtFreeNavMeshQuery(navMeshQuery_);
     navMeshQuery_ = nullptr;
 
+    pathRequests_->ReleaseQueries();
+
     numTilesX_ = 0;
     numTilesZ_ = 0;
     boundingBox_.Clear();
@@ -24,8 +24,10 @@
 
 #pragma once
 
+#include <EASTL/functional.h>
 #include <EASTL/unique_ptr.h>
 
+#include "../Core/StopToken.h"
 #include "../Math/BoundingBox.h"
 #include "../Math/Matrix3x4.h"
 #include "../Scene/Component.h"
@@ -38,6 +40,7 @@ using dtPolyRef = unsigned int;
 
 class dtNavMesh;
 class dtNavMeshQuery;
+struct rcConfig;
 class dtQueryFilter;
 
 namespace Urho3D
@@ -53,7 +56,9 @@ class Geometry;
 class NavArea;
 
 struct FindPathData;
+struct PathRequestQueue;
 struct NavBuildData;
+struct SimpleNavBuildData;
 
 /// Description of a navigation mesh geometry component, with transform and bounds information.
 struct NavigationGeometryInfo
@@ -88,6 +93,15 @@ struct URHO3D_API NavigationPathPoint
     unsigned char areaID_;
 };
 
+/// Result of asynchronous path request.
+struct URHO3D_API NavigationPathResult
+{
+    /// Handle of the request.
+    unsigned handle_{};
+    /// World-space path points. Empty if path is not found.
+    ea::vector<NavigationPathPoint> path_;
+};
+
 /// Navigation mesh component. Collects the navigation geometry from child nodes with the Navigable component and responds to path queries.
 class URHO3D_API NavigationMesh : public Component
 {
@@ -159,6 +173,9 @@ public:
     virtual bool Build(const BoundingBox& boundingBox);
     /// Rebuild part of the navigation mesh in the rectangular area. Return true if successful.
     virtual bool Build(const IntVector2& from, const IntVector2& to);
+    /// Rebuild the navigation mesh. Tiles are built in batches, build is aborted between batches when stop token is signaled.
+    /// Aborted build releases the navigation mesh and doesn't send E_NAVIGATION_MESH_REBUILT. Return true if successful and not aborted.
+    bool Build(StopToken stopToken);
     /// Return tile data.
     virtual ea::vector<unsigned char> GetTileData(const IntVector2& tile) const;
     /// Add tile to navigation mesh.
@@ -186,6 +203,25 @@ public:
     void FindPath
         (ea::vector<NavigationPathPoint>& dest, const Vector3& start, const Vector3& end, const Vector3& extents = Vector3::ONE,
             const dtQueryFilter* filter = nullptr);
+    /// Submit asynchronous request to find a path between world space points. Return handle of the request, or 0 if the request cannot be submitted.
+    /// Requests are processed in parallel on scene post-update, and results are delivered in E_NAVIGATION_PATHS_FOUND event.
+    unsigned FindPathAsync(const Vector3& start, const Vector3& end, const Vector3& extents = Vector3::ONE,
+        const dtQueryFilter* filter = nullptr);
+    /// Cancel pending asynchronous path request.
+    void CancelPathRequest(unsigned handle);
+    /// Process pending asynchronous path requests until the time limit is exceeded and send E_NAVIGATION_PATHS_FOUND event.
+    /// At least one batch is processed. Called automatically on scene post-update.
+    void ProcessPathRequests(unsigned maxTimeUSec);
+    /// Return number of pending asynchronous path requests.
+    unsigned GetNumPendingPathRequests() const;
+    /// Return results of asynchronous path requests processed during last update.
+    const ea::vector<NavigationPathResult>& GetPathResults() const { return pathResults_; }
+    /// Set max time spent on asynchronous path requests per frame in microseconds.
+    /// @property
+    void SetMaxPathRequestTime(unsigned timeUSec) { maxPathRequestTime_ = timeUSec; }
+    /// Return max time spent on asynchronous path requests per frame in microseconds.
+    /// @property
+    unsigned GetMaxPathRequestTime() const { return maxPathRequestTime_; }
     /// Return a random point on the navigation mesh.
     Vector3 GetRandomPoint(const dtQueryFilter* filter = nullptr, dtPolyRef* randomRef = nullptr);
     /// Return a random point on the navigation mesh within a circle. The circle radius is only a guideline and in practice the returned point may be further away.
@@ -318,6 +354,15 @@ private:
     void WriteTile(Serializer& dest, int x, int z) const;
     /// Read tile data to the navigation mesh.
     bool ReadTile(Deserializer& source, bool silent);
+    /// Find a path between local space points and transform it to world space. Area IDs are not assigned.
+    /// Doesn't access the scene and is safe to call from worker threads with distinct query and path data.
+    static void FindWorldPath(ea::vector<NavigationPathPoint>& dest, dtNavMeshQuery* query, FindPathData& pathData,
+        const Matrix3x4& transform, const Vector3& localStart, const Vector3& localEnd, const Vector3& extents,
+        const dtQueryFilter* filter);
+    /// Assign area IDs of enabled NavArea components to world space path points.
+    void AssignPathAreas(ea::vector<NavigationPathPoint>& path);
+    /// Handle scene post-update event.
+    void HandleScenePostUpdate(StringHash eventType, VariantMap& eventData);
 
 protected:
     /// Collect geometry from under Navigable components.
@@ -328,10 +373,24 @@ protected:
     void GetTileGeometry(NavBuildData* build, ea::vector<NavigationGeometryInfo>& geometryList, BoundingBox& box);
     /// Add a triangle mesh to the geometry data.
     void AddTriMeshGeometry(NavBuildData* build, Geometry* geometry, const Matrix3x4& transform);
-    /// Build one tile of the navigation mesh. Return true if successful.
-    virtual bool BuildTile(ea::vector<NavigationGeometryInfo>& geometryList, int x, int z);
-    /// Build tiles in the rectangular area. Return number of built tiles.
-    unsigned BuildTiles(ea::vector<NavigationGeometryInfo>& geometryList, const IntVector2& from, const IntVector2& to);
+    /// Initialize Recast config of the tile. Return bounding box of the geometry that should be collected for the tile.
+    BoundingBox InitializeTileConfig(rcConfig& cfg, const IntVector2& tile) const;
+    /// Build navigation data of one tile from collected geometry. Doesn't modify the navigation mesh and is safe to call from worker threads.
+    /// Return true if successful. Output data is null if the tile is empty.
+    bool BuildTileData(SimpleNavBuildData& build, const rcConfig& cfg, const IntVector2& tile, unsigned char*& navData, int& navDataSize) const;
+    /// Add built tile data to the navigation mesh and send notification. Takes ownership of the data. Return true if successful.
+    bool AddTileData(unsigned char* navData, int navDataSize, const IntVector2& tile);
+    /// Build tiles in the rectangular area. Return number of built tiles. Optionally output whether the build was aborted by stop token.
+    unsigned BuildTiles(ea::vector<NavigationGeometryInfo>& geometryList, const IntVector2& from, const IntVector2& to,
+        bool* aborted = nullptr);
+    /// Process tiles in the rectangular area in batches and send progress notifications.
+    /// Prepare and commit callbacks are called from main thread in tile order, build callback is called from worker threads.
+    /// Callbacks receive index of the tile within the batch. Return false if aborted by stop token.
+    bool ProcessTileBatches(const IntVector2& from, const IntVector2& to,
+        const ea::function<void(unsigned index, const IntVector2& tile)>& prepare,
+        const ea::function<void(unsigned index)>& build, const ea::function<void(unsigned index)>& commit);
+    /// Return max number of tiles processed in one batch.
+    unsigned GetTileBatchSize() const;
     /// Ensure that the navigation mesh query is initialized. Return true if successful.
     bool InitializeQuery();
     /// Release the navigation mesh and the query.
@@ -391,6 +450,16 @@ protected:
     bool drawNavAreas_;
     /// NavAreas for this NavMesh.
     ea::vector<WeakPtr<NavArea> > areas_;
+    /// Stop token of the build in progress.
+    StopToken buildStopToken_;
+    /// Pending asynchronous path requests and per-thread queries.
+    ea::unique_ptr<PathRequestQueue> pathRequests_;
+    /// Results of asynchronous path requests processed during last update.
+    ea::vector<NavigationPathResult> pathResults_;
+    /// Max time spent on asynchronous path requests per frame in microseconds.
+    unsigned maxPathRequestTime_{ 2000 };
+    /// Handle of the next asynchronous path request.
+    unsigned nextPathRequestHandle_{ 1 };
 };
 
 /// Register Navigation library objects.
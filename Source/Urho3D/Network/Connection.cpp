@@ -30,15 +30,20 @@
 #include "../IO/MemoryBuffer.h"
 #include "../IO/PackageFile.h"
 #include "../Network/Connection.h"
+#include "../Network/InterestManager.h"
 #include "../Network/Network.h"
 #include "../Network/NetworkEvents.h"
 #include "../Network/NetworkPriority.h"
+#include "../Network/NetworkTransport.h"
 #include "../Network/Protocol.h"
+#include "../Network/SnapshotDelta.h"
 #include "../Resource/ResourceCache.h"
 #include "../Scene/Scene.h"
 #include "../Scene/SceneEvents.h"
 #include "../Scene/SmoothedTransform.h"
 
+#include <EASTL/sort.h>
+
 #include <slikenet/MessageIdentifiers.h>
 #include <slikenet/peerinterface.h>
 #include <slikenet/statistics.h>
@@ -57,6 +62,7 @@ namespace Urho3D
 {
 
 static const int STATS_INTERVAL_MSEC = 2000;
+static const float DEFAULT_NODE_PRIORITY = 100.0f;
 
 PackageDownload::PackageDownload() :
     totalFragments_(0),
@@ -104,6 +110,16 @@ void Connection::Initialize(bool isClient, const SLNet::AddressOrGUID& address,
     SetAddressOrGUID(address);
 }
 
+void Connection::Initialize(bool isClient, ConnectionTransport* transport)
+{
+    assert(peer_ == nullptr && transport_ == nullptr);
+    transport_ = transport;
+    isClient_ = isClient;
+    sceneState_.connection_ = this;
+    port_ = 0;
+    SetAddressOrGUID(SLNet::AddressOrGUID());
+}
+
 void Connection::RegisterObject(Context* context)
 {
     context->RegisterFactory<Connection>();
@@ -152,6 +168,7 @@ void Connection::SendMessage(int msgID, bool reliable, bool inOrder, const unsig
     buffer.WriteUInt((unsigned int) msgID);
     buffer.WriteUInt(numBytes);
     buffer.Write(data, numBytes);
+    updateSize_ += numBytes;
 }
 
 void Connection::SendRemoteEvent(StringHash eventType, bool inOrder, const VariantMap& eventData)
@@ -268,14 +285,33 @@ void Connection::SetLogStatistics(bool enable)
 
 void Connection::Disconnect(int waitMSec)
 {
-    peer_->CloseConnection(*address_, true);
+    if (transport_)
+        transport_->Close();
+    else if (peer_)
+        peer_->CloseConnection(*address_, true);
 }
 
 void Connection::SendServerUpdate()
+{
+    BuildServerUpdate();
+    FinishServerUpdate();
+}
+
+void Connection::BuildServerUpdate()
 {
     if (!scene_ || !sceneLoaded_)
         return;
 
+    // Snapshot is sent only if any node or component has pending latest data
+    ++snapshotID_;
+    snapshotNodes_.Clear();
+    snapshotComponents_.Clear();
+
+    updateSize_ = 0;
+    interestManager_ = scene_->GetComponent<InterestManager>();
+    if (interestManager_ && !interestManager_->IsEnabledEffective())
+        interestManager_ = nullptr;
+
     // Always check the root node (scene) first so that the scene-wide components get sent first,
     // and all other replicated nodes get added to the dirty set for sending the initial state
     unsigned sceneID = scene_->GetID();
@@ -283,16 +319,97 @@ void Connection::SendServerUpdate()
     ProcessNode(sceneID);
 
     // Then go through all dirtied nodes
-    nodesToProcess_.insert(sceneState_.dirtyNodes_.begin(), sceneState_.dirtyNodes_.end());
-    nodesToProcess_.erase(sceneID); // Do not process the root node twice
+    if (interestManager_)
+        ProcessRelevantNodes();
+    else
+    {
+        // Removed nodes are found in the dirty set as well
+        sceneState_.removedNodes_.clear();
+
+        // If interest manager was used before, irrelevant nodes were not replicated: mark everything dirty
+        if (!relevantNodeIDs_.empty())
+        {
+            relevantNodeIDs_.clear();
+            ea::vector<Node*> nodes;
+            scene_->GetChildren(nodes, true);
+            for (Node* node : nodes)
+            {
+                if (node->IsReplicated())
+                    sceneState_.dirtyNodes_.insert(node->GetID());
+            }
+        }
+
+        nodesToProcess_.insert(sceneState_.dirtyNodes_.begin(), sceneState_.dirtyNodes_.end());
+        nodesToProcess_.erase(sceneID); // Do not process the root node twice
+
+        while (nodesToProcess_.size())
+        {
+            unsigned nodeID = *nodesToProcess_.begin();
+            ProcessNode(nodeID);
+        }
+    }
+    interestManager_ = nullptr;
 
-    while (nodesToProcess_.size())
+    if (numSnapshotNodes_ || numSnapshotComponents_)
     {
-        unsigned nodeID = *nodesToProcess_.begin();
-        ProcessNode(nodeID);
+        msg_.Clear();
+        msg_.WriteUInt(snapshotID_);
+        msg_.WriteUByte(timeStamp_);
+        msg_.WriteVLE(numSnapshotNodes_);
+        msg_.Write(snapshotNodes_.GetData(), snapshotNodes_.GetSize());
+        msg_.WriteVLE(numSnapshotComponents_);
+        msg_.Write(snapshotComponents_.GetData(), snapshotComponents_.GetSize());
+
+        SendMessage(MSG_SCENESNAPSHOT, false, true, msg_);
+        numSnapshotNodes_ = 0;
+        numSnapshotComponents_ = 0;
     }
 }
 
+void Connection::FinishServerUpdate()
+{
+    for (NodeReplicationState* nodeState : newNodeStates_)
+    {
+        if (Node* node = nodeState->node_)
+            node->AddReplicationState(nodeState);
+    }
+
+    for (ComponentReplicationState* componentState : newComponentStates_)
+    {
+        if (Component* component = componentState->component_)
+            component->AddReplicationState(componentState);
+    }
+
+    newNodeStates_.clear();
+    newComponentStates_.clear();
+
+    for (unsigned nodeID : removedNodeIDs_)
+    {
+        auto i = sceneState_.nodeStates_.find(nodeID);
+        if (i == sceneState_.nodeStates_.end())
+            continue;
+
+        // Stop tracking the node if it still exists
+        NodeReplicationState& nodeState = i->second;
+        if (Node* node = nodeState.node_)
+        {
+            if (NetworkState* networkState = node->GetNetworkState())
+                networkState->replicationStates_.erase_first(&nodeState);
+
+            for (auto& item : nodeState.componentStates_)
+            {
+                Component* component = item.second.component_;
+                NetworkState* networkState = component ? component->GetNetworkState() : nullptr;
+                if (networkState)
+                    networkState->replicationStates_.erase_first(&item.second);
+            }
+        }
+
+        sceneState_.nodeStates_.erase(i);
+    }
+    removedNodeIDs_.clear();
+}
+
 void Connection::SendClientUpdate()
 {
     if (!scene_ || !sceneLoaded_)
@@ -406,7 +523,12 @@ void Connection::SendBuffer(PacketType type)
     if (type == PT_RELIABLE_UNORDERED)
         reliability = PacketReliability::RELIABLE;
 
-    if (peer_) {
+    if (transport_)
+    {
+        transport_->Send(type, buffer.GetData(), buffer.GetSize());
+        tempPacketCounter_.y_++;
+    }
+    else if (peer_) {
         peer_->Send((const char *) buffer.GetData(), (int) buffer.GetSize(), HIGH_PRIORITY, reliability, (char) 0,
                     *address_, false);
         tempPacketCounter_.y_++;
@@ -524,6 +646,14 @@ bool Connection::ProcessMessage(int msgID, MemoryBuffer& buffer)
             case MSG_PACKAGEINFO:
                 ProcessPackageInfo(msgID, msg);
                 break;
+
+            case MSG_SCENESNAPSHOT:
+                ProcessSceneSnapshot(msgID, msg);
+                break;
+
+            case MSG_SNAPSHOTACK:
+                ProcessSnapshotAck(msgID, msg);
+                break;
             default:
                 ProcessUnknownMessage(msgID, msg);
                 break;
@@ -560,6 +690,8 @@ void Connection::ProcessLoadScene(int msgID, MemoryBuffer& msg)
     // Clear previous pending latest data and package downloads if any
     nodeLatestData_.clear();
     componentLatestData_.clear();
+    nodeSnapshots_.clear();
+    componentSnapshots_.clear();
     downloads_.clear();
 
     // In case we have joined other scenes in this session, remove first all downloaded package files from the resource system
@@ -724,6 +856,7 @@ void Connection::ProcessSceneUpdate(int msgID, MemoryBuffer& msg)
             if (node)
                 node->Remove();
             nodeLatestData_.erase(nodeID);
+            nodeSnapshots_.erase(nodeID);
         }
         break;
 
@@ -801,6 +934,7 @@ void Connection::ProcessSceneUpdate(int msgID, MemoryBuffer& msg)
             if (component)
                 component->Remove();
             componentLatestData_.erase(componentID);
+            componentSnapshots_.erase(componentID);
         }
         break;
 
@@ -1075,6 +1209,103 @@ void Connection::ProcessRemoteEvent(int msgID, MemoryBuffer& msg)
     }
 }
 
+void Connection::ProcessSceneSnapshot(int msgID, MemoryBuffer& msg)
+{
+    if (IsClient())
+    {
+        URHO3D_LOGWARNING("Received unexpected SceneSnapshot message from client " + ToString());
+        return;
+    }
+
+    if (!scene_)
+        return;
+
+    const unsigned snapshotID = msg.ReadUInt();
+    const unsigned char timeStamp = msg.ReadUByte();
+    const bool nodesDecoded = ReadSnapshotEntries(msg, snapshotID, timeStamp, false);
+    const bool componentsDecoded = nodesDecoded && ReadSnapshotEntries(msg, snapshotID, timeStamp, true);
+
+    // Snapshot cannot be used as delta base unless all entries are decoded
+    if (!componentsDecoded)
+    {
+        URHO3D_LOGWARNING("Failed to decode scene snapshot " + ea::to_string(snapshotID));
+        return;
+    }
+
+    msg_.Clear();
+    msg_.WriteUInt(snapshotID);
+    SendMessage(MSG_SNAPSHOTACK, false, false, msg_);
+}
+
+bool Connection::ReadSnapshotEntries(MemoryBuffer& msg, unsigned snapshotID, unsigned char timeStamp, bool isComponent)
+{
+    auto& snapshots = isComponent ? componentSnapshots_ : nodeSnapshots_;
+    auto& pendingLatestData = isComponent ? componentLatestData_ : nodeLatestData_;
+
+    unsigned numEntries = msg.ReadVLE();
+    while (numEntries--)
+    {
+        const unsigned id = msg.ReadNetID();
+        const unsigned baseDistance = msg.ReadVLE();
+        SnapshotHistory& history = snapshots[id];
+
+        const SnapshotEntry* base = nullptr;
+        if (baseDistance)
+        {
+            base = history.Find(snapshotID - baseDistance);
+            if (!base)
+                return false;
+        }
+
+        if (!ReadSnapshotDelta(msg, base ? ea::span<const unsigned char>(base->data_) : ea::span<const unsigned char>(),
+            snapshotDecoded_))
+            return false;
+
+        // Old snapshots may be received out of order, but they are still valid delta bases
+        const bool isLatest = history.entries_.empty() || history.entries_.back().snapshotID_ < snapshotID;
+        if (!history.Find(snapshotID))
+            history.Add(snapshotID, snapshotDecoded_.data(), snapshotDecoded_.size());
+        if (!isLatest)
+            continue;
+
+        // Apply in the same format as latest data message, cache if the object is not received yet
+        snapshotData_.Clear();
+        snapshotData_.WriteNetID(id);
+        snapshotData_.WriteUByte(timeStamp);
+        snapshotData_.Write(snapshotDecoded_.data(), snapshotDecoded_.size());
+
+        MemoryBuffer data(snapshotData_.GetData(), snapshotData_.GetSize());
+        data.ReadNetID();
+        if (Component* component = isComponent ? scene_->GetComponent(id) : nullptr)
+        {
+            if (component->ReadLatestDataUpdate(data))
+                component->ApplyAttributes();
+        }
+        else if (Node* node = !isComponent ? scene_->GetNode(id) : nullptr)
+        {
+            // ApplyAttributes() is deliberately skipped, as Node has no attributes that require late applying.
+            node->ReadLatestDataUpdate(data);
+        }
+        else
+            pendingLatestData[id] = snapshotData_.GetBuffer();
+    }
+
+    return true;
+}
+
+void Connection::ProcessSnapshotAck(int msgID, MemoryBuffer& msg)
+{
+    if (!IsClient())
+    {
+        URHO3D_LOGWARNING("Received unexpected SnapshotAck message from server");
+        return;
+    }
+
+    const unsigned snapshotID = msg.ReadUInt();
+    if (snapshotID <= snapshotID_ && snapshotID_ - snapshotID < MAX_ACKED_SNAPSHOTS)
+        ackedSnapshots_[snapshotID % MAX_ACKED_SNAPSHOTS] = snapshotID;
+}
+
 Scene* Connection::GetScene() const
 {
     return scene_;
@@ -1082,11 +1313,15 @@ Scene* Connection::GetScene() const
 
 bool Connection::IsConnected() const
 {
+    if (transport_)
+        return transport_->IsConnected();
     return peer_ && peer_->IsActive();
 }
 
 float Connection::GetRoundTripTime() const
 {
+    if (transport_)
+        return transport_->GetRoundTripTime();
     if (peer_)
     {
         SLNet::RakNetStatistics stats{};
@@ -1103,6 +1338,8 @@ unsigned Connection::GetLastHeardTime() const
 
 float Connection::GetBytesInPerSec() const
 {
+    if (transport_)
+        return transport_->GetBytesInPerSec();
     if (peer_)
     {
         SLNet::RakNetStatistics stats{};
@@ -1114,6 +1351,8 @@ float Connection::GetBytesInPerSec() const
 
 float Connection::GetBytesOutPerSec() const
 {
+    if (transport_)
+        return transport_->GetBytesOutPerSec();
     if (peer_)
     {
         SLNet::RakNetStatistics stats{};
@@ -1213,6 +1452,122 @@ void Connection::HandleAsyncLoadFinished(StringHash eventType, VariantMap& event
     SendMessage(MSG_SCENELOADED, true, true, msg_);
 }
 
+void Connection::ProcessRelevantNodes()
+{
+    const unsigned updateBudget = interestManager_->GetUpdateBudget();
+
+    // Removed nodes are not tracked by interest manager, but the client should know about removal
+    for (unsigned nodeID : sceneState_.removedNodes_)
+        RemoveReplicatedNode(nodeID);
+    sceneState_.removedNodes_.clear();
+
+    // Gather relevant nodes together with their dependencies, so the client can always resolve them
+    relevantNodes_.clear();
+    scheduledNodes_.clear();
+    ea::swap(relevantNodeIDs_, previousRelevantNodeIDs_);
+    relevantNodeIDs_.clear();
+    relevantNodeIDs_.insert(scene_->GetID());
+
+    interestManager_->QueryRelevantNodes(this, relevantNodes_);
+    for (const InterestEntry* entry : relevantNodes_)
+        AddRelevantNode(entry->node_);
+
+    // Nodes that are no longer relevant are removed from the client, and are created again when they become relevant
+    for (unsigned nodeID : previousRelevantNodeIDs_)
+    {
+        if (!relevantNodeIDs_.contains(nodeID))
+            RemoveReplicatedNode(nodeID);
+    }
+
+    // New nodes are created first, then existing nodes are ranked by priority accumulated while waiting for update
+    for (const InterestEntry* entry : relevantNodes_)
+    {
+        const unsigned nodeID = entry->node_->GetID();
+        auto i = sceneState_.nodeStates_.find(nodeID);
+        if (i == sceneState_.nodeStates_.end())
+        {
+            scheduledNodes_.emplace_back(M_INFINITY, nodeID);
+            continue;
+        }
+
+        if (!sceneState_.dirtyNodes_.contains(nodeID))
+            continue;
+
+        // Update rate is limited by priority regardless of update budget
+        NodeReplicationState& nodeState = i->second;
+        NetworkPriority* priority = entry->priority_;
+        const float distance = (entry->position_ - position_).Length();
+        if (priority && !nodeState.updateDue_ && (!priority->GetAlwaysUpdateOwner() || entry->owner_ != this))
+        {
+            if (!priority->CheckUpdate(distance, nodeState.priorityAcc_))
+                continue;
+            nodeState.updateDue_ = true;
+        }
+
+        float score = M_INFINITY;
+        if (updateBudget)
+        {
+            nodeState.schedulePriority_ += priority ? priority->GetPriority(distance) : DEFAULT_NODE_PRIORITY;
+            score = nodeState.schedulePriority_;
+        }
+        scheduledNodes_.emplace_back(score, nodeID);
+    }
+
+    if (updateBudget)
+    {
+        ea::stable_sort(scheduledNodes_.begin(), scheduledNodes_.end(),
+            [](const ea::pair<float, unsigned>& lhs, const ea::pair<float, unsigned>& rhs) { return lhs.first > rhs.first; });
+    }
+
+    // Nodes that don't fit into the budget are kept dirty until next update
+    for (const auto& scoreAndID : scheduledNodes_)
+    {
+        if (updateBudget && updateSize_ + snapshotNodes_.GetSize() + snapshotComponents_.GetSize() >= updateBudget)
+            break;
+        ProcessNode(scoreAndID.second);
+    }
+    nodesToProcess_.clear();
+
+    // Drop dirty state of irrelevant nodes: they are either not tracked or already removed from the client
+    tempNodeIDs_.clear();
+    for (unsigned nodeID : relevantNodeIDs_)
+    {
+        if (sceneState_.dirtyNodes_.contains(nodeID))
+            tempNodeIDs_.push_back(nodeID);
+    }
+    sceneState_.dirtyNodes_.clear();
+    sceneState_.dirtyNodes_.insert(tempNodeIDs_.begin(), tempNodeIDs_.end());
+}
+
+void Connection::AddRelevantNode(Node* node)
+{
+    const unsigned nodeID = node->GetID();
+    if (!relevantNodeIDs_.insert(nodeID).second)
+        return;
+
+    if (!sceneState_.nodeStates_.contains(nodeID) || sceneState_.dirtyNodes_.contains(nodeID))
+        nodesToProcess_.insert(nodeID);
+
+    for (Node* dependencyNode : node->GetDependencyNodes())
+        AddRelevantNode(dependencyNode);
+}
+
+void Connection::RemoveReplicatedNode(unsigned nodeID)
+{
+    sceneState_.dirtyNodes_.erase(nodeID);
+
+    if (!sceneState_.nodeStates_.contains(nodeID))
+        return;
+
+    // Network states are shared between connections, so the replication state is released in FinishServerUpdate()
+    if (!removedNodeIDs_.insert(nodeID).second)
+        return;
+
+    msg_.Clear();
+    msg_.WriteNetID(nodeID);
+    SendMessage(MSG_REMOVENODE, true, true, msg_);
+}
+
 void Connection::ProcessNode(unsigned nodeID)
 {
     // Check that we have not already processed this due to dependency recursion
@@ -1260,7 +1615,7 @@ void Connection::ProcessNewNode(Node* node)
     for (auto i = dependencyNodes.begin(); i != dependencyNodes.end(); ++i)
     {
         unsigned nodeID = (*i)->GetID();
-        if (sceneState_.dirtyNodes_.contains(nodeID))
+        if (nodesToProcess_.contains(nodeID))
             ProcessNode(nodeID);
     }
 
@@ -1271,7 +1626,7 @@ void Connection::ProcessNewNode(Node* node)
     nodeState.connection_ = this;
     nodeState.sceneState_ = &sceneState_;
     nodeState.node_ = node;
-    node->AddReplicationState(&nodeState);
+    newNodeStates_.push_back(&nodeState);
 
     // Write node's attributes
     node->WriteInitialDeltaUpdate(msg_, timeStamp_);
@@ -1299,7 +1654,7 @@ void Connection::ProcessNewNode(Node* node)
         componentState.connection_ = this;
         componentState.nodeState_ = &nodeState;
         componentState.component_ = component;
-        component->AddReplicationState(&componentState);
+        newComponentStates_.push_back(&componentState);
 
         msg_.WriteStringHash(component->GetType());
         msg_.WriteNetID(component->GetID());
@@ -1319,20 +1674,31 @@ void Connection::ProcessExistingNode(Node* node, NodeReplicationState& nodeState
     for (auto i = dependencyNodes.begin(); i != dependencyNodes.end(); ++i)
     {
         unsigned nodeID = (*i)->GetID();
-        if (sceneState_.dirtyNodes_.contains(nodeID))
+        if (nodesToProcess_.contains(nodeID))
             ProcessNode(nodeID);
     }
 
     // Check from the interest management component, if exists, whether should update
-    /// \todo Searching for the component is a potential CPU hotspot. It should be cached
-    auto* priority = node->GetComponent<NetworkPriority>();
-    if (priority && (!priority->GetAlwaysUpdateOwner() || node->GetOwner() != this))
+    if (interestManager_)
     {
-        float distance = (node->GetWorldPosition() - position_).Length();
-        if (!priority->CheckUpdate(distance, nodeState.priorityAcc_))
-            return;
+        // Priority is already accounted for when scheduling the update
+        nodeState.updateDue_ = false;
+        nodeState.schedulePriority_ = 0.0f;
+    }
+    else
+    {
+        NetworkPriority* priority = node->GetComponent<NetworkPriority>();
+        if (priority && (!priority->GetAlwaysUpdateOwner() || node->GetOwner() != this))
+        {
+            float distance = (node->GetWorldPosition() - position_).Length();
+            if (!priority->CheckUpdate(distance, nodeState.priorityAcc_))
+                return;
+        }
     }
 
+    // In snapshot mode, latest data is sent until the client acknowledges it
+    bool snapshotPending = false;
+
     // Check if attributes have changed
     if (nodeState.dirtyAttributes_.Count() || nodeState.dirtyVars_.size())
     {
@@ -1350,7 +1716,9 @@ void Connection::ProcessExistingNode(Node* node, NodeReplicationState& nodeState
         }
 
         // Send latestdata message if necessary
-        if (hasLatestData)
+        if (hasLatestData && snapshotReplication_)
+            nodeState.snapshots_.pending_ = true;
+        else if (hasLatestData)
         {
             msg_.Clear();
             msg_.WriteNetID(node->GetID());
@@ -1393,6 +1761,9 @@ void Connection::ProcessExistingNode(Node* node, NodeReplicationState& nodeState
         }
     }
 
+    if (nodeState.snapshots_.pending_)
+        snapshotPending |= WriteSnapshotEntry(snapshotNodes_, numSnapshotNodes_, node, node->GetID(), nodeState.snapshots_);
+
     // Check for removed or changed components
     for (auto i = nodeState.componentStates_.begin();
          i != nodeState.componentStates_.end();)
@@ -1428,7 +1799,9 @@ void Connection::ProcessExistingNode(Node* node, NodeReplicationState& nodeState
                 }
 
                 // Send latestdata message if necessary
-                if (hasLatestData)
+                if (hasLatestData && snapshotReplication_)
+                    componentState.snapshots_.pending_ = true;
+                else if (hasLatestData)
                 {
                     msg_.Clear();
                     msg_.WriteNetID(component->GetID());
@@ -1449,6 +1822,12 @@ void Connection::ProcessExistingNode(Node* node, NodeReplicationState& nodeState
                     componentState.dirtyAttributes_.ClearAll();
                 }
             }
+
+            if (componentState.snapshots_.pending_)
+            {
+                snapshotPending |= WriteSnapshotEntry(snapshotComponents_, numSnapshotComponents_, component,
+                    component->GetID(), componentState.snapshots_);
+            }
         }
     }
 
@@ -1472,7 +1851,7 @@ void Connection::ProcessExistingNode(Node* node, NodeReplicationState& nodeState
                 componentState.connection_ = this;
                 componentState.nodeState_ = &nodeState;
                 componentState.component_ = component;
-                component->AddReplicationState(&componentState);
+                newComponentStates_.push_back(&componentState);
 
                 msg_.Clear();
                 msg_.WriteNetID(node->GetID());
@@ -1485,8 +1864,56 @@ void Connection::ProcessExistingNode(Node* node, NodeReplicationState& nodeState
         }
     }
 
-    nodeState.markedDirty_ = false;
-    sceneState_.dirtyNodes_.erase(node->GetID());
+    // Keep the node dirty so pending snapshot entries are sent again on next update
+    if (!snapshotPending)
+    {
+        nodeState.markedDirty_ = false;
+        sceneState_.dirtyNodes_.erase(node->GetID());
+    }
+}
+
+bool Connection::WriteSnapshotEntry(VectorBuffer& dest, unsigned& numEntries, Serializable* serializable, unsigned id,
+    SnapshotHistory& history)
+{
+    snapshotData_.Clear();
+    serializable->WriteLatestDataSnapshot(snapshotData_);
+    const ea::span<const unsigned char> data{ snapshotData_.GetData(), snapshotData_.GetSize() };
+
+    // Latest acknowledged entry is the delta base
+    SnapshotEntry* base = nullptr;
+    for (auto iter = history.entries_.rbegin(); iter != history.entries_.rend(); ++iter)
+    {
+        if (!iter->acked_)
+            iter->acked_ = IsSnapshotAcked(iter->snapshotID_);
+        if (iter->acked_)
+        {
+            base = &*iter;
+            break;
+        }
+    }
+
+    // Client already has the latest data
+    if (base && base->data_.size() == data.size() && memcmp(base->data_.data(), data.data(), data.size()) == 0)
+    {
+        history.pending_ = false;
+        return false;
+    }
+
+    dest.WriteNetID(id);
+    if (base)
+    {
+        dest.WriteVLE(snapshotID_ - base->snapshotID_);
+        WriteSnapshotDelta(dest, data, base->data_);
+    }
+    else
+    {
+        dest.WriteVLE(0);
+        WriteSnapshotDelta(dest, data, {});
+    }
+    ++numEntries;
+
+    history.Add(snapshotID_, data.data(), data.size());
+    return true;
 }
 
 bool Connection::RequestNeededPackages(unsigned numPackages, MemoryBuffer& msg)
@@ -45,11 +45,14 @@ namespace SLNet
 namespace Urho3D
 {
 
+class ConnectionTransport;
 class File;
+class InterestManager;
 class MemoryBuffer;
 class Node;
 class Scene;
 class Serializable;
+struct InterestEntry;
 class PackageFile;
 
 /// Queued remote event.
@@ -107,6 +110,9 @@ enum ObserverPositionSendMode
     OPSM_POSITION_ROTATION
 };
 
+/// Number of tracked snapshot acknowledgements.
+static const unsigned MAX_ACKED_SNAPSHOTS = 64;
+
 /// Packet types for outgoing buffers. Outgoing messages are grouped by their type
 enum PacketType {
     PT_UNRELIABLE_UNORDERED,
@@ -127,6 +133,8 @@ public:
     ~Connection() override;
     /// Initialize object state. Should be called immediately after constructor.
     void Initialize(bool isClient, const SLNet::AddressOrGUID& address, SLNet::RakPeerInterface* peer);
+    /// Initialize object state with custom transport instead of RakNet peer. Should be called immediately after constructor.
+    void Initialize(bool isClient, ConnectionTransport* transport);
 
     /// Register object with the engine.
     static void RegisterObject(Context* context);
@@ -154,15 +162,27 @@ public:
     /// Set the observer rotation for interest management, to be sent to the server. Note: not used by the NetworkPriority component.
     /// @property
     void SetRotation(const Quaternion& rotation);
+    /// Set interest mask. Nodes are relevant only if their relevance mask matches. Used by InterestManager on the server.
+    /// @property
+    void SetInterestMask(unsigned mask) { interestMask_ = mask; }
     /// Set the connection pending status. Called by Network.
     void SetConnectPending(bool connectPending);
     /// Set whether to log data in/out statistics.
     /// @property
     void SetLogStatistics(bool enable);
+    /// Set whether to send latest data as deltas against snapshots acknowledged by the client.
+    /// Snapshots are sent over unreliable channel once per update. Used on the server only.
+    /// @property
+    void SetSnapshotReplication(bool enable) { snapshotReplication_ = enable; }
     /// Disconnect. If wait time is non-zero, will block while waiting for disconnect to finish.
     void Disconnect(int waitMSec = 0);
-    /// Send scene update messages. Called by Network.
+    /// Send scene update messages. Equivalent to BuildServerUpdate followed by FinishServerUpdate.
     void SendServerUpdate();
+    /// Write scene update messages to outgoing buffers. Doesn't modify the scene, so it may be called
+    /// for different connections from worker threads in parallel. Called by Network.
+    void BuildServerUpdate();
+    /// Register replication states created by BuildServerUpdate in nodes and components. Called by Network.
+    void FinishServerUpdate();
     /// Send latest controls from the client. Called by Network.
     void SendClientUpdate();
     /// Send queued remote events. Called by Network.
@@ -204,6 +224,10 @@ public:
     /// @property
     const Quaternion& GetRotation() const { return rotation_; }
 
+    /// Return interest mask.
+    /// @property
+    unsigned GetInterestMask() const { return interestMask_; }
+
     /// Return whether is a client connection.
     /// @property
     bool IsClient() const { return isClient_; }
@@ -224,6 +248,17 @@ public:
     /// @property
     bool GetLogStatistics() const { return logStatistics_; }
 
+    /// Return whether latest data is sent as deltas against acknowledged snapshots.
+    /// @property
+    bool GetSnapshotReplication() const { return snapshotReplication_; }
+    /// Return ID of the latest sent snapshot. Used on the server only.
+    unsigned GetSnapshotID() const { return snapshotID_; }
+    /// Return whether the snapshot is acknowledged by the client. Only recent acknowledgements are tracked.
+    bool IsSnapshotAcked(unsigned snapshotID) const { return ackedSnapshots_[snapshotID % MAX_ACKED_SNAPSHOTS] == snapshotID; }
+
+    /// Return custom transport, if any.
+    ConnectionTransport* GetTransport() const { return transport_; }
+
     /// Return remote address.
     /// @property
     ea::string GetAddress() const;
@@ -301,6 +336,20 @@ private:
     void ProcessSceneLoaded(int msgID, MemoryBuffer& msg);
     /// Process a remote event message from the client or server. Called by Network.
     void ProcessRemoteEvent(int msgID, MemoryBuffer& msg);
+    /// Process a scene snapshot message from the server. Called by Network.
+    void ProcessSceneSnapshot(int msgID, MemoryBuffer& msg);
+    /// Process a snapshot acknowledgement from the client. Called by Network.
+    void ProcessSnapshotAck(int msgID, MemoryBuffer& msg);
+    /// Write snapshot entry for a node or component with pending latest data. Return whether the latest data is still not acknowledged.
+    bool WriteSnapshotEntry(VectorBuffer& dest, unsigned& numEntries, Serializable* serializable, unsigned id, SnapshotHistory& history);
+    /// Read and apply snapshot entries of nodes or components. Return false if any entry could not be decoded.
+    bool ReadSnapshotEntries(MemoryBuffer& msg, unsigned snapshotID, unsigned char timeStamp, bool isComponent);
+    /// Process dirty nodes relevant to the client according to interest manager, ranked by priority.
+    void ProcessRelevantNodes();
+    /// Add relevant node and its dependencies to the relevant set. Untracked or dirty ones are added to the set of nodes to process.
+    void AddRelevantNode(Node* node);
+    /// Remove node from the client and stop tracking it.
+    void RemoveReplicatedNode(unsigned nodeID);
     /// Process a node for sending a network update. Recurses to process depended on node(s) first.
     void ProcessNode(unsigned nodeID);
     /// Process a node that the client has not yet received.
@@ -338,8 +387,48 @@ private:
     ea::unordered_map<unsigned, ea::vector<unsigned char> > componentLatestData_;
     /// Node ID's to process during a replication update.
     ea::hash_set<unsigned> nodesToProcess_;
+    /// Interest manager of the scene during a replication update.
+    InterestManager* interestManager_{};
+    /// Nodes relevant to the client during a replication update.
+    ea::vector<const InterestEntry*> relevantNodes_;
+    /// ID's of relevant nodes and their dependencies. Only these nodes are replicated to the client.
+    ea::hash_set<unsigned> relevantNodeIDs_;
+    /// ID's of relevant nodes and their dependencies during previous replication update.
+    ea::hash_set<unsigned> previousRelevantNodeIDs_;
+    /// Temporary node ID buffer.
+    ea::vector<unsigned> tempNodeIDs_;
+    /// Scores and ID's of nodes to process in order during a replication update.
+    ea::vector<ea::pair<float, unsigned>> scheduledNodes_;
+    /// Size of messages written during a replication update.
+    unsigned updateSize_{};
+    /// Node replication states created during current replication update.
+    ea::vector<NodeReplicationState*> newNodeStates_;
+    /// Component replication states created during current replication update.
+    ea::vector<ComponentReplicationState*> newComponentStates_;
+    /// ID's of nodes removed from the client during current replication update. Their states are released afterwards.
+    ea::hash_set<unsigned> removedNodeIDs_;
     /// Reusable message buffer.
     VectorBuffer msg_;
+    /// Snapshot entries of nodes written during current replication update.
+    VectorBuffer snapshotNodes_;
+    /// Snapshot entries of components written during current replication update.
+    VectorBuffer snapshotComponents_;
+    /// Reusable buffer for snapshot latest data.
+    VectorBuffer snapshotData_;
+    /// Reusable buffer for decoded snapshot latest data.
+    ByteVector snapshotDecoded_;
+    /// Number of node entries in current snapshot.
+    unsigned numSnapshotNodes_{};
+    /// Number of component entries in current snapshot.
+    unsigned numSnapshotComponents_{};
+    /// Current snapshot ID. Used on the server only.
+    unsigned snapshotID_{};
+    /// Acknowledged snapshot IDs, indexed by ID modulo MAX_ACKED_SNAPSHOTS. Used on the server only.
+    unsigned ackedSnapshots_[MAX_ACKED_SNAPSHOTS]{};
+    /// Received latest data snapshots of nodes. Used on the client only.
+    ea::unordered_map<unsigned, SnapshotHistory> nodeSnapshots_;
+    /// Received latest data snapshots of components. Used on the client only.
+    ea::unordered_map<unsigned, SnapshotHistory> componentSnapshots_;
     /// Queued remote events.
     ea::vector<RemoteEvent> remoteEvents_;
     /// Scene file to load once all packages (if any) have been downloaded.
@@ -362,10 +451,16 @@ private:
     bool sceneLoaded_;
     /// Show statistics flag.
     bool logStatistics_;
+    /// Snapshot replication mode flag.
+    bool snapshotReplication_{};
+    /// Interest mask.
+    unsigned interestMask_{ M_MAX_UNSIGNED };
     /// Address of this connection.
     SLNet::AddressOrGUID* address_;
     /// Raknet peer object.
     SLNet::RakPeerInterface* peer_;
+    /// Custom transport used instead of RakNet peer.
+    SharedPtr<ConnectionTransport> transport_;
     /// Temporary variable to hold packet count in the next second, x - packets in, y - packets out.
     IntVector2 tempPacketCounter_;
     /// Packet count in the last second, x - packets in, y - packets out.
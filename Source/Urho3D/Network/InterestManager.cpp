@@ -0,0 +1,215 @@
+//
+// Copyright (c) 2017-2021 the rbfx project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "../Precompiled.h"
+
+#include "../Core/Context.h"
+#include "../Core/Profiler.h"
+#include "../Network/Connection.h"
+#include "../Network/InterestManager.h"
+#include "../Network/NetworkPriority.h"
+#include "../Scene/Scene.h"
+
+#include <EASTL/sort.h>
+
+#include "../DebugNew.h"
+
+namespace Urho3D
+{
+
+extern const char* NETWORK_CATEGORY;
+
+static const float DEFAULT_CELL_SIZE = 32.0f;
+static const float DEFAULT_RELEVANCE_RADIUS = 256.0f;
+static const float DEFAULT_VIEW_ANGLE = 360.0f;
+static const float DEFAULT_NEAR_RADIUS = 32.0f;
+static const unsigned DEFAULT_UPDATE_BUDGET = 0;
+
+InterestManager::InterestManager(Context* context) :
+    Component(context),
+    cellSize_(DEFAULT_CELL_SIZE),
+    relevanceRadius_(DEFAULT_RELEVANCE_RADIUS),
+    viewAngle_(DEFAULT_VIEW_ANGLE),
+    nearRadius_(DEFAULT_NEAR_RADIUS),
+    updateBudget_(DEFAULT_UPDATE_BUDGET)
+{
+}
+
+InterestManager::~InterestManager() = default;
+
+void InterestManager::RegisterObject(Context* context)
+{
+    context->RegisterFactory<InterestManager>(NETWORK_CATEGORY);
+
+    URHO3D_ACCESSOR_ATTRIBUTE("Cell Size", GetCellSize, SetCellSize, float, DEFAULT_CELL_SIZE, AM_DEFAULT);
+    URHO3D_ACCESSOR_ATTRIBUTE("Relevance Radius", GetRelevanceRadius, SetRelevanceRadius, float, DEFAULT_RELEVANCE_RADIUS, AM_DEFAULT);
+    URHO3D_ACCESSOR_ATTRIBUTE("View Angle", GetViewAngle, SetViewAngle, float, DEFAULT_VIEW_ANGLE, AM_DEFAULT);
+    URHO3D_ACCESSOR_ATTRIBUTE("Near Radius", GetNearRadius, SetNearRadius, float, DEFAULT_NEAR_RADIUS, AM_DEFAULT);
+    URHO3D_ACCESSOR_ATTRIBUTE("Update Budget", GetUpdateBudget, SetUpdateBudget, unsigned, DEFAULT_UPDATE_BUDGET, AM_DEFAULT);
+}
+
+void InterestManager::SetCellSize(float size)
+{
+    cellSize_ = Max(size, M_EPSILON);
+}
+
+void InterestManager::SetRelevanceRadius(float radius)
+{
+    relevanceRadius_ = Max(radius, 0.0f);
+}
+
+void InterestManager::SetViewAngle(float angle)
+{
+    viewAngle_ = Clamp(angle, 0.0f, 360.0f);
+}
+
+void InterestManager::SetNearRadius(float radius)
+{
+    nearRadius_ = Max(radius, 0.0f);
+}
+
+void InterestManager::SetUpdateBudget(unsigned bytes)
+{
+    updateBudget_ = bytes;
+}
+
+void InterestManager::Update()
+{
+    URHO3D_PROFILE("UpdateInterestManager");
+
+    entries_.clear();
+    entryIndices_.clear();
+    cells_.clear();
+    alwaysRelevant_.clear();
+    owned_.clear();
+
+    Scene* scene = GetScene();
+    if (!scene)
+        return;
+
+    nodes_.clear();
+    scene->GetChildren(nodes_, true);
+
+    for (Node* node : nodes_)
+    {
+        if (!node->IsReplicated())
+            continue;
+
+        const unsigned index = entries_.size();
+        InterestEntry& entry = entries_.push_back();
+        entry.node_ = node;
+        entry.priority_ = node->GetComponent<NetworkPriority>();
+        entry.owner_ = node->GetOwner();
+        entry.position_ = node->GetWorldPosition();
+        entry.relevanceMask_ = entry.priority_ ? entry.priority_->GetRelevanceMask() : M_MAX_UNSIGNED;
+        entryIndices_[node->GetID()] = index;
+
+        if (entry.priority_ && entry.priority_->GetAlwaysRelevant())
+            alwaysRelevant_.push_back(index);
+        else
+        {
+            const int x = FloorToInt(entry.position_.x_ / cellSize_);
+            const int z = FloorToInt(entry.position_.z_ / cellSize_);
+            cells_.emplace_back(GetCellKey(x, z), index);
+        }
+
+        if (entry.owner_)
+            owned_.push_back(index);
+    }
+
+    ea::sort(cells_.begin(), cells_.end());
+}
+
+void InterestManager::QueryRelevantNodes(const Connection* connection, ea::vector<const InterestEntry*>& dest) const
+{
+    const unsigned interestMask = connection->GetInterestMask();
+
+    for (unsigned index : alwaysRelevant_)
+    {
+        const InterestEntry& entry = entries_[index];
+        if (entry.owner_ == connection || (entry.relevanceMask_ & interestMask))
+            dest.push_back(&entry);
+    }
+
+    // Owned nodes are always relevant to the owner
+    for (unsigned index : owned_)
+    {
+        const InterestEntry& entry = entries_[index];
+        const bool isAlwaysRelevant = entry.priority_ && entry.priority_->GetAlwaysRelevant();
+        if (entry.owner_ == connection && !isAlwaysRelevant)
+            dest.push_back(&entry);
+    }
+
+    // Check grid cells overlapping relevance radius
+    const Vector3& position = connection->GetPosition();
+    const Vector3 direction = connection->GetRotation() * Vector3::FORWARD;
+    const float cosHalfAngle = Cos(viewAngle_ * 0.5f);
+    const int minX = FloorToInt((position.x_ - relevanceRadius_) / cellSize_);
+    const int maxX = FloorToInt((position.x_ + relevanceRadius_) / cellSize_);
+    const int minZ = FloorToInt((position.z_ - relevanceRadius_) / cellSize_);
+    const int maxZ = FloorToInt((position.z_ + relevanceRadius_) / cellSize_);
+
+    for (int x = minX; x <= maxX; ++x)
+    {
+        // Cells with the same X are adjacent in sorted order
+        const auto compareKey = [](const ea::pair<unsigned long long, unsigned>& cell, unsigned long long key) { return cell.first < key; };
+        auto iter = ea::lower_bound(cells_.begin(), cells_.end(), GetCellKey(x, minZ), compareKey);
+        const unsigned long long endKey = GetCellKey(x, maxZ);
+        for (; iter != cells_.end() && iter->first <= endKey; ++iter)
+        {
+            const InterestEntry& entry = entries_[iter->second];
+            if (entry.owner_ != connection && (entry.relevanceMask_ & interestMask)
+                && IsRelevant(entry, connection, direction, cosHalfAngle))
+                dest.push_back(&entry);
+        }
+    }
+}
+
+const InterestEntry* InterestManager::FindEntry(unsigned nodeID) const
+{
+    const auto iter = entryIndices_.find(nodeID);
+    return iter != entryIndices_.end() ? &entries_[iter->second] : nullptr;
+}
+
+unsigned long long InterestManager::GetCellKey(int x, int z) const
+{
+    // Flip sign bits so that keys are ordered in the same way as coordinates
+    const auto ux = static_cast<unsigned long long>(static_cast<unsigned>(x) ^ 0x80000000u);
+    const auto uz = static_cast<unsigned long long>(static_cast<unsigned>(z) ^ 0x80000000u);
+    return (ux << 32u) | uz;
+}
+
+bool InterestManager::IsRelevant(const InterestEntry& entry, const Connection* connection, const Vector3& direction,
+    float cosHalfAngle) const
+{
+    const Vector3 offset = entry.position_ - connection->GetPosition();
+    const float distanceSquared = offset.LengthSquared();
+    if (distanceSquared > relevanceRadius_ * relevanceRadius_)
+        return false;
+
+    if (viewAngle_ >= 360.0f || distanceSquared <= nearRadius_ * nearRadius_)
+        return true;
+
+    return direction.DotProduct(offset) >= cosHalfAngle * sqrtf(distanceSquared);
+}
+
+}
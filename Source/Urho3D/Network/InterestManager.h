@@ -0,0 +1,144 @@
+//
+// Copyright (c) 2017-2021 the rbfx project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+/// \file
+
+#pragma once
+
+#include "../Math/Vector3.h"
+#include "../Scene/Component.h"
+
+#include <EASTL/unordered_map.h>
+
+namespace Urho3D
+{
+
+class Connection;
+class NetworkPriority;
+
+/// Replicated node data gathered by InterestManager once per network update.
+struct InterestEntry
+{
+    /// Node.
+    Node* node_{};
+    /// Cached interest management settings of the node, if any.
+    NetworkPriority* priority_{};
+    /// Owner connection of the node.
+    Connection* owner_{};
+    /// World position of the node.
+    Vector3 position_;
+    /// Relevance mask.
+    unsigned relevanceMask_{};
+};
+
+/// %Network interest management component. Should be created in the server scene.
+/// Replicated nodes are sorted into a horizontal grid once per network update,
+/// so each connection receives updates only for nodes relevant to its observer,
+/// ranked by priority within the optional per-connection update budget.
+class URHO3D_API InterestManager : public Component
+{
+    URHO3D_OBJECT(InterestManager, Component);
+
+public:
+    /// Construct.
+    explicit InterestManager(Context* context);
+    /// Destruct.
+    ~InterestManager() override;
+    /// Register object factory.
+    /// @nobind
+    static void RegisterObject(Context* context);
+
+    /// Set size of grid cell in the XZ plane.
+    /// @property
+    void SetCellSize(float size);
+    /// Set radius around the observer within which nodes are relevant.
+    /// @property
+    void SetRelevanceRadius(float radius);
+    /// Set view angle in degrees. Nodes outside of observer view cone are relevant only within near radius. 360 disables the check.
+    /// @property
+    void SetViewAngle(float angle);
+    /// Set radius around the observer within which nodes are relevant regardless of view angle.
+    /// @property
+    void SetNearRadius(float radius);
+    /// Set max size in bytes of node updates sent to each connection per network update. 0 means unlimited.
+    /// @property
+    void SetUpdateBudget(unsigned bytes);
+
+    /// Return size of grid cell.
+    /// @property
+    float GetCellSize() const { return cellSize_; }
+
+    /// Return relevance radius.
+    /// @property
+    float GetRelevanceRadius() const { return relevanceRadius_; }
+
+    /// Return view angle in degrees.
+    /// @property
+    float GetViewAngle() const { return viewAngle_; }
+
+    /// Return near radius.
+    /// @property
+    float GetNearRadius() const { return nearRadius_; }
+
+    /// Return update budget in bytes.
+    /// @property
+    unsigned GetUpdateBudget() const { return updateBudget_; }
+
+    /// Gather replicated nodes and rebuild the grid. Called by Network once per update.
+    void Update();
+    /// Return nodes relevant to the connection. Safe to call from multiple threads after Update.
+    void QueryRelevantNodes(const Connection* connection, ea::vector<const InterestEntry*>& dest) const;
+    /// Return entry for the node, or null if the node is not tracked.
+    const InterestEntry* FindEntry(unsigned nodeID) const;
+
+private:
+    /// Return grid cell key for position.
+    unsigned long long GetCellKey(int x, int z) const;
+    /// Return whether the entry found in the grid is relevant to the observer.
+    bool IsRelevant(const InterestEntry& entry, const Connection* connection, const Vector3& direction, float cosHalfAngle) const;
+
+    /// Cell size.
+    float cellSize_;
+    /// Relevance radius.
+    float relevanceRadius_;
+    /// View angle.
+    float viewAngle_;
+    /// Near radius.
+    float nearRadius_;
+    /// Update budget.
+    unsigned updateBudget_;
+
+    /// Entries of replicated nodes.
+    ea::vector<InterestEntry> entries_;
+    /// Entry indices by node ID.
+    ea::unordered_map<unsigned, unsigned> entryIndices_;
+    /// Entry indices sorted by grid cell key.
+    ea::vector<ea::pair<unsigned long long, unsigned>> cells_;
+    /// Indices of entries which are relevant regardless of position.
+    ea::vector<unsigned> alwaysRelevant_;
+    /// Indices of entries which have owner connection.
+    ea::vector<unsigned> owned_;
+    /// Temporary node buffer.
+    ea::vector<Node*> nodes_;
+};
+
+}
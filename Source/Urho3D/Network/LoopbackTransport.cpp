@@ -0,0 +1,234 @@
+//
+// Copyright (c) 2017-2021 the rbfx project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "../Precompiled.h"
+
+#include "../Core/Context.h"
+#include "../IO/MemoryBuffer.h"
+#include "../Network/LoopbackTransport.h"
+
+#include <EASTL/sort.h>
+
+#include "../DebugNew.h"
+
+namespace Urho3D
+{
+
+namespace
+{
+
+/// Size of SLikeNet packet ID and Urho3D message ID preceding the message data.
+const unsigned PACKET_HEADER_SIZE = 1 + sizeof(unsigned);
+
+/// Connection transport endpoint of loopback link.
+class LoopbackTransport : public ConnectionTransport
+{
+public:
+    /// Construct.
+    LoopbackTransport(LoopbackLink* link, LoopbackLink::Direction direction)
+        : link_(link)
+        , direction_(direction)
+    {
+    }
+
+    /// Send packet.
+    void Send(PacketType type, const unsigned char* data, unsigned numBytes) override
+    {
+        if (link_)
+            link_->Send(direction_, type, data, numBytes);
+    }
+
+    /// Close connection.
+    void Close() override
+    {
+        if (link_)
+            link_->Close();
+    }
+
+    /// Return whether the connection is open.
+    bool IsConnected() const override { return link_ && link_->IsOpen(); }
+
+    /// Return round trip time in milliseconds.
+    float GetRoundTripTime() const override { return link_ ? link_->GetParams().latency_ * 2000.0f : 0.0f; }
+
+    /// Return bytes received per second.
+    float GetBytesInPerSec() const override
+    {
+        const auto incoming = direction_ == LoopbackLink::TO_CLIENT ? LoopbackLink::TO_SERVER : LoopbackLink::TO_CLIENT;
+        return GetAverageRate(link_ ? link_->GetStats(incoming).numBytesDelivered_ : 0);
+    }
+
+    /// Return bytes sent per second.
+    float GetBytesOutPerSec() const override { return GetAverageRate(link_ ? link_->GetStats(direction_).numBytesSent_ : 0); }
+
+private:
+    /// Return average rate over link lifetime.
+    float GetAverageRate(unsigned long long numBytes) const
+    {
+        const double time = link_ ? link_->GetTime() : 0.0;
+        return time > 0.0 ? static_cast<float>(numBytes / time) : 0.0f;
+    }
+
+    /// Link.
+    WeakPtr<LoopbackLink> link_;
+    /// Direction of sent packets.
+    const LoopbackLink::Direction direction_;
+};
+
+}
+
+LoopbackLink::LoopbackLink(Context* context, const LoopbackLinkParams& params, unsigned seed)
+    : params_(params)
+    , random_(seed)
+{
+    clientConnection_ = context->CreateObject<Connection>();
+    clientConnection_->Initialize(true, new LoopbackTransport(this, TO_CLIENT));
+
+    serverConnection_ = context->CreateObject<Connection>();
+    serverConnection_->Initialize(false, new LoopbackTransport(this, TO_SERVER));
+}
+
+LoopbackLink::~LoopbackLink() = default;
+
+void LoopbackLink::Send(Direction direction, PacketType type, const unsigned char* data, unsigned numBytes)
+{
+    if (!open_)
+        return;
+
+    DirectionState& state = directions_[direction];
+    ++state.stats_.numPacketsSent_;
+    state.stats_.numBytesSent_ += numBytes;
+    if (state.recordPackets_)
+        state.recordedData_.insert(state.recordedData_.end(), data, data + numBytes);
+
+    // Packets are serialized into the link one by one if bandwidth is limited
+    double sendTime = ea::max(time_, state.busyUntil_);
+    if (params_.bandwidth_ > 0)
+        sendTime += static_cast<double>(numBytes) / params_.bandwidth_;
+    state.busyUntil_ = sendTime;
+
+    const bool reliable = type == PT_RELIABLE_ORDERED || type == PT_RELIABLE_UNORDERED;
+    if (!reliable && state.dropUnreliable_)
+    {
+        ++state.stats_.numPacketsLost_;
+        return;
+    }
+
+    double deliveryTime = sendTime + params_.latency_ + random_.GetDouble(0.0, params_.jitter_);
+    while (random_.GetBool(params_.packetLoss_))
+    {
+        if (!reliable)
+        {
+            ++state.stats_.numPacketsLost_;
+            return;
+        }
+
+        // Lost reliable packet is resent when the loss is detected after round trip
+        ++state.stats_.numPacketsResent_;
+        state.stats_.numBytesSent_ += numBytes;
+        deliveryTime += 2.0 * params_.latency_ + random_.GetDouble(0.0, params_.jitter_);
+    }
+
+    if (type == PT_RELIABLE_ORDERED)
+    {
+        deliveryTime = ea::max(deliveryTime, state.orderedDeliveryTime_);
+        state.orderedDeliveryTime_ = deliveryTime;
+    }
+
+    Packet packet;
+    packet.deliveryTime_ = deliveryTime;
+    packet.sequence_ = state.nextSequence_++;
+    packet.type_ = type;
+    packet.data_.assign(data, data + numBytes);
+    state.packets_.push_back(ea::move(packet));
+}
+
+void LoopbackLink::Update(float timeStep)
+{
+    time_ += timeStep;
+
+    for (unsigned direction = 0; direction < NUM_DIRECTIONS; ++direction)
+    {
+        if (!open_)
+            return;
+
+        // Packets sent during delivery will be delivered on next update
+        ea::vector<Packet>& packets = directions_[direction].packets_;
+        const auto isArrived = [this](const Packet& packet) { return packet.deliveryTime_ <= time_; };
+        const auto firstPending = ea::stable_partition(packets.begin(), packets.end(), isArrived);
+
+        arrivedPackets_.clear();
+        ea::move(packets.begin(), firstPending, ea::back_inserter(arrivedPackets_));
+        packets.erase(packets.begin(), firstPending);
+
+        ea::sort(arrivedPackets_.begin(), arrivedPackets_.end(), [](const Packet& lhs, const Packet& rhs)
+        {
+            return lhs.deliveryTime_ != rhs.deliveryTime_ ? lhs.deliveryTime_ < rhs.deliveryTime_ : lhs.sequence_ < rhs.sequence_;
+        });
+
+        for (const Packet& packet : arrivedPackets_)
+        {
+            if (!open_)
+                break;
+            Deliver(static_cast<Direction>(direction), packet);
+        }
+    }
+}
+
+void LoopbackLink::Close()
+{
+    open_ = false;
+    for (DirectionState& state : directions_)
+        state.packets_.clear();
+}
+
+void LoopbackLink::Deliver(Direction direction, const Packet& packet)
+{
+    DirectionState& state = directions_[direction];
+
+    // Sequenced packets older than already delivered one are discarded
+    if (packet.type_ == PT_UNRELIABLE_ORDERED)
+    {
+        if (state.hasSequenced_ && packet.sequence_ < state.lastSequenced_)
+        {
+            ++state.stats_.numPacketsDiscarded_;
+            return;
+        }
+        state.hasSequenced_ = true;
+        state.lastSequenced_ = packet.sequence_;
+    }
+
+    ++state.stats_.numPacketsDelivered_;
+    state.stats_.numBytesDelivered_ += packet.data_.size();
+
+    if (packet.data_.size() < PACKET_HEADER_SIZE)
+        return;
+
+    // Keep the receiver alive during processing
+    SharedPtr<Connection> receiver{ direction == TO_CLIENT ? serverConnection_ : clientConnection_ };
+    MemoryBuffer header(packet.data_.data() + 1, sizeof(unsigned));
+    const unsigned msgID = header.ReadUInt();
+    MemoryBuffer msg(packet.data_.data() + PACKET_HEADER_SIZE, packet.data_.size() - PACKET_HEADER_SIZE);
+    receiver->ProcessMessage(static_cast<int>(msgID), msg);
+}
+
+}
@@ -0,0 +1,175 @@
+//
+// Copyright (c) 2017-2021 the rbfx project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+/// \file
+
+#pragma once
+
+#include "../Container/Ptr.h"
+#include "../Math/RandomEngine.h"
+#include "../Network/NetworkTransport.h"
+
+#include <EASTL/vector.h>
+
+namespace Urho3D
+{
+
+/// Simulated properties of loopback link, applied in both directions.
+struct LoopbackLinkParams
+{
+    /// One-way latency in seconds.
+    float latency_{};
+    /// Max random extra latency in seconds. Unordered packets may arrive out of order.
+    float jitter_{};
+    /// Packet loss probability. Lost reliable packets are resent after round trip time.
+    float packetLoss_{};
+    /// Bandwidth in bytes per second. Zero is unlimited.
+    unsigned bandwidth_{};
+};
+
+/// Statistics of one direction of loopback link.
+struct LoopbackLinkStats
+{
+    /// Number of sent packets.
+    unsigned numPacketsSent_{};
+    /// Number of delivered packets.
+    unsigned numPacketsDelivered_{};
+    /// Number of lost unreliable packets.
+    unsigned numPacketsLost_{};
+    /// Number of sequenced packets discarded because newer packet was already delivered.
+    unsigned numPacketsDiscarded_{};
+    /// Number of lost reliable packets that were resent.
+    unsigned numPacketsResent_{};
+    /// Number of sent bytes, including resent packets.
+    unsigned long long numBytesSent_{};
+    /// Number of delivered bytes.
+    unsigned long long numBytesDelivered_{};
+};
+
+/// Deterministic in-process link between client connection on the server and server connection on the client.
+/// Link time is advanced explicitly and all randomness is seeded, so results don't depend on wall clock.
+class URHO3D_API LoopbackLink : public RefCounted
+{
+public:
+    /// Direction of packet transfer.
+    enum Direction
+    {
+        TO_CLIENT,
+        TO_SERVER,
+        NUM_DIRECTIONS
+    };
+
+    /// Construct connections.
+    LoopbackLink(Context* context, const LoopbackLinkParams& params, unsigned seed = 0);
+    /// Destruct.
+    ~LoopbackLink() override;
+
+    /// Advance link time and deliver arrived packets to connections.
+    void Update(float timeStep);
+    /// Close link. Packets in flight are discarded.
+    void Close();
+    /// Set whether all unreliable packets sent in specified direction are lost.
+    void SetDropUnreliablePackets(Direction direction, bool drop) { directions_[direction].dropUnreliable_ = drop; }
+    /// Set whether data of packets sent in specified direction is recorded.
+    void SetRecordPackets(Direction direction, bool record) { directions_[direction].recordPackets_ = record; }
+    /// Discard recorded data of specified direction.
+    void ClearRecordedData(Direction direction) { directions_[direction].recordedData_.clear(); }
+
+    /// Return connection on the server side, which represents remote client.
+    Connection* GetClientConnection() const { return clientConnection_; }
+    /// Return connection on the client side, which represents remote server.
+    Connection* GetServerConnection() const { return serverConnection_; }
+    /// Return link parameters.
+    const LoopbackLinkParams& GetParams() const { return params_; }
+    /// Return link time in seconds.
+    double GetTime() const { return time_; }
+    /// Return whether the link is open.
+    bool IsOpen() const { return open_; }
+    /// Return statistics of specified direction.
+    const LoopbackLinkStats& GetStats(Direction direction) const { return directions_[direction].stats_; }
+    /// Return data of all packets sent in specified direction while recording, in order of sending.
+    const ByteVector& GetRecordedData(Direction direction) const { return directions_[direction].recordedData_; }
+
+    /// Enqueue packet. Called by connection transport.
+    void Send(Direction direction, PacketType type, const unsigned char* data, unsigned numBytes);
+
+private:
+    /// Packet in flight.
+    struct Packet
+    {
+        /// Time of delivery.
+        double deliveryTime_{};
+        /// Sequence number within direction.
+        unsigned sequence_{};
+        /// Packet type.
+        PacketType type_{};
+        /// Packet data.
+        ByteVector data_;
+    };
+
+    /// State of one direction.
+    struct DirectionState
+    {
+        /// Packets in flight.
+        ea::vector<Packet> packets_;
+        /// Time when the link is free to send next packet.
+        double busyUntil_{};
+        /// Latest delivery time of reliable ordered packets.
+        double orderedDeliveryTime_{};
+        /// Next sequence number.
+        unsigned nextSequence_{};
+        /// Sequence number of the latest delivered sequenced packet.
+        unsigned lastSequenced_{};
+        /// Whether any sequenced packet was delivered.
+        bool hasSequenced_{};
+        /// Whether all unreliable packets are lost.
+        bool dropUnreliable_{};
+        /// Whether sent data is recorded.
+        bool recordPackets_{};
+        /// Recorded data.
+        ByteVector recordedData_;
+        /// Statistics.
+        LoopbackLinkStats stats_;
+    };
+
+    /// Deliver packet to the connection.
+    void Deliver(Direction direction, const Packet& packet);
+
+    /// Link parameters.
+    const LoopbackLinkParams params_;
+    /// Random generator for loss and jitter.
+    RandomEngine random_;
+    /// Client connection on the server side.
+    SharedPtr<Connection> clientConnection_;
+    /// Server connection on the client side.
+    SharedPtr<Connection> serverConnection_;
+    /// Direction states.
+    DirectionState directions_[NUM_DIRECTIONS];
+    /// Packets arrived during current update.
+    ea::vector<Packet> arrivedPackets_;
+    /// Link time.
+    double time_{};
+    /// Whether the link is open.
+    bool open_{ true };
+};
+
+}
@@ -25,6 +25,7 @@
 #include "../Core/Context.h"
 #include "../Core/CoreEvents.h"
 #include "../Core/Profiler.h"
+#include "../Core/WorkQueue.h"
 #include "../Engine/EngineEvents.h"
 #include "../IO/FileSystem.h"
 #include "../Input/InputEvents.h"
@@ -32,6 +33,7 @@
 #include "../IO/Log.h"
 #include "../IO/MemoryBuffer.h"
 #include "../Network/HttpRequest.h"
+#include "../Network/InterestManager.h"
 #include "../Network/Network.h"
 #include "../Network/NetworkEvents.h"
 #include "../Network/NetworkPriority.h"
@@ -311,6 +313,7 @@ void Network::NewConnectionEstablished(const SLNet::AddressOrGUID& connection)
     SharedPtr<Connection> newConnection(context_->CreateObject<Connection>());
     newConnection->Initialize(true, connection, rakPeer_);
     newConnection->ConfigureNetworkSimulator(simulatedLatency_, simulatedPacketLoss_);
+    newConnection->SetSnapshotReplication(snapshotReplication_);
     clientConnections_[GetEndpointHash(connection)] = newConnection;
     URHO3D_LOGINFO("Client " + newConnection->ToString() + " connected");
 
@@ -577,6 +580,13 @@ void Network::SetUpdateFps(int fps)
     updateAcc_ = 0.0f;
 }
 
+void Network::SetSnapshotReplication(bool enable)
+{
+    snapshotReplication_ = enable;
+    for (auto i = clientConnections_.begin(); i != clientConnections_.end(); ++i)
+        i->second->SetSnapshotReplication(enable);
+}
+
 void Network::SetSimulatedLatency(int ms)
 {
     simulatedLatency_ = Max(ms, 0);
@@ -937,16 +947,32 @@ void Network::PostUpdate(float timeStep)
                 }
 
                 for (auto i = networkScenes_.begin(); i != networkScenes_.end(); ++i)
+                {
                     (*i)->PrepareNetworkUpdate();
+                    if (auto* interestManager = (*i)->GetComponent<InterestManager>())
+                        interestManager->Update();
+                }
+            }
+
+            {
+                URHO3D_PROFILE("BuildServerUpdate");
+
+                // Then build server updates for each client connection in worker threads.
+                // Serialized attribute data is shared between connections
+                updateConnections_.clear();
+                for (auto i = clientConnections_.begin(); i != clientConnections_.end(); ++i)
+                    updateConnections_.push_back(i->second);
+
+                ForEachParallel(GetSubsystem<WorkQueue>(), 1, updateConnections_,
+                    [](unsigned /*index*/, Connection* connection) { connection->BuildServerUpdate(); });
             }
 
             {
                 URHO3D_PROFILE("SendServerUpdate");
 
-                // Then send server updates for each client connection
                 for (auto i = clientConnections_.begin(); i != clientConnections_.end(); ++i)
                 {
-                    i->second->SendServerUpdate();
+                    i->second->FinishServerUpdate();
                     i->second->SendRemoteEvents();
                     i->second->SendPackages();
                     i->second->SendAllBuffers();
@@ -1035,6 +1061,7 @@ unsigned long Network::GetEndpointHash(const SLNet::AddressOrGUID& endpoint)
 void RegisterNetworkLibrary(Context* context)
 {
     NetworkPriority::RegisterObject(context);
+    InterestManager::RegisterObject(context);
     Connection::RegisterObject(context);
 }
 
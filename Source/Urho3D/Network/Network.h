@@ -89,6 +89,9 @@ public:
     /// Set network update FPS.
     /// @property
     void SetUpdateFps(int fps);
+    /// Set whether client connections send latest data as deltas against snapshots acknowledged by the client.
+    /// @property
+    void SetSnapshotReplication(bool enable);
     /// Set simulated latency in milliseconds. This adds a fixed delay before sending each packet.
     /// @property
     void SetSimulatedLatency(int ms);
@@ -114,6 +117,10 @@ public:
     /// @property
     int GetUpdateFps() const { return updateFps_; }
 
+    /// Return whether client connections use snapshot replication.
+    /// @property
+    bool GetSnapshotReplication() const { return snapshotReplication_; }
+
     /// Return simulated latency in milliseconds.
     /// @property
     int GetSimulatedLatency() const { return simulatedLatency_; }
@@ -175,12 +182,16 @@ private:
     ea::hash_set<StringHash> blacklistedRemoteEvents_;
     /// Networked scenes.
     ea::hash_set<Scene*> networkScenes_;
+    /// Client connections updated during current network update.
+    ea::vector<Connection*> updateConnections_;
     /// Update FPS.
     int updateFps_;
     /// Simulated latency (send delay) in milliseconds.
     int simulatedLatency_;
     /// Simulated packet loss probability between 0.0 - 1.0.
     float simulatedPacketLoss_;
+    /// Snapshot replication flag for client connections.
+    bool snapshotReplication_{};
     /// Update time interval.
     float updateInterval_;
     /// Update time accumulator.
@@ -36,13 +36,16 @@ static const float DEFAULT_BASE_PRIORITY = 100.0f;
 static const float DEFAULT_DISTANCE_FACTOR = 0.0f;
 static const float DEFAULT_MIN_PRIORITY = 0.0f;
 static const float UPDATE_THRESHOLD = 100.0f;
+static const unsigned DEFAULT_RELEVANCE_MASK = M_MAX_UNSIGNED;
 
 NetworkPriority::NetworkPriority(Context* context) :
     Component(context),
     basePriority_(DEFAULT_BASE_PRIORITY),
     distanceFactor_(DEFAULT_DISTANCE_FACTOR),
     minPriority_(DEFAULT_MIN_PRIORITY),
-    alwaysUpdateOwner_(true)
+    alwaysUpdateOwner_(true),
+    relevanceMask_(DEFAULT_RELEVANCE_MASK),
+    alwaysRelevant_(false)
 {
 }
 
@@ -56,6 +59,8 @@ void NetworkPriority::RegisterObject(Context* context)
     URHO3D_ATTRIBUTE("Distance Factor", float, distanceFactor_, DEFAULT_DISTANCE_FACTOR, AM_DEFAULT);
     URHO3D_ATTRIBUTE("Minimum Priority", float, minPriority_, DEFAULT_MIN_PRIORITY, AM_DEFAULT);
     URHO3D_ATTRIBUTE("Always Update Owner", bool, alwaysUpdateOwner_, true, AM_DEFAULT);
+    URHO3D_ATTRIBUTE("Relevance Mask", unsigned, relevanceMask_, DEFAULT_RELEVANCE_MASK, AM_DEFAULT);
+    URHO3D_ATTRIBUTE("Always Relevant", bool, alwaysRelevant_, false, AM_DEFAULT);
 }
 
 void NetworkPriority::SetBasePriority(float priority)
@@ -82,10 +87,21 @@ void NetworkPriority::SetAlwaysUpdateOwner(bool enable)
     MarkNetworkUpdate();
 }
 
+void NetworkPriority::SetRelevanceMask(unsigned mask)
+{
+    relevanceMask_ = mask;
+    MarkNetworkUpdate();
+}
+
+void NetworkPriority::SetAlwaysRelevant(bool enable)
+{
+    alwaysRelevant_ = enable;
+    MarkNetworkUpdate();
+}
+
 bool NetworkPriority::CheckUpdate(float distance, float& accumulator)
 {
-    float currentPriority = Max(basePriority_ - distanceFactor_ * distance, minPriority_);
-    accumulator += currentPriority;
+    accumulator += GetPriority(distance);
     if (accumulator >= UPDATE_THRESHOLD)
     {
         accumulator = fmodf(accumulator, UPDATE_THRESHOLD);
@@ -53,6 +53,12 @@ public:
     /// Set whether updates to owner should be sent always at full rate. Default true.
     /// @property
     void SetAlwaysUpdateOwner(bool enable);
+    /// Set relevance mask. Node is relevant only to connections with matching interest mask. Used by InterestManager.
+    /// @property
+    void SetRelevanceMask(unsigned mask);
+    /// Set whether node is relevant to all connections regardless of distance. Used by InterestManager.
+    /// @property
+    void SetAlwaysRelevant(bool enable);
 
     /// Return base priority.
     /// @property
@@ -70,6 +76,16 @@ public:
     /// @property
     bool GetAlwaysUpdateOwner() const { return alwaysUpdateOwner_; }
 
+    /// Return relevance mask.
+    /// @property
+    unsigned GetRelevanceMask() const { return relevanceMask_; }
+
+    /// Return whether node is relevant to all connections regardless of distance.
+    /// @property
+    bool GetAlwaysRelevant() const { return alwaysRelevant_; }
+
+    /// Return priority at given distance.
+    float GetPriority(float distance) const { return Max(basePriority_ - distanceFactor_ * distance, minPriority_); }
     /// Increment and check priority accumulator. Return true if should update. Called by Connection.
     bool CheckUpdate(float distance, float& accumulator);
 
@@ -82,6 +98,10 @@ private:
     float minPriority_;
     /// Update owner at full rate flag.
     bool alwaysUpdateOwner_;
+    /// Relevance mask.
+    unsigned relevanceMask_;
+    /// Always relevant flag.
+    bool alwaysRelevant_;
 };
 
 }
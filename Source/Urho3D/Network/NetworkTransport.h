@@ -0,0 +1,52 @@
+//
+// Copyright (c) 2017-2021 the rbfx project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+/// \file
+
+#pragma once
+
+#include "../Network/Connection.h"
+
+namespace Urho3D
+{
+
+/// Custom packet transport of a connection. Connections without transport use SLikeNet peer.
+/// Transport is responsible for delivering packets into Connection::ProcessMessage on the remote side.
+class URHO3D_API ConnectionTransport : public RefCounted
+{
+public:
+    /// Send packet. Data contains SLikeNet-compatible packet header followed by the message.
+    virtual void Send(PacketType type, const unsigned char* data, unsigned numBytes) = 0;
+    /// Close connection.
+    virtual void Close() = 0;
+
+    /// Return whether the connection is open.
+    virtual bool IsConnected() const = 0;
+    /// Return round trip time in milliseconds.
+    virtual float GetRoundTripTime() const = 0;
+    /// Return bytes received per second.
+    virtual float GetBytesInPerSec() const = 0;
+    /// Return bytes sent per second.
+    virtual float GetBytesOutPerSec() const = 0;
+};
+
+}
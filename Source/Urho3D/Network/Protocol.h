@@ -63,6 +63,10 @@ static const int MSG_REMOTEEVENT = 0x96;
 static const int MSG_REMOTENODEEVENT = 0x97;
 /// Server->client: info about package.
 static const int MSG_PACKAGEINFO = 0x98;
+/// Server->client: node and component attributes as delta against acknowledged snapshots. Used in snapshot replication mode.
+static const int MSG_SCENESNAPSHOT = 0x9A;
+/// Client->server: acknowledge received scene snapshot.
+static const int MSG_SNAPSHOTACK = 0x9B;
 
 /// Packet that includes all the above messages
 static const int MSG_PACKED_MESSAGE = 0x99;
@@ -0,0 +1,136 @@
+//
+// Copyright (c) 2017-2021 the rbfx project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "../Precompiled.h"
+
+#include "../IO/Deserializer.h"
+#include "../IO/Serializer.h"
+#include "../Network/SnapshotDelta.h"
+
+#include "../DebugNew.h"
+
+namespace Urho3D
+{
+
+namespace
+{
+
+/// Size of the block covered by one byte mask.
+const unsigned BLOCK_SIZE = 8;
+/// Number of blocks covered by one block mask.
+const unsigned GROUP_SIZE = 8;
+
+/// Return XOR of data and base bytes. Base is treated as zero-padded.
+unsigned char GetDelta(ea::span<const unsigned char> data, ea::span<const unsigned char> base, unsigned index)
+{
+    return index < base.size() ? data[index] ^ base[index] : data[index];
+}
+
+}
+
+void WriteSnapshotDelta(Serializer& dest, ea::span<const unsigned char> data, ea::span<const unsigned char> base)
+{
+    const unsigned size = data.size();
+    const unsigned numBlocks = (size + BLOCK_SIZE - 1) / BLOCK_SIZE;
+    dest.WriteVLE(size);
+
+    for (unsigned groupBegin = 0; groupBegin < numBlocks; groupBegin += GROUP_SIZE)
+    {
+        const unsigned groupEnd = ea::min(groupBegin + GROUP_SIZE, numBlocks);
+
+        unsigned char blockMasks[GROUP_SIZE]{};
+        unsigned char groupMask = 0;
+        for (unsigned block = groupBegin; block < groupEnd; ++block)
+        {
+            const unsigned blockEnd = ea::min((block + 1) * BLOCK_SIZE, size);
+            for (unsigned index = block * BLOCK_SIZE; index < blockEnd; ++index)
+            {
+                if (GetDelta(data, base, index))
+                    blockMasks[block - groupBegin] |= 1u << (index % BLOCK_SIZE);
+            }
+            if (blockMasks[block - groupBegin])
+                groupMask |= 1u << (block - groupBegin);
+        }
+
+        dest.WriteUByte(groupMask);
+        for (unsigned block = groupBegin; block < groupEnd; ++block)
+        {
+            const unsigned char blockMask = blockMasks[block - groupBegin];
+            if (!blockMask)
+                continue;
+
+            dest.WriteUByte(blockMask);
+            const unsigned blockEnd = ea::min((block + 1) * BLOCK_SIZE, size);
+            for (unsigned index = block * BLOCK_SIZE; index < blockEnd; ++index)
+            {
+                if (blockMask & (1u << (index % BLOCK_SIZE)))
+                    dest.WriteUByte(GetDelta(data, base, index));
+            }
+        }
+    }
+}
+
+bool ReadSnapshotDelta(Deserializer& source, ea::span<const unsigned char> base, ByteVector& data)
+{
+    const unsigned size = source.ReadVLE();
+    const unsigned numBlocks = (size + BLOCK_SIZE - 1) / BLOCK_SIZE;
+    const unsigned numGroups = (numBlocks + GROUP_SIZE - 1) / GROUP_SIZE;
+    if (numGroups > source.GetSize() - source.GetPosition())
+        return false;
+
+    data.resize(size);
+    for (unsigned index = 0; index < size; ++index)
+        data[index] = index < base.size() ? base[index] : 0;
+
+    for (unsigned groupBegin = 0; groupBegin < numBlocks; groupBegin += GROUP_SIZE)
+    {
+        const unsigned groupEnd = ea::min(groupBegin + GROUP_SIZE, numBlocks);
+        if (source.IsEof())
+            return false;
+
+        const unsigned char groupMask = source.ReadUByte();
+        for (unsigned block = groupBegin; block < groupEnd; ++block)
+        {
+            if (!(groupMask & (1u << (block - groupBegin))))
+                continue;
+
+            if (source.IsEof())
+                return false;
+
+            const unsigned char blockMask = source.ReadUByte();
+            const unsigned blockEnd = ea::min((block + 1) * BLOCK_SIZE, size);
+            for (unsigned index = block * BLOCK_SIZE; index < blockEnd; ++index)
+            {
+                if (blockMask & (1u << (index % BLOCK_SIZE)))
+                {
+                    if (source.IsEof())
+                        return false;
+                    data[index] ^= source.ReadUByte();
+                }
+            }
+        }
+    }
+
+    return true;
+}
+
+}
@@ -0,0 +1,44 @@
+//
+// Copyright (c) 2017-2021 the rbfx project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+/// \file
+
+#pragma once
+
+#include "../Container/ByteVector.h"
+
+#include <EASTL/span.h>
+
+namespace Urho3D
+{
+
+class Deserializer;
+class Serializer;
+
+/// Write data as XOR difference against base data, which is treated as zero-padded to the size of data.
+/// Differences are bit-packed: each group of 64 bytes is preceded by a mask of non-zero 8-byte blocks,
+/// each non-zero block is preceded by a mask of non-zero bytes, and only non-zero bytes are written.
+URHO3D_API void WriteSnapshotDelta(Serializer& dest, ea::span<const unsigned char> data, ea::span<const unsigned char> base);
+/// Read data written by WriteSnapshotDelta using the same base data. Return false if the source data is malformed.
+URHO3D_API bool ReadSnapshotDelta(Deserializer& source, ea::span<const unsigned char> base, ByteVector& data);
+
+}
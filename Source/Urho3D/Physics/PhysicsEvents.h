@@ -76,6 +76,13 @@ URHO3D_EVENT(E_PHYSICSCOLLISIONEND, PhysicsCollisionEnd)
     URHO3D_PARAM(P_TRIGGER, Trigger);              // bool
 }
 
+/// Contact stream of the physics step is updated. Global event sent by the PhysicsWorld once per step, before per-pair collision events.
+/// Collisions and contacts can be read from PhysicsWorld.
+URHO3D_EVENT(E_PHYSICSCONTACTS, PhysicsContacts)
+{
+    URHO3D_PARAM(P_WORLD, World);                  // PhysicsWorld pointer
+}
+
 /// Node's physics collision started. Sent by scene nodes participating in a collision.
 URHO3D_EVENT(E_NODECOLLISIONSTART, NodeCollisionStart)
 {
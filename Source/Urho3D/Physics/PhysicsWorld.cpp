@@ -27,6 +27,7 @@
 #include "../Core/Context.h"
 #include "../Core/Mutex.h"
 #include "../Core/Profiler.h"
+#include "../Core/WorkQueue.h"
 #include "../Graphics/DebugRenderer.h"
 #include "../Graphics/Model.h"
 #include "../IO/Log.h"
@@ -42,17 +43,25 @@
 #include "../Scene/SceneEvents.h"
 
 #include <Bullet/BulletCollision/BroadphaseCollision/btDbvtBroadphase.h>
+#include <Bullet/BulletCollision/CollisionDispatch/btCollisionDispatcherMt.h>
 #include <Bullet/BulletCollision/CollisionDispatch/btDefaultCollisionConfiguration.h>
 #include <Bullet/BulletCollision/CollisionDispatch/btInternalEdgeUtility.h>
 #include <Bullet/BulletCollision/CollisionShapes/btBoxShape.h>
 #include <Bullet/BulletCollision/CollisionShapes/btSphereShape.h>
 #include <Bullet/BulletCollision/Gimpact/btGImpactCollisionAlgorithm.h>
 #include <Bullet/BulletDynamics/ConstraintSolver/btSequentialImpulseConstraintSolver.h>
+#include <Bullet/BulletDynamics/ConstraintSolver/btSequentialImpulseConstraintSolverMt.h>
 #include <Bullet/BulletDynamics/Dynamics/btDiscreteDynamicsWorld.h>
+#include <Bullet/BulletDynamics/Dynamics/btDiscreteDynamicsWorldMt.h>
+#include <Bullet/LinearMath/btThreads.h>
 
 
 extern ContactAddedCallback gContactAddedCallback;
 
+// Defined in btThreads.cpp but not exposed in headers, task schedulers use them to detect nested loops
+void btPushThreadsAreRunning();
+void btPopThreadsAreRunning();
+
 namespace Urho3D
 {
 
@@ -108,6 +117,31 @@ void RemoveCachedGeometryImpl(CollisionGeometryDataCache& cache, Model* model)
     }
 }
 
+static bool IsCollisionReported(const RigidBody* bodyA, const RigidBody* bodyB)
+{
+    // Skip collision event signaling if both objects are static, or if collision event mode does not match
+    if (bodyA->GetMass() == 0.0f && bodyB->GetMass() == 0.0f)
+        return false;
+    if (bodyA->GetCollisionEventMode() == COLLISION_NEVER || bodyB->GetCollisionEventMode() == COLLISION_NEVER)
+        return false;
+    if (bodyA->GetCollisionEventMode() == COLLISION_ACTIVE && bodyB->GetCollisionEventMode() == COLLISION_ACTIVE &&
+        !bodyA->IsActive() && !bodyB->IsActive())
+        return false;
+    return true;
+}
+
+static void WriteContacts(VectorBuffer& buffer, ea::span<const PhysicsContact> contacts, bool flipNormals)
+{
+    buffer.Clear();
+    for (const PhysicsContact& contact : contacts)
+    {
+        buffer.WriteVector3(contact.position_);
+        buffer.WriteVector3(flipNormals ? -contact.normal_ : contact.normal_);
+        buffer.WriteFloat(contact.distance_);
+        buffer.WriteFloat(contact.impulse_);
+    }
+}
+
 void CleanupGeometryCacheImpl(CollisionGeometryDataCache& cache)
 {
     for (auto i = cache.begin(); i != cache.end();)
@@ -147,6 +181,164 @@ struct PhysicsQueryCallback : public btCollisionWorld::ContactResultCallback
     unsigned collisionMask_;
 };
 
+/// Bullet task scheduler that executes parallel loops in WorkQueue threads.
+class WorkQueueTaskScheduler : public btITaskScheduler
+{
+public:
+    /// Construct.
+    WorkQueueTaskScheduler(WorkQueue* workQueue, unsigned maxThreads) :
+        btITaskScheduler("WorkQueue"),
+        workQueue_(workQueue),
+        maxNumThreads_(static_cast<int>(Min(workQueue->GetNumThreads() + 1, BT_MAX_THREAD_COUNT))),
+        numThreads_(maxThreads ? Clamp(static_cast<int>(maxThreads), 1, maxNumThreads_) : maxNumThreads_)
+    {
+    }
+
+    /// Return maximum number of threads.
+    int getMaxNumThreads() const override { return maxNumThreads_; }
+    /// Return upper bound of Bullet thread index. Bullet assigns indices to all threads that have ever called it,
+    /// and sizes per-thread storage and batches with this value. It's kept constant so the results don't depend on thread count.
+    int getNumThreads() const override { return BT_MAX_THREAD_COUNT; }
+    /// Limit number of threads used by parallel loops.
+    void setNumThreads(int numThreads) override { numThreads_ = Clamp(numThreads, 1, maxNumThreads_); }
+    /// Return number of threads used by parallel loops.
+    int GetNumThreads() const { return numThreads_; }
+
+    /// Execute parallel loop.
+    void parallelFor(int iBegin, int iEnd, int grainSize, const btIParallelForBody& body) override
+    {
+        Dispatch(iBegin, iEnd, grainSize, [&body](int beginIndex, int endIndex)
+        {
+            body.forLoop(beginIndex, endIndex);
+            return btScalar(0);
+        });
+    }
+
+    /// Execute parallel loop and return sum of results.
+    btScalar parallelSum(int iBegin, int iEnd, int grainSize, const btIParallelSumBody& body) override
+    {
+        return Dispatch(iBegin, iEnd, grainSize, [&body](int beginIndex, int endIndex)
+        {
+            return body.sumLoop(beginIndex, endIndex);
+        });
+    }
+
+private:
+    /// Split range into buckets and process them in WorkQueue threads. Results are summed in order of buckets.
+    template <class Callback>
+    btScalar Dispatch(int iBegin, int iEnd, int grainSize, const Callback& callback)
+    {
+        const int bucket = Max(grainSize, 1);
+        const int numBuckets = (iEnd - iBegin + bucket - 1) / bucket;
+
+        // Nested loops and loops started outside of main thread are executed in place
+        if (numBuckets <= 1 || numThreads_ <= 1 || btThreadsAreRunning() || WorkQueue::GetThreadIndex() != 0)
+            return iBegin < iEnd ? callback(iBegin, iEnd) : btScalar(0);
+
+        struct ParallelContext
+        {
+            const Callback* callback_;
+            btScalar* results_;
+            std::atomic<int> nextBucket_;
+            int begin_;
+            int end_;
+            int bucket_;
+            int numBuckets_;
+        };
+
+        bucketResults_.resize(numBuckets);
+        ParallelContext parallelContext{ &callback, bucketResults_.data(), 0, iBegin, iEnd, bucket, numBuckets };
+        const auto workFunction = [](const WorkItem* item, unsigned /*threadIndex*/)
+        {
+            auto& ctx = *static_cast<ParallelContext*>(item->aux_);
+            // Threads beyond Bullet limit cannot use per-thread storage, leave work to others
+            if (btGetCurrentThreadIndex() >= BT_MAX_THREAD_COUNT)
+                return;
+
+            while (true)
+            {
+                const int bucketIndex = ctx.nextBucket_.fetch_add(1, std::memory_order_relaxed);
+                if (bucketIndex >= ctx.numBuckets_)
+                    break;
+
+                const int beginIndex = ctx.begin_ + bucketIndex * ctx.bucket_;
+                const int endIndex = Min(beginIndex + ctx.bucket_, ctx.end_);
+                ctx.results_[bucketIndex] = (*ctx.callback_)(beginIndex, endIndex);
+            }
+        };
+
+        btPushThreadsAreRunning();
+        const int numItems = Min(numThreads_, numBuckets);
+        workItems_.clear();
+        for (int i = 0; i < numItems; ++i)
+        {
+            SharedPtr<WorkItem> item = workQueue_->GetFreeItem();
+            item->workFunction_ = workFunction;
+            item->aux_ = &parallelContext;
+            item->priority_ = M_MAX_UNSIGNED;
+            workQueue_->AddWorkItem(item);
+            workItems_.push_back(item);
+        }
+        // Wait only for own items, unrelated immediate work may be in flight
+        workQueue_->CompleteItems(workItems_);
+        workItems_.clear();
+        btPopThreadsAreRunning();
+
+        btScalar sum = 0;
+        for (int i = 0; i < numBuckets; ++i)
+            sum += bucketResults_[i];
+        return sum;
+    }
+
+    /// Work queue.
+    WorkQueue* workQueue_{};
+    /// Number of threads that may call Bullet.
+    int maxNumThreads_{};
+    /// Number of threads used by parallel loops.
+    int numThreads_{};
+    /// Results of buckets of the current loop.
+    ea::vector<btScalar> bucketResults_;
+    /// Work items of the current loop.
+    ea::vector<SharedPtr<WorkItem>> workItems_;
+};
+
+/// Multithreaded collision dispatcher that keeps order of new contact manifolds independent of thread scheduling.
+class DeterministicCollisionDispatcherMt : public btCollisionDispatcherMt
+{
+public:
+    /// Construct.
+    explicit DeterministicCollisionDispatcherMt(btCollisionConfiguration* config) :
+        btCollisionDispatcherMt(config)
+    {
+    }
+
+    /// Dispatch collision pairs in parallel.
+    void dispatchAllCollisionPairs(btOverlappingPairCache* pairCache, const btDispatcherInfo& info, btDispatcher* dispatcher) override
+    {
+        const int numOldManifolds = m_manifoldsPtr.size();
+        btCollisionDispatcherMt::dispatchAllCollisionPairs(pairCache, info, dispatcher);
+
+        // New manifolds are appended in order of threads, sort them by broadphase IDs of bodies
+        const int numManifolds = m_manifoldsPtr.size();
+        if (numManifolds - numOldManifolds < 2)
+            return;
+
+        btPersistentManifold** manifolds = &m_manifoldsPtr[0];
+        ea::sort(manifolds + numOldManifolds, manifolds + numManifolds,
+            [](const btPersistentManifold* lhs, const btPersistentManifold* rhs)
+        {
+            const int lhsId0 = lhs->getBody0()->getBroadphaseHandle()->m_uniqueId;
+            const int rhsId0 = rhs->getBody0()->getBroadphaseHandle()->m_uniqueId;
+            if (lhsId0 != rhsId0)
+                return lhsId0 < rhsId0;
+            return lhs->getBody1()->getBroadphaseHandle()->m_uniqueId < rhs->getBody1()->getBroadphaseHandle()->m_uniqueId;
+        });
+
+        for (int i = numOldManifolds; i < numManifolds; ++i)
+            m_manifoldsPtr[i]->m_index1a = i;
+    }
+};
+
 PhysicsWorld::PhysicsWorld(Context* context) :
     Component(context),
     fps_(DEFAULT_FPS),
@@ -159,12 +351,41 @@ PhysicsWorld::PhysicsWorld(Context* context) :
     else
         collisionConfiguration_ = new btDefaultCollisionConfiguration();
 
-    collisionDispatcher_ = ea::make_unique<btCollisionDispatcher>(collisionConfiguration_);
+    if (PhysicsWorld::config.multiThreaded_)
+    {
+#if BT_THREADSAFE
+        // Task scheduler should be set before the dispatcher is created, the dispatcher allocates per-thread storage
+        if (auto workQueue = GetSubsystem<WorkQueue>())
+        {
+            taskScheduler_ = ea::make_unique<WorkQueueTaskScheduler>(workQueue, PhysicsWorld::config.maxThreads_);
+            btSetTaskScheduler(taskScheduler_.get());
+        }
+#else
+        URHO3D_LOGWARNING("Multithreaded physics requires URHO3D_PHYSICS_THREADING build option, single thread is used");
+#endif
+    }
+
+    if (taskScheduler_)
+        collisionDispatcher_ = ea::make_unique<DeterministicCollisionDispatcherMt>(collisionConfiguration_);
+    else
+        collisionDispatcher_ = ea::make_unique<btCollisionDispatcher>(collisionConfiguration_);
     btGImpactCollisionAlgorithm::registerAlgorithm(static_cast<btCollisionDispatcher*>(collisionDispatcher_.get()));
 
     broadphase_ = ea::make_unique<btDbvtBroadphase>();
-    solver_ = ea::make_unique<btSequentialImpulseConstraintSolver>();
-    world_ = ea::make_unique<btDiscreteDynamicsWorld>(collisionDispatcher_.get(), broadphase_.get(), solver_.get(), collisionConfiguration_);
+    if (taskScheduler_)
+    {
+        // Islands are solved in parallel, large islands are additionally split into batches
+        const int numSolvers = static_cast<WorkQueueTaskScheduler*>(taskScheduler_.get())->GetNumThreads();
+        solver_ = ea::make_unique<btConstraintSolverPoolMt>(numSolvers);
+        solverMt_ = ea::make_unique<btSequentialImpulseConstraintSolverMt>();
+        world_ = ea::make_unique<btDiscreteDynamicsWorldMt>(collisionDispatcher_.get(), broadphase_.get(),
+            static_cast<btConstraintSolverPoolMt*>(solver_.get()), solverMt_.get(), collisionConfiguration_);
+    }
+    else
+    {
+        solver_ = ea::make_unique<btSequentialImpulseConstraintSolver>();
+        world_ = ea::make_unique<btDiscreteDynamicsWorld>(collisionDispatcher_.get(), broadphase_.get(), solver_.get(), collisionConfiguration_);
+    }
 
     world_->setGravity(ToBtVector3(DEFAULT_GRAVITY));
     world_->getDispatchInfo().m_useContinuous = true;
@@ -191,10 +412,15 @@ PhysicsWorld::~PhysicsWorld()
     }
 
     world_.reset();
+    solverMt_.reset();
     solver_.reset();
     broadphase_.reset();
     collisionDispatcher_.reset();
 
+    if (taskScheduler_ && btGetTaskScheduler() == taskScheduler_.get())
+        btSetTaskScheduler(btGetSequentialTaskScheduler());
+    taskScheduler_.reset();
+
     // Delete configuration only if it was the default created by PhysicsWorld
     if (!PhysicsWorld::config.collisionConfig_)
         delete collisionConfiguration_;
@@ -213,6 +439,7 @@ void PhysicsWorld::RegisterObject(Context* context)
     URHO3D_ATTRIBUTE("Interpolation", bool, interpolation_, true, AM_FILE);
     URHO3D_ATTRIBUTE("Internal Edge Utility", bool, internalEdge_, true, AM_DEFAULT);
     URHO3D_ACCESSOR_ATTRIBUTE("Split Impulse", GetSplitImpulse, SetSplitImpulse, bool, false, AM_DEFAULT);
+    URHO3D_ATTRIBUTE("Collision Events", bool, collisionEventsEnabled_, true, AM_DEFAULT);
 }
 
 bool PhysicsWorld::isVisible(const btVector3& aabbMin, const btVector3& aabbMax)
@@ -271,6 +498,7 @@ void PhysicsWorld::Update(float timeStep)
         maxSubSteps = Min(maxSubSteps, maxSubSteps_);
 
     delayedWorldTransforms_.clear();
+    ActivateTaskScheduler();
     simulating_ = true;
 
     if (interpolation_)
@@ -310,9 +538,17 @@ void PhysicsWorld::Update(float timeStep)
 
 void PhysicsWorld::UpdateCollisions()
 {
+    ActivateTaskScheduler();
     world_->performDiscreteCollisionDetection();
 }
 
+void PhysicsWorld::ActivateTaskScheduler()
+{
+    // Bullet task scheduler is global and may be replaced by another world
+    if (taskScheduler_ && btGetTaskScheduler() != taskScheduler_.get())
+        btSetTaskScheduler(taskScheduler_.get());
+}
+
 void PhysicsWorld::SetFps(int fps)
 {
     fps_ = (unsigned)Clamp(fps, 1, 1000);
@@ -400,19 +636,15 @@ void PhysicsWorld::Raycast(ea::vector<PhysicsRaycastResult>& result, const Ray&
     ea::quick_sort(result.begin(), result.end(), CompareRaycastResults);
 }
 
-void PhysicsWorld::RaycastSingle(PhysicsRaycastResult& result, const Ray& ray, float maxDistance, unsigned collisionMask)
+static void RaycastSingleImpl(const btCollisionWorld* world, PhysicsRaycastResult& result, const Ray& ray,
+    float maxDistance, unsigned collisionMask)
 {
-    URHO3D_PROFILE("PhysicsRaycastSingle");
-
-    if (maxDistance >= M_INFINITY)
-        URHO3D_LOGWARNING("Infinite maxDistance in physics raycast is not supported");
-
     btCollisionWorld::ClosestRayResultCallback
         rayCallback(ToBtVector3(ray.origin_), ToBtVector3(ray.origin_ + maxDistance * ray.direction_));
     rayCallback.m_collisionFilterGroup = (short)0xffff;
     rayCallback.m_collisionFilterMask = (short)collisionMask;
 
-    world_->rayTest(rayCallback.m_rayFromWorld, rayCallback.m_rayToWorld, rayCallback);
+    world->rayTest(rayCallback.m_rayFromWorld, rayCallback.m_rayToWorld, rayCallback);
 
     if (rayCallback.hasHit())
     {
@@ -432,6 +664,48 @@ void PhysicsWorld::RaycastSingle(PhysicsRaycastResult& result, const Ray& ray, f
     }
 }
 
+static void SphereCastImpl(const btCollisionWorld* world, PhysicsRaycastResult& result, const Ray& ray,
+    float radius, float maxDistance, unsigned collisionMask)
+{
+    btSphereShape shape(radius);
+    Vector3 endPos = ray.origin_ + maxDistance * ray.direction_;
+
+    btCollisionWorld::ClosestConvexResultCallback
+        convexCallback(ToBtVector3(ray.origin_), ToBtVector3(endPos));
+    convexCallback.m_collisionFilterGroup = (short)0xffff;
+    convexCallback.m_collisionFilterMask = (short)collisionMask;
+
+    world->convexSweepTest(&shape, btTransform(btQuaternion::getIdentity(), convexCallback.m_convexFromWorld),
+        btTransform(btQuaternion::getIdentity(), convexCallback.m_convexToWorld), convexCallback);
+
+    if (convexCallback.hasHit())
+    {
+        result.body_ = static_cast<RigidBody*>(convexCallback.m_hitCollisionObject->getUserPointer());
+        result.position_ = ToVector3(convexCallback.m_hitPointWorld);
+        result.normal_ = ToVector3(convexCallback.m_hitNormalWorld);
+        result.distance_ = convexCallback.m_closestHitFraction * (endPos - ray.origin_).Length();
+        result.hitFraction_ = convexCallback.m_closestHitFraction;
+    }
+    else
+    {
+        result.body_ = nullptr;
+        result.position_ = Vector3::ZERO;
+        result.normal_ = Vector3::ZERO;
+        result.distance_ = M_INFINITY;
+        result.hitFraction_ = 0.0f;
+    }
+}
+
+void PhysicsWorld::RaycastSingle(PhysicsRaycastResult& result, const Ray& ray, float maxDistance, unsigned collisionMask)
+{
+    URHO3D_PROFILE("PhysicsRaycastSingle");
+
+    if (maxDistance >= M_INFINITY)
+        URHO3D_LOGWARNING("Infinite maxDistance in physics raycast is not supported");
+
+    RaycastSingleImpl(world_.get(), result, ray, maxDistance, collisionMask);
+}
+
 void PhysicsWorld::RaycastSingleSegmented(PhysicsRaycastResult& result, const Ray& ray, float maxDistance, float segmentDistance, unsigned collisionMask, float overlapDistance)
 {
     URHO3D_PROFILE("PhysicsRaycastSingleSegmented");
@@ -491,33 +765,44 @@ void PhysicsWorld::SphereCast(PhysicsRaycastResult& result, const Ray& ray, floa
     if (maxDistance >= M_INFINITY)
         URHO3D_LOGWARNING("Infinite maxDistance in physics sphere cast is not supported");
 
-    btSphereShape shape(radius);
-    Vector3 endPos = ray.origin_ + maxDistance * ray.direction_;
-
-    btCollisionWorld::ClosestConvexResultCallback
-        convexCallback(ToBtVector3(ray.origin_), ToBtVector3(endPos));
-    convexCallback.m_collisionFilterGroup = (short)0xffff;
-    convexCallback.m_collisionFilterMask = (short)collisionMask;
+    SphereCastImpl(world_.get(), result, ray, radius, maxDistance, collisionMask);
+}
 
-    world_->convexSweepTest(&shape, btTransform(btQuaternion::getIdentity(), convexCallback.m_convexFromWorld),
-        btTransform(btQuaternion::getIdentity(), convexCallback.m_convexToWorld), convexCallback);
+void PhysicsWorld::RaycastSingleBatch(ea::span<const PhysicsRaycastQuery> queries, ea::span<PhysicsRaycastResult> results)
+{
+    URHO3D_PROFILE("PhysicsRaycastSingleBatch");
 
-    if (convexCallback.hasHit())
+    if (queries.size() != results.size())
     {
-        result.body_ = static_cast<RigidBody*>(convexCallback.m_hitCollisionObject->getUserPointer());
-        result.position_ = ToVector3(convexCallback.m_hitPointWorld);
-        result.normal_ = ToVector3(convexCallback.m_hitNormalWorld);
-        result.distance_ = convexCallback.m_closestHitFraction * (endPos - ray.origin_).Length();
-        result.hitFraction_ = convexCallback.m_closestHitFraction;
+        URHO3D_LOGERROR("Physics raycast batch should have the same number of queries and results");
+        return;
     }
-    else
+
+    const btCollisionWorld* world = world_.get();
+    const auto processQueries = [&](unsigned beginIndex, unsigned endIndex)
     {
-        result.body_ = nullptr;
-        result.position_ = Vector3::ZERO;
-        result.normal_ = Vector3::ZERO;
-        result.distance_ = M_INFINITY;
-        result.hitFraction_ = 0.0f;
+        for (unsigned i = beginIndex; i < endIndex; ++i)
+        {
+            const PhysicsRaycastQuery& query = queries[i];
+            if (query.radius_ > 0.0f)
+                SphereCastImpl(world, results[i], query.ray_, query.radius_, query.maxDistance_, query.collisionMask_);
+            else
+                RaycastSingleImpl(world, results[i], query.ray_, query.maxDistance_, query.collisionMask_);
+        }
+    };
+
+    // Broadphase ray test is reentrant only if Bullet is built thread-safe
+#if BT_THREADSAFE
+    auto workQueue = GetSubsystem<WorkQueue>();
+    if (workQueue && workQueue->GetNumThreads() > 0 && WorkQueue::GetThreadIndex() == 0 && !simulating_)
+    {
+        static const unsigned bucketSize = 16;
+        ForEachParallel(workQueue, bucketSize, queries.size(), processQueries);
+        return;
     }
+#endif
+
+    processQueries(0, queries.size());
 }
 
 void PhysicsWorld::ConvexCast(PhysicsRaycastResult& result, CollisionShape* shape, const Vector3& startPos,
@@ -687,22 +972,23 @@ void PhysicsWorld::GetCollidingBodies(ea::vector<RigidBody*>& result, const Rigi
 
     result.clear();
 
-    for (auto i = currentCollisions_.begin();
-         i != currentCollisions_.end(); ++i)
+    for (unsigned index : GetCollisionIndices(body))
     {
-        if (i->first.first == body)
-        {
-            if (i->first.second)
-                result.push_back(i->first.second);
-        }
-        else if (i->first.second == body)
-        {
-            if (i->first.first)
-                result.push_back(i->first.first);
-        }
+        const RigidBodyCollision& collision = collisions_[index];
+        RigidBody* otherBody = collision.bodyA_ == body ? collision.bodyB_ : collision.bodyA_;
+        if (otherBody)
+            result.push_back(otherBody);
     }
 }
 
+ea::span<const unsigned> PhysicsWorld::GetCollisionIndices(const RigidBody* body) const
+{
+    const auto range = ea::equal_range(bodyCollisionKeys_.begin(), bodyCollisionKeys_.end(), body);
+    const unsigned beginIndex = range.first - bodyCollisionKeys_.begin();
+    const unsigned endIndex = range.second - bodyCollisionKeys_.begin();
+    return ea::span<const unsigned>(bodyCollisionIndices_).subspan(beginIndex, endIndex - beginIndex);
+}
+
 Vector3 PhysicsWorld::GetGravity() const
 {
     return ToVector3(world_->getGravity());
@@ -728,6 +1014,32 @@ void PhysicsWorld::RemoveRigidBody(RigidBody* body)
     rigidBodies_.erase_first(body);
     // Remove possible dangling pointer from the delayedWorldTransforms structure
     delayedWorldTransforms_.erase(body);
+
+    // Remove possible dangling pointers from the contact stream
+    const auto range = ea::equal_range(bodyCollisionKeys_.begin(), bodyCollisionKeys_.end(), body);
+    if (range.first != range.second)
+    {
+        const unsigned beginIndex = range.first - bodyCollisionKeys_.begin();
+        const unsigned endIndex = range.second - bodyCollisionKeys_.begin();
+        for (unsigned i = beginIndex; i < endIndex; ++i)
+        {
+            const unsigned collisionIndex = bodyCollisionIndices_[i];
+            collisions_[collisionIndex].bodyA_ = nullptr;
+            collisions_[collisionIndex].bodyB_ = nullptr;
+            collisionPairs_[collisionIndex] = {};
+        }
+        bodyCollisionKeys_.erase(range.first, range.second);
+        bodyCollisionIndices_.erase(bodyCollisionIndices_.begin() + beginIndex, bodyCollisionIndices_.begin() + endIndex);
+        collisionPairsDirty_ = true;
+    }
+    for (RigidBodyCollision& collision : endedCollisions_)
+    {
+        if (collision.bodyA_ == body || collision.bodyB_ == body)
+        {
+            collision.bodyA_ = nullptr;
+            collision.bodyB_ = nullptr;
+        }
+    }
 }
 
 void PhysicsWorld::AddCollisionShape(CollisionShape* shape)
@@ -833,246 +1145,253 @@ void PhysicsWorld::SendCollisionEvents()
 {
     URHO3D_PROFILE("SendCollisionEvents");
 
-    currentCollisions_.clear();
-    physicsCollisionData_.clear();
-    nodeCollisionData_.clear();
+    UpdateContactStream();
 
-    int numManifolds = collisionDispatcher_->getNumManifolds();
+    // Contact stream listeners receive single event per step
+    {
+        using namespace PhysicsContacts;
+
+        VariantMap& eventData = GetEventDataMap();
+        eventData[P_WORLD] = this;
+        SendEvent(E_PHYSICSCONTACTS, eventData);
+    }
+
+    if (collisionEventsEnabled_)
+        SendPairCollisionEvents();
+}
+
+void PhysicsWorld::UpdateContactStream()
+{
+    URHO3D_PROFILE("UpdateContactStream");
 
-    if (numManifolds)
+    ea::swap(previousCollisionPairs_, collisionPairs_);
+    if (collisionPairsDirty_)
     {
-        physicsCollisionData_[PhysicsCollision::P_WORLD] = this;
+        ea::sort(previousCollisionPairs_.begin(), previousCollisionPairs_.end());
+        collisionPairsDirty_ = false;
+    }
 
-        for (int i = 0; i < numManifolds; ++i)
-        {
-            btPersistentManifold* contactManifold = collisionDispatcher_->getManifoldByIndexInternal(i);
-            // First check that there are actual contacts, as the manifold exists also when objects are close but not touching
-            if (!contactManifold->getNumContacts())
-                continue;
+    pairManifolds_.clear();
+    collisions_.clear();
+    endedCollisions_.clear();
+    contacts_.clear();
+    collisionPairs_.clear();
 
-            const btCollisionObject* objectA = contactManifold->getBody0();
-            const btCollisionObject* objectB = contactManifold->getBody1();
+    // Collect manifolds with contacts and group them by body pair
+    const int numManifolds = collisionDispatcher_->getNumManifolds();
+    for (int i = 0; i < numManifolds; ++i)
+    {
+        const btPersistentManifold* contactManifold = collisionDispatcher_->getManifoldByIndexInternal(i);
+        // First check that there are actual contacts, as the manifold exists also when objects are close but not touching
+        if (!contactManifold->getNumContacts())
+            continue;
+
+        auto* bodyA = static_cast<RigidBody*>(contactManifold->getBody0()->getUserPointer());
+        auto* bodyB = static_cast<RigidBody*>(contactManifold->getBody1()->getUserPointer());
+        // If it's not a rigidbody, maybe a ghost object
+        if (!bodyA || !bodyB || !IsCollisionReported(bodyA, bodyB))
+            continue;
+
+        if (bodyA < bodyB)
+            pairManifolds_.push_back({ ea::make_pair(bodyA, bodyB), i, false });
+        else
+            pairManifolds_.push_back({ ea::make_pair(bodyB, bodyA), i, true });
+    }
 
-            auto* bodyA = static_cast<RigidBody*>(objectA->getUserPointer());
-            auto* bodyB = static_cast<RigidBody*>(objectB->getUserPointer());
-            // If it's not a rigidbody, maybe a ghost object
-            if (!bodyA || !bodyB)
-                continue;
+    ea::sort(pairManifolds_.begin(), pairManifolds_.end(), [](const PairManifold& lhs, const PairManifold& rhs)
+    {
+        return lhs.bodies_ != rhs.bodies_ ? lhs.bodies_ < rhs.bodies_ : lhs.index_ < rhs.index_;
+    });
 
-            // Skip collision event signaling if both objects are static, or if collision event mode does not match
-            if (bodyA->GetMass() == 0.0f && bodyB->GetMass() == 0.0f)
-                continue;
-            if (bodyA->GetCollisionEventMode() == COLLISION_NEVER || bodyB->GetCollisionEventMode() == COLLISION_NEVER)
-                continue;
-            if (bodyA->GetCollisionEventMode() == COLLISION_ACTIVE && bodyB->GetCollisionEventMode() == COLLISION_ACTIVE &&
-                !bodyA->IsActive() && !bodyB->IsActive())
-                continue;
+    for (unsigned i = 0; i < pairManifolds_.size();)
+    {
+        const ea::pair<RigidBody*, RigidBody*> bodies = pairManifolds_[i].bodies_;
 
-            WeakPtr<RigidBody> bodyWeakA(bodyA);
-            WeakPtr<RigidBody> bodyWeakB(bodyB);
+        RigidBodyCollision collision;
+        collision.bodyA_ = bodies.first;
+        collision.bodyB_ = bodies.second;
+        collision.trigger_ = bodies.first->IsTrigger() || bodies.second->IsTrigger();
+        collision.started_ = !ea::binary_search(previousCollisionPairs_.begin(), previousCollisionPairs_.end(), bodies);
+        collision.contactsBegin_ = contacts_.size();
 
-            // First only store the collision pair as weak pointers and the manifold pointer, so user code can safely destroy
-            // objects during collision event handling
-            ea::pair<WeakPtr<RigidBody>, WeakPtr<RigidBody> > bodyPair;
-            if (bodyA < bodyB)
-            {
-                bodyPair = ea::make_pair(bodyWeakA, bodyWeakB);
-                currentCollisions_[bodyPair].manifold_ = contactManifold;
-            }
-            else
+        for (; i < pairManifolds_.size() && pairManifolds_[i].bodies_ == bodies; ++i)
+        {
+            // Normals of flipped manifolds are flipped too
+            const btPersistentManifold* contactManifold = collisionDispatcher_->getManifoldByIndexInternal(pairManifolds_[i].index_);
+            const float normalScale = pairManifolds_[i].flipped_ ? -1.0f : 1.0f;
+            for (int j = 0; j < contactManifold->getNumContacts(); ++j)
             {
-                bodyPair = ea::make_pair(bodyWeakB, bodyWeakA);
-                currentCollisions_[bodyPair].flippedManifold_ = contactManifold;
+                const btManifoldPoint& point = contactManifold->getContactPoint(j);
+                contacts_.push_back({ ToVector3(point.m_positionWorldOnB), ToVector3(point.m_normalWorldOnB) * normalScale,
+                    point.m_distance1, point.m_appliedImpulse });
             }
         }
 
-        for (auto i = currentCollisions_.begin();
-             i != currentCollisions_.end(); ++i)
-        {
-            RigidBody* bodyA = i->first.first;
-            RigidBody* bodyB = i->first.second;
-            if (!bodyA || !bodyB)
-                continue;
+        collision.contactsEnd_ = contacts_.size();
+        collisions_.push_back(collision);
+        collisionPairs_.push_back(bodies);
+    }
 
-            Node* nodeA = bodyA->GetNode();
-            Node* nodeB = bodyB->GetNode();
-            WeakPtr<Node> nodeWeakA(nodeA);
-            WeakPtr<Node> nodeWeakB(nodeB);
+    // Pairs of removed bodies are reset and never end
+    for (const auto& bodies : previousCollisionPairs_)
+    {
+        if (!bodies.first || ea::binary_search(collisionPairs_.begin(), collisionPairs_.end(), bodies))
+            continue;
 
-            bool trigger = bodyA->IsTrigger() || bodyB->IsTrigger();
-            bool newCollision = !previousCollisions_.contains(i->first);
+        if (!IsCollisionReported(bodies.first, bodies.second))
+            continue;
 
-            physicsCollisionData_[PhysicsCollision::P_NODEA] = nodeA;
-            physicsCollisionData_[PhysicsCollision::P_NODEB] = nodeB;
-            physicsCollisionData_[PhysicsCollision::P_BODYA] = bodyA;
-            physicsCollisionData_[PhysicsCollision::P_BODYB] = bodyB;
-            physicsCollisionData_[PhysicsCollision::P_TRIGGER] = trigger;
+        RigidBodyCollision collision;
+        collision.bodyA_ = bodies.first;
+        collision.bodyB_ = bodies.second;
+        collision.trigger_ = bodies.first->IsTrigger() || bodies.second->IsTrigger();
+        endedCollisions_.push_back(collision);
+    }
 
-            contacts_.Clear();
+    // Index collisions by body
+    bodyCollisionPairs_.clear();
+    for (unsigned i = 0; i < collisions_.size(); ++i)
+    {
+        bodyCollisionPairs_.emplace_back(collisions_[i].bodyA_, i);
+        bodyCollisionPairs_.emplace_back(collisions_[i].bodyB_, i);
+    }
+    ea::sort(bodyCollisionPairs_.begin(), bodyCollisionPairs_.end());
 
-            // "Pointers not flipped"-manifold, send unmodified normals
-            btPersistentManifold* contactManifold = i->second.manifold_;
-            if (contactManifold)
-            {
-                for (int j = 0; j < contactManifold->getNumContacts(); ++j)
-                {
-                    btManifoldPoint& point = contactManifold->getContactPoint(j);
-                    contacts_.WriteVector3(ToVector3(point.m_positionWorldOnB));
-                    contacts_.WriteVector3(ToVector3(point.m_normalWorldOnB));
-                    contacts_.WriteFloat(point.m_distance1);
-                    contacts_.WriteFloat(point.m_appliedImpulse);
-                }
-            }
-            // "Pointers flipped"-manifold, flip normals also
-            contactManifold = i->second.flippedManifold_;
-            if (contactManifold)
-            {
-                for (int j = 0; j < contactManifold->getNumContacts(); ++j)
-                {
-                    btManifoldPoint& point = contactManifold->getContactPoint(j);
-                    contacts_.WriteVector3(ToVector3(point.m_positionWorldOnB));
-                    contacts_.WriteVector3(-ToVector3(point.m_normalWorldOnB));
-                    contacts_.WriteFloat(point.m_distance1);
-                    contacts_.WriteFloat(point.m_appliedImpulse);
-                }
-            }
+    bodyCollisionKeys_.clear();
+    bodyCollisionIndices_.clear();
+    for (const auto& bodyAndIndex : bodyCollisionPairs_)
+    {
+        bodyCollisionKeys_.push_back(bodyAndIndex.first);
+        bodyCollisionIndices_.push_back(bodyAndIndex.second);
+    }
+}
 
-            physicsCollisionData_[PhysicsCollision::P_CONTACTS] = contacts_.GetBuffer();
+void PhysicsWorld::SendPairCollisionEvents()
+{
+    physicsCollisionData_.clear();
+    nodeCollisionData_.clear();
 
-            // Send separate collision start event if collision is new
-            if (newCollision)
-            {
-                SendEvent(E_PHYSICSCOLLISIONSTART, physicsCollisionData_);
-                // Skip rest of processing if either of the nodes or bodies is removed as a response to the event
-                if (!nodeWeakA || !nodeWeakB || !i->first.first || !i->first.second)
-                    continue;
-            }
+    // Collisions are accessed by index because handlers may remove bodies, which resets body pointers in the stream
+    for (unsigned i = 0; i < collisions_.size(); ++i)
+    {
+        const RigidBodyCollision& collision = collisions_[i];
+        RigidBody* bodyA = collision.bodyA_;
+        RigidBody* bodyB = collision.bodyB_;
+        if (!bodyA || !bodyB)
+            continue;
 
-            // Then send the ongoing collision event
-            SendEvent(E_PHYSICSCOLLISION, physicsCollisionData_);
-            if (!nodeWeakA || !nodeWeakB || !i->first.first || !i->first.second)
-                continue;
+        Node* nodeA = bodyA->GetNode();
+        Node* nodeB = bodyB->GetNode();
+        WeakPtr<Node> nodeWeakA(nodeA);
+        WeakPtr<Node> nodeWeakB(nodeB);
+        const auto isExpired = [&]() { return !nodeWeakA || !nodeWeakB || !collision.bodyA_ || !collision.bodyB_; };
 
-            nodeCollisionData_[NodeCollision::P_BODY] = bodyA;
-            nodeCollisionData_[NodeCollision::P_OTHERNODE] = nodeB;
-            nodeCollisionData_[NodeCollision::P_OTHERBODY] = bodyB;
-            nodeCollisionData_[NodeCollision::P_TRIGGER] = trigger;
-            nodeCollisionData_[NodeCollision::P_CONTACTS] = contacts_.GetBuffer();
+        const bool trigger = collision.trigger_;
+        const bool newCollision = collision.started_;
 
-            if (newCollision)
-            {
-                nodeA->SendEvent(E_NODECOLLISIONSTART, nodeCollisionData_);
-                if (!nodeWeakA || !nodeWeakB || !i->first.first || !i->first.second)
-                    continue;
-            }
+        physicsCollisionData_[PhysicsCollision::P_WORLD] = this;
+        physicsCollisionData_[PhysicsCollision::P_NODEA] = nodeA;
+        physicsCollisionData_[PhysicsCollision::P_NODEB] = nodeB;
+        physicsCollisionData_[PhysicsCollision::P_BODYA] = bodyA;
+        physicsCollisionData_[PhysicsCollision::P_BODYB] = bodyB;
+        physicsCollisionData_[PhysicsCollision::P_TRIGGER] = trigger;
 
-            nodeA->SendEvent(E_NODECOLLISION, nodeCollisionData_);
-            if (!nodeWeakA || !nodeWeakB || !i->first.first || !i->first.second)
+        WriteContacts(contactsBuffer_, GetContacts(collision), false);
+        physicsCollisionData_[PhysicsCollision::P_CONTACTS] = contactsBuffer_.GetBuffer();
+
+        // Send separate collision start event if collision is new
+        if (newCollision)
+        {
+            SendEvent(E_PHYSICSCOLLISIONSTART, physicsCollisionData_);
+            // Skip rest of processing if either of the nodes or bodies is removed as a response to the event
+            if (isExpired())
                 continue;
+        }
 
-            // Flip perspective to body B
-            contacts_.Clear();
-            contactManifold = i->second.manifold_;
-            if (contactManifold)
-            {
-                for (int j = 0; j < contactManifold->getNumContacts(); ++j)
-                {
-                    btManifoldPoint& point = contactManifold->getContactPoint(j);
-                    contacts_.WriteVector3(ToVector3(point.m_positionWorldOnB));
-                    contacts_.WriteVector3(-ToVector3(point.m_normalWorldOnB));
-                    contacts_.WriteFloat(point.m_distance1);
-                    contacts_.WriteFloat(point.m_appliedImpulse);
-                }
-            }
-            contactManifold = i->second.flippedManifold_;
-            if (contactManifold)
-            {
-                for (int j = 0; j < contactManifold->getNumContacts(); ++j)
-                {
-                    btManifoldPoint& point = contactManifold->getContactPoint(j);
-                    contacts_.WriteVector3(ToVector3(point.m_positionWorldOnB));
-                    contacts_.WriteVector3(ToVector3(point.m_normalWorldOnB));
-                    contacts_.WriteFloat(point.m_distance1);
-                    contacts_.WriteFloat(point.m_appliedImpulse);
-                }
-            }
+        // Then send the ongoing collision event
+        SendEvent(E_PHYSICSCOLLISION, physicsCollisionData_);
+        if (isExpired())
+            continue;
 
-            nodeCollisionData_[NodeCollision::P_BODY] = bodyB;
-            nodeCollisionData_[NodeCollision::P_OTHERNODE] = nodeA;
-            nodeCollisionData_[NodeCollision::P_OTHERBODY] = bodyA;
-            nodeCollisionData_[NodeCollision::P_CONTACTS] = contacts_.GetBuffer();
+        nodeCollisionData_[NodeCollision::P_BODY] = bodyA;
+        nodeCollisionData_[NodeCollision::P_OTHERNODE] = nodeB;
+        nodeCollisionData_[NodeCollision::P_OTHERBODY] = bodyB;
+        nodeCollisionData_[NodeCollision::P_TRIGGER] = trigger;
+        nodeCollisionData_[NodeCollision::P_CONTACTS] = contactsBuffer_.GetBuffer();
 
-            if (newCollision)
-            {
-                nodeB->SendEvent(E_NODECOLLISIONSTART, nodeCollisionData_);
-                if (!nodeWeakA || !nodeWeakB || !i->first.first || !i->first.second)
-                    continue;
-            }
+        if (newCollision)
+        {
+            nodeA->SendEvent(E_NODECOLLISIONSTART, nodeCollisionData_);
+            if (isExpired())
+                continue;
+        }
+
+        nodeA->SendEvent(E_NODECOLLISION, nodeCollisionData_);
+        if (isExpired())
+            continue;
 
-            nodeB->SendEvent(E_NODECOLLISION, nodeCollisionData_);
+        // Flip perspective to body B
+        WriteContacts(contactsBuffer_, GetContacts(collision), true);
+        nodeCollisionData_[NodeCollision::P_BODY] = bodyB;
+        nodeCollisionData_[NodeCollision::P_OTHERNODE] = nodeA;
+        nodeCollisionData_[NodeCollision::P_OTHERBODY] = bodyA;
+        nodeCollisionData_[NodeCollision::P_CONTACTS] = contactsBuffer_.GetBuffer();
+
+        if (newCollision)
+        {
+            nodeB->SendEvent(E_NODECOLLISIONSTART, nodeCollisionData_);
+            if (isExpired())
+                continue;
         }
+
+        nodeB->SendEvent(E_NODECOLLISION, nodeCollisionData_);
     }
 
     // Send collision end events as applicable
+    physicsCollisionData_.clear();
+    nodeCollisionData_.clear();
+
+    for (unsigned i = 0; i < endedCollisions_.size(); ++i)
     {
-        physicsCollisionData_[PhysicsCollisionEnd::P_WORLD] = this;
+        const RigidBodyCollision& collision = endedCollisions_[i];
+        RigidBody* bodyA = collision.bodyA_;
+        RigidBody* bodyB = collision.bodyB_;
+        if (!bodyA || !bodyB)
+            continue;
+
+        Node* nodeA = bodyA->GetNode();
+        Node* nodeB = bodyB->GetNode();
+        WeakPtr<Node> nodeWeakA(nodeA);
+        WeakPtr<Node> nodeWeakB(nodeB);
+        const auto isExpired = [&]() { return !nodeWeakA || !nodeWeakB || !collision.bodyA_ || !collision.bodyB_; };
 
-        for (auto
-                 i = previousCollisions_.begin(); i != previousCollisions_.end(); ++i)
-        {
-            if (!currentCollisions_.contains(i->first))
-            {
-                RigidBody* bodyA = i->first.first;
-                RigidBody* bodyB = i->first.second;
-                if (!bodyA || !bodyB)
-                    continue;
-
-                bool trigger = bodyA->IsTrigger() || bodyB->IsTrigger();
-
-                // Skip collision event signaling if both objects are static, or if collision event mode does not match
-                if (bodyA->GetMass() == 0.0f && bodyB->GetMass() == 0.0f)
-                    continue;
-                if (bodyA->GetCollisionEventMode() == COLLISION_NEVER || bodyB->GetCollisionEventMode() == COLLISION_NEVER)
-                    continue;
-                if (bodyA->GetCollisionEventMode() == COLLISION_ACTIVE && bodyB->GetCollisionEventMode() == COLLISION_ACTIVE &&
-                    !bodyA->IsActive() && !bodyB->IsActive())
-                    continue;
-
-                Node* nodeA = bodyA->GetNode();
-                Node* nodeB = bodyB->GetNode();
-                WeakPtr<Node> nodeWeakA(nodeA);
-                WeakPtr<Node> nodeWeakB(nodeB);
-
-                physicsCollisionData_[PhysicsCollisionEnd::P_BODYA] = bodyA;
-                physicsCollisionData_[PhysicsCollisionEnd::P_BODYB] = bodyB;
-                physicsCollisionData_[PhysicsCollisionEnd::P_NODEA] = nodeA;
-                physicsCollisionData_[PhysicsCollisionEnd::P_NODEB] = nodeB;
-                physicsCollisionData_[PhysicsCollisionEnd::P_TRIGGER] = trigger;
-
-                SendEvent(E_PHYSICSCOLLISIONEND, physicsCollisionData_);
-                // Skip rest of processing if either of the nodes or bodies is removed as a response to the event
-                if (!nodeWeakA || !nodeWeakB || !i->first.first || !i->first.second)
-                    continue;
-
-                nodeCollisionData_[NodeCollisionEnd::P_BODY] = bodyA;
-                nodeCollisionData_[NodeCollisionEnd::P_OTHERNODE] = nodeB;
-                nodeCollisionData_[NodeCollisionEnd::P_OTHERBODY] = bodyB;
-                nodeCollisionData_[NodeCollisionEnd::P_TRIGGER] = trigger;
-
-                nodeA->SendEvent(E_NODECOLLISIONEND, nodeCollisionData_);
-                if (!nodeWeakA || !nodeWeakB || !i->first.first || !i->first.second)
-                    continue;
-
-                nodeCollisionData_[NodeCollisionEnd::P_BODY] = bodyB;
-                nodeCollisionData_[NodeCollisionEnd::P_OTHERNODE] = nodeA;
-                nodeCollisionData_[NodeCollisionEnd::P_OTHERBODY] = bodyA;
-
-                nodeB->SendEvent(E_NODECOLLISIONEND, nodeCollisionData_);
-            }
-        }
+        physicsCollisionData_[PhysicsCollisionEnd::P_WORLD] = this;
+        physicsCollisionData_[PhysicsCollisionEnd::P_BODYA] = bodyA;
+        physicsCollisionData_[PhysicsCollisionEnd::P_BODYB] = bodyB;
+        physicsCollisionData_[PhysicsCollisionEnd::P_NODEA] = nodeA;
+        physicsCollisionData_[PhysicsCollisionEnd::P_NODEB] = nodeB;
+        physicsCollisionData_[PhysicsCollisionEnd::P_TRIGGER] = collision.trigger_;
+
+        SendEvent(E_PHYSICSCOLLISIONEND, physicsCollisionData_);
+        // Skip rest of processing if either of the nodes or bodies is removed as a response to the event
+        if (isExpired())
+            continue;
+
+        nodeCollisionData_[NodeCollisionEnd::P_BODY] = bodyA;
+        nodeCollisionData_[NodeCollisionEnd::P_OTHERNODE] = nodeB;
+        nodeCollisionData_[NodeCollisionEnd::P_OTHERBODY] = bodyB;
+        nodeCollisionData_[NodeCollisionEnd::P_TRIGGER] = collision.trigger_;
+
+        nodeA->SendEvent(E_NODECOLLISIONEND, nodeCollisionData_);
+        if (isExpired())
+            continue;
+
+        nodeCollisionData_[NodeCollisionEnd::P_BODY] = bodyB;
+        nodeCollisionData_[NodeCollisionEnd::P_OTHERNODE] = nodeA;
+        nodeCollisionData_[NodeCollisionEnd::P_OTHERBODY] = bodyA;
+
+        nodeB->SendEvent(E_NODECOLLISIONEND, nodeCollisionData_);
     }
-
-    previousCollisions_ = currentCollisions_;
 }
 
 void RegisterPhysicsLibrary(Context* context)
@@ -22,10 +22,12 @@
 
 #pragma once
 
+#include <EASTL/span.h>
 #include <EASTL/unique_ptr.h>
 
 #include "../IO/VectorBuffer.h"
 #include "../Math/BoundingBox.h"
+#include "../Math/Ray.h"
 #include "../Math/Sphere.h"
 #include "../Math/Vector3.h"
 #include "../Scene/Component.h"
@@ -39,6 +41,7 @@ class btConstraintSolver;
 class btDiscreteDynamicsWorld;
 class btDispatcher;
 class btDynamicsWorld;
+class btITaskScheduler;
 class btPersistentManifold;
 
 namespace Urho3D
@@ -78,6 +81,19 @@ struct URHO3D_API PhysicsRaycastResult
     RigidBody* body_{};
 };
 
+/// Physics raycast or sphere cast query for batched execution.
+struct PhysicsRaycastQuery
+{
+    /// Ray origin and direction.
+    Ray ray_;
+    /// Maximum distance.
+    float maxDistance_{};
+    /// Radius of swept sphere. Zero for raycast.
+    float radius_{};
+    /// Collision mask.
+    unsigned collisionMask_{ M_MAX_UNSIGNED };
+};
+
 /// Delayed world transform assignment for parented rigidbodies.
 struct DelayedWorldTransform
 {
@@ -91,32 +107,54 @@ struct DelayedWorldTransform
     Quaternion worldRotation_;
 };
 
-/// Manifold pointers stored during collision processing.
-struct ManifoldPair
+/// Contact point between two rigid bodies.
+struct PhysicsContact
 {
-    /// Construct with defaults.
-    ManifoldPair() :
-        manifold_(nullptr),
-        flippedManifold_(nullptr)
-    {
-    }
+    /// Contact worldspace position.
+    Vector3 position_;
+    /// Contact worldspace normal, directed from the second body towards the first one.
+    Vector3 normal_;
+    /// Contact distance. Negative when bodies penetrate.
+    float distance_{};
+    /// Impulse applied by the solver.
+    float impulse_{};
+};
 
-    /// Manifold without the body pointers flipped.
-    btPersistentManifold* manifold_;
-    /// Manifold with the body pointers flipped.
-    btPersistentManifold* flippedManifold_;
+/// Collision between two rigid bodies on the last simulation step. Valid until the next step.
+/// Body pointers are reset to null if the body is removed before that.
+struct RigidBodyCollision
+{
+    /// First rigid body. Bodies are ordered by address.
+    RigidBody* bodyA_{};
+    /// Second rigid body.
+    RigidBody* bodyB_{};
+    /// Index of the first contact in the contact stream.
+    unsigned contactsBegin_{};
+    /// Index past the last contact in the contact stream.
+    unsigned contactsEnd_{};
+    /// Whether either of the bodies is a trigger.
+    bool trigger_{};
+    /// Whether the collision has started on the last simulation step.
+    bool started_{};
 };
 
 /// Custom overrides of physics internals. To use overrides, must be set before the physics component is created.
 struct PhysicsWorldConfig
 {
     PhysicsWorldConfig() :
-        collisionConfig_(nullptr)
+        collisionConfig_(nullptr),
+        multiThreaded_(false),
+        maxThreads_(0)
     {
     }
 
     /// Override for the collision configuration (default btDefaultCollisionConfiguration).
     btCollisionConfiguration* collisionConfig_;
+    /// Whether to step simulation in WorkQueue threads using btDiscreteDynamicsWorldMt.
+    /// Requires threading support. Collision events are still sent from the main thread.
+    bool multiThreaded_;
+    /// Maximum number of threads used by multithreaded simulation, including main thread. 0 to use all WorkQueue threads.
+    unsigned maxThreads_;
 };
 
 static const int DEFAULT_FPS = 60;
@@ -193,6 +231,9 @@ public:
     void SetSplitImpulse(bool enable);
     /// Set maximum angular velocity for network replication.
     void SetMaxNetworkAngularVelocity(float velocity);
+    /// Set whether to send collision events for each colliding pair. Enabled by default. Contact stream is updated regardless.
+    /// @property
+    void SetCollisionEventsEnabled(bool enable) { collisionEventsEnabled_ = enable; }
     /// Perform a physics world raycast and return all hits.
     void Raycast
         (ea::vector<PhysicsRaycastResult>& result, const Ray& ray, float maxDistance, unsigned collisionMask = M_MAX_UNSIGNED);
@@ -204,6 +245,9 @@ public:
     /// Perform a physics world swept sphere test and return the closest hit.
     void SphereCast
         (PhysicsRaycastResult& result, const Ray& ray, float radius, float maxDistance, unsigned collisionMask = M_MAX_UNSIGNED);
+    /// Perform a batch of physics world raycasts and swept sphere tests and return the closest hit for each query.
+    /// Queries are executed in WorkQueue threads if possible. Results should have the same size as queries.
+    void RaycastSingleBatch(ea::span<const PhysicsRaycastQuery> queries, ea::span<PhysicsRaycastResult> results);
     /// Perform a physics world swept convex test using a user-supplied collision shape and return the first hit.
     void ConvexCast(PhysicsRaycastResult& result, CollisionShape* shape, const Vector3& startPos, const Quaternion& startRot,
         const Vector3& endPos, const Quaternion& endRot, unsigned collisionMask = M_MAX_UNSIGNED);
@@ -220,6 +264,17 @@ public:
     void GetRigidBodies(ea::vector<RigidBody*>& result, const RigidBody* body);
     /// Return rigid bodies that have been in collision with the specified body on the last simulation step. Only returns collisions that were sent as events (depends on collision event mode) and excludes e.g. static-static collisions.
     void GetCollidingBodies(ea::vector<RigidBody*>& result, const RigidBody* body);
+    /// Return collisions on the last simulation step, sorted by body pair. Same filtering as for collision events is applied.
+    ea::span<const RigidBodyCollision> GetCollisions() const { return collisions_; }
+    /// Return collisions that have ended on the last simulation step. They have no contacts.
+    ea::span<const RigidBodyCollision> GetEndedCollisions() const { return endedCollisions_; }
+    /// Return contacts of the collision.
+    ea::span<const PhysicsContact> GetContacts(const RigidBodyCollision& collision) const
+    {
+        return ea::span<const PhysicsContact>(contacts_).subspan(collision.contactsBegin_, collision.contactsEnd_ - collision.contactsBegin_);
+    }
+    /// Return indices of collisions of the specified body on the last simulation step, see GetCollisions.
+    ea::span<const unsigned> GetCollisionIndices(const RigidBody* body) const;
 
     /// Return gravity.
     /// @property
@@ -249,6 +304,10 @@ public:
     /// @property
     bool GetSplitImpulse() const;
 
+    /// Return whether collision events are sent for each colliding pair.
+    /// @property
+    bool GetCollisionEventsEnabled() const { return collisionEventsEnabled_; }
+
     /// Return simulation steps per second.
     /// @property
     int GetFps() const { return fps_; }
@@ -256,6 +315,9 @@ public:
     /// Return maximum angular velocity for network replication.
     float GetMaxNetworkAngularVelocity() const { return maxNetworkAngularVelocity_; }
 
+    /// Return whether the simulation is stepped in multiple threads.
+    bool IsMultiThreaded() const { return taskScheduler_ != nullptr; }
+
     /// Add a rigid body to keep track of. Called by RigidBody.
     void AddRigidBody(RigidBody* body);
     /// Remove a rigid body. Called by RigidBody.
@@ -315,8 +377,14 @@ private:
     void PreStep(float timeStep);
     /// Trigger update after each physics simulation step.
     void PostStep(float timeStep);
-    /// Send accumulated collision events.
+    /// Update contact stream and send accumulated collision events.
     void SendCollisionEvents();
+    /// Fill contact stream from contact manifolds.
+    void UpdateContactStream();
+    /// Send collision events for each colliding pair from contact stream.
+    void SendPairCollisionEvents();
+    /// Make own task scheduler current in multithreaded mode.
+    void ActivateTaskScheduler();
 
     /// Bullet collision configuration.
     btCollisionConfiguration* collisionConfiguration_{};
@@ -324,8 +392,12 @@ private:
     ea::unique_ptr<btDispatcher> collisionDispatcher_;
     /// Bullet collision broadphase.
     ea::unique_ptr<btBroadphaseInterface> broadphase_;
-    /// Bullet constraint solver.
+    /// Bullet constraint solver. Pool of solvers in multithreaded mode.
     ea::unique_ptr<btConstraintSolver> solver_;
+    /// Bullet constraint solver for large islands in multithreaded mode.
+    ea::unique_ptr<btConstraintSolver> solverMt_;
+    /// Bullet task scheduler in multithreaded mode.
+    ea::unique_ptr<btITaskScheduler> taskScheduler_;
     /// Bullet physics world.
     ea::unique_ptr<btDiscreteDynamicsWorld> world_;
     /// Extra weak pointer to scene to allow for cleanup in case the world is destroyed before other components.
@@ -336,10 +408,36 @@ private:
     ea::vector<CollisionShape*> collisionShapes_;
     /// Constraints in the world.
     ea::vector<Constraint*> constraints_;
-    /// Collision pairs on this frame.
-    ea::unordered_map<ea::pair<WeakPtr<RigidBody>, WeakPtr<RigidBody> >, ManifoldPair> currentCollisions_;
-    /// Collision pairs on the previous frame. Used to check if a collision is "new." Manifolds are not guaranteed to exist anymore.
-    ea::unordered_map<ea::pair<WeakPtr<RigidBody>, WeakPtr<RigidBody> >, ManifoldPair> previousCollisions_;
+    /// Contact manifold of colliding pair, used to group manifolds by pair.
+    struct PairManifold
+    {
+        /// Body pair ordered by address.
+        ea::pair<RigidBody*, RigidBody*> bodies_;
+        /// Index of manifold in dispatcher.
+        int index_{};
+        /// Whether the manifold bodies are in reverse order.
+        bool flipped_{};
+    };
+    /// Manifolds of colliding pairs on the last step.
+    ea::vector<PairManifold> pairManifolds_;
+    /// Collisions on the last step.
+    ea::vector<RigidBodyCollision> collisions_;
+    /// Collisions ended on the last step.
+    ea::vector<RigidBodyCollision> endedCollisions_;
+    /// Contacts of collisions on the last step.
+    ea::vector<PhysicsContact> contacts_;
+    /// Sorted body pairs of collisions on the last step. Pairs of removed bodies are reset to null.
+    ea::vector<ea::pair<RigidBody*, RigidBody*>> collisionPairs_;
+    /// Sorted body pairs of collisions on the previous step. Used to check if a collision is new.
+    ea::vector<ea::pair<RigidBody*, RigidBody*>> previousCollisionPairs_;
+    /// Whether the collision pairs are not sorted anymore because some of them were reset.
+    bool collisionPairsDirty_{};
+    /// Rigid bodies and indices of their collisions, sorted by body.
+    ea::vector<ea::pair<const RigidBody*, unsigned>> bodyCollisionPairs_;
+    /// Colliding rigid bodies sorted by address, one element per collision.
+    ea::vector<const RigidBody*> bodyCollisionKeys_;
+    /// Indices of collisions of bodies in bodyCollisionKeys_.
+    ea::vector<unsigned> bodyCollisionIndices_;
     /// Delayed (parented) world transform assignments.
     ea::unordered_map<RigidBody*, DelayedWorldTransform> delayedWorldTransforms_;
     /// Cache for trimesh geometry data by model and LOD level.
@@ -353,7 +451,9 @@ private:
     /// Preallocated event data map for node collision events.
     VariantMap nodeCollisionData_;
     /// Preallocated buffer for physics collision contact data.
-    VectorBuffer contacts_;
+    VectorBuffer contactsBuffer_;
+    /// Whether to send collision events for each colliding pair.
+    bool collisionEventsEnabled_{ true };
     /// Simulation substeps per second.
     unsigned fps_{DEFAULT_FPS};
     /// Maximum number of simulation substeps per frame. 0 (default) unlimited, or negative values for adaptive timestep.
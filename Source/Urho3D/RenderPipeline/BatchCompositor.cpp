@@ -39,7 +39,8 @@ namespace
 
 /// Add batch or delayed batch.
 void AddPipelineBatch(const PipelineBatchDesc& desc, BatchStateCache& cache,
-    WorkQueueVector<PipelineBatch>& batches, WorkQueueVector<PipelineBatchDesc>& delayedBatches)
+    WorkQueueVector<PipelineBatch, EASTLFrameAllocator>& batches,
+    WorkQueueVector<PipelineBatchDesc, EASTLFrameAllocator>& delayedBatches)
 {
     PipelineState* pipelineState = cache.GetPipelineState(desc.GetKey());
     if (pipelineState)
@@ -181,8 +182,8 @@ void BatchCompositorPass::ProcessGeometryBatch(const GeometryBatch& geometryBatc
 }
 
 void BatchCompositorPass::ResolveDelayedBatches(BatchCompositorSubpass subpass,
-    const WorkQueueVector<PipelineBatchDesc>& delayedBatches,
-    BatchStateCache& cache, WorkQueueVector<PipelineBatch>& batches)
+    const WorkQueueVector<PipelineBatchDesc, EASTLFrameAllocator>& delayedBatches,
+    BatchStateCache& cache, WorkQueueVector<PipelineBatch, EASTLFrameAllocator>& batches)
 {
     BatchStateCreateContext ctx;
     ctx.pass_ = this;
@@ -169,17 +169,18 @@ protected:
     BatchStateCacheCallback* batchStateCacheCallback_{};
     /// @}
 
-    WorkQueueVector<PipelineBatch> deferredBatches_;
-    WorkQueueVector<PipelineBatch> baseBatches_;
-    WorkQueueVector<PipelineBatch> lightBatches_;
-    WorkQueueVector<PipelineBatch> negativeLightBatches_;
+    WorkQueueVector<PipelineBatch, EASTLFrameAllocator> deferredBatches_;
+    WorkQueueVector<PipelineBatch, EASTLFrameAllocator> baseBatches_;
+    WorkQueueVector<PipelineBatch, EASTLFrameAllocator> lightBatches_;
+    WorkQueueVector<PipelineBatch, EASTLFrameAllocator> negativeLightBatches_;
 
 private:
     bool PreparePipelineBatch(PipelineBatchDesc& key, const GeometryBatch& geometryBatch) const;
 
     void ProcessGeometryBatch(const GeometryBatch& geometryBatch);
-    void ResolveDelayedBatches(BatchCompositorSubpass subpass, const WorkQueueVector<PipelineBatchDesc>& delayedBatches,
-        BatchStateCache& cache, WorkQueueVector<PipelineBatch>& batches);
+    void ResolveDelayedBatches(BatchCompositorSubpass subpass,
+        const WorkQueueVector<PipelineBatchDesc, EASTLFrameAllocator>& delayedBatches,
+        BatchStateCache& cache, WorkQueueVector<PipelineBatch, EASTLFrameAllocator>& batches);
 
     /// Pipeline state caches
     /// @{
@@ -191,11 +192,11 @@ private:
 
     /// Batches whose processing is delayed due to missing pipeline state
     /// @{
-    WorkQueueVector<PipelineBatchDesc> delayedDeferredBatches_;
-    WorkQueueVector<PipelineBatchDesc> delayedUnlitBaseBatches_;
-    WorkQueueVector<PipelineBatchDesc> delayedLitBaseBatches_;
-    WorkQueueVector<PipelineBatchDesc> delayedLightBatches_;
-    WorkQueueVector<PipelineBatchDesc> delayedNegativeLightBatches_;
+    WorkQueueVector<PipelineBatchDesc, EASTLFrameAllocator> delayedDeferredBatches_;
+    WorkQueueVector<PipelineBatchDesc, EASTLFrameAllocator> delayedUnlitBaseBatches_;
+    WorkQueueVector<PipelineBatchDesc, EASTLFrameAllocator> delayedLitBaseBatches_;
+    WorkQueueVector<PipelineBatchDesc, EASTLFrameAllocator> delayedLightBatches_;
+    WorkQueueVector<PipelineBatchDesc, EASTLFrameAllocator> delayedNegativeLightBatches_;
     /// @}
 };
 
@@ -286,7 +287,7 @@ private:
     BatchStateCache lightVolumeCache_;
     /// @}
 
-    WorkQueueVector<ea::pair<ShadowSplitProcessor*, PipelineBatchDesc>> delayedShadowBatches_;
+    WorkQueueVector<ea::pair<ShadowSplitProcessor*, PipelineBatchDesc>, EASTLFrameAllocator> delayedShadowBatches_;
     ea::vector<PipelineBatch> lightVolumeBatches_;
     ea::vector<PipelineBatchByState> sortedLightVolumeBatches_;
 };
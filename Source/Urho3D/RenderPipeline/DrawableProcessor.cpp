@@ -155,6 +155,7 @@ DrawableProcessor::DrawableProcessor(RenderPipelineInterface* renderPipeline)
     : Object(renderPipeline->GetContext())
     , workQueue_(GetSubsystem<WorkQueue>())
     , defaultMaterial_(GetSubsystem<Renderer>()->GetDefaultMaterial())
+    , lightsTaskGraph_(workQueue_)
     , lightProcessorCache_(ea::make_unique<LightProcessorCache>())
 {
     renderPipeline->OnCollectStatistics.Subscribe(this, &DrawableProcessor::OnCollectStatistics);
@@ -501,12 +502,62 @@ void DrawableProcessor::ProcessLights(LightProcessorCallback* callback)
     for (LightProcessor* lightProcessor : lightProcessors_)
         lightProcessor->BeginUpdate(this, callback);
 
-    ForEachParallel(workQueue_, lightProcessors_,
-        [&](unsigned /*index*/, LightProcessor* lightProcessor)
+    // Shadow casters don't depend on shadow map allocation and forward lighting, overlap them.
+    // Forward lighting of different lights may touch the same geometry, so lights are processed one by one.
+    TaskGraph& graph = lightsTaskGraph_;
+    graph.Clear();
+
+    const unsigned numLights = lightProcessors_.size();
+    const auto updateLights = graph.AddParallelTask("UpdateLights", numLights, 1,
+        [=](unsigned beginIndex, unsigned endIndex)
+    {
+        for (unsigned i = beginIndex; i < endIndex; ++i)
+            lightProcessors_[i]->Update(this, callback);
+    });
+
+    const auto processShadowCasters = graph.AddParallelTask("ProcessShadowCasters",
+        [=]() { return queuedDrawableUpdates_.Size(); }, 1,
+        [=](unsigned beginIndex, unsigned endIndex)
     {
-        lightProcessor->Update(this, callback);
+        auto iter = queuedDrawableUpdates_.Begin() + beginIndex;
+        for (unsigned i = beginIndex; i < endIndex; ++i, ++iter)
+            ProcessQueuedDrawable(*iter);
     });
+    graph.AddDependency(processShadowCasters, updateLights);
+
+    const auto endLightsUpdate = graph.AddTask("EndLightsUpdate",
+        [=](unsigned /*threadIndex*/) { EndLightsUpdate(callback); }, TaskAffinity::MainThread);
+    graph.AddDependency(endLightsUpdate, updateLights);
 
+    TaskGraph::TaskId previousTask = endLightsUpdate;
+    for (unsigned lightIndex = 0; lightIndex < numLights; ++lightIndex)
+    {
+        const auto forwardLighting = graph.AddParallelTask("ProcessForwardLighting",
+            [=]() { return GetNumForwardLitGeometries(lightIndex); }, 1,
+            [=](unsigned beginIndex, unsigned endIndex) { AccumulateForwardLighting(lightIndex, beginIndex, endIndex); });
+        graph.AddDependency(forwardLighting, previousTask);
+        previousTask = forwardLighting;
+    }
+
+    const auto finalizeForwardLighting = graph.AddParallelTask("FinalizeForwardLighting",
+        [=]()
+    {
+        for (unsigned lightIndex = 0; lightIndex < numLights; ++lightIndex)
+        {
+            if (lightProcessors_[lightIndex]->HasForwardLitGeometries())
+                return geometries_.Size();
+        }
+        return 0u;
+    }, 1,
+        [=](unsigned beginIndex, unsigned endIndex) { FinalizeForwardLighting(beginIndex, endIndex); });
+    graph.AddDependency(finalizeForwardLighting, previousTask);
+
+    graph.Execute();
+    queuedDrawableUpdates_.Clear();
+}
+
+void DrawableProcessor::EndLightsUpdate(LightProcessorCallback* callback)
+{
     SortLightProcessorsByShadowMapSize();
 
     numShadowedLights_ = 0;
@@ -518,34 +569,32 @@ void DrawableProcessor::ProcessLights(LightProcessorCallback* callback)
     }
 
     SortLightProcessorsByShadowMapTexture();
-
-    ProcessShadowCasters();
 }
 
-void DrawableProcessor::ProcessForwardLightingForLight(
-    unsigned lightIndex, const ea::vector<Drawable*>& litGeometries)
+unsigned DrawableProcessor::GetNumForwardLitGeometries(unsigned lightIndex) const
 {
-    if (lightIndex >= lights_.size())
-    {
-        URHO3D_LOGERROR("Invalid light index {}", lightIndex);
-        return;
-    }
+    const LightProcessor* lightProcessor = lightProcessors_[lightIndex];
+    return lightProcessor->HasForwardLitGeometries() ? lightProcessor->GetLitGeometries().size() : 0;
+}
 
+void DrawableProcessor::AccumulateForwardLighting(unsigned lightIndex, unsigned beginIndex, unsigned endIndex)
+{
     Light* light = lights_[lightIndex];
     const LightType lightType = light->GetLightType();
     const float lightIntensityPenalty = 1.0f / light->GetIntensityDivisor();
     const bool hasShadow = lightProcessors_[lightIndex]->HasShadow();
     const bool isNegative = light->IsNegative();
     const LightImportance lightImportance = hasShadow ? LI_IMPORTANT : light->GetLightImportance();
+    const ea::vector<Drawable*>& litGeometries = lightProcessors_[lightIndex]->GetLitGeometries();
 
     LightAccumulatorContext ctx;
     ctx.maxVertexLights_ = settings_.maxVertexLights_;
     ctx.maxPixelLights_ = settings_.maxPixelLights_;
     ctx.lights_ = &lightDataForAccumulator_;
 
-    ForEachParallel(workQueue_, litGeometries,
-        [&](unsigned /*index*/, Drawable* geometry)
+    for (unsigned i = beginIndex; i < endIndex; ++i)
     {
+        Drawable* geometry = litGeometries[i];
         const unsigned drawableIndex = geometry->GetDrawableIndex();
 
         // Directional light doesn't filter out e.g. deferred lit geometries for shadow focusing
@@ -553,21 +602,22 @@ void DrawableProcessor::ProcessForwardLightingForLight(
         {
             const bool isForwardLit = !!(geometryFlags_[drawableIndex] & GeometryRenderFlag::ForwardLit);
             if (!isForwardLit)
-                return;
+                continue;
         }
 
         const float distance = ea::max(light->GetDistanceTo(geometry), M_LARGE_EPSILON);
         const float penalty = GetDrawableLightPenalty(distance * lightIntensityPenalty,
             isNegative, lightImportance, lightType);
         geometryLighting_[drawableIndex].AccumulateLight(ctx, geometry, lightImportance, lightIndex, penalty);
-    });
+    }
 }
 
-void DrawableProcessor::FinalizeForwardLighting()
+void DrawableProcessor::FinalizeForwardLighting(unsigned beginIndex, unsigned endIndex)
 {
-    ForEachParallel(workQueue_, geometries_,
-        [&](unsigned /*index*/, Drawable* drawable)
+    auto iter = geometries_.Begin() + beginIndex;
+    for (unsigned i = beginIndex; i < endIndex; ++i, ++iter)
     {
+        Drawable* drawable = *iter;
         const unsigned drawableIndex = drawable->GetDrawableIndex();
         const unsigned char flags = geometryFlags_[drawableIndex];
         if (flags & GeometryRenderFlag::ForwardLit)
@@ -575,25 +625,7 @@ void DrawableProcessor::FinalizeForwardLighting()
             LightAccumulator& lightAccumulator = geometryLighting_[drawableIndex];
             lightAccumulator.Cook();
         }
-    });
-}
-
-void DrawableProcessor::ProcessForwardLighting()
-{
-    URHO3D_PROFILE("ProcessForwardLighting");
-
-    bool hasForwardLights = false;
-    for (unsigned i = 0; i < lightProcessors_.size(); ++i)
-    {
-        const LightProcessor* lightProcessor = lightProcessors_[i];
-        if (lightProcessor->HasForwardLitGeometries())
-        {
-            ProcessForwardLightingForLight(i, lightProcessor->GetLitGeometries());
-            hasForwardLights = true;
-        }
     }
-    if (hasForwardLights)
-        FinalizeForwardLighting();
 }
 
 void DrawableProcessor::PreprocessShadowCasters(ea::vector<Drawable*>& shadowCasters,
@@ -641,16 +673,6 @@ void DrawableProcessor::QueueDrawableUpdate(Drawable* drawable)
         queuedDrawableUpdates_.Insert(drawable);
 }
 
-void DrawableProcessor::ProcessShadowCasters()
-{
-    ForEachParallel(workQueue_, queuedDrawableUpdates_,
-        [&](unsigned /*index*/, Drawable* drawable)
-    {
-        ProcessQueuedDrawable(drawable);
-    });
-    queuedDrawableUpdates_.Clear();
-}
-
 void DrawableProcessor::ProcessQueuedDrawable(Drawable* drawable)
 {
     drawable->UpdateBatches(frameInfo_);
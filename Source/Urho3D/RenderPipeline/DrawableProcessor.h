@@ -23,6 +23,7 @@
 #pragma once
 
 #include "../Core/Object.h"
+#include "../Core/TaskGraph.h"
 #include "../Core/WorkQueue.h"
 #include "../Graphics/GraphicsDefs.h"
 #include "../Math/NumericRange.h"
@@ -126,7 +127,7 @@ protected:
     virtual void OnUpdateBegin(const CommonFrameInfo& frameInfo);
     /// @}
 
-    WorkQueueVector<GeometryBatch> geometryBatches_;
+    WorkQueueVector<GeometryBatch, EASTLFrameAllocator> geometryBatches_;
 };
 
 /// Utility used to update and process visible or shadow caster Drawables.
@@ -184,17 +185,10 @@ public:
     /// Internal. Pre-process shadow caster candidates. Safe to call from worker thread.
     void PreprocessShadowCasters(ea::vector<Drawable*>& shadowCasters,
         const ea::vector<Drawable*>& candidates, const FloatRange& frustumSubRange, Light* light, Camera* shadowCamera);
-    /// Internal. Finalize shadow casters processing.
-    void ProcessShadowCasters();
 
-    /// Process lights: collect lit geometries, query shadow casters, update shadow maps.
+    /// Process lights: collect lit geometries, query shadow casters, update shadow maps, accumulate forward lighting.
+    /// Shadow casters are processed concurrently with shadow map allocation and forward lighting.
     void ProcessLights(LightProcessorCallback* callback);
-    /// Accumulate forward lighting for specified light source and geometries.
-    void ProcessForwardLightingForLight(unsigned lightIndex, const ea::vector<Drawable*>& litGeometries);
-    /// Should be called after all forward lighting is processed.
-    void FinalizeForwardLighting();
-    /// Process forward lighting for all lights.
-    void ProcessForwardLighting();
 
     /// Update drawable geometries if needed.
     void UpdateGeometries();
@@ -212,6 +206,11 @@ protected:
     void SortLightProcessorsByShadowMapSize();
     void SortLightProcessorsByShadowMapTexture();
 
+    void EndLightsUpdate(LightProcessorCallback* callback);
+    unsigned GetNumForwardLitGeometries(unsigned lightIndex) const;
+    void AccumulateForwardLighting(unsigned lightIndex, unsigned beginIndex, unsigned endIndex);
+    void FinalizeForwardLighting(unsigned beginIndex, unsigned endIndex);
+
 private:
     /// Whether the drawable is already updated for this pipeline and frame.
     /// Technically copyable to allow storage in vector, but is invalidated on copying.
@@ -228,6 +227,9 @@ private:
     Material* defaultMaterial_{};
     /// @}
 
+    /// Task graph for lights processing, reused between frames.
+    TaskGraph lightsTaskGraph_;
+
     /// Cached between frames
     /// @{
     ea::vector<SharedPtr<DrawableProcessorPass>> passes_;
@@ -261,11 +263,11 @@ private:
 
     ea::vector<SortedOccluder> sortedOccluders_;
 
-    WorkQueueVector<Drawable*> geometries_;
-    WorkQueueVector<Drawable*> threadedGeometryUpdates_;
-    WorkQueueVector<Drawable*> nonThreadedGeometryUpdates_;
+    WorkQueueVector<Drawable*, EASTLFrameAllocator> geometries_;
+    WorkQueueVector<Drawable*, EASTLFrameAllocator> threadedGeometryUpdates_;
+    WorkQueueVector<Drawable*, EASTLFrameAllocator> nonThreadedGeometryUpdates_;
 
-    WorkQueueVector<Light*> lightsTemp_;
+    WorkQueueVector<Light*, EASTLFrameAllocator> lightsTemp_;
     ea::vector<Light*> lights_;
     ea::vector<LightDataForAccumulator> lightDataForAccumulator_;
     ea::vector<LightProcessor*> lightProcessors_;
@@ -273,7 +275,7 @@ private:
     ea::vector<LightProcessor*> lightProcessorsByShadowMapTexture_;
     unsigned numShadowedLights_{};
 
-    WorkQueueVector<Drawable*> queuedDrawableUpdates_;
+    WorkQueueVector<Drawable*, EASTLFrameAllocator> queuedDrawableUpdates_;
 };
 
 }
@@ -147,18 +147,18 @@ void DirectionalLightShadowCasterQuery::TestDrawables(Drawable** start, Drawable
 {
     for (Drawable* drawable : MakeIteratorRange(start, end))
     {
-        if (IsShadowCaster(drawable, inside))
-            result_.push_back(drawable);
+        if (IsShadowCaster(drawable))
+            candidates_.push_back(drawable);
     }
+    ProcessCandidates(inside);
 }
 
-bool DirectionalLightShadowCasterQuery::IsShadowCaster(Drawable* drawable, bool inside) const
+bool DirectionalLightShadowCasterQuery::IsShadowCaster(Drawable* drawable) const
 {
     return drawable->GetCastShadows()
         && (drawable->GetDrawableFlags() & drawableFlags_)
         && (drawable->GetViewMask() & viewMask_)
-        && (drawable->GetShadowMask() & lightMask_)
-        && (inside || frustum_.IsInsideFast(drawable->GetWorldBoundingBox()));
+        && (drawable->GetShadowMask() & lightMask_);
 }
 
 }
@@ -98,7 +98,7 @@ public:
     void TestDrawables(Drawable** start, Drawable** end, bool inside) override;
 
 private:
-    bool IsShadowCaster(Drawable* drawable, bool inside) const;
+    bool IsShadowCaster(Drawable* drawable) const;
 
     const unsigned lightMask_{};
 };
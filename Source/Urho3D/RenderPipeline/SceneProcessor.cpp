@@ -72,11 +72,9 @@ public:
         {
             const DrawableFlags flags = drawable->GetDrawableFlags();
             if (flags == DRAWABLE_GEOMETRY && drawable->IsOccluder() && (drawable->GetViewMask() & viewMask_))
-            {
-                if (inside || frustum_.IsInsideFast(drawable->GetWorldBoundingBox()))
-                    result_.push_back(drawable);
-            }
+                candidates_.push_back(drawable);
         }
+        ProcessCandidates(inside);
     }
 };
 
@@ -111,11 +109,9 @@ public:
         for (Drawable* drawable : MakeIteratorRange(start, end))
         {
             if ((drawable->GetDrawableFlags() & drawableFlags_) && (drawable->GetViewMask() & viewMask_))
-            {
-                if (inside || frustum_.IsInsideFast(drawable->GetWorldBoundingBox()))
-                    result_.push_back(drawable);
-            }
+                candidates_.push_back(drawable);
         }
+        ProcessCandidates(inside);
     }
 
     /// Occlusion buffer.
@@ -309,7 +305,6 @@ void SceneProcessor::Update()
     // Process drawables
     drawableProcessor_->ProcessVisibleDrawables(drawables_, currentOcclusionBuffer_);
     drawableProcessor_->ProcessLights(this);
-    drawableProcessor_->ProcessForwardLighting();
 
     drawableProcessor_->UpdateGeometries();
 
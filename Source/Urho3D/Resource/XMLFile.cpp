@@ -25,6 +25,7 @@
 #include "../Core/Context.h"
 #include "../Core/Profiler.h"
 #include "../IO/Deserializer.h"
+#include "../IO/File.h"
 #include "../IO/Log.h"
 #include "../IO/MemoryBuffer.h"
 #include "../IO/VectorBuffer.h"
@@ -84,11 +85,24 @@ bool XMLFile::BeginLoad(Deserializer& source)
         return false;
     }
 
-    ea::shared_array<char> buffer(new char[dataSize]);
-    if (source.Read(buffer.get(), dataSize) != dataSize)
-        return false;
+    // Parse memory-mapped file without intermediate copy
+    ea::shared_array<char> buffer;
+    const void* data = nullptr;
+    auto* file = dynamic_cast<File*>(&source);
+    if (file && file->GetMappedData() && file->GetPosition() == 0)
+    {
+        data = file->GetMappedData();
+        file->Seek(dataSize);
+    }
+    else
+    {
+        buffer.reset(new char[dataSize]);
+        if (source.Read(buffer.get(), dataSize) != dataSize)
+            return false;
+        data = buffer.get();
+    }
 
-    if (!document_->load_buffer(buffer.get(), dataSize))
+    if (!document_->load_buffer(data, dataSize))
     {
         URHO3D_LOGERROR("Could not parse XML data from " + source.GetName());
         document_->reset();
@@ -0,0 +1,228 @@
+//
+// Copyright (c) 2017-2021 the rbfx project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "../Precompiled.h"
+
+#include "../IO/BitStream.h"
+#include "../IO/Deserializer.h"
+#include "../IO/Serializer.h"
+#include "../Scene/AttributeEncoding.h"
+
+#include "../DebugNew.h"
+
+namespace Urho3D
+{
+
+namespace
+{
+
+/// Max number of bits per quantized float component.
+const unsigned MAX_QUANTIZED_BITS = 24;
+/// Max absolute value of any but largest component of normalized quaternion.
+const float SMALLEST_THREE_RANGE = 0.70710678f;
+
+/// Return number of float components of quantized value.
+unsigned GetNumQuantizedComponents(VariantType type)
+{
+    switch (type)
+    {
+    case VAR_FLOAT: return 1;
+    case VAR_VECTOR2: return 2;
+    case VAR_VECTOR3: return 3;
+    case VAR_VECTOR4: return 4;
+    default: return 0;
+    }
+}
+
+/// Return max quantized value for given number of bits.
+unsigned GetMaxQuantized(unsigned bits)
+{
+    return (1u << bits) - 1;
+}
+
+unsigned QuantizeFloat(float value, float minValue, float maxValue, unsigned bits)
+{
+    const float range = maxValue - minValue;
+    const float normalized = range > 0.0f ? Clamp((value - minValue) / range, 0.0f, 1.0f) : 0.0f;
+    return static_cast<unsigned>(RoundToInt(normalized * GetMaxQuantized(bits)));
+}
+
+float DequantizeFloat(unsigned value, float minValue, float maxValue, unsigned bits)
+{
+    return minValue + (maxValue - minValue) * static_cast<float>(value) / GetMaxQuantized(bits);
+}
+
+void WriteQuantized(BitWriter& writer, const AttributeNetworkEncoding& encoding, const float* components, unsigned numComponents)
+{
+    for (unsigned i = 0; i < numComponents; ++i)
+        writer.WriteBits(QuantizeFloat(components[i], encoding.min_, encoding.max_, encoding.bits_), encoding.bits_);
+}
+
+void ReadQuantized(BitReader& reader, const AttributeNetworkEncoding& encoding, float* components, unsigned numComponents)
+{
+    for (unsigned i = 0; i < numComponents; ++i)
+        components[i] = DequantizeFloat(reader.ReadBits(encoding.bits_), encoding.min_, encoding.max_, encoding.bits_);
+}
+
+void WriteSmallestThree(BitWriter& writer, unsigned bits, const Quaternion& value)
+{
+    const Quaternion normalized = value.Normalized();
+    const float* components = normalized.Data();
+
+    unsigned largestIndex = 0;
+    for (unsigned i = 1; i < 4; ++i)
+    {
+        if (Abs(components[i]) > Abs(components[largestIndex]))
+            largestIndex = i;
+    }
+
+    // Quaternions q and -q represent the same rotation, so the largest component is always positive
+    const float sign = components[largestIndex] < 0.0f ? -1.0f : 1.0f;
+
+    writer.WriteBits(largestIndex, 2);
+    for (unsigned i = 0; i < 4; ++i)
+    {
+        if (i != largestIndex)
+            writer.WriteBits(QuantizeFloat(sign * components[i], -SMALLEST_THREE_RANGE, SMALLEST_THREE_RANGE, bits), bits);
+    }
+}
+
+Quaternion ReadSmallestThree(BitReader& reader, unsigned bits)
+{
+    const unsigned largestIndex = reader.ReadBits(2);
+
+    float components[4]{};
+    float sumSquares = 0.0f;
+    for (unsigned i = 0; i < 4; ++i)
+    {
+        if (i != largestIndex)
+        {
+            components[i] = DequantizeFloat(reader.ReadBits(bits), -SMALLEST_THREE_RANGE, SMALLEST_THREE_RANGE, bits);
+            sumSquares += components[i] * components[i];
+        }
+    }
+    components[largestIndex] = sqrtf(Max(0.0f, 1.0f - sumSquares));
+
+    return Quaternion(components[0], components[1], components[2], components[3]).Normalized();
+}
+
+}
+
+bool HasCompactNetworkEncoding(const AttributeInfo& attr)
+{
+    const AttributeNetworkEncoding& encoding = attr.networkEncoding_;
+    if (encoding.bits_ == 0)
+        return false;
+
+    switch (encoding.type_)
+    {
+    case ANE_QUANTIZED:
+        return encoding.bits_ <= MAX_QUANTIZED_BITS && GetNumQuantizedComponents(attr.type_) != 0;
+    case ANE_SMALLEST_THREE:
+        return encoding.bits_ <= MAX_QUANTIZED_BITS && attr.type_ == VAR_QUATERNION;
+    case ANE_BITS:
+        return encoding.bits_ <= 32 && attr.type_ == VAR_INT;
+    default:
+        return false;
+    }
+}
+
+void WriteNetworkAttribute(Serializer& dest, const AttributeInfo& attr, const Variant& value)
+{
+    if (!HasCompactNetworkEncoding(attr))
+    {
+        dest.WriteVariantData(value);
+        return;
+    }
+
+    const AttributeNetworkEncoding& encoding = attr.networkEncoding_;
+    BitWriter writer(dest);
+    switch (encoding.type_)
+    {
+    case ANE_QUANTIZED:
+    {
+        float components[4]{};
+        switch (attr.type_)
+        {
+        case VAR_FLOAT: components[0] = value.GetFloat(); break;
+        case VAR_VECTOR2: memcpy(components, value.GetVector2().Data(), sizeof(Vector2)); break;
+        case VAR_VECTOR3: memcpy(components, value.GetVector3().Data(), sizeof(Vector3)); break;
+        case VAR_VECTOR4: memcpy(components, value.GetVector4().Data(), sizeof(Vector4)); break;
+        default: break;
+        }
+        WriteQuantized(writer, encoding, components, GetNumQuantizedComponents(attr.type_));
+        break;
+    }
+
+    case ANE_SMALLEST_THREE:
+        WriteSmallestThree(writer, encoding.bits_, value.GetQuaternion());
+        break;
+
+    case ANE_BITS:
+    {
+        const auto minValue = static_cast<int>(encoding.min_);
+        const auto maxValue = static_cast<int>(encoding.max_);
+        const int clampedValue = Clamp(value.GetInt(), minValue, maxValue);
+        writer.WriteBits(static_cast<unsigned>(clampedValue) - static_cast<unsigned>(minValue), encoding.bits_);
+        break;
+    }
+
+    default:
+        break;
+    }
+}
+
+Variant ReadNetworkAttribute(Deserializer& source, const AttributeInfo& attr)
+{
+    if (!HasCompactNetworkEncoding(attr))
+        return source.ReadVariant(attr.type_);
+
+    const AttributeNetworkEncoding& encoding = attr.networkEncoding_;
+    BitReader reader(source);
+    switch (encoding.type_)
+    {
+    case ANE_QUANTIZED:
+    {
+        float components[4]{};
+        ReadQuantized(reader, encoding, components, GetNumQuantizedComponents(attr.type_));
+        switch (attr.type_)
+        {
+        case VAR_FLOAT: return components[0];
+        case VAR_VECTOR2: return Vector2(components[0], components[1]);
+        case VAR_VECTOR3: return Vector3(components[0], components[1], components[2]);
+        case VAR_VECTOR4: return Vector4(components[0], components[1], components[2], components[3]);
+        default: return Variant::EMPTY;
+        }
+    }
+
+    case ANE_SMALLEST_THREE:
+        return ReadSmallestThree(reader, encoding.bits_);
+
+    case ANE_BITS:
+        return static_cast<int>(reader.ReadBits(encoding.bits_) + static_cast<unsigned>(static_cast<int>(encoding.min_)));
+
+    default:
+        return Variant::EMPTY;
+    }
+}
+
+}
@@ -0,0 +1,42 @@
+//
+// Copyright (c) 2017-2021 the rbfx project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+/// \file
+
+#pragma once
+
+#include "../Core/Attribute.h"
+
+namespace Urho3D
+{
+
+class Deserializer;
+class Serializer;
+
+/// Return whether the attribute has compact network encoding applicable to its type.
+URHO3D_API bool HasCompactNetworkEncoding(const AttributeInfo& attr);
+/// Write attribute value for network replication. Attribute network encoding is used if applicable.
+URHO3D_API void WriteNetworkAttribute(Serializer& dest, const AttributeInfo& attr, const Variant& value);
+/// Read attribute value written by WriteNetworkAttribute.
+URHO3D_API Variant ReadNetworkAttribute(Deserializer& source, const AttributeInfo& attr);
+
+}
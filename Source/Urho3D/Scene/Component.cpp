@@ -170,6 +170,7 @@ void Component::PrepareNetworkUpdate()
 {
     if (!networkState_)
         AllocateNetworkState();
+    networkState_->ClearSerializedData();
 
     const ea::vector<AttributeInfo>* attributes = networkState_->attributes_;
     if (!attributes)
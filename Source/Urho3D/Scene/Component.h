@@ -24,6 +24,7 @@
 
 #pragma once
 
+#include "../Container/PoolAllocator.h"
 #include "../Scene/Animatable.h"
 
 namespace Urho3D
@@ -48,6 +49,7 @@ enum AutoRemoveMode
 class URHO3D_API Component : public Animatable
 {
     URHO3D_OBJECT(Component, Animatable);
+    URHO3D_POOL_ALLOCATED();
 
     friend class Node;
     friend class Scene;
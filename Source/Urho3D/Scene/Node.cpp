@@ -36,6 +36,7 @@
 #include "../Scene/Scene.h"
 #include "../Scene/SceneEvents.h"
 #include "../Scene/SmoothedTransform.h"
+#include "../Scene/TransformHierarchy.h"
 #include "../Scene/UnknownComponent.h"
 
 #include "../DebugNew.h"
@@ -89,8 +90,9 @@ void Node::RegisterObject(Context* context)
     URHO3D_ATTRIBUTE("Variables", VariantMap, vars_, Variant::emptyVariantMap, AM_FILE); // Network replication of vars uses custom data
     URHO3D_ACCESSOR_ATTRIBUTE("Network Position", GetNetPositionAttr, SetNetPositionAttr, Vector3, Vector3::ZERO,
         AM_NET | AM_LATESTDATA | AM_NOEDIT);
-    URHO3D_ACCESSOR_ATTRIBUTE("Network Rotation", GetNetRotationAttr, SetNetRotationAttr, ea::vector<unsigned char>, Variant::emptyBuffer,
-        AM_NET | AM_LATESTDATA | AM_NOEDIT);
+    URHO3D_ACCESSOR_ATTRIBUTE("Network Rotation", GetNetRotationAttr, SetNetRotationAttr, Quaternion, Quaternion::IDENTITY,
+        AM_NET | AM_LATESTDATA | AM_NOEDIT)
+        .SetNetworkEncoding(AttributeNetworkEncoding::SmallestThree(15));
     URHO3D_ACCESSOR_ATTRIBUTE("Network Parent Node", GetNetParentAttr, SetNetParentAttr, ea::vector<unsigned char>, Variant::emptyBuffer,
         AM_NET | AM_NOEDIT);
 }
@@ -886,6 +888,14 @@ void Node::SetOwner(Connection* owner)
 
 void Node::MarkDirty()
 {
+    // Walk flat storage instead of recursion if possible
+    if (scene_)
+    {
+        TransformHierarchy* transformHierarchy = scene_->GetTransformHierarchy();
+        if (transformHierarchy && !scene_->IsThreadedUpdate() && transformHierarchy->MarkDirty(this))
+            return;
+    }
+
     Node *cur = this;
     for (;;)
     {
@@ -901,22 +911,7 @@ void Node::MarkDirty()
         cur->dirty_ = true;
 
         // Notify listener components first, then mark child nodes
-        for (auto i = cur->listeners_.begin(); i !=
-            cur->listeners_.end();)
-        {
-            Component *c = i->Get();
-            if (c)
-            {
-                c->OnMarkedDirty(cur);
-                ++i;
-            }
-            // If listener has expired, erase from list (swap with the last element to avoid O(n^2) behavior)
-            else
-            {
-                *i = cur->listeners_.back();
-                cur->listeners_.pop_back();
-            }
-        }
+        cur->NotifyListenersDirty();
 
         // Tail call optimization: Don't recurse to mark the first child dirty, but
         // instead process it in the context of the current function. If there are more
@@ -934,6 +929,25 @@ void Node::MarkDirty()
     }
 }
 
+void Node::NotifyListenersDirty()
+{
+    for (auto i = listeners_.begin(); i != listeners_.end();)
+    {
+        Component *c = i->Get();
+        if (c)
+        {
+            c->OnMarkedDirty(this);
+            ++i;
+        }
+        // If listener has expired, erase from list (swap with the last element to avoid O(n^2) behavior)
+        else
+        {
+            *i = listeners_.back();
+            listeners_.pop_back();
+        }
+    }
+}
+
 Node* Node::CreateChild(const ea::string& name, CreateMode mode, unsigned id, bool temporary)
 {
     Node* newNode = CreateChild(id, mode, temporary);
@@ -986,6 +1000,8 @@ void Node::AddChild(Node* node, unsigned index)
     children_.insert_at(index, nodeShared);
     if (scene_ && node->GetScene() != scene_)
         scene_->NodeAdded(node);
+    if (scene_)
+        scene_->MarkTransformHierarchyDirty();
 
     node->parent_ = this;
     node->MarkDirty();
@@ -1627,14 +1643,13 @@ void Node::SetNetPositionAttr(const Vector3& value)
         SetPosition(value);
 }
 
-void Node::SetNetRotationAttr(const ea::vector<unsigned char>& value)
+void Node::SetNetRotationAttr(const Quaternion& value)
 {
-    MemoryBuffer buf(value);
     auto* transform = GetComponent<SmoothedTransform>();
     if (transform)
-        transform->SetTargetRotation(buf.ReadPackedQuaternion());
+        transform->SetTargetRotation(value);
     else
-        SetRotation(buf.ReadPackedQuaternion());
+        SetRotation(value);
 }
 
 void Node::SetNetParentAttr(const ea::vector<unsigned char>& value)
@@ -1679,11 +1694,9 @@ const Vector3& Node::GetNetPositionAttr() const
     return position_;
 }
 
-const ea::vector<unsigned char>& Node::GetNetRotationAttr() const
+const Quaternion& Node::GetNetRotationAttr() const
 {
-    impl_->attrBuffer_.Clear();
-    impl_->attrBuffer_.WritePackedQuaternion(rotation_);
-    return impl_->attrBuffer_.GetBuffer();
+    return rotation_;
 }
 
 const ea::vector<unsigned char>& Node::GetNetParentAttr() const
@@ -1873,6 +1886,7 @@ void Node::PrepareNetworkUpdate()
     // Then check for node attribute changes
     if (!networkState_)
         AllocateNetworkState();
+    networkState_->ClearSerializedData();
 
     const ea::vector<AttributeInfo>* attributes = networkState_->attributes_;
     unsigned numAttributes = attributes->size();
@@ -2293,6 +2307,8 @@ void Node::RemoveChild(ea::vector<SharedPtr<Node> >::iterator i)
         scene_->SendEvent(E_NODEREMOVED, eventData);
     }
 
+    if (scene_)
+        scene_->MarkTransformHierarchyDirty();
     child->parent_ = nullptr;
     child->MarkDirty();
     child->MarkNetworkUpdate();
@@ -24,6 +24,7 @@
 
 #pragma once
 
+#include "../Container/PoolAllocator.h"
 #include "../IO/VectorBuffer.h"
 #include "../Math/Matrix3x4.h"
 #include "../Scene/Animatable.h"
@@ -75,8 +76,11 @@ struct URHO3D_API NodeImpl
 class URHO3D_API Node : public Animatable
 {
     URHO3D_OBJECT(Node, Animatable);
+    URHO3D_POOL_ALLOCATED();
 
     friend class Connection;
+    friend class SceneLoader;
+    friend class TransformHierarchy;
 
 public:
     /// Construct.
@@ -649,13 +653,13 @@ public:
     /// Set network position attribute.
     void SetNetPositionAttr(const Vector3& value);
     /// Set network rotation attribute.
-    void SetNetRotationAttr(const ea::vector<unsigned char>& value);
+    void SetNetRotationAttr(const Quaternion& value);
     /// Set network parent attribute.
     void SetNetParentAttr(const ea::vector<unsigned char>& value);
     /// Return network position attribute.
     const Vector3& GetNetPositionAttr() const;
     /// Return network rotation attribute.
-    const ea::vector<unsigned char>& GetNetRotationAttr() const;
+    const Quaternion& GetNetRotationAttr() const;
     /// Return network parent attribute.
     const ea::vector<unsigned char>& GetNetParentAttr() const;
     /// Load components and optionally load child nodes.
@@ -716,6 +720,8 @@ private:
     Component* SafeCreateComponent(const ea::string& typeName, StringHash type, CreateMode mode, unsigned id);
     /// Recalculate the world transform.
     void UpdateWorldTransform() const;
+    /// Notify listener components that the node is marked dirty.
+    void NotifyListenersDirty();
     /// Remove child node by iterator.
     void RemoveChild(ea::vector<SharedPtr<Node> >::iterator i);
     /// Return child nodes recursively.
@@ -761,6 +767,8 @@ private:
     Vector3 scale_;
     /// World-space rotation.
     mutable Quaternion worldRotation_;
+    /// Index in scene transform hierarchy, if enabled.
+    unsigned transformIndex_{ M_MAX_UNSIGNED };
     /// Components.
     ea::vector<SharedPtr<Component> > components_;
     /// Child scene nodes.
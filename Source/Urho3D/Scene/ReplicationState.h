@@ -25,7 +25,9 @@
 #include <EASTL/hash_set.h>
 #include <EASTL/unordered_map.h>
 
+#include "../Container/ByteVector.h"
 #include "../Core/Attribute.h"
+#include "../Core/Mutex.h"
 #include "../Math/StringHash.h"
 
 #include <cstring>
@@ -111,6 +113,12 @@ struct URHO3D_API DirtyBits
     /// Return number of set bits.
     unsigned Count() const { return count_; }
 
+    /// Test for equality with another bit set.
+    bool operator ==(const DirtyBits& rhs) const
+    {
+        return count_ == rhs.count_ && memcmp(data_, rhs.data_, MAX_NETWORK_ATTRIBUTES / 8) == 0;
+    }
+
     /// Bit data.
     unsigned char data_[MAX_NETWORK_ATTRIBUTES / 8]{};
     /// Number of set bits.
@@ -132,6 +140,76 @@ struct URHO3D_API NetworkState
     VariantMap previousVars_;
     /// Bitmask for intercepting network messages. Used on the client only.
     unsigned long long interceptMask_{};
+
+    /// Serialized attribute bitfields and values shared by all connections.
+    ea::vector<ea::pair<DirtyBits, ByteVector>> serializedDeltas_;
+    /// Serialized latest data shared by all connections.
+    ByteVector serializedLatestData_;
+    /// Mutex for serialized data, which is written from connection update threads.
+    SpinLockMutex serializedDataMutex_;
+
+    /// Discard serialized data. Should be called whenever current values are updated.
+    void ClearSerializedData()
+    {
+        serializedDeltas_.clear();
+        serializedLatestData_.clear();
+    }
+};
+
+/// Latest data attributes of an object sent in a scene snapshot.
+struct URHO3D_API SnapshotEntry
+{
+    /// Snapshot ID.
+    unsigned snapshotID_{};
+    /// Whether the snapshot is known to be received.
+    bool acked_{};
+    /// Serialized latest data attributes.
+    ByteVector data_;
+};
+
+/// Recently sent or received latest data of an object, used as delta bases in snapshot replication mode.
+struct URHO3D_API SnapshotHistory
+{
+    /// Max number of kept entries. Should be the same on server and client.
+    static const unsigned MAX_ENTRIES = 16;
+
+    /// Entries ordered by snapshot ID.
+    ea::vector<SnapshotEntry> entries_;
+    /// Whether the object has changes which are not yet acknowledged by the client. Used on the server only.
+    bool pending_{};
+
+    /// Add entry in order of snapshot ID, discarding the oldest one if necessary.
+    /// Entry older than all kept entries is ignored if there's no free space.
+    void Add(unsigned snapshotID, const unsigned char* data, unsigned size)
+    {
+        // Snapshots may be received out of order
+        unsigned index = entries_.size();
+        while (index > 0 && entries_[index - 1].snapshotID_ > snapshotID)
+            --index;
+
+        if (entries_.size() >= MAX_ENTRIES)
+        {
+            if (index == 0)
+                return;
+            entries_.erase(entries_.begin());
+            --index;
+        }
+
+        SnapshotEntry& entry = *entries_.emplace(entries_.begin() + index);
+        entry.snapshotID_ = snapshotID;
+        entry.data_.assign(data, data + size);
+    }
+
+    /// Return entry by snapshot ID, or null if not found.
+    const SnapshotEntry* Find(unsigned snapshotID) const
+    {
+        for (const SnapshotEntry& entry : entries_)
+        {
+            if (entry.snapshotID_ == snapshotID)
+                return &entry;
+        }
+        return nullptr;
+    }
 };
 
 /// Base class for per-user network replication states.
@@ -150,6 +228,8 @@ struct URHO3D_API ComponentReplicationState : public ReplicationState
     WeakPtr<Component> component_;
     /// Dirty attribute bits.
     DirtyBits dirtyAttributes_;
+    /// Sent snapshots of component latest data attributes.
+    SnapshotHistory snapshots_;
 };
 
 /// Per-user node network replication state.
@@ -165,8 +245,14 @@ struct URHO3D_API NodeReplicationState : public ReplicationState
     ea::hash_set<StringHash> dirtyVars_;
     /// Components by ID.
     ea::unordered_map<unsigned, ComponentReplicationState> componentStates_;
+    /// Sent snapshots of node latest data attributes.
+    SnapshotHistory snapshots_;
     /// Interest management priority accumulator.
     float priorityAcc_{};
+    /// Priority accumulated while waiting for update within interest manager update budget.
+    float schedulePriority_{};
+    /// Whether the update passed priority check and is waiting for interest manager update budget.
+    bool updateDue_{};
     /// Whether exists in the SceneState's dirty set.
     bool markedDirty_{};
 };
@@ -178,11 +264,14 @@ struct URHO3D_API SceneReplicationState : public ReplicationState
     ea::unordered_map<unsigned, NodeReplicationState> nodeStates_;
     /// Dirty node IDs.
     ea::hash_set<unsigned> dirtyNodes_;
+    /// Removed node IDs. Nodes are also marked dirty.
+    ea::vector<unsigned> removedNodes_;
 
     void Clear()
     {
         nodeStates_.clear();
         dirtyNodes_.clear();
+        removedNodes_.clear();
     }
 };
 
@@ -44,6 +44,7 @@
 #include "../Scene/SceneManager.h"
 #include "../Scene/SmoothedTransform.h"
 #include "../Scene/SplinePath.h"
+#include "../Scene/TransformHierarchy.h"
 #include "../Scene/UnknownComponent.h"
 #include "../Scene/ValueAnimation.h"
 
@@ -86,6 +87,9 @@ Scene::Scene(Context* context) :
 
 Scene::~Scene()
 {
+    // Don't maintain transform hierarchy during destruction
+    transformHierarchy_ = nullptr;
+
     // Remove root-level components first, so that scene subsystems such as the octree destroy themselves. This will speed up
     // the removal of child nodes' components
     RemoveAllComponents();
@@ -394,52 +398,9 @@ bool Scene::LoadAsync(File* file, LoadMode mode)
             file->Seek(0);
     }
 
-    if (mode > LOAD_RESOURCES_ONLY)
-    {
-        URHO3D_LOGINFO("Loading scene from " + file->GetName());
-        Clear();
-    }
-
-    asyncLoading_ = true;
-    asyncProgress_.file_ = file;
-    asyncProgress_.mode_ = mode;
-    asyncProgress_.loadedNodes_ = asyncProgress_.totalNodes_ = asyncProgress_.loadedResources_ = asyncProgress_.totalResources_ = 0;
-    asyncProgress_.resources_.clear();
-
-    if (mode > LOAD_RESOURCES_ONLY)
-    {
-        // Preload resources if appropriate, then return to the original position for loading the scene content
-        if (mode != LOAD_SCENE)
-        {
-            URHO3D_PROFILE("FindResourcesToPreload");
-
-            unsigned currentPos = file->GetPosition();
-            PreloadResources(file, isSceneFile);
-            file->Seek(currentPos);
-        }
-
-        // Store own old ID for resolving possible root node references
-        unsigned nodeID = file->ReadUInt();
-        resolver_.AddNode(nodeID, this);
-
-        // Load root level components first
-        if (!Node::Load(*file, resolver_, false))
-        {
-            StopAsyncLoading();
-            return false;
-        }
-
-        // Then prepare to load child nodes in the async updates
-        asyncProgress_.totalNodes_ = file->ReadVLE();
-    }
-    else
-    {
-        URHO3D_PROFILE("FindResourcesToPreload");
-
-        URHO3D_LOGINFO("Preloading resources from " + file->GetName());
-        PreloadResources(file, isSceneFile);
-    }
-
+    auto loader = MakeShared<SceneLoader>(context_);
+    StartAsyncLoading(file, mode, loader);
+    loader->StartBinary(file, isSceneFile);
     return true;
 }
 
@@ -453,62 +414,9 @@ bool Scene::LoadAsyncXML(File* file, LoadMode mode)
 
     StopAsyncLoading();
 
-    SharedPtr<XMLFile> xml(context_->CreateObject<XMLFile>());
-    if (!xml->Load(*file))
-        return false;
-
-    if (mode > LOAD_RESOURCES_ONLY)
-    {
-        URHO3D_LOGINFO("Loading scene from " + file->GetName());
-        Clear();
-    }
-
-    asyncLoading_ = true;
-    asyncProgress_.xmlFile_ = xml;
-    asyncProgress_.file_ = file;
-    asyncProgress_.mode_ = mode;
-    asyncProgress_.loadedNodes_ = asyncProgress_.totalNodes_ = asyncProgress_.loadedResources_ = asyncProgress_.totalResources_ = 0;
-    asyncProgress_.resources_.clear();
-
-    if (mode > LOAD_RESOURCES_ONLY)
-    {
-        XMLElement rootElement = xml->GetRoot();
-
-        // Preload resources if appropriate
-        if (mode != LOAD_SCENE)
-        {
-            URHO3D_PROFILE("FindResourcesToPreload");
-
-            PreloadResourcesXML(rootElement);
-        }
-
-        // Store own old ID for resolving possible root node references
-        unsigned nodeID = rootElement.GetUInt("id");
-        resolver_.AddNode(nodeID, this);
-
-        // Load the root level components first
-        if (!Node::LoadXML(rootElement, resolver_, false))
-            return false;
-
-        // Then prepare for loading all root level child nodes in the async update
-        XMLElement childNodeElement = rootElement.GetChild("node");
-        asyncProgress_.xmlElement_ = childNodeElement;
-
-        // Count the amount of child nodes
-        while (childNodeElement)
-        {
-            ++asyncProgress_.totalNodes_;
-            childNodeElement = childNodeElement.GetNext("node");
-        }
-    }
-    else
-    {
-        URHO3D_PROFILE("FindResourcesToPreload");
-
-        URHO3D_LOGINFO("Preloading resources from " + file->GetName());
-        PreloadResourcesXML(xml->GetRoot());
-    }
-
+    auto loader = MakeShared<SceneLoader>(context_);
+    StartAsyncLoading(file, mode, loader);
+    loader->StartXML(file);
     return true;
 }
 
@@ -522,58 +430,9 @@ bool Scene::LoadAsyncJSON(File* file, LoadMode mode)
 
     StopAsyncLoading();
 
-    SharedPtr<JSONFile> json(context_->CreateObject<JSONFile>());
-    if (!json->Load(*file))
-        return false;
-
-    if (mode > LOAD_RESOURCES_ONLY)
-    {
-        URHO3D_LOGINFO("Loading scene from " + file->GetName());
-        Clear();
-    }
-
-    asyncLoading_ = true;
-    asyncProgress_.jsonFile_ = json;
-    asyncProgress_.file_ = file;
-    asyncProgress_.mode_ = mode;
-    asyncProgress_.loadedNodes_ = asyncProgress_.totalNodes_ = asyncProgress_.loadedResources_ = asyncProgress_.totalResources_ = 0;
-    asyncProgress_.resources_.clear();
-
-    if (mode > LOAD_RESOURCES_ONLY)
-    {
-        JSONValue rootVal = json->GetRoot();
-
-        // Preload resources if appropriate
-        if (mode != LOAD_SCENE)
-        {
-            URHO3D_PROFILE("FindResourcesToPreload");
-
-            PreloadResourcesJSON(rootVal);
-        }
-
-        // Store own old ID for resolving possible root node references
-        unsigned nodeID = rootVal.Get("id").GetUInt();
-        resolver_.AddNode(nodeID, this);
-
-        // Load the root level components first
-        if (!Node::LoadJSON(rootVal, resolver_, false))
-            return false;
-
-        // Then prepare for loading all root level child nodes in the async update
-        JSONArray childrenArray = rootVal.Get("children").GetArray();
-        asyncProgress_.jsonIndex_ = 0;
-
-        // Count the amount of child nodes
-        asyncProgress_.totalNodes_ = childrenArray.size();
-    }
-    else
-    {
-        URHO3D_PROFILE("FindResourcesToPreload");
-
-        URHO3D_LOGINFO("Preloading resources from " + file->GetName());
-        PreloadResourcesJSON(json->GetRoot());
-    }
-
+    auto loader = MakeShared<SceneLoader>(context_);
+    StartAsyncLoading(file, mode, loader);
+    loader->StartJSON(file);
     return true;
 }
 
@@ -581,10 +440,8 @@ void Scene::StopAsyncLoading()
 {
     asyncLoading_ = false;
     asyncProgress_.file_.Reset();
-    asyncProgress_.xmlFile_.Reset();
-    asyncProgress_.jsonFile_.Reset();
-    asyncProgress_.xmlElement_ = XMLElement::EMPTY;
-    asyncProgress_.jsonIndex_ = 0;
+    asyncProgress_.loader_.Reset();
+    asyncProgress_.parsed_ = false;
     asyncProgress_.resources_.clear();
     resolver_.Reset();
 }
@@ -874,12 +731,38 @@ void Scene::Update(float timeStep)
     // Post-update variable timestep logic
     SendEvent(E_SCENEPOSTUPDATE, eventData);
 
+    // Update world transforms of moved nodes at once
+    UpdateTransformHierarchy();
+
     // Note: using a float for elapsed time accumulation is inherently inaccurate. The purpose of this value is
     // primarily to update material animation effects, as it is available to shaders. It can be reset by calling
     // SetElapsedTime()
     elapsedTime_ += timeStep;
 }
 
+void Scene::SetTransformHierarchyEnabled(bool enable)
+{
+    if (enable == IsTransformHierarchyEnabled())
+        return;
+
+    if (enable)
+        transformHierarchy_ = ea::make_unique<TransformHierarchy>(this);
+    else
+        transformHierarchy_ = nullptr;
+}
+
+void Scene::MarkTransformHierarchyDirty()
+{
+    if (transformHierarchy_)
+        transformHierarchy_->MarkStructureDirty();
+}
+
+void Scene::UpdateTransformHierarchy()
+{
+    if (transformHierarchy_)
+        transformHierarchy_->Update();
+}
+
 void Scene::BeginThreadedUpdate()
 {
     // Check the work queue subsystem whether it actually has created worker threads. If not, do not enter threaded mode.
@@ -1057,7 +940,7 @@ void Scene::NodeRemoved(Node* node)
     if (Scene::IsReplicatedID(id))
     {
         replicatedNodes_.erase(id);
-        MarkReplicationDirty(node);
+        MarkReplicationRemoved(node);
     }
     else
         localNodes_.erase(id);
@@ -1184,6 +1067,14 @@ void Scene::PrepareNetworkUpdate()
 
     networkUpdateNodes_.clear();
     networkUpdateComponents_.clear();
+
+    // Connections read world positions of replicated nodes from worker threads, so update them beforehand
+    for (auto i = replicatedNodes_.begin(); i != replicatedNodes_.end(); ++i)
+    {
+        Node* node = i->second;
+        if (node->IsDirty())
+            node->GetWorldTransform();
+    }
 }
 
 void Scene::CleanupConnection(Connection* connection)
@@ -1239,6 +1130,20 @@ void Scene::MarkReplicationDirty(Node* node)
     }
 }
 
+void Scene::MarkReplicationRemoved(Node* node)
+{
+    if (networkState_ && node->IsReplicated())
+    {
+        unsigned id = node->GetID();
+        for (auto i = networkState_->replicationStates_.begin(); i != networkState_->replicationStates_.end(); ++i)
+        {
+            auto* nodeState = static_cast<NodeReplicationState*>(*i);
+            nodeState->sceneState_->dirtyNodes_.insert(id);
+            nodeState->sceneState_->removedNodes_.push_back(id);
+        }
+    }
+}
+
 void Scene::HandleUpdate(StringHash eventType, VariantMap& eventData)
 {
     if (!updateEnabled_)
@@ -1263,10 +1168,66 @@ void Scene::HandleResourceBackgroundLoaded(StringHash eventType, VariantMap& eve
     }
 }
 
+void Scene::StartAsyncLoading(File* file, LoadMode mode, SceneLoader* loader)
+{
+    if (mode > LOAD_RESOURCES_ONLY)
+    {
+        URHO3D_LOGINFO("Loading scene from " + file->GetName());
+        Clear();
+    }
+    else
+        URHO3D_LOGINFO("Preloading resources from " + file->GetName());
+
+    // File content is parsed in worker threads and is processed in the async updates
+    asyncLoading_ = true;
+    asyncProgress_.file_ = file;
+    asyncProgress_.loader_ = loader;
+    asyncProgress_.parsed_ = false;
+    asyncProgress_.mode_ = mode;
+    asyncProgress_.loadedNodes_ = asyncProgress_.totalNodes_ = asyncProgress_.loadedResources_ = asyncProgress_.totalResources_ = 0;
+    asyncProgress_.resources_.clear();
+}
+
 void Scene::UpdateAsyncLoading()
 {
     URHO3D_PROFILE("UpdateAsyncLoading");
 
+    // Wait until the file is parsed in worker threads, then preload resources and load the root node
+    if (!asyncProgress_.parsed_)
+    {
+        SceneLoader* loader = asyncProgress_.loader_;
+        if (!loader->IsParsed())
+            return;
+
+        if (!loader->IsSuccessful())
+        {
+            URHO3D_LOGERROR("Could not load " + asyncProgress_.file_->GetName());
+            StopAsyncLoading();
+            return;
+        }
+
+        asyncProgress_.parsed_ = true;
+        if (asyncProgress_.mode_ != LOAD_SCENE)
+        {
+            URHO3D_PROFILE("PreloadResources");
+            PreloadResources();
+        }
+
+        if (asyncProgress_.mode_ > LOAD_RESOURCES_ONLY)
+        {
+            // Load the root level components first
+            if (!loader->CommitRoot(this, resolver_))
+            {
+                URHO3D_LOGERROR("Could not load " + asyncProgress_.file_->GetName());
+                StopAsyncLoading();
+                return;
+            }
+
+            // Then prepare to load child nodes in the async updates
+            asyncProgress_.totalNodes_ = loader->GetNumRootChildren();
+        }
+    }
+
     // If resources left to load, do not load nodes yet
     if (asyncProgress_.loadedResources_ < asyncProgress_.totalResources_)
         return;
@@ -1281,36 +1242,9 @@ void Scene::UpdateAsyncLoading()
             return;
         }
 
-
-        // Read one child node with its full sub-hierarchy either from binary, JSON, or XML
+        // Create one child node with its full sub-hierarchy from parsed data
         /// \todo Works poorly in scenes where one root-level child node contains all content
-        if (asyncProgress_.xmlFile_)
-        {
-            unsigned nodeID = asyncProgress_.xmlElement_.GetUInt("id");
-            Node* newNode = CreateChild(nodeID, IsReplicatedID(nodeID) ? REPLICATED : LOCAL);
-            resolver_.AddNode(nodeID, newNode);
-            newNode->LoadXML(asyncProgress_.xmlElement_, resolver_);
-            asyncProgress_.xmlElement_ = asyncProgress_.xmlElement_.GetNext("node");
-        }
-        else if (asyncProgress_.jsonFile_) // Load from JSON
-        {
-            const JSONValue& childValue = asyncProgress_.jsonFile_->GetRoot().Get("children").GetArray().at(
-                asyncProgress_.jsonIndex_);
-
-            unsigned nodeID =childValue.Get("id").GetUInt();
-            Node* newNode = CreateChild(nodeID, IsReplicatedID(nodeID) ? REPLICATED : LOCAL);
-            resolver_.AddNode(nodeID, newNode);
-            newNode->LoadJSON(childValue, resolver_);
-            ++asyncProgress_.jsonIndex_;
-        }
-        else // Load from binary
-        {
-            unsigned nodeID = asyncProgress_.file_->ReadUInt();
-            Node* newNode = CreateChild(nodeID, IsReplicatedID(nodeID) ? REPLICATED : LOCAL);
-            resolver_.AddNode(nodeID, newNode);
-            newNode->Load(*asyncProgress_.file_, resolver_);
-        }
-
+        asyncProgress_.loader_->CommitNextChild(this, resolver_);
         ++asyncProgress_.loadedNodes_;
 
         // Break if time limit exceeded, so that we keep sufficient FPS
@@ -1369,241 +1303,24 @@ void Scene::FinishSaving(Serializer* dest) const
     }
 }
 
-void Scene::PreloadResources(File* file, bool isSceneFile)
-{
-    // If not threaded, can not background load resources, so rather load synchronously later when needed
-#ifdef URHO3D_THREADING
-    auto* cache = GetSubsystem<ResourceCache>();
-
-    // Read node ID (not needed)
-    /*unsigned nodeID = */file->ReadUInt();
-
-    // Read Node or Scene attributes; these do not include any resources
-    const ea::vector<AttributeInfo>* attributes = context_->GetAttributes(isSceneFile ? Scene::GetTypeStatic() : Node::GetTypeStatic());
-    assert(attributes);
-
-    for (unsigned i = 0; i < attributes->size(); ++i)
-    {
-        const AttributeInfo& attr = attributes->at(i);
-        if (!(attr.mode_ & AM_FILE))
-            continue;
-        /*Variant varValue = */file->ReadVariant(attr.type_);
-    }
-
-    // Read component attributes
-    unsigned numComponents = file->ReadVLE();
-    for (unsigned i = 0; i < numComponents; ++i)
-    {
-        VectorBuffer compBuffer(*file, file->ReadVLE());
-        StringHash compType = compBuffer.ReadStringHash();
-        // Read component ID (not needed)
-        /*unsigned compID = */compBuffer.ReadUInt();
-
-        attributes = context_->GetAttributes(compType);
-        if (attributes)
-        {
-            for (unsigned j = 0; j < attributes->size(); ++j)
-            {
-                const AttributeInfo& attr = attributes->at(j);
-                if (!(attr.mode_ & AM_FILE))
-                    continue;
-                Variant varValue = compBuffer.ReadVariant(attr.type_);
-                if (attr.type_ == VAR_RESOURCEREF)
-                {
-                    const ResourceRef& ref = varValue.GetResourceRef();
-                    // Sanitate resource name beforehand so that when we get the background load event, the name matches exactly
-                    ea::string name = cache->SanitateResourceName(ref.name_);
-                    bool success = cache->BackgroundLoadResource(ref.type_, name);
-                    if (success)
-                    {
-                        ++asyncProgress_.totalResources_;
-                        asyncProgress_.resources_.insert(StringHash(name));
-                    }
-                }
-                else if (attr.type_ == VAR_RESOURCEREFLIST)
-                {
-                    const ResourceRefList& refList = varValue.GetResourceRefList();
-                    for (unsigned k = 0; k < refList.names_.size(); ++k)
-                    {
-                        ea::string name = cache->SanitateResourceName(refList.names_[k]);
-                        bool success = cache->BackgroundLoadResource(refList.type_, name);
-                        if (success)
-                        {
-                            ++asyncProgress_.totalResources_;
-                            asyncProgress_.resources_.insert(StringHash(name));
-                        }
-                    }
-                }
-            }
-        }
-    }
-
-    // Read child nodes
-    unsigned numChildren = file->ReadVLE();
-    for (unsigned i = 0; i < numChildren; ++i)
-        PreloadResources(file, false);
-#endif
-}
-
-void Scene::PreloadResourcesXML(const XMLElement& element)
+void Scene::PreloadResources()
 {
     // If not threaded, can not background load resources, so rather load synchronously later when needed
 #ifdef URHO3D_THREADING
     auto* cache = GetSubsystem<ResourceCache>();
 
-    // Node or Scene attributes do not include any resources; therefore skip to the components
-    XMLElement compElem = element.GetChild("component");
-    while (compElem)
+    for (const SceneDataChunk& chunk : asyncProgress_.loader_->GetChunks())
     {
-        ea::string typeName = compElem.GetAttribute("type");
-        const ea::vector<AttributeInfo>* attributes = context_->GetAttributes(StringHash(typeName));
-        if (attributes)
+        for (const auto& typeAndName : chunk.resources_)
         {
-            XMLElement attrElem = compElem.GetChild("attribute");
-            unsigned startIndex = 0;
-
-            while (attrElem)
+            // Sanitate resource name beforehand so that when we get the background load event, the name matches exactly
+            const ea::string name = cache->SanitateResourceName(typeAndName.second);
+            if (cache->BackgroundLoadResource(typeAndName.first, name))
             {
-                ea::string name = attrElem.GetAttribute("name");
-                unsigned i = startIndex;
-                unsigned attempts = attributes->size();
-
-                while (attempts)
-                {
-                    const AttributeInfo& attr = attributes->at(i);
-                    if ((attr.mode_ & AM_FILE) && !attr.name_.compare(name))
-                    {
-                        if (attr.type_ == VAR_RESOURCEREF)
-                        {
-                            ResourceRef ref = attrElem.GetVariantValue(attr.type_).GetResourceRef();
-                            ea::string name = cache->SanitateResourceName(ref.name_);
-                            bool success = cache->BackgroundLoadResource(ref.type_, name);
-                            if (success)
-                            {
-                                ++asyncProgress_.totalResources_;
-                                asyncProgress_.resources_.insert(StringHash(name));
-                            }
-                        }
-                        else if (attr.type_ == VAR_RESOURCEREFLIST)
-                        {
-                            ResourceRefList refList = attrElem.GetVariantValue(attr.type_).GetResourceRefList();
-                            for (unsigned k = 0; k < refList.names_.size(); ++k)
-                            {
-                                ea::string name = cache->SanitateResourceName(refList.names_[k]);
-                                bool success = cache->BackgroundLoadResource(refList.type_, name);
-                                if (success)
-                                {
-                                    ++asyncProgress_.totalResources_;
-                                    asyncProgress_.resources_.insert(StringHash(name));
-                                }
-                            }
-                        }
-
-                        startIndex = (i + 1) % attributes->size();
-                        break;
-                    }
-                    else
-                    {
-                        i = (i + 1) % attributes->size();
-                        --attempts;
-                    }
-                }
-
-                attrElem = attrElem.GetNext("attribute");
+                ++asyncProgress_.totalResources_;
+                asyncProgress_.resources_.insert(StringHash(name));
             }
         }
-
-        compElem = compElem.GetNext("component");
-    }
-
-    XMLElement childElem = element.GetChild("node");
-    while (childElem)
-    {
-        PreloadResourcesXML(childElem);
-        childElem = childElem.GetNext("node");
-    }
-#endif
-}
-
-void Scene::PreloadResourcesJSON(const JSONValue& value)
-{
-    // If not threaded, can not background load resources, so rather load synchronously later when needed
-#ifdef URHO3D_THREADING
-    auto* cache = GetSubsystem<ResourceCache>();
-
-    // Node or Scene attributes do not include any resources; therefore skip to the components
-    JSONArray componentArray = value.Get("components").GetArray();
-
-    for (unsigned i = 0; i < componentArray.size(); i++)
-    {
-        const JSONValue& compValue = componentArray.at(i);
-        ea::string typeName = compValue.Get("type").GetString();
-
-        const ea::vector<AttributeInfo>* attributes = context_->GetAttributes(StringHash(typeName));
-        if (attributes)
-        {
-            JSONArray attributesArray = compValue.Get("attributes").GetArray();
-
-            unsigned startIndex = 0;
-
-            for (unsigned j = 0; j < attributesArray.size(); j++)
-            {
-                const JSONValue& attrVal = attributesArray.at(j);
-                ea::string name = attrVal.Get("name").GetString();
-                unsigned i = startIndex;
-                unsigned attempts = attributes->size();
-
-                while (attempts)
-                {
-                    const AttributeInfo& attr = attributes->at(i);
-                    if ((attr.mode_ & AM_FILE) && !attr.name_.compare(name))
-                    {
-                        if (attr.type_ == VAR_RESOURCEREF)
-                        {
-                            ResourceRef ref = attrVal.Get("value").GetVariantValue(attr.type_).GetResourceRef();
-                            ea::string name = cache->SanitateResourceName(ref.name_);
-                            bool success = cache->BackgroundLoadResource(ref.type_, name);
-                            if (success)
-                            {
-                                ++asyncProgress_.totalResources_;
-                                asyncProgress_.resources_.insert(StringHash(name));
-                            }
-                        }
-                        else if (attr.type_ == VAR_RESOURCEREFLIST)
-                        {
-                            ResourceRefList refList = attrVal.Get("value").GetVariantValue(attr.type_).GetResourceRefList();
-                            for (unsigned k = 0; k < refList.names_.size(); ++k)
-                            {
-                                ea::string name = cache->SanitateResourceName(refList.names_[k]);
-                                bool success = cache->BackgroundLoadResource(refList.type_, name);
-                                if (success)
-                                {
-                                    ++asyncProgress_.totalResources_;
-                                    asyncProgress_.resources_.insert(StringHash(name));
-                                }
-                            }
-                        }
-
-                        startIndex = (i + 1) % attributes->size();
-                        break;
-                    }
-                    else
-                    {
-                        i = (i + 1) % attributes->size();
-                        --attempts;
-                    }
-                }
-
-            }
-        }
-
-    }
-
-    JSONArray childrenArray = value.Get("children").GetArray();
-    for (unsigned i = 0; i < childrenArray.size(); i++)
-    {
-        const JSONValue& childVal = childrenArray.at(i);
-        PreloadResourcesJSON(childVal);
     }
 #endif
 }
@@ -31,6 +31,7 @@
 #include "../Resource/XMLElement.h"
 #include "../Resource/JSONFile.h"
 #include "../Scene/Node.h"
+#include "../Scene/SceneLoader.h"
 #include "../Scene/SceneResolver.h"
 
 namespace Urho3D
@@ -39,6 +40,7 @@ namespace Urho3D
 class File;
 class PackageFile;
 class Texture2D;
+class TransformHierarchy;
 
 static const unsigned FIRST_REPLICATED_ID = 0x1;
 static const unsigned LAST_REPLICATED_ID = 0xffffff;
@@ -59,18 +61,12 @@ enum LoadMode
 /// Asynchronous loading progress of a scene.
 struct AsyncProgress
 {
-    /// File for binary mode.
+    /// Source file.
     SharedPtr<File> file_;
-    /// XML file for XML mode.
-    SharedPtr<XMLFile> xmlFile_;
-    /// JSON file for JSON mode.
-    SharedPtr<JSONFile> jsonFile_;
-
-    /// Current XML element for XML mode.
-    XMLElement xmlElement_;
-
-    /// Current JSON child array and for JSON mode.
-    unsigned jsonIndex_;
+    /// Loader that parses the file in worker threads.
+    SharedPtr<SceneLoader> loader_;
+    /// Whether the file is parsed and root node is loaded.
+    bool parsed_;
 
     /// Current load mode.
     LoadMode mode_;
@@ -279,6 +275,18 @@ public:
     /// Return threaded update flag.
     bool IsThreadedUpdate() const { return threadedUpdate_; }
 
+    /// Enable or disable flat transform hierarchy. When enabled, dirty nodes are marked without recursion
+    /// and world transforms of all dirty nodes are updated in one batch at the end of scene update.
+    void SetTransformHierarchyEnabled(bool enable);
+    /// Return whether the flat transform hierarchy is enabled.
+    bool IsTransformHierarchyEnabled() const { return transformHierarchy_ != nullptr; }
+    /// Return flat transform hierarchy, if enabled.
+    TransformHierarchy* GetTransformHierarchy() const { return transformHierarchy_.get(); }
+    /// Notify flat transform hierarchy that node hierarchy is changed.
+    void MarkTransformHierarchyDirty();
+    /// Update world transforms of all dirty nodes if flat transform hierarchy is enabled. Called by Update.
+    void UpdateTransformHierarchy();
+
     /// Get free node ID, either non-local or local.
     unsigned GetFreeNodeID(CreateMode mode);
     /// Get free component ID, either non-local or local.
@@ -314,6 +322,8 @@ public:
     void MarkNetworkUpdate(Component* component);
     /// Mark a node dirty in scene replication states. The node does not need to have own replication state yet.
     void MarkReplicationDirty(Node* node);
+    /// Mark a node removed in scene replication states.
+    void MarkReplicationRemoved(Node* node);
 
 private:
     /// Handle the logic update event to update the scene, if active.
@@ -328,12 +338,10 @@ private:
     void FinishLoading(Deserializer* source);
     /// Finish saving. Sets the scene filename and checksum.
     void FinishSaving(Serializer* dest) const;
-    /// Preload resources from a binary scene or object prefab file.
-    void PreloadResources(File* file, bool isSceneFile);
-    /// Preload resources from an XML scene or object prefab file.
-    void PreloadResourcesXML(const XMLElement& element);
-    /// Preload resources from a JSON scene or object prefab file.
-    void PreloadResourcesJSON(const JSONValue& value);
+    /// Start asynchronous loading with the loader.
+    void StartAsyncLoading(File* file, LoadMode mode, SceneLoader* loader);
+    /// Preload resources referenced by parsed scene or object prefab file.
+    void PreloadResources();
     /// Return component index storage for given type.
     SceneComponentIndex* GetMutableComponentIndex(StringHash componentType);
     /// Reload lightmap textures.
@@ -370,6 +378,8 @@ private:
     ea::hash_set<unsigned> networkUpdateComponents_;
     /// Delayed dirty notification queue for components.
     ea::vector<Component*> delayedDirtyComponents_;
+    /// Flat transform hierarchy.
+    ea::unique_ptr<TransformHierarchy> transformHierarchy_;
     /// Mutex for the delayed dirty notification queue.
     Mutex sceneMutex_;
     /// Preallocated event data map for smoothing update events.
@@ -0,0 +1,599 @@
+//
+// Copyright (c) 2017-2021 the rbfx project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "../Precompiled.h"
+
+#include "../Core/Context.h"
+#include "../Core/WorkQueue.h"
+#include "../IO/File.h"
+#include "../IO/Log.h"
+#include "../IO/MemoryBuffer.h"
+#include "../Resource/JSONFile.h"
+#include "../Resource/XMLFile.h"
+#include "../Scene/Component.h"
+#include "../Scene/Scene.h"
+#include "../Scene/SceneLoader.h"
+
+#include <EASTL/algorithm.h>
+
+#include "../DebugNew.h"
+
+namespace Urho3D
+{
+
+namespace
+{
+
+/// Return enum value by name or empty variant if not found.
+Variant ParseEnumValue(const AttributeInfo& attr, const ea::string& value)
+{
+    int enumValue = 0;
+    for (const char** enumPtr = attr.enumNames_; *enumPtr; ++enumPtr, ++enumValue)
+    {
+        if (!value.comparei(*enumPtr))
+            return enumValue;
+    }
+
+    URHO3D_LOGWARNING("Unknown enum value " + value + " in attribute " + attr.name_);
+    return Variant::EMPTY;
+}
+
+/// Collect resources referenced by attribute value.
+void CollectResources(const Variant& value, ea::vector<ea::pair<StringHash, ea::string>>& resources)
+{
+    if (value.GetType() == VAR_RESOURCEREF)
+    {
+        const ResourceRef& ref = value.GetResourceRef();
+        if (!ref.name_.empty())
+            resources.emplace_back(ref.type_, ref.name_);
+    }
+    else if (value.GetType() == VAR_RESOURCEREFLIST)
+    {
+        const ResourceRefList& refList = value.GetResourceRefList();
+        for (const ea::string& name : refList.names_)
+        {
+            if (!name.empty())
+                resources.emplace_back(refList.type_, name);
+        }
+    }
+}
+
+/// Return whether the object has attribute animations that can be loaded only on the main thread.
+bool HasAttributeAnimation(const XMLElement& source)
+{
+    return source.HasChild("objectanimation") || source.HasChild("attributeanimation");
+}
+
+/// Return whether the object has attribute animations that can be loaded only on the main thread.
+bool HasAttributeAnimation(const JSONValue& source)
+{
+    return source.Contains("objectanimation") || source.Contains("attributeanimation");
+}
+
+/// Return range of root-level children parsed by the chunk.
+ea::pair<unsigned, unsigned> GetChunkRange(unsigned numChildren, unsigned chunkIndex, unsigned numChunks)
+{
+    return { numChildren * chunkIndex / numChunks, numChildren * (chunkIndex + 1) / numChunks };
+}
+
+}
+
+SceneLoader::SceneLoader(Context* context)
+    : context_(context)
+{
+}
+
+SceneLoader::~SceneLoader()
+{
+}
+
+void SceneLoader::StartBinary(File* file, bool isSceneFile)
+{
+    file_ = file;
+    isSceneFile_ = isSceneFile;
+    chunks_.resize(1);
+
+    // Binary format cannot be split without reading it, so whole file is parsed by one work item
+    auto workQueue = context_->GetSubsystem<WorkQueue>();
+    SharedPtr<SceneLoader> self(this);
+    workItems_.push_back(workQueue->AddWorkItem([self](unsigned) { self->ParseBinary(); }));
+}
+
+void SceneLoader::StartXML(File* file)
+{
+    file_ = file;
+    xmlFile_ = MakeShared<XMLFile>(context_);
+
+    auto workQueue = context_->GetSubsystem<WorkQueue>();
+    const unsigned numChunks = workQueue->GetNumThreads() + 1;
+    chunks_.resize(numChunks);
+
+    SharedPtr<SceneLoader> self(this);
+    const SharedPtr<WorkItem> documentItem = workQueue->AddWorkItem([self](unsigned) { self->LoadDocument(); });
+    workItems_.push_back(documentItem);
+    for (unsigned i = 0; i < numChunks; ++i)
+        workItems_.push_back(workQueue->AddWorkItem([self, i](unsigned) { self->ParseXMLChunk(i); }, { &documentItem, 1 }));
+}
+
+void SceneLoader::StartJSON(File* file)
+{
+    file_ = file;
+    jsonFile_ = MakeShared<JSONFile>(context_);
+
+    auto workQueue = context_->GetSubsystem<WorkQueue>();
+    const unsigned numChunks = workQueue->GetNumThreads() + 1;
+    chunks_.resize(numChunks);
+
+    SharedPtr<SceneLoader> self(this);
+    const SharedPtr<WorkItem> documentItem = workQueue->AddWorkItem([self](unsigned) { self->LoadDocument(); });
+    workItems_.push_back(documentItem);
+    for (unsigned i = 0; i < numChunks; ++i)
+        workItems_.push_back(workQueue->AddWorkItem([self, i](unsigned) { self->ParseJSONChunk(i); }, { &documentItem, 1 }));
+}
+
+bool SceneLoader::IsParsed() const
+{
+    for (const SharedPtr<WorkItem>& item : workItems_)
+    {
+        if (!item->completed_.load(std::memory_order_acquire))
+            return false;
+    }
+    return true;
+}
+
+bool SceneLoader::IsSuccessful() const
+{
+    if (!rootSuccess_)
+        return false;
+
+    for (const SceneDataChunk& chunk : chunks_)
+    {
+        if (!chunk.success_)
+            return false;
+    }
+    return true;
+}
+
+unsigned SceneLoader::GetNumRootChildren() const
+{
+    unsigned numChildren = 0;
+    for (const SceneDataChunk& chunk : chunks_)
+    {
+        for (const NodeData& data : chunk.nodes_)
+        {
+            if (data.parentIndex_ == M_MAX_UNSIGNED)
+                ++numChildren;
+        }
+    }
+    return numChildren;
+}
+
+bool SceneLoader::CommitRoot(Scene* scene, SceneResolver& resolver) const
+{
+    // Store own old ID for resolving possible root node references
+    resolver.AddNode(root_.node_.id_, scene);
+    return CommitNode(scene, root_, resolver);
+}
+
+bool SceneLoader::CommitNextChild(Scene* scene, SceneResolver& resolver)
+{
+    while (commitChunkIndex_ < chunks_.size() && commitNodeIndex_ >= chunks_[commitChunkIndex_].nodes_.size())
+    {
+        ++commitChunkIndex_;
+        commitNodeIndex_ = 0;
+        committedNodes_.clear();
+    }
+
+    if (commitChunkIndex_ >= chunks_.size())
+        return false;
+
+    // Commit root-level node and all nodes up to the next root-level node
+    const ea::vector<NodeData>& nodes = chunks_[commitChunkIndex_].nodes_;
+    do
+    {
+        const NodeData& data = nodes[commitNodeIndex_];
+        Node* parent = data.parentIndex_ == M_MAX_UNSIGNED ? scene : committedNodes_[data.parentIndex_];
+
+        const unsigned nodeID = data.node_.id_;
+        Node* node = parent->CreateChild(nodeID, Scene::IsReplicatedID(nodeID) ? REPLICATED : LOCAL);
+        resolver.AddNode(nodeID, node);
+        CommitNode(node, data, resolver);
+
+        committedNodes_.push_back(node);
+        ++commitNodeIndex_;
+    } while (commitNodeIndex_ < nodes.size() && nodes[commitNodeIndex_].parentIndex_ != M_MAX_UNSIGNED);
+
+    return true;
+}
+
+void SceneLoader::ParseBinary()
+{
+    SceneDataChunk& chunk = chunks_[0];
+
+    root_.node_.id_ = file_->ReadUInt();
+    rootSuccess_ = ParseNodeContents(*file_, isSceneFile_ ? Scene::GetTypeStatic() : Node::GetTypeStatic(),
+        root_, chunk.resources_);
+    if (!rootSuccess_)
+        return;
+
+    const unsigned numChildren = file_->ReadVLE();
+    for (unsigned i = 0; i < numChildren; ++i)
+    {
+        if (!ParseNode(*file_, M_MAX_UNSIGNED, chunk))
+        {
+            chunk.success_ = false;
+            return;
+        }
+    }
+}
+
+void SceneLoader::LoadDocument()
+{
+    // Resources of the root node are stored in the first chunk, it is parsed strictly after this item
+    if (xmlFile_)
+    {
+        rootSuccess_ = xmlFile_->Load(*file_);
+        if (rootSuccess_)
+            ParseNodeContents(xmlFile_->GetRoot(), Scene::GetTypeStatic(), root_, chunks_[0].resources_);
+    }
+    else if (jsonFile_)
+    {
+        rootSuccess_ = jsonFile_->Load(*file_);
+        if (rootSuccess_)
+            ParseNodeContents(jsonFile_->GetRoot(), Scene::GetTypeStatic(), root_, chunks_[0].resources_);
+    }
+}
+
+void SceneLoader::ParseXMLChunk(unsigned chunkIndex)
+{
+    if (!rootSuccess_)
+        return;
+
+    const XMLElement rootElement = xmlFile_->GetRoot();
+    unsigned numChildren = 0;
+    for (XMLElement childElement = rootElement.GetChild("node"); childElement; childElement = childElement.GetNext("node"))
+        ++numChildren;
+
+    const auto range = GetChunkRange(numChildren, chunkIndex, chunks_.size());
+    XMLElement childElement = rootElement.GetChild("node");
+    for (unsigned i = 0; i < range.first; ++i)
+        childElement = childElement.GetNext("node");
+
+    SceneDataChunk& chunk = chunks_[chunkIndex];
+    for (unsigned i = range.first; i < range.second; ++i)
+    {
+        ParseNode(childElement, M_MAX_UNSIGNED, chunk);
+        childElement = childElement.GetNext("node");
+    }
+}
+
+void SceneLoader::ParseJSONChunk(unsigned chunkIndex)
+{
+    if (!rootSuccess_)
+        return;
+
+    const JSONArray& childrenArray = jsonFile_->GetRoot().Get("children").GetArray();
+    const auto range = GetChunkRange(childrenArray.size(), chunkIndex, chunks_.size());
+
+    SceneDataChunk& chunk = chunks_[chunkIndex];
+    for (unsigned i = range.first; i < range.second; ++i)
+        ParseNode(childrenArray[i], M_MAX_UNSIGNED, chunk);
+}
+
+bool SceneLoader::ParseNode(Deserializer& source, unsigned parentIndex, SceneDataChunk& chunk) const
+{
+    const unsigned index = chunk.nodes_.size();
+    NodeData& data = chunk.nodes_.emplace_back();
+    data.parentIndex_ = parentIndex;
+    data.node_.id_ = source.ReadUInt();
+    if (!ParseNodeContents(source, Node::GetTypeStatic(), data, chunk.resources_))
+        return false;
+
+    const unsigned numChildren = source.ReadVLE();
+    for (unsigned i = 0; i < numChildren; ++i)
+    {
+        if (!ParseNode(source, index, chunk))
+            return false;
+    }
+
+    return true;
+}
+
+bool SceneLoader::ParseNodeContents(Deserializer& source, StringHash type, NodeData& data,
+    ea::vector<ea::pair<StringHash, ea::string>>& resources) const
+{
+    // ID has been read at the parent level
+    data.node_.type_ = type;
+    if (!ParseAttributes(source, data.node_, resources))
+        return false;
+
+    ByteVector componentBuffer;
+    const unsigned numComponents = source.ReadVLE();
+    data.components_.resize(numComponents);
+    for (SerializableData& component : data.components_)
+    {
+        componentBuffer.resize(source.ReadVLE());
+        source.Read(componentBuffer.data(), componentBuffer.size());
+
+        MemoryBuffer componentSource(componentBuffer);
+        component.type_ = componentSource.ReadStringHash();
+        component.id_ = componentSource.ReadUInt();
+
+        if (context_->GetTypeName(component.type_).empty())
+        {
+            const unsigned position = componentSource.GetPosition();
+            component.binarySource_.assign(componentBuffer.begin() + position, componentBuffer.end());
+        }
+        else
+        {
+            // Do not abort if component fails to load, as the component buffer is nested and we can skip to the next
+            ParseAttributes(componentSource, component, resources);
+        }
+    }
+
+    return true;
+}
+
+void SceneLoader::ParseNode(const XMLElement& source, unsigned parentIndex, SceneDataChunk& chunk) const
+{
+    const unsigned index = chunk.nodes_.size();
+    NodeData& data = chunk.nodes_.emplace_back();
+    data.parentIndex_ = parentIndex;
+    ParseNodeContents(source, Node::GetTypeStatic(), data, chunk.resources_);
+
+    for (XMLElement childElement = source.GetChild("node"); childElement; childElement = childElement.GetNext("node"))
+        ParseNode(childElement, index, chunk);
+}
+
+void SceneLoader::ParseNodeContents(const XMLElement& source, StringHash type, NodeData& data,
+    ea::vector<ea::pair<StringHash, ea::string>>& resources) const
+{
+    data.node_.type_ = type;
+    data.node_.id_ = source.GetUInt("id");
+    ParseAttributes(source, data.node_, resources);
+    if (HasAttributeAnimation(source))
+        data.node_.xmlSource_ = source;
+
+    for (XMLElement componentElement = source.GetChild("component"); componentElement;
+         componentElement = componentElement.GetNext("component"))
+    {
+        SerializableData& component = data.components_.emplace_back();
+        component.typeName_ = componentElement.GetAttribute("type");
+        component.type_ = StringHash(component.typeName_);
+        component.id_ = componentElement.GetUInt("id");
+
+        const bool isKnownType = !context_->GetTypeName(component.type_).empty();
+        if (isKnownType)
+            ParseAttributes(componentElement, component, resources);
+        if (!isKnownType || HasAttributeAnimation(componentElement))
+            component.xmlSource_ = componentElement;
+    }
+}
+
+void SceneLoader::ParseNode(const JSONValue& source, unsigned parentIndex, SceneDataChunk& chunk) const
+{
+    const unsigned index = chunk.nodes_.size();
+    NodeData& data = chunk.nodes_.emplace_back();
+    data.parentIndex_ = parentIndex;
+    ParseNodeContents(source, Node::GetTypeStatic(), data, chunk.resources_);
+
+    for (const JSONValue& childValue : source.Get("children").GetArray())
+        ParseNode(childValue, index, chunk);
+}
+
+void SceneLoader::ParseNodeContents(const JSONValue& source, StringHash type, NodeData& data,
+    ea::vector<ea::pair<StringHash, ea::string>>& resources) const
+{
+    data.node_.type_ = type;
+    data.node_.id_ = source.Get("id").GetUInt();
+    ParseAttributes(source, data.node_, resources);
+    if (HasAttributeAnimation(source))
+        data.node_.jsonSource_ = &source;
+
+    const JSONArray& componentsArray = source.Get("components").GetArray();
+    data.components_.resize(componentsArray.size());
+    for (unsigned i = 0; i < componentsArray.size(); ++i)
+    {
+        const JSONValue& componentValue = componentsArray[i];
+        SerializableData& component = data.components_[i];
+        component.typeName_ = componentValue.Get("type").GetString();
+        component.type_ = StringHash(component.typeName_);
+        component.id_ = componentValue.Get("id").GetUInt();
+
+        const bool isKnownType = !context_->GetTypeName(component.type_).empty();
+        if (isKnownType)
+            ParseAttributes(componentValue, component, resources);
+        if (!isKnownType || HasAttributeAnimation(componentValue))
+            component.jsonSource_ = &componentValue;
+    }
+}
+
+bool SceneLoader::ParseAttributes(Deserializer& source, SerializableData& data,
+    ea::vector<ea::pair<StringHash, ea::string>>& resources) const
+{
+    const ea::vector<AttributeInfo>* attributes = context_->GetAttributes(data.type_);
+    if (!attributes)
+        return true;
+
+    for (unsigned i = 0; i < attributes->size(); ++i)
+    {
+        const AttributeInfo& attr = attributes->at(i);
+        if (!attr.ShouldLoad())
+            continue;
+
+        if (source.IsEof())
+        {
+            URHO3D_LOGERROR("Could not load " + context_->GetTypeName(data.type_) + ", stream not open or at end");
+            return false;
+        }
+
+        Variant varValue = source.ReadVariant(attr.type_, context_);
+        CollectResources(varValue, resources);
+        data.attributes_.emplace_back(i, ea::move(varValue));
+    }
+
+    return true;
+}
+
+void SceneLoader::ParseAttributes(const XMLElement& source, SerializableData& data,
+    ea::vector<ea::pair<StringHash, ea::string>>& resources) const
+{
+    const ea::vector<AttributeInfo>* attributes = context_->GetAttributes(data.type_);
+    if (!attributes)
+        return;
+
+    // Attributes are usually stored in declaration order, so the search starts from the next attribute
+    unsigned startIndex = 0;
+    for (XMLElement attrElem = source.GetChild("attribute"); attrElem; attrElem = attrElem.GetNext("attribute"))
+    {
+        const ea::string name = attrElem.GetAttribute("name");
+        unsigned i = startIndex;
+        unsigned attempts = attributes->size();
+
+        while (attempts)
+        {
+            const AttributeInfo& attr = attributes->at(i);
+            if (attr.ShouldLoad() && !attr.name_.compare(name))
+            {
+                // If enums specified, do enum lookup and int assignment. Otherwise assign the variant directly
+                Variant varValue = attr.enumNames_ && attr.type_ == VAR_INT
+                    ? ParseEnumValue(attr, attrElem.GetAttribute("value"))
+                    : attrElem.GetVariantValue(attr.type_, context_);
+
+                if (!varValue.IsEmpty())
+                {
+                    CollectResources(varValue, resources);
+                    data.attributes_.emplace_back(i, ea::move(varValue));
+                }
+
+                startIndex = (i + 1) % attributes->size();
+                break;
+            }
+            else
+            {
+                i = (i + 1) % attributes->size();
+                --attempts;
+            }
+        }
+
+        if (!attempts)
+            URHO3D_LOGWARNING("Unknown attribute " + name + " in XML data");
+    }
+}
+
+void SceneLoader::ParseAttributes(const JSONValue& source, SerializableData& data,
+    ea::vector<ea::pair<StringHash, ea::string>>& resources) const
+{
+    const ea::vector<AttributeInfo>* attributes = context_->GetAttributes(data.type_);
+    if (!attributes)
+        return;
+
+    const JSONValue& attributesValue = source.Get("attributes");
+    if (attributesValue.IsNull())
+        return;
+
+    if (!attributesValue.IsObject())
+    {
+        URHO3D_LOGWARNING("'attributes' object is present in " + data.typeName_ + " but is not a JSON object; skipping load");
+        return;
+    }
+
+    for (unsigned i = 0; i < attributes->size(); ++i)
+    {
+        const AttributeInfo& attr = attributes->at(i);
+        if (!attr.ShouldLoad())
+            continue;
+
+        const JSONValue& value = attributesValue.Get(attr.name_);
+        if (value.GetValueType() == JSON_NULL)
+            continue;
+
+        // If enums specified, do enum lookup and int assignment. Otherwise assign the variant directly
+        Variant varValue = attr.enumNames_ && attr.type_ == VAR_INT
+            ? ParseEnumValue(attr, value.GetString())
+            : value.GetVariantValue(attr.type_, context_);
+
+        if (!varValue.IsEmpty())
+        {
+            CollectResources(varValue, resources);
+            data.attributes_.emplace_back(i, ea::move(varValue));
+        }
+    }
+
+    // Report missing attributes
+    for (const auto& pair : attributesValue.GetObject())
+    {
+        const auto isSameName = [&](const AttributeInfo& attr) { return attr.name_ == pair.first; };
+        if (ea::none_of(attributes->begin(), attributes->end(), isSameName))
+            URHO3D_LOGWARNING("Unknown attribute {} in JSON data", pair.first);
+    }
+}
+
+bool SceneLoader::CommitNode(Node* node, const NodeData& data, SceneResolver& resolver) const
+{
+    // Node::LoadXML and Node::LoadJSON would also load children, so call Animatable implementation directly
+    const SerializableData& nodeData = data.node_;
+    bool success = false;
+    if (nodeData.xmlSource_)
+        success = node->Animatable::LoadXML(nodeData.xmlSource_);
+    else if (nodeData.jsonSource_)
+        success = node->Animatable::LoadJSON(*nodeData.jsonSource_);
+    else
+        success = node->LoadAttributeValues(nodeData.attributes_);
+
+    if (!success)
+        return false;
+
+    for (const SerializableData& componentData : data.components_)
+    {
+        const unsigned componentID = componentData.id_;
+        Component* component = node->SafeCreateComponent(componentData.typeName_, componentData.type_,
+            Scene::IsReplicatedID(componentID) ? REPLICATED : LOCAL, componentID);
+        if (component)
+        {
+            resolver.AddComponent(componentID, component);
+            if (!CommitComponent(component, componentData))
+                return false;
+        }
+    }
+
+    return true;
+}
+
+bool SceneLoader::CommitComponent(Component* component, const SerializableData& data) const
+{
+    if (!data.binarySource_.empty())
+    {
+        // Do not abort if component fails to load, as the component buffer is nested and we can skip to the next
+        MemoryBuffer source(data.binarySource_);
+        component->Load(source);
+        return true;
+    }
+    else if (data.xmlSource_)
+        return component->LoadXML(data.xmlSource_);
+    else if (data.jsonSource_)
+        return component->LoadJSON(*data.jsonSource_);
+    else
+        return component->LoadAttributeValues(data.attributes_);
+}
+
+}
@@ -0,0 +1,195 @@
+//
+// Copyright (c) 2017-2021 the rbfx project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+/// \file
+
+#pragma once
+
+#include "../Container/Ptr.h"
+#include "../Container/RefCounted.h"
+#include "../Core/Variant.h"
+#include "../Resource/XMLElement.h"
+
+#include <EASTL/vector.h>
+
+namespace Urho3D
+{
+
+class Component;
+class Context;
+class Deserializer;
+class File;
+class JSONFile;
+class JSONValue;
+class Node;
+class Scene;
+class SceneResolver;
+class WorkItem;
+class XMLFile;
+
+/// Serializable object parsed from scene file.
+struct SerializableData
+{
+    /// Object type.
+    StringHash type_;
+    /// Object type name. Empty for binary files.
+    ea::string typeName_;
+    /// Object ID in the file.
+    unsigned id_{};
+    /// Attribute indices and values in loading order.
+    ea::vector<ea::pair<unsigned, Variant>> attributes_;
+
+    /// Object data that should be loaded on the main thread instead of parsed attributes.
+    /// Used for components of unknown type and for objects with attribute animations.
+    /// @{
+    ByteVector binarySource_;
+    XMLElement xmlSource_;
+    const JSONValue* jsonSource_{};
+    /// @}
+};
+
+/// Scene node parsed from scene file.
+struct NodeData
+{
+    /// Index of parent node in the same chunk. M_MAX_UNSIGNED for children of the root node.
+    unsigned parentIndex_{ M_MAX_UNSIGNED };
+    /// Node attributes.
+    SerializableData node_;
+    /// Node components.
+    ea::vector<SerializableData> components_;
+};
+
+/// Part of the scene parsed by one work item.
+struct SceneDataChunk
+{
+    /// Nodes in depth-first order, every root-level subtree occupies contiguous range.
+    ea::vector<NodeData> nodes_;
+    /// Types and names of referenced resources.
+    ea::vector<ea::pair<StringHash, ea::string>> resources_;
+    /// Whether the chunk is parsed successfully.
+    bool success_{ true };
+};
+
+/// Parses scene or object prefab file into intermediate representation in worker threads,
+/// then creates nodes and components on the main thread.
+/// Parsing doesn't touch the scene, so the loader may be abandoned at any time.
+class URHO3D_API SceneLoader : public RefCounted
+{
+public:
+    /// Construct.
+    explicit SceneLoader(Context* context);
+    /// Destruct.
+    ~SceneLoader() override;
+
+    /// Start parsing binary file positioned at root node ID. Scene files should have file ID already skipped.
+    void StartBinary(File* file, bool isSceneFile);
+    /// Start parsing XML file.
+    void StartXML(File* file);
+    /// Start parsing JSON file.
+    void StartJSON(File* file);
+
+    /// Return whether parsing is finished.
+    bool IsParsed() const;
+    /// Return whether parsing is finished successfully.
+    bool IsSuccessful() const;
+    /// Return parsed root node. Children are stored in chunks.
+    const NodeData& GetRoot() const { return root_; }
+    /// Return parsed chunks.
+    const ea::vector<SceneDataChunk>& GetChunks() const { return chunks_; }
+    /// Return number of root-level child nodes.
+    unsigned GetNumRootChildren() const;
+
+    /// Load root node attributes and components into the scene.
+    bool CommitRoot(Scene* scene, SceneResolver& resolver) const;
+    /// Create next root-level child node with whole subtree. Return false if there are no nodes left.
+    bool CommitNextChild(Scene* scene, SceneResolver& resolver);
+
+private:
+    /// Parse binary file.
+    void ParseBinary();
+    /// Load XML or JSON document and parse root node.
+    void LoadDocument();
+    /// Parse range of root-level children from XML document.
+    void ParseXMLChunk(unsigned chunkIndex);
+    /// Parse range of root-level children from JSON document.
+    void ParseJSONChunk(unsigned chunkIndex);
+
+    /// Parse binary node with children. Node ID is read here.
+    bool ParseNode(Deserializer& source, unsigned parentIndex, SceneDataChunk& chunk) const;
+    /// Parse binary node attributes and components.
+    bool ParseNodeContents(Deserializer& source, StringHash type, NodeData& data,
+        ea::vector<ea::pair<StringHash, ea::string>>& resources) const;
+    /// Parse XML node with children.
+    void ParseNode(const XMLElement& source, unsigned parentIndex, SceneDataChunk& chunk) const;
+    /// Parse XML node attributes and components.
+    void ParseNodeContents(const XMLElement& source, StringHash type, NodeData& data,
+        ea::vector<ea::pair<StringHash, ea::string>>& resources) const;
+    /// Parse JSON node with children.
+    void ParseNode(const JSONValue& source, unsigned parentIndex, SceneDataChunk& chunk) const;
+    /// Parse JSON node attributes and components.
+    void ParseNodeContents(const JSONValue& source, StringHash type, NodeData& data,
+        ea::vector<ea::pair<StringHash, ea::string>>& resources) const;
+
+    /// Parse binary attributes of known type.
+    bool ParseAttributes(Deserializer& source, SerializableData& data,
+        ea::vector<ea::pair<StringHash, ea::string>>& resources) const;
+    /// Parse XML attributes of known type.
+    void ParseAttributes(const XMLElement& source, SerializableData& data,
+        ea::vector<ea::pair<StringHash, ea::string>>& resources) const;
+    /// Parse JSON attributes of known type.
+    void ParseAttributes(const JSONValue& source, SerializableData& data,
+        ea::vector<ea::pair<StringHash, ea::string>>& resources) const;
+
+    /// Load node attributes and components.
+    bool CommitNode(Node* node, const NodeData& data, SceneResolver& resolver) const;
+    /// Load component from parsed data.
+    bool CommitComponent(Component* component, const SerializableData& data) const;
+
+    /// Context.
+    Context* context_{};
+    /// Work items of parsing.
+    ea::vector<SharedPtr<WorkItem>> workItems_;
+    /// Source file.
+    SharedPtr<File> file_;
+    /// XML document.
+    SharedPtr<XMLFile> xmlFile_;
+    /// JSON document.
+    SharedPtr<JSONFile> jsonFile_;
+    /// Whether the root is a scene.
+    bool isSceneFile_{ true };
+
+    /// Parsed root node.
+    NodeData root_;
+    /// Whether the root node is parsed successfully.
+    bool rootSuccess_{};
+    /// Parsed chunks.
+    ea::vector<SceneDataChunk> chunks_;
+
+    /// Index of chunk to commit next.
+    unsigned commitChunkIndex_{};
+    /// Index of node to commit next in the current chunk.
+    unsigned commitNodeIndex_{};
+    /// Nodes created from the current chunk.
+    ea::vector<Node*> committedNodes_;
+};
+
+}
@@ -29,11 +29,13 @@
 #include "../IO/FileSystem.h"
 #include "../IO/Log.h"
 #include "../IO/Serializer.h"
+#include "../IO/VectorBuffer.h"
 #include "../Resource/XMLElement.h"
 #include "../Resource/XMLFile.h"
 #include "../Resource/JSONFile.h"
 #include "../Resource/JSONValue.h"
 #include "../Resource/ResourceCache.h"
+#include "../Scene/AttributeEncoding.h"
 #include "../Scene/ReplicationState.h"
 #include "../Scene/SceneEvents.h"
 #include "../Scene/Serializable.h"
@@ -547,6 +549,26 @@ bool Serializable::LoadJSON(const JSONValue& source)
     return true;
 }
 
+bool Serializable::LoadAttributeValues(const ea::vector<ea::pair<unsigned, Variant>>& values)
+{
+    const ea::vector<AttributeInfo>* attributes = GetAttributes();
+    if (!attributes)
+        return true;
+
+    for (const auto& indexAndValue : values)
+    {
+        if (indexAndValue.first >= attributes->size())
+        {
+            URHO3D_LOGERROR("Could not load " + GetTypeName() + ", attribute index is out of range");
+            return false;
+        }
+
+        OnSetAttribute(attributes->at(indexAndValue.first), indexAndValue.second);
+    }
+
+    return true;
+}
+
 bool Serializable::SaveXML(XMLElement& dest) const
 {
     if (dest.IsNull())
@@ -1026,13 +1048,7 @@ void Serializable::WriteInitialDeltaUpdate(Serializer& dest, unsigned char timeS
 
     // First write the change bitfield, then attribute data for non-default attributes
     dest.WriteUByte(timeStamp);
-    dest.Write(attributeBits.data_, (numAttributes + 7) >> 3u);
-
-    for (unsigned i = 0; i < numAttributes; ++i)
-    {
-        if (attributeBits.IsSet(i))
-            dest.WriteVariantData(networkState_->currentValues_[i]);
-    }
+    WriteSharedDeltaUpdate(dest, attributeBits);
 }
 
 void Serializable::WriteDeltaUpdate(Serializer& dest, const DirtyBits& attributeBits, unsigned char timeStamp)
@@ -1047,25 +1063,29 @@ void Serializable::WriteDeltaUpdate(Serializer& dest, const DirtyBits& attribute
     if (!attributes)
         return;
 
-    unsigned numAttributes = attributes->size();
-
     // First write the change bitfield, then attribute data for changed attributes
     // Note: the attribute bits should not contain LATESTDATA attributes
     dest.WriteUByte(timeStamp);
-    dest.Write(attributeBits.data_, (numAttributes + 7) >> 3u);
+    WriteSharedDeltaUpdate(dest, attributeBits);
+}
 
-    for (unsigned i = 0; i < numAttributes; ++i)
+void Serializable::WriteLatestDataUpdate(Serializer& dest, unsigned char timeStamp)
+{
+    if (!networkState_)
     {
-        if (attributeBits.IsSet(i))
-            dest.WriteVariantData(networkState_->currentValues_[i]);
+        URHO3D_LOGERROR("WriteLatestDataUpdate called without allocated NetworkState");
+        return;
     }
+
+    dest.WriteUByte(timeStamp);
+    WriteLatestDataSnapshot(dest);
 }
 
-void Serializable::WriteLatestDataUpdate(Serializer& dest, unsigned char timeStamp)
+void Serializable::WriteLatestDataSnapshot(Serializer& dest)
 {
     if (!networkState_)
     {
-        URHO3D_LOGERROR("WriteLatestDataUpdate called without allocated NetworkState");
+        URHO3D_LOGERROR("WriteLatestDataSnapshot called without allocated NetworkState");
         return;
     }
 
@@ -1075,13 +1095,47 @@ void Serializable::WriteLatestDataUpdate(Serializer& dest, unsigned char timeSta
 
     unsigned numAttributes = attributes->size();
 
-    dest.WriteUByte(timeStamp);
+    MutexLock<SpinLockMutex> lock(networkState_->serializedDataMutex_);
+    ByteVector& data = networkState_->serializedLatestData_;
+    if (data.empty())
+    {
+        VectorBuffer buffer;
+        for (unsigned i = 0; i < numAttributes; ++i)
+        {
+            const AttributeInfo& attr = attributes->at(i);
+            if (attr.mode_ & AM_LATESTDATA)
+                WriteNetworkAttribute(buffer, attr, networkState_->currentValues_[i]);
+        }
+        data = buffer.GetBuffer();
+    }
+    dest.Write(data.data(), data.size());
+}
+
+void Serializable::WriteSharedDeltaUpdate(Serializer& dest, const DirtyBits& attributeBits)
+{
+    const unsigned numAttributes = networkState_->attributes_->size();
+
+    // Connections usually have the same dirty attributes, so serialize each combination only once
+    MutexLock<SpinLockMutex> lock(networkState_->serializedDataMutex_);
+    for (const auto& bitsAndData : networkState_->serializedDeltas_)
+    {
+        if (bitsAndData.first == attributeBits)
+        {
+            dest.Write(bitsAndData.second.data(), bitsAndData.second.size());
+            return;
+        }
+    }
 
+    VectorBuffer buffer;
+    buffer.Write(attributeBits.data_, (numAttributes + 7) >> 3u);
     for (unsigned i = 0; i < numAttributes; ++i)
     {
-        if (attributes->at(i).mode_ & AM_LATESTDATA)
-            dest.WriteVariantData(networkState_->currentValues_[i]);
+        if (attributeBits.IsSet(i))
+            WriteNetworkAttribute(buffer, networkState_->attributes_->at(i), networkState_->currentValues_[i]);
     }
+
+    dest.Write(buffer.GetData(), buffer.GetSize());
+    networkState_->serializedDeltas_.emplace_back(attributeBits, buffer.GetBuffer());
 }
 
 bool Serializable::ReadDeltaUpdate(Deserializer& source)
@@ -1105,7 +1159,7 @@ bool Serializable::ReadDeltaUpdate(Deserializer& source)
             const AttributeInfo& attr = attributes->at(i);
             if (!(interceptMask & (1ULL << i)))
             {
-                OnSetAttribute(attr, source.ReadVariant(attr.type_));
+                OnSetAttribute(attr, ReadNetworkAttribute(source, attr));
                 changed = true;
             }
             else
@@ -1117,7 +1171,7 @@ bool Serializable::ReadDeltaUpdate(Deserializer& source)
                 eventData[P_TIMESTAMP] = (unsigned)timeStamp;
                 eventData[P_INDEX] = RemapAttributeIndex(GetAttributes(), attr, i);
                 eventData[P_NAME] = attr.name_;
-                eventData[P_VALUE] = source.ReadVariant(attr.type_);
+                eventData[P_VALUE] = ReadNetworkAttribute(source, attr);
                 SendEvent(E_INTERCEPTNETWORKUPDATE, eventData);
             }
         }
@@ -1145,7 +1199,7 @@ bool Serializable::ReadLatestDataUpdate(Deserializer& source)
         {
             if (!(interceptMask & (1ULL << i)))
             {
-                OnSetAttribute(attr, source.ReadVariant(attr.type_));
+                OnSetAttribute(attr, ReadNetworkAttribute(source, attr));
                 changed = true;
             }
             else
@@ -1157,7 +1211,7 @@ bool Serializable::ReadLatestDataUpdate(Deserializer& source)
                 eventData[P_TIMESTAMP] = (unsigned)timeStamp;
                 eventData[P_INDEX] = RemapAttributeIndex(GetAttributes(), attr, i);
                 eventData[P_NAME] = attr.name_;
-                eventData[P_VALUE] = source.ReadVariant(attr.type_);
+                eventData[P_VALUE] = ReadNetworkAttribute(source, attr);
                 SendEvent(E_INTERCEPTNETWORKUPDATE, eventData);
             }
         }
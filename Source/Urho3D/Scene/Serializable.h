@@ -77,6 +77,8 @@ public:
     virtual bool SaveXML(XMLElement& dest) const;
     /// Load from JSON data. Return true if successful.
     virtual bool LoadJSON(const JSONValue& source);
+    /// Load attribute values parsed in advance. Values are pairs of attribute index and value. Return true if successful.
+    virtual bool LoadAttributeValues(const ea::vector<ea::pair<unsigned, Variant>>& values);
     /// Save as JSON data. Return true if successful.
     virtual bool SaveJSON(JSONValue& dest) const;
     /// Load from binary resource.
@@ -120,11 +122,17 @@ public:
     /// Allocate network attribute state.
     void AllocateNetworkState();
     /// Write initial delta network update.
+    /// Serialized attribute data is shared between connections, so it is safe to call from multiple threads.
     void WriteInitialDeltaUpdate(Serializer& dest, unsigned char timeStamp);
     /// Write a delta network update according to dirty attribute bits.
+    /// Serialized attribute data is shared between connections, so it is safe to call from multiple threads.
     void WriteDeltaUpdate(Serializer& dest, const DirtyBits& attributeBits, unsigned char timeStamp);
     /// Write a latest data network update.
+    /// Serialized attribute data is shared between connections, so it is safe to call from multiple threads.
     void WriteLatestDataUpdate(Serializer& dest, unsigned char timeStamp);
+    /// Write latest data attributes without timestamp. Used in snapshot replication mode.
+    /// Serialized attribute data is shared between connections, so it is safe to call from multiple threads.
+    void WriteLatestDataSnapshot(Serializer& dest);
     /// Read and apply a network delta update. Return true if attributes were changed.
     bool ReadDeltaUpdate(Deserializer& source);
     /// Read and apply a network latest data update. Return true if attributes were changed.
@@ -160,6 +168,12 @@ protected:
     /// Network attribute state.
     ea::unique_ptr<NetworkState> networkState_;
 
+private:
+    /// Write attribute bitfield and values of dirty attributes, serializing them only once for all connections.
+    void WriteSharedDeltaUpdate(Serializer& dest, const DirtyBits& attributeBits);
+
+protected:
+
     /// Attribute default value at each instance level.
     ea::unique_ptr<VariantMap> instanceDefaultValues_;
     /// When true, store the attribute value as instance's default value (internal use only).
@@ -0,0 +1,192 @@
+//
+// Copyright (c) 2017-2021 the rbfx project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "../Precompiled.h"
+
+#include "../Core/Profiler.h"
+#include "../Scene/Scene.h"
+#include "../Scene/TransformHierarchy.h"
+
+#include <EASTL/sort.h>
+
+#include "../DebugNew.h"
+
+namespace Urho3D
+{
+
+TransformHierarchy::TransformHierarchy(Scene* scene)
+    : scene_(scene)
+{
+}
+
+TransformHierarchy::~TransformHierarchy()
+{
+}
+
+bool TransformHierarchy::IsTracked(const Node* node) const
+{
+    const unsigned index = node->transformIndex_;
+    return !structureDirty_ && index < nodes_.size() && nodes_[index] == node;
+}
+
+bool TransformHierarchy::MarkDirty(Node* node)
+{
+    if (!IsTracked(node))
+        return false;
+
+    // Same invariant as in Node::MarkDirty: children of dirty node are dirty too
+    if (node->dirty_)
+        return true;
+
+    const unsigned beginIndex = node->transformIndex_;
+    const unsigned endIndex = subtreeEnds_[beginIndex];
+    dirtyRoots_.push_back(beginIndex);
+
+    for (unsigned index = beginIndex; index < endIndex;)
+    {
+        Node* current = nodes_[index];
+        if (current->dirty_)
+        {
+            index = subtreeEnds_[index];
+            continue;
+        }
+
+        current->dirty_ = true;
+        current->NotifyListenersDirty();
+        assert(!structureDirty_);
+        ++index;
+    }
+
+    return true;
+}
+
+void TransformHierarchy::Update()
+{
+    URHO3D_PROFILE("UpdateTransformHierarchy");
+
+    if (structureDirty_)
+    {
+        Rebuild();
+        dirtyRoots_.clear();
+        UpdateRange(0, nodes_.size());
+        return;
+    }
+
+    // Nested subtrees are already covered by outer ones
+    ea::sort(dirtyRoots_.begin(), dirtyRoots_.end());
+    unsigned coveredEnd = 0;
+    for (unsigned rootIndex : dirtyRoots_)
+    {
+        if (rootIndex < coveredEnd)
+            continue;
+
+        coveredEnd = subtreeEnds_[rootIndex];
+        UpdateRange(rootIndex, coveredEnd);
+    }
+    dirtyRoots_.clear();
+}
+
+void TransformHierarchy::Rebuild()
+{
+    // Some nodes may be already destroyed, don't touch them
+    nodes_.clear();
+    parents_.clear();
+
+    // Depth-first traversal, children are visited in order
+    traversalStack_.clear();
+    const auto& sceneChildren = scene_->GetChildren();
+    for (auto iter = sceneChildren.rbegin(); iter != sceneChildren.rend(); ++iter)
+        traversalStack_.emplace_back(iter->Get(), M_MAX_UNSIGNED);
+
+    while (!traversalStack_.empty())
+    {
+        Node* node = traversalStack_.back().first;
+        const unsigned parentIndex = traversalStack_.back().second;
+        traversalStack_.pop_back();
+
+        const unsigned index = nodes_.size();
+        node->transformIndex_ = index;
+        nodes_.push_back(node);
+        parents_.push_back(parentIndex);
+
+        const auto& children = node->GetChildren();
+        for (auto iter = children.rbegin(); iter != children.rend(); ++iter)
+            traversalStack_.emplace_back(iter->Get(), index);
+    }
+
+    // Children are stored after parents, so subtree ends can be accumulated in reverse order
+    const unsigned numNodes = nodes_.size();
+    subtreeEnds_.resize(numNodes);
+    for (unsigned index = 0; index < numNodes; ++index)
+        subtreeEnds_[index] = index + 1;
+    for (unsigned index = numNodes; index > 0; --index)
+    {
+        const unsigned parentIndex = parents_[index - 1];
+        if (parentIndex != M_MAX_UNSIGNED)
+            subtreeEnds_[parentIndex] = ea::max(subtreeEnds_[parentIndex], subtreeEnds_[index - 1]);
+    }
+
+    worldTransforms_.resize(numNodes);
+    worldRotations_.resize(numNodes);
+    structureDirty_ = false;
+}
+
+void TransformHierarchy::UpdateRange(unsigned beginIndex, unsigned endIndex)
+{
+    for (unsigned index = beginIndex; index < endIndex; ++index)
+    {
+        Node* node = nodes_[index];
+        if (!node->dirty_)
+        {
+            // Node may be updated on demand since last batch, just fetch the result
+            worldTransforms_[index] = node->worldTransform_;
+            worldRotations_[index] = node->worldRotation_;
+            continue;
+        }
+
+        const Matrix3x4 localTransform{ node->position_, node->rotation_, node->scale_ };
+        const unsigned parentIndex = parents_[index];
+        if (parentIndex == M_MAX_UNSIGNED)
+        {
+            worldTransforms_[index] = localTransform;
+            worldRotations_[index] = node->rotation_;
+        }
+        else if (parentIndex >= beginIndex)
+        {
+            worldTransforms_[index] = worldTransforms_[parentIndex] * localTransform;
+            worldRotations_[index] = worldRotations_[parentIndex] * node->rotation_;
+        }
+        else
+        {
+            // Parent is outside of dirty subtree and therefore is up to date
+            const Node* parent = nodes_[parentIndex];
+            worldTransforms_[index] = parent->worldTransform_ * localTransform;
+            worldRotations_[index] = parent->worldRotation_ * node->rotation_;
+        }
+
+        node->worldTransform_ = worldTransforms_[index];
+        node->worldRotation_ = worldRotations_[index];
+        node->dirty_ = false;
+    }
+}
+
+}
@@ -0,0 +1,98 @@
+//
+// Copyright (c) 2017-2021 the rbfx project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+/// \file
+
+#pragma once
+
+#include "../Core/NonCopyable.h"
+#include "../Math/Matrix3x4.h"
+#include "../Math/Quaternion.h"
+
+#include <EASTL/span.h>
+#include <EASTL/vector.h>
+
+namespace Urho3D
+{
+
+class Node;
+class Scene;
+
+/// Flat storage of scene node hierarchy used for batched world transform updates.
+/// Nodes are stored in depth-first order, so every subtree occupies contiguous range of indices
+/// and parents are always stored before children.
+/// Node world transforms are still accessible via Node getters, batched update writes them back.
+class URHO3D_API TransformHierarchy : public NonCopyable
+{
+public:
+    /// Construct.
+    explicit TransformHierarchy(Scene* scene);
+    /// Destruct.
+    ~TransformHierarchy();
+
+    /// Mark node hierarchy as changed. Storage is rebuilt on next update.
+    void MarkStructureDirty() { structureDirty_ = true; }
+    /// Mark node and its children dirty without recursion. Return false if node is not tracked.
+    bool MarkDirty(Node* node);
+    /// Update world transforms of all dirty nodes.
+    void Update();
+
+    /// Return whether the node is tracked and storage is up to date.
+    bool IsTracked(const Node* node) const;
+    /// Return number of tracked nodes.
+    unsigned GetNumNodes() const { return nodes_.size(); }
+    /// Return tracked nodes in depth-first order.
+    ea::span<Node* const> GetNodes() const { return nodes_; }
+    /// Return world transforms of tracked nodes as of last update.
+    ea::span<const Matrix3x4> GetWorldTransforms() const { return worldTransforms_; }
+    /// Return world rotations of tracked nodes as of last update.
+    ea::span<const Quaternion> GetWorldRotations() const { return worldRotations_; }
+
+private:
+    /// Rebuild storage from scene hierarchy.
+    void Rebuild();
+    /// Update world transforms in range of nodes. Parent of the first node should not be dirty.
+    void UpdateRange(unsigned beginIndex, unsigned endIndex);
+
+    /// Owner scene.
+    Scene* scene_{};
+    /// Whether the hierarchy is changed since last rebuild.
+    bool structureDirty_{ true };
+
+    /// Nodes in depth-first order.
+    ea::vector<Node*> nodes_;
+    /// Index of parent node. M_MAX_UNSIGNED for children of the scene.
+    ea::vector<unsigned> parents_;
+    /// End of subtree range (exclusive) for each node.
+    ea::vector<unsigned> subtreeEnds_;
+    /// World transforms.
+    ea::vector<Matrix3x4> worldTransforms_;
+    /// World rotations.
+    ea::vector<Quaternion> worldRotations_;
+
+    /// Roots of subtrees marked dirty since last update.
+    ea::vector<unsigned> dirtyRoots_;
+    /// Temporary stack for hierarchy traversal.
+    ea::vector<ea::pair<Node*, unsigned>> traversalStack_;
+};
+
+}
@@ -127,6 +127,7 @@ option                (URHO3D_MONOLITHIC_HEADER  "Create Urho3DAll.h which inclu
 cmake_dependent_option(URHO3D_MINIDUMPS          "Enable writing minidumps on crash"                     ${URHO3D_ENABLE_ALL} "MSVC;NOT UWP"                  OFF)
 cmake_dependent_option(URHO3D_PLUGINS            "Enable plugins"                                        ${URHO3D_ENABLE_ALL} "NOT WEB;NOT UWP"               OFF)
 cmake_dependent_option(URHO3D_THREADING          "Enable multithreading"                                 ${URHO3D_ENABLE_ALL} "NOT WEB"                       OFF)
+cmake_dependent_option(URHO3D_PHYSICS_THREADING  "Build Bullet thread-safe for multithreaded physics"    OFF                  "URHO3D_PHYSICS;URHO3D_THREADING" OFF)
 option                (URHO3D_WEBP               "WEBP support enabled"                                  ${URHO3D_ENABLE_ALL}                                    )
 cmake_dependent_option(URHO3D_TESTING            "Enable unit tests"                                     OFF                  "NOT WEB;NOT MOBILE;NOT UWP"    OFF)
 # Web